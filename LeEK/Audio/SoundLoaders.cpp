@@ -182,7 +182,7 @@ U32 WAVLoader::GetLoadedResSize(char* rawBuf, U32 rawSize)
 	return fileLoadedSz;
 }
 
-bool WAVLoader::LoadResource(char* rawBuf, U32 rawSize, std::shared_ptr<Resource> resource)
+bool WAVLoader::LoadResource(char* rawBuf, U32 rawSize, Resource* resource)
 {
 	if(!lazyParse(rawBuf, rawSize))
 	{
@@ -343,7 +343,7 @@ bool OGGLoader::lazyOpen(char* oggFile, size_t bufLen)
 	return openFile(oggFile, bufLen);
 }
 
-bool OGGLoader::parseFile(char* oggFile, size_t bufLen, std::shared_ptr<Resource> resPtr)
+bool OGGLoader::parseFile(char* oggFile, size_t bufLen, Resource* resPtr)
 {
 	if(!lazyOpen(oggFile, bufLen))
 	{
@@ -429,7 +429,7 @@ U32 OGGLoader::GetLoadedResSize(char* rawBuf, U32 rawSize)
 	return (U32)result;
 }
 
-bool OGGLoader::LoadResource(char* rawBuf, U32 rawSize, std::shared_ptr<Resource> resource)
+bool OGGLoader::LoadResource(char* rawBuf, U32 rawSize, Resource* resource)
 {
 	if(!lazyOpen(rawBuf, rawSize))
 	{
@@ -49,10 +49,11 @@ namespace LeEK
 	public:
 		WAVLoader();
 		String GetPattern() { return "*.wav"; }
+		ResCategory GetCategory() { return SOUND_RES; }
 		//File must be parsed.
 		bool UseRawResource() { return false; }
 		U32 GetLoadedResSize(char* rawBuf, U32 rawSize);
-		bool LoadResource(char* rawBuf, U32 rawSize, std::shared_ptr<Resource> resource);
+		bool LoadResource(char* rawBuf, U32 rawSize, Resource* resource);
 	};
 
 	//Keeps track of the memory buffer that libogg's using.
@@ -84,14 +85,15 @@ namespace LeEK
 		void resetFileInfo();
 		bool openFile(char* oggFile, size_t bufLen);
 		bool lazyOpen(char* oggFile, size_t bufLen);
-		bool parseFile(char* oggFile, size_t bufLen, std::shared_ptr<Resource> resPtr);
+		bool parseFile(char* oggFile, size_t bufLen, Resource* resPtr);
 	public:
 		OGGLoader();
 		String GetPattern() { return "*.ogg"; }
+		ResCategory GetCategory() { return SOUND_RES; }
 		//File must be parsed.
 		bool UseRawResource() { return false; }
 		U32 GetLoadedResSize(char* rawBuf, U32 rawSize);
-		bool LoadResource(char* rawBuf, U32 rawSize, std::shared_ptr<Resource> resource);
+		bool LoadResource(char* rawBuf, U32 rawSize, Resource* resource);
 		bool LoadStreamResource(char* rawBuf, FileSz rawSize, std::shared_ptr<StreamingResource> resource);
 	};
 }
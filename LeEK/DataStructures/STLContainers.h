@@ -2,6 +2,7 @@
 #include "Memory/Allocator.h"
 #include "Memory/STLAllocHook.h"
 #include <map>
+#include <unordered_map>
 #include <list>
 #include <stack>
 #include <vector>
@@ -33,6 +34,14 @@ namespace LeEK
 		~Map() {}
 	};
 
+	template<typename keyT, typename valT, typename hashT = std::hash<keyT>, typename eqT = std::equal_to<keyT>>
+	class UnorderedMap : public std::unordered_map<keyT, valT, hashT, eqT, STLAllocHook<std::pair<const keyT, valT>>>
+	{
+	public:
+		UnorderedMap() {}
+		~UnorderedMap() {}
+	};
+
 	template<typename T>
 	class List : public std::list<T, STLAllocHook<T>>
 	{
@@ -48,6 +57,18 @@ namespace LeEK
 		Vector() {}
 		~Vector() {}
 	};
+
+	/**
+	Vector whose backing array is 16 byte aligned,
+	for data that's processed with SIMD instructions.
+	*/
+	template<typename T>
+	class AlignedVector : public std::vector<T, STLAlignedAllocHook<T, 16>>
+	{
+	public:
+		AlignedVector() {}
+		~AlignedVector() {}
+	};
 	
 
 	/*
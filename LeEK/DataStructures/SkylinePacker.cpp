@@ -0,0 +1,141 @@
+#include "SkylinePacker.h"
+#include "Math/MathFunctions.h"
+
+using namespace LeEK;
+
+SkylinePacker::SkylinePacker(void) : binWidth(0), binHeight(0), usedArea(0)
+{
+}
+
+SkylinePacker::SkylinePacker(U32 width, U32 height)
+{
+	Init(width, height);
+}
+
+SkylinePacker::~SkylinePacker(void)
+{
+}
+
+void SkylinePacker::Init(U32 width, U32 height)
+{
+	binWidth = width;
+	binHeight = height;
+	usedArea = 0;
+	skyline.clear();
+	skyline.push_back(Segment(0, 0, width));
+}
+
+bool SkylinePacker::fits(U32 index, U32 width, U32 height, U32& yOut) const
+{
+	U32 x = skyline[index].X;
+	if(x + width > binWidth)
+	{
+		return false;
+	}
+	//the rectangle rests on the highest segment under it
+	U32 y = 0;
+	U32 widthLeft = width;
+	//the segments always cover the whole bin, so this can't run off the end
+	for(U32 i = index; widthLeft > 0; ++i)
+	{
+		y = Math::Max(y, skyline[i].Y);
+		if(y + height > binHeight)
+		{
+			return false;
+		}
+		widthLeft -= Math::Min(widthLeft, skyline[i].Width);
+	}
+	yOut = y;
+	return true;
+}
+
+void SkylinePacker::addSegment(U32 index, U32 x, U32 y, U32 width, U32 height)
+{
+	skyline.insert(skyline.begin() + index, Segment(x, y + height, width));
+	//trim the segments the new one covers
+	for(U32 i = index + 1; i < skyline.size(); )
+	{
+		const Segment& prev = skyline[i - 1];
+		U32 prevEnd = prev.X + prev.Width;
+		Segment& curr = skyline[i];
+		if(curr.X >= prevEnd)
+		{
+			break;
+		}
+		U32 overlap = prevEnd - curr.X;
+		if(curr.Width <= overlap)
+		{
+			skyline.erase(skyline.begin() + i);
+			continue;
+		}
+		curr.X += overlap;
+		curr.Width -= overlap;
+		break;
+	}
+	mergeSegments();
+}
+
+void SkylinePacker::mergeSegments()
+{
+	for(U32 i = 1; i < skyline.size(); )
+	{
+		if(skyline[i - 1].Y == skyline[i].Y)
+		{
+			skyline[i - 1].Width += skyline[i].Width;
+			skyline.erase(skyline.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+bool SkylinePacker::Pack(U32 width, U32 height, U32& xOut, U32& yOut)
+{
+	if(width == 0 || height == 0)
+	{
+		xOut = 0;
+		yOut = 0;
+		return true;
+	}
+	const U32 NOT_FOUND = 0xFFFFFFFF;
+	U32 bestIndex = NOT_FOUND;
+	U32 bestTop = NOT_FOUND;
+	U32 bestWidth = NOT_FOUND;
+	U32 bestY = 0;
+	for(U32 i = 0; i < skyline.size(); ++i)
+	{
+		U32 y = 0;
+		if(!fits(i, width, height, y))
+		{
+			continue;
+		}
+		U32 top = y + height;
+		if(top < bestTop || (top == bestTop && skyline[i].Width < bestWidth))
+		{
+			bestIndex = i;
+			bestTop = top;
+			bestWidth = skyline[i].Width;
+			bestY = y;
+		}
+	}
+	if(bestIndex == NOT_FOUND)
+	{
+		return false;
+	}
+	xOut = skyline[bestIndex].X;
+	yOut = bestY;
+	addSegment(bestIndex, xOut, yOut, width, height);
+	usedArea += (U64)width * height;
+	return true;
+}
+
+F32 SkylinePacker::Occupancy() const
+{
+	if(binWidth == 0 || binHeight == 0)
+	{
+		return 0;
+	}
+	return (F32)((F64)usedArea / ((F64)binWidth * binHeight));
+}
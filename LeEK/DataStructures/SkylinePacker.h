@@ -0,0 +1,56 @@
+#pragma once
+#include "Datatypes.h"
+#include "DataStructures/STLContainers.h"
+
+namespace LeEK
+{
+	/**
+	Packs rectangles into a fixed size bin by tracking the skyline,
+	the top edge of everything placed so far.
+	Each rectangle goes wherever its top ends up lowest,
+	ties going to the narrowest stretch of skyline so gaps get filled first.
+	Rectangles come out tighter than with a tree of split nodes,
+	particularly when they're packed tallest first.
+	*/
+	class SkylinePacker
+	{
+	private:
+		//A horizontal stretch of the skyline; everything below Y is taken.
+		struct Segment
+		{
+			U32 X;
+			U32 Y;
+			U32 Width;
+
+			Segment(U32 x, U32 y, U32 width) : X(x), Y(y), Width(width) {}
+			Segment() : X(0), Y(0), Width(0) {}
+		};
+
+		Vector<Segment> skyline;
+		U32 binWidth;
+		U32 binHeight;
+		U64 usedArea;
+
+		//Finds how low a rectangle can sit if its left edge is at the given segment.
+		bool fits(U32 index, U32 width, U32 height, U32& yOut) const;
+		void addSegment(U32 index, U32 x, U32 y, U32 width, U32 height);
+		void mergeSegments();
+	public:
+		SkylinePacker(void);
+		SkylinePacker(U32 width, U32 height);
+		~SkylinePacker(void);
+
+		//Empties the bin and sets its size.
+		void Init(U32 width, U32 height);
+		/**
+		Finds a spot for a rectangle and marks it as used.
+		@return false, and leaves the bin alone, if the rectangle doesn't fit anywhere.
+		*/
+		bool Pack(U32 width, U32 height, U32& xOut, U32& yOut);
+
+		U32 Width() const { return binWidth; }
+		U32 Height() const { return binHeight; }
+		//The fraction of the bin covered by packed rectangles.
+		F32 Occupancy() const;
+	};
+}
@@ -31,6 +31,11 @@ I32 GroupingNode::AttachChild(SpatialHnd child)
 {
 	//Simple, put child in list
 	//and return its index in the list.
+	//The child's world transform now depends on this node.
+	if(child)
+	{
+		child->SetParent(this);
+	}
 	//Elements can be null, so linearly search for a free space.
 	for(int i = 0; i < children.size(); ++i)
 	{
@@ -55,6 +60,7 @@ I32 GroupingNode::DetachChild(SpatialHnd child)
 		//if addresses match, NULL out the element
 		if(*c == child)
 		{
+			child->SetParent(NULL);
 			children[returnedIndex] = 0;//.erase(c++);
 			//and return the index
 			return returnedIndex;
@@ -84,6 +90,10 @@ SpatialHnd GroupingNode::DetachChildAt(I32 index)
 	}
 	SpatialHnd result = *c;
 	children.erase(c);
+	if(result)
+	{
+		result->SetParent(NULL);
+	}
 	return result;
 }
 
@@ -94,6 +104,14 @@ SpatialHnd GroupingNode::SetChild(I32 index, SpatialHnd child)
 		return 0;
 	}
 	SpatialHnd prevChild = children[index];
+	if(prevChild)
+	{
+		prevChild->SetParent(NULL);
+	}
+	if(child)
+	{
+		child->SetParent(this);
+	}
 	children[index] = child;
 	return prevChild;
 }
@@ -118,9 +136,15 @@ void GroupingNode::OnGetVisibleSet(Culler& culler, bool shouldNotCull, bool pRec
 	}
 
 	//Insert children into visible set.
+	//Go through GetVisibleSet() so the children's
+	//transforms get updated if this node moved.
 	for(int i = 0; i < children.size(); ++i)
 	{
-		children[i]->OnGetVisibleSet(culler, shouldNotCull, pRecalcTrans);
+		if(!children[i])
+		{
+			continue;
+		}
+		children[i]->GetVisibleSet(culler, shouldNotCull, pRecalcTrans);
 	}
 
 	//Then note the end of the affected nodes.
@@ -6,6 +6,8 @@ using namespace LeEK;
 void ModelNode::SetGeometry(TypedHandle<Model> modelHnd)
 {
 	model = modelHnd;
+	//The old model's levels don't mean anything for the new one.
+	lodLevel = 0;
 }
 
 TypedHandle<Model> ModelNode::GetModel()
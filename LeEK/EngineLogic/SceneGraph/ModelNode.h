@@ -13,11 +13,15 @@ namespace LeEK
 	class ModelNode : public SpatialNode
 	{
 		TypedHandle<Model> model;
+		//The detail level this node was last drawn at.
+		U32 lodLevel;
 	public:
-		ModelNode() : model() {}
+		ModelNode() : model(), lodLevel(0) {}
 		void SetGeometry(TypedHandle<Model> modelHnd);
 		//void SetGeometry(const Geometry* geomPtr);
 		TypedHandle<Model> GetModel();
+		inline U32 GetLODLevel() const { return lodLevel; }
+		inline void SetLODLevel(U32 val) { lodLevel = val; }
 
 		//TODO
 		void OnGetVisibleSet(Culler& culler, bool shouldNotCull, bool pRecalcTrans);
@@ -1,21 +1,15 @@
 #include "SpatialNode.h"
+#include "TransformHierarchy.h"
 
 using namespace LeEK;
 
-void SpatialNode::recalcWorldTrans()
+SpatialNode::~SpatialNode()
 {
-	if(shouldRecalcTrans)
+	if(hierarchy)
 	{
-		if(!parent)
-		{
-			worldTrans = localTrans;
-		}
-		else
-		{
-			worldTrans = localTrans * parent->GetWorldTransform();
-		}
-		shouldRecalcTrans = false;
+		hierarchy->Release(hierarchyIdx);
 	}
+	HandleMgr::DeleteHandle(thisHnd);
 }
 
 const SpatialNode* SpatialNode::GetParent() const
@@ -43,9 +37,18 @@ const SpatialNode::CullMode& SpatialNode::GetCullMode() const
 	return cullMode;
 }
 
-const Transform& SpatialNode::GetWorldTransform() const
+Transform SpatialNode::GetWorldTransform() const
 {
-	return worldTrans;
+	if(hierarchy)
+	{
+		return hierarchy->GetWorldTransform(hierarchyIdx);
+	}
+	//Not in a scene, so there's no cached value; work it out from the parents.
+	if(!parent)
+	{
+		return localTrans;
+	}
+	return localTrans * parent->GetWorldTransform();
 }
 
 const Transform& SpatialNode::GetLocalTransform() const
@@ -53,18 +56,25 @@ const Transform& SpatialNode::GetLocalTransform() const
 	return localTrans;
 }
 
-Transform& SpatialNode::WorldTransform()
+Transform& SpatialNode::LocalTransform()
 {
-	//mark node for world transform recalculation?
+	//mark node for world transform recalculation;
+	//only queue it once per update.
+	if(hierarchy && !shouldRecalcTrans)
+	{
+		hierarchy->MarkDirty(hierarchyIdx);
+	}
 	shouldRecalcTrans = true;
-	return worldTrans;
+	return localTrans;
 }
 
-Transform& SpatialNode::LocalTransform()
+Matrix4x4 SpatialNode::GetWorldMatrix() const
 {
-	//mark node for world transform recalculation
-	shouldRecalcTrans = true;
-	return localTrans;
+	if(hierarchy)
+	{
+		return hierarchy->GetWorldMatrix(hierarchyIdx);
+	}
+	return GetWorldTransform().ToMatrix();
 }
 
 void SpatialNode::UpdateGraphInfo()
@@ -77,30 +87,11 @@ void SpatialNode::GetVisibleSet(Culler& culler, bool shouldNotCull, bool pRecalc
 	//All node types will enter through this, 
 	//so recursive calls will also enter this BEFORE
 	//entering their respective node's OnGetVisibleSet.
-
-	//First thing to do is update the world transform if necessary.
-	//If this node needs to be recalculated, 
-	//ALL children below it must be recalculated; we check for this first.
-	pRecalcTrans |= shouldRecalcTrans;
-	if(pRecalcTrans)
-	{
-		//To avoid having another branch here
-		//or an extra parameter in GetVisibleSet,
-		//we assume this node has a parent.
-		//For this to work, the root also needs a parent;
-		//this can be a dummy node with an identity transform.
-		//Then you just update starting at the scene's root node.
-		L_ASSERT(parent && "Attempted to call GetVisibleSet on a parentless node!\nIf you called this on your scene's root node, make sure it's parented to a dummy node!");
-		recalcWorldTrans();
-	}
+	//World transforms have already been updated
+	//by the scene's TransformHierarchy at this point.
 
 	//Now do node-specific work. This can be a recursive call.
-	OnGetVisibleSet(culler, shouldNotCull, shouldRecalcTrans);
-}
-
-void SpatialNode::OnInsert()
-{
-	recalcWorldTrans();
+	OnGetVisibleSet(culler, shouldNotCull, pRecalcTrans);
 }
 
 U32 SpatialNode::GetNumLocalShaders() const
@@ -9,6 +9,7 @@ namespace LeEK
 {
 	class Culler;
 	class LightNode;
+	class TransformHierarchy;
 
 	/**
 	Denotes an element in the scene graph hierarchy.
@@ -18,6 +19,7 @@ namespace LeEK
 	*/
 	class SpatialNode
 	{
+		friend class TransformHierarchy;
 	public:
 		typedef TypedHandle<Shader> ShaderHnd;
 		typedef TypedHandle<LightNode> LightHnd;
@@ -44,7 +46,12 @@ namespace LeEK
 		Vector<ShaderHnd> globalShaders;
 
 		Transform localTrans;
-		Transform worldTrans;
+		//The world transform lives in this hierarchy's arrays,
+		//at hierarchyIdx. If this is null, the node isn't in a scene
+		//and calculates its world transform on request.
+		TransformHierarchy* hierarchy;
+		U32 hierarchyIdx;
+		//Set when the local transform's been edited.
 		bool shouldRecalcTrans;
 
 		Vector<LightHnd> localLights;
@@ -56,25 +63,22 @@ namespace LeEK
 		{
 			containerMode = NODE_LEAF;
 			localTrans = Transform();
-			worldTrans = Transform();
 			localShaders = Vector<ShaderHnd>();
 			globalShaders = Vector<ShaderHnd>();
 			localLights = Vector<LightHnd>();
 			globalLights = Vector<LightHnd>();
 			parent = NULL;
 			cullMode = CULL_DYNAMIC;
+			hierarchy = NULL;
+			hierarchyIdx = 0;
 			shouldRecalcTrans = true;
 			//shouldRecalcLights = true;
 			thisHnd = HandleMgr::RegisterPtr(this);
 		}
 		//virtual void UpdateWorldBound() = 0;
-		void recalcWorldTrans();
 		//void PropagateBoundChange();
 	public:
-		virtual ~SpatialNode()
-		{
-			HandleMgr::DeleteHandle(thisHnd);
-		}
+		virtual ~SpatialNode();
 
 		//Accessors
 		SpatialNode* GetWritableParent();
@@ -84,14 +88,9 @@ namespace LeEK
 		void SetCullMode(const CullMode& newMode);
 		/**
 		Gets the node's world transformation.
-		Use this for READING.
+		This is the value from the last transform update.
 		*/
-		const Transform& GetWorldTransform() const;
-		/**
-		Gets the node's editable world transformation.
-		Use this for EDITING; this marks the node for internal processing.
-		*/
-		Transform& WorldTransform();
+		Transform GetWorldTransform() const;
 		/**
 		Gets the node's local transformation.
 		Use this for READING.
@@ -102,6 +101,11 @@ namespace LeEK
 		Use this for EDITING; this marks the node for internal processing.
 		*/
 		Transform& LocalTransform();
+		/**
+		Gets the node's world transformation as a matrix.
+		This is cached by the node's hierarchy, and only rebuilt when the world transform changes.
+		*/
+		Matrix4x4 GetWorldMatrix() const;
 
 		/**
 		Updates node data based on the parent's information.
@@ -130,7 +134,8 @@ namespace LeEK
 			Note that this does not prevent 
 			this node's children from being culled!
 		@param pRecalcTrans
-			If true, specifies that this node needs its world transform recalculated.
+			If true, specifies that this node's world transform has changed.
+			World transforms are updated by the node's TransformHierarchy beforehand.
 		*/
 		void GetVisibleSet(Culler& culler, bool shouldNotCull, bool pRecalcTrans);
 		/**
@@ -146,7 +151,6 @@ namespace LeEK
 			If true, specifies that this node needs its world transform recalculated.
 		*/
 		virtual void OnGetVisibleSet(Culler& culler, bool shouldNotCull, bool pRecalcTrans) = 0;
-		void OnInsert();
 
 		U32 GetNumLocalShaders() const;
 		ShaderHnd GetLocalShader(U32 idx);
@@ -0,0 +1,239 @@
+#include "TransformHierarchy.h"
+#include "GroupingNode.h"
+#include "Stats/Profiling.h"
+#include <algorithm>
+
+using namespace LeEK;
+
+TransformHierarchy::TransformHierarchy()
+{
+	shouldRebuild = true;
+	numUpdated = 0;
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+	clear();
+}
+
+void TransformHierarchy::clear()
+{
+	//Nodes that are still around fall back
+	//to calculating their own world transforms.
+	for(U32 i = 0; i < nodes.size(); ++i)
+	{
+		if(nodes[i] && nodes[i]->hierarchy == this)
+		{
+			nodes[i]->hierarchy = NULL;
+		}
+	}
+	nodes.clear();
+	parents.clear();
+	localPositions.clear();
+	localOrientations.clear();
+	localScales.clear();
+	worldPositions.clear();
+	worldOrientations.clear();
+	worldScales.clear();
+	worldMatrices.clear();
+	changed.clear();
+	dirtyEntries.clear();
+}
+
+void TransformHierarchy::addEntry(SpatialNode* node, I32 parentIdx)
+{
+	node->hierarchy = this;
+	node->hierarchyIdx = nodes.size();
+	nodes.push_back(node);
+	parents.push_back(parentIdx);
+	const Transform& local = node->GetLocalTransform();
+	localPositions.push_back(local.Position());
+	localOrientations.push_back(local.Orientation());
+	localScales.push_back(local.Scale());
+	worldPositions.push_back(local.Position());
+	worldOrientations.push_back(local.Orientation());
+	worldScales.push_back(local.Scale());
+	worldMatrices.push_back(Matrix4x4::Identity);
+	//New entries always need their world transform calculated.
+	changed.push_back(1);
+	node->shouldRecalcTrans = false;
+}
+
+void TransformHierarchy::addSubtree(SpatialNode* node, I32 parentIdx)
+{
+	U32 head = nodes.size();
+	addEntry(node, parentIdx);
+	//The arrays double as the queue for a breadth-first walk;
+	//that keeps each level together and after the level above.
+	for(; head < nodes.size(); ++head)
+	{
+		SpatialNode* curr = nodes[head];
+		if(curr->GetContainMode() != SpatialNode::NODE_CONTAINER)
+		{
+			continue;
+		}
+		GroupingNode* asGroupingNode = (GroupingNode*)curr;
+		for(U32 i = 0; i < asGroupingNode->GetNumChildren(); ++i)
+		{
+			SpatialHnd child = asGroupingNode->GetChild(i);
+			//Detached children leave null slots behind.
+			if(!child)
+			{
+				continue;
+			}
+			addEntry(child.Ptr(), (I32)head);
+		}
+	}
+}
+
+void TransformHierarchy::pullLocalTransform(U32 idx)
+{
+	SpatialNode* node = nodes[idx];
+	if(!node)
+	{
+		return;
+	}
+	const Transform& local = node->GetLocalTransform();
+	localPositions[idx] = local.Position();
+	localOrientations[idx] = local.Orientation();
+	localScales[idx] = local.Scale();
+	changed[idx] = 1;
+	node->shouldRecalcTrans = false;
+}
+
+void TransformHierarchy::calcWorldTransform(U32 idx)
+{
+	I32 parentIdx = parents[idx];
+	if(parentIdx == NO_PARENT)
+	{
+		worldPositions[idx] = localPositions[idx];
+		worldOrientations[idx] = localOrientations[idx];
+		worldScales[idx] = localScales[idx];
+	}
+	else
+	{
+		//Same as Transform::operator*=,
+		//but reading straight out of the arrays.
+		F32 scale = worldScales[parentIdx] * localScales[idx];
+		worldScales[idx] = scale;
+		worldPositions[idx] = localPositions[idx] +
+			localOrientations[idx].GetInverse().RotateVector(scale * worldPositions[parentIdx]);
+		worldOrientations[idx] = worldOrientations[parentIdx] * localOrientations[idx];
+	}
+	worldMatrices[idx] = GetWorldTransform(idx).ToMatrix();
+}
+
+void TransformHierarchy::Invalidate()
+{
+	shouldRebuild = true;
+}
+
+bool TransformHierarchy::NeedsRebuild() const
+{
+	return shouldRebuild;
+}
+
+void TransformHierarchy::Rebuild(SpatialNode* root)
+{
+	clear();
+	if(root)
+	{
+		addSubtree(root, NO_PARENT);
+	}
+	shouldRebuild = false;
+}
+
+void TransformHierarchy::Insert(SpatialNode* node)
+{
+	if(!node)
+	{
+		return;
+	}
+	const SpatialNode* parent = node->GetParent();
+	I32 parentIdx = NO_PARENT;
+	if(parent)
+	{
+		//Can't place the node without its parent.
+		if(parent->hierarchy != this)
+		{
+			Invalidate();
+			return;
+		}
+		parentIdx = (I32)parent->hierarchyIdx;
+	}
+	U32 start = nodes.size();
+	addSubtree(node, parentIdx);
+	//Parents come first, so one pass over the new entries is enough.
+	for(U32 i = start; i < nodes.size(); ++i)
+	{
+		calcWorldTransform(i);
+		changed[i] = 0;
+	}
+}
+
+U32 TransformHierarchy::Update()
+{
+	PROFILE("TransformUpdate");
+	for(U32 i = 0; i < dirtyEntries.size(); ++i)
+	{
+		pullLocalTransform(dirtyEntries[i]);
+	}
+	dirtyEntries.clear();
+
+	numUpdated = 0;
+	const U32 numNodes = nodes.size();
+	for(U32 i = 0; i < numNodes; ++i)
+	{
+		//The parent's earlier in the arrays,
+		//so its changed flag is already current.
+		I32 parentIdx = parents[i];
+		if(parentIdx != NO_PARENT)
+		{
+			changed[i] |= changed[parentIdx];
+		}
+		if(!changed[i])
+		{
+			continue;
+		}
+		calcWorldTransform(i);
+		++numUpdated;
+	}
+	//Only clear flags after the sweep,
+	//since children read their parent's flag.
+	if(numUpdated > 0)
+	{
+		std::fill(changed.begin(), changed.end(), 0);
+	}
+	return numUpdated;
+}
+
+void TransformHierarchy::MarkDirty(U32 idx)
+{
+	dirtyEntries.push_back(idx);
+}
+
+void TransformHierarchy::Release(U32 idx)
+{
+	nodes[idx] = NULL;
+	Invalidate();
+}
+
+Transform TransformHierarchy::GetWorldTransform(U32 idx) const
+{
+	return Transform(worldPositions[idx], worldOrientations[idx], worldScales[idx]);
+}
+
+const Matrix4x4& TransformHierarchy::GetWorldMatrix(U32 idx) const
+{
+	return worldMatrices[idx];
+}
+
+U32 TransformHierarchy::GetNumNodes() const
+{
+	return nodes.size();
+}
+
+U32 TransformHierarchy::GetNumUpdated() const
+{
+	return numUpdated;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "Datatypes.h"
+#include "DataStructures/STLContainers.h"
+#include "Math/Matrix4x4.h"
+#include "EngineLogic/Transform.h"
+
+namespace LeEK
+{
+	class SpatialNode;
+
+	/**
+	Stores the transforms of the nodes in a scene graph
+	as parallel arrays, sorted by depth so that
+	every parent comes before its children.
+	World transforms are updated in one linear sweep over the arrays
+	instead of a recursive walk through the graph.
+	Each node keeps its index into these arrays;
+	the arrays only need rebuilding when the hierarchy changes,
+	moving a node doesn't require a rebuild.
+	*/
+	class TransformHierarchy
+	{
+	private:
+		static const I32 NO_PARENT = -1;
+
+		//Back-pointers, used to pull in edited local transforms.
+		//Destroyed nodes leave null entries here until the next rebuild.
+		Vector<SpatialNode*> nodes;
+		//Index of each entry's parent, or NO_PARENT for the root.
+		Vector<I32> parents;
+		Vector<Vector3> localPositions;
+		Vector<Quaternion> localOrientations;
+		Vector<F32> localScales;
+		Vector<Vector3> worldPositions;
+		Vector<Quaternion> worldOrientations;
+		Vector<F32> worldScales;
+		//Cached matrix form of the world transforms,
+		//so the renderer doesn't rebuild them every frame.
+		//Aligned, since these are read by the SIMD matrix kernels.
+		AlignedVector<Matrix4x4> worldMatrices;
+		//Nonzero if the entry's world transform
+		//needs recalculating this update.
+		Vector<U8> changed;
+		//Entries whose local transforms were edited since the last update.
+		Vector<U32> dirtyEntries;
+		bool shouldRebuild;
+		U32 numUpdated;
+
+		void clear();
+		void addEntry(SpatialNode* node, I32 parentIdx);
+		/**
+		Appends the given node and all of its descendants,
+		breadth first, so each level comes after the one above it.
+		*/
+		void addSubtree(SpatialNode* node, I32 parentIdx);
+		void pullLocalTransform(U32 idx);
+		void calcWorldTransform(U32 idx);
+	public:
+		TransformHierarchy();
+		~TransformHierarchy();
+
+		/**
+		Marks the arrays as out of date.
+		Call this whenever nodes are added, moved or removed in the hierarchy.
+		*/
+		void Invalidate();
+		bool NeedsRebuild() const;
+		/**
+		Rebuilds the arrays from the given node and all of its descendants.
+		Nodes that were in the old arrays but aren't under the root
+		are detached from this hierarchy.
+		*/
+		void Rebuild(SpatialNode* root);
+		/**
+		Adds a node and its descendants without a full rebuild,
+		and calculates their world transforms immediately.
+		The node's parent must already be in the hierarchy.
+		The new entries still come after their parents,
+		but won't be sorted by depth until the next rebuild.
+		*/
+		void Insert(SpatialNode* node);
+		/**
+		Updates the world transforms of all nodes in the hierarchy.
+		Only nodes that moved, or that have a parent that moved, are recalculated.
+		@return the number of nodes that were recalculated.
+		*/
+		U32 Update();
+
+		/**
+		Marks the given entry as needing its local transform pulled in
+		from its node. Called when a node's local transform is edited.
+		*/
+		void MarkDirty(U32 idx);
+		/**
+		Forgets the node at the given entry.
+		Called when the node's destroyed.
+		*/
+		void Release(U32 idx);
+
+		Transform GetWorldTransform(U32 idx) const;
+		const Matrix4x4& GetWorldMatrix(U32 idx) const;
+
+		U32 GetNumNodes() const;
+		/**
+		Gets the number of nodes recalculated during the last Update().
+		*/
+		U32 GetNumUpdated() const;
+	};
+}
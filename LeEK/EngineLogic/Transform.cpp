@@ -22,9 +22,22 @@ Transform& Transform::operator*=(const Transform& other)
 
 Matrix4x4 Transform::ToMatrix() const
 {
-	//TODO
-	//optimize this!
-	return Matrix4x4::BuildTranslation(trans) * orien.ToMatrix() * Matrix4x4::BuildScale(scale);//Matrix4x4::BuildScale(scale) * orien.ToMatrix() * Matrix4x4::BuildTranslation(trans);
+	//Equivalent to BuildTranslation(trans) * orien.ToMatrix() * BuildScale(scale),
+	//but without the two full matrix multiplies:
+	//scaling only touches the rotation block,
+	//and translation only fills in the last column.
+	Matrix4x4 result = orien.ToMatrix();
+	for(U32 i = 0; i < 3; ++i)
+	{
+		for(U32 j = 0; j < 3; ++j)
+		{
+			result(i, j) *= scale;
+		}
+	}
+	result(0, 3) = trans.X();
+	result(1, 3) = trans.Y();
+	result(2, 3) = trans.Z();
+	return result;
 }
 
 Vector3 Transform::ToEulerAngles() const
@@ -3,6 +3,7 @@
 #include "Logging/Log.h"
 #include "Constants/AllocTypes.h"
 #include "Math/MathFunctions.h"
+#include "Hashing/Hash.h"
 
 
 using namespace LeEK;
@@ -50,8 +51,10 @@ ZipFile::ZipFile()
 	filePath =Path();
 	file = NULL;
 	dirBuf = NULL;
+	dirFilePointers = NULL;
+	slots = NULL;
+	slotMask = 0;
 	numEntries = 0;
-	FileIndexMap = Map<String, I32>();
 }
 
 ZipFile::~ZipFile(void)
@@ -59,27 +62,46 @@ ZipFile::~ZipFile(void)
 	End();
 }
 
-bool ZipFile::Init(const Path& archivePath)
+bool ZipFile::Init(const Path& archivePath, bool allowMapping)
 {
 	LogV(String("Opening archive ") + archivePath.ToString());
-	//open the file, of course
-	file = Filesystem::OpenFileReadOnly(archivePath);
-	if(!file)
+	//Map the archive if possible; reads are then just copies out of the page cache,
+	//and stored files can be used without copying them at all.
+	//Otherwise open the file, of course
+	if(!allowMapping || !mapping.Open(archivePath))
 	{
-		LogE(String("Couldn't open archive ") + archivePath.ToString() + "!");
-		return false;
+		file = Filesystem::OpenFileReadOnly(archivePath);
+		if(!file)
+		{
+			LogE(String("Couldn't open archive ") + archivePath.ToString() + "!");
+			return false;
+		}
 	}
 	filePath = archivePath;
 
 	//now find the directory listing.
 	//For now, assume there's no comments, so just seek to the end of the file.
 	//Might be off by one?
-	file->SeekFromEnd(sizeof(DirHeader));
 	//zero out the directory buffer, and read it in.
 	//dirBuf = CustomArrayNew<char>(sizeof(DirHeader), RESFILE_ALLOC, "ResFileAlloc");
 	DirHeader dirHeader;
 	memset(&dirHeader, 0, sizeof(DirHeader));
-	U32 res = file->Read((char*)&dirHeader, sizeof(DirHeader));
+	FileSz dirHeaderOffset = 0;
+	U32 res = 0;
+	if(mapping.IsOpen())
+	{
+		dirHeaderOffset = mapping.Size() - sizeof(DirHeader);
+		if(mapping.Size() >= sizeof(DirHeader) && readAt(dirHeaderOffset, &dirHeader, sizeof(DirHeader)))
+		{
+			res = sizeof(DirHeader);
+		}
+	}
+	else
+	{
+		dirHeaderOffset = file->FileSize() - sizeof(DirHeader);
+		file->Seek(dirHeaderOffset);
+		res = file->Read((char*)&dirHeader, sizeof(DirHeader));
+	}
 	if(res != sizeof(DirHeader))
 	{
 		LogE(String("Couldn't load directory info for ") + archivePath.GetBaseName() + "!");
@@ -91,28 +113,51 @@ bool ZipFile::Init(const Path& archivePath)
 		LogE(String(archivePath.GetBaseName()) + " appears to be corrupt!");
 		return false;
 	}
+	U32 numDirEntries = dirHeader.NumDirEntriesOnDisk;
+	FileSz dirSize = dirHeader.DirSize;
+	FileSz dirOffset = dirHeader.DirOffset;
+	if(	dirHeader.NumDirEntriesOnDisk == 0xFFFF &&
+		!readZip64DirInfo(dirHeaderOffset, numDirEntries, dirSize, dirOffset))
+	{
+		LogE(String("Couldn't load ZIP64 directory info for ") + archivePath.GetBaseName() + "!");
+		return false;
+	}
 	LogV(String("Opened archive ") + archivePath.GetBaseName());
 
 	//try to process the file records.
 	//From the directory header, we should know the offset to the start of file records.
-	//also include space at the end for the pointer array used by dirFilePointers.
-	dirBuf = CustomArrayNew<char>(	dirHeader.DirSize + dirHeader.NumDirEntriesOnDisk*sizeof(DirFileHeader*),
+	//The lookup tables go after the directory in the same buffer:
+	//the pointer array used by dirFilePointers, then the name table.
+	//Keeping the table at most half full keeps probe runs short.
+	U32 numSlots = 1;
+	while(numSlots < numDirEntries * 2)
+	{
+		numSlots <<= 1;
+	}
+	FileSz tableOffset = (dirSize + sizeof(void*) - 1) & ~(FileSz)(sizeof(void*) - 1);
+	dirBuf = CustomArrayNew<char>(	tableOffset + numDirEntries*sizeof(DirFileHeader*) + numSlots*sizeof(NameSlot),
 									RESFILE_ALLOC, "ResFileBufAlloc");
-	file->Seek(dirHeader.DirOffset);
-	file->Read(dirBuf, dirHeader.DirSize);
+	if(!readAt(dirOffset, dirBuf, dirSize))
+	{
+		LogE(String("Couldn't read directory for ") + archivePath.GetBaseName() + "!");
+		return false;
+	}
+	dirFilePointers = (const DirFileHeader**)(dirBuf + tableOffset);
+	NameSlot* table = (NameSlot*)(dirFilePointers + numDirEntries);
+	memset(table, 0, numSlots*sizeof(NameSlot));
+	slots = table;
+	slotMask = numSlots - 1;
 	char* bufPos = dirBuf;
-	dirFilePointers = (const DirFileHeader**)(dirBuf + dirHeader.DirSize);
-	//make a buffer so we can build strings.
-	const U32 BUF_LEN = 255;
-	char strBuf[BUF_LEN];
-	memset(strBuf, 0, BUF_LEN);
+	const char* dirEnd = dirBuf + dirSize;
 	//run through the file headers...
-	for(U32 i = 0; i < dirHeader.NumDirEntriesOnDisk; ++i)
+	for(U32 i = 0; i < numDirEntries; ++i)
 	{
 		DirFileHeader& fileHdr = *(DirFileHeader*)bufPos;
 
 		//verify the header
-		if(fileHdr.Signature != DirFileHeader::SIGNATURE)
+		if(	(FileSz)(dirEnd - bufPos) < sizeof(DirFileHeader) ||
+			fileHdr.Signature != DirFileHeader::SIGNATURE ||
+			(FileSz)(dirEnd - bufPos) - sizeof(DirFileHeader) < (FileSz)fileHdr.FNameLen + fileHdr.ExtraLen + fileHdr.CommentLen)
 		{
 			LogW(String(archivePath.GetBaseName()) + ": File " + i + " appears to be corrupt!");
 			return false;
@@ -133,16 +178,54 @@ bool ZipFile::Init(const Path& archivePath)
 				}
 			}
 //#endif
-			//and add the converted filename to the index map
-			strncpy(strBuf, bufPos, Math::Min(BUF_LEN, (U32)fileHdr.FNameLen));
-			strBuf[fileHdr.FNameLen] = 0;
-			FileIndexMap[ToLower(String(strBuf))] = i;
+			//and add the filename to the hash table.
+			//Later entries with the same name replace earlier ones, like extracting the archive would.
+			U32 hash = HashPathNoCase(bufPos, fileHdr.FNameLen);
+			U32 slot = hash & slotMask;
+			while(table[slot].Entry != 0)
+			{
+				const DirFileHeader& other = *dirFilePointers[table[slot].Entry - 1];
+				if(	table[slot].Hash == hash && other.FNameLen == fileHdr.FNameLen &&
+					PathsEqualNoCase(other.GetFileName(), bufPos, fileHdr.FNameLen))
+				{
+					break;
+				}
+				slot = (slot + 1) & slotMask;
+			}
+			table[slot].Hash = hash;
+			table[slot].Entry = i + 1;
 			//skip the rest to go to the next header.
 			bufPos += fileHdr.FNameLen + fileHdr.ExtraLen + fileHdr.CommentLen;
 		}
 	}
 	//and set the archive properties
-	numEntries = dirHeader.NumDirEntriesOnDisk;
+	numEntries = numDirEntries;
+	return true;
+}
+
+bool ZipFile::readZip64DirInfo(FileSz dirHeaderOffset, U32& numDirEntries, FileSz& dirSize, FileSz& dirOffset)
+{
+	Zip64DirLocator locator;
+	Zip64DirHeader zip64Header;
+	if(	dirHeaderOffset < sizeof(Zip64DirLocator) ||
+		!readAt(dirHeaderOffset - sizeof(Zip64DirLocator), &locator, sizeof(Zip64DirLocator)) ||
+		locator.Signature != Zip64DirLocator::SIGNATURE ||
+		//FileSz limits archives to 4GB anyway.
+		locator.DirHeaderOffset > dirHeaderOffset ||
+		!readAt((FileSz)locator.DirHeaderOffset, &zip64Header, sizeof(Zip64DirHeader)) ||
+		zip64Header.Signature != Zip64DirHeader::SIGNATURE)
+	{
+		return false;
+	}
+	//every entry takes at least a header's worth of the directory.
+	if(	zip64Header.DirOffset > dirHeaderOffset || zip64Header.DirSize > dirHeaderOffset ||
+		zip64Header.NumDirEntriesOnDisk > zip64Header.DirSize / sizeof(DirFileHeader))
+	{
+		return false;
+	}
+	numDirEntries = (U32)zip64Header.NumDirEntriesOnDisk;
+	dirSize = (FileSz)zip64Header.DirSize;
+	dirOffset = (FileSz)zip64Header.DirOffset;
 	return true;
 }
 
@@ -152,21 +235,69 @@ void ZipFile::End()
 	//get rid of all the stuff!
 	CustomArrayDelete(dirBuf);
 	dirBuf = NULL;
+	dirFilePointers = NULL;
+	slots = NULL;
+	slotMask = 0;
 	numEntries = 0;
 	Filesystem::CloseFile(file);
 	file = NULL;
+	mapping.Close();
 	filePath = Path();
 }
 
+bool ZipFile::readAt(FileSz offset, void* dest, FileSz size)
+{
+	if(mapping.IsOpen())
+	{
+		if(offset > mapping.Size() || size > mapping.Size() - offset)
+		{
+			return false;
+		}
+		memcpy(dest, mapping.Data() + offset, size);
+		return true;
+	}
+	file->Seek(offset);
+	return file->Read((char*)dest, size) == size;
+}
+
+char* ZipFile::GetMappedFile(I32 fileIndex) const
+{
+	if(!mapping.IsOpen() || fileIndex < 0 || fileIndex >= numEntries)
+	{
+		return NULL;
+	}
+	//The local header's already in memory, so no reads are needed to find the data.
+	const DirFileHeader& dirHdr = *dirFilePointers[fileIndex];
+	FileSz locHdrOffset = dirHdr.LocalHdrOffset;
+	if(mapping.Size() < sizeof(LocalHeader) || locHdrOffset > mapping.Size() - sizeof(LocalHeader))
+	{
+		LogW(String("Local header for file ") + fileIndex + " is out of bounds!");
+		return NULL;
+	}
+	const LocalHeader& locHdr = *(const LocalHeader*)(mapping.Data() + locHdrOffset);
+	if(locHdr.Signature != LocalHeader::SIGNATURE)
+	{
+		LogW(String("Local header for file ") + fileIndex + " appears corrupt!");
+		return NULL;
+	}
+	FileSz dataOffset = locHdrOffset + sizeof(LocalHeader) + locHdr.FNameLen + locHdr.ExtraLen;
+	if(dataOffset > mapping.Size() || dirHdr.CompSize > mapping.Size() - dataOffset)
+	{
+		LogW(String("Data for file ") + fileIndex + " is out of bounds!");
+		return NULL;
+	}
+	return mapping.Data() + dataOffset;
+}
+
 String ZipFile::GetFilename(I32 fileIndex) const
 {
 	if(fileIndex < 0 || fileIndex >= numEntries)
 	{
 		return String("");
 	}
-	String result(dirFilePointers[fileIndex]->GetFileName());
-	result = result.substr( 0, result.length() - 1 );
-	return result;
+	//names in the directory aren't null terminated.
+	const DirFileHeader& dirHdr = *dirFilePointers[fileIndex];
+	return String(dirHdr.GetFileName(), dirHdr.FNameLen);
 }
 
 FileSz ZipFile::GetFileLen(I32 fileIndex) const
@@ -178,6 +309,89 @@ FileSz ZipFile::GetFileLen(I32 fileIndex) const
 	return dirFilePointers[fileIndex]->UnCompSize;
 }
 
+FileSz ZipFile::GetCompressedLen(I32 fileIndex) const
+{
+	if(fileIndex < 0 || fileIndex >= numEntries)
+	{
+		return 0;
+	}
+	return dirFilePointers[fileIndex]->CompSize;
+}
+
+U16 ZipFile::GetCompression(I32 fileIndex) const
+{
+	if(fileIndex < 0 || fileIndex >= numEntries)
+	{
+		return COMP_NONE;
+	}
+	return dirFilePointers[fileIndex]->Compression;
+}
+
+bool ZipFile::ReadCompressedFile(I32 fileIndex, void* compBuf)
+{
+	if(fileIndex < 0 || fileIndex >= numEntries)
+	{
+		return false;
+	}
+	//folders have nothing to read.
+	const DirFileHeader& dirHdr = *dirFilePointers[fileIndex];
+	if(dirHdr.CompSize == 0)
+	{
+		return true;
+	}
+	if(mapping.IsOpen())
+	{
+		char* mappedData = GetMappedFile(fileIndex);
+		if(!mappedData)
+		{
+			return false;
+		}
+		memcpy(compBuf, mappedData, dirHdr.CompSize);
+		return true;
+	}
+
+	FileSz dataOffset = 0;
+	if(!GetDataOffset(fileIndex, dataOffset))
+	{
+		return false;
+	}
+	file->Seek(dataOffset);
+	//Use the directory's size; it's what GetCompressedLen() reports.
+	return file->Read((char*)compBuf, dirHdr.CompSize) == dirHdr.CompSize;
+}
+
+bool ZipFile::GetDataOffset(I32 fileIndex, FileSz& offset)
+{
+	if(fileIndex < 0 || fileIndex >= numEntries)
+	{
+		return false;
+	}
+	if(mapping.IsOpen())
+	{
+		char* mappedData = GetMappedFile(fileIndex);
+		if(!mappedData)
+		{
+			return false;
+		}
+		offset = mappedData - mapping.Data();
+		return true;
+	}
+	//the local header can have different extra data than the directory entry,
+	//so it has to be read to find the data's start.
+	const DirFileHeader& dirHdr = *dirFilePointers[fileIndex];
+	LocalHeader locHdr;
+	memset(&locHdr, 0, sizeof(LocalHeader));
+	file->Seek(dirHdr.LocalHdrOffset);
+	file->Read((char*)&locHdr, sizeof(LocalHeader));
+	if(locHdr.Signature != LocalHeader::SIGNATURE)
+	{
+		LogW(String("Local header for file ") + fileIndex + " appears corrupt!");
+		return false;
+	}
+	offset = dirHdr.LocalHdrOffset + sizeof(LocalHeader) + locHdr.FNameLen + locHdr.ExtraLen;
+	return true;
+}
+
 bool ZipFile::ReadFile(I32 fileIndex, void* fileBuf)
 {
 	if(fileIndex < 0 || fileIndex >= numEntries)
@@ -202,6 +416,28 @@ bool ZipFile::ReadFile(I32 fileIndex, void* fileBuf)
 		return true;
 	}
 
+	//Mapped archives can decompress straight from the mapping.
+	if(mapping.IsOpen())
+	{
+		char* mappedData = GetMappedFile(fileIndex);
+		if(!mappedData)
+		{
+			return false;
+		}
+		const DirFileHeader& dirHdr = *dirFilePointers[fileIndex];
+		switch(dirHdr.Compression)
+		{
+		case CompressionType::COMP_NONE:
+			memcpy(fileBuf, mappedData, dirHdr.CompSize);
+			return true;
+		case CompressionType::COMP_DEFLATE:
+			return DecompDeflateBuf(mappedData, dirHdr.CompSize, (char*)fileBuf, dirHdr.UnCompSize);
+		default:
+			LogW(String("Unrecognized compression on file ") + fileIndex + "!");
+			return false;
+		}
+	}
+
 	LocalHeader locHdr;
 	memset(&locHdr, 0, sizeof(LocalHeader));
 	U32 locHdrOffset = dirFilePointers[fileIndex]->LocalHdrOffset;
@@ -252,62 +488,67 @@ bool ZipFile::ReadFile(I32 fileIndex, void* fileBuf)
 	return true;
 }
 
-ZipStream* ZipFile::GetStream(I32 fileIndex)
+ZipStream* ZipFile::GetStream(I32 fileIndex, U32 chunkSize, U32 chunkCount)
 {
 	if(fileIndex < 0 || fileIndex >= numEntries)
 	{
 		return NULL;
 	}
 
-	DataStream* resStream = Filesystem::OpenFileReadOnly(filePath);
-	if(!resStream)
+	//there might be zero-sized files; these typically indicate folders.
+	const DirFileHeader& dirHdr = *dirFilePointers[fileIndex];
+	if(dirHdr.UnCompSize == 0)
 	{
-		LogE("Couldn't allocate memory for the stream, aborting!");
+		LogV(String("File ") + fileIndex + " appears to be a folder, aborting stream creation");
 		return NULL;
 	}
-	//Simple - read the whole file in one go.
-	//This runs on the same thread as the engine, so don't use this if the file's bigger than like 64MB
-	//or everything will noticeably freeze and people will be mad.
-	//Anyway! Process is:
-	//	* get indexed dir file header
-	//	* go to the offset the header specifies
-	//	* read that offset as a local header, verify signature
-	
-	//Get the offset to the local header and read the header.
-	//We can't definitely read the file in one read, there may be extra data in the local header.
-
-	//there might be zero-sized files; these typically indicate folders.
-	if(dirFilePointers[fileIndex]->UnCompSize == 0)
+	if(	dirHdr.Compression != CompressionType::COMP_NONE &&
+		dirHdr.Compression != CompressionType::COMP_DEFLATE)
 	{
-		LogV(String("File ") + fileIndex + " appears to be a folder, aborting stream creation");
+		LogW(String("Unrecognized compression on file ") + fileIndex + ", aborting stream creation!");
 		return NULL;
 	}
 
+	//Streams on a mapped archive all share the mapping,
+	//rather than each opening the archive again.
+	if(mapping.IsOpen())
+	{
+		char* mappedData = GetMappedFile(fileIndex);
+		if(!mappedData)
+		{
+			return NULL;
+		}
+		return LNew(ZipStream, AllocType::RESFILE_ALLOC, "ZipStreamAlloc")(mappedData, dirHdr.CompSize, dirHdr.Compression);
+	}
+
+	//Otherwise the stream gets its own handle,
+	//so its read-ahead thread doesn't fight over the archive's.
+	DataStream* resStream = Filesystem::OpenFileReadOnly(filePath);
+	if(!resStream)
+	{
+		LogE("Couldn't allocate memory for the stream, aborting!");
+		return NULL;
+	}
+	//Get the offset to the local header and read the header.
+	//We can't find the data from the directory alone, there may be extra data in the local header.
 	LocalHeader locHdr;
 	memset(&locHdr, 0, sizeof(LocalHeader));
-	U32 locHdrOffset = dirFilePointers[fileIndex]->LocalHdrOffset;
+	U32 locHdrOffset = dirHdr.LocalHdrOffset;
 	resStream->Seek(locHdrOffset);
-	resStream->Read((char*)&locHdr, sizeof(LocalHeader));
-	if(locHdr.Signature != LocalHeader::SIGNATURE)
+	if(	resStream->Read((char*)&locHdr, sizeof(LocalHeader)) != sizeof(LocalHeader) ||
+		locHdr.Signature != LocalHeader::SIGNATURE)
 	{
 		LogW(String("Local header for file ") + fileIndex + " appears corrupt! Aborting stream creation!");
+		Filesystem::CloseFile(resStream);
 		return NULL;
 	}
 
-	//the header should be valid now, prep to read the compressed data
+	//the header should be valid now, so the compressed data starts right after it.
+	//The local header's sizes can be 0 if they're in a trailing data descriptor,
+	//so take the size from the directory.
 	U32 fileStart = locHdrOffset + sizeof(LocalHeader) + locHdr.FNameLen + locHdr.ExtraLen;
-	resStream->Seek(fileStart);
-
-	//Now we have compressed data.
-	//Check the compression type.
-	if(	locHdr.Compression != CompressionType::COMP_NONE &&
-		locHdr.Compression != CompressionType::COMP_DEFLATE)
-	{
-		LogW(String("Unrecognized compression on file ") + fileIndex + ", aborting stream creation!");
-		return NULL;
-	}
-
-	return LNew(ZipStream, AllocType::RESFILE_ALLOC, "ZipStreamAlloc")(resStream, fileStart, locHdr.CompSize, locHdr.Compression);
+	return LNew(ZipStream, AllocType::RESFILE_ALLOC, "ZipStreamAlloc")(	resStream, fileStart, dirHdr.CompSize, dirHdr.Compression,
+																		chunkSize, chunkCount);
 }
 
 //streaming functions
@@ -335,6 +576,12 @@ bool ZipFile::ReadLargeFile(I32 fileIndex, void* fileBuf, const FileSz bufSz, vo
 		return true;
 	}
 
+	//mapped archives don't do any reads, so there's nothing to split up.
+	if(mapping.IsOpen())
+	{
+		return ReadFile(fileIndex, fileBuf);
+	}
+
 	LocalHeader locHdr = {0};
 	U32 locHdrOffset = dirFilePointers[fileIndex]->LocalHdrOffset;
 	//Now we *do* have the local header's position; 
@@ -419,107 +666,175 @@ bool ZipFile::ReadLargeFile(I32 fileIndex, void* fileBuf, const FileSz bufSz, vo
 	return true;
 }
 
-I32 ZipFile::Find(const String& filePath) const
+I32 ZipFile::Find(const char* filePath) const
 {
-	Map<String, I32>::const_iterator fileIt = FileIndexMap.find(filePath);
-	if(fileIt != FileIndexMap.end())
+	if(!slots || !filePath)
+	{
+		return -1;
+	}
+	U32 len = strlen(filePath);
+	U32 hash = HashPathNoCase(filePath, len);
+	//linear probing; the table's never full, so there's always an empty slot to stop at.
+	for(U32 i = hash & slotMask; slots[i].Entry != 0; i = (i + 1) & slotMask)
 	{
-		return fileIt->second;
+		if(slots[i].Hash != hash)
+		{
+			continue;
+		}
+		I32 fileIndex = slots[i].Entry - 1;
+		const DirFileHeader& dirHdr = *dirFilePointers[fileIndex];
+		if(dirHdr.FNameLen == len && PathsEqualNoCase(dirHdr.GetFileName(), filePath, len))
+		{
+			return fileIndex;
+		}
 	}
 	return -1;
 }
 
-void ZipStream::init(DataStream* pFile, FileSz pStreamStart, FileSz pStreamSz, U16 pCompType)
+void ZipStream::init(FileSz pStreamSz, U16 pCompType)
 {
 	//Setup the stream.
 	memset(&dcompStream, 0, sizeof(z_stream));
 
-	file = pFile;
-	streamStart = pStreamStart;
+	mappedData = NULL;
+	mappedPos = 0;
+	readAhead = NULL;
+	inBuf = NULL;
+	inBufSz = 0;
+	inflating = false;
 	streamSz = pStreamSz;
 	compType = pCompType;
 }
 
-ZipStream::ZipStream(DataStream* pFile, FileSz pStreamStart, FileSz pStreamSz, U16 pCompType)
+ZipStream::ZipStream(DataStream* pFile, FileSz pStreamStart, FileSz pStreamSz, U16 pCompType, U32 chunkSize, U32 chunkCount)
+{
+	init(pStreamSz, pCompType);
+	readAhead = LNew(ReadAheadStream, RESFILE_ALLOC, "ZipStreamAlloc")(pFile, pStreamStart, pStreamSz, true, chunkSize, chunkCount);
+	if(compType == CompressionType::COMP_DEFLATE)
+	{
+		inBufSz = Math::Max(chunkSize, (U32)1);
+		inBuf = CustomArrayNew<char>(inBufSz, RESFILE_ALLOC, "ZipStreamAlloc");
+	}
+}
+
+ZipStream::ZipStream(const char* pMappedData, FileSz pStreamSz, U16 pCompType)
 {
-	init(pFile, pStreamStart, pStreamSz, pCompType);
+	init(pStreamSz, pCompType);
+	mappedData = pMappedData;
 }
 
 ZipStream::~ZipStream()
 {
-	Filesystem::CloseFile(file);
+	if(inflating)
+	{
+		inflateEnd(&dcompStream);
+	}
+	//closes the stream's file, if it has one.
+	LDelete(readAhead);
+	CustomArrayDelete(inBuf);
 }
 
-FileSz ZipStream::Read(U8* dest, FileSz readSz)
+bool ZipStream::startInflating()
+{
+	//The inflate state persists between reads, so each read picks up where the last left off.
+	if(!inflating)
+	{
+		//pass -MAX_WBITS to indicate there's no zlib headers in the data.
+		if(inflateInit2(&dcompStream, -MAX_WBITS) != Z_OK)
+		{
+			LogW("Decompression initialization failed!");
+			return false;
+		}
+		inflating = true;
+	}
+	return true;
+}
+
+FileSz ZipStream::readMapped(U8* dest, FileSz readSz)
 {
-	//Clamp to the number of bytes left in the stream.
-	FileSz fixedSz = Math::Max(readSz, streamSz - (file->ReadPos() - streamStart));
+	FileSz bytesLeft = streamSz - mappedPos;
 	switch(compType)
 	{
 	case CompressionType::COMP_NONE:
 		{
-			//if it's uncompressed, copy to the destination.
-			return file->Read((char*)dest, fixedSz);
+			FileSz fixedSz = Math::Min(readSz, bytesLeft);
+			memcpy(dest, mappedData + mappedPos, fixedSz);
+			mappedPos += fixedSz;
+			return fixedSz;
 		}
 	case CompressionType::COMP_DEFLATE:
 		{
-			//if it's DEFLATE, run zlib's DEFLATE already.
-			//alloc a temp buffer
-			FileSz startPos = file->ReadPos();
-			char* compData = LArrayNew(char, fixedSz, RESFILE_ALLOC, "TempBufAlloc");
-			memset(compData, 0, fixedSz);
-			file->Read(compData, fixedSz);
-
-			//now you have to setup the decompression stream...
-			int err;
-
-			memset(&dcompStream, 0, sizeof(z_stream));
-			dcompStream.next_in = (Bytef*)compData; //input coming from this buffer
-			dcompStream.avail_in = (uInt)fixedSz; //this many bytes of comp. data coming in
-			dcompStream.next_out = (Bytef*)dest; //write to this buffer
-			dcompStream.avail_out = fixedSz; //this many bytes of decomp. data going out
-			dcompStream.zalloc = (alloc_func)0; //...no, we're not letting DEFLATE do allocs.
-			dcompStream.zfree = (free_func)0;	//freeing is thus also redundant
-
-			//and now we can do the decompression.
-			//pass -MAX_WBITS to indicate there's no zlib headers in the data.
-			err = inflateInit2(&dcompStream, -MAX_WBITS);
-			if(err != Z_OK)
+			//All the compressed data's in memory, so it can all be offered at once.
+			if(!startInflating())
 			{
-				LogW("Decompression initialization failed!");
-				LArrayDelete(compData);
-				file->Seek(startPos);
 				return 0;
 			}
-			//Do ACTUAL decompression.
-			//Write to buffer as we decomp.
-			err = inflate(&dcompStream, Z_SYNC_FLUSH);
-			//Update the read head according to the number of bytes actually read.
-			FileSz actualRead = dcompStream.total_in;
-			if(actualRead != fixedSz)
-			{
-				file->Seek(startPos + actualRead);
-			}
-			FileSz actualWritten = dcompStream.total_out;
-			//and cleanup
-			inflateEnd(&dcompStream);
-			//compression worked if we get Z_STREAM_END,
-			//Z_OK or Z_BUF_ERROR (decompressed data is too big);
-			//otherwise we have some unknown problem
+			dcompStream.next_in = (Bytef*)(mappedData + mappedPos);
+			dcompStream.avail_in = (uInt)bytesLeft;
+			dcompStream.next_out = (Bytef*)dest;
+			dcompStream.avail_out = (uInt)readSz;
+			int err = inflate(&dcompStream, Z_SYNC_FLUSH);
+			mappedPos += bytesLeft - dcompStream.avail_in;
 			if(	err != Z_STREAM_END &&
 				err != Z_OK &&
 				err != Z_BUF_ERROR)
 			{
-				//just quit here
 				LogW("Decompression failed!");
-				inflateEnd(&dcompStream);
-				LArrayDelete(compData);
-				file->Seek(startPos);
 				return 0;
 			}
-			//now we're done; get rid of the temporary buffer
-			LArrayDelete(compData);
-			return actualWritten;
+			return readSz - dcompStream.avail_out;
+		}
+	default:
+		{
+			L_ASSERT(false && "Created ZipStream with unrecognized compression!");
+			LogW("Unrecognized compression!");
+			return 0;
+		}
+	}
+}
+
+FileSz ZipStream::readBuffered(U8* dest, FileSz readSz)
+{
+	switch(compType)
+	{
+	case CompressionType::COMP_NONE:
+		{
+			//if it's uncompressed, copy straight out of the read-ahead.
+			return readAhead->Read((char*)dest, readSz);
+		}
+	case CompressionType::COMP_DEFLATE:
+		{
+			if(!startInflating())
+			{
+				return 0;
+			}
+			dcompStream.next_out = (Bytef*)dest;
+			dcompStream.avail_out = (uInt)readSz;
+			while(dcompStream.avail_out > 0)
+			{
+				//refill the input once the decompressor's used it all.
+				if(dcompStream.avail_in == 0)
+				{
+					FileSz bytesRead = readAhead->Read(inBuf, inBufSz);
+					if(bytesRead == 0)
+					{
+						break;
+					}
+					dcompStream.next_in = (Bytef*)inBuf;
+					dcompStream.avail_in = (uInt)bytesRead;
+				}
+				int err = inflate(&dcompStream, Z_SYNC_FLUSH);
+				if(err == Z_STREAM_END)
+				{
+					break;
+				}
+				if(err != Z_OK && err != Z_BUF_ERROR)
+				{
+					LogW("Decompression failed!");
+					return 0;
+				}
+			}
+			return readSz - dcompStream.avail_out;
 		}
 	default:
 		{
@@ -531,8 +846,28 @@ FileSz ZipStream::Read(U8* dest, FileSz readSz)
 	}
 }
 
+FileSz ZipStream::Read(U8* dest, FileSz readSz)
+{
+	if(mappedData)
+	{
+		return readMapped(dest, readSz);
+	}
+	return readBuffered(dest, readSz);
+}
+
 FileSz ZipStream::Seek(FileSz relPos)
 {
-	FileSz fixedSeekPos = streamStart + Math::Max(relPos, streamSz);
-	return file->Seek(fixedSeekPos);
-}
\ No newline at end of file
+	relPos = Math::Min(relPos, streamSz);
+	//the decompressor has to start over from the new position.
+	if(inflating)
+	{
+		inflateReset(&dcompStream);
+		dcompStream.avail_in = 0;
+	}
+	if(mappedData)
+	{
+		mappedPos = relPos;
+		return mappedPos;
+	}
+	return readAhead->Seek(relPos);
+}
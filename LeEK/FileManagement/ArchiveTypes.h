@@ -2,6 +2,8 @@
 #include "Datatypes.h"
 #include "FileManagement/Filesystem.h"
 #include "FileManagement/DataStream.h"
+#include "FileManagement/MappedFile.h"
+#include "FileManagement/ReadAheadStream.h"
 #include "DataStructures/STLContainers.h"
 #include "Libraries/Zlib/zlib.h"
 
@@ -25,50 +27,150 @@ namespace LeEK
 	{
 	private:
 		struct DirHeader;
+		struct Zip64DirLocator;
+		struct Zip64DirHeader;
 		struct DirFileHeader;
 		struct LocalHeader;
 		Path filePath;
+		//only open if the archive couldn't be mapped.
 		DataStream* file;
+		MappedFile mapping;
 		//buffer for archive directory struct
 		char* dirBuf;
 		//points to individual entries in dirBuf.
 		//presumably dir. file headers aren't equally spaced apart?
 		const DirFileHeader** dirFilePointers;
+		//Slot in the name table. Keeping the hash in the slot means
+		//a probe only touches the directory once the hash matches.
+		struct NameSlot
+		{
+			//HashPathNoCase() of the entry's name.
+			U32 Hash;
+			//entry index + 1, or 0 if the slot's empty.
+			U32 Entry;
+		};
+		//open addressed table of the entries, by name hash.
+		//Names are compared in place in dirBuf, so lookups never copy them.
+		const NameSlot* slots;
+		U32 slotMask;
 		I32 numEntries;
+
+		//Copies part of the archive, from the mapping or the file.
+		bool readAt(FileSz offset, void* dest, FileSz size);
+		//Archives with more than 65535 files keep the real directory info in ZIP64 records,
+		//just before the usual directory header.
+		bool readZip64DirInfo(FileSz dirHeaderOffset, U32& numDirEntries, FileSz& dirSize, FileSz& dirOffset);
 	public:
 		ZipFile();
 		~ZipFile(void);
 
-		bool Init(const Path& archivePath);
+		/**
+		Opens the archive and reads its directory.
+		@param allowMapping if true, the archive's memory mapped where the platform supports it.
+		*/
+		bool Init(const Path& archivePath, bool allowMapping = true);
 		void End();
 
+		/**
+		Returns true if the archive's memory mapped,
+		so its files can be used straight from the mapping.
+		*/
+		inline bool IsMapped() const { return mapping.IsOpen(); }
+		/**
+		Gets the file's data as it's stored, inside the archive's mapping.
+		Stays valid until the archive's closed.
+		Writing to it only changes this process's copy of the written pages.
+		@return NULL if the archive isn't mapped or the file's corrupt.
+		*/
+		char* GetMappedFile(I32 fileIndex) const;
+
 		inline I32 GetNumFiles() const { return numEntries; }
 		String GetFilename(I32 fileIndex) const;
 		FileSz GetFileLen(I32 fileIndex) const;
+		/**
+		Gets the size of the file as it's stored in the archive.
+		*/
+		FileSz GetCompressedLen(I32 fileIndex) const;
+		/**
+		Gets the compression used on the file; match against COMP_* enums.
+		*/
+		U16 GetCompression(I32 fileIndex) const;
 		bool ReadFile(I32 fileIndex, void* fileBuf);
-		//gets index of given file.
-		I32 Find(const String& filePath) const;
-		ZipStream* GetStream(I32 fileIndex);
+		/**
+		Reads the file's data as it's stored, without decompressing it.
+		The buffer must be at least GetCompressedLen() bytes.
+		Lets the read and the decompression happen on different threads.
+		*/
+		bool ReadCompressedFile(I32 fileIndex, void* compBuf);
+		/**
+		Finds where the file's data starts in the archive,
+		so it can be read through another handle to the archive.
+		If the archive isn't mapped, this reads the file's local header.
+		*/
+		bool GetDataOffset(I32 fileIndex, FileSz& offset);
+		/**
+		Gets the index of the file with the given path, ignoring case.
+		@return -1 if the file isn't in the archive.
+		*/
+		I32 Find(const char* filePath) const;
+		inline I32 Find(const String& filePath) const { return Find(filePath.c_str()); }
+		/**
+		Opens a stream over the file.
+		If the archive isn't mapped, the stream opens its own handle to the archive
+		and reads ahead in chunks of the given size.
+		@return NULL if the file can't be streamed. Delete the stream with LDelete().
+		*/
+		ZipStream* GetStream(	I32 fileIndex, U32 chunkSize = ReadAheadStream::DEFAULT_CHUNK_SIZE,
+								U32 chunkCount = ReadAheadStream::DEFAULT_CHUNK_COUNT);
 
 		//TODO:
 		//should simply load in a different thread and call the callback after each load.
 		bool ReadLargeFile(I32 fileIndex, void* fileBuf, const FileSz bufSz, void (*progressCallback)(I32, bool&));
-
-		Map<String, I32> FileIndexMap;
 	};
 	
+	/**
+	Reads a file from a ZIP archive a piece at a time, decompressing as it goes.
+	Streams on an unmapped archive read through a ReadAheadStream,
+	so the next compressed data's read on a background thread while the current data's decompressed.
+	*/
 	class ZipStream
 	{
 	private:
 		z_stream dcompStream;
-		DataStream* file;
-		FileSz streamStart;
+		//if the archive's mapped, the stream reads from here instead of a file.
+		const char* mappedData;
+		//read position relative to the stream's start; only used when mapped.
+		FileSz mappedPos;
+		//otherwise, the stream's data comes through here.
+		ReadAheadStream* readAhead;
+		//compressed data waiting to be inflated; only used when not mapped.
+		char* inBuf;
+		U32 inBufSz;
+		//true once dcompStream's been initialized.
+		bool inflating;
 		FileSz streamSz;
 		U16 compType;
-		void init(DataStream* pFile, FileSz pStreamStart, FileSz pStreamSz, U16 pCompType);
+		void init(FileSz pStreamSz, U16 pCompType);
+		bool startInflating();
+		FileSz readMapped(U8* dest, FileSz readSz);
+		FileSz readBuffered(U8* dest, FileSz readSz);
+
+		ZipStream(const ZipStream& other);
+		ZipStream& operator=(const ZipStream& other);
 	public:
-		//ZipStream();
-		ZipStream(DataStream* pFile, FileSz pStreamStart, FileSz pStreamSz, U16 pCompType);
+		/**
+		Makes a stream over part of a file, and starts reading it ahead.
+		The stream takes ownership of the file.
+		@param chunkSize the size of each read-ahead buffer.
+		@param chunkCount the number of read-ahead buffers.
+		*/
+		ZipStream(	DataStream* pFile, FileSz pStreamStart, FileSz pStreamSz, U16 pCompType,
+					U32 chunkSize = ReadAheadStream::DEFAULT_CHUNK_SIZE, U32 chunkCount = ReadAheadStream::DEFAULT_CHUNK_COUNT);
+		/**
+		Makes a stream over data in a mapped archive.
+		The stream doesn't own the data; the archive has to outlive the stream.
+		*/
+		ZipStream(const char* pMappedData, FileSz pStreamSz, U16 pCompType);
 		~ZipStream();
 		/**
 		Reads the specified number of bytes into the destination buffer.
@@ -79,10 +181,16 @@ namespace LeEK
 		FileSz Read(U8* dest, FileSz readSz);
 		/**
 		Moves to the specified <em>compressed</em> position in the stream.
+		Compressed streams can only be restarted from the beginning (position 0).
 		@return the new position of the read head in the stream, relative
 		to the start of the stream.
 		*/
 		FileSz Seek(FileSz relPos);
+		/**
+		Gets the number of times a read had to wait for the disk.
+		Always 0 for mapped streams.
+		*/
+		U32 NumStalls() const { return readAhead ? readAhead->NumStalls() : 0; }
 	};
 
 	//now let's define these headers!
@@ -110,6 +218,31 @@ namespace LeEK
 		//and our loading code will break if there is.
 		U16 CommentLen;
 	};
+	//Points to the Zip64DirHeader; immediately precedes the DirHeader.
+	struct ZipFile::Zip64DirLocator
+	{
+		enum { SIGNATURE = 0x07064b50 };
+		U32 Signature;
+		U32 DirHeaderDisk;
+		U64 DirHeaderOffset;
+		U32 NumDisks;
+	};
+	//Replaces any DirHeader fields that are all ones.
+	struct ZipFile::Zip64DirHeader
+	{
+		enum { SIGNATURE = 0x06064b50 };
+		U32 Signature;
+		//size of the rest of the record.
+		U64 HeaderSize;
+		U16 VersionMade;
+		U16 VersionNeeded;
+		U32 DiskNum;
+		U32 DiskStart;
+		U64 NumDirEntriesOnDisk;
+		U64 TotalDirEntries;
+		U64 DirSize;
+		U64 DirOffset;
+	};
 	struct ZipFile::DirFileHeader
 	{
 		enum
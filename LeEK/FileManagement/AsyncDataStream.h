@@ -6,30 +6,46 @@
 namespace LeEK
 {
 	/**
-	TODO: Refactor to IAsyncDataStream
 	Interface for datastreams that asynchronously read/write data.
+	Unlike DataStream, there's no stream position; every request names its own offset,
+	and any number of requests can be outstanding at once.
+	Requests don't necessarily complete in the order they were made.
+
+	When a request completes, its callback gets OnChunkRead() or OnChunkWritten() with the bytes transferred,
+	then OnReadEnd() or OnWriteEnd(); if it fails, it only gets OnError().
+	Callbacks are called from the stream's own threads, and the stream doesn't touch a request's callback
+	after its last call, so the callback can delete itself there.
 	*/
-	class IAsyncDataStream : DataStream
+	class IAsyncDataStream
 	{
 	public:
 		virtual ~IAsyncDataStream(void) {}
-		//virtual bool IsAsync() = 0;
-		virtual bool OpenAsync(const char* path) = 0;
-		virtual bool OpenTextAsync(const char* path) = 0;
-		virtual bool OpenReadOnlyAsync(const char* path) = 0;
+		virtual bool Open(const char* path, StreamFlag flags) = 0;
+		/**
+		Waits for all outstanding requests, then closes the file.
+		*/
 		virtual bool Close() = 0;
 		virtual FileSz FileSize() = 0;
-		virtual FileSz WriteAsync(const char* buffer, FileSz size) = 0;
-		virtual FileSz ReadAsync(char* buffer, FileSz offset, FileSz size) = 0;
-		virtual FileSz WritePos() = 0;
-		virtual FileSz ReadPos() = 0;
-		virtual char* ReadAll() = 0;
-		virtual FileSz Seek(FileSz position) = 0; //move to (position) bytes from beginning of file
-		virtual FileSz FileEnd() { return FileSize() - 1; }
-		virtual FileSz SeekToEnd() { return Seek(FileSize()-1); }
-		virtual FileSz SeekFromEnd(FileSz negPosition) { return Seek(FileSize() - negPosition); }
-		//virtual FileSz WriteAsync(const U8* buffer, FileSz offset, FileSz count) = 0;
-		//virtual FileSz ReadAsync(U8* buffer, FileSz offset, FileSz count) = 0;
-		//virtual FileSz ReadByte() = 0;
+		/**
+		Queues a read of [size] bytes at [offset] into [buffer].
+		The buffer must stay valid until the callback's told the read's done.
+		Reads past the end of the file come up short.
+		@param callback may be NULL.
+		@return false if the request couldn't be queued, in which case the callback isn't called.
+		*/
+		virtual bool ReadAsync(char* buffer, FileSz offset, FileSz size, IAsyncCallback* callback) = 0;
+		/**
+		Queues a write of [size] bytes from [buffer] to [offset].
+		The buffer must stay valid until the callback's told the write's done.
+		*/
+		virtual bool WriteAsync(const char* buffer, FileSz offset, FileSz size, IAsyncCallback* callback) = 0;
+		/**
+		Gets the number of requests that haven't completed yet.
+		*/
+		virtual U32 NumPending() = 0;
+		/**
+		Blocks until every request made so far has completed.
+		*/
+		virtual void WaitForAll() = 0;
 	};
-}
\ No newline at end of file
+}
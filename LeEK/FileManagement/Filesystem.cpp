@@ -1,6 +1,8 @@
 #include "StdAfx.h"
 #include "Filesystem.h"
 #include "StdLibDataStream.h"
+#include "AsyncDataStream.h"
+#include "LinuxAsyncDataStream.h"
 #include "Constants/LogTags.h"
 #include <boost/filesystem.hpp>
 
@@ -115,6 +117,34 @@ DataStream* Filesystem::OpenFileReadOnly(const Path& p)
 	return ds;
 }
 
+namespace
+{
+	IAsyncDataStream* openAsync(const Path& p, StreamFlag flags)
+	{
+#ifdef __linux__
+		IAsyncDataStream* ds = CustomNew<LinuxAsyncDataStream>(FILESYS_ALLOC, LogTags::FILESYS_ALLOC);
+		if(!ds->Open(p.ToString().c_str(), flags))
+		{
+			CustomDelete(ds);
+			return NULL;
+		}
+		return ds;
+#else
+		return NULL;
+#endif
+	}
+}
+
+IAsyncDataStream* Filesystem::OpenFileAsync(const Path& p)
+{
+	return openAsync(p, StreamFlags::ReadWrite);
+}
+
+IAsyncDataStream* Filesystem::OpenFileAsyncReadOnly(const Path& p)
+{
+	return openAsync(p, StreamFlags::Read);
+}
+
 //Note that the stream is invalid from here on out!
 bool Filesystem::CloseFile(DataStream* stream)
 {
@@ -126,4 +156,32 @@ bool Filesystem::CloseFile(DataStream* stream)
 		return result;
 	}
 	return true;
+}
+
+//Waits for the stream's outstanding requests before closing it.
+bool Filesystem::CloseFile(IAsyncDataStream* stream)
+{
+	if(stream)
+	{
+		bool result = stream->Close();
+		CustomDelete(stream);
+		return result;
+	}
+	return true;
+}
+
+bool Filesystem::WriteFile(const Path& p, const char* data, FileSz size)
+{
+	if(Exists(p))
+	{
+		RemoveFile(p);
+	}
+	DataStream* out = OpenFile(p);
+	if(!out)
+	{
+		return false;
+	}
+	bool written = out->Write(data, size) == size;
+	CloseFile(out);
+	return written;
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 namespace LeEK
 {
 	class DataStream;
+	class IAsyncDataStream;
 	class IPlatform;
 
 	namespace Filesystem
@@ -48,8 +49,29 @@ namespace LeEK
 		DataStream* OpenFile(const Path& p);
 		DataStream* OpenFileText(const Path& p);
 		DataStream* OpenFileReadOnly(const Path& p);
-		AsyncDataStream* OpenFileAsync(const Path& p);
+		/**
+		*	Opens a file for asynchronous reads and writes at any offset.
+		*	Returns NULL if the platform has no asynchronous stream,
+		*	in which case use the synchronous streams instead.
+		*/
+		IAsyncDataStream* OpenFileAsync(const Path& p);
+		IAsyncDataStream* OpenFileAsyncReadOnly(const Path& p);
 		bool CloseFile(DataStream* stream);
+		bool CloseFile(IAsyncDataStream* stream);
+		/**
+		*	Writes a whole file in one go, replacing any file already at the path.
+		*/
+		bool WriteFile(const Path& p, const char* data, FileSz size);
+
+		/**
+		*	Returns true if count elements of elemSize bytes, starting at start,
+		*	are all inside a file of fileSize bytes.
+		*	For checking offsets read from a file before using them.
+		*/
+		inline bool InFile(U64 start, U64 count, U64 elemSize, U64 fileSize)
+		{
+			return start <= fileSize && count * elemSize <= fileSize - start;
+		}
 	}
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "FontFile.h"
+#include "TextureFile.h"
+#include "Logging/Log.h"
+#include "Hashing/Hash.h"
+#include "FileManagement/Filesystem.h"
+#include "Math/MathFunctions.h"
+#include "Libraries/MurmurHash3/MurmurHash3.h"
+#include <cstring>
+#include <cstdio>
+
+using namespace LeEK;
+
+namespace
+{
+	//The atlas is never a region atlas, so it's always written without any.
+	const Vector<TextureRegion> noRegions;
+
+	FontHeader buildHeader(const FontAtlasData& font)
+	{
+		FontHeader hdr;
+		memset(&hdr, 0, sizeof(FontHeader));
+		hdr.Signature = FontHeader::SIGNATURE;
+		hdr.Version = CURR_FONT_VER;
+		hdr.Key = font.Key;
+		hdr.BaseSize = font.BaseSize;
+		hdr.Spread = font.Spread;
+		hdr.LineHeight = font.LineHeight;
+		hdr.NumGlyphs = font.Glyphs.size();
+		hdr.GlyphTableStart = sizeof(FontHeader);
+		hdr.TextureStart = Math::RoundUp<U32>(hdr.GlyphTableStart + hdr.NumGlyphs * sizeof(FontGlyph), TEXTURE_DATA_ALIGN);
+		hdr.TextureSize = TextureMgr::FindFileSize(font.Atlas, noRegions);
+		hdr.FileSize = hdr.TextureStart + hdr.TextureSize;
+		return hdr;
+	}
+}
+
+U64 FontMgr::FindFontKey(const char* fontFile, U32 fileSize, U32 baseSize, U32 spread, U32 maxTexSize)
+{
+	U32 settings[4] = { CURR_FONT_VER, baseSize, spread, maxTexSize };
+	U64 hash[2];
+	MurmurHash3_x64_128(fontFile, (int)fileSize, getHash(settings, sizeof(settings)), hash);
+	return hash[0];
+}
+
+String FontMgr::FindCacheName(U64 key)
+{
+	char name[32];
+	sprintf_s(name, sizeof(name), "%016llx.lfnt", (unsigned long long)key);
+	return String(name);
+}
+
+size_t FontMgr::FindFileSize(const FontAtlasData& font)
+{
+	return buildHeader(font).FileSize;
+}
+
+bool FontMgr::WriteFontMemory(const FontAtlasData& font, char* buf, size_t bufSize)
+{
+	if(font.Atlas.PixType != Texture2D::BYTE)
+	{
+		LogE("Font atlas has to be a single channel texture!");
+		return false;
+	}
+	FontHeader hdr = buildHeader(font);
+	if(!buf || bufSize < hdr.FileSize)
+	{
+		LogE("Buffer's too small for font!");
+		return false;
+	}
+	memset(buf, 0, hdr.FileSize);
+	memcpy(buf, &hdr, sizeof(FontHeader));
+	if(hdr.NumGlyphs > 0)
+	{
+		memcpy(buf + hdr.GlyphTableStart, &font.Glyphs[0], hdr.NumGlyphs * sizeof(FontGlyph));
+	}
+	return TextureMgr::WriteTextureMemory(font.Atlas, noRegions, buf + hdr.TextureStart, hdr.TextureSize);
+}
+
+bool FontMgr::IsFontFile(const char* data, size_t size)
+{
+	if(!data || size < sizeof(FontHeader))
+	{
+		return false;
+	}
+	const FontHeader* hdr = (const FontHeader*)data;
+	return hdr->Signature == FontHeader::SIGNATURE && hdr->Version <= CURR_FONT_VER;
+}
+
+bool FontMgr::VerifyFontFile(const char* data, size_t size)
+{
+	if(!IsFontFile(data, size))
+	{
+		LogE("Couldn't verify font header!");
+		return false;
+	}
+	const FontHeader* hdr = (const FontHeader*)data;
+	U64 fileSize = hdr->FileSize;
+	if(fileSize > size || hdr->BaseSize < 1 || hdr->TextureStart % TEXTURE_DATA_ALIGN != 0)
+	{
+		LogE("Font has a malformed header!");
+		return false;
+	}
+	if(!Filesystem::InFile(hdr->GlyphTableStart, hdr->NumGlyphs, sizeof(FontGlyph), fileSize))
+	{
+		LogE("Font has a malformed glyph table!");
+		return false;
+	}
+	if(	!Filesystem::InFile(hdr->TextureStart, hdr->TextureSize, 1, fileSize) ||
+		!TextureMgr::VerifyTextureFile(data + hdr->TextureStart, hdr->TextureSize))
+	{
+		LogE("Font has a malformed atlas!");
+		return false;
+	}
+	const TextureHeader* texHdr = (const TextureHeader*)(data + hdr->TextureStart);
+	if(texHdr->PixType != Texture2D::BYTE || texHdr->CompType != Texture2D::NONE)
+	{
+		LogE("Font atlas isn't a single channel texture!");
+		return false;
+	}
+	const FontGlyph* glyphs = (const FontGlyph*)(data + hdr->GlyphTableStart);
+	for(U32 i = 0; i < hdr->NumGlyphs; ++i)
+	{
+		const FontGlyph& glyph = glyphs[i];
+		if(	glyph.AtlasX > texHdr->Width || glyph.Width > texHdr->Width - glyph.AtlasX ||
+			glyph.AtlasY > texHdr->Height || glyph.Height > texHdr->Height - glyph.AtlasY)
+		{
+			LogE(String("Font has a malformed glyph ") + i + "!");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FontMgr::ReadFontInPlace(FontAtlasData& font, const char* data, size_t size)
+{
+	if(!VerifyFontFile(data, size))
+	{
+		return false;
+	}
+	const FontHeader* hdr = (const FontHeader*)data;
+	if(!TextureMgr::ReadTextureInPlace(font.Atlas, data + hdr->TextureStart, hdr->TextureSize))
+	{
+		return false;
+	}
+	font.Key = hdr->Key;
+	font.BaseSize = hdr->BaseSize;
+	font.Spread = hdr->Spread;
+	font.LineHeight = hdr->LineHeight;
+	const FontGlyph* glyphs = (const FontGlyph*)(data + hdr->GlyphTableStart);
+	font.Glyphs.assign(glyphs, glyphs + hdr->NumGlyphs);
+	return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "Datatypes.h"
+#include "Rendering/Texture.h"
+#include "DataStructures/STLContainers.h"
+#include "Strings/String.h"
+
+namespace LeEK
+{
+	const U16 CURR_FONT_VER = 100;
+
+	//File structs follow.
+	//Specify no packing so that this matches what's written to disk.
+#pragma pack(1)
+	/**
+	Header of a cached glyph atlas (.lfnt).
+	The header's followed by the glyph table and then the atlas itself,
+	a single channel distance field stored as a cooked texture (.ltex).
+	Every offset counts from the start of the file.
+	*/
+	struct FontHeader
+	{
+		enum { SIGNATURE = 0x4C464E54 };
+		U32 Signature;
+		U16 Version;
+		U16 Pad;
+		//From FontMgr::FindFontKey(); a cache only matches the font and settings that built it.
+		U64 Key;
+		//Pixel size the glyphs were rendered at; every metric is at this size.
+		U32 BaseSize;
+		//How far, in pixels at the base size, the distance field reaches past a glyph's edge.
+		U32 Spread;
+		F32 LineHeight;
+		U32 NumGlyphs;
+		U32 GlyphTableStart;
+		//Aligned to TEXTURE_DATA_ALIGN, so the texture's level data stays aligned too.
+		U32 TextureStart;
+		U32 TextureSize;
+		U32 FileSize;
+	};
+
+	/**
+	A glyph's metrics and place in the atlas, all in pixels at the base size.
+	The glyph's cell includes the spread on every side.
+	*/
+	struct FontGlyph
+	{
+		U32 Glyph;
+		F32 AdvanceX;
+		F32 AdvanceY;
+		//Offset of the cell's left edge from the cursor, and of its top edge above the baseline.
+		I32 BearingX;
+		I32 BearingY;
+		U32 Width;
+		U32 Height;
+		//Cell's position in the atlas; Y counts from the first row of the texture's data.
+		U32 AtlasX;
+		U32 AtlasY;
+	};
+#pragma pack()
+
+	//Everything in a cached atlas, outside of a file.
+	struct FontAtlasData
+	{
+		U64 Key;
+		U32 BaseSize;
+		U32 Spread;
+		F32 LineHeight;
+		Vector<FontGlyph> Glyphs;
+		//A Texture2D::BYTE texture.
+		Texture2D Atlas;
+
+		FontAtlasData() : Key(0), BaseSize(0), Spread(0), LineHeight(0), Atlas() {}
+	};
+
+	namespace FontMgr
+	{
+		//Identifies the atlas that would be built from the given font and settings.
+		U64 FindFontKey(const char* fontFile, U32 fileSize, U32 baseSize, U32 spread, U32 maxTexSize);
+		//Name of the file a cached atlas with the given key should be kept in.
+		String FindCacheName(U64 key);
+
+		//Finds the total size of the atlas if written to disk.
+		size_t FindFileSize(const FontAtlasData& font);
+		bool WriteFontMemory(const FontAtlasData& font, char* buf, size_t bufSize);
+		//Returns true if the data starts with a font header. Only looks at the header.
+		bool IsFontFile(const char* data, size_t size);
+		//Checks the header, the glyph table and the embedded texture.
+		bool VerifyFontFile(const char* data, size_t size);
+		/**
+		Reads a cached atlas. The glyphs are copied out,
+		but the atlas' data points straight into data, which has to outlive it.
+		*/
+		bool ReadFontInPlace(FontAtlasData& font, const char* data, size_t size);
+	}
+}
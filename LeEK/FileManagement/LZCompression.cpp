@@ -0,0 +1,249 @@
+#include "LZCompression.h"
+#include <cstring>
+
+using namespace LeEK;
+
+namespace
+{
+	//Each sequence is a token byte (literal count in the high nibble,
+	//match length - MIN_MATCH in the low nibble), any extra literal count bytes,
+	//the literals, a 2 byte little endian offset back to the match,
+	//and any extra match length bytes.
+	//The block ends on a sequence with literals only.
+	const U32 MIN_MATCH = 4;
+	const U32 RUN_MASK = 15;
+	const U32 MAX_OFFSET = 65535;
+	//the format needs a block's last few bytes to be literals,
+	//and no match can start too close to the end.
+	const U32 LAST_LITERALS = 5;
+	const U32 MATCH_FIND_LIMIT = 12;
+	const U32 HASH_BITS = 13;
+	//after this many misses in a row, start skipping ahead faster;
+	//incompressible data then goes by quickly.
+	const U32 SKIP_TRIGGER = 6;
+	const U32 WILD_COPY_SIZE = 16;
+
+	inline U32 read32(const U8* ptr)
+	{
+		U32 result;
+		memcpy(&result, ptr, sizeof(U32));
+		return result;
+	}
+
+	inline U32 hashSequence(U32 sequence)
+	{
+		return (sequence * 2654435761U) >> (32 - HASH_BITS);
+	}
+
+	inline U8* writeLength(U8* out, U32 len)
+	{
+		while(len >= 255)
+		{
+			*out++ = 255;
+			len -= 255;
+		}
+		*out++ = (U8)len;
+		return out;
+	}
+
+	//Writes a sequence. A match length of 0 writes the final, literal only sequence.
+	//Returns NULL if the sequence won't fit.
+	U8* writeSequence(U8* out, const U8* outEnd, const U8* literals, U32 numLiterals, U32 offset, U32 matchLen)
+	{
+		//worst case: token, the literal count, literals, offset, match length.
+		U32 maxSize = 1 + (numLiterals / 255 + 1) + numLiterals + 2 + (matchLen / 255 + 1);
+		if(maxSize > (U32)(outEnd - out))
+		{
+			return NULL;
+		}
+		U8* token = out++;
+		*token = (U8)((numLiterals >= RUN_MASK ? RUN_MASK : numLiterals) << 4);
+		if(numLiterals >= RUN_MASK)
+		{
+			out = writeLength(out, numLiterals - RUN_MASK);
+		}
+		memcpy(out, literals, numLiterals);
+		out += numLiterals;
+		if(matchLen == 0)
+		{
+			return out;
+		}
+		*out++ = (U8)(offset & 0xFF);
+		*out++ = (U8)(offset >> 8);
+		U32 lenCode = matchLen - MIN_MATCH;
+		*token |= (U8)(lenCode >= RUN_MASK ? RUN_MASK : lenCode);
+		if(lenCode >= RUN_MASK)
+		{
+			out = writeLength(out, lenCode - RUN_MASK);
+		}
+		return out;
+	}
+
+	//Reads a length's extra bytes onto len. Returns false if the input runs out first.
+	inline bool readLength(const U8*& in, const U8* inEnd, U32& len)
+	{
+		U8 next;
+		do
+		{
+			if(in >= inEnd)
+			{
+				return false;
+			}
+			next = *in++;
+			len += next;
+		} while(next == 255);
+		return true;
+	}
+}
+
+U32 LZ::MaxCompressedSize(U32 srcSz)
+{
+	return srcSz + srcSz / 255 + 16;
+}
+
+U32 LZ::Compress(const char* src, U32 srcSz, char* dest, U32 destCap)
+{
+	const U8* in = (const U8*)src;
+	U8* out = (U8*)dest;
+	const U8* outEnd = out + destCap;
+	U32 anchor = 0;
+
+	if(srcSz >= MATCH_FIND_LIMIT)
+	{
+		//positions of the last sequence seen with each hash.
+		//Anything stale just fails the compare below.
+		U32 table[1 << HASH_BITS];
+		memset(table, 0, sizeof(table));
+		U32 matchLimit = srcSz - LAST_LITERALS;
+		U32 pos = 1;
+		U32 misses = 0;
+		while(pos + MATCH_FIND_LIMIT <= srcSz)
+		{
+			U32 sequence = read32(in + pos);
+			U32 hash = hashSequence(sequence);
+			U32 candidate = table[hash];
+			table[hash] = pos;
+			if(pos - candidate > MAX_OFFSET || read32(in + candidate) != sequence)
+			{
+				pos += 1 + (misses++ >> SKIP_TRIGGER);
+				continue;
+			}
+			misses = 0;
+			//extend the match back over any matching literals...
+			while(pos > anchor && candidate > 0 && in[pos - 1] == in[candidate - 1])
+			{
+				--pos;
+				--candidate;
+			}
+			//...and forward as far as it goes.
+			U32 matchLen = MIN_MATCH;
+			while(pos + matchLen < matchLimit && in[candidate + matchLen] == in[pos + matchLen])
+			{
+				++matchLen;
+			}
+			out = writeSequence(out, outEnd, in + anchor, pos - anchor, pos - candidate, matchLen);
+			if(!out)
+			{
+				return 0;
+			}
+			pos += matchLen;
+			anchor = pos;
+			//the match's tail is a good candidate for the next one.
+			if(pos + MATCH_FIND_LIMIT <= srcSz)
+			{
+				table[hashSequence(read32(in + pos - 2))] = pos - 2;
+			}
+		}
+	}
+
+	out = writeSequence(out, outEnd, in + anchor, srcSz - anchor, 0, 0);
+	if(!out)
+	{
+		return 0;
+	}
+	return (U32)(out - (U8*)dest);
+}
+
+bool LZ::Decompress(const char* src, U32 srcSz, char* dest, U32 destSz)
+{
+	const U8* in = (const U8*)src;
+	const U8* inEnd = in + srcSz;
+	U8* out = (U8*)dest;
+	U8* outEnd = out + destSz;
+
+	while(in < inEnd)
+	{
+		U8 token = *in++;
+		U32 numLiterals = token >> 4;
+		if(numLiterals == RUN_MASK && !readLength(in, inEnd, numLiterals))
+		{
+			return false;
+		}
+		if(numLiterals > (U32)(inEnd - in) || numLiterals > (U32)(outEnd - out))
+		{
+			return false;
+		}
+		//most runs are short; copying a fixed size is much faster than
+		//a variable size memcpy, as long as there's room to overrun.
+		if(numLiterals <= WILD_COPY_SIZE && inEnd - in >= WILD_COPY_SIZE && outEnd - out >= WILD_COPY_SIZE)
+		{
+			memcpy(out, in, WILD_COPY_SIZE);
+		}
+		else
+		{
+			memcpy(out, in, numLiterals);
+		}
+		in += numLiterals;
+		out += numLiterals;
+		//only the last sequence ends without a match.
+		if(in == inEnd)
+		{
+			break;
+		}
+
+		if(inEnd - in < 2)
+		{
+			return false;
+		}
+		U32 offset = in[0] | (in[1] << 8);
+		in += 2;
+		U32 matchLen = token & RUN_MASK;
+		if(matchLen == RUN_MASK && !readLength(in, inEnd, matchLen))
+		{
+			return false;
+		}
+		matchLen += MIN_MATCH;
+		if(offset == 0 || offset > (U32)(out - (U8*)dest) || matchLen > (U32)(outEnd - out))
+		{
+			return false;
+		}
+		const U8* match = out - offset;
+		if(offset >= 8 && (U32)(outEnd - out) >= matchLen + 8)
+		{
+			//same idea as above, 8 bytes at a time.
+			U8* matchEnd = out + matchLen;
+			do
+			{
+				memcpy(out, match, 8);
+				out += 8;
+				match += 8;
+			} while(out < matchEnd);
+			out = matchEnd;
+		}
+		else if(offset >= matchLen)
+		{
+			memcpy(out, match, matchLen);
+			out += matchLen;
+		}
+		else
+		{
+			//the match overlaps what it's writing (a repeating pattern),
+			//so it has to go byte by byte.
+			for(U32 i = 0; i < matchLen; ++i)
+			{
+				*out++ = *match++;
+			}
+		}
+	}
+	return out == outEnd;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "Datatypes.h"
+
+namespace LeEK
+{
+	/**
+	A fast LZ77 block codec, using the LZ4 block layout.
+	Compresses much worse than DEFLATE, but decompresses several times faster,
+	which is the better trade for data that's loaded far more often than it's built.
+	Blocks are independent and don't record their uncompressed size,
+	so the caller has to store it.
+	*/
+	namespace LZ
+	{
+		/**
+		Gets the largest a block of the given size can become after compression.
+		*/
+		U32 MaxCompressedSize(U32 srcSz);
+		/**
+		Compresses a block.
+		@param destCap the size of dest; MaxCompressedSize() bytes always suffices.
+		@return the compressed size, or 0 if the block didn't fit in dest.
+		*/
+		U32 Compress(const char* src, U32 srcSz, char* dest, U32 destCap);
+		/**
+		Decompresses a block. Corrupt data's detected rather than
+		read or written out of bounds.
+		@param destSz the block's exact uncompressed size.
+		@return true if the block decompressed to exactly destSz bytes.
+		*/
+		bool Decompress(const char* src, U32 srcSz, char* dest, U32 destSz);
+	}
+}
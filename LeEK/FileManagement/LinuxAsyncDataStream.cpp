@@ -0,0 +1,559 @@
+#include "LinuxAsyncDataStream.h"
+#ifdef __linux__
+#include "Memory/Allocator.h"
+#include "Constants/AllocTypes.h"
+#include "Math/MathFunctions.h"
+#include "Logging/Log.h"
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+using namespace LeEK;
+
+namespace
+{
+	//user_data of the no-op that tells the completion thread to stop.
+	//Real requests use their slot index, which is always less.
+	const U64 STOP_MARKER = ~(U64)0;
+
+	int ringEnter(int ringFd, U32 toSubmit, U32 minComplete, U32 flags)
+	{
+#ifdef __NR_io_uring_enter
+		return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+#else
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+
+	//the kernel reads and writes the ring indices from its side,
+	//so they're only touched with these.
+	inline U32 loadAcquire(const U32* index)
+	{
+		return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+	}
+
+	inline void storeRelease(U32* index, U32 value)
+	{
+		__atomic_store_n(index, value, __ATOMIC_RELEASE);
+	}
+}
+
+void LinuxAsyncDataStream::CompletionClient::Run()
+{
+	owner->runCompletion();
+}
+
+void LinuxAsyncDataStream::WorkerClient::Run()
+{
+	owner->runWorker();
+}
+
+LinuxAsyncDataStream::LinuxAsyncDataStream(U32 queueDepthParam, bool allowUringParam) : completionClient(this), workerClient(this)
+{
+	fd = -1;
+	fileSize = 0;
+	queueDepth = Math::Max(queueDepthParam, (U32)1);
+	allowUring = allowUringParam;
+	ringFd = -1;
+	sqRing = NULL;
+	sqRingSz = 0;
+	cqRing = NULL;
+	cqRingSz = 0;
+	sqes = NULL;
+	sqesSz = 0;
+	sqHead = NULL;
+	sqTail = NULL;
+	sqArray = NULL;
+	sqMask = 0;
+	cqHead = NULL;
+	cqTail = NULL;
+	cqMask = 0;
+	cqes = NULL;
+	numPending = 0;
+	stopping = false;
+	completionThread = NULL;
+}
+
+LinuxAsyncDataStream::~LinuxAsyncDataStream()
+{
+	Close();
+}
+
+bool LinuxAsyncDataStream::initRing()
+{
+#ifdef __NR_io_uring_setup
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	//one extra entry for the stop marker.
+	ringFd = (int)syscall(__NR_io_uring_setup, queueDepth + 1, &params);
+	if(ringFd < 0)
+	{
+		ringFd = -1;
+		return false;
+	}
+	//IORING_OP_READ and WRITE arrived in the same release as this feature;
+	//older kernels would fail every request.
+	if(!(params.features & IORING_FEAT_RW_CUR_POS))
+	{
+		endRing();
+		return false;
+	}
+
+	sqRingSz = params.sq_off.array + params.sq_entries * sizeof(U32);
+	cqRingSz = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if(singleMap)
+	{
+		sqRingSz = cqRingSz = Math::Max(sqRingSz, cqRingSz);
+	}
+	sqRing = mmap(NULL, sqRingSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+	if(sqRing == MAP_FAILED)
+	{
+		sqRing = NULL;
+		endRing();
+		return false;
+	}
+	if(singleMap)
+	{
+		cqRing = sqRing;
+	}
+	else
+	{
+		cqRing = mmap(NULL, cqRingSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		if(cqRing == MAP_FAILED)
+		{
+			cqRing = NULL;
+			endRing();
+			return false;
+		}
+	}
+	sqesSz = params.sq_entries * sizeof(struct io_uring_sqe);
+	sqes = mmap(NULL, sqesSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+	if(sqes == MAP_FAILED)
+	{
+		sqes = NULL;
+		endRing();
+		return false;
+	}
+
+	char* sqBase = (char*)sqRing;
+	sqHead = (U32*)(sqBase + params.sq_off.head);
+	sqTail = (U32*)(sqBase + params.sq_off.tail);
+	sqMask = *(U32*)(sqBase + params.sq_off.ring_mask);
+	sqArray = (U32*)(sqBase + params.sq_off.array);
+	char* cqBase = (char*)cqRing;
+	cqHead = (U32*)(cqBase + params.cq_off.head);
+	cqTail = (U32*)(cqBase + params.cq_off.tail);
+	cqMask = *(U32*)(cqBase + params.cq_off.ring_mask);
+	cqes = cqBase + params.cq_off.cqes;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void LinuxAsyncDataStream::endRing()
+{
+	if(sqes)
+	{
+		munmap(sqes, sqesSz);
+	}
+	if(cqRing && cqRing != sqRing)
+	{
+		munmap(cqRing, cqRingSz);
+	}
+	if(sqRing)
+	{
+		munmap(sqRing, sqRingSz);
+	}
+	if(ringFd >= 0)
+	{
+		close(ringFd);
+	}
+	ringFd = -1;
+	sqRing = NULL;
+	cqRing = NULL;
+	sqes = NULL;
+}
+
+bool LinuxAsyncDataStream::Open(const char* path, StreamFlag flags)
+{
+	Close();
+	int openFlags = (flags & StreamFlags::Write) ? (O_RDWR | O_CREAT) : O_RDONLY;
+	fd = open(path, openFlags, 0644);
+	if(fd < 0)
+	{
+		return false;
+	}
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0)
+	{
+		close(fd);
+		fd = -1;
+		return false;
+	}
+	fileSize = (FileSz)fileStat.st_size;
+	stopping = false;
+	numPending = 0;
+
+	if(allowUring && initRing())
+	{
+		slots.resize(queueDepth);
+		freeSlots.clear();
+		for(U32 i = 0; i < queueDepth; ++i)
+		{
+			freeSlots.push_back(queueDepth - 1 - i);
+		}
+		completionThread = LNew(Thread, THREAD_ALLOC, "ThreadAlloc")(&completionClient);
+		completionThread->Start();
+	}
+	else
+	{
+		if(allowUring)
+		{
+			LogV("io_uring isn't available, using threads for async I/O");
+		}
+		U32 numWorkers = Math::Min(queueDepth, MAX_POOL_THREADS);
+		for(U32 i = 0; i < numWorkers; ++i)
+		{
+			Thread* worker = LNew(Thread, THREAD_ALLOC, "ThreadAlloc")(&workerClient);
+			worker->Start();
+			workers.push_back(worker);
+		}
+	}
+	return true;
+}
+
+bool LinuxAsyncDataStream::Close()
+{
+	if(fd < 0)
+	{
+		return true;
+	}
+	WaitForAll();
+	{
+		std::lock_guard<std::mutex> lock(mutex.GetMutex());
+		stopping = true;
+		if(UsesUring())
+		{
+			submitNop();
+		}
+	}
+	requestReady.notify_all();
+	if(completionThread)
+	{
+		completionThread->Join();
+		LDelete(completionThread);
+		completionThread = NULL;
+	}
+	for(U32 i = 0; i < workers.size(); ++i)
+	{
+		workers[i]->Join();
+		LDelete(workers[i]);
+	}
+	workers.clear();
+	endRing();
+	slots.clear();
+	freeSlots.clear();
+
+	bool result = close(fd) == 0;
+	fd = -1;
+	fileSize = 0;
+	return result;
+}
+
+FileSz LinuxAsyncDataStream::FileSize()
+{
+	std::lock_guard<std::mutex> lock(mutex.GetMutex());
+	return fileSize;
+}
+
+void LinuxAsyncDataStream::submitToRing(const Request& request)
+{
+	U32 slot = freeSlots.back();
+	freeSlots.pop_back();
+	slots[slot] = request;
+
+	U32 tail = *sqTail;
+	U32 index = tail & sqMask;
+	struct io_uring_sqe* sqe = (struct io_uring_sqe*)sqes + index;
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = request.Type == AsyncRead ? IORING_OP_READ : IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = (U64)(size_t)request.Buffer;
+	sqe->len = request.Size;
+	sqe->off = request.Offset;
+	sqe->user_data = slot;
+	sqArray[index] = index;
+	storeRelease(sqTail, tail + 1);
+	//the ring has room for every slot, so this only fails on a signal.
+	while(ringEnter(ringFd, 1, 0, 0) < 0 && (errno == EINTR || errno == EAGAIN))
+	{
+	}
+}
+
+void LinuxAsyncDataStream::submitNop()
+{
+	U32 tail = *sqTail;
+	U32 index = tail & sqMask;
+	struct io_uring_sqe* sqe = (struct io_uring_sqe*)sqes + index;
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_NOP;
+	sqe->user_data = STOP_MARKER;
+	sqArray[index] = index;
+	storeRelease(sqTail, tail + 1);
+	while(ringEnter(ringFd, 1, 0, 0) < 0 && (errno == EINTR || errno == EAGAIN))
+	{
+	}
+}
+
+bool LinuxAsyncDataStream::enqueue(const Request& request)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex.GetMutex());
+		if(fd < 0 || stopping)
+		{
+			return false;
+		}
+		++numPending;
+		if(UsesUring() && !freeSlots.empty())
+		{
+			submitToRing(request);
+			return true;
+		}
+		backlog.push_back(request);
+	}
+	requestReady.notify_one();
+	return true;
+}
+
+bool LinuxAsyncDataStream::ReadAsync(char* buffer, FileSz offset, FileSz size, IAsyncCallback* callback)
+{
+	if(!buffer && size > 0)
+	{
+		return false;
+	}
+	Request request = { AsyncRead, buffer, offset, size, 0, callback };
+	return enqueue(request);
+}
+
+bool LinuxAsyncDataStream::WriteAsync(const char* buffer, FileSz offset, FileSz size, IAsyncCallback* callback)
+{
+	if(!buffer && size > 0)
+	{
+		return false;
+	}
+	Request request = { AsyncWrite, (char*)buffer, offset, size, 0, callback };
+	return enqueue(request);
+}
+
+void LinuxAsyncDataStream::runCompletion()
+{
+	bool stopSeen = false;
+	while(!stopSeen)
+	{
+		if(ringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+		{
+			int error = errno;
+			LogE(String("Waiting on io_uring failed: ") + strerror(error));
+			//Nothing will complete now, so don't leave WaitForAll() hanging.
+			failOutstanding(-error);
+			return;
+		}
+		U32 head = *cqHead;
+		U32 tail = loadAcquire(cqTail);
+		while(head != tail)
+		{
+			const struct io_uring_cqe& cqe = ((const struct io_uring_cqe*)cqes)[head & cqMask];
+			U64 slot = cqe.user_data;
+			I32 result = cqe.res;
+			++head;
+			//hand the entry back before the callback runs, so the kernel can reuse it.
+			storeRelease(cqHead, head);
+			if(slot == STOP_MARKER)
+			{
+				stopSeen = true;
+				continue;
+			}
+
+			Request request;
+			bool resubmitted = false;
+			{
+				std::lock_guard<std::mutex> lock(mutex.GetMutex());
+				request = slots[(U32)slot];
+				freeSlots.push_back((U32)slot);
+				//Regular files only come up short at the end of the file,
+				//but a signal can interrupt a large transfer. Pick up where it left off.
+				bool shortRead = request.Type == AsyncRead && request.Offset + result < fileSize;
+				if(result > 0 && (FileSz)result < request.Size && (request.Type == AsyncWrite || shortRead))
+				{
+					request.Buffer += result;
+					request.Offset += result;
+					request.Size -= result;
+					request.Done += result;
+					submitToRing(request);
+					resubmitted = true;
+				}
+				//and let a waiting request take the free slot.
+				else if(!backlog.empty())
+				{
+					submitToRing(backlog.front());
+					backlog.pop_front();
+				}
+			}
+			if(!resubmitted)
+			{
+				complete(request, result);
+			}
+		}
+	}
+}
+
+void LinuxAsyncDataStream::failOutstanding(I64 result)
+{
+	Vector<Request> failed;
+	{
+		std::lock_guard<std::mutex> lock(mutex.GetMutex());
+		//turn away new requests; there's nothing left to complete them.
+		stopping = true;
+		Vector<U8> isFree;
+		isFree.resize(slots.size(), 0);
+		for(U32 i = 0; i < freeSlots.size(); ++i)
+		{
+			isFree[freeSlots[i]] = 1;
+		}
+		freeSlots.clear();
+		for(U32 i = 0; i < slots.size(); ++i)
+		{
+			if(!isFree[i])
+			{
+				failed.push_back(slots[i]);
+			}
+			freeSlots.push_back(slots.size() - 1 - i);
+		}
+		failed.insert(failed.end(), backlog.begin(), backlog.end());
+		backlog.clear();
+	}
+	for(U32 i = 0; i < failed.size(); ++i)
+	{
+		complete(failed[i], result);
+	}
+}
+
+void LinuxAsyncDataStream::runWorker()
+{
+	while(true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex.GetMutex());
+			while(backlog.empty() && !stopping)
+			{
+				requestReady.wait(lock);
+			}
+			if(backlog.empty())
+			{
+				return;
+			}
+			request = backlog.front();
+			backlog.pop_front();
+		}
+
+		I64 result = 0;
+		while((FileSz)result < request.Size)
+		{
+			ssize_t count = request.Type == AsyncRead ?
+							pread(fd, request.Buffer + result, request.Size - result, request.Offset + result) :
+							pwrite(fd, request.Buffer + result, request.Size - result, request.Offset + result);
+			if(count < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+				result = -errno;
+				break;
+			}
+			//end of file.
+			if(count == 0)
+			{
+				break;
+			}
+			result += count;
+		}
+		complete(request, result);
+	}
+}
+
+void LinuxAsyncDataStream::complete(const Request& request, I64 result)
+{
+	IAsyncCallback* callback = request.Callback;
+	if(result < 0)
+	{
+		LogW(String("Async ") + (request.Type == AsyncRead ? "read" : "write") + " at " +
+			(request.Offset) + " failed: " + strerror((int)-result));
+		if(callback)
+		{
+			callback->OnError();
+		}
+	}
+	else
+	{
+		FileSz transferred = request.Done + (FileSz)result;
+		if(request.Type == AsyncRead)
+		{
+			if(callback)
+			{
+				callback->OnChunkRead(transferred);
+				callback->OnReadEnd();
+			}
+		}
+		else
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex.GetMutex());
+				fileSize = Math::Max(fileSize, (FileSz)(request.Offset + result));
+			}
+			if(callback)
+			{
+				callback->OnChunkWritten(transferred);
+				callback->OnWriteEnd();
+			}
+		}
+	}
+
+	//only counted as done once the callback's finished,
+	//so WaitForAll() means every callback's been called, too.
+	bool allFinished;
+	{
+		std::lock_guard<std::mutex> lock(mutex.GetMutex());
+		--numPending;
+		allFinished = numPending == 0;
+	}
+	if(allFinished)
+	{
+		allDone.notify_all();
+	}
+}
+
+U32 LinuxAsyncDataStream::NumPending()
+{
+	std::lock_guard<std::mutex> lock(mutex.GetMutex());
+	return numPending;
+}
+
+void LinuxAsyncDataStream::WaitForAll()
+{
+	std::unique_lock<std::mutex> lock(mutex.GetMutex());
+	while(numPending > 0)
+	{
+		allDone.wait(lock);
+	}
+}
+#endif //__linux__
@@ -0,0 +1,131 @@
+#pragma once
+#ifdef __linux__
+#include "AsyncDataStream.h"
+#include "DataStructures/STLContainers.h"
+#include "MultiThreading/StdThreading.h"
+#include <condition_variable>
+#include <cstddef>
+
+namespace LeEK
+{
+	/**
+	Asynchronous file stream for Linux.
+	Requests go through an io_uring where the kernel supports it,
+	so they can all be in flight at once with no thread per request.
+	Otherwise, a pool of threads services them with pread()/pwrite().
+	*/
+	class LinuxAsyncDataStream : public IAsyncDataStream
+	{
+	public:
+		static const U32 DEFAULT_QUEUE_DEPTH = 64;
+		//the fallback's threads block on their requests,
+		//so any requests past this many wait for a thread to free up.
+		static const U32 MAX_POOL_THREADS = 16;
+	private:
+		class CompletionClient : public IThreadClient
+		{
+		private:
+			LinuxAsyncDataStream* owner;
+		public:
+			CompletionClient(LinuxAsyncDataStream* ownerParam) : owner(ownerParam) {}
+			void Run();
+		};
+		class WorkerClient : public IThreadClient
+		{
+		private:
+			LinuxAsyncDataStream* owner;
+		public:
+			WorkerClient(LinuxAsyncDataStream* ownerParam) : owner(ownerParam) {}
+			void Run();
+		};
+		struct Request
+		{
+			AsyncRequest Type;
+			char* Buffer;
+			FileSz Offset;
+			FileSz Size;
+			//bytes already transferred, if the request had to be resubmitted after coming up short.
+			FileSz Done;
+			IAsyncCallback* Callback;
+		};
+
+		int fd;
+		FileSz fileSize;
+		U32 queueDepth;
+		bool allowUring;
+
+		//The ring's shared with the kernel; ringFd's -1 if the thread pool's in use instead.
+		int ringFd;
+		void* sqRing;
+		size_t sqRingSz;
+		void* cqRing;
+		size_t cqRingSz;
+		//io_uring_sqe array.
+		void* sqes;
+		size_t sqesSz;
+		U32* sqHead;
+		U32* sqTail;
+		U32* sqArray;
+		U32 sqMask;
+		U32* cqHead;
+		U32* cqTail;
+		U32 cqMask;
+		//io_uring_cqe array.
+		void* cqes;
+
+		//guards everything below, and submission to the ring.
+		Mutex mutex;
+		std::condition_variable requestReady;
+		std::condition_variable allDone;
+		//requests in the ring, by the slot index they're submitted with.
+		Vector<Request> slots;
+		Vector<U32> freeSlots;
+		//requests waiting for a free slot or a pool thread.
+		List<Request> backlog;
+		U32 numPending;
+		bool stopping;
+
+		CompletionClient completionClient;
+		Thread* completionThread;
+		WorkerClient workerClient;
+		Vector<Thread*> workers;
+
+		bool initRing();
+		void endRing();
+		//Both of these expect the lock to be held.
+		void submitToRing(const Request& request);
+		void submitNop();
+		bool enqueue(const Request& request);
+		void runCompletion();
+		//Fails every request in the ring or the backlog, and stops taking new ones.
+		//For when the ring's stopped working; expects the lock to NOT be held.
+		void failOutstanding(I64 result);
+		void runWorker();
+		//Reports the request to its callback. result is the bytes transferred or a negative errno.
+		void complete(const Request& request, I64 result);
+
+		LinuxAsyncDataStream(const LinuxAsyncDataStream& other);
+		LinuxAsyncDataStream& operator=(const LinuxAsyncDataStream& other);
+	public:
+		/**
+		@param queueDepthParam the most requests that can be in flight at once;
+		requests past that wait in a queue.
+		@param allowUringParam if false, always uses the thread pool.
+		*/
+		LinuxAsyncDataStream(U32 queueDepthParam = DEFAULT_QUEUE_DEPTH, bool allowUringParam = true);
+		~LinuxAsyncDataStream();
+
+		bool Open(const char* path, StreamFlag flags);
+		bool Close();
+		FileSz FileSize();
+		bool ReadAsync(char* buffer, FileSz offset, FileSz size, IAsyncCallback* callback);
+		bool WriteAsync(const char* buffer, FileSz offset, FileSz size, IAsyncCallback* callback);
+		U32 NumPending();
+		void WaitForAll();
+		/**
+		Returns true if requests are going through io_uring, rather than the thread pool.
+		*/
+		bool UsesUring() const { return ringFd >= 0; }
+	};
+}
+#endif //__linux__
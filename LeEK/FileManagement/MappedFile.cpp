@@ -0,0 +1,73 @@
+#include "MappedFile.h"
+#include "Logging/Log.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace LeEK;
+
+MappedFile::MappedFile()
+{
+	data = NULL;
+	size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef __linux__
+bool MappedFile::Open(const Path& path)
+{
+	Close();
+	int fd = open(path.ToString().c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		return false;
+	}
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+	//the mapping holds its own reference to the file,
+	//so the descriptor's not needed past this.
+	void* mapped = mmap(NULL, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED)
+	{
+		LogW(String("Couldn't map ") + path.ToString() + "!");
+		return false;
+	}
+	data = (char*)mapped;
+	size = (FileSz)fileStat.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(data)
+	{
+		munmap(data, size);
+	}
+	data = NULL;
+	size = 0;
+}
+
+#else
+bool MappedFile::Open(const Path& path)
+{
+	return false;
+}
+
+void MappedFile::Close()
+{
+	data = NULL;
+	size = 0;
+}
+#endif
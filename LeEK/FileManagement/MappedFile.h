@@ -0,0 +1,37 @@
+#pragma once
+#include "Datatypes.h"
+#include "FileManagement/path.h"
+
+namespace LeEK
+{
+	/**
+	A read only file that's mapped into memory as a whole,
+	so reading it is just a matter of reading memory;
+	pages are loaded by the OS as they're touched, and are shared with the page cache.
+	Only implemented on Linux; elsewhere Open() always fails,
+	and callers should fall back to a DataStream.
+	*/
+	class MappedFile
+	{
+	private:
+		char* data;
+		FileSz size;
+
+		MappedFile(const MappedFile& other);
+		MappedFile& operator=(const MappedFile& other);
+	public:
+		MappedFile();
+		~MappedFile();
+
+		/**
+		Maps the file at the given path.
+		The mapping's private, so writes to it are allowed,
+		but only copy the written pages for this process.
+		*/
+		bool Open(const Path& path);
+		void Close();
+		bool IsOpen() const { return data != NULL; }
+		char* Data() const { return data; }
+		FileSz Size() const { return size; }
+	};
+}
@@ -1,12 +1,19 @@
 #include "ModelFile.h"
 #include "Memory/Allocator.h"
 #include "Logging/Log.h"
+#include "FileManagement/Filesystem.h"
+#include "Math/MathFunctions.h"
+#include <cstddef>
 
 using namespace LeEK;
 
 void logModelHeaderInfo(const ModelHeader& hdr)
 {
 	LogV(String("\tNum. Meshes:\t") + hdr.NumUnits);
+	if(hdr.Version >= LOD_MODEL_VER)
+	{
+		LogV(String("\tNum. LODs:\t") + hdr.NumLODs);
+	}
 	LogV(String("\tData Start Offset:\t") + HexStrFromVal(hdr.MeshHdrStart));
 }
 
@@ -63,8 +70,11 @@ struct CombinedHeaders
 {
 public:
 	ModelHeader MainHeader;
+	Vector<LODHeader> LODHeaders;
 	MeshHeader* MeshHeaders;
 	U32 NumMeshHeaders;
+	//The mesh each mesh header describes.
+	Vector<const Mesh*> Units;
 
 	CombinedHeaders()
 	{
@@ -74,14 +84,30 @@ public:
 	}
 };
 
+/**
+Lists every mesh in the model in the order they're written to file;
+all of LOD 0's meshes, then all of LOD 1's, and so on.
+*/
+void listUnits(const Model& model, Vector<const Mesh*>& units)
+{
+	for(U32 lod = 0; lod < model.LODCount(); ++lod)
+	{
+		for(U32 i = 0; i < model.LODMeshCount(lod); ++i)
+		{
+			units.push_back(model.GetLODMesh(lod, i));
+		}
+	}
+}
+
 bool buildHeaders(const Model& model, CombinedHeaders* outHdrs)
 {
 	//CombinedHeaders outHdrs = CombinedHeaders();
 	ModelHeader& mainHeader = outHdrs->MainHeader;
 	memset(&mainHeader, 0, sizeof(ModelHeader));
 	mainHeader.Signature = ModelHeader::SIGNATURE;
-	mainHeader.Version = CURR_MODEL_VER;
-	mainHeader.NumUnits = model.MeshCount();
+	mainHeader.Version = LOD_MODEL_VER;
+	listUnits(model, outHdrs->Units);
+	mainHeader.NumUnits = outHdrs->Units.size();
 	LogV(String("Header.NumUnits = ") + mainHeader.NumUnits);
 	if(mainHeader.NumUnits < 1)
 	{
@@ -90,7 +116,22 @@ bool buildHeaders(const Model& model, CombinedHeaders* outHdrs)
 		return false;
 	}
 	size_t meshHdrBufSize = mainHeader.NumUnits * sizeof(MeshHeader);
-	mainHeader.MeshHdrStart = sizeof(ModelHeader);
+	//LOD headers go right after the main header,
+	//then the mesh headers.
+	mainHeader.NumLODs = model.LODCount();
+	mainHeader.LODHdrStart = sizeof(ModelHeader);
+	mainHeader.MeshHdrStart = mainHeader.LODHdrStart + mainHeader.NumLODs * sizeof(LODHeader);
+	U16 firstUnit = 0;
+	for(U32 lod = 0; lod < model.LODCount(); ++lod)
+	{
+		LODHeader lodHdr;
+		lodHdr.Signature = LODHeader::SIGNATURE;
+		lodHdr.FirstUnit = firstUnit;
+		lodHdr.NumUnits = model.LODMeshCount(lod);
+		lodHdr.GeometricError = model.LODError(lod);
+		outHdrs->LODHeaders.push_back(lodHdr);
+		firstUnit += lodHdr.NumUnits;
+	}
 	const Vector3& bounds = model.AABBBounds();
 	mainHeader.BoundsX = bounds.X();
 	mainHeader.BoundsY = bounds.Y();
@@ -120,8 +161,13 @@ bool buildHeaders(const Model& model, CombinedHeaders* outHdrs)
 	for(U32 i = 0; i < mainHeader.NumUnits; ++i)
 	{
 		LogV(String("Header.NumUnits = ") + mainHeader.NumUnits);
-		const Mesh* mesh = model.GetMesh(i);
+		const Mesh* mesh = outHdrs->Units[i];
 		const Geometry& geom = mesh->GetGeometry();
+		if(geom.IsPacked())
+		{
+			LogE(String("Mesh ") + i + " is packed; only version " + PACKED_MODEL_VER + " and up can store packed meshes!");
+			return false;
+		}
 		//setup the header
 		MeshHeader& meshHdr = meshHeaders[i];
 		meshHdr.Signature = MeshHeader::SIGNATURE;
@@ -172,8 +218,170 @@ void writeToBuffer(char* buf, const char* bufEnd, const char* data, size_t dataS
 	memcpy_s(buf, bufEnd-buf, data, dataSize);
 }
 
-bool ModelMgr::WriteModelMemory(const Model& model, char* buf, size_t bufSize)
+/**
+Where everything goes in an in-place file.
+*/
+struct InPlaceLayout
+{
+public:
+	ModelHeader MainHeader;
+	Vector<LODHeader> LODHeaders;
+	Vector<InPlaceMeshHeader> MeshHeaders;
+	Vector<char> Strings;
+	//offsets of each string already in the table, so materials can share them.
+	Vector<U32> StringOffsets;
+	Vector<const Mesh*> Units;
+
+	InPlaceLayout()
+	{
+		memset(&MainHeader, 0, sizeof(ModelHeader));
+	}
+};
+
+U32 addString(InPlaceLayout& layout, const ResGUID& guid)
+{
+	if(guid.Length() == 0)
+	{
+		return InPlaceMeshHeader::NO_STRING;
+	}
+	for(U32 i = 0; i < layout.StringOffsets.size(); ++i)
+	{
+		if(strcmp(&layout.Strings[layout.StringOffsets[i]], guid.Name) == 0)
+		{
+			return layout.StringOffsets[i];
+		}
+	}
+	U32 offset = layout.Strings.size();
+	layout.Strings.insert(layout.Strings.end(), guid.Name, guid.Name + guid.Length() + 1);
+	layout.StringOffsets.push_back(offset);
+	return offset;
+}
+
+bool buildInPlaceLayout(const Model& model, InPlaceLayout* outLayout)
+{
+	ModelHeader& mainHeader = outLayout->MainHeader;
+	mainHeader.Signature = ModelHeader::SIGNATURE;
+	mainHeader.Version = PACKED_MODEL_VER;
+	listUnits(model, outLayout->Units);
+	mainHeader.NumUnits = outLayout->Units.size();
+	if(mainHeader.NumUnits < 1)
+	{
+		LogW("No mesh data to build headers from!");
+		return false;
+	}
+	const Vector3& bounds = model.AABBBounds();
+	mainHeader.BoundsX = bounds.X();
+	mainHeader.BoundsY = bounds.Y();
+	mainHeader.BoundsZ = bounds.Z();
+	mainHeader.BoundingRadius = model.BoundingRadius();
+
+	//The main header's followed by the LOD headers, the mesh headers and the string table,
+	//then each mesh's vertices and indices.
+	mainHeader.NumLODs = model.LODCount();
+	mainHeader.LODHdrStart = sizeof(ModelHeader);
+	mainHeader.MeshHdrStart = mainHeader.LODHdrStart + mainHeader.NumLODs * sizeof(LODHeader);
+	U16 firstUnit = 0;
+	for(U32 lod = 0; lod < model.LODCount(); ++lod)
+	{
+		LODHeader lodHdr;
+		lodHdr.Signature = LODHeader::SIGNATURE;
+		lodHdr.FirstUnit = firstUnit;
+		lodHdr.NumUnits = model.LODMeshCount(lod);
+		lodHdr.GeometricError = model.LODError(lod);
+		outLayout->LODHeaders.push_back(lodHdr);
+		firstUnit += lodHdr.NumUnits;
+	}
+
+	outLayout->MeshHeaders.resize(mainHeader.NumUnits);
+	for(U32 i = 0; i < mainHeader.NumUnits; ++i)
+	{
+		const Mesh* mesh = outLayout->Units[i];
+		const Geometry& geom = mesh->GetGeometry();
+		const Material& mat = mesh->GetMaterial();
+		InPlaceMeshHeader& meshHdr = outLayout->MeshHeaders[i];
+		meshHdr = InPlaceMeshHeader();
+		meshHdr.Signature = InPlaceMeshHeader::SIGNATURE;
+		meshHdr.NumVerts = geom.VertexCount();
+		meshHdr.NumIndices = geom.IndexCount();
+		meshHdr.NumTexChannels = geom.UVChannelCount();
+		meshHdr.DiffuseColor = mat.DiffuseColor;
+		meshHdr.SpecularColor = mat.SpecularColor;
+		meshHdr.EmissiveColor = mat.EmissiveColor;
+		meshHdr.DiffuseGUID = addString(*outLayout, mat.DiffuseTexGUID);
+		meshHdr.SpecularGUID = addString(*outLayout, mat.SpecularTexGUID);
+		meshHdr.EmissiveGUID = addString(*outLayout, mat.EmissiveTexGUID);
+		meshHdr.NormalMapGUID = addString(*outLayout, mat.NormalMapGUID);
+		meshHdr.VertFormat = geom.Format();
+		meshHdr.IndexSize = geom.IndexSize();
+		const Vector3& posOffset = geom.PositionOffset();
+		const Vector3& posScale = geom.PositionScale();
+		meshHdr.PosOffset[0] = posOffset.X();
+		meshHdr.PosOffset[1] = posOffset.Y();
+		meshHdr.PosOffset[2] = posOffset.Z();
+		meshHdr.PosScale[0] = posScale.X();
+		meshHdr.PosScale[1] = posScale.Y();
+		meshHdr.PosScale[2] = posScale.Z();
+	}
+	mainHeader.StringTableStart = mainHeader.MeshHdrStart + mainHeader.NumUnits * sizeof(InPlaceMeshHeader);
+	mainHeader.StringTableSize = outLayout->Strings.size();
+
+	U32 currDataOffset = mainHeader.StringTableStart + mainHeader.StringTableSize;
+	for(U32 i = 0; i < mainHeader.NumUnits; ++i)
+	{
+		InPlaceMeshHeader& meshHdr = outLayout->MeshHeaders[i];
+		meshHdr.VertexDataStart = Math::RoundUp<U32>(currDataOffset, MODEL_DATA_ALIGN);
+		const Geometry& geom = outLayout->Units[i]->GetGeometry();
+		meshHdr.IndexDataStart = Math::RoundUp<U32>(meshHdr.VertexDataStart + geom.VertexSizeAsBuffer(), MODEL_DATA_ALIGN);
+		currDataOffset = meshHdr.IndexDataStart + geom.IndexSizeAsBuffer();
+	}
+	mainHeader.FileSize = currDataOffset;
+	return true;
+}
+
+bool writeInPlaceMemory(const Model& model, char* buf, size_t bufSize)
 {
+	InPlaceLayout layout;
+	if(!buildInPlaceLayout(model, &layout))
+	{
+		LogE("Failed to build model headers!");
+		return false;
+	}
+	const ModelHeader& mainHeader = layout.MainHeader;
+	if(bufSize < mainHeader.FileSize)
+	{
+		LogE("WriteModelMemory: Destination buffer is too small!");
+		return false;
+	}
+	//zero the padding, too.
+	memset(buf, 0, mainHeader.FileSize);
+	memcpy(buf, &mainHeader, sizeof(ModelHeader));
+	memcpy(buf + mainHeader.LODHdrStart, &layout.LODHeaders[0], layout.LODHeaders.size() * sizeof(LODHeader));
+	memcpy(buf + mainHeader.MeshHdrStart, &layout.MeshHeaders[0], layout.MeshHeaders.size() * sizeof(InPlaceMeshHeader));
+	if(!layout.Strings.empty())
+	{
+		memcpy(buf + mainHeader.StringTableStart, &layout.Strings[0], layout.Strings.size());
+	}
+	for(U32 i = 0; i < layout.MeshHeaders.size(); ++i)
+	{
+		const InPlaceMeshHeader& meshHdr = layout.MeshHeaders[i];
+		const Geometry& geom = layout.Units[i]->GetGeometry();
+		if(!geom.VertexData() || !geom.IndexData())
+		{
+			LogE(String("Mesh ") + i + " is missing geometry or index data, halting conversion!");
+			return false;
+		}
+		memcpy(buf + meshHdr.VertexDataStart, geom.VertexData(), geom.VertexSizeAsBuffer());
+		memcpy(buf + meshHdr.IndexDataStart, geom.IndexData(), geom.IndexSizeAsBuffer());
+	}
+	return true;
+}
+
+bool ModelMgr::WriteModelMemory(const Model& model, char* buf, size_t bufSize, U16 version)
+{
+	if(version >= INPLACE_MODEL_VER)
+	{
+		return writeInPlaceMemory(model, buf, bufSize);
+	}
 	char* bufHead = buf;
 	char* bufEnd = buf + bufSize;
 	//build the start header
@@ -192,15 +400,17 @@ bool ModelMgr::WriteModelMemory(const Model& model, char* buf, size_t bufSize)
 
 	writeToBuffer(bufHead, bufEnd, (char*)&headers.MainHeader, sizeof(ModelHeader));
 	bufHead += sizeof(ModelHeader);
+	writeToBuffer(bufHead, bufEnd, (char*)&headers.LODHeaders[0], sizeof(LODHeader)*headers.LODHeaders.size());
+	bufHead += sizeof(LODHeader)*headers.LODHeaders.size();
 	writeToBuffer(bufHead, bufEnd, (char*)headers.MeshHeaders, sizeof(MeshHeader)*headers.NumMeshHeaders);
 	bufHead += sizeof(MeshHeader)*headers.NumMeshHeaders;
 	//now write the data!
 	//headerNum = 0;
-	for(U32 i = 0; i < model.MeshCount(); ++i)//(Model::ConstMeshIt cit = model.GetMeshBegin(); cit != model.GetMeshEnd(); ++cit)
+	for(U32 i = 0; i < headers.NumMeshHeaders; ++i)//(Model::ConstMeshIt cit = model.GetMeshBegin(); cit != model.GetMeshEnd(); ++cit)
 	{
 		const MeshHeader& meshHdr = headers.MeshHeaders[i];
 
-		const Mesh* mesh = model.GetMesh(i);
+		const Mesh* mesh = headers.Units[i];
 		//write the GUIDs first
 		const Material& mat = mesh->GetMaterial();
 		if(meshHdr.DiffuseGUIDLen > 0)
@@ -252,8 +462,21 @@ bool ModelMgr::WriteModelMemory(const Model& model, char* buf, size_t bufSize)
 	return true;
 }
 
-bool ModelMgr::WriteModelFile(const Model& model, DataStream* file)
+bool ModelMgr::WriteModelFile(const Model& model, DataStream* file, U16 version)
 {
+	if(version >= INPLACE_MODEL_VER)
+	{
+		//the layout's easiest built in memory, since the geometry's padded.
+		size_t fileSize = FindFileSize(model, version);
+		char* buf = CustomArrayNew<char>(fileSize, FILEWRITE_ALLOC, "FileWriteAlloc");
+		if(!buf)
+		{
+			return false;
+		}
+		bool result = writeInPlaceMemory(model, buf, fileSize) && file->Write(buf, fileSize) == fileSize;
+		CustomArrayDelete(buf);
+		return result;
+	}
 	//build the start header
 	CombinedHeaders headers = CombinedHeaders();
 	if(!buildHeaders(model, &headers))
@@ -264,15 +487,16 @@ bool ModelMgr::WriteModelFile(const Model& model, DataStream* file)
 
 	//write the headers.
 	file->Write((char*)&headers.MainHeader, sizeof(ModelHeader));
+	file->Write((char*)&headers.LODHeaders[0], sizeof(LODHeader)*headers.LODHeaders.size());
 	file->Write((char*)headers.MeshHeaders, sizeof(MeshHeader)*headers.NumMeshHeaders);
 
 	//now write the data!
 	//headerNum = 0;
-	for(U32 i = 0; i < model.MeshCount(); ++i)//(Model::ConstMeshIt cit = model.GetMeshBegin(); cit != model.GetMeshEnd(); ++cit)
+	for(U32 i = 0; i < headers.NumMeshHeaders; ++i)//(Model::ConstMeshIt cit = model.GetMeshBegin(); cit != model.GetMeshEnd(); ++cit)
 	{
 		const MeshHeader& meshHdr = headers.MeshHeaders[i];
 
-		const Mesh* mesh = model.GetMesh(i);
+		const Mesh* mesh = headers.Units[i];
 		//write the GUIDs first
 		const Material& mat = mesh->GetMaterial();
 		if(meshHdr.DiffuseGUIDLen > 0)
@@ -333,6 +557,214 @@ bool ModelMgr::ReadModelFile(Model& model, DataStream* file)
 }
 */
 
+/**
+Checks that the LOD headers cover every unit in the file, in order.
+*/
+bool verifyLODHeaders(const LODHeader* lodHdrs, U16 numLODs, U16 numUnits, size_t hdrStart, size_t fileSize)
+{
+	if(hdrStart + numLODs * sizeof(LODHeader) > fileSize)
+	{
+		return false;
+	}
+	U32 nextUnit = 0;
+	for(U32 lod = 0; lod < numLODs; ++lod)
+	{
+		if(lodHdrs[lod].Signature != LODHeader::SIGNATURE || lodHdrs[lod].FirstUnit != nextUnit)
+		{
+			return false;
+		}
+		nextUnit += lodHdrs[lod].NumUnits;
+	}
+	return nextUnit == numUnits;
+}
+
+bool ModelMgr::IsInPlaceModel(const char* data, size_t size)
+{
+	if(!data || size < sizeof(ModelHeader))
+	{
+		return false;
+	}
+	const ModelHeader* mainHdr = (const ModelHeader*)data;
+	return mainHdr->Signature == ModelHeader::SIGNATURE && mainHdr->Version >= INPLACE_MODEL_VER;
+}
+
+//Version INPLACE_MODEL_VER mesh headers stop before the vertex format fields.
+U32 meshHeaderStride(U16 version)
+{
+	return version >= PACKED_MODEL_VER ? sizeof(InPlaceMeshHeader) : offsetof(InPlaceMeshHeader, VertFormat);
+}
+
+/**
+Copies a mesh header out of an in-place file,
+filling in the fields older versions don't have.
+*/
+void getMeshHeader(const char* data, U32 index, InPlaceMeshHeader& out)
+{
+	const ModelHeader* mainHdr = (const ModelHeader*)data;
+	U32 stride = meshHeaderStride(mainHdr->Version);
+	memcpy(&out, data + mainHdr->MeshHdrStart + index * stride, stride);
+	if(stride < sizeof(InPlaceMeshHeader))
+	{
+		out.VertFormat = FULL_VERTEX;
+		out.IndexSize = sizeof(U32);
+		for(U32 i = 0; i < 3; ++i)
+		{
+			out.PosOffset[i] = 0.0f;
+			out.PosScale[i] = 1.0f;
+		}
+	}
+}
+
+U32 vertexStride(U8 format)
+{
+	return format == FULL_VERTEX ? sizeof(Vertex) : sizeof(PackedVertex);
+}
+
+bool ModelMgr::VerifyInPlaceModel(const char* data, size_t size)
+{
+	if(!IsInPlaceModel(data, size))
+	{
+		LogE("Couldn't verify model header!");
+		return false;
+	}
+	const ModelHeader* mainHdr = (const ModelHeader*)data;
+	U64 fileSize = mainHdr->FileSize;
+	if(fileSize > size || mainHdr->NumUnits < 1 || mainHdr->NumLODs < 1)
+	{
+		LogE("Model has a malformed main header!");
+		return false;
+	}
+	const LODHeader* lodHdrs = (const LODHeader*)(data + mainHdr->LODHdrStart);
+	if(	!Filesystem::InFile(mainHdr->LODHdrStart, mainHdr->NumLODs, sizeof(LODHeader), fileSize) ||
+		!verifyLODHeaders(lodHdrs, mainHdr->NumLODs, mainHdr->NumUnits, mainHdr->LODHdrStart, (size_t)fileSize))
+	{
+		LogE("Model has malformed LOD headers!");
+		return false;
+	}
+	//the table's last string has to end in it, so every string in it does.
+	U32 stringsSize = mainHdr->StringTableSize;
+	if(	!Filesystem::InFile(mainHdr->StringTableStart, stringsSize, 1, fileSize) ||
+		(stringsSize > 0 && data[mainHdr->StringTableStart + stringsSize - 1] != 0))
+	{
+		LogE("Model has a malformed string table!");
+		return false;
+	}
+	if(!Filesystem::InFile(mainHdr->MeshHdrStart, mainHdr->NumUnits, meshHeaderStride(mainHdr->Version), fileSize))
+	{
+		LogE("Model has malformed mesh headers!");
+		return false;
+	}
+	for(U32 i = 0; i < mainHdr->NumUnits; ++i)
+	{
+		InPlaceMeshHeader meshHdr;
+		getMeshHeader(data, i, meshHdr);
+		bool stringsValid = true;
+		const U32 guids[4] = { meshHdr.DiffuseGUID, meshHdr.SpecularGUID, meshHdr.EmissiveGUID, meshHdr.NormalMapGUID };
+		for(U32 j = 0; j < 4; ++j)
+		{
+			stringsValid &= guids[j] == InPlaceMeshHeader::NO_STRING || guids[j] < stringsSize;
+		}
+		if(	meshHdr.Signature != InPlaceMeshHeader::SIGNATURE || !stringsValid ||
+			meshHdr.VertFormat >= VERTFMT_LEN || (meshHdr.IndexSize != sizeof(U16) && meshHdr.IndexSize != sizeof(U32)) ||
+			meshHdr.VertexDataStart % MODEL_DATA_ALIGN != 0 || meshHdr.IndexDataStart % MODEL_DATA_ALIGN != 0 ||
+			!Filesystem::InFile(meshHdr.VertexDataStart, meshHdr.NumVerts, vertexStride(meshHdr.VertFormat), fileSize) ||
+			!Filesystem::InFile(meshHdr.IndexDataStart, meshHdr.NumIndices, meshHdr.IndexSize, fileSize))
+		{
+			LogE(String("Mesh header ") + i + " is malformed!");
+			return false;
+		}
+	}
+	return true;
+}
+
+ResGUID guidFromTable(const char* strings, U32 offset)
+{
+	return offset == InPlaceMeshHeader::NO_STRING ? ResGUID() : ResGUID(strings + offset);
+}
+
+/**
+Reads an in-place file. If geomDataOut's NULL, the geometry's used where it is;
+otherwise it's copied there.
+*/
+bool readInPlaceModel(Model& model, const char* data, size_t size, char* geomDataOut, size_t outSize)
+{
+	if(!ModelMgr::VerifyInPlaceModel(data, size))
+	{
+		return false;
+	}
+	const ModelHeader* mainHdr = (const ModelHeader*)data;
+	logModelHeaderInfo(*mainHdr);
+	model.SetAABBBounds(Vector3(mainHdr->BoundsX, mainHdr->BoundsY, mainHdr->BoundsZ));
+	const LODHeader* lodHdrs = (const LODHeader*)(data + mainHdr->LODHdrStart);
+	for(U32 lod = 1; lod < mainHdr->NumLODs; ++lod)
+	{
+		model.AddLOD(lodHdrs[lod].GeometricError);
+	}
+
+	const char* strings = data + mainHdr->StringTableStart;
+	char* geomOutPtr = geomDataOut;
+	U32 currLOD = 0;
+	U32 totVert = 0;
+	for(U32 i = 0; i < mainHdr->NumUnits; ++i)
+	{
+		InPlaceMeshHeader meshHdr;
+		getMeshHeader(data, i, meshHdr);
+		Material mat = Material();
+		mat.DiffuseColor = meshHdr.DiffuseColor;
+		mat.SpecularColor = meshHdr.SpecularColor;
+		mat.EmissiveColor = meshHdr.EmissiveColor;
+		mat.DiffuseTexGUID = guidFromTable(strings, meshHdr.DiffuseGUID);
+		mat.SpecularTexGUID = guidFromTable(strings, meshHdr.SpecularGUID);
+		mat.EmissiveTexGUID = guidFromTable(strings, meshHdr.EmissiveGUID);
+		mat.NormalMapGUID = guidFromTable(strings, meshHdr.NormalMapGUID);
+
+		char* verts = (char*)data + meshHdr.VertexDataStart;
+		char* inds = (char*)data + meshHdr.IndexDataStart;
+		if(geomDataOut)
+		{
+			size_t vertSize = meshHdr.NumVerts * vertexStride(meshHdr.VertFormat);
+			size_t indSize = meshHdr.NumIndices * meshHdr.IndexSize;
+			if(vertSize + indSize > outSize - (size_t)(geomOutPtr - geomDataOut))
+			{
+				LogE("ReadModelMemory: Destination buffer is too small!");
+				return false;
+			}
+			memcpy(geomOutPtr, verts, vertSize);
+			memcpy(geomOutPtr + vertSize, inds, indSize);
+			verts = geomOutPtr;
+			inds = geomOutPtr + vertSize;
+			geomOutPtr += vertSize + indSize;
+		}
+		Geometry geom = Geometry();
+		if(meshHdr.VertFormat == FULL_VERTEX && meshHdr.IndexSize == sizeof(U32))
+		{
+			geom.Initialize(HandleMgr::RegisterPtr((Vertex*)verts).GetHandle(), HandleMgr::RegisterPtr((U32*)inds).GetHandle(),
+							meshHdr.NumVerts, meshHdr.NumIndices, meshHdr.NumTexChannels);
+		}
+		else
+		{
+			geom.InitializePacked(	HandleMgr::RegisterPtr((void*)verts), HandleMgr::RegisterPtr((void*)inds),
+									meshHdr.NumVerts, meshHdr.NumIndices, meshHdr.NumTexChannels, (VertexFormat)meshHdr.VertFormat, meshHdr.IndexSize,
+									Vector3(meshHdr.PosOffset[0], meshHdr.PosOffset[1], meshHdr.PosOffset[2]),
+									Vector3(meshHdr.PosScale[0], meshHdr.PosScale[1], meshHdr.PosScale[2]));
+		}
+		totVert += meshHdr.NumVerts;
+
+		while(currLOD + 1 < mainHdr->NumLODs && i >= lodHdrs[currLOD + 1].FirstUnit)
+		{
+			++currLOD;
+		}
+		model.AddLODMesh(currLOD, Mesh(mat, geom));
+	}
+	LogV(String("\tTotal Vertices:\t") + totVert);
+	return true;
+}
+
+bool ModelMgr::ReadModelInPlace(Model& model, const char* data, size_t size)
+{
+	return readInPlaceModel(model, data, size, NULL, 0);
+}
+
 bool ModelMgr::ReadModelMemory(Model& model, const char* data, size_t inSize, char* geomDataOut, size_t outSize)
 {
 	//Our assumption is that the WHOLE file is in a buffer.
@@ -357,12 +789,34 @@ bool ModelMgr::ReadModelMemory(Model& model, const char* data, size_t inSize, ch
 		LogE("Model is too old!");
 		return false;
 	}
+	if(mainHdr->Version >= INPLACE_MODEL_VER)
+	{
+		return readInPlaceModel(model, data, inSize, geomDataOut, outSize);
+	}
 	logModelHeaderInfo(*mainHdr);
 
 	//setup model properties
 	model.SetAABBBounds(Vector3(mainHdr->BoundsX, mainHdr->BoundsY, mainHdr->BoundsZ));
 
 	U16 numMeshes = mainHdr->NumUnits;
+	//Older files don't have LOD headers; all of their units are in LOD 0.
+	U16 numLODs = 1;
+	const LODHeader* lodHdrs = NULL;
+	if(mainHdr->Version >= LOD_MODEL_VER && mainHdr->NumLODs > 1)
+	{
+		numLODs = mainHdr->NumLODs;
+		lodHdrs = (const LODHeader*)(data + mainHdr->LODHdrStart);
+		if(!verifyLODHeaders(lodHdrs, numLODs, numMeshes, mainHdr->LODHdrStart, inSize))
+		{
+			LogE("Model has malformed LOD headers!");
+			return false;
+		}
+		for(U32 lod = 1; lod < numLODs; ++lod)
+		{
+			model.AddLOD(lodHdrs[lod].GeometricError);
+		}
+	}
+	U32 currLOD = 0;
 	//now move up to and iterate through the mesh headers.
 	dataPtr = (char*)(data + mainHdr->MeshHdrStart);
 	char* geomOutPtr = geomDataOut;
@@ -439,7 +893,12 @@ bool ModelMgr::ReadModelMemory(Model& model, const char* data, size_t inSize, ch
 			//both parts of the mesh should be ready now; attach it to the model
 			Mesh mesh = Mesh(mat, geom);
 
-			model.AddMesh(mesh);
+			//units are sorted by LOD, so we only ever need to move forward a level
+			while(currLOD + 1 < numLODs && i >= lodHdrs[currLOD + 1].FirstUnit)
+			{
+				++currLOD;
+			}
+			model.AddLODMesh(currLOD, mesh);
 
 			//and advance the output head
 			geomOutPtr += geomDataSize;
@@ -462,16 +921,25 @@ bool ModelMgr::ReadModelMemory(Model& model, const char* data, size_t inSize, ch
 	return true;
 }
 
-size_t ModelMgr::FindFileSize(const Model& model)
+size_t ModelMgr::FindFileSize(const Model& model, U16 version)
 {
+	if(version >= INPLACE_MODEL_VER)
+	{
+		InPlaceLayout layout;
+		return buildInPlaceLayout(model, &layout) ? layout.MainHeader.FileSize : 0;
+	}
 	size_t result = 0;
 	//files always contain a header
 	result += sizeof(ModelHeader);
-	//and (numMeshes) mesh headers
-	result += model.MeshCount() * sizeof(MeshHeader);
-	for(int i = 0; i < model.MeshCount(); ++i)
+	//one LOD header per detail level
+	result += model.LODCount() * sizeof(LODHeader);
+	//and (numMeshes) mesh headers, counting the meshes of every LOD
+	Vector<const Mesh*> units;
+	listUnits(model, units);
+	result += units.size() * sizeof(MeshHeader);
+	for(U32 i = 0; i < units.size(); ++i)
 	{
-		const Mesh* mesh = model.GetMesh(i);
+		const Mesh* mesh = units[i];
 		const Geometry& geom = mesh->GetGeometry();
 		const Material& mat = mesh->GetMaterial();
 
@@ -505,8 +973,19 @@ size_t ModelMgr::FindFileGeomSize(const char* fileBuf)
 	}
 
 	U16 numMeshes = mainHdr->NumUnits;
+	if(mainHdr->Version >= INPLACE_MODEL_VER)
+	{
+		size_t geomSize = 0;
+		for(U32 i = 0; i < numMeshes; ++i)
+		{
+			InPlaceMeshHeader meshHdr;
+			getMeshHeader(fileBuf, i, meshHdr);
+			geomSize += meshHdr.NumVerts * vertexStride(meshHdr.VertFormat) + meshHdr.NumIndices * meshHdr.IndexSize;
+		}
+		return geomSize;
+	}
 	//now move up to and iterate through the mesh headers.
-	MeshHeader* meshHdrStart = (MeshHeader*)((char*)fileBuf + sizeof(ModelHeader));
+	MeshHeader* meshHdrStart = (MeshHeader*)((char*)fileBuf + mainHdr->MeshHdrStart);
 	//char* geomOutPtr = geomDataOut;
 	size_t geomSize = 0;
 	for(U32 i = 0; i < numMeshes; ++i)
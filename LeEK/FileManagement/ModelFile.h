@@ -8,7 +8,16 @@
 namespace LeEK
 {
 	const U16 MIN_MODEL_VER = 200;
-	const U16 CURR_MODEL_VER = 200;
+	//First version with LOD headers.
+	const U16 LOD_MODEL_VER = 201;
+	//First version that can be used in place, straight from the file's buffer.
+	const U16 INPLACE_MODEL_VER = 300;
+	//First version whose meshes can use packed vertex formats and 16-bit indices.
+	const U16 PACKED_MODEL_VER = 301;
+	const U16 CURR_MODEL_VER = 301;
+	//In in-place files, vertex and index blocks start on multiples of this,
+	//counting from the start of the file.
+	const U32 MODEL_DATA_ALIGN = 16;
 
 	//File structs follow.
 	//Specify no packing so that this matches what's written to disk.
@@ -24,6 +33,29 @@ namespace LeEK
 		F32 BoundsY;
 		F32 BoundsZ;
 		F32 BoundingRadius;
+		//Only present in version LOD_MODEL_VER and up.
+		//Older files have one LOD holding every unit.
+		U16 NumLODs;
+		U32 LODHdrStart;
+		//Only present in version INPLACE_MODEL_VER and up.
+		//The string table holds every material GUID, each null terminated.
+		U32 StringTableStart;
+		U32 StringTableSize;
+		U32 FileSize;
+	};
+
+	/**
+	Describes one detail level of a model.
+	The units of each level are stored consecutively, starting with LOD 0,
+	so NumUnits in the model header counts the meshes of all levels.
+	*/
+	struct LODHeader
+	{
+		enum { SIGNATURE = 0x4C4B4D4C };
+		U32 Signature;
+		U16 FirstUnit;
+		U16 NumUnits;
+		F32 GeometricError;
 	};
 
 	struct MeshHeader
@@ -46,16 +78,72 @@ namespace LeEK
 		U32 NormalMapGUIDLen;
 		U32 NextMeshOffset;
 	};
+
+	/**
+	Mesh header for version INPLACE_MODEL_VER and up.
+	The mesh headers are in one array, and every offset counts from the start of the file,
+	so the file can be used wherever it's loaded or mapped without any fixups.
+	*/
+	struct InPlaceMeshHeader
+	{
+		enum { SIGNATURE = 0x4C4B4D49 };
+		enum { NO_STRING = 0xFFFFFFFF };
+		U32 Signature;
+		U32 NumVerts;
+		U32 NumIndices;
+		//both MODEL_DATA_ALIGN aligned.
+		U32 VertexDataStart;
+		U32 IndexDataStart;
+		U8 NumTexChannels;
+		U8 Pad[3];
+		Color DiffuseColor;
+		Color SpecularColor;
+		Color EmissiveColor;
+		//Offsets into the string table, or NO_STRING if the mesh doesn't use the map.
+		U32 DiffuseGUID;
+		U32 SpecularGUID;
+		U32 EmissiveGUID;
+		U32 NormalMapGUID;
+		//Only present in version PACKED_MODEL_VER and up;
+		//older meshes are always FULL_VERTEX with 32-bit indices.
+		//A VertexFormat.
+		U8 VertFormat;
+		//2 or 4.
+		U8 IndexSize;
+		U8 Pad2[2];
+		//Dequantization parameters for packed positions; see PackedVertex.
+		F32 PosOffset[3];
+		F32 PosScale[3];
+	};
 #pragma pack()
 
 	namespace ModelMgr
 	{
-		bool WriteModelMemory(const Model& model, char* buf, size_t bufSize);
-		bool WriteModelFile(const Model& model, DataStream* file);
+		//version can be LOD_MODEL_VER, to write files older builds can read.
+		bool WriteModelMemory(const Model& model, char* buf, size_t bufSize, U16 version = CURR_MODEL_VER);
+		bool WriteModelFile(const Model& model, DataStream* file, U16 version = CURR_MODEL_VER);
 		//bool ReadModelFile(Model& model, DataStream* file);
+		//Reads any version from MIN_MODEL_VER up, copying the geometry into geomDataOut.
 		bool ReadModelMemory(Model& model, const char* dataIn, size_t inSize, char* geomDataOut, size_t outSize);
+		/**
+		Returns true if the file can be read with ReadModelInPlace().
+		Only looks at the main header.
+		*/
+		bool IsInPlaceModel(const char* data, size_t size);
+		/**
+		Checks that every header, offset and string in an in-place file is in bounds.
+		Only reads the headers, so it takes the same time however much geometry the file has;
+		index values aren't checked.
+		*/
+		bool VerifyInPlaceModel(const char* data, size_t size);
+		/**
+		Reads an in-place file without copying anything;
+		the model's geometry points straight into data, which has to outlive the model.
+		data can be a view of a memory mapped archive.
+		*/
+		bool ReadModelInPlace(Model& model, const char* data, size_t size);
 		//Finds the total size of the model if written to disk.
-		size_t FindFileSize(const Model& model);
+		size_t FindFileSize(const Model& model, U16 version = CURR_MODEL_VER);
 		//Finds the total size of the geometry data in the file.
 		size_t FindFileGeomSize(const char* fileBuf);
 	}
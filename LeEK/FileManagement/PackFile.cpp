@@ -0,0 +1,658 @@
+#include "PackFile.h"
+#include "LZCompression.h"
+#include "Memory/Allocator.h"
+#include "Logging/Log.h"
+#include "Constants/AllocTypes.h"
+#include "Hashing/Hash.h"
+#include "Math/MathFunctions.h"
+
+using namespace LeEK;
+
+const char* const PackFile::EXTENSION = ".lpak";
+
+namespace
+{
+	inline bool isPowerOfTwo(U32 val)
+	{
+		return val != 0 && (val & (val - 1)) == 0;
+	}
+}
+
+PackFile::PackFile()
+{
+	file = NULL;
+	dirBuf = NULL;
+	header = NULL;
+	entries = NULL;
+	slots = NULL;
+	chunkEnds = NULL;
+	names = NULL;
+	chunkBuf = NULL;
+}
+
+PackFile::~PackFile()
+{
+	End();
+}
+
+bool PackFile::Init(const Path& archivePath, bool allowMapping)
+{
+	LogV(String("Opening pack ") + archivePath.ToString());
+	End();
+	if(!allowMapping || !mapping.Open(archivePath))
+	{
+		file = Filesystem::OpenFileReadOnly(archivePath);
+		if(!file)
+		{
+			LogE(String("Couldn't open pack ") + archivePath.ToString() + "!");
+			return false;
+		}
+	}
+	filePath = archivePath;
+	FileSz archiveSize = mapping.IsOpen() ? mapping.Size() : file->FileSize();
+
+	Header hdr;
+	memset(&hdr, 0, sizeof(Header));
+	if(archiveSize < sizeof(Header) || !readAt(0, &hdr, sizeof(Header)) || hdr.Signature != Header::SIGNATURE)
+	{
+		LogE(String(archivePath.GetBaseName()) + " isn't a pack!");
+		End();
+		return false;
+	}
+	if(hdr.Version != Header::VERSION)
+	{
+		LogE(String(archivePath.GetBaseName()) + " is pack version " + (U32)hdr.Version + ", expected " + (U32)Header::VERSION + "!");
+		End();
+		return false;
+	}
+	//check the directory's layout before trusting any of it.
+	//The table needs more slots than entries, so it always has empty slots;
+	//the slots themselves are checked once the directory's read.
+	if(	!isPowerOfTwo(hdr.NumSlots) || hdr.NumSlots <= hdr.NumEntries ||
+		hdr.ChunkSize == 0 || !isPowerOfTwo(hdr.Alignment) ||
+		hdr.DirSize > archiveSize - sizeof(Header) ||
+		hdr.SlotOffset < (U64)hdr.NumEntries * sizeof(Entry) ||
+		hdr.ChunkOffset < hdr.SlotOffset + (U64)hdr.NumSlots * sizeof(U32) ||
+		hdr.NameOffset < hdr.ChunkOffset + (U64)hdr.NumChunks * sizeof(U32) ||
+		hdr.NameOffset > hdr.DirSize)
+	{
+		LogE(String(archivePath.GetBaseName()) + " has a corrupt directory!");
+		End();
+		return false;
+	}
+
+	//A mapped directory's used where it is, so opening is just a matter of checking it.
+	const char* dir = NULL;
+	if(mapping.IsOpen())
+	{
+		header = (const Header*)mapping.Data();
+		dir = mapping.Data() + sizeof(Header);
+	}
+	else
+	{
+		dirBuf = CustomArrayNew<char>(sizeof(Header) + hdr.DirSize, RESFILE_ALLOC, "ResFileBufAlloc");
+		memcpy(dirBuf, &hdr, sizeof(Header));
+		if(!readAt(sizeof(Header), dirBuf + sizeof(Header), hdr.DirSize))
+		{
+			LogE(String("Couldn't read directory for ") + archivePath.GetBaseName() + "!");
+			End();
+			return false;
+		}
+		header = (const Header*)dirBuf;
+		dir = dirBuf + sizeof(Header);
+	}
+	entries = (const Entry*)dir;
+	slots = (const U32*)(dir + hdr.SlotOffset);
+	chunkEnds = (const U32*)(dir + hdr.ChunkOffset);
+	names = dir + hdr.NameOffset;
+	FileSz namesSize = hdr.DirSize - hdr.NameOffset;
+
+	//every entry has to be in the table exactly once.
+	//Since there's more slots than entries, that leaves the empty slots Find() stops at.
+	Vector<U8> entrySlotted;
+	entrySlotted.resize(hdr.NumEntries, 0);
+	U32 numSlotted = 0;
+	for(U32 i = 0; i < hdr.NumSlots; ++i)
+	{
+		if(slots[i] == 0)
+		{
+			continue;
+		}
+		if(slots[i] > hdr.NumEntries || entrySlotted[slots[i] - 1])
+		{
+			LogE(String(archivePath.GetBaseName()) + " has a corrupt hash table!");
+			End();
+			return false;
+		}
+		entrySlotted[slots[i] - 1] = 1;
+		++numSlotted;
+	}
+	if(numSlotted != hdr.NumEntries)
+	{
+		LogE(String(archivePath.GetBaseName()) + " has a corrupt hash table!");
+		End();
+		return false;
+	}
+	for(U32 i = 0; i < hdr.NumEntries; ++i)
+	{
+		const Entry& entry = entries[i];
+		bool valid =	(U64)entry.NameOffset + entry.NameLen < namesSize &&
+						names[entry.NameOffset + entry.NameLen] == 0 &&
+						entry.DataOffset <= archiveSize && entry.PackedSize <= archiveSize - entry.DataOffset &&
+						//GetMappedFile() promises aligned data.
+						(entry.DataOffset & (hdr.Alignment - 1)) == 0;
+		if(valid && entry.Compression == PACK_COMP_NONE)
+		{
+			valid = entry.PackedSize == entry.RawSize;
+		}
+		else if(valid && entry.Compression == PACK_COMP_LZ)
+		{
+			valid =	(U64)entry.FirstChunk + entry.NumChunks <= hdr.NumChunks &&
+					entry.NumChunks == (entry.RawSize + (U64)hdr.ChunkSize - 1) / hdr.ChunkSize;
+			//each chunk has to fit in the file's data, and can't be bigger
+			//than it is uncompressed (those are stored instead).
+			FileSz chunkStart = 0;
+			for(U32 j = 0; valid && j < entry.NumChunks; ++j)
+			{
+				FileSz chunkEnd = chunkEnds[entry.FirstChunk + j];
+				FileSz rawSize = Math::Min(hdr.ChunkSize, entry.RawSize - j * hdr.ChunkSize);
+				valid = chunkEnd > chunkStart && chunkEnd - chunkStart <= rawSize && chunkEnd <= entry.PackedSize;
+				chunkStart = chunkEnd;
+			}
+		}
+		else
+		{
+			valid = false;
+		}
+		if(!valid)
+		{
+			LogE(String(archivePath.GetBaseName()) + ": File " + i + " appears to be corrupt!");
+			End();
+			return false;
+		}
+	}
+
+	chunkBuf = CustomArrayNew<char>(2 * hdr.ChunkSize, RESFILE_ALLOC, "ResFileBufAlloc");
+	LogV(String("Opened pack ") + archivePath.GetBaseName() + ", " + hdr.NumEntries + " files");
+	return true;
+}
+
+void PackFile::End()
+{
+	CustomArrayDelete(dirBuf);
+	dirBuf = NULL;
+	CustomArrayDelete(chunkBuf);
+	chunkBuf = NULL;
+	header = NULL;
+	entries = NULL;
+	slots = NULL;
+	chunkEnds = NULL;
+	names = NULL;
+	Filesystem::CloseFile(file);
+	file = NULL;
+	mapping.Close();
+	filePath = Path();
+}
+
+bool PackFile::readAt(FileSz offset, void* dest, FileSz size)
+{
+	if(mapping.IsOpen())
+	{
+		if(offset > mapping.Size() || size > mapping.Size() - offset)
+		{
+			return false;
+		}
+		memcpy(dest, mapping.Data() + offset, size);
+		return true;
+	}
+	file->Seek(offset);
+	return file->Read((char*)dest, size) == size;
+}
+
+void PackFile::getChunkBounds(const Entry& entry, U32 chunk, FileSz& start, FileSz& packedSize, FileSz& rawSize) const
+{
+	start = chunk > 0 ? chunkEnds[entry.FirstChunk + chunk - 1] : 0;
+	packedSize = chunkEnds[entry.FirstChunk + chunk] - start;
+	rawSize = Math::Min(header->ChunkSize, entry.RawSize - chunk * header->ChunkSize);
+}
+
+bool PackFile::unpackChunk(const char* packedChunk, FileSz packedSize, char* dest, FileSz rawSize) const
+{
+	//chunks that didn't compress are stored.
+	if(packedSize == rawSize)
+	{
+		memcpy(dest, packedChunk, rawSize);
+		return true;
+	}
+	return LZ::Decompress(packedChunk, packedSize, dest, rawSize);
+}
+
+char* PackFile::GetMappedFile(I32 fileIndex) const
+{
+	if(!mapping.IsOpen() || fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return NULL;
+	}
+	//Init() already checked the data's in bounds.
+	return mapping.Data() + entries[fileIndex].DataOffset;
+}
+
+I32 PackFile::GetNumFiles() const
+{
+	return header ? (I32)header->NumEntries : 0;
+}
+
+String PackFile::GetFilename(I32 fileIndex) const
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return String("");
+	}
+	return String(names + entries[fileIndex].NameOffset);
+}
+
+FileSz PackFile::GetFileLen(I32 fileIndex) const
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return 0;
+	}
+	return entries[fileIndex].RawSize;
+}
+
+FileSz PackFile::GetPackedLen(I32 fileIndex) const
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return 0;
+	}
+	return entries[fileIndex].PackedSize;
+}
+
+U16 PackFile::GetCompression(I32 fileIndex) const
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return PACK_COMP_NONE;
+	}
+	return entries[fileIndex].Compression;
+}
+
+U32 PackFile::GetChunkSize() const
+{
+	return header ? header->ChunkSize : 0;
+}
+
+U32 PackFile::GetAlignment() const
+{
+	return header ? header->Alignment : 0;
+}
+
+I32 PackFile::Find(const char* filePath) const
+{
+	if(!header || !filePath)
+	{
+		return -1;
+	}
+	U32 len = strlen(filePath);
+	U32 hash = HashPathNoCase(filePath, len);
+	U32 mask = header->NumSlots - 1;
+	//linear probing; there's always an empty slot to stop at.
+	for(U32 i = hash & mask; slots[i] != 0; i = (i + 1) & mask)
+	{
+		const Entry& entry = entries[slots[i] - 1];
+		if(entry.NameHash == hash && entry.NameLen == len && PathsEqualNoCase(names + entry.NameOffset, filePath, len))
+		{
+			return slots[i] - 1;
+		}
+	}
+	return -1;
+}
+
+bool PackFile::ReadPackedFile(I32 fileIndex, void* packedBuf)
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return false;
+	}
+	const Entry& entry = entries[fileIndex];
+	return readAt(entry.DataOffset, packedBuf, entry.PackedSize);
+}
+
+FileSz PackFile::GetDataOffset(I32 fileIndex) const
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return 0;
+	}
+	return entries[fileIndex].DataOffset;
+}
+
+bool PackFile::UnpackFile(I32 fileIndex, const char* packedBuf, FileSz packedSize, void* fileBuf) const
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return false;
+	}
+	const Entry& entry = entries[fileIndex];
+	if(packedSize < entry.PackedSize)
+	{
+		return false;
+	}
+	if(entry.Compression == PACK_COMP_NONE)
+	{
+		memcpy(fileBuf, packedBuf, entry.RawSize);
+		return true;
+	}
+	char* dest = (char*)fileBuf;
+	for(U32 i = 0; i < entry.NumChunks; ++i)
+	{
+		FileSz start, chunkPackedSize, chunkRawSize;
+		getChunkBounds(entry, i, start, chunkPackedSize, chunkRawSize);
+		if(!unpackChunk(packedBuf + start, chunkPackedSize, dest + i * header->ChunkSize, chunkRawSize))
+		{
+			LogW(String("Chunk ") + i + " of " + GetFilename(fileIndex) + " appears to be corrupt!");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool PackFile::ReadFile(I32 fileIndex, void* fileBuf)
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return false;
+	}
+	const Entry& entry = entries[fileIndex];
+	if(entry.Compression == PACK_COMP_NONE)
+	{
+		return readAt(entry.DataOffset, fileBuf, entry.RawSize);
+	}
+	//mapped data can be decompressed in place;
+	//otherwise go a chunk at a time, so there's no temporary buffer for the whole file.
+	if(mapping.IsOpen())
+	{
+		return UnpackFile(fileIndex, GetMappedFile(fileIndex), entry.PackedSize, fileBuf);
+	}
+	return ReadRange(fileIndex, 0, entry.RawSize, fileBuf) == entry.RawSize;
+}
+
+FileSz PackFile::ReadRange(I32 fileIndex, FileSz offset, FileSz size, void* dest)
+{
+	if(fileIndex < 0 || fileIndex >= GetNumFiles())
+	{
+		return 0;
+	}
+	const Entry& entry = entries[fileIndex];
+	if(offset >= entry.RawSize || size == 0)
+	{
+		return 0;
+	}
+	size = Math::Min(size, entry.RawSize - offset);
+	if(entry.Compression == PACK_COMP_NONE)
+	{
+		return readAt(entry.DataOffset + offset, dest, size) ? size : 0;
+	}
+
+	U32 chunkSize = header->ChunkSize;
+	char* packedChunk = chunkBuf;
+	char* rawChunk = chunkBuf + chunkSize;
+	char* out = (char*)dest;
+	FileSz remaining = size;
+	FileSz offsetInChunk = offset % chunkSize;
+	for(U32 i = offset / chunkSize; remaining > 0; ++i)
+	{
+		FileSz start, packedSize, rawSize;
+		getChunkBounds(entry, i, start, packedSize, rawSize);
+		const char* chunkData = packedChunk;
+		if(mapping.IsOpen())
+		{
+			chunkData = mapping.Data() + entry.DataOffset + start;
+		}
+		else if(!readAt(entry.DataOffset + start, packedChunk, packedSize))
+		{
+			return size - remaining;
+		}
+		//whole chunks can go straight to the destination.
+		FileSz copySize = Math::Min(rawSize - offsetInChunk, remaining);
+		bool wholeChunk = offsetInChunk == 0 && copySize == rawSize;
+		if(!unpackChunk(chunkData, packedSize, wholeChunk ? out : rawChunk, rawSize))
+		{
+			LogW(String("Chunk ") + i + " of " + GetFilename(fileIndex) + " appears to be corrupt!");
+			return size - remaining;
+		}
+		if(!wholeChunk)
+		{
+			memcpy(out, rawChunk + offsetInChunk, copySize);
+		}
+		out += copySize;
+		remaining -= copySize;
+		offsetInChunk = 0;
+	}
+	return size;
+}
+
+PackWriter::PackWriter(U32 alignmentParam, U32 chunkSizeParam)
+{
+	alignment = isPowerOfTwo(alignmentParam) ? alignmentParam : DEFAULT_ALIGNMENT;
+	chunkSize = chunkSizeParam > 0 ? chunkSizeParam : DEFAULT_CHUNK_SIZE;
+}
+
+PackWriter::~PackWriter()
+{
+	Clear();
+}
+
+void PackWriter::Clear()
+{
+	for(U32 i = 0; i < files.size(); ++i)
+	{
+		CustomArrayDelete(files[i].Data);
+	}
+	files.clear();
+}
+
+bool PackWriter::AddFile(const String& name, const char* data, FileSz size, bool allowCompression)
+{
+	if(name.empty() || name.length() > 0xFFFF)
+	{
+		LogW(String("Can't add file \"") + name + "\" to pack!");
+		return false;
+	}
+	PendingFile pending;
+	pending.Name = name;
+	for(U32 i = 0; i < pending.Name.length(); ++i)
+	{
+		if(pending.Name[i] == '\\')
+		{
+			pending.Name[i] = '/';
+		}
+	}
+	pending.RawSize = size;
+	pending.Compression = PACK_COMP_NONE;
+	pending.Data = NULL;
+	pending.DataSize = size;
+
+	if(allowCompression && size > 0)
+	{
+		//Chunks that don't shrink are stored, so the packed file's never bigger than the original.
+		U32 numChunks = (size + chunkSize - 1) / chunkSize;
+		char* packed = CustomArrayNew<char>(size, RESFILE_ALLOC, "TempBufAlloc");
+		char* chunkOut = CustomArrayNew<char>(LZ::MaxCompressedSize(chunkSize), RESFILE_ALLOC, "TempBufAlloc");
+		FileSz packedSize = 0;
+		for(U32 i = 0; i < numChunks; ++i)
+		{
+			FileSz rawSize = Math::Min(chunkSize, size - i * chunkSize);
+			const char* rawChunk = data + i * chunkSize;
+			U32 compSize = LZ::Compress(rawChunk, rawSize, chunkOut, LZ::MaxCompressedSize(chunkSize));
+			if(compSize > 0 && compSize < rawSize)
+			{
+				memcpy(packed + packedSize, chunkOut, compSize);
+				packedSize += compSize;
+			}
+			else
+			{
+				memcpy(packed + packedSize, rawChunk, rawSize);
+				packedSize += rawSize;
+			}
+			pending.ChunkEnds.push_back(packedSize);
+		}
+		CustomArrayDelete(chunkOut);
+		//If it barely compresses, it's better off stored;
+		//then it can be used straight from a mapping.
+		if(packedSize < size - size / 16)
+		{
+			pending.Compression = PACK_COMP_LZ;
+			pending.Data = packed;
+			pending.DataSize = packedSize;
+		}
+		else
+		{
+			CustomArrayDelete(packed);
+			pending.ChunkEnds.clear();
+		}
+	}
+	if(pending.Compression == PACK_COMP_NONE)
+	{
+		pending.Data = CustomArrayNew<char>(Math::Max(size, (FileSz)1), RESFILE_ALLOC, "TempBufAlloc");
+		memcpy(pending.Data, data, size);
+	}
+	files.push_back(pending);
+	return true;
+}
+
+bool PackWriter::Write(const Path& outPath)
+{
+	typedef PackFile::Header Header;
+	typedef PackFile::Entry Entry;
+
+	U32 numEntries = files.size();
+	U32 numSlots = 2;
+	while(numSlots < 2 * numEntries)
+	{
+		numSlots *= 2;
+	}
+	U32 numChunks = 0;
+	U64 namesSize = 0;
+	for(U32 i = 0; i < numEntries; ++i)
+	{
+		numChunks += files[i].ChunkEnds.size();
+		namesSize += files[i].Name.length() + 1;
+	}
+
+	Header hdr;
+	memset(&hdr, 0, sizeof(Header));
+	hdr.Signature = Header::SIGNATURE;
+	hdr.Version = Header::VERSION;
+	hdr.NumEntries = numEntries;
+	hdr.NumSlots = numSlots;
+	hdr.NumChunks = numChunks;
+	hdr.ChunkSize = chunkSize;
+	hdr.Alignment = alignment;
+	hdr.SlotOffset = numEntries * sizeof(Entry);
+	hdr.ChunkOffset = hdr.SlotOffset + numSlots * sizeof(U32);
+	hdr.NameOffset = hdr.ChunkOffset + numChunks * sizeof(U32);
+	U64 dirSize = hdr.NameOffset + namesSize;
+
+	//lay out the file data after the directory, each file aligned.
+	Vector<U64> dataOffsets;
+	dataOffsets.resize(numEntries);
+	U64 archiveSize = Math::RoundUp<U64>(sizeof(Header) + dirSize, alignment);
+	for(U32 i = 0; i < numEntries; ++i)
+	{
+		dataOffsets[i] = archiveSize;
+		archiveSize = Math::RoundUp<U64>(archiveSize + files[i].DataSize, alignment);
+	}
+	if(archiveSize > 0xFFFFFFFF)
+	{
+		LogE(String("Pack ") + outPath.ToString() + " would be over 4 GB!");
+		return false;
+	}
+	hdr.DirSize = (U32)dirSize;
+
+	//build the directory in memory so it's a single write.
+	char* dir = CustomArrayNew<char>(hdr.DirSize, RESFILE_ALLOC, "TempBufAlloc");
+	memset(dir, 0, hdr.DirSize);
+	Entry* entries = (Entry*)dir;
+	U32* slots = (U32*)(dir + hdr.SlotOffset);
+	U32* chunkEnds = (U32*)(dir + hdr.ChunkOffset);
+	char* names = dir + hdr.NameOffset;
+	U32 nextChunk = 0;
+	U32 nextName = 0;
+	for(U32 i = 0; i < numEntries; ++i)
+	{
+		const PendingFile& pending = files[i];
+		Entry& entry = entries[i];
+		entry.DataOffset = (U32)dataOffsets[i];
+		entry.RawSize = pending.RawSize;
+		entry.PackedSize = pending.DataSize;
+		entry.NameLen = (U16)pending.Name.length();
+		entry.NameHash = HashPathNoCase(pending.Name.c_str(), entry.NameLen);
+		entry.NameOffset = nextName;
+		entry.Compression = pending.Compression;
+		entry.FirstChunk = nextChunk;
+		entry.NumChunks = pending.ChunkEnds.size();
+		memcpy(names + nextName, pending.Name.c_str(), entry.NameLen + 1);
+		nextName += entry.NameLen + 1;
+		for(U32 j = 0; j < entry.NumChunks; ++j)
+		{
+			chunkEnds[nextChunk++] = pending.ChunkEnds[j];
+		}
+
+		//insert into the hash table, checking for duplicates as we go.
+		U32 slot = entry.NameHash & (numSlots - 1);
+		for(; slots[slot] != 0; slot = (slot + 1) & (numSlots - 1))
+		{
+			const Entry& other = entries[slots[slot] - 1];
+			if(	other.NameHash == entry.NameHash && other.NameLen == entry.NameLen &&
+				PathsEqualNoCase(names + other.NameOffset, names + entry.NameOffset, entry.NameLen))
+			{
+				LogE(String("Pack has two files named ") + pending.Name + "!");
+				CustomArrayDelete(dir);
+				return false;
+			}
+		}
+		slots[slot] = i + 1;
+	}
+
+	if(Filesystem::Exists(outPath))
+	{
+		Filesystem::RemoveFile(outPath);
+	}
+	DataStream* out = Filesystem::OpenFile(outPath);
+	if(!out)
+	{
+		LogE(String("Couldn't create pack ") + outPath.ToString() + "!");
+		CustomArrayDelete(dir);
+		return false;
+	}
+	char* padding = CustomArrayNew<char>(alignment, RESFILE_ALLOC, "TempBufAlloc");
+	memset(padding, 0, alignment);
+	bool written =	out->Write((const char*)&hdr, sizeof(Header)) == sizeof(Header) &&
+					out->Write(dir, hdr.DirSize) == hdr.DirSize;
+	U64 pos = sizeof(Header) + hdr.DirSize;
+	for(U32 i = 0; written && i < numEntries; ++i)
+	{
+		FileSz padSize = (FileSz)(dataOffsets[i] - pos);
+		written =	out->Write(padding, padSize) == padSize &&
+					out->Write(files[i].Data, files[i].DataSize) == files[i].DataSize;
+		pos = dataOffsets[i] + files[i].DataSize;
+	}
+	//pad the end too, so the last file can be read in whole pages.
+	FileSz endPadSize = (FileSz)(archiveSize - pos);
+	written = written && out->Write(padding, endPadSize) == endPadSize;
+	//closing flushes the last of the data, so it can fail too.
+	written = Filesystem::CloseFile(out) && written;
+	CustomArrayDelete(padding);
+	CustomArrayDelete(dir);
+	if(!written)
+	{
+		//don't leave a truncated pack behind.
+		LogE(String("Couldn't write pack ") + outPath.ToString() + "!");
+		Filesystem::RemoveFile(outPath);
+		return false;
+	}
+	LogV(String("Wrote pack ") + outPath.ToString() + ": " + numEntries + " files, " + (U32)archiveSize + " bytes");
+	return true;
+}
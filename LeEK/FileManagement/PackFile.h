@@ -0,0 +1,221 @@
+#pragma once
+#include "Datatypes.h"
+#include "FileManagement/Filesystem.h"
+#include "FileManagement/DataStream.h"
+#include "FileManagement/MappedFile.h"
+#include "DataStructures/STLContainers.h"
+
+namespace LeEK
+{
+	enum PackCompressionType
+	{
+		PACK_COMP_NONE = 0,
+		//split into chunks, each compressed with the LZ codec.
+		PACK_COMP_LZ = 1
+	};
+
+	/**
+	The engine's own archive format (.lpak).
+	Compared to ZIP:
+		* the directory's one block with a hash table in it,
+		so opening an archive is a single read and lookups don't build any strings.
+		* compressed files are split into fixed size chunks, each compressed on its own
+		with the LZ codec, so any part of a file can be read without decompressing the rest.
+		* file data's aligned (to a page, by default),
+		so stored files in a mapped archive can be handed straight to the GPU or used in place.
+	Layout is the header, the directory, then the file data.
+	Build archives with PackWriter.
+	*/
+	class PackFile
+	{
+	public:
+		static const char* const EXTENSION;
+	private:
+		//the writer shares the on-disk structures.
+		friend class PackWriter;
+		struct Header;
+		struct Entry;
+		Path filePath;
+		//only open if the archive couldn't be mapped.
+		DataStream* file;
+		MappedFile mapping;
+		//holds the whole directory; the pointers below point into it.
+		char* dirBuf;
+		const Header* header;
+		const Entry* entries;
+		//open addressed; each slot is an entry index + 1, or 0 if empty.
+		const U32* slots;
+		//for each chunk of each compressed file,
+		//the offset of the chunk's end from the file's data.
+		const U32* chunkEnds;
+		const char* names;
+		//scratch space for chunked reads from an unmapped archive;
+		//holds a chunk as it's stored, then the decompressed chunk.
+		char* chunkBuf;
+
+		//Copies part of the archive, from the mapping or the file.
+		bool readAt(FileSz offset, void* dest, FileSz size);
+		//Finds where a chunk's stored, relative to the file's data.
+		void getChunkBounds(const Entry& entry, U32 chunk, FileSz& start, FileSz& packedSize, FileSz& rawSize) const;
+		bool unpackChunk(const char* packedChunk, FileSz packedSize, char* dest, FileSz rawSize) const;
+
+		PackFile(const PackFile& other);
+		PackFile& operator=(const PackFile& other);
+	public:
+		PackFile();
+		~PackFile();
+
+		/**
+		Opens the archive and reads its directory.
+		@param allowMapping if true, the archive's memory mapped where the platform supports it.
+		*/
+		bool Init(const Path& archivePath, bool allowMapping = true);
+		void End();
+
+		inline bool IsMapped() const { return mapping.IsOpen(); }
+		/**
+		Gets the file's data as it's stored, inside the archive's mapping.
+		Stays valid until the archive's closed, and is aligned
+		to the archive's alignment.
+		@return NULL if the archive isn't mapped.
+		*/
+		char* GetMappedFile(I32 fileIndex) const;
+
+		I32 GetNumFiles() const;
+		String GetFilename(I32 fileIndex) const;
+		FileSz GetFileLen(I32 fileIndex) const;
+		/**
+		Gets the size of the file as it's stored in the archive.
+		*/
+		FileSz GetPackedLen(I32 fileIndex) const;
+		/**
+		Gets the compression used on the file; match against PACK_COMP_* enums.
+		*/
+		U16 GetCompression(I32 fileIndex) const;
+		U32 GetChunkSize() const;
+		U32 GetAlignment() const;
+		/**
+		Gets the index of the file with the given path, ignoring case.
+		@return -1 if the file isn't in the archive.
+		*/
+		I32 Find(const char* filePath) const;
+		inline I32 Find(const String& filePath) const { return Find(filePath.c_str()); }
+
+		bool ReadFile(I32 fileIndex, void* fileBuf);
+		/**
+		Reads the file's data as it's stored, without decompressing it.
+		The buffer must be at least GetPackedLen() bytes.
+		*/
+		bool ReadPackedFile(I32 fileIndex, void* packedBuf);
+		/**
+		Gets where the file's data starts in the archive,
+		so it can be read through another handle to the archive.
+		*/
+		FileSz GetDataOffset(I32 fileIndex) const;
+		/**
+		Decompresses data read with ReadPackedFile() or GetMappedFile().
+		Only uses the directory, so it's safe to call while another thread reads the archive.
+		@param fileBuf must be GetFileLen() bytes.
+		*/
+		bool UnpackFile(I32 fileIndex, const char* packedBuf, FileSz packedSize, void* fileBuf) const;
+		/**
+		Reads part of a file. For compressed files,
+		only the chunks overlapping the range are read and decompressed.
+		@return the number of bytes read; less than size if the range passes the file's end.
+		*/
+		FileSz ReadRange(I32 fileIndex, FileSz offset, FileSz size, void* dest);
+	};
+
+	/**
+	Builds a PackFile archive.
+	Files are compressed as they're added and kept in memory until Write().
+	*/
+	class PackWriter
+	{
+	public:
+		static const U32 DEFAULT_CHUNK_SIZE = 64 * 1024;
+		//a page, so file data can be mapped or DMA'd in place.
+		static const U32 DEFAULT_ALIGNMENT = 4096;
+	private:
+		struct PendingFile
+		{
+			String Name;
+			FileSz RawSize;
+			U16 Compression;
+			Vector<U32> ChunkEnds;
+			char* Data;
+			FileSz DataSize;
+		};
+		Vector<PendingFile> files;
+		U32 chunkSize;
+		U32 alignment;
+
+		PackWriter(const PackWriter& other);
+		PackWriter& operator=(const PackWriter& other);
+	public:
+		/**
+		@param alignmentParam the alignment of each file's data;
+		must be a power of two.
+		*/
+		PackWriter(U32 alignmentParam = DEFAULT_ALIGNMENT, U32 chunkSizeParam = DEFAULT_CHUNK_SIZE);
+		~PackWriter();
+
+		/**
+		Adds a file to the archive.
+		Files that don't compress well enough to be worth decompressing are stored as-is.
+		Names are matched without regard to case, and two files with the same name
+		make Write() fail.
+		@param allowCompression if false, the file's always stored.
+		*/
+		bool AddFile(const String& name, const char* data, FileSz size, bool allowCompression = true);
+		U32 GetNumFiles() const { return files.size(); }
+		/**
+		Writes the archive, replacing any existing file.
+		*/
+		bool Write(const Path& outPath);
+		void Clear();
+	};
+
+#pragma pack(1)
+	struct PackFile::Header
+	{
+		enum
+		{
+			//"LPAK"
+			SIGNATURE = 0x4B41504C,
+			VERSION = 1
+		};
+		U32 Signature;
+		U16 Version;
+		U16 Reserved;
+		U32 NumEntries;
+		//always a power of two.
+		U32 NumSlots;
+		U32 NumChunks;
+		U32 ChunkSize;
+		U32 Alignment;
+		//the directory immediately follows the header.
+		//Offsets are from the directory's start.
+		U32 DirSize;
+		U32 SlotOffset;
+		U32 ChunkOffset;
+		U32 NameOffset;
+	};
+	struct PackFile::Entry
+	{
+		//from the start of the archive.
+		U32 DataOffset;
+		U32 RawSize;
+		U32 PackedSize;
+		//HashPathNoCase() of the name.
+		U32 NameHash;
+		//names are null terminated, but the length saves a strlen() on lookups.
+		U32 NameOffset;
+		U16 NameLen;
+		U16 Compression;
+		//index of the entry's first chunk in the chunk table.
+		U32 FirstChunk;
+		U32 NumChunks;
+	};
+#pragma pack()
+}
@@ -0,0 +1,213 @@
+#include "ReadAheadStream.h"
+#include "FileManagement/Filesystem.h"
+#include "Memory/Allocator.h"
+#include "Constants/AllocTypes.h"
+#include "Math/MathFunctions.h"
+#include "Logging/Log.h"
+
+using namespace LeEK;
+
+void ReadAheadStream::IOClient::Run()
+{
+	owner->runIO();
+}
+
+ReadAheadStream::ReadAheadStream(	DataStream* fileParam, FileSz start, FileSz size, bool ownsFileParam,
+									U32 chunkSizeParam, U32 chunkCountParam) : ioClient(this)
+{
+	file = fileParam;
+	ownsFile = ownsFileParam;
+	streamStart = start;
+	streamSz = size;
+	chunkSize = Math::Max(chunkSizeParam, (U32)1);
+	//one chunk being read from and one being filled, at least.
+	U32 chunkCount = Math::Max(chunkCountParam, (U32)2);
+	chunkData = CustomArrayNew<char>(chunkSize * chunkCount, RESFILE_ALLOC, "ReadAheadAlloc");
+	for(U32 i = 0; i < chunkCount; ++i)
+	{
+		Chunk chunk;
+		chunk.Data = chunkData + i * chunkSize;
+		chunk.Size = 0;
+		chunks.push_back(chunk);
+	}
+	readChunk = 0;
+	numFilled = 0;
+	chunkPos = 0;
+	readPos = 0;
+	fillPos = 0;
+	generation = 0;
+	failed = false;
+	stopping = false;
+	numStalls = 0;
+
+	ioThread = LNew(Thread, THREAD_ALLOC, "ThreadAlloc")(&ioClient);
+	ioThread->Start();
+}
+
+ReadAheadStream::~ReadAheadStream()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex.GetMutex());
+		stopping = true;
+	}
+	chunkFreed.notify_all();
+	ioThread->Join();
+	LDelete(ioThread);
+	CustomArrayDelete(chunkData);
+	if(ownsFile)
+	{
+		Filesystem::CloseFile(file);
+	}
+}
+
+void ReadAheadStream::runIO()
+{
+	std::unique_lock<std::mutex> lock(mutex.GetMutex());
+	while(true)
+	{
+		while(!stopping && (numFilled == chunks.size() || fillPos >= streamSz || failed))
+		{
+			chunkFreed.wait(lock);
+		}
+		if(stopping)
+		{
+			return;
+		}
+		//The target chunk's past all the filled ones,
+		//so the consumer won't touch it until it's marked filled.
+		Chunk& chunk = chunks[(readChunk + numFilled) % chunks.size()];
+		U32 readGen = generation;
+		FileSz pos = fillPos;
+		FileSz size = Math::Min((FileSz)chunkSize, streamSz - pos);
+
+		lock.unlock();
+		file->Seek(streamStart + pos);
+		FileSz bytesRead = file->Read(chunk.Data, size);
+		lock.lock();
+
+		//the consumer's moved somewhere else; this data's useless now.
+		if(readGen != generation)
+		{
+			continue;
+		}
+		if(bytesRead < size)
+		{
+			LogW(String("Read ahead came up short at ") + (streamStart + pos + bytesRead) + "!");
+			failed = true;
+		}
+		chunk.Size = bytesRead;
+		fillPos = pos + bytesRead;
+		if(bytesRead > 0)
+		{
+			++numFilled;
+		}
+		chunkFilled.notify_one();
+	}
+}
+
+FileSz ReadAheadStream::read(char* dest, FileSz size, bool block)
+{
+	std::unique_lock<std::mutex> lock(mutex.GetMutex());
+	FileSz totalRead = 0;
+	while(totalRead < size && readPos < streamSz)
+	{
+		if(numFilled == 0)
+		{
+			if(!block || failed)
+			{
+				break;
+			}
+			++numStalls;
+			while(numFilled == 0 && !failed)
+			{
+				chunkFilled.wait(lock);
+			}
+			continue;
+		}
+		//The I/O thread never writes a filled chunk,
+		//so the copy doesn't need the lock.
+		Chunk& chunk = chunks[readChunk];
+		FileSz copySz = Math::Min(chunk.Size - chunkPos, size - totalRead);
+		const char* src = chunk.Data + chunkPos;
+		lock.unlock();
+		memcpy(dest + totalRead, src, copySz);
+		lock.lock();
+		totalRead += copySz;
+		chunkPos += copySz;
+		readPos += copySz;
+		if(chunkPos == chunk.Size)
+		{
+			//hand the chunk back to the I/O thread.
+			readChunk = (readChunk + 1) % chunks.size();
+			--numFilled;
+			chunkPos = 0;
+			chunkFreed.notify_one();
+		}
+	}
+	return totalRead;
+}
+
+FileSz ReadAheadStream::Read(char* dest, FileSz size)
+{
+	return read(dest, size, true);
+}
+
+FileSz ReadAheadStream::TryRead(char* dest, FileSz size)
+{
+	return read(dest, size, false);
+}
+
+FileSz ReadAheadStream::Seek(FileSz relPos)
+{
+	relPos = Math::Min(relPos, streamSz);
+	{
+		std::lock_guard<std::mutex> lock(mutex.GetMutex());
+		//Skipping forward into data that's already been read
+		//just drops what's skipped over.
+		while(numFilled > 0 && relPos >= readPos)
+		{
+			FileSz chunkLeft = chunks[readChunk].Size - chunkPos;
+			if(relPos - readPos < chunkLeft)
+			{
+				chunkPos += relPos - readPos;
+				readPos = relPos;
+				break;
+			}
+			readPos += chunkLeft;
+			readChunk = (readChunk + 1) % chunks.size();
+			--numFilled;
+			chunkPos = 0;
+		}
+		if(readPos != relPos)
+		{
+			//otherwise start over from the new position.
+			++generation;
+			readChunk = 0;
+			numFilled = 0;
+			chunkPos = 0;
+			readPos = relPos;
+			fillPos = relPos;
+			failed = false;
+		}
+	}
+	chunkFreed.notify_one();
+	return relPos;
+}
+
+FileSz ReadAheadStream::Tell()
+{
+	std::lock_guard<std::mutex> lock(mutex.GetMutex());
+	return readPos;
+}
+
+FileSz ReadAheadStream::Available()
+{
+	std::lock_guard<std::mutex> lock(mutex.GetMutex());
+	return fillPos - readPos;
+}
+
+U32 ReadAheadStream::NumStalls()
+{
+	std::lock_guard<std::mutex> lock(mutex.GetMutex());
+	return numStalls;
+}
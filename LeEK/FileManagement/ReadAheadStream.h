@@ -0,0 +1,113 @@
+#pragma once
+#include "Datatypes.h"
+#include "FileManagement/DataStream.h"
+#include "DataStructures/STLContainers.h"
+#include "MultiThreading/StdThreading.h"
+#include <condition_variable>
+
+namespace LeEK
+{
+	/**
+	Reads part of a DataStream ahead of its consumer, on a background I/O thread.
+	Data's read into a ring of chunks; while the consumer copies out of one chunk,
+	the thread fills the others, so the consumer only waits on the disk
+	when it's caught up with everything that's been read.
+	The consumer side isn't thread safe; only one thread should call Read() and Seek().
+	*/
+	class ReadAheadStream
+	{
+	public:
+		static const U32 DEFAULT_CHUNK_SIZE = ASYNC_CHUNK_SZ;
+		static const U32 DEFAULT_CHUNK_COUNT = ASYNC_CHUNK_COUNT;
+	private:
+		class IOClient : public IThreadClient
+		{
+		private:
+			ReadAheadStream* owner;
+		public:
+			IOClient(ReadAheadStream* ownerParam) : owner(ownerParam) {}
+			void Run();
+		};
+		struct Chunk
+		{
+			char* Data;
+			//bytes actually read into the chunk.
+			FileSz Size;
+		};
+
+		//only touched by the I/O thread once it's started.
+		DataStream* file;
+		bool ownsFile;
+		FileSz streamStart;
+		FileSz streamSz;
+		U32 chunkSize;
+		char* chunkData;
+		Vector<Chunk> chunks;
+
+		//guards everything below.
+		Mutex mutex;
+		std::condition_variable chunkFilled;
+		std::condition_variable chunkFreed;
+		//the filled chunks run from readChunk, wrapping around.
+		U32 readChunk;
+		U32 numFilled;
+		//consumer's position in chunks[readChunk].
+		FileSz chunkPos;
+		//consumer's position in the stream.
+		FileSz readPos;
+		//where the I/O thread reads next.
+		FileSz fillPos;
+		//bumped on every Seek(), so reads already in flight are thrown out.
+		U32 generation;
+		//set if the file came up short; reading stops at fillPos.
+		bool failed;
+		bool stopping;
+		U32 numStalls;
+
+		IOClient ioClient;
+		Thread* ioThread;
+
+		void runIO();
+		FileSz read(char* dest, FileSz size, bool block);
+
+		ReadAheadStream(const ReadAheadStream& other);
+		ReadAheadStream& operator=(const ReadAheadStream& other);
+	public:
+		/**
+		Starts reading ahead immediately.
+		@param fileParam the stream to read from; nothing else should use it
+		until this is destroyed.
+		@param ownsFileParam if true, the file's closed along with this.
+		@param chunkCountParam number of chunks to read ahead; at least 2.
+		*/
+		ReadAheadStream(DataStream* fileParam, FileSz start, FileSz size, bool ownsFileParam,
+						U32 chunkSizeParam = DEFAULT_CHUNK_SIZE, U32 chunkCountParam = DEFAULT_CHUNK_COUNT);
+		~ReadAheadStream();
+
+		/**
+		Copies the next bytes of the stream,
+		waiting for the I/O thread only if none of them have been read yet.
+		@return the number of bytes copied; less than size only at the end of the stream.
+		*/
+		FileSz Read(char* dest, FileSz size);
+		/**
+		Copies whatever's already been read, up to size bytes. Never waits.
+		*/
+		FileSz TryRead(char* dest, FileSz size);
+		/**
+		Moves to the given position, relative to the stream's start.
+		Anything that was read ahead is thrown out, unless the new position's inside it.
+		*/
+		FileSz Seek(FileSz relPos);
+		FileSz Tell();
+		FileSz Size() const { return streamSz; }
+		/**
+		Gets the number of bytes that can be read without waiting.
+		*/
+		FileSz Available();
+		/**
+		Gets the number of times Read() had to wait for the I/O thread.
+		*/
+		U32 NumStalls();
+	};
+}
@@ -91,17 +91,26 @@ bool StdLibDataStream::OpenText(const char* path)
 
 bool StdLibDataStream::Close()
 {
-	file.close();
 	//if file's invalid, there wasn't anything to close
-	return true;
+	if(!file.is_open())
+	{
+		return true;
+	}
+	//closing flushes any buffered writes; only report if that fails,
+	//not that an earlier read ran into the end of the file.
+	file.clear();
+	file.close();
+	return !file.fail();
 }
 
 FileSz StdLibDataStream::Write(const char* buffer, FileSz size)
 {
 	file.write(buffer, size);
+	//the stream can't say how much was written, only whether it all was.
+	bool failed = file.fail();
 	//update file size?
 	updateFileSize();
-	return size;
+	return failed ? 0 : size;
 }
 
 FileSz StdLibDataStream::Write(const char* buffer)
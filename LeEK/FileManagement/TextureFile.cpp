@@ -0,0 +1,197 @@
+#include "TextureFile.h"
+#include "Logging/Log.h"
+#include "Hashing/Hash.h"
+#include "FileManagement/Filesystem.h"
+#include "Math/MathFunctions.h"
+#include <cstring>
+
+using namespace LeEK;
+
+namespace
+{
+	//Lays out the file; everything but the regions and level data is in the header.
+	TextureHeader buildHeader(const Texture2D& tex, const Vector<TextureRegion>& regions)
+	{
+		TextureHeader hdr;
+		memset(&hdr, 0, sizeof(TextureHeader));
+		hdr.Signature = TextureHeader::SIGNATURE;
+		hdr.Version = CURR_TEXTURE_VER;
+		hdr.PixType = (U8)tex.PixType;
+		hdr.CompType = (U8)tex.CompType;
+		hdr.Width = tex.Width;
+		hdr.Height = tex.Height;
+		hdr.NumMips = (U8)tex.MipCount();
+		hdr.NumRegions = regions.size();
+		hdr.RegionTableStart = sizeof(TextureHeader);
+		hdr.StringTableStart = hdr.RegionTableStart + regions.size() * sizeof(AtlasRegion);
+		for(U32 i = 0; i < regions.size(); ++i)
+		{
+			hdr.StringTableSize += regions[i].Name.length() + 1;
+		}
+		hdr.DataStart = Math::RoundUp<U32>(hdr.StringTableStart + hdr.StringTableSize, TEXTURE_DATA_ALIGN);
+		hdr.DataSize = tex.DataSize();
+		hdr.FileSize = hdr.DataStart + hdr.DataSize;
+		return hdr;
+	}
+
+	//The texture the header describes, minus its data.
+	Texture2D textureFromHeader(const TextureHeader& hdr)
+	{
+		Texture2D tex = Texture2D();
+		tex.PixType = (Texture2D::PixelType)hdr.PixType;
+		tex.CompType = (Texture2D::CompressionType)hdr.CompType;
+		tex.Width = hdr.Width;
+		tex.Height = hdr.Height;
+		tex.BitDepth = 32;
+		tex.HasMipMap = hdr.NumMips > 1;
+		tex.NumMips = hdr.NumMips;
+		return tex;
+	}
+}
+
+size_t TextureMgr::FindFileSize(const Texture2D& tex, const Vector<TextureRegion>& regions)
+{
+	return buildHeader(tex, regions).FileSize;
+}
+
+bool TextureMgr::WriteTextureMemory(const Texture2D& tex, const Vector<TextureRegion>& regions, char* buf, size_t bufSize)
+{
+	if(!tex.Data || tex.PixType >= Texture2D::PIXTYPE_LEN || tex.CompType >= Texture2D::COMPTYPE_LEN)
+	{
+		LogE("Texture has no data, or has an unknown format!");
+		return false;
+	}
+	TextureHeader hdr = buildHeader(tex, regions);
+	if(!buf || bufSize < hdr.FileSize)
+	{
+		LogE("Buffer's too small for texture!");
+		return false;
+	}
+	memset(buf, 0, hdr.FileSize);
+	memcpy(buf, &hdr, sizeof(TextureHeader));
+	AtlasRegion* regionTable = (AtlasRegion*)(buf + hdr.RegionTableStart);
+	U32 nameOffset = 0;
+	for(U32 i = 0; i < regions.size(); ++i)
+	{
+		const TextureRegion& region = regions[i];
+		AtlasRegion& out = regionTable[i];
+		out.NameHash = getHash(region.Name.c_str(), region.Name.length());
+		out.Name = nameOffset;
+		out.X = region.X;
+		out.Y = region.Y;
+		out.Width = region.Width;
+		out.Height = region.Height;
+		memcpy(buf + hdr.StringTableStart + nameOffset, region.Name.c_str(), region.Name.length() + 1);
+		nameOffset += region.Name.length() + 1;
+	}
+	memcpy(buf + hdr.DataStart, tex.Data, hdr.DataSize);
+	return true;
+}
+
+bool TextureMgr::IsTextureFile(const char* data, size_t size)
+{
+	if(!data || size < sizeof(TextureHeader))
+	{
+		return false;
+	}
+	const TextureHeader* hdr = (const TextureHeader*)data;
+	return hdr->Signature == TextureHeader::SIGNATURE && hdr->Version <= CURR_TEXTURE_VER;
+}
+
+bool TextureMgr::VerifyTextureFile(const char* data, size_t size)
+{
+	if(!IsTextureFile(data, size))
+	{
+		LogE("Couldn't verify texture header!");
+		return false;
+	}
+	const TextureHeader* hdr = (const TextureHeader*)data;
+	U64 fileSize = hdr->FileSize;
+	if(	fileSize > size || hdr->PixType >= Texture2D::PIXTYPE_LEN || hdr->CompType >= Texture2D::COMPTYPE_LEN ||
+		hdr->Width < 1 || hdr->Height < 1 || hdr->NumMips < 1 ||
+		//any bigger and the level sizes could overflow.
+		hdr->Width > Texture2D::MAX_DIMENSION || hdr->Height > Texture2D::MAX_DIMENSION ||
+		hdr->NumMips > Texture2D::FullMipCount(hdr->Width, hdr->Height))
+	{
+		LogE("Texture has a malformed header!");
+		return false;
+	}
+	//the data's size has to match the format, or we'd upload past its end.
+	if(	hdr->DataStart % TEXTURE_DATA_ALIGN != 0 || !Filesystem::InFile(hdr->DataStart, hdr->DataSize, 1, fileSize) ||
+		textureFromHeader(*hdr).DataSize() != hdr->DataSize)
+	{
+		LogE("Texture has malformed level data!");
+		return false;
+	}
+	U32 stringsSize = hdr->StringTableSize;
+	if(	!Filesystem::InFile(hdr->StringTableStart, stringsSize, 1, fileSize) ||
+		(stringsSize > 0 && data[hdr->StringTableStart + stringsSize - 1] != 0))
+	{
+		LogE("Texture has a malformed string table!");
+		return false;
+	}
+	if(!Filesystem::InFile(hdr->RegionTableStart, hdr->NumRegions, sizeof(AtlasRegion), fileSize))
+	{
+		LogE("Texture has a malformed region table!");
+		return false;
+	}
+	const AtlasRegion* regions = (const AtlasRegion*)(data + hdr->RegionTableStart);
+	for(U32 i = 0; i < hdr->NumRegions; ++i)
+	{
+		const AtlasRegion& region = regions[i];
+		if(	region.Name >= stringsSize || region.X > hdr->Width || region.Width > hdr->Width - region.X ||
+			region.Y > hdr->Height || region.Height > hdr->Height - region.Y)
+		{
+			LogE(String("Texture has a malformed atlas region ") + i + "!");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool TextureMgr::ReadTextureInPlace(Texture2D& tex, const char* data, size_t size)
+{
+	if(!VerifyTextureFile(data, size))
+	{
+		return false;
+	}
+	const TextureHeader* hdr = (const TextureHeader*)data;
+	tex = textureFromHeader(*hdr);
+	tex.Data = (char*)data + hdr->DataStart;
+	return true;
+}
+
+U32 TextureMgr::GetRegionCount(const char* data)
+{
+	return ((const TextureHeader*)data)->NumRegions;
+}
+
+const AtlasRegion* TextureMgr::GetRegion(const char* data, U32 index)
+{
+	const TextureHeader* hdr = (const TextureHeader*)data;
+	if(index >= hdr->NumRegions)
+	{
+		return NULL;
+	}
+	return (const AtlasRegion*)(data + hdr->RegionTableStart) + index;
+}
+
+const char* TextureMgr::GetRegionName(const char* data, const AtlasRegion& region)
+{
+	return data + ((const TextureHeader*)data)->StringTableStart + region.Name;
+}
+
+const AtlasRegion* TextureMgr::FindRegion(const char* data, const char* name)
+{
+	const TextureHeader* hdr = (const TextureHeader*)data;
+	const AtlasRegion* regions = (const AtlasRegion*)(data + hdr->RegionTableStart);
+	U32 nameHash = getHash(name, strlen(name));
+	for(U32 i = 0; i < hdr->NumRegions; ++i)
+	{
+		if(regions[i].NameHash == nameHash && strcmp(GetRegionName(data, regions[i]), name) == 0)
+		{
+			return &regions[i];
+		}
+	}
+	return NULL;
+}
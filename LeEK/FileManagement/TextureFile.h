@@ -0,0 +1,101 @@
+#pragma once
+#include "Datatypes.h"
+#include "Rendering/Texture.h"
+#include "DataStructures/STLContainers.h"
+#include "Strings/String.h"
+
+namespace LeEK
+{
+	const U16 CURR_TEXTURE_VER = 100;
+	//Level data starts on a multiple of this, counting from the start of the file.
+	const U32 TEXTURE_DATA_ALIGN = 16;
+
+	//File structs follow.
+	//Specify no packing so that this matches what's written to disk.
+#pragma pack(1)
+	/**
+	Header of a cooked texture (.ltex).
+	The header's followed by the atlas region table, the region names,
+	and then every mip level back to back, largest first,
+	exactly as Texture2D::Data holds them. Every offset counts from the start of the file,
+	so the file can be used wherever it's loaded without any fixups.
+	*/
+	struct TextureHeader
+	{
+		enum { SIGNATURE = 0x4C4B5458 };
+		U32 Signature;
+		U16 Version;
+		//A Texture2D::PixelType.
+		U8 PixType;
+		//A Texture2D::CompressionType.
+		U8 CompType;
+		U32 Width;
+		U32 Height;
+		//At least 1; more than 1 means the texture has mipmaps.
+		U8 NumMips;
+		U8 Pad[3];
+		U32 DataStart;
+		U32 DataSize;
+		//0 unless the texture's an atlas.
+		U32 NumRegions;
+		U32 RegionTableStart;
+		//The string table holds every region's name, each null terminated.
+		U32 StringTableStart;
+		U32 StringTableSize;
+		U32 FileSize;
+	};
+
+	/**
+	Where one of an atlas' source images ended up, in pixels of the top level.
+	Y counts from the first row of the texture's data, the same way V does.
+	*/
+	struct AtlasRegion
+	{
+		//getHash() of the name, to skip most string compares.
+		U32 NameHash;
+		//Offset into the string table.
+		U32 Name;
+		U32 X;
+		U32 Y;
+		U32 Width;
+		U32 Height;
+	};
+#pragma pack()
+
+	//An atlas region to write.
+	struct TextureRegion
+	{
+		String Name;
+		U32 X;
+		U32 Y;
+		U32 Width;
+		U32 Height;
+	};
+
+	namespace TextureMgr
+	{
+		//Finds the total size of the texture if written to disk.
+		size_t FindFileSize(const Texture2D& tex, const Vector<TextureRegion>& regions);
+		//regions can be empty, for textures that aren't atlases.
+		bool WriteTextureMemory(const Texture2D& tex, const Vector<TextureRegion>& regions, char* buf, size_t bufSize);
+		//Returns true if the data starts with a texture header. Only looks at the header.
+		bool IsTextureFile(const char* data, size_t size);
+		/**
+		Checks that every offset and region in the file is in bounds,
+		and that the level data's the size the header says it should be.
+		*/
+		bool VerifyTextureFile(const char* data, size_t size);
+		/**
+		Reads a texture without copying anything;
+		the texture's data points straight into data, which has to outlive the texture.
+		*/
+		bool ReadTextureInPlace(Texture2D& tex, const char* data, size_t size);
+
+		//Atlas lookups. data has to have passed VerifyTextureFile().
+		U32 GetRegionCount(const char* data);
+		const AtlasRegion* GetRegion(const char* data, U32 index);
+		const char* GetRegionName(const char* data, const AtlasRegion& region);
+		//Returns NULL if there's no region of that name.
+		const AtlasRegion* FindRegion(const char* data, const char* name);
+	}
+}
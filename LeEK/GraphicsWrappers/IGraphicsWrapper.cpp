@@ -1,3 +1,18 @@
 #include "IGraphicsWrapper.h"
 
-using namespace LeEK;
\ No newline at end of file
+using namespace LeEK;
+
+bool IGraphicsWrapper::InitModel(Model& model)
+{
+	for(U32 lod = 0; lod < model.LODCount(); ++lod)
+	{
+		for(U32 i = 0; i < model.LODMeshCount(lod); ++i)
+		{
+			if(!InitGeometry(model.GetLODMesh(lod, i)->GetGeometry()))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -8,6 +8,7 @@
 //#include "EngineLogic/IEngineModule.h"
 #include "Memory/Handle.h"
 #include "Rendering/Text.h"
+#include "Rendering/TextBatch.h"
 #include "Rendering/Model.h"
 #include "Rendering/Bounds/AABBBounds.h"
 #include "Rendering/Bounds/SphereBounds.h"
@@ -73,6 +74,12 @@ namespace LeEK
 		*/
 		virtual bool InitGeometry(Geometry& mesh) = 0;
 		/**
+		* Builds wrapper-specific data for every mesh in every LOD of the model,
+		* since the renderer can pick any of them.
+		* @param model the model to be processed by the wrapper.
+		*/
+		bool InitModel(Model& model);
+		/**
 		* Builds wrapper-specific data for the specified text element.
 		* @param text the text to be processed by the wrapper.
 		*/
@@ -121,6 +128,12 @@ namespace LeEK
 		* @param text the text to be drawn. Must have been initialized via InitText().
 		*/
 		virtual void Draw(Text& text) = 0;
+		/**
+		* Draws every Text in a batch, with a draw call per glyph page.
+		* Uses whichever shader's current, like the other Draw() calls.
+		* @param batch the texts to be drawn; they don't need to have been initialized via InitText().
+		*/
+		virtual void Draw(const TextBatch& batch) = 0;
 
 		/**
 		* Draws a line independent of the current shading program.
@@ -38,6 +38,7 @@ namespace LeEK
 		inline void Clear() {}
 		void Draw(const Geometry& mesh) {}
 		void Draw(Text& text) {}
+		void Draw(const TextBatch& batch) {}
 		#pragma region Debug Drawing Commands
 		void DebugDrawLine(const Vector3& start, const Vector3& end, const Color& color) {}
 		void DebugDrawPlane(const Vector3& origin, const Vector3& normal, const Color& color) {}
@@ -7,6 +7,13 @@
 #include "Stats/Profiling.h"
 #include "DebugUtils/Assertions.h"
 #include "Rendering/Camera/Camera.h"
+#include "Rendering/Font.h"
+#include <cstddef>
+
+//BPTC's been core since 4.2, but the loader header leaves it out.
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
 
 #ifndef RENDERER_HARD_ASSERT
 //#define RENDERER_HARD_ASSERT
@@ -78,6 +85,8 @@ void initCompFormatTable()
 {
 	comprFormatTypes[Texture2D::NONE] = 0;
 	comprFormatTypes[Texture2D::DXT1] = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	comprFormatTypes[Texture2D::DXT5] = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	comprFormatTypes[Texture2D::BC7] = GL_COMPRESSED_RGBA_BPTC_UNORM;
 	//TODO: figure out how the hell to do crunch
 }
 GLenum lastGlobalErr = GL_NO_ERROR;
@@ -375,6 +384,10 @@ OGLGrpWrapper::OGLGrpWrapper(void) : currentProgram()
 	debugVertArrayHnd = 0;
 	debugIndexHnd = 0;
 	contextSet = false;
+	textStreamVAOHnd = 0;
+	textStreamVertHnd = 0;
+	textStreamIndexHnd = 0;
+	textStreamPos = 0;
 
 	initTexFormatTable();
 	initCompFormatTable();
@@ -487,7 +500,7 @@ bool OGLGrpWrapper::InitGeometry(Geometry& mesh)
 	//}
 	glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
 	assertNoErr();
-	glBufferData(GL_ARRAY_BUFFER, mesh.VertexCount() * sizeof(Vertex), mesh.Vertices(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, mesh.VertexSizeAsBuffer(), mesh.VertexData(), GL_STATIC_DRAW);
 	assertNoErr();
 	//about to recieve pointers to individual pieces of data; enable VAO attributes
 	glEnableVertexAttribArray(POSITION);
@@ -495,29 +508,52 @@ bool OGLGrpWrapper::InitGeometry(Geometry& mesh)
 	glEnableVertexAttribArray(NORMAL);
 	glEnableVertexAttribArray(UV0);
 	assertNoErr();
-	//notify OpenGL where position data is in geometry
-	//glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
-	//pass data to attribute 0, position
-	//last param is an OFFSET to the pointer to the data
-	glVertexAttribPointer(	POSITION,
-							3,				//3 components in a Vector3
-							GL_FLOAT,		//uses floats
-							false,			//don't normalize values
-							sizeof(Vertex),	//stride by vert size
-							0);				//offset to position component within each vertex
-	assertNoErr();
-	//next, pass data to attribute 1, color
-	//since color's the second element in Vertex, you have to offset by one vector
-	//glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
-	glVertexAttribPointer(COLOR, 3, GL_FLOAT, false, sizeof(Vertex), (unsigned char*)0 + (sizeof(Vector3)));
-	assertNoErr();
-	//and finally, pass data to normals
-	//glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
-	glVertexAttribPointer(NORMAL, 3, GL_FLOAT, false, sizeof(Vertex), (unsigned char*)0 + (2*sizeof(Vector3)));
-	assertNoErr();
-	//change to use Vector2s?
-	glVertexAttribPointer(UV0, 2, GL_FLOAT, false, sizeof(Vertex), (unsigned char*)0 + (3*sizeof(Vector3)));
-	assertNoErr();
+	if(mesh.IsPacked())
+	{
+		//Packed vertices are expanded by the attribute fetch.
+		//Positions come out relative to the mesh bounds (see PackedVertex)
+		//and normals come out as their 2 octahedral components;
+		//the shader finishes decoding both, see setVertexFormatUniforms().
+		glVertexAttribPointer(	POSITION,
+								3,
+								mesh.Format() == HALF_POS_VERTEX ? GL_HALF_FLOAT : GL_SHORT,
+								mesh.Format() == SNORM_POS_VERTEX,	//snorms map to [-1, 1]
+								sizeof(PackedVertex),
+								(unsigned char*)0 + offsetof(PackedVertex, Position));
+		assertNoErr();
+		glVertexAttribPointer(COLOR, 3, GL_UNSIGNED_BYTE, true, sizeof(PackedVertex), (unsigned char*)0 + offsetof(PackedVertex, Color));
+		assertNoErr();
+		glVertexAttribPointer(NORMAL, 2, GL_SHORT, true, sizeof(PackedVertex), (unsigned char*)0 + offsetof(PackedVertex, Normal));
+		assertNoErr();
+		glVertexAttribPointer(UV0, 2, GL_HALF_FLOAT, false, sizeof(PackedVertex), (unsigned char*)0 + offsetof(PackedVertex, UV));
+		assertNoErr();
+	}
+	else
+	{
+		//notify OpenGL where position data is in geometry
+		//glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
+		//pass data to attribute 0, position
+		//last param is an OFFSET to the pointer to the data
+		glVertexAttribPointer(	POSITION,
+								3,				//3 components in a Vector3
+								GL_FLOAT,		//uses floats
+								false,			//don't normalize values
+								sizeof(Vertex),	//stride by vert size
+								0);				//offset to position component within each vertex
+		assertNoErr();
+		//next, pass data to attribute 1, color
+		//since color's the second element in Vertex, you have to offset by one vector
+		//glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
+		glVertexAttribPointer(COLOR, 3, GL_FLOAT, false, sizeof(Vertex), (unsigned char*)0 + (sizeof(Vector3)));
+		assertNoErr();
+		//and finally, pass data to normals
+		//glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
+		glVertexAttribPointer(NORMAL, 3, GL_FLOAT, false, sizeof(Vertex), (unsigned char*)0 + (2*sizeof(Vector3)));
+		assertNoErr();
+		//change to use Vector2s?
+		glVertexAttribPointer(UV0, 2, GL_FLOAT, false, sizeof(Vertex), (unsigned char*)0 + (3*sizeof(Vector3)));
+		assertNoErr();
+	}
 	//now generate and pass vertex indices
 	//if(mesh.IndexBufferHandle() == 0)
 	//{
@@ -528,7 +564,7 @@ bool OGLGrpWrapper::InitGeometry(Geometry& mesh)
 	
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IndexBufferHandle());
 	assertNoErr();
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.IndexCount() * sizeof(U32), mesh.Indices(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.IndexSizeAsBuffer(), mesh.IndexData(), GL_STATIC_DRAW);
 	assertNoErr();
 	//TODO: handle normals
 
@@ -644,17 +680,36 @@ bool OGLGrpWrapper::InitTexture(Texture2D& tex, TextureMeta::MapType type)
 	glBindTexture(GL_TEXTURE_2D, tex.TextureBufferHandle);
 	assertNoErr();
 
-	//load the texture data
-	glTexImage2D(	GL_TEXTURE_2D,	//2D texture
-					0,				//base level of mipmap
-					texOutputTypes[tex.PixType], //way the pixels should be stored in VRAM
-					tex.Width,
-					tex.Height,
-					0,				//border never worked!
-					texInputTypes[tex.PixType], //GL_RGBA,	//way the pixels are stored in the res manager
-					texDataWidths[tex.PixType], //GL_UNSIGNED_BYTE,
-					tex.Data);
-	assertNoErr();
+	//load the texture data.
+	//Cooked textures bring every mip level with them, and compressed ones
+	//go to VRAM as they are.
+	for(U32 level = 0; level < tex.MipCount(); ++level)
+	{
+		if(tex.IsCompressed())
+		{
+			glCompressedTexImage2D(	GL_TEXTURE_2D,
+									level,
+									comprFormatTypes[tex.CompType],
+									tex.LevelWidth(level),
+									tex.LevelHeight(level),
+									0,
+									tex.LevelSize(level),
+									tex.Data + tex.LevelOffset(level));
+		}
+		else
+		{
+			glTexImage2D(	GL_TEXTURE_2D,	//2D texture
+							level,			//level of mipmap
+							texOutputTypes[tex.PixType], //way the pixels should be stored in VRAM
+							tex.LevelWidth(level),
+							tex.LevelHeight(level),
+							0,				//border never worked!
+							texInputTypes[tex.PixType], //GL_RGBA,	//way the pixels are stored in the res manager
+							texDataWidths[tex.PixType], //GL_UNSIGNED_BYTE,
+							tex.Data + tex.LevelOffset(level));
+		}
+		assertNoErr();
+	}
 	GLint err = glGetError();
 	if(err != GL_NO_ERROR)
 	{
@@ -674,19 +729,26 @@ bool OGLGrpWrapper::InitTexture(Texture2D& tex, TextureMeta::MapType type)
 	//mipmap levels...
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
 	assertNoErr();
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	//Compressed textures can't have mipmaps generated for them,
+	//so they only have the levels they were cooked with.
+	bool generateMips = !tex.HasMipMap && !tex.IsCompressed();
+	if(!generateMips)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, tex.MipCount() - 1);
+		assertNoErr();
+	}
 
 	//and filtering - basically, do trilinear.
 	//Magnification is linear, minification is linear w/ linear mipmapping
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tex.MipCount() > 1 || generateMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 	assertNoErr();
 	if(err != GL_NO_ERROR)
 	{
 		LogE(StrFromVal(err));
 	}
 	//generate mipmaps if needed1
-	if(!tex.HasMipMap)
+	if(generateMips)
 	{
 		//apparently, ATI drivers as of 2011 have a bug
 		//where you need to glEnable GL_TEXTURE_2D
@@ -732,6 +794,7 @@ void OGLGrpWrapper::Shutdown()
 	//glDeleteBuffers(1, &vertexBufferHnd);
 	//glDeleteBuffers(1, &indexBufferHnd);
 	glDeleteBuffers(1, &debugVertArrayHnd);
+	shutdownTextStream();
 	}
 
 //Can only be called AFTER OGLGrpWrapper::Shutdown.
@@ -797,6 +860,22 @@ void OGLGrpWrapper::Clear(Color c)
 	assertNoErr();
 }
 
+void OGLGrpWrapper::setVertexFormatUniforms(const Geometry& mesh)
+{
+	//shaders that can't take packed meshes won't have these.
+	if(!currentProgram || currentProgram->ProgramHandle() == 0 || !currentProgram->HasUniform("posScale"))
+	{
+		return;
+	}
+	SetVec3Uniform("posOffset", mesh.PositionOffset());
+	SetVec3Uniform("posScale", mesh.PositionScale());
+	if(currentProgram->HasUniform("packedNormals"))
+	{
+		glUniform1i(currentProgram->GetUniformHandle("packedNormals"), mesh.IsPacked() ? 1 : 0);
+		assertNoErr();
+	}
+}
+
 void OGLGrpWrapper::Draw(const Geometry& mesh)
 {
 	PROFILE("DrawMesh");
@@ -806,12 +885,13 @@ void OGLGrpWrapper::Draw(const Geometry& mesh)
 		//glUseProgram(currentProgram->ProgramHandle());
 		//glBindBuffer(GL_ARRAY_BUFFER, mesh.VertexBufferHandle());
 		//glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IndexBufferHandle());
+		setVertexFormatUniforms(mesh);
 		glBindVertexArray(mesh.VertexArrayHandle());
 		assertNoErr();
 		//pass null as index pointer to indicate that a buffer should be used
 		glDrawElements(	GL_TRIANGLES,		//doesn't matter as much as in glDrawArrays
 						mesh.IndexCount(),	//number of indices
-						GL_UNSIGNED_INT,	//index format
+						mesh.IndexSize() == sizeof(U16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,	//index format
 						0);					//indices not here, search an active buffer
 		assertNoErr();
 		//unbind to prep for next mesh?
@@ -841,12 +921,20 @@ void OGLGrpWrapper::Draw(Text& text)
 		//glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IndexBufferHandle());
 		glBindVertexArray(mesh.VertexArrayHandle());
 		assertNoErr();
-		//pass null as index pointer to indicate that a buffer should be used
-		glDrawElements(	GL_TRIANGLES,		//doesn't matter as much as in glDrawArrays
-						mesh.IndexCount(),	//number of indices
-						GL_UNSIGNED_INT,	//index format
-						0);					//indices not here, search an active buffer
-		assertNoErr();
+		//each run of quads samples a different glyph page
+		const Font& font = text.GetFont();
+		const Vector<TextRun>& runs = text.GetRuns();
+		for(U32 r = 0; r < runs.size(); ++r)
+		{
+			const TextRun& run = runs[r];
+			SetTexture(font.GetPageTexture(run.Page), TextureMeta::DIFFUSE);
+			//the index pointer is an offset into the active buffer
+			glDrawElements(	GL_TRIANGLES,		//doesn't matter as much as in glDrawArrays
+							run.NumQuads * 6,	//number of indices
+							GL_UNSIGNED_INT,	//index format
+							(unsigned char*)0 + (run.FirstQuad * 6 * sizeof(U32)));
+			assertNoErr();
+		}
 		//unbind to prep for next mesh?
 		glBindVertexArray(0);
 		assertNoErr();
@@ -855,6 +943,164 @@ void OGLGrpWrapper::Draw(Text& text)
 	}
 }
 
+bool OGLGrpWrapper::initTextStream()
+{
+	glGenVertexArrays(1, &textStreamVAOHnd);
+	glBindVertexArray(textStreamVAOHnd);
+	assertNoErr();
+
+	//the vertex buffer's only ever written through mappings
+	glGenBuffers(1, &textStreamVertHnd);
+	glBindBuffer(GL_ARRAY_BUFFER, textStreamVertHnd);
+	glBufferData(GL_ARRAY_BUFFER, TEXT_STREAM_QUADS * 4 * sizeof(TextVertex), NULL, GL_STREAM_DRAW);
+	assertNoErr();
+	glEnableVertexAttribArray(POSITION);
+	glEnableVertexAttribArray(UV0);
+	glVertexAttribPointer(POSITION, 3, GL_FLOAT, false, sizeof(TextVertex), 0);
+	glVertexAttribPointer(UV0, 2, GL_FLOAT, false, sizeof(TextVertex), (unsigned char*)0 + (sizeof(Vector3)));
+	assertNoErr();
+
+	//every quad's indexed the same way, so the indices never change;
+	//draws pick their quads with a base vertex.
+	const U32 numIndices = TEXT_STREAM_QUADS * 6;
+	U32* indices = CustomArrayNew<U32>(numIndices, RENDERER_ALLOC, "TextStreamAlloc");
+	for(U32 i = 0; i < TEXT_STREAM_QUADS; ++i)
+	{
+		const U32 vIndexBase = i * 4;
+		U32* quad = indices + (i * 6);
+		quad[0] = vIndexBase;
+		quad[1] = vIndexBase + 1;
+		quad[2] = vIndexBase + 2;
+		quad[3] = vIndexBase + 3;
+		quad[4] = vIndexBase + 2;
+		quad[5] = vIndexBase + 1;
+	}
+	glGenBuffers(1, &textStreamIndexHnd);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, textStreamIndexHnd);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(U32), indices, GL_STATIC_DRAW);
+	CustomArrayDelete(indices);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	textStreamPos = 0;
+	return glGetError() == GL_NO_ERROR;
+}
+
+void OGLGrpWrapper::shutdownTextStream()
+{
+	for(U32 i = 0; i < textStreamFences.size(); ++i)
+	{
+		glDeleteSync(textStreamFences[i].Fence);
+	}
+	textStreamFences.clear();
+	if(textStreamVAOHnd != 0)
+	{
+		glDeleteBuffers(1, &textStreamVertHnd);
+		glDeleteBuffers(1, &textStreamIndexHnd);
+		glDeleteVertexArrays(1, &textStreamVAOHnd);
+	}
+	textStreamVAOHnd = 0;
+	textStreamVertHnd = 0;
+	textStreamIndexHnd = 0;
+}
+
+void OGLGrpWrapper::waitForTextStream(U32 start, U32 end)
+{
+	//in nanoseconds
+	const GLuint64 FENCE_TIMEOUT = 1000000;
+	for(U32 i = 0; i < textStreamFences.size(); )
+	{
+		StreamFence& fence = textStreamFences[i];
+		if(fence.Start >= end || fence.End <= start)
+		{
+			++i;
+			continue;
+		}
+		while(glClientWaitSync(fence.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT) == GL_TIMEOUT_EXPIRED)
+		{
+		}
+		glDeleteSync(fence.Fence);
+		textStreamFences.erase(textStreamFences.begin() + i);
+	}
+}
+
+void OGLGrpWrapper::retireTextStreamFences()
+{
+	//fences signal in the order they were made,
+	//so everything after the first unsignaled one is still pending too.
+	U32 numSignaled = 0;
+	for(; numSignaled < textStreamFences.size(); ++numSignaled)
+	{
+		GLenum status = glClientWaitSync(textStreamFences[numSignaled].Fence, 0, 0);
+		if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+		glDeleteSync(textStreamFences[numSignaled].Fence);
+	}
+	textStreamFences.erase(textStreamFences.begin(), textStreamFences.begin() + numSignaled);
+}
+
+void OGLGrpWrapper::Draw(const TextBatch& batch)
+{
+	PROFILE("DrawTextBatch");
+	if(batch.QuadCount() == 0)
+	{
+		return;
+	}
+	if(textStreamVAOHnd == 0 && !initTextStream())
+	{
+		LogE("Couldn't build text stream!");
+		shutdownTextStream();
+		return;
+	}
+	retireTextStreamFences();
+	glBindVertexArray(textStreamVAOHnd);
+	glBindBuffer(GL_ARRAY_BUFFER, textStreamVertHnd);
+	assertNoErr();
+	for(U32 r = 0; r < batch.RunCount(); ++r)
+	{
+		const TextBatch::PageRun& run = batch.GetRun(r);
+		SetTexture(run.Texture, TextureMeta::DIFFUSE);
+		//runs too big for the stream go in pieces
+		for(U32 quad = 0; quad < run.QuadCount(); )
+		{
+			const U32 numQuads = Math::Min(run.QuadCount() - quad, TEXT_STREAM_QUADS);
+			const U32 numVerts = numQuads * 4;
+			if(textStreamPos + numVerts > TEXT_STREAM_QUADS * 4)
+			{
+				textStreamPos = 0;
+			}
+			waitForTextStream(textStreamPos, textStreamPos + numVerts);
+			//the fences keep the GPU off this range, so the driver doesn't need to sync
+			void* dest = glMapBufferRange(	GL_ARRAY_BUFFER,
+											textStreamPos * sizeof(TextVertex),
+											numVerts * sizeof(TextVertex),
+											GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			if(!dest)
+			{
+				LogE("Couldn't map text stream!");
+				break;
+			}
+			memcpy(dest, &run.Vertices[quad * 4], numVerts * sizeof(TextVertex));
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glDrawElementsBaseVertex(GL_TRIANGLES, numQuads * 6, GL_UNSIGNED_INT, 0, textStreamPos);
+			assertNoErr();
+			StreamFence fence;
+			fence.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			fence.Start = textStreamPos;
+			fence.End = textStreamPos + numVerts;
+			textStreamFences.push_back(fence);
+			textStreamPos += numVerts;
+			quad += numQuads;
+		}
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	assertNoErr();
+}
+
 //The debug rendering commands.
 //Note that these all currently interrupt the API,
 //loading the debug shaders and immediately drawing the requested primitives.
@@ -33,6 +33,21 @@ namespace LeEK
 		U32 debugVertArrayHnd;
 		U32 debugIndexHnd;
 		bool contextSet;
+		//text batch streaming members.
+		//The stream's a ring of quads; each range drawn from gets a fence,
+		//so it isn't overwritten before the GPU's done with it.
+		struct StreamFence
+		{
+			GLsync Fence;
+			U32 Start;
+			U32 End;
+		};
+		U32 textStreamVAOHnd;
+		U32 textStreamVertHnd;
+		U32 textStreamIndexHnd;
+		//in vertices
+		U32 textStreamPos;
+		Vector<StreamFence> textStreamFences;
 		//screen properties
 		Vector2 screenRes;
 		//F32 fieldOfView, screenAspect;
@@ -41,6 +56,7 @@ namespace LeEK
 		void* context;
 
 		static const int debugVertArraySize = 256;
+		static const U32 TEXT_STREAM_QUADS = 65536;
 		//mesh data
 		static const F32 cubePos[24];
 		static const U32 cubeIndex[14];
@@ -51,8 +67,17 @@ namespace LeEK
 		bool buildDebugMeshes();
 		bool loadDebugShader();
 		bool loadDebugFunctions();
+		bool initTextStream();
+		void shutdownTextStream();
+		//Waits until the GPU's done drawing from any of the given range of the text stream.
+		void waitForTextStream(U32 start, U32 end);
+		//Deletes the text stream's fences that have already signaled, oldest first,
+		//so they don't pile up while the stream takes its time wrapping around.
+		void retireTextStreamFences();
 		
 		bool isContextSet();
+		//Sets the current shader's dequantization uniforms for the given mesh.
+		void setVertexFormatUniforms(const Geometry& mesh);
 		/**
 		Determines if the given GLenum is an enum for
 		geometry type, such as GL_TRIANGLE or GL_LINE_LOOP.
@@ -111,6 +136,7 @@ namespace LeEK
 		inline void Clear() { Clear(Colors::Black); }
 		void Draw(const Geometry& mesh);
 		void Draw(Text& text);
+		void Draw(const TextBatch& batch);
 		#pragma region Debug Drawing Commands
 		void DebugDrawLine(const Vector3& start, const Vector3& end, const Color& color);
 		void DebugDrawPlane(const Vector3& origin, const Vector3& normal, const Color& color);
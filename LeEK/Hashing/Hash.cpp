@@ -8,6 +8,15 @@ using namespace LeEK;
 namespace
 {
 	const U32 HASH_SEED = 0xA2490425;
+
+	inline char foldPathChar(char c)
+	{
+		if(c >= 'A' && c <= 'Z')
+		{
+			return c + ('a' - 'A');
+		}
+		return c == '\\' ? '/' : c;
+	}
 }
 
 //U32 LeEK::Hash(const String& key)
@@ -19,4 +28,27 @@ U32 LeEK::getHash(const void* val, U32 valLen)
 	return result;
 }
 
+U32 LeEK::HashPathNoCase(const char* path, U32 pathLen)
+{
+	//FNV-1a; it's byte at a time anyway, so folding each byte as it's hashed costs nothing.
+	U32 result = 2166136261U;
+	for(U32 i = 0; i < pathLen; ++i)
+	{
+		result = (result ^ (U8)foldPathChar(path[i])) * 16777619U;
+	}
+	return result;
+}
+
+bool LeEK::PathsEqualNoCase(const char* lhs, const char* rhs, U32 len)
+{
+	for(U32 i = 0; i < len; ++i)
+	{
+		if(foldPathChar(lhs[i]) != foldPathChar(rhs[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 //add overloads for basic types
@@ -8,6 +8,16 @@ namespace LeEK
 {
 	//note that this only takes chunks of data, not straight values.
 	U32 getHash(const void* val, U32 valLen);
+	/**
+	Hashes a file path without regard to case,
+	treating '\\' and '/' as the same separator.
+	Doesn't need a lowercased copy of the path, so it's cheap enough to call on every lookup.
+	*/
+	U32 HashPathNoCase(const char* path, U32 pathLen);
+	/**
+	Compares the first len characters of two paths the same way HashPathNoCase() hashes them.
+	*/
+	bool PathsEqualNoCase(const char* lhs, const char* rhs, U32 len);
 
 	static U32 Hash(const char* key, size_t len = 0) 
 	{
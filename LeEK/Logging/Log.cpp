@@ -4,6 +4,7 @@
 #include "Time/DateTime.h"
 #include "Platforms/IPlatform.h"
 #include <iostream>
+#include <mutex>
 
 using namespace LeEK;
 
@@ -19,6 +20,14 @@ U32 bufPos = 0;
 char logBuffer[MAX_BUF_CHARS] = {0};
 const char* FALLBACK_LOG_DIR = "/logs";
 
+//Resource loads log from worker threads, so messages are written under this.
+//Recursive in case a message handler logs too.
+std::recursive_mutex& logMutex()
+{
+	static std::recursive_mutex mutex;
+	return mutex;
+}
+
 void dumpBuffer()
 {
 	if(logFile)
@@ -150,6 +159,7 @@ void Log::SetLogMessageHandler(void (*newOnLogMessage)(const char* const, int))
 
 void Log::RAW(const char* message)
 {
+	std::lock_guard<std::recursive_mutex> lock(logMutex());
 	std::cout << message;
 	if(bufferingEnabled && !bufferingPaused)
 	{
@@ -160,6 +170,7 @@ void Log::RAW(const char* message)
 
 void Log::logMessage(const char* const message, Verbosity v)
 {
+	std::lock_guard<std::recursive_mutex> lock(logMutex());
 	if(verboseLevel >= v)
 	{
 		static const char* severPrefix = "";
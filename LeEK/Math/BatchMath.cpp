@@ -0,0 +1,403 @@
+#include "StdAfx.h"
+#include "BatchMath.h"
+#include "SimdKernels.h"
+#include <cmath>
+
+using namespace LeEK;
+
+namespace
+{
+	//Past this, the quaternions are close enough that
+	//slerp's weights are indistinguishable from lerp's
+	//(and sin(theta) gets too small to divide by).
+	const F32 SLERP_LERP_THRESHOLD = 0.9995f;
+
+	//Gets the weights for each endpoint of a slerp,
+	//given the (non negative) cosine of the angle between the endpoints.
+	void slerpWeights(F32 cosTheta, F32 t, F32& fromWeight, F32& toWeight)
+	{
+		if(cosTheta > SLERP_LERP_THRESHOLD)
+		{
+			fromWeight = 1.0f - t;
+			toWeight = t;
+			return;
+		}
+		//Math::ACos() and Math::Sin() are too rough to keep the
+		//results on the arc, so use the standard library here.
+		F32 theta = acosf(cosTheta);
+		F32 invSinTheta = 1.0f / sinf(theta);
+		fromWeight = sinf((1.0f - t) * theta) * invSinTheta;
+		toWeight = sinf(t * theta) * invSinTheta;
+	}
+
+	inline const F32* asFloats(const Vector3* v) { return (const F32*)v; }
+	inline F32* asFloats(Vector3* v) { return (F32*)v; }
+	inline const F32* asFloats(const Quaternion* q) { return (const F32*)q; }
+	inline F32* asFloats(Quaternion* q) { return (F32*)q; }
+}
+
+void BatchMath::TransformPoints(const Matrix4x4& m, const Vector3* points, Vector3* results, U32 numPoints)
+{
+	static_assert(sizeof(Vector3) == 3*sizeof(F32), "Vector3 isn't a packed float triple; fix BatchMath!");
+	const F32* mat = m.ToFloatArray();
+	const F32* in = asFloats(points);
+	F32* out = asFloats(results);
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	using namespace Math::SseDetail;
+	//Four points per step, with each component in its own register;
+	//out.x = x*m(0,0) + y*m(1,0) + z*m(2,0) + m(3,0), and so on.
+	__m128 m00 = _mm_set1_ps(mat[0]), m10 = _mm_set1_ps(mat[1]), m20 = _mm_set1_ps(mat[2]), m30 = _mm_set1_ps(mat[3]);
+	__m128 m01 = _mm_set1_ps(mat[4]), m11 = _mm_set1_ps(mat[5]), m21 = _mm_set1_ps(mat[6]), m31 = _mm_set1_ps(mat[7]);
+	__m128 m02 = _mm_set1_ps(mat[8]), m12 = _mm_set1_ps(mat[9]), m22 = _mm_set1_ps(mat[10]), m32 = _mm_set1_ps(mat[11]);
+	for(; i + 4 <= numPoints; i += 4)
+	{
+		__m128 x, y, z;
+		LoadPoints4(in + 3*i, x, y, z);
+		__m128 resX = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)),
+									_mm_add_ps(_mm_mul_ps(z, m20), m30));
+		__m128 resY = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)),
+									_mm_add_ps(_mm_mul_ps(z, m21), m31));
+		__m128 resZ = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)),
+									_mm_add_ps(_mm_mul_ps(z, m22), m32));
+		StorePoints4(out + 3*i, resX, resY, resZ);
+	}
+#endif
+	Math::Mat4TransformPoints(mat, in + 3*i, out + 3*i, numPoints - i);
+}
+
+void BatchMath::TransformPoints(	const Matrix4x4& m, const F32* xs, const F32* ys, const F32* zs,
+									F32* outXs, F32* outYs, F32* outZs, U32 numPoints)
+{
+	const F32* mat = m.ToFloatArray();
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	__m128 m00 = _mm_set1_ps(mat[0]), m10 = _mm_set1_ps(mat[1]), m20 = _mm_set1_ps(mat[2]), m30 = _mm_set1_ps(mat[3]);
+	__m128 m01 = _mm_set1_ps(mat[4]), m11 = _mm_set1_ps(mat[5]), m21 = _mm_set1_ps(mat[6]), m31 = _mm_set1_ps(mat[7]);
+	__m128 m02 = _mm_set1_ps(mat[8]), m12 = _mm_set1_ps(mat[9]), m22 = _mm_set1_ps(mat[10]), m32 = _mm_set1_ps(mat[11]);
+	for(; i + 4 <= numPoints; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(xs + i);
+		__m128 y = _mm_loadu_ps(ys + i);
+		__m128 z = _mm_loadu_ps(zs + i);
+		//Calculate everything before storing, in case the outputs alias the inputs.
+		__m128 resX = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)),
+									_mm_add_ps(_mm_mul_ps(z, m20), m30));
+		__m128 resY = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)),
+									_mm_add_ps(_mm_mul_ps(z, m21), m31));
+		__m128 resZ = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)),
+									_mm_add_ps(_mm_mul_ps(z, m22), m32));
+		_mm_storeu_ps(outXs + i, resX);
+		_mm_storeu_ps(outYs + i, resY);
+		_mm_storeu_ps(outZs + i, resZ);
+	}
+#endif
+	for(; i < numPoints; ++i)
+	{
+		F32 x = xs[i], y = ys[i], z = zs[i];
+		outXs[i] = x * mat[0] + y * mat[1] + z * mat[2] + mat[3];
+		outYs[i] = x * mat[4] + y * mat[5] + z * mat[6] + mat[7];
+		outZs[i] = x * mat[8] + y * mat[9] + z * mat[10] + mat[11];
+	}
+}
+
+void BatchMath::TransformVectors(const Matrix4x4& m, const Vector3* vecs, Vector3* results, U32 numVecs)
+{
+	const F32* mat = m.ToFloatArray();
+	const F32* in = asFloats(vecs);
+	F32* out = asFloats(results);
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	using namespace Math::SseDetail;
+	__m128 m00 = _mm_set1_ps(mat[0]), m10 = _mm_set1_ps(mat[1]), m20 = _mm_set1_ps(mat[2]);
+	__m128 m01 = _mm_set1_ps(mat[4]), m11 = _mm_set1_ps(mat[5]), m21 = _mm_set1_ps(mat[6]);
+	__m128 m02 = _mm_set1_ps(mat[8]), m12 = _mm_set1_ps(mat[9]), m22 = _mm_set1_ps(mat[10]);
+	for(; i + 4 <= numVecs; i += 4)
+	{
+		__m128 x, y, z;
+		LoadPoints4(in + 3*i, x, y, z);
+		__m128 resX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_mul_ps(z, m20));
+		__m128 resY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_mul_ps(z, m21));
+		__m128 resZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)), _mm_mul_ps(z, m22));
+		StorePoints4(out + 3*i, resX, resY, resZ);
+	}
+#endif
+	for(; i < numVecs; ++i)
+	{
+		const F32* v = in + 3*i;
+		F32 x = v[0], y = v[1], z = v[2];
+		F32* res = out + 3*i;
+		res[0] = x * mat[0] + y * mat[1] + z * mat[2];
+		res[1] = x * mat[4] + y * mat[5] + z * mat[6];
+		res[2] = x * mat[8] + y * mat[9] + z * mat[10];
+	}
+}
+
+void BatchMath::ExpandAABB(const Vector3* points, U32 numPoints, Vector3& min, Vector3& max, U32 stride)
+{
+	const U8* in = (const U8*)points;
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	using namespace Math::SseDetail;
+	if(stride == sizeof(Vector3))
+	{
+		//Packed points; split into components four at a time,
+		//and reduce the lanes at the end.
+		__m128 minX = _mm_set1_ps(min.X()), minY = _mm_set1_ps(min.Y()), minZ = _mm_set1_ps(min.Z());
+		__m128 maxX = _mm_set1_ps(max.X()), maxY = _mm_set1_ps(max.Y()), maxZ = _mm_set1_ps(max.Z());
+		for(; i + 4 <= numPoints; i += 4)
+		{
+			__m128 x, y, z;
+			LoadPoints4(asFloats(points) + 3*i, x, y, z);
+			minX = _mm_min_ps(minX, x);
+			minY = _mm_min_ps(minY, y);
+			minZ = _mm_min_ps(minZ, z);
+			maxX = _mm_max_ps(maxX, x);
+			maxY = _mm_max_ps(maxY, y);
+			maxZ = _mm_max_ps(maxZ, z);
+		}
+		min = Vector3(HorizontalMin(minX), HorizontalMin(minY), HorizontalMin(minZ));
+		max = Vector3(HorizontalMax(maxX), HorizontalMax(maxY), HorizontalMax(maxZ));
+	}
+	else if(stride >= 4*sizeof(F32) && numPoints > 0)
+	{
+		//Interleaved points (say, vertex positions);
+		//there's room to load a whole register per point, except at the very end,
+		//where the fourth float could be past the end of the array.
+		//The fourth lane's ignored.
+		__m128 minV = LoadPoint(min.ToFloatArray());
+		__m128 maxV = LoadPoint(max.ToFloatArray());
+		for(; i + 1 < numPoints; ++i)
+		{
+			__m128 p = _mm_loadu_ps((const F32*)(in + i*stride));
+			minV = _mm_min_ps(minV, p);
+			maxV = _mm_max_ps(maxV, p);
+		}
+		F32 res[4];
+		_mm_storeu_ps(res, minV);
+		min = Vector3(res[0], res[1], res[2]);
+		_mm_storeu_ps(res, maxV);
+		max = Vector3(res[0], res[1], res[2]);
+	}
+#endif
+	F32 minX = min.X(), minY = min.Y(), minZ = min.Z();
+	F32 maxX = max.X(), maxY = max.Y(), maxZ = max.Z();
+	for(; i < numPoints; ++i)
+	{
+		const F32* p = (const F32*)(in + i*stride);
+		minX = Math::Min(minX, p[0]);
+		minY = Math::Min(minY, p[1]);
+		minZ = Math::Min(minZ, p[2]);
+		maxX = Math::Max(maxX, p[0]);
+		maxY = Math::Max(maxY, p[1]);
+		maxZ = Math::Max(maxZ, p[2]);
+	}
+	min = Vector3(minX, minY, minZ);
+	max = Vector3(maxX, maxY, maxZ);
+}
+
+void BatchMath::ExpandAABB(const F32* xs, const F32* ys, const F32* zs, U32 numPoints, Vector3& min, Vector3& max)
+{
+	F32 minX = min.X(), minY = min.Y(), minZ = min.Z();
+	F32 maxX = max.X(), maxY = max.Y(), maxZ = max.Z();
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	using namespace Math::SseDetail;
+	__m128 minXV = _mm_set1_ps(minX), minYV = _mm_set1_ps(minY), minZV = _mm_set1_ps(minZ);
+	__m128 maxXV = _mm_set1_ps(maxX), maxYV = _mm_set1_ps(maxY), maxZV = _mm_set1_ps(maxZ);
+	for(; i + 4 <= numPoints; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(xs + i);
+		__m128 y = _mm_loadu_ps(ys + i);
+		__m128 z = _mm_loadu_ps(zs + i);
+		minXV = _mm_min_ps(minXV, x);
+		minYV = _mm_min_ps(minYV, y);
+		minZV = _mm_min_ps(minZV, z);
+		maxXV = _mm_max_ps(maxXV, x);
+		maxYV = _mm_max_ps(maxYV, y);
+		maxZV = _mm_max_ps(maxZV, z);
+	}
+	minX = HorizontalMin(minXV);
+	minY = HorizontalMin(minYV);
+	minZ = HorizontalMin(minZV);
+	maxX = HorizontalMax(maxXV);
+	maxY = HorizontalMax(maxYV);
+	maxZ = HorizontalMax(maxZV);
+#endif
+	for(; i < numPoints; ++i)
+	{
+		minX = Math::Min(minX, xs[i]);
+		minY = Math::Min(minY, ys[i]);
+		minZ = Math::Min(minZ, zs[i]);
+		maxX = Math::Max(maxX, xs[i]);
+		maxY = Math::Max(maxY, ys[i]);
+		maxZ = Math::Max(maxZ, zs[i]);
+	}
+	min = Vector3(minX, minY, minZ);
+	max = Vector3(maxX, maxY, maxZ);
+}
+
+F32 BatchMath::FindBoundingSphere(const Vector3* points, U32 numPoints, Vector3& center, U32 stride)
+{
+	if(numPoints == 0)
+	{
+		center = Vector3::Zero;
+		return 0.0f;
+	}
+	//Start the box on the first point,
+	//otherwise the origin always ends up inside it.
+	Vector3 min = *points;
+	Vector3 max = *points;
+	ExpandAABB(points, numPoints, min, max, stride);
+	center = (min + max) / 2.0f;
+
+	const U8* in = (const U8*)points;
+	F32 maxDistSqr = 0.0f;
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	using namespace Math::SseDetail;
+	if(stride == sizeof(Vector3))
+	{
+		__m128 cX = _mm_set1_ps(center.X()), cY = _mm_set1_ps(center.Y()), cZ = _mm_set1_ps(center.Z());
+		__m128 maxDistV = _mm_setzero_ps();
+		for(; i + 4 <= numPoints; i += 4)
+		{
+			__m128 x, y, z;
+			LoadPoints4(asFloats(points) + 3*i, x, y, z);
+			x = _mm_sub_ps(x, cX);
+			y = _mm_sub_ps(y, cY);
+			z = _mm_sub_ps(z, cZ);
+			__m128 distSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			maxDistV = _mm_max_ps(maxDistV, distSqr);
+		}
+		maxDistSqr = HorizontalMax(maxDistV);
+	}
+#endif
+	for(; i < numPoints; ++i)
+	{
+		const F32* p = (const F32*)(in + i*stride);
+		F32 x = p[0] - center.X();
+		F32 y = p[1] - center.Y();
+		F32 z = p[2] - center.Z();
+		maxDistSqr = Math::Max(maxDistSqr, x*x + y*y + z*z);
+	}
+	return sqrtf(maxDistSqr);
+}
+
+void BatchMath::NormalizeVectors(const Vector3* vecs, Vector3* results, U32 numVecs)
+{
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	using namespace Math::SseDetail;
+	const F32* in = asFloats(vecs);
+	F32* out = asFloats(results);
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	for(; i + 4 <= numVecs; i += 4)
+	{
+		__m128 x, y, z;
+		LoadPoints4(in + 3*i, x, y, z);
+		__m128 lenSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		//Zero vectors get a scale of 0 instead of infinity.
+		__m128 invLen = _mm_and_ps(	_mm_div_ps(one, _mm_sqrt_ps(lenSqr)),
+									_mm_cmpgt_ps(lenSqr, zero));
+		StorePoints4(out + 3*i, _mm_mul_ps(x, invLen), _mm_mul_ps(y, invLen), _mm_mul_ps(z, invLen));
+	}
+#endif
+	for(; i < numVecs; ++i)
+	{
+		results[i] = vecs[i].GetNormalized();
+	}
+}
+
+void BatchMath::SlerpQuaternions(const Quaternion* from, const Quaternion* to, F32 t, Quaternion* results, U32 numQuats)
+{
+	const F32* inA = asFloats(from);
+	const F32* inB = asFloats(to);
+	F32* out = asFloats(results);
+	U32 i = 0;
+#ifdef ENABLE_SSE
+	__m128 signBit = _mm_set1_ps(-0.0f);
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	for(; i + 4 <= numQuats; i += 4)
+	{
+		//Transpose so each register holds one component of all four quaternions.
+		__m128 ax = _mm_loadu_ps(inA + 4*i);
+		__m128 ay = _mm_loadu_ps(inA + 4*i + 4);
+		__m128 az = _mm_loadu_ps(inA + 4*i + 8);
+		__m128 aw = _mm_loadu_ps(inA + 4*i + 12);
+		_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+		__m128 bx = _mm_loadu_ps(inB + 4*i);
+		__m128 by = _mm_loadu_ps(inB + 4*i + 4);
+		__m128 bz = _mm_loadu_ps(inB + 4*i + 8);
+		__m128 bw = _mm_loadu_ps(inB + 4*i + 12);
+		_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+		__m128 cosTheta = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+										_mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+		//q and -q are the same rotation;
+		//flip the end quaternion where needed to take the short way around.
+		__m128 flip = _mm_and_ps(_mm_cmplt_ps(cosTheta, zero), signBit);
+		cosTheta = _mm_xor_ps(cosTheta, flip);
+		bx = _mm_xor_ps(bx, flip);
+		by = _mm_xor_ps(by, flip);
+		bz = _mm_xor_ps(bz, flip);
+		bw = _mm_xor_ps(bw, flip);
+
+		//There's no SSE trig, so the weights are found per lane.
+		F32 cosLanes[4], fromWeights[4], toWeights[4];
+		_mm_storeu_ps(cosLanes, cosTheta);
+		for(U32 j = 0; j < 4; ++j)
+		{
+			slerpWeights(cosLanes[j], t, fromWeights[j], toWeights[j]);
+		}
+		__m128 wA = _mm_loadu_ps(fromWeights);
+		__m128 wB = _mm_loadu_ps(toWeights);
+		__m128 rx = _mm_add_ps(_mm_mul_ps(ax, wA), _mm_mul_ps(bx, wB));
+		__m128 ry = _mm_add_ps(_mm_mul_ps(ay, wA), _mm_mul_ps(by, wB));
+		__m128 rz = _mm_add_ps(_mm_mul_ps(az, wA), _mm_mul_ps(bz, wB));
+		__m128 rw = _mm_add_ps(_mm_mul_ps(aw, wA), _mm_mul_ps(bw, wB));
+		//Renormalize; needed for the lerp case, and cleans up rounding error otherwise.
+		__m128 lenSqr = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)),
+									_mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw)));
+		__m128 invLen = _mm_div_ps(one, _mm_sqrt_ps(lenSqr));
+		rx = _mm_mul_ps(rx, invLen);
+		ry = _mm_mul_ps(ry, invLen);
+		rz = _mm_mul_ps(rz, invLen);
+		rw = _mm_mul_ps(rw, invLen);
+		_MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+		_mm_storeu_ps(out + 4*i, rx);
+		_mm_storeu_ps(out + 4*i + 4, ry);
+		_mm_storeu_ps(out + 4*i + 8, rz);
+		_mm_storeu_ps(out + 4*i + 12, rw);
+	}
+#endif
+	for(; i < numQuats; ++i)
+	{
+		const F32* a = inA + 4*i;
+		const F32* b = inB + 4*i;
+		F32 cosTheta = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+		F32 sign = 1.0f;
+		if(cosTheta < 0.0f)
+		{
+			cosTheta = -cosTheta;
+			sign = -1.0f;
+		}
+		F32 wA, wB;
+		slerpWeights(cosTheta, t, wA, wB);
+		wB *= sign;
+		F32 res[4];
+		F32 lenSqr = 0.0f;
+		for(U32 j = 0; j < 4; ++j)
+		{
+			res[j] = a[j] * wA + b[j] * wB;
+			lenSqr += res[j] * res[j];
+		}
+		F32 invLen = 1.0f / sqrtf(lenSqr);
+		for(U32 j = 0; j < 4; ++j)
+		{
+			out[4*i + j] = res[j] * invLen;
+		}
+	}
+}
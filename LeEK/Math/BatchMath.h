@@ -0,0 +1,60 @@
+#pragma once
+#include "Datatypes.h"
+#include "Vector3.h"
+#include "Quaternion.h"
+#include "Matrix4x4.h"
+
+namespace LeEK
+{
+	/**
+	Math on whole arrays of vectors and quaternions at once,
+	for bulk data like vertex buffers and animation poses.
+	Each function has a SIMD path that works on several elements per step,
+	so prefer these over looping on the single-element operations.
+	Arrays can be passed in either as arrays of Vector3 (AoS),
+	or as separate X, Y and Z float arrays (SoA); the SoA versions are faster.
+	Unless noted, outputs may be the same arrays as the inputs.
+	*/
+	namespace BatchMath
+	{
+		/**
+		Transforms points the same way Matrix4x4::MultiplyPoint() does.
+		*/
+		void TransformPoints(const Matrix4x4& m, const Vector3* points, Vector3* results, U32 numPoints);
+		void TransformPoints(	const Matrix4x4& m, const F32* xs, const F32* ys, const F32* zs,
+								F32* outXs, F32* outYs, F32* outZs, U32 numPoints);
+		/**
+		Transforms direction vectors the same way Matrix4x4::MultiplyVector() does;
+		translation is ignored.
+		*/
+		void TransformVectors(const Matrix4x4& m, const Vector3* vecs, Vector3* results, U32 numVecs);
+
+		/**
+		Expands an axis aligned bounding box to contain the given points.
+		The box isn't reset first, so initialize min and max before calling.
+		@param stride the distance in bytes between each point,
+		so points can be read directly out of an array of vertices.
+		*/
+		void ExpandAABB(const Vector3* points, U32 numPoints, Vector3& min, Vector3& max, U32 stride = sizeof(Vector3));
+		void ExpandAABB(const F32* xs, const F32* ys, const F32* zs, U32 numPoints, Vector3& min, Vector3& max);
+		/**
+		Finds a sphere enclosing the given points.
+		The sphere's centered on the points' bounding box, so it isn't the tightest fit,
+		but it's found in two linear passes.
+		@return the sphere's radius, or 0 if there are no points.
+		*/
+		F32 FindBoundingSphere(const Vector3* points, U32 numPoints, Vector3& center, U32 stride = sizeof(Vector3));
+
+		/**
+		Normalizes vectors. As with Vector3::Normalize(), zero vectors stay zero.
+		*/
+		void NormalizeVectors(const Vector3* vecs, Vector3* results, U32 numVecs);
+
+		/**
+		Spherically interpolates each pair of quaternions in from and to
+		by the same amount t, taking the shortest path between them.
+		The inputs should be unit quaternions; the results are normalized.
+		*/
+		void SlerpQuaternions(const Quaternion* from, const Quaternion* to, F32 t, Quaternion* results, U32 numQuats);
+	}
+}
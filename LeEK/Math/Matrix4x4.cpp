@@ -198,29 +198,33 @@ Matrix4x4 Matrix4x4::Adjoint() const
 
 Matrix4x4 Matrix4x4::FindInverse() const
 {
-	//Cramer's rule: inverse = adjoint / determinant
-	float det = Determinant();
+	//Cofactor expansion, done in one pass in Math::Mat4Inverse()
+	//rather than through Adjoint() and Determinant(),
+	//which rebuild every 3x3 submatrix.
+	Matrix4x4 result;
+	F32 det = Math::Mat4Inverse(values, result.values);
 
 	//if matrix can't be inverted, return a zero matrix
 	if(Math::ApproxEqual(det, 0.0f))
 	{
 		return Matrix4x4::Zero;
 	}
-
-	//otherwise, calculate the inverse
-	return Adjoint() / det;
+	return result;
 }
 
 Matrix4x4 Matrix4x4::GetTransformInverse() const
 {
-	Matrix3x3 rotComponent = this->GetRotationSubmatrix();
-	rotComponent.Transpose();
-	Vector3 transComponent = this->GetTranslateComponent();
-	transComponent = -rotComponent.Multiply(transComponent);
-	Matrix4x4 result = Matrix4x4(rotComponent, transComponent);
+	Matrix4x4 result;
+	Math::Mat4TransformInverse(values, result.values);
 	return result;
 }
 
+void Matrix4x4::MultiplyPoints(const Vector3* points, Vector3* results, U32 numPoints) const
+{
+	static_assert(sizeof(Vector3) == 3*sizeof(F32), "Vector3 isn't a packed float triple; fix MultiplyPoints()!");
+	Math::Mat4TransformPoints(values, (const F32*)points, (F32*)results, numPoints);
+}
+
 #pragma region Matrix Building Functions
 Matrix4x4 Matrix4x4::BuildTranslation(F32 x, F32 y, F32 z) 
 {
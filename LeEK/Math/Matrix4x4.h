@@ -4,6 +4,7 @@
 //#include "Vector3.h"
 #include "Matrix3x3.h"
 #include "Vector4.h"
+#include "SimdKernels.h"
 #include "Strings/String.h"
 
 //4x4 matrix.
@@ -76,25 +77,7 @@ namespace LeEK
 		inline Matrix4x4& operator*=(const Matrix4x4& rhs)
 		{
 			//PROFILE("MatrixMult");
-			Matrix4x4 result = Matrix4x4::Zero;
-			for(U32 i = 0; i < MATRIX_SIZE; i++)
-			{
-				for(U32 j = 0; j < MATRIX_SIZE; j++)
-				{
-					//F32 temp = (*this)(i, j);
-					//(*this)(i, j) = 0.0f;
-					for(U32 k = 0; k < MATRIX_SIZE; k++)
-					{
-						result(i, j) += (*this)(i, k) * rhs(k, j);
-					}
-					//(*this)(i, j) =	(*this)(i, 0) * const_cast<Matrix4x4&>(rhs)(0, j) + 
-					//				(*this)(i, 1) * const_cast<Matrix4x4&>(rhs)(1, j) +
-					//				(*this)(i, 2) * const_cast<Matrix4x4&>(rhs)(2, j) +
-					//				(*this)(i, 3) * const_cast<Matrix4x4&>(rhs)(3, j);
-				}
-			}
-			*this = result;
-
+			Math::Mat4Multiply(values, rhs.values, values);
 			return *this;
 		}
 		#pragma endregion
@@ -120,6 +103,11 @@ namespace LeEK
 
 			return Vector3(tempResult.X(), tempResult.Y(), tempResult.Z()) / tempResult.W();
 		}
+		/**
+		Batch version of MultiplyPoint().
+		The results may be written over the source points.
+		*/
+		void MultiplyPoints(const Vector3* points, Vector3* results, U32 numPoints) const;
 		inline Vector3 MultiplyVector(const Vector3& v) const
 		{
 			Vector4 tempResult = Matrix4x4::MultiplyVector4(Vector4(Vector3(v), 0.0f));
@@ -186,20 +174,23 @@ namespace LeEK
 	};
 
 #pragma region Static Operators
-	inline Matrix4x4 operator *(Matrix4x4 lhs, const Matrix4x4& rhs)
+	inline Matrix4x4 operator *(const Matrix4x4& lhs, const Matrix4x4& rhs)
 	{
-		lhs *= rhs;
-		return lhs;
+		Matrix4x4 result = lhs;
+		result *= rhs;
+		return result;
 	}
-	inline Matrix4x4 operator *(Matrix4x4 lhs, const F32 rhs)
+	inline Matrix4x4 operator *(const Matrix4x4& lhs, const F32 rhs)
 	{
-		lhs *= rhs;
-		return lhs;
+		Matrix4x4 result = lhs;
+		result *= rhs;
+		return result;
 	}
-	inline Matrix4x4 operator /(Matrix4x4 lhs, const F32 rhs)
+	inline Matrix4x4 operator /(const Matrix4x4& lhs, const F32 rhs)
 	{
-		lhs /= rhs;
-		return lhs;
+		Matrix4x4 result = lhs;
+		result /= rhs;
+		return result;
 	}
 #pragma endregion
 }
@@ -140,19 +140,16 @@ const {
 
 	//courtesy of Fabian Giesen, 
 	//posted on http://mollyrocket.com/forums/viewtopic.php?t=833&sid=3a84e00a70ccb046cfc87ac39881a3d0
-	Vector3 quatVec = Vector3(x, y, z);
-	Vector3 t = 2.0f * Vector3::Cross(quatVec, v);
-	return v + (w * t) + Vector3::Cross(quatVec, t);
-
-	/*
-	F32 vMult = 2.0f*(x*v.X() + y*v.Y() + z*v.Z());
-	F32 crossMult = 2.0f*w;
-	F32 pMult = crossMult*w - 1.0f;
-
-	return Vector3(	pMult*v.X() + vMult*x + crossMult*(z*v.Y() - y*v.Z()),
-					pMult*v.Y() + vMult*y + crossMult*(x*v.Z() - z*v.X()),
-					pMult*v.Z() + vMult*z + crossMult*(y*v.X() - x*v.Y()));
-	*/
+	//t = 2 * cross(q.xyz, v); v' = v + q.w * t + cross(q.xyz, t)
+	Vector3 result;
+	RotateVectors(&v, &result, 1);
+	return result;
+}
+
+void Quaternion::RotateVectors(const Vector3* vectors, Vector3* results, U32 numVectors) const
+{
+	static_assert(sizeof(Vector3) == 3*sizeof(F32), "Vector3 isn't a packed float triple; fix RotateVectors()!");
+	Math::QuatRotatePoints(&x, (const F32*)vectors, (F32*)results, numVectors);
 }
 
 Quaternion Quaternion::FromEulerAngles(F32 xRads, F32 yRads, F32 zRads)
@@ -3,6 +3,7 @@
 #include "MathFunctions.h"
 #include "Vector3.h"
 #include "Matrix4x4.h"
+#include "SimdKernels.h"
 
 namespace LeEK
 {
@@ -62,20 +63,8 @@ namespace LeEK
 		inline Quaternion& operator *=(const Quaternion& rhs)
 		{
 			//PROFILE("QuatMult");
-			w = w*rhs.w - x*rhs.x - y*rhs.y - z*rhs.z;
-			x = w*rhs.x + x*rhs.w + y*rhs.z - z*rhs.y;
-			y = w*rhs.y - x*rhs.z + y*rhs.w + z*rhs.x;
-			z = w*rhs.z + x*rhs.y - y*rhs.x + z*rhs.w;
-
-			/*Vector3 vRhs = Vector3(rhs.x,rhs.y,rhs.z);
-			Vector3 vLhs = Vector3(x,y,z);
-
-			w = rhs.w*w - vRhs.Dot(vLhs);
-			Vector3 vFinal = rhs.w*vLhs + w*vRhs + vLhs.Cross(vRhs);
-			x = vFinal.X();
-			y = vFinal.Y();
-			z = vFinal.Z();*/
-
+			//x, y, z and w are laid out like a float[4].
+			Math::QuatMultiply(&x, &rhs.x, &x);
 			Normalize();
 
 			return *this;
@@ -158,7 +147,13 @@ namespace LeEK
 #pragma endregion
 
 		Vector3 RotateVector(const Vector3& v) const;
+		/**
+		Batch version of RotateVector().
+		The results may be written over the source vectors.
+		*/
+		void RotateVectors(const Vector3* vectors, Vector3* results, U32 numVectors) const;
 	};
+	static_assert(sizeof(Quaternion) == 4*sizeof(F32), "Quaternion isn't a packed float[4]; fix the SIMD kernel calls!");
 
 	//comparison operators
 	inline bool operator==(const Quaternion& lhs, const Quaternion& rhs){ return	Math::ApproxEqual(const_cast<Quaternion&>(lhs).X(), const_cast<Quaternion&>(rhs).X()) &&
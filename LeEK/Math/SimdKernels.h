@@ -0,0 +1,433 @@
+#pragma once
+#include "Datatypes.h"
+#include "MathFunctions.h"
+#include <xmmintrin.h>
+
+//SSE versions of the kernels are used when the compiler targets SSE;
+//define DISABLE_SSE to force the scalar versions.
+#if !defined(DISABLE_SSE) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define ENABLE_SSE
+#endif
+
+//Builds an _mm_shuffle_ps() mask from lane indices, in lane order
+//(unlike _MM_SHUFFLE(), which takes them in reverse).
+#define L_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+
+namespace LeEK
+{
+	/**
+	Low-level kernels behind the matrix and quaternion classes.
+	These work on raw float arrays so they can be shared by
+	the math classes and by bulk data (transform hierarchies, vertex buffers).
+	Matrices use Matrix4x4's layout - 16 floats, column major,
+	so element (row, col) is at [row + 4*col].
+	Quaternions are 4 floats in (x, y, z, w) order, and points are 3 floats.
+	None of the kernels require aligned pointers, but aligned data avoids
+	loads that straddle cache lines.
+	*/
+	namespace Math
+	{
+#ifdef ENABLE_SSE
+		namespace SseDetail
+		{
+			//2x2 matrix product A*B, with each 2x2 matrix packed as (m00, m01, m10, m11).
+			inline __m128 Mat2Mul(__m128 a, __m128 b)
+			{
+				return _mm_add_ps(	_mm_mul_ps(a, _mm_shuffle_ps(b, b, L_SHUFFLE_MASK(0, 3, 0, 3))),
+									_mm_mul_ps(	_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(1, 0, 3, 2)),
+												_mm_shuffle_ps(b, b, L_SHUFFLE_MASK(2, 1, 2, 1))));
+			}
+			//Adjugate(A) * B.
+			inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+			{
+				return _mm_sub_ps(	_mm_mul_ps(_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(3, 3, 0, 0)), b),
+									_mm_mul_ps(	_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(1, 1, 2, 2)),
+												_mm_shuffle_ps(b, b, L_SHUFFLE_MASK(2, 3, 0, 1))));
+			}
+			//A * Adjugate(B).
+			inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+			{
+				return _mm_sub_ps(	_mm_mul_ps(a, _mm_shuffle_ps(b, b, L_SHUFFLE_MASK(3, 0, 3, 0))),
+									_mm_mul_ps(	_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(1, 0, 3, 2)),
+												_mm_shuffle_ps(b, b, L_SHUFFLE_MASK(2, 1, 2, 1))));
+			}
+			//(a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x, 0) for w = 0 inputs.
+			inline __m128 Cross(__m128 a, __m128 b)
+			{
+				__m128 aYZX = _mm_shuffle_ps(a, a, L_SHUFFLE_MASK(1, 2, 0, 3));
+				__m128 bYZX = _mm_shuffle_ps(b, b, L_SHUFFLE_MASK(1, 2, 0, 3));
+				__m128 res = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+				return _mm_shuffle_ps(res, res, L_SHUFFLE_MASK(1, 2, 0, 3));
+			}
+			inline __m128 LoadPoint(const F32* p)
+			{
+				//Don't read a fourth float; it could be past the end of the array.
+				return _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+			}
+			inline void StorePoint(F32* p, __m128 v)
+			{
+				_mm_storel_pi((__m64*)p, v);
+				_mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+			}
+			//Loads 4 packed points (12 floats) and splits them into
+			//one register per component.
+			inline void LoadPoints4(const F32* p, __m128& x, __m128& y, __m128& z)
+			{
+				//a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+				__m128 a = _mm_loadu_ps(p);
+				__m128 b = _mm_loadu_ps(p + 4);
+				__m128 c = _mm_loadu_ps(p + 8);
+				x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, L_SHUFFLE_MASK(2, 2, 1, 1)), L_SHUFFLE_MASK(0, 3, 0, 2));
+				y = _mm_shuffle_ps(	_mm_shuffle_ps(a, b, L_SHUFFLE_MASK(1, 1, 0, 0)),
+									_mm_shuffle_ps(b, c, L_SHUFFLE_MASK(3, 3, 2, 2)), L_SHUFFLE_MASK(0, 2, 0, 2));
+				z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, L_SHUFFLE_MASK(2, 2, 1, 1)), c, L_SHUFFLE_MASK(0, 2, 0, 3));
+			}
+			//Reverse of LoadPoints4().
+			inline void StorePoints4(F32* p, __m128 x, __m128 y, __m128 z)
+			{
+				_mm_storeu_ps(p, _mm_shuffle_ps(	_mm_shuffle_ps(x, y, L_SHUFFLE_MASK(0, 0, 0, 0)),
+													_mm_shuffle_ps(z, x, L_SHUFFLE_MASK(0, 0, 1, 1)), L_SHUFFLE_MASK(0, 2, 0, 2)));
+				_mm_storeu_ps(p + 4, _mm_shuffle_ps(	_mm_shuffle_ps(y, z, L_SHUFFLE_MASK(1, 1, 1, 1)),
+														_mm_shuffle_ps(x, y, L_SHUFFLE_MASK(2, 2, 2, 2)), L_SHUFFLE_MASK(0, 2, 0, 2)));
+				_mm_storeu_ps(p + 8, _mm_shuffle_ps(	_mm_shuffle_ps(z, x, L_SHUFFLE_MASK(2, 2, 3, 3)),
+														_mm_shuffle_ps(y, z, L_SHUFFLE_MASK(3, 3, 3, 3)), L_SHUFFLE_MASK(0, 2, 0, 2)));
+			}
+			//Horizontal min/max of all 4 lanes.
+			inline F32 HorizontalMin(__m128 v)
+			{
+				v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+				v = _mm_min_ss(v, _mm_shuffle_ps(v, v, L_SHUFFLE_MASK(1, 1, 1, 1)));
+				F32 res;
+				_mm_store_ss(&res, v);
+				return res;
+			}
+			inline F32 HorizontalMax(__m128 v)
+			{
+				v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+				v = _mm_max_ss(v, _mm_shuffle_ps(v, v, L_SHUFFLE_MASK(1, 1, 1, 1)));
+				F32 res;
+				_mm_store_ss(&res, v);
+				return res;
+			}
+		}
+#endif
+
+		/**
+		Multiplies two 4x4 matrices.
+		The result may be the same array as either input.
+		*/
+		inline void Mat4Multiply(const F32* lhs, const F32* rhs, F32* result)
+		{
+#ifdef ENABLE_SSE
+			//Each column of the result is
+			//lhs's columns weighted by the matching column of rhs.
+			__m128 c0 = _mm_loadu_ps(lhs);
+			__m128 c1 = _mm_loadu_ps(lhs + 4);
+			__m128 c2 = _mm_loadu_ps(lhs + 8);
+			__m128 c3 = _mm_loadu_ps(lhs + 12);
+			__m128 res[4];
+			for(U32 j = 0; j < 4; ++j)
+			{
+				const F32* b = rhs + 4*j;
+				__m128 r = _mm_mul_ps(c0, _mm_set1_ps(b[0]));
+				r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+				r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(b[2])));
+				r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(b[3])));
+				res[j] = r;
+			}
+			//Only write out once rhs has been completely read.
+			for(U32 j = 0; j < 4; ++j)
+			{
+				_mm_storeu_ps(result + 4*j, res[j]);
+			}
+#else
+			F32 res[16];
+			for(U32 j = 0; j < 4; ++j)
+			{
+				const F32* b = rhs + 4*j;
+				for(U32 i = 0; i < 4; ++i)
+				{
+					res[i + 4*j] =	lhs[i] * b[0] + lhs[i + 4] * b[1] +
+									lhs[i + 8] * b[2] + lhs[i + 12] * b[3];
+				}
+			}
+			for(U32 i = 0; i < 16; ++i)
+			{
+				result[i] = res[i];
+			}
+#endif
+		}
+
+		/**
+		Inverts a rigid transformation matrix
+		(a rotation block and a translation column, with a bottom row of [0 0 0 1]).
+		The rotation block is assumed to be orthonormal,
+		so it's inverted by transposing it.
+		The result may be the same array as the input.
+		*/
+		inline void Mat4TransformInverse(const F32* m, F32* result)
+		{
+#ifdef ENABLE_SSE
+			__m128 c0 = _mm_loadu_ps(m);
+			__m128 c1 = _mm_loadu_ps(m + 4);
+			__m128 c2 = _mm_loadu_ps(m + 8);
+			__m128 t = _mm_loadu_ps(m + 12);
+			__m128 zero = _mm_setzero_ps();
+			//Transposing with a zero column moves the bottom row's zeroes
+			//into the new columns' last element.
+			_MM_TRANSPOSE4_PS(c0, c1, c2, zero);
+			//New translation is -(R^T * t).
+			__m128 newT = _mm_mul_ps(c0, _mm_shuffle_ps(t, t, L_SHUFFLE_MASK(0, 0, 0, 0)));
+			newT = _mm_add_ps(newT, _mm_mul_ps(c1, _mm_shuffle_ps(t, t, L_SHUFFLE_MASK(1, 1, 1, 1))));
+			newT = _mm_add_ps(newT, _mm_mul_ps(c2, _mm_shuffle_ps(t, t, L_SHUFFLE_MASK(2, 2, 2, 2))));
+			newT = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), newT);
+			_mm_storeu_ps(result, c0);
+			_mm_storeu_ps(result + 4, c1);
+			_mm_storeu_ps(result + 8, c2);
+			_mm_storeu_ps(result + 12, newT);
+#else
+			F32 res[16];
+			for(U32 i = 0; i < 3; ++i)
+			{
+				for(U32 j = 0; j < 3; ++j)
+				{
+					res[i + 4*j] = m[j + 4*i];
+				}
+				res[3 + 4*i] = 0.0f;
+			}
+			for(U32 i = 0; i < 3; ++i)
+			{
+				res[i + 12] = -(res[i] * m[12] + res[i + 4] * m[13] + res[i + 8] * m[14]);
+			}
+			res[15] = 1.0f;
+			for(U32 i = 0; i < 16; ++i)
+			{
+				result[i] = res[i];
+			}
+#endif
+		}
+
+		/**
+		Inverts a general 4x4 matrix.
+		The result may be the same array as the input.
+		@return the matrix's determinant.
+		If this is (approximately) zero, the matrix can't be inverted
+		and the result is left unmodified.
+		*/
+		inline F32 Mat4Inverse(const F32* m, F32* result)
+		{
+#ifdef ENABLE_SSE
+			using namespace SseDetail;
+			//Blockwise inversion on the four 2x2 submatrices
+			//   [ A B ]
+			//   [ C D ]
+			//Inverse(M^T) == Inverse(M)^T, so this works unchanged
+			//on column major data; the "rows" here are our columns.
+			__m128 r0 = _mm_loadu_ps(m);
+			__m128 r1 = _mm_loadu_ps(m + 4);
+			__m128 r2 = _mm_loadu_ps(m + 8);
+			__m128 r3 = _mm_loadu_ps(m + 12);
+			__m128 A = _mm_movelh_ps(r0, r1);
+			__m128 B = _mm_movehl_ps(r1, r0);
+			__m128 C = _mm_movelh_ps(r2, r3);
+			__m128 D = _mm_movehl_ps(r3, r2);
+
+			//Determinants of A, B, C and D, in that order.
+			__m128 detSub = _mm_sub_ps(
+				_mm_mul_ps(	_mm_shuffle_ps(r0, r2, L_SHUFFLE_MASK(0, 2, 0, 2)),
+							_mm_shuffle_ps(r1, r3, L_SHUFFLE_MASK(1, 3, 1, 3))),
+				_mm_mul_ps(	_mm_shuffle_ps(r0, r2, L_SHUFFLE_MASK(1, 3, 1, 3)),
+							_mm_shuffle_ps(r1, r3, L_SHUFFLE_MASK(0, 2, 0, 2))));
+			__m128 detA = _mm_shuffle_ps(detSub, detSub, L_SHUFFLE_MASK(0, 0, 0, 0));
+			__m128 detB = _mm_shuffle_ps(detSub, detSub, L_SHUFFLE_MASK(1, 1, 1, 1));
+			__m128 detC = _mm_shuffle_ps(detSub, detSub, L_SHUFFLE_MASK(2, 2, 2, 2));
+			__m128 detD = _mm_shuffle_ps(detSub, detSub, L_SHUFFLE_MASK(3, 3, 3, 3));
+
+			__m128 D_C = Mat2AdjMul(D, C);
+			__m128 A_B = Mat2AdjMul(A, B);
+			__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+			__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+			__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+			__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+			//det(M) = det(A)det(D) + det(B)det(C) - trace(A#B * D#C).
+			__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+			__m128 tr = _mm_mul_ps(A_B, _mm_shuffle_ps(D_C, D_C, L_SHUFFLE_MASK(0, 2, 1, 3)));
+			tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+			tr = _mm_add_ss(tr, _mm_shuffle_ps(tr, tr, L_SHUFFLE_MASK(1, 1, 1, 1)));
+			tr = _mm_shuffle_ps(tr, tr, L_SHUFFLE_MASK(0, 0, 0, 0));
+			detM = _mm_sub_ps(detM, tr);
+			F32 det;
+			_mm_store_ss(&det, detM);
+			if(ApproxEqual(det, 0.0f))
+			{
+				return det;
+			}
+
+			__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+			X = _mm_mul_ps(X, rDetM);
+			Y = _mm_mul_ps(Y, rDetM);
+			Z = _mm_mul_ps(Z, rDetM);
+			W = _mm_mul_ps(W, rDetM);
+			_mm_storeu_ps(result,		_mm_shuffle_ps(X, Y, L_SHUFFLE_MASK(3, 1, 3, 1)));
+			_mm_storeu_ps(result + 4,	_mm_shuffle_ps(X, Y, L_SHUFFLE_MASK(2, 0, 2, 0)));
+			_mm_storeu_ps(result + 8,	_mm_shuffle_ps(Z, W, L_SHUFFLE_MASK(3, 1, 3, 1)));
+			_mm_storeu_ps(result + 12,	_mm_shuffle_ps(Z, W, L_SHUFFLE_MASK(2, 0, 2, 0)));
+			return det;
+#else
+			//Cofactor expansion, sharing the 2x2 subdeterminants
+			//between cofactors instead of recalculating them per 3x3 submatrix.
+			F32 s0 = m[0] * m[5] - m[4] * m[1];
+			F32 s1 = m[0] * m[6] - m[4] * m[2];
+			F32 s2 = m[0] * m[7] - m[4] * m[3];
+			F32 s3 = m[1] * m[6] - m[5] * m[2];
+			F32 s4 = m[1] * m[7] - m[5] * m[3];
+			F32 s5 = m[2] * m[7] - m[6] * m[3];
+			F32 c5 = m[10] * m[15] - m[14] * m[11];
+			F32 c4 = m[9] * m[15] - m[13] * m[11];
+			F32 c3 = m[9] * m[14] - m[13] * m[10];
+			F32 c2 = m[8] * m[15] - m[12] * m[11];
+			F32 c1 = m[8] * m[14] - m[12] * m[10];
+			F32 c0 = m[8] * m[13] - m[12] * m[9];
+			F32 det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+			if(ApproxEqual(det, 0.0f))
+			{
+				return det;
+			}
+			F32 invDet = 1.0f / det;
+			F32 res[16];
+			res[0] = ( m[5] * c5 - m[6] * c4 + m[7] * c3) * invDet;
+			res[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * invDet;
+			res[2] = ( m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet;
+			res[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * invDet;
+			res[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * invDet;
+			res[5] = ( m[0] * c5 - m[2] * c2 + m[3] * c1) * invDet;
+			res[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet;
+			res[7] = ( m[8] * s5 - m[10] * s2 + m[11] * s1) * invDet;
+			res[8] = ( m[4] * c4 - m[5] * c2 + m[7] * c0) * invDet;
+			res[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * invDet;
+			res[10] = ( m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet;
+			res[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * invDet;
+			res[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * invDet;
+			res[13] = ( m[0] * c3 - m[1] * c1 + m[2] * c0) * invDet;
+			res[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet;
+			res[15] = ( m[8] * s3 - m[9] * s1 + m[10] * s0) * invDet;
+			for(U32 i = 0; i < 16; ++i)
+			{
+				result[i] = res[i];
+			}
+			return det;
+#endif
+		}
+
+		/**
+		Transforms an array of points the same way Matrix4x4::MultiplyPoint() does,
+		treating each point as a row vector with w = 1.
+		The output may be the same array as the input.
+		*/
+		inline void Mat4TransformPoints(const F32* m, const F32* points, F32* result, U32 numPoints)
+		{
+#ifdef ENABLE_SSE
+			using namespace SseDetail;
+			//A row vector picks up each *row* of the matrix,
+			//so transpose the columns once up front.
+			__m128 r0 = _mm_loadu_ps(m);
+			__m128 r1 = _mm_loadu_ps(m + 4);
+			__m128 r2 = _mm_loadu_ps(m + 8);
+			__m128 r3 = _mm_loadu_ps(m + 12);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			for(U32 i = 0; i < numPoints; ++i)
+			{
+				const F32* p = points + 3*i;
+				__m128 res = _mm_add_ps(r3, _mm_mul_ps(r0, _mm_set1_ps(p[0])));
+				res = _mm_add_ps(res, _mm_mul_ps(r1, _mm_set1_ps(p[1])));
+				res = _mm_add_ps(res, _mm_mul_ps(r2, _mm_set1_ps(p[2])));
+				StorePoint(result + 3*i, res);
+			}
+#else
+			for(U32 i = 0; i < numPoints; ++i)
+			{
+				const F32* p = points + 3*i;
+				F32 x = p[0], y = p[1], z = p[2];
+				F32* out = result + 3*i;
+				for(U32 j = 0; j < 3; ++j)
+				{
+					const F32* col = m + 4*j;
+					out[j] = x * col[0] + y * col[1] + z * col[2] + col[3];
+				}
+			}
+#endif
+		}
+
+		/**
+		Multiplies two quaternions (Hamilton product lhs * rhs).
+		The result may be the same array as either input.
+		*/
+		inline void QuatMultiply(const F32* lhs, const F32* rhs, F32* result)
+		{
+#ifdef ENABLE_SSE
+			__m128 a = _mm_loadu_ps(lhs);
+			__m128 b = _mm_loadu_ps(rhs);
+			//Each component of lhs scales a shuffled, sign-flipped copy of rhs.
+			__m128 res = _mm_mul_ps(_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(3, 3, 3, 3)), b);
+			res = _mm_add_ps(res, _mm_mul_ps(	_mm_mul_ps(	_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(0, 0, 0, 0)),
+															_mm_shuffle_ps(b, b, L_SHUFFLE_MASK(3, 2, 1, 0))),
+												_mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f)));
+			res = _mm_add_ps(res, _mm_mul_ps(	_mm_mul_ps(	_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(1, 1, 1, 1)),
+															_mm_shuffle_ps(b, b, L_SHUFFLE_MASK(2, 3, 0, 1))),
+												_mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f)));
+			res = _mm_add_ps(res, _mm_mul_ps(	_mm_mul_ps(	_mm_shuffle_ps(a, a, L_SHUFFLE_MASK(2, 2, 2, 2)),
+															_mm_shuffle_ps(b, b, L_SHUFFLE_MASK(1, 0, 3, 2))),
+												_mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f)));
+			_mm_storeu_ps(result, res);
+#else
+			F32 x = lhs[3]*rhs[0] + lhs[0]*rhs[3] + lhs[1]*rhs[2] - lhs[2]*rhs[1];
+			F32 y = lhs[3]*rhs[1] - lhs[0]*rhs[2] + lhs[1]*rhs[3] + lhs[2]*rhs[0];
+			F32 z = lhs[3]*rhs[2] + lhs[0]*rhs[1] - lhs[1]*rhs[0] + lhs[2]*rhs[3];
+			F32 w = lhs[3]*rhs[3] - lhs[0]*rhs[0] - lhs[1]*rhs[1] - lhs[2]*rhs[2];
+			result[0] = x;
+			result[1] = y;
+			result[2] = z;
+			result[3] = w;
+#endif
+		}
+
+		/**
+		Rotates an array of points by a unit quaternion.
+		The output may be the same array as the input.
+		*/
+		inline void QuatRotatePoints(const F32* q, const F32* points, F32* result, U32 numPoints)
+		{
+#ifdef ENABLE_SSE
+			using namespace SseDetail;
+			//Same formula as Quaternion::RotateVector():
+			//t = 2 * cross(q.xyz, v); v' = v + q.w * t + cross(q.xyz, t)
+			__m128 qVec = _mm_setr_ps(q[0], q[1], q[2], 0.0f);
+			__m128 qW = _mm_set1_ps(q[3]);
+			__m128 two = _mm_set1_ps(2.0f);
+			for(U32 i = 0; i < numPoints; ++i)
+			{
+				__m128 v = LoadPoint(points + 3*i);
+				__m128 t = _mm_mul_ps(two, Cross(qVec, v));
+				__m128 res = _mm_add_ps(v, _mm_mul_ps(qW, t));
+				res = _mm_add_ps(res, Cross(qVec, t));
+				StorePoint(result + 3*i, res);
+			}
+#else
+			F32 qx = q[0], qy = q[1], qz = q[2], qw = q[3];
+			for(U32 i = 0; i < numPoints; ++i)
+			{
+				const F32* v = points + 3*i;
+				F32 vx = v[0], vy = v[1], vz = v[2];
+				F32 tx = 2.0f * (qy*vz - qz*vy);
+				F32 ty = 2.0f * (qz*vx - qx*vz);
+				F32 tz = 2.0f * (qx*vy - qy*vx);
+				F32* out = result + 3*i;
+				out[0] = vx + qw*tx + (qy*tz - qz*ty);
+				out[1] = vy + qw*ty + (qz*tx - qx*tz);
+				out[2] = vz + qw*tz + (qx*ty - qy*tx);
+			}
+#endif
+		}
+	}
+}
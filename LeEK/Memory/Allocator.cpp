@@ -10,6 +10,7 @@
 #include "FileManagement/DataStream.h"
 #include "Time/DateTime.h"
 #include <cstdio>
+#include <mutex>
 using namespace LeEK;
 
 //tracking system constants
@@ -62,10 +63,21 @@ bool verboseDump = false;
 const U32 SUMMARY_MAX = 1024;
 char allocSummary[SUMMARY_MAX];
 
+//Resources can be decoded on worker threads,
+//so the heaps and the tracking tables are guarded by this.
+//It's recursive since aligned allocs call back into _CustomMalloc.
+std::recursive_mutex& allocMutex()
+{
+	//function static, so it's built before any global allocates through it
+	static std::recursive_mutex mutex;
+	return mutex;
+}
+
 //stats
 //move these to AllocStats!
 F64 peakAllocsKb = 0;
 F64 totAllocsKb = 0;
+U64 numAllocs = 0;
 
 extern void* operator new(size_t, void* ptr, custom_tag)
 {
@@ -146,6 +158,7 @@ U32 getPtrHash(void* ptr)
 
 void registerAlloc(void* ptr, size_t size, U32 category, const char* desc, const char* file, U32 line)
 {
+	++numAllocs;
 	AllocDesc* alloc = (AllocDesc*)allocDescHeap.Malloc(sizeof(AllocDesc));
 	alloc->Ptr = ptr;
 	alloc->Size = size;
@@ -221,6 +234,7 @@ void unregisterAlloc(void* ptr)
 
 void* Allocator::_CustomMalloc(size_t size, U32 allocType, const char* desc, const char* file, U32 line)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	void* result = heap.Malloc(size);
 	//do any needed bookkeeping here
 	registerAlloc(result, size, allocType, desc, file, line);
@@ -230,6 +244,7 @@ void* Allocator::_CustomMalloc(size_t size, U32 allocType, const char* desc, con
 
 void* Allocator::_CustomRealloc(void* target, size_t newSize, const char* file, U32 line)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	void* result = heap.Realloc(target, newSize);
 	//do any needed bookkeeping here
 	updateAlloc(target, result, newSize, file, line);
@@ -238,6 +253,7 @@ void* Allocator::_CustomRealloc(void* target, size_t newSize, const char* file,
 
 void Allocator::_CustomFree(void* target)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	unregisterAlloc(target);
 	heap.Free(target);
 	target = NULL;
@@ -260,6 +276,7 @@ void* Allocator::_AlignedMalloc(size_t size, size_t alignment, U32 allocType, co
 
 void* Allocator::_AlignedRealloc(void* target, size_t newSize, size_t alignment, const char* file, U32 line)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	//Get the old alloc's info.
 	auto allocData = getAlloc(target);
 	U32 allocType = allocData->Tag->Category;
@@ -281,6 +298,7 @@ void Allocator::_AlignedFree(void* target)
 //returns all unused memory to the OS.
 void Allocator::Purge()
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	//The heap layers also need to inform the handle system of purged regions.
 	heap.Purge();
 	bulletHeap.Purge();
@@ -292,6 +310,7 @@ void Allocator::Purge()
 #pragma region External Hooks
 void* Allocator::BulletMalloc(size_t size)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	void* result = bulletHeap.Malloc(size);
 	//do any needed bookkeeping here
 	registerAlloc(result, size, BULLET_ALLOC, "BulletAlloc", "BulletLibrary", 0);
@@ -301,12 +320,14 @@ void* Allocator::BulletMalloc(size_t size)
 
 void Allocator::BulletFree(void* target)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	unregisterAlloc(target);
 	bulletHeap.Free(target);
 }
 
 void* Allocator::STLStrMalloc(size_t size)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	void* result = strHeap.Malloc(size);
 	//do any needed bookkeeping here
 	registerAlloc(result, size, STRING_ALLOC, "STLStrAlloc", "STL", 0);
@@ -316,12 +337,14 @@ void* Allocator::STLStrMalloc(size_t size)
 
 void Allocator::STLStrFree(void* target)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	unregisterAlloc(target);
 	strHeap.Free(target);
 }
 
 void* Allocator::STLMalloc(size_t size)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	void* result = stlHeap.Malloc(size);
 	//do any needed bookkeeping here
 	registerAlloc(result, size, AllocType::STLHOOK_ALLOC, "STLHookAlloc", "STL", 0);
@@ -331,6 +354,7 @@ void* Allocator::STLMalloc(size_t size)
 
 void Allocator::STLFree(void* target, size_t freedSize)
 {
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
 	unregisterAlloc(target);
 	stlHeap.Free(target);
 }
@@ -464,4 +488,10 @@ F64 Allocator::TotalMemoryAllocated()
 F64 Allocator::PeakMemoryAllocated()
 {
 	return peakAllocsKb;
+}
+
+U64 Allocator::NumAllocations()
+{
+	std::lock_guard<std::recursive_mutex> lock(allocMutex());
+	return numAllocs;
 }
\ No newline at end of file
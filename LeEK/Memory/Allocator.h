@@ -105,6 +105,10 @@ namespace LeEK
 		*/
 		static F64 TotalMemoryAllocated();
 		static F64 PeakMemoryAllocated();
+		/**
+		Returns the number of engine allocations made so far, freed or not.
+		*/
+		static U64 NumAllocations();
 	};
 
 	//shortcut defines
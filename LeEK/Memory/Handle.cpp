@@ -1,6 +1,7 @@
 #include "Handle.h"
 #include "DebugUtils/Assertions.h"
 #include "DataStructures/STLContainers.h"
+#include <mutex>
 
 using namespace LeEK;
 
@@ -9,6 +10,41 @@ Vector<void*> handleMap = Vector<void*>();
 //typedef Vector<void*>::const_iterator ConstMapIt;
 Handle nextHnd = 1;
 
+//Only set by tools that use handles from several threads;
+//the engine dereferences handles every frame, and shouldn't pay for a lock.
+bool threadSafe = false;
+
+//Guards the handle map while threadSafe is set.
+//Recursive since RegisterPtr() goes through FindHandle().
+std::recursive_mutex& handleMutex()
+{
+	//function static, so it's built before any global registers a handle
+	static std::recursive_mutex mutex;
+	return mutex;
+}
+
+//Locks the handle map for its lifetime, if thread safety's on.
+class HandleLock
+{
+private:
+	bool locked;
+public:
+	HandleLock() : locked(threadSafe)
+	{
+		if(locked)
+		{
+			handleMutex().lock();
+		}
+	}
+	~HandleLock()
+	{
+		if(locked)
+		{
+			handleMutex().unlock();
+		}
+	}
+};
+
 Handle nextHandle()
 {
 	L_ASSERT(nextHnd != MAX_HND);
@@ -37,8 +73,14 @@ void setHnd(Handle hnd, void* ptr)
 	handleMap[hnd - 1] = ptr;
 }
 
+void HandleMgr::SetThreadSafe(bool enabled)
+{
+	threadSafe = enabled;
+}
+
 void* HandleMgr::GetPointer(const Handle& hnd)
 {
+	HandleLock lock;
 	if(hnd != 0 && hnd <= handleMap.size())
 	{
 		//Should really fix this -
@@ -53,6 +95,7 @@ void* HandleMgr::GetPointer(const Handle& hnd)
 
 Handle HandleMgr::RegisterPtr(void* ptr)
 {
+	HandleLock lock;
 	if(ptr)
 	{
 		Handle hnd = FindHandle(ptr);//nextHandle();
@@ -72,6 +115,7 @@ Handle HandleMgr::RegisterPtr(void* ptr)
 
 Handle HandleMgr::FindHandle(void* ptr)
 {
+	HandleLock lock;
 	//must do a search of all handles
 	//returns the FIRST handle pointing to given pointer
 	/*
@@ -97,12 +141,14 @@ Handle HandleMgr::FindHandle(void* ptr)
 
 void HandleMgr::RemoveHandle(const Handle& hnd)
 {
+	HandleLock lock;
 	setHnd(hnd, NULL);
 	//handleMap.erase(hnd);
 }
 
 void HandleMgr::RemovePtr(void* ptr)
 {
+	HandleLock lock;
 	for(int i = 0; i < handleMap.size(); ++i)
 	{
 		//If the handle's pointer matches, remove it.
@@ -124,6 +170,7 @@ void HandleMgr::DeleteHandle(const Handle& hnd)
 
 void HandleMgr::MoveHandle(const Handle& hnd, void* newPtr)
 {
+	HandleLock lock;
 	//remove the handle if the new pointer is null?
 	if(hnd != 0 && hnd <= handleMap.size())
 	{
@@ -139,6 +186,7 @@ void HandleMgr::MoveHandle(const Handle& hnd, void* newPtr)
 
 void HandleMgr::NotifyRegionPurged(void* regionStart, size_t regionSize)
 {
+	HandleLock lock;
 	//Iterate through each handle
 	for(int i = 0; i < handleMap.size(); ++i)
 	{
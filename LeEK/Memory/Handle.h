@@ -18,6 +18,9 @@ namespace LeEK
 
 	namespace HandleMgr
 	{
+		//Makes the handle functions lock the handle map, so several threads can use handles at once.
+		//Off by default; set it before starting any threads that use handles.
+		void SetThreadSafe(bool enabled);
 		void* GetPointer(const Handle& hnd);
 		//Handle GetHandle(const void* ptr);
 		Handle RegisterPtr(void* ptr);
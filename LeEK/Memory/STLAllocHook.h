@@ -224,6 +224,97 @@ namespace LeEK
 	  };
 	};
 
+	//Same as STLAllocHook, but allocations are aligned to the given power of 2.
+	//The engine heaps don't guarantee more than word alignment,
+	//so use this for arrays that SIMD code streams through.
+	template <typename T, size_t Alignment = 16> class STLAlignedAllocHook
+	{
+	public:
+		typedef size_t    size_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef T*        pointer;
+		typedef const T*  const_pointer;
+		typedef T&        reference;
+		typedef const T&  const_reference;
+		typedef T         value_type;
+
+		STLAlignedAllocHook() {}
+		STLAlignedAllocHook(const STLAlignedAllocHook&) {}
+		//for rebinds
+		template <typename U>
+		STLAlignedAllocHook(const STLAlignedAllocHook<U, Alignment>&) {}
+		~STLAlignedAllocHook() {}
+
+		template <typename U>
+		struct rebind
+		{
+			typedef STLAlignedAllocHook<U, Alignment> other;
+		};
+
+		inline pointer address(reference x) const
+		{
+			return &x;
+		}
+
+		inline const_pointer address(const_reference x) const
+		{
+			return &x;
+		}
+
+		pointer allocate(size_type size, typename std::allocator<void>::const_pointer hint = 0)
+		{
+			void* vaddress = Allocator::_AlignedMalloc(size*sizeof(T), Alignment, STLHOOK_ALLOC, "STLAlignedAlloc", "STL", 0);
+			if(!vaddress)
+			{
+				throw std::bad_alloc();
+			}
+			return static_cast<pointer>(vaddress);
+		}
+
+		inline void deallocate(pointer p, size_type n)
+		{
+			Allocator::_AlignedFree(p);
+		}
+
+		size_type max_size() const
+		{
+			return size_type(-1);
+		}
+
+		void construct(pointer p, const value_type& val)
+		{
+			new (p) value_type(val);
+		}
+
+		void destroy(pointer p)
+		{
+			p->~T();
+		}
+
+		template<typename U>
+		void destroy(U* p)
+		{
+			p->~U();
+		}
+
+		/// Copy
+		STLAlignedAllocHook& operator=(const STLAlignedAllocHook&)
+		{
+			return *this;
+		}
+		/// Copy with another type
+		template<typename U>
+		STLAlignedAllocHook& operator=(const STLAlignedAllocHook<U, Alignment>&) 
+		{
+			return *this;
+		}
+	};
+
+	template <typename T, size_t Alignment>
+	inline bool operator==(const STLAlignedAllocHook<T, Alignment>&, const STLAlignedAllocHook<T, Alignment>&) { return true; }
+	template <typename T, size_t Alignment>
+	inline bool operator!=(const STLAlignedAllocHook<T, Alignment>&, const STLAlignedAllocHook<T, Alignment>&) { return false; }
+
 	template<typename T>
 	struct STLDeleter
 	{
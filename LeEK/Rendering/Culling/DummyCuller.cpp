@@ -18,7 +18,6 @@ void DummyCuller::Insert(TypedHandle<SpatialNode> node,
 
 void DummyCuller::OnSceneNodeAdded(TypedHandle<SpatialNode> newNode)
 {
-	newNode->OnInsert();
 	allMdls.push_back(VisibleElement(newNode, newNode->FindGlobalShaders()));
 }
 
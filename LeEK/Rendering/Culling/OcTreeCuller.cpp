@@ -45,7 +45,6 @@ void OcTreeCuller::OnSceneNodeAdded(TypedHandle<SpatialNode> newNode)
 	{
 		return;
 	}
-	newNode->OnInsert();
 	VisibleElement newElem = VisibleElement(newNode, newNode->FindGlobalShaders());
 	SpatialOcTree::Node* treeNode = ocTree.Insert(newElem);
 	if(!treeNode)
@@ -6,8 +6,14 @@
 #include FT_FREETYPE_H
 #include <freetype/ftmodapi.h>
 #include "GraphicsWrappers/IGraphicsWrapper.h"
-#include "DataStructures/BinaryTree.h"
+#include "DataStructures/SkylinePacker.h"
 #include "DataStructures/STLContainers.h"
+#include "FileManagement/Filesystem.h"
+#include "FileManagement/DataStream.h"
+#include "Strings/StringUtils.h"
+#include "Libraries/MurmurHash3/MurmurHash3.h"
+#include <cmath>
+#include <algorithm>
 
 using namespace LeEK;
 	
@@ -55,421 +61,845 @@ void shutdownFreeType()
 {
 	//FT_Done_Library(freeType);
 }
-#pragma endregion
-
-typedef std::pair<GlyphElem, GlyphInfo&> GlyphPair;
-
-//dummy vars for references
-GlyphInfo invalidInfo;
 
-struct GlyphData
+//Loads the default face of a font at the given size.
+FT_Face openFace(const char* fontFile, U32 fileSize, U32 pixelSize)
 {
-public:
-	GlyphInfo* Info;
-	unsigned char* Bitmap;
-
-	GlyphData(GlyphInfo& info, unsigned char* bitmap) :
-		Info(&info), Bitmap(bitmap) {}
-	GlyphData() :
-		Info(NULL), Bitmap(NULL) {}
-	GlyphData(const GlyphData& copy) : 
-		Info(copy.Info), Bitmap(copy.Bitmap) {}
-
-	GlyphData& operator= (const GlyphData& copy)
+	if(!ftReady)
 	{
-		if(this == &copy)
+		if(!initFreeType())
 		{
-			return *this;
+			LogE("Failed to initialize FreeType!");
+			return NULL;
 		}
-		//assign stuff
-		Info = copy.Info;
-		Bitmap = copy.Bitmap;
-		return *this;
+		ftReady = true;
 	}
-};
 
-GlyphData invalidGData = GlyphData();
+	FT_Face face;
+	FT_Error err = FT_New_Memory_Face(freeType, (const FT_Byte*)(const void*)fontFile, fileSize - 1, 0, &face);
+	if(err)
+	{
+		LogE("Failed to load font!");
+		return NULL;
+	}
 
-typedef Vector<GlyphData> GlyphDataArray;
+	//setup desired char size
+	err = FT_Set_Pixel_Sizes(face, 0, pixelSize);
+	if(err)
+	{
+		LogE("Failed to set font size!");
+		FT_Done_Face(face);
+		return NULL;
+	}
+	return face;
+}
+#pragma endregion
 
-//Gets the larger side of a glyph's bounding box.
-U32 maxSide(const GlyphInfo* gi)
+#pragma region Distance Fields
+//Glyphs are rendered this many times larger than the base size,
+//and their distance fields sampled back down, so edges can land between base pixels.
+const I32 SDF_OVERSAMPLE = 4;
+//Coverage at or above this counts as inside the glyph.
+const U8 INSIDE_THRESHOLD = 128;
+//Gap left between glyph cells, so bilinear filtering doesn't pick up their neighbors.
+const U32 CELL_PADDING = 1;
+//Smallest atlas side tried.
+const U32 MIN_ATLAS_SIZE = 64;
+const F32 EDT_INF = 1e20f;
+
+I32 floorDiv(I32 num, I32 denom)
 {
-	return Math::Max(gi->Dimensions.Width(), gi->Dimensions.Height());
+	return num >= 0 ? num / denom : -((-num + denom - 1) / denom);
 }
 
-U32 area(const GlyphInfo* gi)
+I32 ceilDiv(I32 num, I32 denom)
 {
-	return gi->Dimensions.Width() * gi->Dimensions.Height();
+	return -floorDiv(-num, denom);
 }
 
-//Sorts a list of glyphs by desending maximum side.
-bool reverseSort(const GlyphData& left, const GlyphData& right)
+//Felzenszwalb and Huttenlocher's squared distance transform of a single row or column.
+//v and z are scratch space; z needs n + 1 elements.
+void distanceTransform1D(const F32* f, I32 n, F32* d, I32* v, F32* z)
 {
-	return maxSide(left.Info) > maxSide(right.Info);
+	I32 k = 0;
+	v[0] = 0;
+	z[0] = -EDT_INF;
+	z[1] = EDT_INF;
+	for(I32 q = 1; q < n; ++q)
+	{
+		F32 s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		while(s <= z[k])
+		{
+			--k;
+			s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		}
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = EDT_INF;
+	}
+	k = 0;
+	for(I32 q = 0; q < n; ++q)
+	{
+		while(z[k + 1] < q)
+		{
+			++k;
+		}
+		d[q] = (F32)((q - v[k]) * (q - v[k])) + f[v[k]];
+	}
 }
 
-//node used for packing glyphs into a texture.
-class GlyphNode : public BTreeNode
+//Replaces every pixel with its squared distance to the nearest pixel that's 0.
+void distanceTransform2D(F32* grid, I32 width, I32 height)
 {
-private:
-	IntRectangle texRegion;
-	GlyphData& gData;
-	bool inUse;
-public:
-	GlyphNode(GlyphNode* parent, const IntRectangle& texRegionParam) : 
-		texRegion(texRegionParam), gData(invalidGData), inUse(false)
+	I32 maxLen = Math::Max(width, height);
+	Vector<F32> f, d, z;
+	Vector<I32> v;
+	f.resize(maxLen);
+	d.resize(maxLen);
+	z.resize(maxLen + 1);
+	v.resize(maxLen);
+	for(I32 x = 0; x < width; ++x)
 	{
-		Parent = parent;
+		for(I32 y = 0; y < height; ++y)
+		{
+			f[y] = grid[y * width + x];
+		}
+		distanceTransform1D(&f[0], height, &d[0], &v[0], &z[0]);
+		for(I32 y = 0; y < height; ++y)
+		{
+			grid[y * width + x] = d[y];
+		}
 	}
-	~GlyphNode() {}
-
-	//Returns the region used by the texture in PIXELS.
-	inline const IntRectangle& GetTexRegion() const { return texRegion; }
-
-	/*inline const GlyphElem GetGlyph() const { return glyph; }
-	void SetGlyph(GlyphElem val) { glyph = val; }
+	for(I32 y = 0; y < height; ++y)
+	{
+		F32* row = grid + (y * width);
+		distanceTransform1D(row, width, &d[0], &v[0], &z[0]);
+		memcpy(row, &d[0], width * sizeof(F32));
+	}
+}
+#pragma endregion
 
-	inline char* GetBitmap() const { return bitmap; }
-	void SetBitmap(char* ptr) { bitmap = ptr; }*/
+//A glyph's metrics, and its distance field at the base size.
+struct GlyphField
+{
+	FontGlyph Glyph;
+	Vector<U8> Field;
+};
 
-	const GlyphData& GetGlyphData() const { return gData; }
-	void SetGlyphData(const GlyphData& val) { gData = val; }
+//Orders glyph cells tallest first, which is what the skyline packer does best with.
+struct tallerCell
+{
+	const Vector<GlyphField>& fields;
 
-	inline bool InUse() const { return inUse; }
-	void SetInUse(bool val) { inUse = val; }
+	tallerCell(const Vector<GlyphField>& fieldsParam) : fields(fieldsParam) {}
+	bool operator()(U32 left, U32 right) const
+	{
+		const FontGlyph& l = fields[left].Glyph;
+		const FontGlyph& r = fields[right].Glyph;
+		if(l.Height != r.Height)
+		{
+			return l.Height > r.Height;
+		}
+		return l.Width > r.Width;
+	}
+};
 
-	inline GlyphNode* GetParent() const { return (GlyphNode*)Parent; }
-	void SetParent(GlyphNode* val) { Parent = val; }
+bool renderGlyph(FT_Face face, U32 glyph)
+{
+	//render nothing if character isn't in font
+	L_ASSERT(face->charmap);
+	FT_UInt glInd = FT_Get_Char_Index(face, glyph);
+	FT_Error err = FT_Load_Glyph(face, glInd, FT_LOAD_RENDER);
+	if(err)
+	{
+		LogE(String("Couldn't load character ") + glyph + "!");
+		return false;
+	}
+	if(glInd == 0)
+	{
+		return false;
+	}
+	return true;
+}
 
-	inline GlyphNode* GetRight() const { return (GlyphNode*)Right; }
-	void SetRight(GlyphNode* val) { Right = val; }
+/**
+Turns the glyph in the slot, rendered at SDF_OVERSAMPLE times the base size,
+into a distance field at the base size.
+The field's 128 on the glyph's edge, rising inside it and falling outside it,
+and reaches 0 and 255 spread pixels away from the edge.
+*/
+void buildGlyphField(FT_GlyphSlot gs, I32 spread, GlyphField& out)
+{
+	const FT_Bitmap& bmp = gs->bitmap;
+	FontGlyph& glyph = out.Glyph;
+	//advances are listed in 1/64 of pixels
+	glyph.AdvanceX = (F32)gs->advance.x / (64 * SDF_OVERSAMPLE);
+	glyph.AdvanceY = (F32)gs->advance.y / (64 * SDF_OVERSAMPLE);
+	if(bmp.width == 0 || bmp.rows == 0)
+	{
+		return;
+	}
 
-	inline GlyphNode* GetDown() const { return (GlyphNode*)Left; }
-	void SetDown(GlyphNode* val) { Left = val; }
-};
+	//snap the cell to base pixels, then add the spread around it
+	const I32 left = gs->bitmap_left;
+	const I32 top = gs->bitmap_top;
+	const I32 bmpWidth = bmp.width;
+	const I32 bmpHeight = bmp.rows;
+	const I32 minX = floorDiv(left, SDF_OVERSAMPLE);
+	const I32 maxX = ceilDiv(left + bmpWidth, SDF_OVERSAMPLE);
+	const I32 minY = floorDiv(top - bmpHeight, SDF_OVERSAMPLE);
+	const I32 maxY = ceilDiv(top, SDF_OVERSAMPLE);
+	glyph.Width = (maxX - minX) + (2 * spread);
+	glyph.Height = (maxY - minY) + (2 * spread);
+	glyph.BearingX = minX - spread;
+	glyph.BearingY = maxY + spread;
+
+	//lay the bitmap out over the oversampled cell, rows going down from the top
+	const I32 hiWidth = glyph.Width * SDF_OVERSAMPLE;
+	const I32 hiHeight = glyph.Height * SDF_OVERSAMPLE;
+	const I32 offsetX = (left - (minX * SDF_OVERSAMPLE)) + (spread * SDF_OVERSAMPLE);
+	const I32 offsetY = ((maxY * SDF_OVERSAMPLE) - top) + (spread * SDF_OVERSAMPLE);
+	Vector<F32> toInside, toOutside;
+	toInside.assign(hiWidth * hiHeight, EDT_INF);
+	toOutside.assign(hiWidth * hiHeight, 0);
+	for(I32 y = 0; y < bmpHeight; ++y)
+	{
+		const U8* row = bmp.buffer + (y * bmp.pitch);
+		for(I32 x = 0; x < bmpWidth; ++x)
+		{
+			if(row[x] >= INSIDE_THRESHOLD)
+			{
+				I32 index = ((offsetY + y) * hiWidth) + offsetX + x;
+				toInside[index] = 0;
+				toOutside[index] = EDT_INF;
+			}
+		}
+	}
+	distanceTransform2D(&toInside[0], hiWidth, hiHeight);
+	distanceTransform2D(&toOutside[0], hiWidth, hiHeight);
 
-GlyphNode* newGlyphNode(GlyphNode* parent, const IntRectangle& texRegion)
-{
-	return CustomNew<GlyphNode>(FONT_ALLOC, "FontAlloc", parent, texRegion);
+	//sample the middle of each base pixel
+	out.Field.resize(glyph.Width * glyph.Height);
+	const F32 scale = 1.0f / (2.0f * spread * SDF_OVERSAMPLE);
+	for(U32 y = 0; y < glyph.Height; ++y)
+	{
+		for(U32 x = 0; x < glyph.Width; ++x)
+		{
+			I32 index = (((y * SDF_OVERSAMPLE) + (SDF_OVERSAMPLE / 2)) * hiWidth) + (x * SDF_OVERSAMPLE) + (SDF_OVERSAMPLE / 2);
+			//distances are to pixel centers, and the edge is half a pixel short of those
+			F32 dist = toInside[index] > 0 ?
+						sqrtf(toInside[index]) - 0.5f :
+						0.5f - sqrtf(toOutside[index]);
+			F32 value = Math::Clamp(0.5f - (dist * scale), 0.0f, 1.0f);
+			out.Field[(y * glyph.Width) + x] = (U8)((value * 255) + 0.5f);
+		}
+	}
 }
 
-GlyphNode* findFreeNode(GlyphNode* root, F32 glyphWidth, F32 glyphHeight)
+//Packs the glyph cells, doubling the atlas' shorter side until they all fit.
+bool packGlyphs(Vector<GlyphField>& fields, U32 maxTexSize, U32& widthOut, U32& heightOut)
 {
-	//terminating condition
-	L_ASSERT(root && "Passing null node!");
+	Vector<U32> order;
+	U64 area = 0;
+	for(U32 i = 0; i < fields.size(); ++i)
+	{
+		const FontGlyph& glyph = fields[i].Glyph;
+		if(glyph.Width > 0 && glyph.Height > 0)
+		{
+			order.push_back(i);
+			area += (U64)(glyph.Width + CELL_PADDING) * (glyph.Height + CELL_PADDING);
+		}
+	}
+	std::sort(order.begin(), order.end(), tallerCell(fields));
 
-	const IntRectangle& texRegion = root->GetTexRegion();
-	if(root->InUse())
+	const U32 MAX_TEX_SIZE = Math::NearestPowOf2(maxTexSize);
+	U32 width = MIN_ATLAS_SIZE;
+	U32 height = MIN_ATLAS_SIZE;
+	//no point trying sizes that can't hold the glyphs' area
+	while((U64)width * height < area)
 	{
-		GlyphNode* result = NULL;
-		//check children
-		if(root->GetRight())
+		if(width <= height)
 		{
-			result = findFreeNode(root->GetRight(), glyphWidth, glyphHeight);
+			width <<= 1;
 		}
-		if(!result && root->GetDown())
+		else
 		{
-			result = findFreeNode(root->GetDown(), glyphWidth, glyphHeight);
+			height <<= 1;
 		}
-		return result;
 	}
-	//otherwise, check this node specifically
-	else if(glyphWidth <= texRegion.Width() && glyphHeight <= texRegion.Height())//texRegion.Width() >= glyphWidth && texRegion.Height() >= glyphHeight)
+	SkylinePacker packer;
+	while(width <= MAX_TEX_SIZE && height <= MAX_TEX_SIZE)
 	{
-		return root;
+		packer.Init(width, height);
+		bool packed = true;
+		for(U32 i = 0; i < order.size() && packed; ++i)
+		{
+			//glyphs are packed structs, so their fields can't be passed by reference
+			FontGlyph& glyph = fields[order[i]].Glyph;
+			U32 x = 0, y = 0;
+			packed = packer.Pack(glyph.Width + CELL_PADDING, glyph.Height + CELL_PADDING, x, y);
+			glyph.AtlasX = x;
+			glyph.AtlasY = y;
+		}
+		if(packed)
+		{
+			widthOut = width;
+			heightOut = height;
+			return true;
+		}
+		LogW(String("Couldn't build glyph atlas at size ") + width + "x" + height + ", rebuilding larger");
+		if(width <= height)
+		{
+			width <<= 1;
+		}
+		else
+		{
+			height <<= 1;
+		}
 	}
-	//nothing fits; return null
-	return NULL;
+	LogE("Couldn't pack font glyphs into texture!");
+	return false;
 }
 
-GlyphNode* splitNode(GlyphNode* node, F32 glyphWidth, F32 glyphHeight)
+//Fills in a glyph's drawing info from its place on a page of the given size.
+void setGlyphInfo(GlyphInfo& info, const FontGlyph& glyph, U32 page, F32 texWidth, F32 texHeight)
 {
-	//first, note this node's used
-	node->SetInUse(true);
-	const IntRectangle& texRegion = node->GetTexRegion();
-	//now generate subnodes
-	L_ASSERT(texRegion.Width() >= glyphWidth);
-	IntRectangle rightRegion(	texRegion.MinX() + glyphWidth, texRegion.MinY(), 
-							texRegion.Width() - glyphWidth, glyphHeight);
-	GlyphNode* right = newGlyphNode(node, rightRegion);
-	node->SetRight(right);
+	info.Glyph = glyph.Glyph;
+	info.Page = page;
+	info.Advance = Vector2(glyph.AdvanceX, glyph.AdvanceY);
+	info.Dimensions = IntRectangle(glyph.BearingX, glyph.BearingY, glyph.Width, glyph.Height);
+	info.Descend = Vector2(0, (F32)((I32)glyph.Height - glyph.BearingY));
+	info.TexCoords = LeEK::Rectangle(	glyph.AtlasX / texWidth,
+										1.0f - ((glyph.AtlasY + glyph.Height) / texHeight),
+										glyph.Width / texWidth,
+										glyph.Height / texHeight);
+}
 
-	L_ASSERT(texRegion.Height() >= glyphHeight);
-	IntRectangle downRegion(	texRegion.MinX(), texRegion.MinY() + glyphHeight,
-							texRegion.Width(), texRegion.Height() - glyphHeight);
-	GlyphNode* down = newGlyphNode(node, downRegion);
-	node->SetDown(down);
-	return node;
+Font::Font(void) : textureHandle(0), lineHeight(0), baseSize(0), spread(0), faceData(NULL), face(NULL),
+					useTick(0), layoutVersion(0)
+{
 }
 
-bool renderGlyph(FT_Face face, GlyphElem glyph)
+Font::~Font(void)
 {
-	//render nothing if character isn't in font
-	L_ASSERT(face->charmap);
-	U32 glyphInd = glyph;
-	FT_UInt glInd = FT_Get_Char_Index(face, glyphInd);
-	FT_Error err = FT_Load_Glyph(face, glInd, FT_LOAD_RENDER);
-	if(err)
+	releaseFace();
+}
+
+void Font::Shutdown()
+{
+	resetCache();
+	if(textureHandle != 0)
 	{
-		LogE(String("Couldn't load character ") + glyph + "!");
-		return false;
+		Texture2D tex;
+		tex.TextureBufferHandle = textureHandle;
+		gfx->ShutdownTexture(tex);
+		textureHandle = 0;
 	}
-	if(glInd == 0)
+	releaseFace();
+}
+
+bool Font::loadFace(const char* fontFile, U32 fileSize)
+{
+	releaseFace();
+	//the face reads from the file as glyphs are rendered, so it needs its own copy
+	faceData = CustomArrayNew<char>(fileSize, FONT_ALLOC, "FontAlloc");
+	memcpy(faceData, fontFile, fileSize);
+	face = openFace(faceData, fileSize, baseSize * SDF_OVERSAMPLE);
+	if(!face)
 	{
+		LogW("Couldn't keep font face loaded, only ASCII will be drawn");
+		releaseFace();
 		return false;
 	}
 	return true;
 }
 
-bool initGlyphInfo(FT_Face face, GlyphElem glyph, GlyphInfo& info)
+void Font::releaseFace()
 {
-	if(!renderGlyph(face, glyph))
+	if(face)
 	{
-		//set a null glyph
-		info.Glyph = glyph;
-		FT_GlyphSlot gs = face->glyph;
-		info.Advance = Vector2(gs->advance.x / 64, gs->advance.y / 64);
-		info.Dimensions = IntRectangle(	gs->bitmap_left, 
-										gs->bitmap_top,
-										gs->bitmap.width,
-										gs->bitmap.rows);
-		info.Descend = Vector2::Zero;
-		return true;
+		FT_Done_Face(face);
+		face = NULL;
+	}
+	if(faceData)
+	{
+		CustomArrayDelete(faceData);
+		faceData = NULL;
 	}
-	FT_GlyphSlot gs = face->glyph;
-	FT_Glyph_Metrics gm = gs->metrics;
-	info.Glyph = glyph;
-	//advances are listed in 1/64 of pixels,
-	//so convert back to pixels
-	info.Advance = Vector2(gs->advance.x / 64, gs->advance.y / 64);
-	info.Dimensions = IntRectangle(gs->bitmap_left, gs->bitmap_top,	//set top position
-								gs->bitmap.width,	//set width
-								gs->bitmap.rows);	//set height
-	info.Descend = Vector2(gs->bitmap.width - (gm.vertBearingX / 64), gs->bitmap.rows - (gm.horiBearingY / 64));
-	return true;
 }
 
-//Builds a packed texture atlas for a given set of glyphs.
-//Also assigns texture coordinates to all glyph units.
-bool buildGlyphTextureAndTexCoords(FT_Face face, GfxWrapperHandle gfx, const Texture2D& tex, U32 paddingLen, U32 texWidth, U32 texHeight, GlyphDataArray::iterator glyphDataStart, GlyphDataArray::iterator glyphDataEnd)
+void Font::resetCache()
 {
-	//setup root node for texture
-	GlyphNode* const root = newGlyphNode(	NULL,									//root, so no parent
-									IntRectangle(0, 0, texWidth, texHeight));	//encloses entire texture
-	if(!root)
+	for(U32 i = 0; i < pages.size(); ++i)
 	{
-		LogE("Couldn't build glyph packing tree!");
-		return false;
+		gfx->ShutdownTexture(pages[i].Texture);
 	}
+	pages.clear();
+	glyphCache.clear();
+	ClearLayoutCache();
+	++layoutVersion;
+}
 
-	//now iterate through the list
-	for(GlyphDataArray::iterator it = glyphDataStart; it != glyphDataEnd; ++it)
+bool Font::BuildAtlas(const char* fontFile, U32 fileSize, U32 fontSizePixels, U32 maxTexSize, FontAtlasData& atlasOut)
+{
+	//load the font now, oversampled for the distance field
+	FT_Face face = openFace(fontFile, fileSize, fontSizePixels * SDF_OVERSAMPLE);
+	if(!face)
 	{
-		GlyphInfo* gi = it->Info;
-		GlyphElem glyph = gi->Glyph;
+		return false;
+	}
 
-		//render the text
-		if(!initGlyphInfo(face, glyph, *gi))//renderGlyph(face, glyph))
+	//Render the whole ASCII set, including the invisible characters;
+	//those just get an advance and an empty cell.
+	const U32 spread = FindSpread(fontSizePixels);
+	Vector<GlyphField> fields;
+	fields.resize(NUM_GLYPHS);
+	for(U32 i = 0; i < NUM_GLYPHS; ++i)
+	{
+		FontGlyph& glyph = fields[i].Glyph;
+		memset(&glyph, 0, sizeof(FontGlyph));
+		glyph.Glyph = i;
+		if(renderGlyph(face, i))
 		{
-			return false;
-		}
-		FT_GlyphSlot gSlot = face->glyph;
-		FT_Bitmap gBmap = face->glyph->bitmap;
-		char* bitmap = (char*)gBmap.buffer;
-		
-		F32 gWidth = gi->Dimensions.Width();
-		F32 gHeight = gi->Dimensions.Height();
-
-		//need to include upper and lower padding
-		F32 paddedWidth = gWidth + (2 * paddingLen);
-		F32 paddedHeight = gHeight + (2 * paddingLen);
-
-		//get a node
-		GlyphNode* glyphNode = findFreeNode(root, paddedWidth, paddedHeight);
-		//if we have one, great; set, split and continue.
-		//there should be free nodes in the tree now
-		if(glyphNode)
-		{
-			glyphNode->SetGlyphData(*it);
-			//glyphNode->SetBitmap((char*)it->Bitmap);
-			splitNode(glyphNode, paddedWidth, paddedHeight);
-			
-			//now we can compute the texture coordinates.
-			//remember to normalize the dimensions!
-			const IntRectangle& pixCoords = glyphNode->GetTexRegion();
-			L_ASSERT(gi->Glyph == glyphNode->GetGlyphData().Info->Glyph);
-			gi->TexCoords = LeEK::Rectangle(	(((F32)pixCoords.MinX() + paddingLen) / texWidth), 
-										1.0f - ((F32)(pixCoords.MinY() + paddingLen + gHeight) / texHeight), 
-										(gWidth / texWidth), 
-										(gHeight / texHeight));
-
-			//advances are listed in 1/64 of pixels
-			//gi->Advance.SetX(gSlot->advance.x / 64);
-			//gi->Advance.SetY(gSlot->advance.y / 64);
-
-			//and write to the texture
-			//we need to use padding, so write slightly offset
-			if(!gfx->FillTextureSection(tex, pixCoords.MinX() + paddingLen, pixCoords.MinY() + paddingLen, 
-										gWidth, gHeight,
-										bitmap))
-			{
-				LogE(String("Couldn't write glyph \'") + glyph + "\' to texture!");
-				return false;
-			}
+			buildGlyphField(face->glyph, spread, fields[i]);
 		}
-		//otherwise, this node doesn't fit in the texture at all...
-		//we're boned, cleanup and quit
 		else
 		{
-			LogE("Couldn't pack font glyphs into texture!");
-			DeleteBTree(root);
-			return false;
+			glyph.AdvanceX = (F32)face->glyph->advance.x / (64 * SDF_OVERSAMPLE);
 		}
 	}
-	//Tree should be populated, note success
-	//Don't forget to get rid of the packing tree!
-	DeleteBTree(root);
-	return true;
-}
+	FT_Done_Face(face);
 
-GlyphNode* findGlyphNode(GlyphNode* root, const GlyphData& elem)
-{
-	//quit if this is the node
-	if(root->InUse() && root->GetGlyphData().Info->Glyph == elem.Info->Glyph)
+	U32 texWidth = 0, texHeight = 0;
+	if(!packGlyphs(fields, maxTexSize, texWidth, texHeight))
 	{
-		return root;
+		return false;
 	}
-	//otherwise, search the children
-	else
+
+	Texture2D& tex = atlasOut.Atlas;
+	tex = Texture2D();
+	tex.PixType = Texture2D::BYTE;
+	tex.CompType = Texture2D::NONE;
+	tex.Width = texWidth;
+	tex.Height = texHeight;
+	tex.BitDepth = 8;
+	tex.HasMipMap = false;
+	tex.NumMips = 1;
+	tex.Data = LArrayNew(char, tex.DataSize(), FONT_ALLOC, "FontAlloc");
+	//anything outside a cell is as far from an edge as the field goes
+	memset(tex.Data, 0, tex.DataSize());
+	atlasOut.Glyphs.resize(NUM_GLYPHS);
+	for(U32 i = 0; i < NUM_GLYPHS; ++i)
 	{
-		GlyphNode* result = findGlyphNode(root->GetRight(), elem);
-		if(!result)
+		const GlyphField& field = fields[i];
+		const FontGlyph& glyph = field.Glyph;
+		for(U32 y = 0; y < glyph.Height; ++y)
 		{
-			result = findGlyphNode(root->GetDown(), elem);
+			memcpy(	tex.Data + ((glyph.AtlasY + y) * texWidth) + glyph.AtlasX,
+					&field.Field[y * glyph.Width], glyph.Width);
 		}
-		return result;
+		atlasOut.Glyphs[i] = glyph;
 	}
-	//and return null otherwise
-	return NULL;
+	atlasOut.Key = FontMgr::FindFontKey(fontFile, fileSize, fontSizePixels, spread, maxTexSize);
+	atlasOut.BaseSize = fontSizePixels;
+	atlasOut.Spread = spread;
+	atlasOut.LineHeight = (F32)fontSizePixels;
+	return true;
 }
 
-Font::Font(void) : textureHandle(0), lineHeight(0)
+bool Font::GenerateFromAtlas(const FontAtlasData& atlas, GfxWrapperHandle gfx)
 {
+	const Texture2D& atlasTex = atlas.Atlas;
+	if(!atlasTex.Data || atlasTex.PixType != Texture2D::BYTE || atlas.BaseSize == 0)
+	{
+		LogE("Glyph atlas is empty, or isn't a single channel texture!");
+		return false;
+	}
+	Texture2D tex = gfx->GenerateBlankTexture(atlasTex.Width, atlasTex.Height, Texture2D::BYTE);
+	if(!tex.TextureBufferHandle)
+	{
+		LogE("Couldn't build texture for glyph atlas!");
+		return false;
+	}
+	if(!gfx->FillTextureSection(tex, 0, 0, atlasTex.Width, atlasTex.Height, atlasTex.Data))
+	{
+		LogE("Couldn't write glyph atlas to texture!");
+		gfx->ShutdownTexture(tex);
+		return false;
+	}
+
+	//anything cached belongs to whatever font this was before
+	resetCache();
+	releaseFace();
+	this->gfx = gfx;
+
+	//now we can compute the texture coordinates.
+	//remember to normalize the dimensions!
+	for(U32 i = 0; i < NUM_GLYPHS; ++i)
+	{
+		glyphs[i] = GlyphInfo();
+		glyphs[i].Glyph = (GlyphElem)i;
+	}
+	for(U32 i = 0; i < atlas.Glyphs.size(); ++i)
+	{
+		const FontGlyph& glyph = atlas.Glyphs[i];
+		if(glyph.Glyph >= NUM_GLYPHS)
+		{
+			continue;
+		}
+		setGlyphInfo(glyphs[glyph.Glyph], glyph, 0, (F32)tex.Width, (F32)tex.Height);
+	}
+	textureHandle = tex.TextureBufferHandle;
+	lineHeight = atlas.LineHeight;
+	baseSize = atlas.BaseSize;
+	spread = atlas.Spread;
+	return true;
 }
 
-Font::~Font(void)
+bool Font::GenerateFromMemory(const char* fontFile, GfxWrapperHandle gfx, U32 fileSize, U32 fontSizePixels, U32 maxTexSize)
 {
+	FontAtlasData atlas;
+	if(!BuildAtlas(fontFile, fileSize, fontSizePixels, maxTexSize, atlas))
+	{
+		return false;
+	}
+	bool result = GenerateFromAtlas(atlas, gfx);
+	LArrayDelete(atlas.Atlas.Data);
+	if(result)
+	{
+		loadFace(fontFile, fileSize);
+	}
+	return result;
 }
 
-bool Font::GenerateFromMemory(const char* fontFile, GfxWrapperHandle gfx, U32 fileSize, U32 fontSizePixels, U32 maxTexSize)
+bool Font::GenerateFromMemory(	const char* fontFile, GfxWrapperHandle gfx, U32 fileSize, U32 fontSizePixels, U32 maxTexSize,
+								const Path& cacheDir)
 {
-	if(!ftReady)
+	U64 key = FontMgr::FindFontKey(fontFile, fileSize, fontSizePixels, FindSpread(fontSizePixels), maxTexSize);
+	Path cachePath = Path(cacheDir.ToString() + "/" + FontMgr::FindCacheName(key));
+	if(Filesystem::Exists(cachePath))
 	{
-		if(!initFreeType())
+		DataStream* file = Filesystem::OpenFileReadOnly(cachePath);
+		if(file)
 		{
-			LogE("Failed to initialize FreeType!");
-			return false;
+			FileSz size = file->FileSize();
+			char* buf = CustomArrayNew<char>(Math::Max(size, (FileSz)1), FONT_ALLOC, "FontAlloc");
+			bool read = file->Read(buf, size) == size;
+			Filesystem::CloseFile(file);
+			FontAtlasData atlas;
+			bool result = read && FontMgr::ReadFontInPlace(atlas, buf, size) && atlas.Key == key &&
+							GenerateFromAtlas(atlas, gfx);
+			CustomArrayDelete(buf);
+			if(result)
+			{
+				loadFace(fontFile, fileSize);
+				return true;
+			}
 		}
-		ftReady = true;
+		LogW(String("Couldn't use cached glyph atlas ") + cachePath.ToString() + ", rebuilding it");
 	}
 
-	//load the font now, default face
-	FT_Face face;
-	FT_Error err = FT_New_Memory_Face(freeType, (const FT_Byte*)(const void*)fontFile, fileSize - 1, 0, &face);
-	if(err)
+	FontAtlasData atlas;
+	if(!BuildAtlas(fontFile, fileSize, fontSizePixels, maxTexSize, atlas))
 	{
-		LogE("Failed to load font!");
 		return false;
 	}
+	bool result = GenerateFromAtlas(atlas, gfx);
+	//a cache that can't be written isn't fatal; it just gets built again next time
+	size_t size = FontMgr::FindFileSize(atlas);
+	char* buf = CustomArrayNew<char>(size, FONT_ALLOC, "FontAlloc");
+	if(	!(Filesystem::Exists(cacheDir) || Filesystem::MakeDirectory(cacheDir)) ||
+		!FontMgr::WriteFontMemory(atlas, buf, size) || !Filesystem::WriteFile(cachePath, buf, size))
+	{
+		LogW(String("Couldn't write glyph atlas cache ") + cachePath.ToString());
+	}
+	CustomArrayDelete(buf);
+	LArrayDelete(atlas.Atlas.Data);
+	if(result)
+	{
+		loadFace(fontFile, fileSize);
+	}
+	return result;
+}
 
-	//setup desired char size
-	err = FT_Set_Pixel_Sizes(face, 0, fontSizePixels);
-	if(err)
+bool Font::GenerateFromCache(const char* data, size_t size, GfxWrapperHandle gfx)
+{
+	FontAtlasData atlas;
+	if(!FontMgr::ReadFontInPlace(atlas, data, size))
 	{
-		LogE("Failed to set font size!");
+		LogE("Couldn't read cached glyph atlas!");
 		return false;
 	}
+	return GenerateFromAtlas(atlas, gfx);
+}
 
-	//now we can set general data
-	lineHeight = fontSizePixels;//(F32)(face->height * 4) / 64;
-
-	GlyphDataArray glyphData;
-	
-	//Now render fonts and build their info structs.
-	//Iterate through the ASCII set;
-	//we only need to render the visible set, 33 on.
-	//Space (32) is special; we don't draw it, it just moves the cursor.
-	initGlyphInfo(face, ' ', glyphs[' ']);
+const GlyphInfo& Font::GetGlyphInfo(GlyphElem glyph) const
+{
+	//we're dumb and store all of the ASCII characters, including INVISIBLE ones,
+	//so no transforms are needed
+	if(glyph < NUM_GLYPHS)
+	{
+		return glyphs[glyph];
+	}
+	UnorderedMap<GlyphElem, GlyphInfo>::iterator it = glyphCache.find(glyph);
+	if(it != glyphCache.end())
+	{
+		const GlyphInfo& info = it->second;
+		if(info.Page > 0)
+		{
+			pages[info.Page - 1].LastUsed = ++useTick;
+		}
+		return info;
+	}
+	return addGlyph(glyph);
+}
 
-	//Do not calculate a region for invisible characters!
-	const U32 CHAR_START = 0;
-	const U32 CHAR_END = NUM_GLYPHS;
-	glyphData.reserve(CHAR_END - CHAR_START);
-	for(U32 i = CHAR_START; i < CHAR_END; ++i)
+const GlyphInfo& Font::addGlyph(GlyphElem glyph) const
+{
+	//glyphs that can't be drawn are cached too, so they're only looked for once
+	GlyphInfo info;
+	info.Glyph = glyph;
+	if(face && renderGlyph(face, glyph))
 	{
-		GlyphInfo& info = glyphs[i];
-		if(!initGlyphInfo(face, i, info))
+		GlyphField field;
+		memset(&field.Glyph, 0, sizeof(FontGlyph));
+		field.Glyph.Glyph = glyph;
+		buildGlyphField(face->glyph, spread, field);
+		FontGlyph& cell = field.Glyph;
+		info.Advance = Vector2(cell.AdvanceX, cell.AdvanceY);
+		U32 page = 0, x = 0, y = 0;
+		if(	cell.Width > 0 && cell.Height > 0 &&
+			placeGlyph(cell.Width + CELL_PADDING, cell.Height + CELL_PADDING, page, x, y))
 		{
-			return false;
+			GlyphPage& glyphPage = pages[page - 1];
+			cell.AtlasX = x;
+			cell.AtlasY = y;
+			gfx->FillTextureSection(glyphPage.Texture, x, y, cell.Width, cell.Height, (char*)&field.Field[0]);
+			setGlyphInfo(info, cell, page, (F32)DYNAMIC_PAGE_SIZE, (F32)DYNAMIC_PAGE_SIZE);
+			glyphPage.Glyphs.push_back(glyph);
+			glyphPage.LastUsed = ++useTick;
 		}
-		FT_GlyphSlot gs = face->glyph;
-		//push this into the pair list if it's a visible character
-		//lineHeight = Math::Max(lineHeight, (F32)info.Dimensions.Height());
-		if(info.Dimensions.Area() > 0)
+	}
+	else if(face)
+	{
+		info.Advance = Vector2((F32)face->glyph->advance.x / (64 * SDF_OVERSAMPLE), 0);
+	}
+	GlyphInfo& result = glyphCache[glyph];
+	result = info;
+	return result;
+}
+
+bool Font::placeGlyph(U32 width, U32 height, U32& pageOut, U32& xOut, U32& yOut) const
+{
+	if(width > DYNAMIC_PAGE_SIZE || height > DYNAMIC_PAGE_SIZE)
+	{
+		LogW("Glyph is too big for a glyph page!");
+		return false;
+	}
+	for(U32 i = 0; i < pages.size(); ++i)
+	{
+		if(pages[i].Packer.Pack(width, height, xOut, yOut))
 		{
-			glyphData.push_back(GlyphData(info, gs->bitmap.buffer));
+			pageOut = i + 1;
+			return true;
 		}
 	}
-	//sort the rectangles, and pack them.
-	std::sort(glyphData.begin(), glyphData.end() - 1, reverseSort);
-	
-	//and try to build the atlas now
-	//create an empty texture
-	const U32 MAX_TEX_SIZE = Math::NearestPowOf2(maxTexSize);
-	//start from an estimated required size; might not fit exactly, but it often works
-	U32 texSize = Math::NearestPowOf2(fontSizePixels * 8);
-	while(texSize <= MAX_TEX_SIZE)
+	U32 index = 0;
+	if(pages.size() < MAX_DYNAMIC_PAGES)
 	{
-		Texture2D tex = gfx->GenerateBlankTexture(texSize, texSize, Texture2D::BYTE);
-		if(!tex.TextureBufferHandle)
+		GlyphPage page;
+		page.Texture = gfx->GenerateBlankTexture(DYNAMIC_PAGE_SIZE, DYNAMIC_PAGE_SIZE, Texture2D::BYTE);
+		if(!page.Texture.TextureBufferHandle)
 		{
-			LogE("Couldn't build texture for glyph atlas!");
+			LogE("Couldn't build texture for glyph page!");
 			return false;
 		}
+		index = pages.size();
+		pages.push_back(page);
+	}
+	else
+	{
+		//every page is full, so empty the one that was used longest ago
+		for(U32 i = 1; i < pages.size(); ++i)
+		{
+			if(pages[i].LastUsed < pages[index].LastUsed)
+			{
+				index = i;
+			}
+		}
+		const Vector<GlyphElem>& evicted = pages[index].Glyphs;
+		for(U32 i = 0; i < evicted.size(); ++i)
+		{
+			glyphCache.erase(evicted[i]);
+		}
+		//anything laid out with those glyphs is stale now
+		++layoutVersion;
+	}
+	GlyphPage& page = pages[index];
+	clearPage(page);
+	pageOut = index + 1;
+	return page.Packer.Pack(width, height, xOut, yOut);
+}
 
-		U32 paddingLen = 1;
+void Font::clearPage(GlyphPage& page) const
+{
+	page.Packer.Init(DYNAMIC_PAGE_SIZE, DYNAMIC_PAGE_SIZE);
+	page.Glyphs.clear();
+	//the padding between cells has to be empty, or filtering picks up old glyphs
+	Vector<char> blank;
+	blank.assign(DYNAMIC_PAGE_SIZE * DYNAMIC_PAGE_SIZE, 0);
+	gfx->FillTexture(page.Texture, &blank[0]);
+}
 
-		//try building the texture
-		if(!buildGlyphTextureAndTexCoords(face, gfx, tex, paddingLen, texSize, texSize, glyphData.begin(), glyphData.end()))
+void Font::layoutPass(const String& str, TextLayout& layoutOut) const
+{
+	Vector<TextVertex>& verts = layoutOut.Vertices;
+	verts.clear();
+	layoutOut.Runs.clear();
+	quadPages.clear();
+	//a glyph's never shorter than a byte, so this is as many quads as there can be
+	verts.reserve(str.length() * 4);
+	quadPages.reserve(str.length());
+
+	//keep track of the lower left corner of the current character
+	Vector2 cursorPos = Vector2::Zero;
+	bool onePage = true;
+	const char* pos = str.c_str();
+	const char* end = pos + str.length();
+	while(pos < end)
+	{
+		GlyphElem glyph = StringUtils::DecodeUTF8(pos, end);
+		//if the character is a newline, just move down a section.
+		if(glyph == '\n')
 		{
-			U32 oldTexSize = texSize;
-			//double the texture size
-			texSize <<= 1;
-			LogW(String("Couldn't build glyph atlas at size ") + oldTexSize + ", rebuilding at size " + texSize);
-			//dispose of the old texture
-			gfx->ShutdownTexture(tex);
+			cursorPos.SetX(0);
+			cursorPos.SetY(cursorPos.Y() - lineHeight);
+			continue;
 		}
-		else
+		const GlyphInfo& gInf = GetGlyphInfo(glyph);
+		const IntRectangle& dims = gInf.Dimensions;
+		//invisible characters only move the cursor
+		if(dims.Width() > 0 && dims.Height() > 0)
 		{
-			//We succeeded, save the texture file.
-			//All other info was initialized by the successful buildGlyphTexture call.
-			textureHandle = tex.TextureBufferHandle;
-			return true;
+			//Need to make a quad with the same bounds as the glyph;
+			//However, it also needs to be properly positioned.
+			//Characters with bits below the baseline need to be shifted down.
+			//Glyph cells also have a margin for the distance field, so shift them left by their bearing.
+			const F32 left = cursorPos.X() + dims.MinX();
+			const F32 right = left + dims.Width();
+			const F32 bottom = cursorPos.Y() - gInf.Descend.Y();
+			const F32 top = bottom + dims.Height();
+			const Rectangle& texRect = gInf.TexCoords;
+			const U32 vIndexBase = verts.size();
+			verts.resize(vIndexBase + 4);
+			TextVertex* quad = &verts[vIndexBase];
+			quad[0].Position = Vector3(left, bottom, 0);	//bottom left
+			quad[1].Position = Vector3(right, bottom, 0);	//bottom right
+			quad[2].Position = Vector3(left, top, 0);		//top left
+			quad[3].Position = Vector3(right, top, 0);		//top right
+			quad[0].TexCoord = Vector2(texRect.MinX(), texRect.MinY());
+			quad[1].TexCoord = Vector2(texRect.MaxX(), texRect.MinY());
+			quad[2].TexCoord = Vector2(texRect.MinX(), texRect.MaxY());
+			quad[3].TexCoord = Vector2(texRect.MaxX(), texRect.MaxY());
+			onePage = onePage && (quadPages.empty() || quadPages[0] == gInf.Page);
+			quadPages.push_back(gInf.Page);
 		}
+		//and move the cursor ahead
+		cursorPos += gInf.Advance;
 	}
 
-	LogE("Couldn't pack texture for glyph atlas!");
-	return false;
+	const U32 numQuads = quadPages.size();
+	if(numQuads == 0)
+	{
+		return;
+	}
+	//most strings only use one page, and are already a single run
+	if(onePage)
+	{
+		layoutOut.Runs.push_back(TextRun(quadPages[0], 0, numQuads));
+		return;
+	}
+	//otherwise group the quads by page, keeping each page's quads in order
+	pageQuads.assign(GetPageCount(), 0);
+	for(U32 i = 0; i < numQuads; ++i)
+	{
+		++pageQuads[quadPages[i]];
+	}
+	U32 firstQuad = 0;
+	for(U32 page = 0; page < pageQuads.size(); ++page)
+	{
+		const U32 count = pageQuads[page];
+		if(count > 0)
+		{
+			layoutOut.Runs.push_back(TextRun(page, firstQuad, count));
+		}
+		//the count becomes where the page's next quad goes
+		pageQuads[page] = firstQuad;
+		firstQuad += count;
+	}
+	sortedVerts.resize(verts.size());
+	for(U32 i = 0; i < numQuads; ++i)
+	{
+		const U32 dest = pageQuads[quadPages[i]]++;
+		std::copy(&verts[i * 4], &verts[i * 4] + 4, &sortedVerts[dest * 4]);
+	}
+	verts.swap(sortedVerts);
 }
 
-const GlyphInfo& Font::GetGlyphInfo(GlyphElem glyph) const
+void Font::LayoutString(const String& str, TextLayout& layoutOut) const
 {
-	//we're dumb and store all of the ASCII characters, including INVISIBLE ones,
-	//so no transforms are needed
-	if(glyph > NUM_GLYPHS)
+	//A page can be evicted partway through the string, leaving earlier quads pointing at its new glyphs.
+	//Laying it out again usually finds every glyph cached; if the string can't fit in the pages at all,
+	//the last attempt is used anyway.
+	const U32 MAX_ATTEMPTS = 3;
+	for(U32 i = 0; i < MAX_ATTEMPTS; ++i)
+	{
+		const U32 version = layoutVersion;
+		layoutPass(str, layoutOut);
+		if(layoutVersion == version)
+		{
+			return;
+		}
+	}
+	LogW("Font's glyph pages can't hold every glyph in a string at once!");
+}
+
+const TextLayout& Font::GetLayout(const String& str) const
+{
+	U64 hash[2];
+	MurmurHash3_x64_128(str.c_str(), (int)str.length(), 0, hash);
+	const U64 key = hash[0];
+	UnorderedMap<U64, LayoutEntry>::iterator it = layouts.find(key);
+	if(it == layouts.end())
+	{
+		if(layouts.size() >= MAX_CACHED_LAYOUTS)
+		{
+			layouts.erase(layoutOrder.back());
+			layoutOrder.pop_back();
+		}
+		layoutOrder.push_front(key);
+		it = layouts.insert(std::make_pair(key, LayoutEntry())).first;
+		it->second.Order = layoutOrder.begin();
+	}
+	else
 	{
-		return glyphs[0];
+		layoutOrder.splice(layoutOrder.begin(), layoutOrder, it->second.Order);
+		if(it->second.Str == str && it->second.Version == layoutVersion)
+		{
+			return it->second.Layout;
+		}
 	}
-	return glyphs[glyph];
+	//new, stale or a hash collision; in the last case the newer string takes the slot
+	LayoutEntry& entry = it->second;
+	entry.Str = str;
+	LayoutString(str, entry.Layout);
+	entry.Version = layoutVersion;
+	return entry.Layout;
+}
+
+void Font::ClearLayoutCache()
+{
+	layouts.clear();
+	layoutOrder.clear();
 }
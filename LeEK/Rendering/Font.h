@@ -2,14 +2,21 @@
 #include "Datatypes.h"
 #include "Math/Rectangle.h"
 #include "ResourceManagement/ResourceManager.h"
-#include "DataStructures/BinaryTree.h"
 #include "GraphicsWrappers/IGraphicsWrapper.h"
+#include "FileManagement/FontFile.h"
+#include "FileManagement/path.h"
+#include "DataStructures/SkylinePacker.h"
+#include "DataStructures/STLContainers.h"
+#include "Rendering/Text.h"
+
+//FreeType's face handle, so including this doesn't pull in FreeType.
+struct FT_FaceRec_;
 
 namespace LeEK
 {
 	//The basic element of a text string.
-	//For now, it's ASCII, so each element is a char.
-	typedef char GlyphElem;
+	//Strings are UTF-8, and each element's a Unicode codepoint.
+	typedef U32 GlyphElem;
 
 	struct GlyphInfo
 	{
@@ -20,28 +27,114 @@ namespace LeEK
 		IntRectangle Dimensions;
 		Rectangle TexCoords;	//normalized tex coords
 		GlyphElem Glyph;
+		//Texture the glyph is on; see Font::GetPageTexture().
+		U32 Page;
 
 		GlyphInfo(const GlyphElem glyph, const Vector2& advance, const IntRectangle& dims, const Rectangle& texCoords) :
-			Glyph(glyph), Advance(advance), Descend(Vector2::Zero), Dimensions(dims), TexCoords(texCoords) {}
-		GlyphInfo() : Glyph(0), Advance(Vector2::Zero), Descend(Vector2::Zero), Dimensions(), TexCoords() {}
+			Advance(advance), Descend(Vector2::Zero), Dimensions(dims), TexCoords(texCoords), Glyph(glyph), Page(0) {}
+		GlyphInfo() : Advance(Vector2::Zero), Descend(Vector2::Zero), Dimensions(), TexCoords(), Glyph(0), Page(0) {}
 	};
 
-	//Stores all information necessary for a renderer to draw text.
-	//Presently only supports ASCII characters.
+	/**
+	Stores all information necessary for a renderer to draw text.
+	The glyphs are stored as a signed distance field,
+	so one atlas can be drawn at any size; metrics are in pixels at the size the atlas was rendered at.
+
+	ASCII is prebuilt into page 0, which is what gets cached on disk.
+	Any other glyph is rendered the first time it's asked for and packed into one of a few dynamic pages;
+	once those are full, the page that was used longest ago is emptied for the new glyphs.
+	Evicting a page bumps the layout version, so text using its glyphs gets laid out again.
+	That only works while the font file's around, so fonts set up from just a cached atlas only have ASCII.
+	*/
 	class Font
 	{
 	private:
+		//A dynamic glyph page.
+		struct GlyphPage
+		{
+			Texture2D Texture;
+			SkylinePacker Packer;
+			//Value of useTick when a glyph on the page was last looked up.
+			U64 LastUsed;
+			//Glyphs to drop from the cache when the page is evicted.
+			Vector<GlyphElem> Glyphs;
+
+			GlyphPage() : LastUsed(0) {}
+		};
+
+		//A cached layout, and where it is in the layouts' LRU order.
+		struct LayoutEntry
+		{
+			String Str;
+			TextLayout Layout;
+			U32 Version;
+			List<U64>::iterator Order;
+		};
+
 		static const U32 NUM_GLYPHS = 128;
 
 		U32 textureHandle;
 		F32 lineHeight;
+		U32 baseSize;
+		U32 spread;
 		GlyphInfo glyphs[NUM_GLYPHS];
 
+		//The font file, kept to render glyphs outside of ASCII.
+		char* faceData;
+		FT_FaceRec_* face;
+		//Mutable since lookups upload the glyphs they render.
+		mutable GfxWrapperHandle gfx;
+
+		//The cache's filled in by lookups, which don't otherwise change the font.
+		mutable Vector<GlyphPage> pages;
+		mutable UnorderedMap<GlyphElem, GlyphInfo> glyphCache;
+		mutable U64 useTick;
+		mutable U32 layoutVersion;
+		mutable UnorderedMap<U64, LayoutEntry> layouts;
+		//Front is the most recently used.
+		mutable List<U64> layoutOrder;
+		//Scratch space for LayoutString().
+		mutable Vector<U32> quadPages;
+		mutable Vector<U32> pageQuads;
+		mutable Vector<TextVertex> sortedVerts;
+
+		bool loadFace(const char* fontFile, U32 fileSize);
+		void releaseFace();
+		void resetCache();
+		const GlyphInfo& addGlyph(GlyphElem glyph) const;
+		bool placeGlyph(U32 width, U32 height, U32& pageOut, U32& xOut, U32& yOut) const;
+		void clearPage(GlyphPage& page) const;
+		void layoutPass(const String& str, TextLayout& layoutOut) const;
+
 	public:
+		//The distance field reaches 1/SPREAD_DIVISOR of the base size past each glyph's edge.
+		static const U32 SPREAD_DIVISOR = 8;
+		static const U32 MIN_SPREAD = 2;
+		//Side of each dynamic page, and how many there can be before they're reused.
+		static const U32 DYNAMIC_PAGE_SIZE = 512;
+		static const U32 MAX_DYNAMIC_PAGES = 8;
+		//How many laid out strings are kept.
+		static const U32 MAX_CACHED_LAYOUTS = 4096;
+
 		Font(void);
 		~Font(void);
 
+		//Releases the font's textures. The font can be generated again afterwards.
+		void Shutdown();
+
+		/**
+		Renders the font's glyphs into a distance field atlas and uploads it.
+		fontSizePixels is the size the atlas is rendered at, and the size text's drawn at by default;
+		larger sizes give sharper corners at large scales, at the cost of a larger atlas.
+		*/
 		bool GenerateFromMemory(const char* fontFile, GfxWrapperHandle gfx,  U32 fileSize, U32 fontSizePixels, U32 maxTexSize);
+		/**
+		Like GenerateFromMemory(), but looks for the atlas in cacheDir first,
+		and saves it there if it had to be built.
+		Caches are keyed by the font's contents and the settings, so a stale one is never used.
+		*/
+		bool GenerateFromMemory(const char* fontFile, GfxWrapperHandle gfx,  U32 fileSize, U32 fontSizePixels, U32 maxTexSize,
+								const Path& cacheDir);
 		bool GenerateFromFile(DataStream* file, GfxWrapperHandle gfx, U32 fontSizePixels, U32 maxTexSize)
 		{
 			//read into buffer, and generate
@@ -54,10 +147,53 @@ namespace LeEK
 		{ 
 			return GenerateFromMemory(resource->Buffer(), gfx, resource->Size(), fontSizePixels, maxTexSize);
 		}
+		bool GenerateFromResource(ResPtr resource, GfxWrapperHandle gfx, U32 fontSizePixels, U32 maxTexSize, const Path& cacheDir)
+		{ 
+			return GenerateFromMemory(resource->Buffer(), gfx, resource->Size(), fontSizePixels, maxTexSize, cacheDir);
+		}
+		//Sets up the font from a cached atlas (.lfnt), such as one packed into an archive.
+		bool GenerateFromCache(const char* data, size_t size, GfxWrapperHandle gfx);
+		bool GenerateFromAtlas(const FontAtlasData& atlas, GfxWrapperHandle gfx);
 
+		/**
+		Builds a font's distance field atlas without touching the renderer.
+		The atlas' data is allocated here; release it with LArrayDelete().
+		*/
+		static bool BuildAtlas(const char* fontFile, U32 fileSize, U32 fontSizePixels, U32 maxTexSize, FontAtlasData& atlasOut);
+		static U32 FindSpread(U32 fontSizePixels) { return Math::Max(fontSizePixels / SPREAD_DIVISOR, MIN_SPREAD); }
+
+		/**
+		Looks up a glyph, rendering it into a dynamic page if it's not cached yet.
+		Glyphs the font doesn't have get an empty cell.
+		The reference is only good until the next lookup, which may evict its page.
+		*/
 		const GlyphInfo& GetGlyphInfo(GlyphElem glyph) const;
+		//Texture of the ASCII page.
 		U32 GetTextureHandle() const { return textureHandle; }
+		U32 GetPageTexture(U32 page) const { return page == 0 ? textureHandle : pages[page - 1].Texture.TextureBufferHandle; }
+		U32 GetPageCount() const { return pages.size() + 1; }
+
+		/**
+		Lays out a UTF-8 string, without going through the layout cache.
+		Newlines start a new line; there's no kerning or complex script shaping.
+		*/
+		void LayoutString(const String& str, TextLayout& layoutOut) const;
+		/**
+		Returns the layout of a string, laying it out only if it isn't cached yet or its glyphs were evicted.
+		Like glyphs, the reference is only good until the next lookup.
+		*/
+		const TextLayout& GetLayout(const String& str) const;
+		//Changes whenever a page is evicted; layouts built under an older version are stale.
+		U32 GetLayoutVersion() const { return layoutVersion; }
+		U32 GetCachedGlyphCount() const { return glyphCache.size(); }
+		U32 GetCachedLayoutCount() const { return layouts.size(); }
+		void ClearLayoutCache();
 
 		F32 GetLineHeight() const { return lineHeight; } 
+		//Size the atlas was rendered at.
+		U32 GetBaseSize() const { return baseSize; }
+		U32 GetSpread() const { return spread; }
+		//Factor to scale the glyph metrics by to draw text of the given size.
+		F32 GetScale(F32 pixelSize) const { return baseSize > 0 ? pixelSize / baseSize : 0; }
 	};
-}
+}
\ No newline at end of file
@@ -15,6 +15,172 @@ void Geometry::Initialize(TypedArrayHandle<Vertex> verts, TypedArrayHandle<U32>
 	GeomBase::Initialize(verts, inds, vertCountParam, indexCountParam);
 
 	uvChannelCount = uvChannelCountParam;
+	vertFormat = FULL_VERTEX;
+	indexSize = sizeof(U32);
+	posOffset = Vector3::Zero;
+	posScale = Vector3::One;
+}
+
+void Geometry::InitializePacked(Handle verts, Handle inds, U32 vertCountParam, U32 indexCountParam, U8 uvChannelCountParam, 
+								VertexFormat formatParam, U8 indexSizeParam, const Vector3& posOffsetParam, const Vector3& posScaleParam)
+{
+	GeomBase::Initialize(verts, inds, vertCountParam, indexCountParam);
+
+	uvChannelCount = uvChannelCountParam;
+	vertFormat = formatParam;
+	indexSize = indexSizeParam;
+	posOffset = posOffsetParam;
+	posScale = posScaleParam;
+}
+
+namespace
+{
+	//unlike Math::Sign, 0 counts as positive -
+	//the octahedral fold can't map anything to 0.
+	inline F32 signNotZero(F32 val)
+	{
+		return val >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	inline I16 toSnorm16(F32 val)
+	{
+		val = Math::Clamp(val, -1.0f, 1.0f);
+		return (I16)(val * 32767.0f + (val >= 0.0f ? 0.5f : -0.5f));
+	}
+
+	inline F32 fromSnorm16(I16 val)
+	{
+		return Math::Max((F32)val / 32767.0f, -1.0f);
+	}
+
+	inline U8 toUnorm8(F32 val)
+	{
+		return (U8)(Math::Clamp(val, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	/**
+	Projects a normal onto the octahedron |x|+|y|+|z| = 1
+	and folds the lower half over the upper half.
+	Zero normals come out as +Z.
+	*/
+	void encodeOctahedral(const Vector3& n, I16* out)
+	{
+		F32 l1 = Math::Abs(n.X()) + Math::Abs(n.Y()) + Math::Abs(n.Z());
+		if(l1 <= 0.0f)
+		{
+			out[0] = out[1] = 0;
+			return;
+		}
+		F32 x = n.X() / l1;
+		F32 y = n.Y() / l1;
+		if(n.Z() < 0.0f)
+		{
+			F32 foldX = (1.0f - Math::Abs(y)) * signNotZero(x);
+			y = (1.0f - Math::Abs(x)) * signNotZero(y);
+			x = foldX;
+		}
+		out[0] = toSnorm16(x);
+		out[1] = toSnorm16(y);
+	}
+
+	Vector3 decodeOctahedral(const I16* in)
+	{
+		F32 x = fromSnorm16(in[0]);
+		F32 y = fromSnorm16(in[1]);
+		F32 z = 1.0f - Math::Abs(x) - Math::Abs(y);
+		if(z < 0.0f)
+		{
+			F32 foldX = (1.0f - Math::Abs(y)) * signNotZero(x);
+			y = (1.0f - Math::Abs(x)) * signNotZero(y);
+			x = foldX;
+		}
+		Vector3 result(x, y, z);
+		result.Normalize();
+		return result;
+	}
+}
+
+U16 GeomHelpers::FloatToHalf(F32 val)
+{
+	U32 bits;
+	memcpy(&bits, &val, sizeof(bits));
+	U16 sign = (U16)((bits >> 16) & 0x8000);
+	I32 exp = (I32)((bits >> 23) & 0xFF) - 127 + 15;
+	U32 mant = bits & 0x007FFFFF;
+	//NaN and infinity.
+	if(((bits >> 23) & 0xFF) == 0xFF)
+	{
+		return sign | 0x7C00 | (mant ? 0x200 : 0);
+	}
+	//overflow saturates to infinity.
+	if(exp >= 0x1F)
+	{
+		return sign | 0x7C00;
+	}
+	//denormals and underflow.
+	if(exp <= 0)
+	{
+		if(exp < -10)
+		{
+			return sign;
+		}
+		mant |= 0x00800000;
+		U32 shift = (U32)(14 - exp);
+		U32 half = mant >> shift;
+		//round to nearest even.
+		U32 rem = mant & ((1u << shift) - 1);
+		U32 halfway = 1u << (shift - 1);
+		if(rem > halfway || (rem == halfway && (half & 1)))
+		{
+			++half;
+		}
+		return sign | (U16)half;
+	}
+	U32 half = ((U32)exp << 10) | (mant >> 13);
+	U32 rem = mant & 0x1FFF;
+	if(rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+	{
+		//may carry into the exponent, which is still the right answer.
+		++half;
+	}
+	return sign | (U16)half;
+}
+
+F32 GeomHelpers::HalfToFloat(U16 val)
+{
+	U32 sign = (U32)(val & 0x8000) << 16;
+	U32 exp = (val >> 10) & 0x1F;
+	U32 mant = val & 0x3FF;
+	U32 bits;
+	if(exp == 0x1F)
+	{
+		bits = sign | 0x7F800000 | (mant << 13);
+	}
+	else if(exp == 0)
+	{
+		if(mant == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			//renormalize the denormal.
+			exp = 127 - 15 + 1;
+			while(!(mant & 0x400))
+			{
+				mant <<= 1;
+				--exp;
+			}
+			bits = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+		}
+	}
+	else
+	{
+		bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+	}
+	F32 result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
 }
 
 TypedArrayHandle<Vertex> GeomHelpers::BuildVertArray(Vector3* PosList, Vector3* NormList, Color* ColorList, Vector2* UVList, 
@@ -88,3 +254,112 @@ bool GeomHelpers::BuildGeometry(Geometry& geom, Vector3* PosList, Vector3* NormL
 	geom.Initialize(vertHnd, HandleMgr::RegisterPtr((void*)inds), numVertices, numIndices, numUVChannels);
 	return true;
 }
+
+void GeomHelpers::DeleteGeometry(Geometry& geom)
+{
+	Handle vertHnd = geom.VertexHandle().GetHandle();
+	Handle indHnd = geom.IndexHandle().GetHandle();
+	//every buffer type here is trivially destructible,
+	//so the untyped delete works for packed buffers too.
+	CustomArrayDelete(HandleMgr::GetPointer(vertHnd));
+	CustomArrayDelete(HandleMgr::GetPointer(indHnd));
+	HandleMgr::RemoveHandle(vertHnd);
+	HandleMgr::RemoveHandle(indHnd);
+	geom.Initialize(TypedArrayHandle<Vertex>(0), TypedArrayHandle<U32>(0), 0, 0, 0);
+}
+
+bool GeomHelpers::PackGeometry(const Geometry& src, VertexFormat format, Geometry& out)
+{
+	if(src.IsPacked() || format == FULL_VERTEX || format >= VERTFMT_LEN)
+	{
+		LogW("Can only pack full vertices into a packed format!");
+		return false;
+	}
+	U32 numVerts = src.VertexCount();
+	U32 numIndices = src.IndexCount();
+	const Vertex* srcVerts = src.Vertices();
+	const U32* srcInds = src.Indices();
+
+	//positions are stored relative to the mesh bounds,
+	//so find those first.
+	Vector3 minPos = numVerts > 0 ? srcVerts[0].Position : Vector3::Zero;
+	Vector3 maxPos = minPos;
+	for(U32 i = 1; i < numVerts; ++i)
+	{
+		const Vector3& pos = srcVerts[i].Position;
+		minPos = Vector3(Math::Min(minPos.X(), pos.X()), Math::Min(minPos.Y(), pos.Y()), Math::Min(minPos.Z(), pos.Z()));
+		maxPos = Vector3(Math::Max(maxPos.X(), pos.X()), Math::Max(maxPos.Y(), pos.Y()), Math::Max(maxPos.Z(), pos.Z()));
+	}
+	Vector3 offset = (minPos + maxPos) * 0.5f;
+	Vector3 scale = (maxPos - minPos) * 0.5f;
+	//flat axes would divide by zero otherwise.
+	scale = Vector3(scale.X() > 0.0f ? scale.X() : 1.0f,
+					scale.Y() > 0.0f ? scale.Y() : 1.0f,
+					scale.Z() > 0.0f ? scale.Z() : 1.0f);
+
+	PackedVertex* verts = CustomArrayNew<PackedVertex>(numVerts, MESH_ALLOC, "MeshVertAlloc");
+	if(!verts)
+	{
+		return false;
+	}
+	for(U32 i = 0; i < numVerts; ++i)
+	{
+		const Vertex& vert = srcVerts[i];
+		PackedVertex& packed = verts[i];
+		Vector3 relPos = vert.Position - offset;
+		F32 relComps[3] = { relPos.X() / scale.X(), relPos.Y() / scale.Y(), relPos.Z() / scale.Z() };
+		for(U32 c = 0; c < 3; ++c)
+		{
+			packed.Position[c] = format == HALF_POS_VERTEX ? FloatToHalf(relComps[c]) : (U16)toSnorm16(relComps[c]);
+		}
+		packed._pad = 0;
+		encodeOctahedral(vert.Normal, packed.Normal);
+		packed.Color[0] = toUnorm8(vert.Color.X());
+		packed.Color[1] = toUnorm8(vert.Color.Y());
+		packed.Color[2] = toUnorm8(vert.Color.Z());
+		packed.Color[3] = 0xFF;
+		packed.UV[0] = FloatToHalf(vert.UV.X());
+		packed.UV[1] = FloatToHalf(vert.UV.Y());
+	}
+
+	//any mesh that can address its vertices in 16 bits gets 16-bit indices.
+	U8 indexSize = numVerts <= 0x10000 ? sizeof(U16) : sizeof(U32);
+	void* inds;
+	if(indexSize == sizeof(U16))
+	{
+		U16* shortInds = CustomArrayNew<U16>(numIndices, MESH_ALLOC, "MeshIndexAlloc");
+		for(U32 i = 0; i < numIndices; ++i)
+		{
+			shortInds[i] = (U16)srcInds[i];
+		}
+		inds = shortInds;
+	}
+	else
+	{
+		U32* longInds = CustomArrayNew<U32>(numIndices, MESH_ALLOC, "MeshIndexAlloc");
+		memcpy(longInds, srcInds, numIndices * sizeof(U32));
+		inds = longInds;
+	}
+	out.InitializePacked(	HandleMgr::RegisterPtr((void*)verts), HandleMgr::RegisterPtr(inds), numVerts, numIndices, src.UVChannelCount(),
+							format, indexSize, offset, scale);
+	return true;
+}
+
+Vertex GeomHelpers::UnpackVertex(const Geometry& geom, const PackedVertex& vert)
+{
+	Vertex result;
+	F32 relComps[3];
+	for(U32 c = 0; c < 3; ++c)
+	{
+		relComps[c] = geom.Format() == HALF_POS_VERTEX ? HalfToFloat(vert.Position[c]) : fromSnorm16((I16)vert.Position[c]);
+	}
+	const Vector3& offset = geom.PositionOffset();
+	const Vector3& scale = geom.PositionScale();
+	result.Position = Vector3(	offset.X() + scale.X() * relComps[0],
+								offset.Y() + scale.Y() * relComps[1],
+								offset.Z() + scale.Z() * relComps[2]);
+	result.Normal = decodeOctahedral(vert.Normal);
+	result.Color = Vector3(vert.Color[0] / 255.0f, vert.Color[1] / 255.0f, vert.Color[2] / 255.0f);
+	result.UV = Vector3(HalfToFloat(vert.UV[0]), HalfToFloat(vert.UV[1]), 0);
+	return result;
+}
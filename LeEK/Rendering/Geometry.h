@@ -29,6 +29,37 @@ namespace LeEK
 		Vertex() : Position(), Color(), Normal(), UV() {}
 	};
 
+	/**
+	Layouts a mesh's vertex buffer can be stored in.
+	*/
+	enum VertexFormat
+	{
+		//Vertex structs, full floats everywhere.
+		FULL_VERTEX,
+		//PackedVertex with half-float positions.
+		HALF_POS_VERTEX,
+		//PackedVertex with snorm16 positions.
+		SNORM_POS_VERTEX,
+		VERTFMT_LEN
+	};
+
+	/**
+	Quantized vertex element; 20 bytes versus Vertex's 48.
+	Positions are relative to the mesh's bounds - the shader
+	rebuilds them as PositionOffset + PositionScale * Position,
+	so they're always in [-1, 1] before scaling.
+	Normals are octahedral-encoded snorm16s,
+	colors are unorm8s and UVs are half-floats.
+	*/
+	struct PackedVertex
+	{
+		U16 Position[3];
+		U16 _pad;
+		I16 Normal[2];
+		U8 Color[4];
+		U16 UV[2];
+	};
+
 	/**
 	Contains handles to geometry data buffers on system RAM (NOT the graphics memory).
 	*/
@@ -117,10 +148,14 @@ namespace LeEK
 	{
 	private:
 		U8 uvChannelCount;
-		//TODO: put bounds data here?
-		//Scaling?
+		U8 vertFormat;
+		//size of each index in bytes - 2 or 4.
+		U8 indexSize;
+		//dequantization parameters for packed positions.
+		Vector3 posOffset;
+		Vector3 posScale;
 	public:
-		Geometry(void) : uvChannelCount(0) {}
+		Geometry(void) : uvChannelCount(0), vertFormat(FULL_VERTEX), indexSize(sizeof(U32)), posOffset(Vector3::Zero), posScale(Vector3::One) {}
 		~Geometry(void);
 
 		/**
@@ -128,7 +163,25 @@ namespace LeEK
 		and specifies how many UV channels this piece of geometry has.
 		*/
 		void Initialize(TypedArrayHandle<Vertex> verts, TypedArrayHandle<U32> inds, U32 vertCountParam, U32 indexCountParam, U8 uvChannelCountParam);
+		/**
+		Like Initialize(), but the vertex buffer holds PackedVertex structs
+		in the given format and each index is indexSizeParam bytes.
+		Vertices() and Indices() are only meaningful for FULL_VERTEX geometry;
+		use VertexData() and IndexData() on packed geometry.
+		*/
+		void InitializePacked(Handle verts, Handle inds, U32 vertCountParam, U32 indexCountParam, U8 uvChannelCountParam, 
+							VertexFormat formatParam, U8 indexSizeParam, const Vector3& posOffsetParam, const Vector3& posScaleParam);
 		inline U8 UVChannelCount() const { return uvChannelCount; }
+		inline VertexFormat Format() const { return (VertexFormat)vertFormat; }
+		inline bool IsPacked() const { return vertFormat != FULL_VERTEX; }
+		inline U8 IndexSize() const { return indexSize; }
+		inline U32 VertexStride() const { return IsPacked() ? sizeof(PackedVertex) : sizeof(Vertex); }
+		inline const void* VertexData() const { return HandleMgr::GetPointer(VertexHandle().GetHandle()); }
+		inline const void* IndexData() const { return HandleMgr::GetPointer(IndexHandle().GetHandle()); }
+		inline U32 VertexSizeAsBuffer() const { return VertexCount() * VertexStride(); }
+		inline U32 IndexSizeAsBuffer() const { return IndexCount() * IndexSize(); }
+		inline const Vector3& PositionOffset() const { return posOffset; }
+		inline const Vector3& PositionScale() const { return posScale; }
 	};
 
 	namespace GeomHelpers
@@ -140,5 +193,24 @@ namespace LeEK
 		Remember that it's up to you to delete these buffers!
 		*/
 		bool BuildGeometry(Geometry& geom, Vector3* PosList, Vector3* NormList, Color* ColorList, Vector2* UVList, U32* IndexList, U32 numVertices, U32 numIndices, U8 numUVChannels);
+		/**
+		Deletes buffers made by BuildGeometry() or PackGeometry()
+		and releases their handles. Leaves the geometry empty.
+		Any copies of the geometry are left dangling, so only do this once per buffer!
+		*/
+		void DeleteGeometry(Geometry& geom);
+
+		U16 FloatToHalf(F32 val);
+		F32 HalfToFloat(U16 val);
+		/**
+		Quantizes a FULL_VERTEX mesh into a PackedVertex buffer of the given format.
+		Indices drop to 16 bits if the mesh has 65536 or fewer vertices.
+		As with BuildGeometry(), the new buffers are yours to delete.
+		*/
+		bool PackGeometry(const Geometry& src, VertexFormat format, Geometry& out);
+		/**
+		Expands a single packed vertex back to a full Vertex.
+		*/
+		Vertex UnpackVertex(const Geometry& geom, const PackedVertex& vert);
 	}
 }
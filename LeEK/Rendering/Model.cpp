@@ -1,5 +1,6 @@
 #include "Model.h"
 #include "../Logging/Log.h"
+#include "../Math/BatchMath.h"
 
 using namespace LeEK;
 
@@ -18,6 +19,7 @@ Model::Model(const Model& other)
 	aabbHalfBounds = other.aabbHalfBounds;
 	boundingRadius = other.boundingRadius;
 	meshes = other.meshes;
+	lowerLODs = other.lowerLODs;
 }
 
 Model::~Model(void)
@@ -67,19 +69,22 @@ void Model::RecalcBounds()
 	for(int i = 0; i < meshes.size(); ++i)
 	{
 		const Geometry& geom = meshes[i].GetGeometry();
-		//then each vertex in the mesh's geometry
-		for(int j = 0; j < geom.VertexCount(); ++j)
+		if(geom.VertexCount() == 0)
 		{
-			const Vector3& vert = geom.Vertices()[j].Position;
-			//expand AABB bounds to fit this vertex if needed
-			aabbMax.SetX(Math::Max(aabbMax.X(), vert.X()));
-			aabbMax.SetY(Math::Max(aabbMax.Y(), vert.Y()));
-			aabbMax.SetZ(Math::Max(aabbMax.Z(), vert.Z()));
-
-			//we ALSO need the minimum bounds to get the AABB's center.
-			aabbMin.SetX(Math::Min(aabbMin.X(), vert.X()));
-			aabbMin.SetY(Math::Min(aabbMin.Y(), vert.Y()));
-			aabbMin.SetZ(Math::Min(aabbMin.Z(), vert.Z()));
+			continue;
+		}
+		//expand AABB bounds to fit the mesh's vertices.
+		//we ALSO need the minimum bounds to get the AABB's center.
+		if(geom.IsPacked())
+		{
+			//packed positions are already relative to the mesh's bounds.
+			Vector3 meshBounds[2] = {	geom.PositionOffset() - geom.PositionScale(),
+										geom.PositionOffset() + geom.PositionScale() };
+			BatchMath::ExpandAABB(meshBounds, 2, aabbMin, aabbMax, sizeof(Vector3));
+		}
+		else
+		{
+			BatchMath::ExpandAABB(&geom.Vertices()[0].Position, geom.VertexCount(), aabbMin, aabbMax, sizeof(Vertex));
 		}
 		numVerts += geom.VertexCount();
 	}
@@ -110,6 +115,7 @@ void Model::RecalcBounds()
 void Model::Clear()
 {
 	meshes.clear();
+	lowerLODs.clear();
 	//reset bounds, too!
 	aabbHalfBounds = Vector3::Zero;
 	boundingRadius = 0.0f;
@@ -142,4 +148,91 @@ Model::ConstMeshIt Model::GetMeshBegin() const
 Model::ConstMeshIt Model::GetMeshEnd() const
 {
 	return meshes.cend();
+}
+
+U16 Model::LODMeshCount(U32 lod) const
+{
+	if(lod == 0)
+	{
+		return MeshCount();
+	}
+	if(lod < LODCount())
+	{
+		return lowerLODs[lod - 1].Meshes.size();
+	}
+	return 0;
+}
+
+Mesh* Model::GetLODMesh(U32 lod, U32 index)
+{
+	if(lod == 0)
+	{
+		return GetMesh(index);
+	}
+	if(lod < LODCount() && index < lowerLODs[lod - 1].Meshes.size())
+	{
+		return &lowerLODs[lod - 1].Meshes[index];
+	}
+	return NULL;
+}
+
+const Mesh* Model::GetLODMesh(U32 lod, U32 index) const
+{
+	if(lod == 0)
+	{
+		return GetMesh(index);
+	}
+	if(lod < LODCount() && index < lowerLODs[lod - 1].Meshes.size())
+	{
+		return &lowerLODs[lod - 1].Meshes[index];
+	}
+	return NULL;
+}
+
+F32 Model::LODError(U32 lod) const
+{
+	if(lod == 0 || lod >= LODCount())
+	{
+		return 0.0f;
+	}
+	return lowerLODs[lod - 1].GeometricError;
+}
+
+U32 Model::AddLOD(F32 geometricError)
+{
+	lowerLODs.push_back(ModelLOD(geometricError));
+	return lowerLODs.size();
+}
+
+void Model::AddLODMesh(U32 lod, const Mesh& mesh)
+{
+	if(lod == 0)
+	{
+		AddMesh(mesh);
+		return;
+	}
+	if(lod < LODCount())
+	{
+		lowerLODs[lod - 1].Meshes.push_back(mesh);
+	}
+}
+
+U32 Model::SelectLOD(F32 errorToPixels, F32 maxPixelError, U32 currLOD, F32 hysteresis) const
+{
+	//Levels coarser than the current one have to be comfortably under the threshold
+	//before we switch down to them, and the current level (or finer ones)
+	//can go a bit over it before we switch back up.
+	//Errors increase with the level, so the first level
+	//that passes, searching from the coarsest, is the one we want.
+	F32 coarserThreshold = maxPixelError * (1.0f - hysteresis);
+	F32 finerThreshold = maxPixelError * (1.0f + hysteresis);
+	for(U32 lod = LODCount() - 1; lod > 0; --lod)
+	{
+		F32 projectedError = lowerLODs[lod - 1].GeometricError * errorToPixels;
+		if(projectedError <= (lod > currLOD ? coarserThreshold : finerThreshold))
+		{
+			return lod;
+		}
+	}
+	return 0;
 }
\ No newline at end of file
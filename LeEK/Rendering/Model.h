@@ -6,14 +6,34 @@
 
 namespace LeEK
 {
+	/**
+	A lower detail version of a model's meshes.
+	*/
+	struct ModelLOD
+	{
+	public:
+		Vector<Mesh> Meshes;
+		/**
+		How far, in model space, this level's surface
+		can be from the full detail surface.
+		*/
+		F32 GeometricError;
+
+		ModelLOD(F32 error = 0.0f) : Meshes(), GeometricError(error) {}
+	};
+
 	/**
 	Holds a collection of meshes,
 	as well as a bounding box and sphere.
+	Models can also have a chain of lower detail meshes;
+	the regular mesh list is LOD 0, the full detail level.
 	*/
 	class Model
 	{
 	private:
 		Vector<Mesh> meshes;
+		//LOD 1 onwards, in order of decreasing detail.
+		Vector<ModelLOD> lowerLODs;
 		Vector3 boundsCenter;
 		//used to build AABBs.
 		Vector3 aabbHalfBounds;
@@ -91,5 +111,45 @@ namespace LeEK
 		Might be useful if dynamically generating meshes?
 		*/
 		void Reserve(U16 meshCount) { meshes.reserve(meshCount); }
+
+		#pragma region LOD Methods
+		/**
+		Gets the number of detail levels in the model, including LOD 0.
+		*/
+		inline U32 LODCount() const { return lowerLODs.size() + 1; }
+		/**
+		Gets the number of meshes in the given detail level.
+		*/
+		U16 LODMeshCount(U32 lod) const;
+		Mesh* GetLODMesh(U32 lod, U32 index);
+		const Mesh* GetLODMesh(U32 lod, U32 index) const;
+		/**
+		Gets the geometric error of the given detail level.
+		LOD 0 always has an error of 0.
+		*/
+		F32 LODError(U32 lod) const;
+		/**
+		Adds an empty detail level after the current lowest detail level.
+		Levels should be added in order of increasing error.
+		@return the index of the new level.
+		*/
+		U32 AddLOD(F32 geometricError);
+		/**
+		Adds a mesh to the given detail level.
+		Adding to LOD 0 is the same as AddMesh().
+		*/
+		void AddLODMesh(U32 lod, const Mesh& mesh);
+		/**
+		Picks the lowest detail level that still looks correct on screen.
+		@param errorToPixels the number of pixels a unit of geometric error
+		covers at the model's distance from the camera.
+		@param maxPixelError the largest on-screen error allowed.
+		@param currLOD the level the model was last drawn at.
+		@param hysteresis how far, as a fraction of maxPixelError,
+		the projected error has to cross the threshold before the level changes.
+		Keeps models from popping back and forth at the switching distance.
+		*/
+		U32 SelectLOD(F32 errorToPixels, F32 maxPixelError, U32 currLOD, F32 hysteresis) const;
+		#pragma endregion
 	};
 }
@@ -0,0 +1,99 @@
+#include "PixelConversion.h"
+#include <cstring>
+
+//The vector versions are used when the compiler targets the instruction set they need;
+//define DISABLE_SSE to force the scalar versions.
+#if !defined(DISABLE_SSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ENABLE_SSE2
+#include <emmintrin.h>
+#endif
+//There's no SSSE3 switch in MSVC, but anything that targets AVX has it.
+#if defined(ENABLE_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+#define ENABLE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+using namespace LeEK;
+
+void PixelConversion::BGRAToRGBA(const U8* src, U8* dest, U32 numPixels)
+{
+	U32 i = 0;
+#ifdef ENABLE_SSE2
+	//green and alpha stay put; blue and red are the low bytes of each pixel's two 16-bit halves,
+	//so swapping the halves swaps them.
+	const __m128i gaMask = _mm_set1_epi32((int)0xFF00FF00);
+	for(; i + 8 <= numPixels; i += 8)
+	{
+		__m128i px0 = _mm_loadu_si128((const __m128i*)(src + (i * 4)));
+		__m128i px1 = _mm_loadu_si128((const __m128i*)(src + (i * 4) + 16));
+		__m128i br0 = _mm_andnot_si128(gaMask, px0);
+		__m128i br1 = _mm_andnot_si128(gaMask, px1);
+		br0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(br0, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		br1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(br1, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_si128((__m128i*)(dest + (i * 4)), _mm_or_si128(_mm_and_si128(px0, gaMask), br0));
+		_mm_storeu_si128((__m128i*)(dest + (i * 4) + 16), _mm_or_si128(_mm_and_si128(px1, gaMask), br1));
+	}
+#endif
+	for(; i < numPixels; ++i)
+	{
+		const U8* in = src + (i * 4);
+		U8* out = dest + (i * 4);
+		//read the whole pixel first, in case this is in place
+		const U8 b = in[0], g = in[1], r = in[2], a = in[3];
+		out[0] = r;
+		out[1] = g;
+		out[2] = b;
+		out[3] = a;
+	}
+}
+
+void PixelConversion::BGRToRGBA(const U8* src, U8* dest, U32 numPixels)
+{
+	U32 i = 0;
+#ifdef ENABLE_SSSE3
+	//each load reads 16 bytes for 4 pixels' 12, so stop while there's still 2 pixels past them,
+	//or the load could run off the end of src
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	for(; i + 6 <= numPixels; i += 4)
+	{
+		__m128i px = _mm_loadu_si128((const __m128i*)(src + (i * 3)));
+		_mm_storeu_si128((__m128i*)(dest + (i * 4)), _mm_or_si128(_mm_shuffle_epi8(px, shuffle), alpha));
+	}
+#endif
+	for(; i < numPixels; ++i)
+	{
+		const U8* in = src + (i * 3);
+		U8* out = dest + (i * 4);
+		out[0] = in[2];
+		out[1] = in[1];
+		out[2] = in[0];
+		out[3] = 0xFF;
+	}
+}
+
+void PixelConversion::GrayToRGBA(const U8* src, U8* dest, U32 numPixels)
+{
+	U32 i = 0;
+#ifdef ENABLE_SSE2
+	//interleaving the values with themselves twice spreads each one over a whole pixel
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	for(; i + 16 <= numPixels; i += 16)
+	{
+		__m128i gray = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i lo = _mm_unpacklo_epi8(gray, gray);
+		__m128i hi = _mm_unpackhi_epi8(gray, gray);
+		__m128i* out = (__m128i*)(dest + (i * 4));
+		_mm_storeu_si128(out, _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+		_mm_storeu_si128(out + 1, _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+		_mm_storeu_si128(out + 2, _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+		_mm_storeu_si128(out + 3, _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+	}
+#endif
+	for(; i < numPixels; ++i)
+	{
+		U8* out = dest + (i * 4);
+		out[0] = out[1] = out[2] = src[i];
+		out[3] = 0xFF;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Datatypes.h"
+
+namespace LeEK
+{
+	/**
+	Converts rows of pixels from the layouts image files store them in to RGBA8.
+	Used by the image loaders to decode straight into texture memory,
+	and usable on Texture2D::BGRA8 data for renderers that can't take it as is.
+	Channels are named in memory order, so BGRA8 is B, G, R, A byte by byte.
+	None of these need aligned pointers.
+	*/
+	namespace PixelConversion
+	{
+		//Swaps red and blue. src and dest may be the same buffer.
+		void BGRAToRGBA(const U8* src, U8* dest, U32 numPixels);
+		//Swaps red and blue and adds opaque alpha. src and dest can't overlap.
+		void BGRToRGBA(const U8* src, U8* dest, U32 numPixels);
+		//Copies each value to red, green and blue, and adds opaque alpha. src and dest can't overlap.
+		void GrayToRGBA(const U8* src, U8* dest, U32 numPixels);
+	}
+}
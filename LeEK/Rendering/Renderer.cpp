@@ -13,9 +13,14 @@ Renderer::Renderer(GfxWrapperHandle pGfx, CameraHandle pCam, TypedHandle<Culler>
 
 	defaultTexGUID = pDefTex;
 	defaultTex = NULL;
-	defTexPtr = NULL;
+	defTexPtr.reset();
 	
 	numModelsDrawn = 0;
+	numLowerLODsDrawn = 0;
+	numTransformsUpdated = 0;
+
+	lodPixelError = 1.0f;
+	lodHysteresis = 0.25f;
 
 	//Culler really should be using the renderer's camera.
 	if(camera)
@@ -97,6 +102,17 @@ void Renderer::notifyCullerNodeUpdated(SpatialHnd node)
 	}
 }
 
+void Renderer::updateTransforms()
+{
+	//Only walk the graph when its structure has changed;
+	//otherwise the flattened list is still valid.
+	if(transHierarchy.NeedsRebuild())
+	{
+		transHierarchy.Rebuild(sceneRoot.Ptr());
+	}
+	numTransformsUpdated = transHierarchy.Update();
+}
+
 void Renderer::setTextures(const Material& mat)
 {
 	//need to setup mesh uniforms;
@@ -104,20 +120,60 @@ void Renderer::setTextures(const Material& mat)
 	//that's just the texture.
 	//use a default material if there's no texture specified
 	ResPtr texPtr = resMgr->GetResource(mat.DiffuseTexGUID);
-	const Texture2D& texRef = texPtr != NULL ? *(Texture2D*)texPtr->Buffer() : *defaultTex;
+	const Texture2D& texRef = texPtr ? *(Texture2D*)texPtr->Buffer() : *defaultTex;
 	//should really poll for if a shader uses teexture samplers.
 	gfx->SetTexture(texRef, TextureMeta::DIFFUSE);
 	texPtr = resMgr->GetResource(mat.SpecularTexGUID);
 }
 
-void Renderer::drawModel(Model& model)
+U32 Renderer::selectLOD(ModelNode& node, const Model& model, const SphereBounds& worldBounds, F32 worldScale, F32 errorToPixelsPerDist)
+{
+	if(model.LODCount() < 2 || lodPixelError <= 0.0f || errorToPixelsPerDist <= 0.0f)
+	{
+		node.SetLODLevel(0);
+		return 0;
+	}
+	//Use the distance to the nearest point of the bounding sphere;
+	//if the camera's inside the sphere, nothing beats full detail.
+	F32 dist = (worldBounds.Center() - camera->Position()).Length() - worldBounds.Radius();
+	if(dist <= camera->NearDist())
+	{
+		node.SetLODLevel(0);
+		return 0;
+	}
+	F32 errorToPixels = worldScale * errorToPixelsPerDist / dist;
+	U32 lod = model.SelectLOD(errorToPixels, lodPixelError, node.GetLODLevel(), lodHysteresis);
+	node.SetLODLevel(lod);
+	//Levels loaded from file might not have been sent to the graphics card;
+	//fall back to the nearest level that has.
+	while(lod > 0)
+	{
+		bool ready = true;
+		for(U32 i = 0; i < model.LODMeshCount(lod); ++i)
+		{
+			if(model.GetLODMesh(lod, i)->GetGeometry().VertexArrayHandle() == 0)
+			{
+				ready = false;
+				break;
+			}
+		}
+		if(ready)
+		{
+			break;
+		}
+		--lod;
+	}
+	return lod;
+}
+
+void Renderer::drawModel(Model& model, U32 lod)
 {
 	Texture2D& defTexRef = *(Texture2D*)defTexPtr->Buffer();
 
-	for(U32 i = 0; i < model.MeshCount(); ++i)
+	for(U32 i = 0; i < model.LODMeshCount(lod); ++i)
 	{
 		//Get all the needed data.
-		const Mesh& mesh = *model.GetMesh(i);
+		const Mesh& mesh = *model.GetLODMesh(lod, i);
 		const Material& mat = mesh.GetMaterial();
 		const Geometry& geom = mesh.GetGeometry();
 		setTextures(mat);
@@ -138,7 +194,7 @@ void Renderer::setTexUniforms(const Shader& shader)
 	gfx->SetIntUniform("diffTex", TextureMeta::DIFFUSE);
 }
 
-void Renderer::onDraw(Model& model, TypedHandle<Shader> shader, const Matrix4x4& worldMat)
+void Renderer::onDraw(Model& model, TypedHandle<Shader> shader, const Matrix4x4& worldMat, U32 lod)
 {
 	gfx->SetShader(shader);
 	setLightUniforms(*shader);
@@ -146,7 +202,7 @@ void Renderer::onDraw(Model& model, TypedHandle<Shader> shader, const Matrix4x4&
 	//Each shader program might not get
 	//access to the WVP matrix if we don't specify in the loop.
 	gfx->SetWorldViewProjection(worldMat, camera->GetViewMatrix(), camera->GetProjMatrix());
-	drawModel(model);
+	drawModel(model, lod);
 }
 
 const GfxWrapperHandle& Renderer::GetGraphicsWrapper() const { return gfx; }
@@ -156,14 +212,25 @@ const CameraHandle& Renderer::GetCamera() const { return camera; }
 void Renderer::SetCamera(CameraHandle newCam)	{ camera = newCam; }
 
 const TypedHandle<GroupingNode>& Renderer::GetSceneRoot() const { return sceneRoot; }
-void Renderer::SetSceneRoot(TypedHandle<GroupingNode> newRoot) { sceneRoot = newRoot; }
+void Renderer::SetSceneRoot(TypedHandle<GroupingNode> newRoot)
+{
+	sceneRoot = newRoot;
+	transHierarchy.Invalidate();
+}
 
 const TypedHandle<Culler>& Renderer::GetCuller() const { return culler; }
 void Renderer::GetCuller(TypedHandle<Culler> newCuller) { culler = newCuller; }
 
 const Matrix4x4& Renderer::GetCurrWorldMatrix() const { return worldStack.back(); }
 
+void Renderer::SetLODPixelError(F32 pixels) { lodPixelError = pixels; }
+F32 Renderer::GetLODPixelError() const { return lodPixelError; }
+void Renderer::SetLODHysteresis(F32 fraction) { lodHysteresis = Math::Clamp(fraction, 0.0f, 1.0f); }
+F32 Renderer::GetLODHysteresis() const { return lodHysteresis; }
+
 U64 Renderer::GetNumModelsDrawn() const { return numModelsDrawn; }
+U64 Renderer::GetNumLowerLODsDrawn() const { return numLowerLODsDrawn; }
+U32 Renderer::GetNumTransformsUpdated() const { return numTransformsUpdated; }
 
 void Renderer::Init()
 {
@@ -199,6 +266,16 @@ void Renderer::InsertNodeAt(TypedHandle<SpatialNode> node, TypedHandle<SpatialNo
 
 	//Otherwise, cast to GroupingNode and add the child.
 	((TypedHandle<GroupingNode>)fixedParent)->AttachChild(node);
+	//The culler needs the new node's world transform,
+	//so get the transforms up to date before notifying it.
+	if(transHierarchy.NeedsRebuild())
+	{
+		updateTransforms();
+	}
+	else
+	{
+		transHierarchy.Insert(node.Ptr());
+	}
 	//Notify the culler that a node's been inserted.
 	//This node may be a container - we must recurse on its children if it has any.
 	notifyCullerNodeAdded(node);
@@ -228,6 +305,7 @@ void Renderer::MoveNode(TypedHandle<SpatialNode> node, TypedHandle<SpatialNode>
 
 	//Fix the parent, and then notify the culler.
 	//Nothing moved, but global shaders have almost certainly changed.
+	transHierarchy.Invalidate();
 	notifyCullerNodeMoved(node);
 }
 
@@ -247,6 +325,7 @@ void Renderer::RemoveNode(TypedHandle<SpatialNode> node)
 		((GroupingNode*)parent)->DetachChild(node);
 		node->SetParent(NULL);
 	}
+	transHierarchy.Invalidate();
 
 	//Now notify the culler that the node's been removed.
 	//Like InsertNodeAt(), the node might be a container,
@@ -269,12 +348,24 @@ void Renderer::UpdateNode(TypedHandle<SpatialNode> node)
 
 void Renderer::DrawScene()
 {
+	//Bring world transforms up to date first;
+	//both culling and drawing rely on them.
+	updateTransforms();
 	//Get the culled geometry...
 	culler->CalcVisibleSet();
 	auto visScene = culler->GetVisibleSet();
 	Frustum& camFrust = camera->GetWorldFrustum();
 	//Reset any stat counters.
 	numModelsDrawn = 0;
+	numLowerLODsDrawn = 0;
+	//An object of size s at distance d covers s * (screen height / (2 * d * tan(fov/2))) pixels;
+	//work out everything but the distance once for the whole frame.
+	//Orthographic views don't shrink with distance, so they always get full detail.
+	F32 errorToPixelsPerDist = 0.0f;
+	if(camera->GetProjType() == PT_PERSPECTIVE)
+	{
+		errorToPixelsPerDist = gfx->GetScreenResolution().Y() / (2.0f * tanf(camera->FOV() / 2.0f));
+	}
 	//Now render those elements.
 	for(auto elem = visScene.Elements.begin(); elem != visScene.Elements.end(); ++elem)
 	{
@@ -282,14 +373,16 @@ void Renderer::DrawScene()
 					"Trying to render a null node!");
 		L_ASSERT(	elem->Spatial->GetContainMode() == SpatialNode::NODE_LEAF &&
 					"Trying to render a non-leaf node!");
-		auto modelHnd = ((TypedHandle<ModelNode>)elem->Spatial)->GetModel();
+		ModelNode& modelNode = *((TypedHandle<ModelNode>)elem->Spatial);
+		auto modelHnd = modelNode.GetModel();
 		if(!modelHnd)
 		{
 			continue;
 		}
 		Model& model = *modelHnd;
+		Transform elemTrans = elem->Spatial->GetWorldTransform();
 		//do a sphere test on the object so we don't have to render extra stuff.
-		SphereBounds objBounds = SphereBounds(	model.BoundsCenter() + elem->Spatial->GetWorldTransform().Position(),
+		SphereBounds objBounds = SphereBounds(	model.BoundsCenter() + elemTrans.Position(),
 												model.BoundingRadius());
 		//gfx->DebugDrawSphere(objBounds, Colors::LtGreen);
 		if(!camFrust.Test(objBounds))
@@ -298,22 +391,28 @@ void Renderer::DrawScene()
 		}
 		//We're in the camera's frustum, mark this as being drawn.
 		++numModelsDrawn;
+		U32 lod = selectLOD(modelNode, model, objBounds, elemTrans.Scale(), errorToPixelsPerDist);
+		if(lod > 0)
+		{
+			++numLowerLODsDrawn;
+		}
 
-		Matrix4x4& elemWorld = elem->Spatial->GetWorldTransform().ToMatrix();
+		//The node caches its world matrix, so there's no conversion here.
+		const Matrix4x4& elemWorld = elem->Spatial->GetWorldMatrix();
 
 		//First render the global shaders...
 		for(auto gShader = elem->GlobalShaders.begin(); gShader != elem->GlobalShaders.end(); ++gShader)
 		{
 			//Each shader program might not get
 			//access to the WVP matrix if we don't specify in the loop.
-			onDraw(model, *gShader, elemWorld);
+			onDraw(model, *gShader, elemWorld, lod);
 		}
 		
 		//Then the local shaders.
 		for(U32 i = 0; i < elem->Spatial->GetNumLocalShaders(); ++i)
 		{
 			auto lShader = elem->Spatial->GetLocalShader(i);
-			onDraw(model, lShader, elemWorld);
+			onDraw(model, lShader, elemWorld, lod);
 		}
 	}
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "DataStructures/STLContainers.h"
 #include "Rendering/Camera/Camera.h"
 #include "EngineLogic/SceneGraph/GroupingNode.h"
+#include "EngineLogic/SceneGraph/TransformHierarchy.h"
+#include "EngineLogic/SceneGraph/ModelNode.h"
+#include "Rendering/Bounds/SphereBounds.h"
 #include "Culling/Culler.h"
 #include "ResourceManagement/ResourceManager.h"
 
@@ -21,6 +24,8 @@ namespace LeEK
 		GfxWrapperHandle gfx;
 		CameraHandle camera;
 		TypedHandle<GroupingNode> sceneRoot;
+		//Flattened scene graph, used to update world transforms.
+		TransformHierarchy transHierarchy;
 		TypedHandle<Culler> culler;
 		TypedHandle<ResourceManager> resMgr;
 		ResGUID defaultTexGUID;
@@ -30,21 +35,38 @@ namespace LeEK
 		//Stats.
 		//Can probably be kept in a compiler option, or something.
 		U64 numModelsDrawn;
+		U64 numLowerLODsDrawn;
+		U32 numTransformsUpdated;
+
+		//LOD selection parameters.
+		F32 lodPixelError;
+		F32 lodHysteresis;
 
 		void notifyCullerNodeAdded(SpatialHnd node);
 		void notifyCullerNodeMoved(SpatialHnd node);
 		void notifyCullerNodeRemoved(SpatialHnd node);
 		void notifyCullerNodeUpdated(SpatialHnd node);
+		/**
+		Recalculates world transforms for any nodes that moved since the last frame.
+		*/
+		void updateTransforms();
+		/**
+		Picks the detail level to draw a model node at this frame,
+		and records it on the node.
+		@param errorToPixelsPerDist the number of pixels a unit of error covers
+		at a unit distance from the camera.
+		*/
+		U32 selectLOD(ModelNode& node, const Model& model, const SphereBounds& worldBounds, F32 worldScale, F32 errorToPixelsPerDist);
 	protected:
 		void setTextures(const Material& mat);
 		/**
 		Draws the specified model to the drawing surface.
 		@param model the model to be drawn. All of its geometry must have been initialized via InitGeometry().
 		*/
-		void drawModel(Model& model);
+		void drawModel(Model& model, U32 lod = 0);
 		void setLightUniforms(const Shader& shader);
 		void setTexUniforms(const Shader& shader);
-		void onDraw(Model& model, TypedHandle<Shader> shader, const Matrix4x4& worldMat);
+		void onDraw(Model& model, TypedHandle<Shader> shader, const Matrix4x4& worldMat, U32 lod = 0);
 	public:
 		Renderer(	GfxWrapperHandle pGfx, CameraHandle pCam,
 					TypedHandle<Culler> pCuller, TypedHandle<ResourceManager> pResMgr,
@@ -66,6 +88,27 @@ namespace LeEK
 		const Matrix4x4& GetCurrWorldMatrix() const;
 
 		U64 GetNumModelsDrawn() const;
+		/**
+		Gets the number of models drawn below full detail during the last DrawScene().
+		*/
+		U64 GetNumLowerLODsDrawn() const;
+		/**
+		Gets the number of world transforms recalculated during the last DrawScene().
+		*/
+		U32 GetNumTransformsUpdated() const;
+		/**
+		Sets how large, in pixels, a model's simplification error
+		can get on screen before a more detailed LOD is used.
+		Set to 0 to always draw at full detail.
+		*/
+		void SetLODPixelError(F32 pixels);
+		F32 GetLODPixelError() const;
+		/**
+		Sets how far past the error threshold, as a fraction of it,
+		a model must get before switching LODs.
+		*/
+		void SetLODHysteresis(F32 fraction);
+		F32 GetLODHysteresis() const;
 		//void PushWorldMatrix(const Matrix4x4& mat);
 		//Matrix4x4 PopWorldMatrix();
 
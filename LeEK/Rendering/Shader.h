@@ -44,5 +44,8 @@ namespace LeEK
 		inline U32 ProgramHandle() { return programHandle; }
 		inline U32 GetUniformHandle(const String& name) { return uniformToHandleMap[name]; }
 		inline U32 GetUniformHandle(const HashedString& name) { return uniformToHandleMap[name]; }
+		//GetUniformHandle() returns 0 for missing uniforms, which is a valid location;
+		//check with this first for optional uniforms.
+		inline bool HasUniform(const String& name) const { return uniformToHandleMap.count(name) > 0; }
 	};
 }
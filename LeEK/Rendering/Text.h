@@ -3,6 +3,7 @@
 #include "Strings/String.h"
 #include "Rendering/Geometry.h"
 #include "Math/Vector3.h"
+#include "DataStructures/STLContainers.h"
 
 namespace LeEK
 {
@@ -21,6 +22,30 @@ namespace LeEK
 		}
 	};
 
+	//A span of a text's quads that all sample the same glyph page.
+	struct TextRun
+	{
+		U32 Page;
+		U32 FirstQuad;
+		U32 NumQuads;
+
+		TextRun() : Page(0), FirstQuad(0), NumQuads(0) {}
+		TextRun(U32 page, U32 firstQuad, U32 numQuads) : Page(page), FirstQuad(firstQuad), NumQuads(numQuads) {}
+	};
+
+	/**
+	A string laid out in a font, in pixels at the font's base size, with the first baseline at 0.
+	Only visible glyphs get a quad, and the quads are grouped by the page their glyph is on,
+	so each run can be drawn with a single texture.
+	*/
+	struct TextLayout
+	{
+		Vector<TextVertex> Vertices;
+		Vector<TextRun> Runs;
+
+		U32 QuadCount() const { return Vertices.size() / 4; }
+	};
+
 	//class for storing text geometry.
 	class TextGeom : public GeomBase<TextVertex, U32>
 	{
@@ -33,9 +58,14 @@ namespace LeEK
 	{
 	private:
 		TextGeom geom;
+		//Which part of geom goes with which glyph page.
+		Vector<TextRun> runs;
 		const Font* font;
 		String str;
-		//properties?
+		//Height of a line in pixels; 0 draws at the size the font's atlas was rendered at.
+		F32 size;
+		//The font's layout version when the geometry was built; see Font::GetLayoutVersion().
+		U32 layoutVersion;
 		bool geomReady;
 
 	public:
@@ -45,10 +75,12 @@ namespace LeEK
 		//Returns true if the text geometry doesn't need to be recalculated.
 		//In general, the geometry needs to be recalculated whenever the characters or the font change;
 		//It's a good idea to keep static text in separate objects to reduce the need for rebuilding.
-		bool GeometryReady() const { return geomReady; }
+		//It also needs rebuilding if the font's had to evict glyphs the text was using.
+		bool GeometryReady() const;
 
 		const TextGeom& GetGeometry() const { return geom; }
 		TextGeom& GetGeometry() { return geom; }
+		const Vector<TextRun>& GetRuns() const { return runs; }
 
 		const Font& GetFont()
 		const {
@@ -60,7 +92,11 @@ namespace LeEK
 		const String& GetString() const { return str; }
 		void SetString(const String& val);
 
-		//Generates the geometry needed to render the text.
+		//Fonts are distance fields, so text can be drawn at any size without rebuilding the font.
+		F32 GetSize() const { return size; }
+		void SetSize(F32 val);
+
+		//Fills in the geometry needed to render the text, from the font's cached layout of the string.
 		void RebuildGeometry();
 	};
 }
\ No newline at end of file
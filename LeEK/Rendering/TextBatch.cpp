@@ -0,0 +1,80 @@
+#include "TextBatch.h"
+#include "Font.h"
+
+using namespace LeEK;
+
+TextBatch::TextBatch(void) : numRuns(0), numTexts(0)
+{
+}
+
+TextBatch::~TextBatch(void)
+{
+}
+
+void TextBatch::Clear()
+{
+	for(U32 i = 0; i < numRuns; ++i)
+	{
+		runs[i].Vertices.clear();
+	}
+	numRuns = 0;
+	numTexts = 0;
+}
+
+TextBatch::PageRun& TextBatch::findRun(U32 texture)
+{
+	//there's rarely more than a handful of pages, so a linear search is fine
+	for(U32 i = 0; i < numRuns; ++i)
+	{
+		if(runs[i].Texture == texture)
+		{
+			return runs[i];
+		}
+	}
+	if(numRuns == runs.size())
+	{
+		runs.push_back(PageRun());
+	}
+	PageRun& run = runs[numRuns];
+	++numRuns;
+	run.Texture = texture;
+	run.Vertices.clear();
+	return run;
+}
+
+void TextBatch::Add(Text& text, const Vector3& offset)
+{
+	if(!text.GeometryReady())
+	{
+		text.RebuildGeometry();
+	}
+	++numTexts;
+	const TextGeom& geom = text.GetGeometry();
+	const Font& font = text.GetFont();
+	const Vector<TextRun>& textRuns = text.GetRuns();
+	for(U32 r = 0; r < textRuns.size(); ++r)
+	{
+		const TextRun& textRun = textRuns[r];
+		PageRun& run = findRun(font.GetPageTexture(textRun.Page));
+		const U32 numVerts = textRun.NumQuads * 4;
+		const U32 start = run.Vertices.size();
+		run.Vertices.resize(start + numVerts);
+		const TextVertex* src = geom.Vertices() + (textRun.FirstQuad * 4);
+		TextVertex* dest = &run.Vertices[start];
+		for(U32 i = 0; i < numVerts; ++i)
+		{
+			dest[i].Position = src[i].Position + offset;
+			dest[i].TexCoord = src[i].TexCoord;
+		}
+	}
+}
+
+U32 TextBatch::QuadCount() const
+{
+	U32 result = 0;
+	for(U32 i = 0; i < numRuns; ++i)
+	{
+		result += runs[i].QuadCount();
+	}
+	return result;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Datatypes.h"
+#include "Rendering/Text.h"
+#include "Math/Vector3.h"
+#include "DataStructures/STLContainers.h"
+
+namespace LeEK
+{
+	/**
+	Gathers the glyph quads of many Text objects into one vertex array per glyph page,
+	so a frame's text can be drawn with a draw call per page instead of one per Text.
+	Texts keep their laid out quads between frames and only lay them out again
+	when their string, font or size change, so adding an unchanged Text is just a copy.
+	Refill the batch every frame, and draw it with IGraphicsWrapper::Draw(const TextBatch&).
+	A Text should either be batched or drawn on its own, not both.
+	*/
+	class TextBatch
+	{
+	public:
+		//The quads of every Text using a glyph page, in the order the Texts were added.
+		struct PageRun
+		{
+			//The page's texture handle.
+			U32 Texture;
+			Vector<TextVertex> Vertices;
+
+			PageRun() : Texture(0) {}
+			U32 QuadCount() const { return Vertices.size() / 4; }
+		};
+	private:
+		//Runs past numRuns are left from earlier frames, and kept so their memory's reused.
+		Vector<PageRun> runs;
+		U32 numRuns;
+		U32 numTexts;
+
+		PageRun& findRun(U32 texture);
+	public:
+		TextBatch(void);
+		~TextBatch(void);
+
+		//Empties the batch, keeping its memory for the next frame.
+		void Clear();
+		/**
+		Adds a text's quads, moved by offset.
+		Lays the text out first if it's changed since it was last added.
+		*/
+		void Add(Text& text, const Vector3& offset);
+
+		U32 RunCount() const { return numRuns; }
+		const PageRun& GetRun(U32 index) const { return runs[index]; }
+		U32 TextCount() const { return numTexts; }
+		U32 QuadCount() const;
+	};
+}
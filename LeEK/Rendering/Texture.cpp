@@ -3,6 +3,56 @@
 
 using namespace LeEK;
 
+namespace
+{
+	//Bytes per pixel of each PixelType.
+	const U32 pixelSizes[Texture2D::PIXTYPE_LEN] = { 4, 3, 4, 2, 1 };
+	//Bytes per 4x4 block of each CompressionType.
+	const U32 blockSizes[Texture2D::COMPTYPE_LEN] = { 0, 8, 16, 16 };
+}
+
+U32 Texture2D::LevelSize(U32 level) const
+{
+	return ImageSize(PixType, CompType, LevelWidth(level), LevelHeight(level));
+}
+
+U32 Texture2D::LevelOffset(U32 level) const
+{
+	U32 offset = 0;
+	for(U32 i = 0; i < level; ++i)
+	{
+		offset += LevelSize(i);
+	}
+	return offset;
+}
+
+U32 Texture2D::DataSize() const
+{
+	return LevelOffset(MipCount());
+}
+
+U32 Texture2D::FullMipCount(U32 width, U32 height)
+{
+	U32 count = 1;
+	while(width > 1 || height > 1)
+	{
+		width >>= 1;
+		height >>= 1;
+		++count;
+	}
+	return count;
+}
+
+U32 Texture2D::ImageSize(PixelType pixType, CompressionType compType, U32 width, U32 height)
+{
+	if(compType != NONE)
+	{
+		//partial blocks at the edges still take a whole block.
+		return ((width + 3) / 4) * ((height + 3) / 4) * blockSizes[compType];
+	}
+	return width * height * pixelSizes[pixType];
+}
+
 Texture2D Texture2D::BuildSolidRGBA8Tex(U32 width, U32 height, const Color& color)
 {
 	Texture2D res = Texture2D();
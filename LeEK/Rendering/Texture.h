@@ -20,7 +20,12 @@ namespace LeEK
 		char* Data;
 		
 		enum PixelType { RGBA8, RGB8, BGRA8, RGB565, BYTE, PIXTYPE_LEN };
-		enum CompressionType { NONE, DXT1, /*CRUNCH,*/ COMPTYPE_LEN };
+		//DXT1 is BC1 and DXT5 is BC3; both work on 4x4 pixel blocks, as does BC7.
+		enum CompressionType { NONE, DXT1, DXT5, BC7, /*CRUNCH,*/ COMPTYPE_LEN };
+		//Largest width or height a texture can have.
+		//No format's over 4 bytes a pixel, so at this size
+		//even a full mip chain's size fits in a U32.
+		static const U32 MAX_DIMENSION = 16384;
 
 		//general info about texture.
 		PixelType PixType;
@@ -29,12 +34,29 @@ namespace LeEK
 		U32 Width, Height;
 		U8 BitDepth;
 		bool HasMipMap;
+		//If HasMipMap is set, Data holds this many levels back to back, largest first.
+		U8 NumMips;
 
 		Texture2D()
 		{
 			memset(this, 0, sizeof(Texture2D));
 		}
 
+		inline bool IsCompressed() const { return CompType != NONE; }
+		inline U32 MipCount() const { return HasMipMap ? NumMips : 1; }
+		inline U32 LevelWidth(U32 level) const { return Width >> level ? Width >> level : 1; }
+		inline U32 LevelHeight(U32 level) const { return Height >> level ? Height >> level : 1; }
+		//Size in bytes of the given level.
+		U32 LevelSize(U32 level) const;
+		//Offset from Data of the given level.
+		U32 LevelOffset(U32 level) const;
+		//Size in bytes of every level in Data.
+		U32 DataSize() const;
+
+		//Number of levels in a full mip chain, down to 1x1.
+		static U32 FullMipCount(U32 width, U32 height);
+		//Size in bytes of an image of the given format and dimensions.
+		static U32 ImageSize(PixelType pixType, CompressionType compType, U32 width, U32 height);
 		static Texture2D BuildSolidRGBA8Tex(U32 width, U32 height, const Color& color);
 	};
 
@@ -0,0 +1,791 @@
+#include "TextureCompression.h"
+#include "Constants/AllocTypes.h"
+#include "Memory/Allocator.h"
+#include "Math/MathFunctions.h"
+#include "MultiThreading/StdThreading.h"
+#include "DataStructures/STLContainers.h"
+#include <cmath>
+#include <cstring>
+
+using namespace LeEK;
+using namespace TextureCompression;
+
+namespace
+{
+	const U32 BLOCK_PIXELS = BLOCK_DIM * BLOCK_DIM;
+	//How far along the endpoint line each BC1 index is.
+	const F32 BC1_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	//Same for BC7's 4-bit indices, out of 64.
+	const U32 BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	//Iterations used to find a block's principal axis.
+	const U32 POWER_ITERATIONS = 8;
+
+	typedef F32 BlockPixels[BLOCK_PIXELS][4];
+
+	void toFloats(const U8* pixels, BlockPixels& px)
+	{
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			for(U32 c = 0; c < 4; ++c)
+			{
+				px[i][c] = (F32)pixels[i * 4 + c];
+			}
+		}
+	}
+
+	/**
+	Fits a line through the block's colors along their principal axis,
+	and sets the endpoints to the colors furthest apart along it.
+	Only the first numChannels channels are looked at.
+	*/
+	void fitEndpoints(const BlockPixels& px, U32 numChannels, F32* e0, F32* e1)
+	{
+		F32 mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		F32 minC[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+		F32 maxC[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			for(U32 c = 0; c < numChannels; ++c)
+			{
+				mean[c] += px[i][c];
+				minC[c] = Math::Min(minC[c], px[i][c]);
+				maxC[c] = Math::Max(maxC[c], px[i][c]);
+			}
+		}
+		F32 cov[4][4];
+		memset(cov, 0, sizeof(cov));
+		for(U32 c = 0; c < numChannels; ++c)
+		{
+			mean[c] /= BLOCK_PIXELS;
+		}
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			for(U32 a = 0; a < numChannels; ++a)
+			{
+				for(U32 b = 0; b < numChannels; ++b)
+				{
+					cov[a][b] += (px[i][a] - mean[a]) * (px[i][b] - mean[b]);
+				}
+			}
+		}
+
+		//Power iteration, starting from the block's bounding box diagonal.
+		F32 axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for(U32 c = 0; c < numChannels; ++c)
+		{
+			axis[c] = maxC[c] - minC[c];
+		}
+		for(U32 iter = 0; iter < POWER_ITERATIONS; ++iter)
+		{
+			F32 next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			F32 largest = 0.0f;
+			for(U32 a = 0; a < numChannels; ++a)
+			{
+				for(U32 b = 0; b < numChannels; ++b)
+				{
+					next[a] += cov[a][b] * axis[b];
+				}
+				largest = Math::Max(largest, fabsf(next[a]));
+			}
+			if(largest <= 0.0f)
+			{
+				break;
+			}
+			for(U32 c = 0; c < numChannels; ++c)
+			{
+				axis[c] = next[c] / largest;
+			}
+		}
+		F32 axisLenSq = 0.0f;
+		for(U32 c = 0; c < numChannels; ++c)
+		{
+			axisLenSq += axis[c] * axis[c];
+		}
+		if(axisLenSq <= 0.0f)
+		{
+			//every pixel's the same color.
+			memcpy(e0, mean, sizeof(F32) * numChannels);
+			memcpy(e1, mean, sizeof(F32) * numChannels);
+			return;
+		}
+
+		F32 tMin = 0.0f, tMax = 0.0f;
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			F32 t = 0.0f;
+			for(U32 c = 0; c < numChannels; ++c)
+			{
+				t += (px[i][c] - mean[c]) * axis[c];
+			}
+			tMin = Math::Min(tMin, t);
+			tMax = Math::Max(tMax, t);
+		}
+		for(U32 c = 0; c < numChannels; ++c)
+		{
+			e0[c] = Math::Clamp(mean[c] + axis[c] * tMin / axisLenSq, 0.0f, 255.0f);
+			e1[c] = Math::Clamp(mean[c] + axis[c] * tMax / axisLenSq, 0.0f, 255.0f);
+		}
+	}
+
+	/**
+	Finds the endpoints that best fit the block in the least squares sense,
+	given how far along the line between them each pixel is.
+	Returns false if every pixel has the same weight.
+	*/
+	bool solveEndpoints(const BlockPixels& px, const F32* weights, U32 numChannels, F32* e0, F32* e1)
+	{
+		F32 aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		F32 ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		F32 bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			F32 b = weights[i];
+			F32 a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for(U32 c = 0; c < numChannels; ++c)
+			{
+				ax[c] += a * px[i][c];
+				bx[c] += b * px[i][c];
+			}
+		}
+		F32 det = aa * bb - ab * ab;
+		if(fabsf(det) < 1e-6f)
+		{
+			return false;
+		}
+		for(U32 c = 0; c < numChannels; ++c)
+		{
+			e0[c] = Math::Clamp((bb * ax[c] - ab * bx[c]) / det, 0.0f, 255.0f);
+			e1[c] = Math::Clamp((aa * bx[c] - ab * ax[c]) / det, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	//Finds the palette entry closest to each pixel, returning the block's total squared error.
+	U32 pickIndices(const U8* pixels, const U8 (*palette)[4], U32 paletteSize, U32 numChannels, U8* indices)
+	{
+		U32 totalErr = 0;
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			U32 bestErr = 0xFFFFFFFF;
+			for(U32 p = 0; p < paletteSize; ++p)
+			{
+				U32 err = 0;
+				for(U32 c = 0; c < numChannels; ++c)
+				{
+					I32 diff = (I32)pixels[i * 4 + c] - (I32)palette[p][c];
+					err += diff * diff;
+				}
+				if(err < bestErr)
+				{
+					bestErr = err;
+					indices[i] = (U8)p;
+				}
+			}
+			totalErr += bestErr;
+		}
+		return totalErr;
+	}
+
+	//Packs bits into a block, least significant bit first.
+	class BitWriter
+	{
+	private:
+		U8* out;
+		U32 pos;
+	public:
+		BitWriter(U8* outParam, U32 size) : out(outParam), pos(0)
+		{
+			memset(out, 0, size);
+		}
+		void Write(U32 val, U32 numBits)
+		{
+			for(U32 i = 0; i < numBits; ++i, ++pos)
+			{
+				out[pos >> 3] |= (U8)(((val >> i) & 1) << (pos & 7));
+			}
+		}
+	};
+
+	class BitReader
+	{
+	private:
+		const U8* in;
+		U32 pos;
+	public:
+		BitReader(const U8* inParam) : in(inParam), pos(0) {}
+		U32 Read(U32 numBits)
+		{
+			U32 val = 0;
+			for(U32 i = 0; i < numBits; ++i, ++pos)
+			{
+				val |= (U32)((in[pos >> 3] >> (pos & 7)) & 1) << i;
+			}
+			return val;
+		}
+	};
+
+	//BC1 and BC3's color half.
+
+	U16 toRGB565(const F32* color)
+	{
+		U32 r = (U32)(color[0] * 31.0f / 255.0f + 0.5f);
+		U32 g = (U32)(color[1] * 63.0f / 255.0f + 0.5f);
+		U32 b = (U32)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (U16)((r << 11) | (g << 5) | b);
+	}
+
+	void fromRGB565(U16 packed, U8* color)
+	{
+		U32 r = (packed >> 11) & 0x1F;
+		U32 g = (packed >> 5) & 0x3F;
+		U32 b = packed & 0x1F;
+		color[0] = (U8)((r << 3) | (r >> 2));
+		color[1] = (U8)((g << 2) | (g >> 4));
+		color[2] = (U8)((b << 3) | (b >> 2));
+		color[3] = 255;
+	}
+
+	//Only the four color palette's needed; encoded blocks always use it.
+	void buildColorPalette(U16 c0, U16 c1, U8 (*palette)[4])
+	{
+		fromRGB565(c0, palette[0]);
+		fromRGB565(c1, palette[1]);
+		for(U32 c = 0; c < 4; ++c)
+		{
+			palette[2][c] = (U8)((2 * palette[0][c] + palette[1][c]) / 3);
+			palette[3][c] = (U8)((palette[0][c] + 2 * palette[1][c]) / 3);
+		}
+	}
+
+	void compressColorBlock(const U8* pixels, const BlockPixels& px, U8* out)
+	{
+		F32 e0[4], e1[4];
+		fitEndpoints(px, 3, e0, e1);
+		U16 c0 = toRGB565(e1);
+		U16 c1 = toRGB565(e0);
+		U8 palette[4][4];
+		U8 indices[BLOCK_PIXELS];
+		buildColorPalette(c0, c1, palette);
+		U32 err = pickIndices(pixels, palette, 4, 3, indices);
+
+		//refit the endpoints to the indices that were picked.
+		F32 weights[BLOCK_PIXELS];
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			weights[i] = BC1_WEIGHTS[indices[i]];
+		}
+		if(solveEndpoints(px, weights, 3, e0, e1))
+		{
+			U16 refit0 = toRGB565(e0);
+			U16 refit1 = toRGB565(e1);
+			U8 refitPalette[4][4];
+			U8 refitIndices[BLOCK_PIXELS];
+			buildColorPalette(refit0, refit1, refitPalette);
+			U32 refitErr = pickIndices(pixels, refitPalette, 4, 3, refitIndices);
+			if(refitErr < err)
+			{
+				c0 = refit0;
+				c1 = refit1;
+				memcpy(indices, refitIndices, sizeof(indices));
+			}
+		}
+
+		U32 packedIndices = 0;
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			packedIndices |= (U32)indices[i] << (i * 2);
+		}
+		//The decoder only uses the four color palette if c0 > c1;
+		//swapping the endpoints swaps indices 0 and 1, and 2 and 3.
+		if(c0 < c1)
+		{
+			U16 swap = c0;
+			c0 = c1;
+			c1 = swap;
+			packedIndices ^= 0x55555555;
+		}
+		else if(c0 == c1)
+		{
+			packedIndices = 0;
+		}
+		out[0] = (U8)(c0 & 0xFF);
+		out[1] = (U8)(c0 >> 8);
+		out[2] = (U8)(c1 & 0xFF);
+		out[3] = (U8)(c1 >> 8);
+		for(U32 i = 0; i < 4; ++i)
+		{
+			out[4 + i] = (U8)(packedIndices >> (i * 8));
+		}
+	}
+
+	void decompressColorBlock(const U8* block, bool allowThreeColor, U8* pixels)
+	{
+		U16 c0 = (U16)(block[0] | (block[1] << 8));
+		U16 c1 = (U16)(block[2] | (block[3] << 8));
+		U8 palette[4][4];
+		buildColorPalette(c0, c1, palette);
+		if(allowThreeColor && c0 <= c1)
+		{
+			for(U32 c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (U8)((palette[0][c] + palette[1][c]) / 2);
+				palette[3][c] = 0;
+			}
+		}
+		U32 packedIndices = block[4] | (block[5] << 8) | (block[6] << 16) | ((U32)block[7] << 24);
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			memcpy(pixels + i * 4, palette[(packedIndices >> (i * 2)) & 3], 3);
+		}
+	}
+
+	//BC3's alpha half.
+
+	void buildAlphaPalette(U8 a0, U8 a1, U8 (*palette)[4])
+	{
+		palette[0][0] = a0;
+		palette[1][0] = a1;
+		for(U32 i = 2; i < 8; ++i)
+		{
+			if(a0 > a1)
+			{
+				palette[i][0] = (U8)(((8 - i) * a0 + (i - 1) * a1) / 7);
+			}
+			else if(i < 6)
+			{
+				palette[i][0] = (U8)(((6 - i) * a0 + (i - 1) * a1) / 5);
+			}
+			else
+			{
+				palette[i][0] = i == 6 ? 0 : 255;
+			}
+		}
+	}
+
+	void compressAlphaBlock(const U8* pixels, U8* out)
+	{
+		U8 a0 = 0, a1 = 255;
+		U8 alphas[BLOCK_PIXELS * 4];
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			U8 alpha = pixels[i * 4 + 3];
+			a0 = Math::Max(a0, alpha);
+			a1 = Math::Min(a1, alpha);
+			//pickIndices() looks at the first channel.
+			alphas[i * 4] = alpha;
+		}
+		U8 indices[BLOCK_PIXELS];
+		memset(indices, 0, sizeof(indices));
+		if(a0 > a1)
+		{
+			U8 palette[8][4];
+			buildAlphaPalette(a0, a1, palette);
+			pickIndices(alphas, palette, 8, 1, indices);
+		}
+		BitWriter writer(out, 8);
+		writer.Write(a0, 8);
+		writer.Write(a1, 8);
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			writer.Write(indices[i], 3);
+		}
+	}
+
+	void decompressAlphaBlock(const U8* block, U8* pixels)
+	{
+		BitReader reader(block);
+		U8 a0 = (U8)reader.Read(8);
+		U8 a1 = (U8)reader.Read(8);
+		U8 palette[8][4];
+		buildAlphaPalette(a0, a1, palette);
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			pixels[i * 4 + 3] = palette[reader.Read(3)][0];
+		}
+	}
+
+	//BC7 mode 6.
+
+	const U32 BC7_MODE = 6;
+
+	/**
+	Quantizes an endpoint to 7 bits per channel and a shared low bit,
+	trying both values of the low bit.
+	*/
+	void quantizeBC7(const F32* endpoint, U8* quantized, U8& pBit)
+	{
+		U32 bestErr = 0xFFFFFFFF;
+		for(U8 p = 0; p < 2; ++p)
+		{
+			U8 candidate[4];
+			U32 err = 0;
+			for(U32 c = 0; c < 4; ++c)
+			{
+				I32 q = (I32)((endpoint[c] - p) / 2.0f + 0.5f);
+				candidate[c] = (U8)Math::Clamp(q, 0, 127);
+				I32 diff = (I32)(endpoint[c] + 0.5f) - ((candidate[c] << 1) | p);
+				err += diff * diff;
+			}
+			if(err < bestErr)
+			{
+				bestErr = err;
+				memcpy(quantized, candidate, 4);
+				pBit = p;
+			}
+		}
+	}
+
+	void buildBC7Palette(const U8* q0, U8 p0, const U8* q1, U8 p1, U8 (*palette)[4])
+	{
+		for(U32 c = 0; c < 4; ++c)
+		{
+			U32 v0 = (q0[c] << 1) | p0;
+			U32 v1 = (q1[c] << 1) | p1;
+			for(U32 i = 0; i < 16; ++i)
+			{
+				palette[i][c] = (U8)(((64 - BC7_WEIGHTS[i]) * v0 + BC7_WEIGHTS[i] * v1 + 32) >> 6);
+			}
+		}
+	}
+
+	//Quantizes the given endpoints and picks indices for them, returning the error.
+	U32 evaluateBC7(const U8* pixels, const F32* e0, const F32* e1, U8* q0, U8& p0, U8* q1, U8& p1, U8* indices)
+	{
+		quantizeBC7(e0, q0, p0);
+		quantizeBC7(e1, q1, p1);
+		U8 palette[16][4];
+		buildBC7Palette(q0, p0, q1, p1, palette);
+		return pickIndices(pixels, palette, 16, 4, indices);
+	}
+
+	/**
+	Hands rows of blocks out to every compressing thread.
+	*/
+	class CompressClient : public IThreadClient
+	{
+	private:
+		const U8* rgba;
+		U32 width;
+		U32 height;
+		Texture2D::CompressionType type;
+		U8* out;
+		U32 blocksWide;
+		U32 blocksHigh;
+		U32 blockSize;
+		Mutex rowMutex;
+		U32 nextRow;
+
+		void compressRow(U32 row)
+		{
+			U8 pixels[BLOCK_PIXELS * 4];
+			for(U32 bx = 0; bx < blocksWide; ++bx)
+			{
+				for(U32 y = 0; y < BLOCK_DIM; ++y)
+				{
+					U32 srcY = Math::Min(row * BLOCK_DIM + y, height - 1);
+					for(U32 x = 0; x < BLOCK_DIM; ++x)
+					{
+						U32 srcX = Math::Min(bx * BLOCK_DIM + x, width - 1);
+						memcpy(pixels + (y * BLOCK_DIM + x) * 4, rgba + (srcY * width + srcX) * 4, 4);
+					}
+				}
+				U8* block = out + (row * blocksWide + bx) * blockSize;
+				switch(type)
+				{
+				case Texture2D::DXT1:
+					CompressBlockBC1(pixels, block);
+					break;
+				case Texture2D::DXT5:
+					CompressBlockBC3(pixels, block);
+					break;
+				case Texture2D::BC7:
+					CompressBlockBC7(pixels, block);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	public:
+		CompressClient(const U8* rgbaParam, U32 widthParam, U32 heightParam, Texture2D::CompressionType typeParam, U8* outParam) :
+			rgba(rgbaParam), width(widthParam), height(heightParam), type(typeParam), out(outParam), nextRow(0)
+		{
+			blocksWide = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+			blocksHigh = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+			blockSize = Texture2D::ImageSize(Texture2D::RGBA8, type, BLOCK_DIM, BLOCK_DIM);
+		}
+
+		void Run()
+		{
+			while(true)
+			{
+				U32 row;
+				{
+					Lock lock(rowMutex);
+					if(nextRow >= blocksHigh)
+					{
+						return;
+					}
+					row = nextRow++;
+				}
+				compressRow(row);
+			}
+		}
+	};
+}
+
+void TextureCompression::CompressBlockBC1(const U8* pixels, U8* out)
+{
+	BlockPixels px;
+	toFloats(pixels, px);
+	compressColorBlock(pixels, px, out);
+}
+
+void TextureCompression::CompressBlockBC3(const U8* pixels, U8* out)
+{
+	BlockPixels px;
+	toFloats(pixels, px);
+	compressAlphaBlock(pixels, out);
+	compressColorBlock(pixels, px, out + 8);
+}
+
+void TextureCompression::CompressBlockBC7(const U8* pixels, U8* out)
+{
+	BlockPixels px;
+	toFloats(pixels, px);
+	F32 e0[4], e1[4];
+	fitEndpoints(px, 4, e0, e1);
+	U8 q0[4], q1[4], p0, p1;
+	U8 indices[BLOCK_PIXELS];
+	U32 err = evaluateBC7(pixels, e0, e1, q0, p0, q1, p1, indices);
+
+	//refit the endpoints to the indices that were picked.
+	F32 weights[BLOCK_PIXELS];
+	for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+	}
+	if(solveEndpoints(px, weights, 4, e0, e1))
+	{
+		U8 refitQ0[4], refitQ1[4], refitP0, refitP1;
+		U8 refitIndices[BLOCK_PIXELS];
+		U32 refitErr = evaluateBC7(pixels, e0, e1, refitQ0, refitP0, refitQ1, refitP1, refitIndices);
+		if(refitErr < err)
+		{
+			memcpy(q0, refitQ0, 4);
+			memcpy(q1, refitQ1, 4);
+			p0 = refitP0;
+			p1 = refitP1;
+			memcpy(indices, refitIndices, sizeof(indices));
+		}
+	}
+
+	//The first pixel's index has its top bit left out, so it has to be 0;
+	//swapping the endpoints inverts every index.
+	if(indices[0] & 8)
+	{
+		for(U32 c = 0; c < 4; ++c)
+		{
+			U8 swap = q0[c];
+			q0[c] = q1[c];
+			q1[c] = swap;
+		}
+		U8 swapP = p0;
+		p0 = p1;
+		p1 = swapP;
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	BitWriter writer(out, 16);
+	//the mode's written in unary.
+	writer.Write(1 << BC7_MODE, BC7_MODE + 1);
+	for(U32 c = 0; c < 4; ++c)
+	{
+		writer.Write(q0[c], 7);
+		writer.Write(q1[c], 7);
+	}
+	writer.Write(p0, 1);
+	writer.Write(p1, 1);
+	writer.Write(indices[0], 3);
+	for(U32 i = 1; i < BLOCK_PIXELS; ++i)
+	{
+		writer.Write(indices[i], 4);
+	}
+}
+
+void TextureCompression::DecompressBlock(Texture2D::CompressionType type, const U8* block, U8* pixels)
+{
+	switch(type)
+	{
+	case Texture2D::DXT1:
+		decompressColorBlock(block, true, pixels);
+		for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			pixels[i * 4 + 3] = 255;
+		}
+		break;
+	case Texture2D::DXT5:
+		decompressAlphaBlock(block, pixels);
+		decompressColorBlock(block + 8, false, pixels);
+		break;
+	case Texture2D::BC7:
+		{
+			memset(pixels, 0, BLOCK_PIXELS * 4);
+			BitReader reader(block);
+			if(reader.Read(BC7_MODE + 1) != (1 << BC7_MODE))
+			{
+				return;
+			}
+			U8 q0[4], q1[4];
+			for(U32 c = 0; c < 4; ++c)
+			{
+				q0[c] = (U8)reader.Read(7);
+				q1[c] = (U8)reader.Read(7);
+			}
+			U8 p0 = (U8)reader.Read(1);
+			U8 p1 = (U8)reader.Read(1);
+			U8 palette[16][4];
+			buildBC7Palette(q0, p0, q1, p1, palette);
+			for(U32 i = 0; i < BLOCK_PIXELS; ++i)
+			{
+				memcpy(pixels + i * 4, palette[reader.Read(i == 0 ? 3 : 4)], 4);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void TextureCompression::CompressImage(	const U8* rgba, U32 width, U32 height, Texture2D::CompressionType type,
+										U8* out, U32 numThreads)
+{
+	CompressClient client(rgba, width, height, type, out);
+	U32 blocksHigh = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+	U32 numBlocks = ((width + BLOCK_DIM - 1) / BLOCK_DIM) * blocksHigh;
+	numThreads = Math::Min(numThreads, blocksHigh);
+	if(numThreads <= 1 || numBlocks < MIN_THREADED_BLOCKS)
+	{
+		client.Run();
+		return;
+	}
+	Vector<Thread*> threads;
+	for(U32 i = 0; i < numThreads; ++i)
+	{
+		Thread* thread = LNew(Thread, THREAD_ALLOC, "ThreadAlloc")(&client);
+		thread->Start();
+		threads.push_back(thread);
+	}
+	for(U32 i = 0; i < threads.size(); ++i)
+	{
+		threads[i]->Join();
+		LDelete(threads[i]);
+	}
+}
+
+void TextureCompression::DecompressImage(const U8* data, U32 width, U32 height, Texture2D::CompressionType type, U8* rgbaOut)
+{
+	U32 blocksWide = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+	U32 blocksHigh = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+	U32 blockSize = Texture2D::ImageSize(Texture2D::RGBA8, type, BLOCK_DIM, BLOCK_DIM);
+	U8 pixels[BLOCK_PIXELS * 4];
+	for(U32 by = 0; by < blocksHigh; ++by)
+	{
+		for(U32 bx = 0; bx < blocksWide; ++bx)
+		{
+			DecompressBlock(type, data + (by * blocksWide + bx) * blockSize, pixels);
+			for(U32 y = 0; y < BLOCK_DIM && by * BLOCK_DIM + y < height; ++y)
+			{
+				for(U32 x = 0; x < BLOCK_DIM && bx * BLOCK_DIM + x < width; ++x)
+				{
+					memcpy(	rgbaOut + ((by * BLOCK_DIM + y) * width + bx * BLOCK_DIM + x) * 4,
+							pixels + (y * BLOCK_DIM + x) * 4, 4);
+				}
+			}
+		}
+	}
+}
+
+void TextureCompression::DownsampleRGBA8(const U8* src, U32 srcWidth, U32 srcHeight, U8* dest)
+{
+	U32 destWidth = Math::Max(srcWidth / 2, 1U);
+	U32 destHeight = Math::Max(srcHeight / 2, 1U);
+	for(U32 y = 0; y < destHeight; ++y)
+	{
+		const U8* row0 = src + (y * 2) * srcWidth * 4;
+		const U8* row1 = src + Math::Min(y * 2 + 1, srcHeight - 1) * srcWidth * 4;
+		for(U32 x = 0; x < destWidth; ++x)
+		{
+			U32 x0 = x * 2 * 4;
+			U32 x1 = Math::Min(x * 2 + 1, srcWidth - 1) * 4;
+			for(U32 c = 0; c < 4; ++c)
+			{
+				dest[(y * destWidth + x) * 4 + c] = (U8)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+			}
+		}
+	}
+}
+
+bool TextureCompression::HasAlpha(const U8* rgba, U32 width, U32 height)
+{
+	U32 numPixels = width * height;
+	for(U32 i = 0; i < numPixels; ++i)
+	{
+		if(rgba[i * 4 + 3] != 255)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TextureCompression::CookTexture(	const U8* rgba, U32 width, U32 height, Texture2D::CompressionType type,
+										bool buildMips, U32 numThreads, Texture2D& texOut)
+{
+	if(!rgba || !width || !height || type >= Texture2D::COMPTYPE_LEN)
+	{
+		return false;
+	}
+	texOut = Texture2D();
+	texOut.PixType = Texture2D::RGBA8;
+	texOut.CompType = type;
+	texOut.BitDepth = 32;
+	texOut.Width = width;
+	texOut.Height = height;
+	texOut.HasMipMap = buildMips;
+	texOut.NumMips = (U8)(buildMips ? Texture2D::FullMipCount(width, height) : 1);
+	texOut.Data = LArrayNew(char, texOut.DataSize(), RENDERER_ALLOC, "RendererAlloc");
+
+	//each level's filtered from the one before it.
+	Vector<U8> levelPixels;
+	Vector<U8> nextPixels;
+	const U8* currPixels = rgba;
+	for(U32 level = 0; level < texOut.MipCount(); ++level)
+	{
+		U32 levelWidth = texOut.LevelWidth(level);
+		U32 levelHeight = texOut.LevelHeight(level);
+		if(level > 0)
+		{
+			nextPixels.resize(levelWidth * levelHeight * 4);
+			DownsampleRGBA8(currPixels, texOut.LevelWidth(level - 1), texOut.LevelHeight(level - 1), &nextPixels[0]);
+			levelPixels.swap(nextPixels);
+			currPixels = &levelPixels[0];
+		}
+		U8* levelData = (U8*)texOut.Data + texOut.LevelOffset(level);
+		if(type == Texture2D::NONE)
+		{
+			memcpy(levelData, currPixels, texOut.LevelSize(level));
+		}
+		else
+		{
+			CompressImage(currPixels, levelWidth, levelHeight, type, levelData, numThreads);
+		}
+	}
+	return true;
+}
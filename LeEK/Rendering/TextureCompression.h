@@ -0,0 +1,60 @@
+#pragma once
+#include "Datatypes.h"
+#include "Rendering/Texture.h"
+
+namespace LeEK
+{
+	/**
+	Mip generation and block compression, for cooking textures offline.
+	Images are RGBA8, with their rows in whatever order the caller keeps them;
+	nothing here cares which row is the top.
+	*/
+	namespace TextureCompression
+	{
+		//Pixels per side of a compressed block.
+		const U32 BLOCK_DIM = 4;
+		//Images with fewer blocks than this are compressed on the calling thread.
+		const U32 MIN_THREADED_BLOCKS = 256;
+
+		/**
+		Compresses one 4x4 block of RGBA8 pixels, given row by row.
+		BC1 blocks are 8 bytes and ignore alpha; BC3 and BC7 blocks are 16 bytes.
+		*/
+		void CompressBlockBC1(const U8* pixels, U8* out);
+		void CompressBlockBC3(const U8* pixels, U8* out);
+		//Only writes mode 6 blocks: one RGBA endpoint pair with 4-bit indices.
+		void CompressBlockBC7(const U8* pixels, U8* out);
+		/**
+		Unpacks a block back to 16 RGBA8 pixels, for measuring compression error.
+		Only mode 6 BC7 blocks can be unpacked; others come out black.
+		*/
+		void DecompressBlock(Texture2D::CompressionType type, const U8* block, U8* pixels);
+
+		/**
+		Block compresses an image, splitting its rows of blocks between numThreads threads.
+		Blocks past the edges of images that aren't multiples of 4 repeat the last row and column.
+		@param out needs Texture2D::ImageSize() bytes.
+		*/
+		void CompressImage(	const U8* rgba, U32 width, U32 height, Texture2D::CompressionType type,
+							U8* out, U32 numThreads);
+		//Unpacks a whole compressed image back to RGBA8.
+		void DecompressImage(const U8* data, U32 width, U32 height, Texture2D::CompressionType type, U8* rgbaOut);
+
+		/**
+		Box filters an image down to the next mip level, which is half the size, rounded down.
+		Odd dimensions drop their last row or column.
+		*/
+		void DownsampleRGBA8(const U8* src, U32 srcWidth, U32 srcHeight, U8* dest);
+
+		//True if any pixel's alpha isn't 255.
+		bool HasAlpha(const U8* rgba, U32 width, U32 height);
+
+		/**
+		Builds a texture of the given compression type from an RGBA8 image,
+		with a full mip chain if buildMips is set.
+		The texture's data is allocated here; release it with LArrayDelete().
+		*/
+		bool CookTexture(	const U8* rgba, U32 width, U32 height, Texture2D::CompressionType type,
+							bool buildMips, U32 numThreads, Texture2D& texOut);
+	}
+}
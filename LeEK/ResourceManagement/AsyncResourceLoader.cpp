@@ -0,0 +1,384 @@
+#include "AsyncResourceLoader.h"
+#include "FileManagement/AsyncDataStream.h"
+#include "Constants/AllocTypes.h"
+#include "Logging/Log.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace LeEK;
+
+ResourceRequest::ResourceRequest(const ResGUID& resGUID, I32 priorityParam) : guid(resGUID), callbacks(), resource(), loader()
+{
+	priority = priorityParam;
+	sequence = 0;
+	state = PENDING;
+	archive = NULL;
+	needsUnpack = false;
+	packedBuf = NULL;
+	packedView = NULL;
+	packedSize = 0;
+	rawBuf = NULL;
+	rawSize = 0;
+	uncounted = false;
+	decodeUs = 0;
+	succeeded = false;
+}
+
+ResourceRequest::~ResourceRequest()
+{
+	//the manager should've taken care of these,
+	//but don't leak them if it didn't.
+	CustomArrayDelete(packedBuf);
+	CustomArrayDelete(rawBuf);
+}
+
+void ResourceRequest::AddCallback(ResLoadedCallback callback, void* userData)
+{
+	if(!callback)
+	{
+		return;
+	}
+	if(IsFinished())
+	{
+		callback(ResPtr(resource), userData);
+		return;
+	}
+	callbacks.push_back(Callback(callback, userData));
+}
+
+AsyncResourceLoader::AsyncResourceLoader() : ioClient(this), decodeClient(this)
+{
+	archiveMutex = NULL;
+	stopping = false;
+	nextSequence = 0;
+	numReading = 0;
+	ioThread = NULL;
+}
+
+AsyncResourceLoader::~AsyncResourceLoader()
+{
+	Stop();
+}
+
+bool AsyncResourceLoader::requestLess(const ResRequestPtr& lhs, const ResRequestPtr& rhs)
+{
+	//the top of the heap is the highest priority request,
+	//or the oldest if priorities tie.
+	if(lhs->priority != rhs->priority)
+	{
+		return lhs->priority < rhs->priority;
+	}
+	return lhs->sequence > rhs->sequence;
+}
+
+void AsyncResourceLoader::Start(TypedHandle<ResourceManager> managerHnd, Mutex* archiveMutexParam, U32 numDecodeThreads)
+{
+	if(IsRunning())
+	{
+		return;
+	}
+	manager = managerHnd;
+	archiveMutex = archiveMutexParam;
+	stopping = false;
+	if(numDecodeThreads == 0)
+	{
+		//leave room for the main thread and the I/O thread.
+		U32 hwThreads = std::thread::hardware_concurrency();
+		numDecodeThreads = hwThreads > 2 ? hwThreads - 2 : 1;
+	}
+
+	ioThread = LNew(Thread, THREAD_ALLOC, "ThreadAlloc")(&ioClient);
+	ioThread->Start();
+	for(U32 i = 0; i < numDecodeThreads; ++i)
+	{
+		Thread* decodeThread = LNew(Thread, THREAD_ALLOC, "ThreadAlloc")(&decodeClient);
+		decodeThread->Start();
+		decodeThreads.push_back(decodeThread);
+	}
+	LogV(String("Started async loading with ") + numDecodeThreads + " decode threads");
+}
+
+void AsyncResourceLoader::Stop()
+{
+	if(!IsRunning())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+		stopping = true;
+	}
+	ioReady.notify_all();
+	decodeReady.notify_all();
+	ioThread->Join();
+	LDelete(ioThread);
+	ioThread = NULL;
+	//reads in flight still need their buffers, so let them land.
+	{
+		std::unique_lock<std::mutex> lock(queueMutex.GetMutex());
+		while(numReading > 0)
+		{
+			readsDone.wait(lock);
+		}
+	}
+	for(U32 i = 0; i < decodeThreads.size(); ++i)
+	{
+		decodeThreads[i]->Join();
+		LDelete(decodeThreads[i]);
+	}
+	decodeThreads.clear();
+
+	//Anything still queued never got loaded.
+	RequestHeap* queues[] = { &ioQueue, &decodeQueue };
+	for(U32 i = 0; i < 2; ++i)
+	{
+		for(U32 j = 0; j < queues[i]->size(); ++j)
+		{
+			(*queues[i])[j]->succeeded = false;
+			finishedQueue.push_back((*queues[i])[j]);
+		}
+		queues[i]->clear();
+	}
+}
+
+void AsyncResourceLoader::Enqueue(const ResRequestPtr& request)
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+		request->sequence = nextSequence++;
+	}
+	pushRequest(ioQueue, ioReady, request);
+}
+
+void AsyncResourceLoader::TakeFinished(List<ResRequestPtr>& out, U32 maxRequests)
+{
+	std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+	U32 numTaken = 0;
+	while(!finishedQueue.empty() && (maxRequests == 0 || numTaken < maxRequests))
+	{
+		out.push_back(finishedQueue.front());
+		finishedQueue.pop_front();
+		++numTaken;
+	}
+}
+
+ResRequestPtr AsyncResourceLoader::waitForRequest(RequestHeap& queue, std::condition_variable& ready)
+{
+	std::unique_lock<std::mutex> lock(queueMutex.GetMutex());
+	while(queue.empty() && !stopping)
+	{
+		ready.wait(lock);
+	}
+	if(stopping)
+	{
+		return ResRequestPtr();
+	}
+	std::pop_heap(queue.begin(), queue.end(), requestLess);
+	ResRequestPtr request = queue.back();
+	queue.pop_back();
+	return request;
+}
+
+void AsyncResourceLoader::pushRequest(RequestHeap& queue, std::condition_variable& ready, const ResRequestPtr& request)
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+		queue.push_back(request);
+		std::push_heap(queue.begin(), queue.end(), requestLess);
+	}
+	ready.notify_one();
+}
+
+void AsyncResourceLoader::WaitForFinished()
+{
+	std::unique_lock<std::mutex> lock(queueMutex.GetMutex());
+	while(finishedQueue.empty() && !stopping && IsRunning())
+	{
+		finishedReady.wait(lock);
+	}
+}
+
+void AsyncResourceLoader::finishRequest(const ResRequestPtr& request)
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+		finishedQueue.push_back(request);
+	}
+	finishedReady.notify_all();
+}
+
+void AsyncResourceLoader::IOClient::Run()
+{
+	owner->runIO();
+}
+
+void AsyncResourceLoader::DecodeClient::Run()
+{
+	owner->runDecode();
+}
+
+void AsyncResourceLoader::runIO()
+{
+	while(true)
+	{
+		ResRequestPtr request = waitForRequest(ioQueue, ioReady);
+		if(!request)
+		{
+			return;
+		}
+
+		//Only the read happens here; everything CPU heavy goes to the decode threads,
+		//so the disk stays busy.
+		//Packed data from a mapped archive's read by the decode threads as they unpack it.
+		U32 bytesRead = request->packedView ? request->packedSize : 0;
+		if(!request->packedView)
+		{
+			if(readAsync(request))
+			{
+				continue;
+			}
+			Lock archiveLock(*archiveMutex);
+			bytesRead = request->needsUnpack ?
+						request->archive->GetPackedResource(request->guid, request->packedBuf) :
+						request->archive->GetRawResource(request->guid, request->rawBuf);
+		}
+		request->succeeded = bytesRead > 0;
+		readDone(request);
+	}
+}
+
+void AsyncResourceLoader::readDone(const ResRequestPtr& request)
+{
+	//If there's nothing to unpack or decode off the main thread,
+	//the request can go straight back.
+	bool needsDecode =	request->needsUnpack ||
+						(!request->loader->UseRawResource() && request->loader->LoadsOnWorkerThread());
+	if(request->succeeded && needsDecode)
+	{
+		pushRequest(decodeQueue, decodeReady, request);
+	}
+	else
+	{
+		finishRequest(request);
+	}
+}
+
+bool AsyncResourceLoader::readAsync(const ResRequestPtr& request)
+{
+	IAsyncDataStream* asyncFile = NULL;
+	FileSz offset = 0;
+	{
+		//finding a ZIP file's data can mean reading its local header.
+		Lock archiveLock(*archiveMutex);
+		asyncFile = request->archive->GetAsyncFile();
+		if(!asyncFile || !request->archive->GetPackedOffset(request->guid, offset))
+		{
+			return false;
+		}
+	}
+	char* dest = request->needsUnpack ? request->packedBuf : request->rawBuf;
+	FileSz size = request->needsUnpack ? request->packedSize : request->rawSize;
+	ReadCallback* callback = LNew(ReadCallback, RESFILE_ALLOC, "ReadCallbackAlloc")(this, request, size);
+	{
+		std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+		++numReading;
+	}
+	if(!asyncFile->ReadAsync(dest, offset, size, callback))
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+			--numReading;
+		}
+		LDelete(callback);
+		return false;
+	}
+	return true;
+}
+
+void AsyncResourceLoader::finishRead(ReadCallback* callback, const ResRequestPtr& request, bool succeeded)
+{
+	//the callback holds a reference to the request, so keep one past deleting it.
+	ResRequestPtr readRequest = request;
+	LDelete(callback);
+	readRequest->succeeded = succeeded;
+	readDone(readRequest);
+	{
+		std::lock_guard<std::mutex> lock(queueMutex.GetMutex());
+		--numReading;
+	}
+	readsDone.notify_all();
+}
+
+AsyncResourceLoader::ReadCallback::ReadCallback(AsyncResourceLoader* ownerParam, const ResRequestPtr& requestParam, FileSz expectedSizeParam) :
+	request(requestParam)
+{
+	owner = ownerParam;
+	expectedSize = expectedSizeParam;
+	bytesRead = 0;
+}
+
+void AsyncResourceLoader::ReadCallback::OnReadEnd()
+{
+	owner->finishRead(this, request, expectedSize > 0 && bytesRead == expectedSize);
+}
+
+void AsyncResourceLoader::ReadCallback::OnError()
+{
+	LogW(String("Couldn't read ") + request->guid.Name + "!");
+	owner->finishRead(this, request, false);
+}
+
+void AsyncResourceLoader::runDecode()
+{
+	while(true)
+	{
+		ResRequestPtr request = waitForRequest(decodeQueue, decodeReady);
+		if(!request)
+		{
+			return;
+		}
+		std::chrono::steady_clock::time_point decodeStart = std::chrono::steady_clock::now();
+		decode(*request);
+		request->decodeUs = std::chrono::duration<F32, std::micro>(std::chrono::steady_clock::now() - decodeStart).count();
+		finishRequest(request);
+	}
+}
+
+void AsyncResourceLoader::decode(ResourceRequest& request)
+{
+	if(request.needsUnpack)
+	{
+		const char* packedData = request.packedView ? request.packedView : request.packedBuf;
+		request.succeeded = request.archive->UnpackResource(request.guid, packedData, request.packedSize, request.rawBuf);
+		CustomArrayDelete(request.packedBuf);
+		request.packedBuf = NULL;
+		if(!request.succeeded)
+		{
+			LogW(String("Couldn't unpack ") + request.guid.Name + "!");
+			return;
+		}
+	}
+
+	IResourceLoader& loader = *request.loader;
+	if(loader.UseRawResource() || !loader.LoadsOnWorkerThread())
+	{
+		return;
+	}
+	//The cache can only be changed on the main thread,
+	//so allocate the resource buffer directly; the manager counts it against the cache
+	//when it collects the request.
+	FileSz size = loader.GetLoadedResSize(request.rawBuf, request.rawSize);
+	if(!size)
+	{
+		request.succeeded = false;
+		return;
+	}
+	char* resBuf = CustomArrayNew<char>(size, RESFILE_ALLOC, "CacheBufAlloc");
+	memset(resBuf, 0, size);
+	request.uncounted = true;
+	request.resource = SharedResHandle(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc",
+		request.guid, resBuf, size, manager));
+	request.succeeded = loader.LoadResource(request.rawBuf, request.rawSize, request.resource.get());
+	CustomArrayDelete(request.rawBuf);
+	request.rawBuf = NULL;
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include "Datatypes.h"
+#include "Resource.h"
+#include "ResHandle.h"
+#include "IResourceLoader.h"
+#include "IResourceArchive.h"
+#include "DataStructures/STLContainers.h"
+#include "MultiThreading/StdThreading.h"
+#include <condition_variable>
+
+namespace LeEK
+{
+	class ResourceManager;
+
+	/**
+	Called on the main thread when an asynchronous load finishes.
+	The resource is empty if the load failed.
+	*/
+	typedef void (*ResLoadedCallback)(const ResPtr& resource, void* userData);
+
+	/**
+	Tracks a resource requested via ResourceManager::GetResourceAsync().
+	Poll it from the main thread, or register a callback with the request;
+	either way, the request only finishes during ResourceManager::UpdateAsyncLoads().
+	*/
+	class ResourceRequest
+	{
+	public:
+		enum State
+		{
+			//being read or decoded, or waiting for UpdateAsyncLoads().
+			PENDING,
+			DONE,
+			FAILED
+		};
+	private:
+		friend class ResourceManager;
+		friend class AsyncResourceLoader;
+		typedef Pair<ResLoadedCallback, void*> Callback;
+
+		ResGUID guid;
+		I32 priority;
+		//breaks priority ties, so equal priority requests finish in order.
+		U64 sequence;
+		State state;
+		Vector<Callback> callbacks;
+		//the decode threads make resources, so this has to be safe to share between threads.
+		SharedResHandle resource;
+
+		//Everything below is pipeline state. It's written by whichever stage
+		//owns the request, and only read by the main thread once the loader's finished with it.
+		IResourceArchive* archive;
+		std::shared_ptr<IResourceLoader> loader;
+		bool needsUnpack;
+		//only allocated if the resource needs unpacking.
+		char* packedBuf;
+		//set instead of packedBuf if the archive's mapped,
+		//in which case there's nothing to read.
+		const char* packedView;
+		FileSz packedSize;
+		//comes from the cache if the loader uses raw data,
+		//otherwise it's a temporary buffer.
+		char* rawBuf;
+		FileSz rawSize;
+		//true if the resource's buffer was allocated off the main thread,
+		//and so hasn't been counted against the cache yet.
+		bool uncounted;
+		//time spent unpacking and decoding, for estimating the cost to reload.
+		F32 decodeUs;
+		bool succeeded;
+	public:
+		ResourceRequest(const ResGUID& resGUID, I32 priorityParam);
+		~ResourceRequest();
+
+		const ResGUID& GUID() const { return guid; }
+		I32 Priority() const { return priority; }
+		State GetState() const { return state; }
+		bool IsFinished() const { return state == DONE || state == FAILED; }
+		bool Succeeded() const { return state == DONE; }
+		/**
+		Gets the loaded resource.
+		Empty until the request's finished, or if the load failed.
+		*/
+		ResPtr GetResource() const { return ResPtr(resource); }
+		/**
+		Adds a function to call when the request finishes.
+		If the request's already finished, the function's called immediately.
+		*/
+		void AddCallback(ResLoadedCallback callback, void* userData);
+	};
+
+	typedef std::shared_ptr<ResourceRequest> ResRequestPtr;
+
+	/**
+	Runs the background half of asynchronous resource loading:
+	one I/O thread reads packed resource data in priority order
+	(issuing the reads asynchronously where the archive supports it, so many can be in flight at once),
+	and a pool of decode threads unpacks it and runs
+	any loaders that can work off the main thread.
+	Finished requests wait in a queue until the ResourceManager collects them.
+	*/
+	class AsyncResourceLoader
+	{
+	private:
+		class IOClient : public IThreadClient
+		{
+		private:
+			AsyncResourceLoader* owner;
+		public:
+			IOClient(AsyncResourceLoader* ownerParam) : owner(ownerParam) {}
+			void Run();
+		};
+		class DecodeClient : public IThreadClient
+		{
+		private:
+			AsyncResourceLoader* owner;
+		public:
+			DecodeClient(AsyncResourceLoader* ownerParam) : owner(ownerParam) {}
+			void Run();
+		};
+		//Hands a request on once the archive's asynchronous stream has read it.
+		class ReadCallback : public IAsyncCallback
+		{
+		private:
+			AsyncResourceLoader* owner;
+			ResRequestPtr request;
+			FileSz expectedSize;
+			FileSz bytesRead;
+		public:
+			ReadCallback(AsyncResourceLoader* ownerParam, const ResRequestPtr& requestParam, FileSz expectedSizeParam);
+			void OnStreamOpen() {}
+			void OnStreamClose() {}
+			void OnChunkRead(FileSz bytesReadParam) { bytesRead = bytesReadParam; }
+			void OnChunkWritten(FileSz bytesWritten) {}
+			//Both of these delete the callback.
+			void OnReadEnd();
+			void OnWriteEnd() {}
+			void OnError();
+		};
+		typedef Vector<ResRequestPtr> RequestHeap;
+
+		TypedHandle<ResourceManager> manager;
+		//held whenever an archive's file is read.
+		//The ResourceManager takes it too, for synchronous loads.
+		Mutex* archiveMutex;
+
+		//guards all the queues below.
+		Mutex queueMutex;
+		std::condition_variable ioReady;
+		std::condition_variable decodeReady;
+		std::condition_variable finishedReady;
+		RequestHeap ioQueue;
+		RequestHeap decodeQueue;
+		List<ResRequestPtr> finishedQueue;
+		bool stopping;
+		U64 nextSequence;
+		//reads handed to archives' asynchronous streams that haven't come back yet.
+		U32 numReading;
+		std::condition_variable readsDone;
+
+		IOClient ioClient;
+		Thread* ioThread;
+		DecodeClient decodeClient;
+		Vector<Thread*> decodeThreads;
+
+		void runIO();
+		void runDecode();
+		//Pops the highest priority request, or returns an empty pointer if stopping.
+		ResRequestPtr waitForRequest(RequestHeap& queue, std::condition_variable& ready);
+		void pushRequest(RequestHeap& queue, std::condition_variable& ready, const ResRequestPtr& request);
+		void finishRequest(const ResRequestPtr& request);
+		/**
+		Starts reading the request through its archive's asynchronous stream,
+		so the I/O thread can go on to the next request.
+		@return false if the archive can't be read that way.
+		*/
+		bool readAsync(const ResRequestPtr& request);
+		void finishRead(ReadCallback* callback, const ResRequestPtr& request, bool succeeded);
+		//Sends a request that's been read on to decoding, or back to the manager.
+		void readDone(const ResRequestPtr& request);
+		void decode(ResourceRequest& request);
+		//Heap ordering for the request queues.
+		static bool requestLess(const ResRequestPtr& lhs, const ResRequestPtr& rhs);
+
+		AsyncResourceLoader(const AsyncResourceLoader& other);
+		AsyncResourceLoader& operator=(const AsyncResourceLoader& other);
+	public:
+		AsyncResourceLoader();
+		~AsyncResourceLoader();
+
+		/**
+		Starts the loading threads.
+		@param numDecodeThreads the size of the decode pool;
+		if 0, uses all the hardware threads not taken by the main and I/O threads.
+		*/
+		void Start(TypedHandle<ResourceManager> managerHnd, Mutex* archiveMutexParam, U32 numDecodeThreads = 0);
+		/**
+		Stops and joins all the loading threads.
+		Requests that hadn't finished are moved to the finished queue, marked as failed.
+		*/
+		void Stop();
+		bool IsRunning() const { return ioThread != NULL; }
+		U32 NumDecodeThreads() const { return decodeThreads.size(); }
+		/**
+		Queues a request for reading. Its archive, loader and buffers must already be set.
+		*/
+		void Enqueue(const ResRequestPtr& request);
+		/**
+		Moves finished requests to the given list.
+		@param maxRequests the most requests to move; 0 moves all of them.
+		*/
+		void TakeFinished(List<ResRequestPtr>& out, U32 maxRequests = 0);
+		/**
+		Blocks until there's at least one finished request to take.
+		Returns immediately if the loader isn't running.
+		*/
+		void WaitForFinished();
+	};
+}
@@ -7,6 +7,9 @@
 
 namespace LeEK
 {
+	class ZipStream;
+	class IAsyncDataStream;
+
 	class IResourceArchive
 	{
 	public:
@@ -17,5 +20,51 @@ namespace LeEK
 		virtual const String GetResourceName(U32 resNum) const = 0;
 		virtual const String GetArchiveName() const = 0;
 		virtual bool Open() = 0;
+		/**
+		Opens a stream over the raw resource, for reading it a piece at a time.
+		The caller owns the stream; delete it with LDelete().
+		@return NULL if the archive can't stream the resource.
+		*/
+		virtual ZipStream* OpenStream(const ResGUID& resource) { return NULL; }
+
+		//Asynchronous loads split a read into two steps -
+		//reading the resource as it's stored (on the I/O thread),
+		//then unpacking it (on a decode thread).
+		//By default a resource is stored as-is and needs no unpacking.
+		/**
+		Returns true if the resource has to go through UnpackResource()
+		after being read with GetPackedResource().
+		*/
+		virtual bool NeedsUnpack(const ResGUID& resource) const { return false; }
+		virtual U32 GetPackedSize(const ResGUID& resource) const { return GetRawSize(resource); }
+		virtual U32 GetPackedResource(const ResGUID& resource, char* buffer) { return GetRawResource(resource, buffer); }
+		/**
+		Gets the packed resource where it already sits in memory, if the archive's memory mapped.
+		Stays valid while the archive's open. Can be used in place of GetPackedResource(),
+		and if the resource doesn't need unpacking it's the raw resource itself.
+		@return NULL if the resource isn't in memory.
+		*/
+		virtual char* GetPackedView(const ResGUID& resource) { return NULL; }
+		/**
+		Gets a stream over the archive's file for asynchronous reads,
+		opening it the first time it's asked for. The archive owns the stream.
+		@return NULL if the archive can't be read asynchronously.
+		*/
+		virtual IAsyncDataStream* GetAsyncFile() { return NULL; }
+		/**
+		Gets where the packed resource starts in GetAsyncFile()'s file.
+		It runs for GetPackedSize() bytes from there.
+		*/
+		virtual bool GetPackedOffset(const ResGUID& resource, FileSz& offset) { return false; }
+		/**
+		Converts a packed resource to its raw form.
+		Must not touch the archive's file, as this runs without the archive lock.
+		@param buffer receives the raw resource; must be GetRawSize() bytes.
+		*/
+		virtual bool UnpackResource(const ResGUID& resource, const char* packedBuf, U32 packedSize, char* buffer)
+		{
+			memcpy(buffer, packedBuf, packedSize);
+			return true;
+		}
 	};
 }
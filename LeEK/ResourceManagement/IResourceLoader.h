@@ -13,7 +13,28 @@ namespace LeEK
 		virtual String GetPattern() = 0;
 		virtual bool UseRawResource() = 0;
 		virtual U32 GetLoadedResSize(char* rawBuf, U32 rawSize) = 0;
-		virtual bool LoadResource(char* rawBuf, U32 rawSize, std::shared_ptr<Resource> resource) = 0;
+		virtual bool LoadResource(char* rawBuf, U32 rawSize, Resource* resource) = 0;
+		/**
+		Returns true if GetLoadedResSize() and LoadResource() can run on
+		a decode thread during asynchronous loads.
+		Loaders that touch main thread state (handles, the renderer, etc.) should return false;
+		their resources are then loaded on the main thread when the raw data's ready.
+		*/
+		virtual bool LoadsOnWorkerThread() { return false; }
+		/**
+		Gets the kind of resource the loader makes; the cache budgets each kind separately.
+		*/
+		virtual ResCategory GetCategory() { return OTHER_RES; }
+		/**
+		For loaders that don't use raw data, but can build their resource around a file
+		stored as-is in a mapped archive. Gets the size of the resource buffer
+		LoadMappedResource() needs, or 0 if the file has to be loaded normally.
+		*/
+		virtual FileSz GetMappedResSize(const char* view, FileSz size) { return 0; }
+		/**
+		Builds a resource that uses view where it is; the archive has to stay open while it's in use.
+		*/
+		virtual bool LoadMappedResource(const char* view, FileSz size, Resource* resource) { return false; }
 		virtual bool LoadStreamResource(char* rawBuf, FileSz rawSize, std::shared_ptr<DecodableResource> resource) { return false; }
 		virtual FileSz StreamRead(DecodableResource* res, char* dest, FileSz numBytes) { return 0; }
 		virtual FileSz StreamSeek(DecodableResource* res, FileSz offset) { return 0; }
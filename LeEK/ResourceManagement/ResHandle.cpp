@@ -0,0 +1,149 @@
+#include "ResHandle.h"
+#include "Memory/Allocator.h"
+#include "Constants/AllocTypes.h"
+#include "Logging/Log.h"
+#include <mutex>
+
+using namespace LeEK;
+
+ResSlot* ResTable::Blocks[ResTable::MAX_BLOCKS];
+
+namespace
+{
+	//Resources are made and freed on the decode threads as well as the main thread,
+	//so the free list's guarded. Looking up a slot never takes this.
+	std::mutex& tableMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+	U32 numBlocks = 0;
+	//0 if there's no free slot.
+	U32 firstFree = 0;
+	U32 numResources = 0;
+
+	bool addBlock()
+	{
+		if(numBlocks >= ResTable::MAX_BLOCKS)
+		{
+			return false;
+		}
+		ResSlot* block = CustomArrayNew<ResSlot>(ResTable::BLOCK_SIZE, RESFILE_ALLOC, "ResTableAlloc");
+		U32 base = numBlocks << ResTable::BLOCK_BITS;
+		for(U32 i = 0; i < ResTable::BLOCK_SIZE; ++i)
+		{
+			block[i].Res = NULL;
+			block[i].Generation = 0;
+			block[i].LocalRefs = 0;
+			block[i].Refs.store(0, std::memory_order_relaxed);
+			block[i].NextFree = i + 1 < ResTable::BLOCK_SIZE ? base + i + 1 : firstFree;
+		}
+		ResTable::Blocks[numBlocks] = block;
+		++numBlocks;
+		//slot 0 stands for an empty handle.
+		firstFree = base == 0 ? 1 : base;
+		return true;
+	}
+}
+
+U32 ResTable::Add(Resource* res)
+{
+	std::lock_guard<std::mutex> lock(tableMutex());
+	if(!firstFree && !addBlock())
+	{
+		LogE("Resource table's full!");
+		return 0;
+	}
+	U32 index = firstFree;
+	ResSlot& slot = GetSlot(index);
+	firstFree = slot.NextFree;
+	slot.Res = res;
+	slot.LocalRefs = 0;
+	slot.Refs.store(0, std::memory_order_relaxed);
+	++numResources;
+	return index;
+}
+
+void ResTable::Release(U32 index)
+{
+	ResSlot& slot = GetSlot(index);
+	//acq_rel, so everything done through other references
+	//happens before the resource's deleted.
+	if(slot.Refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+	{
+		return;
+	}
+	Resource* res = slot.Res;
+	{
+		std::lock_guard<std::mutex> lock(tableMutex());
+		slot.Res = NULL;
+		++slot.Generation;
+		slot.NextFree = firstFree;
+		firstFree = index;
+		--numResources;
+	}
+	CustomDelete(res);
+}
+
+U32 ResTable::NumResources()
+{
+	std::lock_guard<std::mutex> lock(tableMutex());
+	return numResources;
+}
+
+ResHandle::ResHandle(Resource* res) : index(0), generation(0)
+{
+	if(!res)
+	{
+		return;
+	}
+	index = ResTable::Add(res);
+	if(!index)
+	{
+		CustomDelete(res);
+		return;
+	}
+	generation = ResTable::GetSlot(index).Generation;
+	acquire();
+}
+
+ResHandle::ResHandle(const SharedResHandle& other) : index(other.Index()), generation(other.Generation())
+{
+	acquire();
+}
+
+U32 ResHandle::UseCount() const
+{
+	if(!index)
+	{
+		return 0;
+	}
+	const ResSlot& slot = GetSlotChecked();
+	//all the ResHandles together hold one of the shared references.
+	U32 sharedRefs = slot.Refs.load(std::memory_order_relaxed);
+	return slot.LocalRefs + sharedRefs - (slot.LocalRefs > 0 ? 1 : 0);
+}
+
+SharedResHandle::SharedResHandle(Resource* res) : index(0), generation(0)
+{
+	if(!res)
+	{
+		return;
+	}
+	index = ResTable::Add(res);
+	if(!index)
+	{
+		CustomDelete(res);
+		return;
+	}
+	generation = ResTable::GetSlot(index).Generation;
+	ResTable::AddRef(index);
+}
+
+SharedResHandle::SharedResHandle(const ResHandle& other) : index(other.Index()), generation(other.Generation())
+{
+	if(index)
+	{
+		ResTable::AddRef(index);
+	}
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include "Datatypes.h"
+#include "ResourceManagement/Resource.h"
+#include "DebugUtils/Assertions.h"
+#include <atomic>
+#include <utility>
+
+namespace LeEK
+{
+	/**
+	Entry in the resource table.
+	Handles point at resources through these, so a handle's just an index and generation,
+	and its reference count lives with the resource instead of in a separate allocation.
+	*/
+	struct ResSlot
+	{
+		Resource* Res;
+		//bumped whenever the slot's freed, to catch handles that outlived their resource.
+		U32 Generation;
+		//number of ResHandles to the resource. Only ever touched on the main thread.
+		U32 LocalRefs;
+		//Everything keeping the resource alive: each SharedResHandle,
+		//plus one for all of the ResHandles together. The resource's deleted when this reaches 0.
+		std::atomic<U32> Refs;
+		//index of the next free slot, while this one's free.
+		U32 NextFree;
+	};
+
+	/**
+	The table of every loaded resource.
+	Slots never move once they're made, so looking one up needs no lock.
+	*/
+	namespace ResTable
+	{
+		const U32 BLOCK_BITS = 10;
+		const U32 BLOCK_SIZE = 1 << BLOCK_BITS;
+		const U32 MAX_BLOCKS = 1024;
+		//Slots are made a block at a time. Slot 0's never used, so a zeroed handle's empty.
+		extern ResSlot* Blocks[MAX_BLOCKS];
+
+		inline ResSlot& GetSlot(U32 index) { return Blocks[index >> BLOCK_BITS][index & (BLOCK_SIZE - 1)]; }
+		/**
+		Puts a resource in the table. Its slot starts with no references;
+		the resource's deleted once references are added and all released.
+		Safe to call from any thread.
+		@return the slot's index, or 0 if the table's full.
+		*/
+		U32 Add(Resource* res);
+		/**
+		Atomically adds or releases a reference.
+		Releasing the last reference deletes the resource and frees its slot.
+		*/
+		inline void AddRef(U32 index) { GetSlot(index).Refs.fetch_add(1, std::memory_order_relaxed); }
+		void Release(U32 index);
+		/**
+		Gets the number of resources in the table.
+		*/
+		U32 NumResources();
+	}
+
+	class SharedResHandle;
+
+	/**
+	Reference counted handle to a resource, for use on the main thread.
+	Copying one just bumps a plain counter in the resource's slot;
+	use SharedResHandle for anything that crosses threads.
+	*/
+	class ResHandle
+	{
+	private:
+		U32 index;
+		U32 generation;
+
+		void acquire()
+		{
+			if(index && GetSlotChecked().LocalRefs++ == 0)
+			{
+				ResTable::AddRef(index);
+			}
+		}
+		void release()
+		{
+			if(index && --GetSlotChecked().LocalRefs == 0)
+			{
+				ResTable::Release(index);
+			}
+		}
+		ResSlot& GetSlotChecked() const
+		{
+			ResSlot& slot = ResTable::GetSlot(index);
+			L_ASSERT(slot.Generation == generation && "Resource handle outlived its resource!");
+			return slot;
+		}
+	public:
+		ResHandle() : index(0), generation(0) {}
+		/**
+		Puts a newly made resource in the resource table.
+		The resource's deleted once the last handle to it goes.
+		*/
+		explicit ResHandle(Resource* res);
+		explicit ResHandle(const SharedResHandle& other);
+		ResHandle(const ResHandle& other) : index(other.index), generation(other.generation) { acquire(); }
+		~ResHandle() { release(); }
+		ResHandle& operator=(const ResHandle& other)
+		{
+			//the copy takes the old reference with it.
+			ResHandle copy(other);
+			std::swap(index, copy.index);
+			std::swap(generation, copy.generation);
+			return *this;
+		}
+
+		Resource* get() const { return index ? GetSlotChecked().Res : NULL; }
+		Resource* operator->() const
+		{
+			L_ASSERT(index && "Attempted to dereference null resource handle!");
+			return GetSlotChecked().Res;
+		}
+		Resource& operator*() const { return *operator->(); }
+		explicit operator bool() const { return index != 0; }
+		void reset() { release(); index = 0; generation = 0; }
+		/**
+		Gets the number of references to the resource, counting both kinds of handle.
+		*/
+		U32 UseCount() const;
+		U32 Index() const { return index; }
+		U32 Generation() const { return generation; }
+
+		bool operator==(const ResHandle& other) const { return index == other.index; }
+		bool operator!=(const ResHandle& other) const { return index != other.index; }
+	};
+
+	/**
+	Reference counted handle to a resource that can be copied and released on any thread.
+	Counts atomically, so prefer ResHandle on the main thread.
+	*/
+	class SharedResHandle
+	{
+	private:
+		U32 index;
+		U32 generation;
+	public:
+		SharedResHandle() : index(0), generation(0) {}
+		explicit SharedResHandle(Resource* res);
+		explicit SharedResHandle(const ResHandle& other);
+		SharedResHandle(const SharedResHandle& other) : index(other.index), generation(other.generation)
+		{
+			if(index)
+			{
+				ResTable::AddRef(index);
+			}
+		}
+		~SharedResHandle() { reset(); }
+		SharedResHandle& operator=(const SharedResHandle& other)
+		{
+			SharedResHandle copy(other);
+			std::swap(index, copy.index);
+			std::swap(generation, copy.generation);
+			return *this;
+		}
+
+		Resource* get() const { return index ? ResTable::GetSlot(index).Res : NULL; }
+		Resource* operator->() const
+		{
+			L_ASSERT(index && "Attempted to dereference null resource handle!");
+			return ResTable::GetSlot(index).Res;
+		}
+		Resource& operator*() const { return *operator->(); }
+		explicit operator bool() const { return index != 0; }
+		void reset()
+		{
+			if(index)
+			{
+				ResTable::Release(index);
+			}
+			index = 0;
+			generation = 0;
+		}
+		U32 Index() const { return index; }
+		U32 Generation() const { return generation; }
+	};
+
+	//What the ResourceManager hands out.
+	typedef ResHandle ResPtr;
+}
@@ -4,6 +4,8 @@
 #include "ResourceManagement/ResourceManager.h"
 #include "FileManagement/Filesystem.h"
 #include "Platforms/IPlatform.h"
+#include "Hashing/Hash.h"
+#include "FileManagement/ArchiveTypes.h"
 
 using namespace LeEK;
 
@@ -50,6 +52,8 @@ void ResGUID::init(const String& name)
 			break;
 		}
 	}
+	hash = Hash(Name, strlen(Name));
+	archiveID = archSepPos ? HashPathNoCase(Name, archSepPos) : 0;
 }
 
 ResGUID::ResGUID(const char* name)
@@ -70,6 +74,8 @@ ResGUID::ResGUID()
 	memset(Name, 0, MAX_NAME_LEN);
 	archSepPos = 0;
 	extPos = 0;
+	hash = 0;
+	archiveID = 0;
 }
 
 U32 ResGUID::Length() const
@@ -155,6 +161,23 @@ ResourceBase::~ResourceBase()
 	LDelete(extra);
 }
 
+const char* LeEK::ResCategoryName(ResCategory category)
+{
+	switch(category)
+	{
+	case TEXTURE_RES:
+		return "Textures";
+	case MODEL_RES:
+		return "Models";
+	case SOUND_RES:
+		return "Sounds";
+	case SCRIPT_RES:
+		return "Scripts";
+	default:
+		return "Other";
+	}
+}
+
 Resource::~Resource(void)
 {
 	
@@ -164,6 +187,14 @@ Resource::~Resource(void)
 	manager->ReportMemoryFreed(size);
 }
 
+MappedResource::~MappedResource(void)
+{
+	//The view belongs to the archive, and never took up any cache space;
+	//stop ~Resource() from freeing or reporting it.
+	buffer = NULL;
+	size = 0;
+}
+
 FileSz DecodableResource::defReadFunc(DecodableResource* res, char* dest, FileSz numBytes)
 {
 	return 0;
@@ -207,4 +238,53 @@ FileSz DecodableResource::Seek(FileSz relOffset)
 void DecodableResource::Close()
 {
 	return closeFunc(this);
-}
\ No newline at end of file
+}
+
+StreamingResource::StreamingResource(	const ResGUID& guidParam, ZipStream* streamParam, FileSz sizeParam,
+										TypedHandle<ResourceManager> managerHnd, ExtraData* extraParam) :
+										ResourceBase(guidParam, sizeParam, managerHnd, extraParam)
+{
+	stream = streamParam;
+	streamPos = 0;
+}
+
+StreamingResource::~StreamingResource()
+{
+	LDelete(stream);
+}
+
+FileSz StreamingResource::Read(char* dest, FileSz numBytes)
+{
+	FileSz bytesRead = stream->Read((U8*)dest, Math::Min(numBytes, size - streamPos));
+	streamPos += bytesRead;
+	return bytesRead;
+}
+
+FileSz StreamingResource::Seek(FileSz pos)
+{
+	pos = Math::Min(pos, size);
+	if(pos < streamPos)
+	{
+		stream->Seek(0);
+		streamPos = 0;
+	}
+	//skip forward by reading; the compressed position
+	//of any point in DEFLATE data can't be known without decompressing up to it.
+	const FileSz SKIP_BUF_SZ = 4096;
+	char skipBuf[SKIP_BUF_SZ];
+	while(streamPos < pos)
+	{
+		FileSz bytesRead = stream->Read((U8*)skipBuf, Math::Min(pos - streamPos, SKIP_BUF_SZ));
+		if(bytesRead == 0)
+		{
+			break;
+		}
+		streamPos += bytesRead;
+	}
+	return streamPos;
+}
+
+U32 StreamingResource::NumStalls() const
+{
+	return stream->NumStalls();
+}
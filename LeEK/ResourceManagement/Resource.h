@@ -6,6 +6,7 @@
 namespace LeEK
 {
 	class ResourceManager;
+	class ZipStream;
 
 	class ResGUID
 	{
@@ -17,6 +18,11 @@ namespace LeEK
 		static const char ARCHIVE_SEPARATOR = ':';
 		U32 archSepPos;
 		U32 extPos;
+		//hash of Name, so lookups and comparisons
+		//rarely need to touch the string.
+		U32 hash;
+		//HashPathNoCase() of the archive name.
+		U32 archiveID;
 
 		void init(const String& name);
 	public:
@@ -24,6 +30,20 @@ namespace LeEK
 		//properties
 		bool Empty() const { return Name[0] == 0; }
 		U32 Length() const;
+		/**
+		Gets the hash of the GUID's name. Computed once, when the GUID's made.
+		*/
+		U32 HashValue() const { return hash; }
+		/**
+		Gets an ID for the resource's archive, ignoring case.
+		Computed once, when the GUID's made, so finding the archive
+		doesn't need a copy of its name. 0 if there's no archive name.
+		*/
+		U32 ArchiveID() const { return archiveID; }
+		/**
+		Gets the length of the archive name at the start of Name.
+		*/
+		U32 ArchiveNameLen() const { return archSepPos; }
 
 		ResGUID(const char* name);
 		ResGUID(const String& archName, const String& resName);
@@ -54,7 +74,22 @@ namespace LeEK
 		bool IsAbsFileSysGUID();
 	};
 
-	inline bool operator== (const ResGUID& lhs, const ResGUID& rhs) { return strcmp(lhs.Name, rhs.Name) == 0; }
+	/**
+	Kinds of resource, so the cache can budget them separately.
+	Each loader says what kind of resource it makes.
+	*/
+	enum ResCategory
+	{
+		TEXTURE_RES,
+		MODEL_RES,
+		SOUND_RES,
+		SCRIPT_RES,
+		OTHER_RES,
+		RESCAT_LEN
+	};
+	const char* ResCategoryName(ResCategory category);
+
+	inline bool operator== (const ResGUID& lhs, const ResGUID& rhs) { return lhs.HashValue() == rhs.HashValue() && strcmp(lhs.Name, rhs.Name) == 0; }
 	inline bool operator!= (const ResGUID& lhs, const ResGUID& rhs) { return !(lhs == rhs); }
 
 	class ExtraData
@@ -102,6 +137,29 @@ namespace LeEK
 			buffer = bufferParam;
 		}
 		~Resource(void);
+		/**
+		Returns true if the resource's data belongs to something else, like a mapped archive,
+		in which case it takes no space in the cache.
+		*/
+		virtual bool IsMapped() const { return false; }
+	};
+
+	/**
+	A resource that uses data straight from a memory mapped archive,
+	instead of a buffer in the cache. Since it takes no cache space,
+	the manager doesn't count it against the cache.
+	The archive has to stay open while the resource's in use.
+	*/
+	class MappedResource : public Resource
+	{
+	public:
+		MappedResource(	const ResGUID& guidParam, char* viewParam, FileSz sizeParam, 
+						TypedHandle<ResourceManager> managerHnd, ExtraData* extraParam = NULL) :
+				Resource(guidParam, viewParam, sizeParam, managerHnd, extraParam)
+		{
+		}
+		~MappedResource(void);
+		bool IsMapped() const { return true; }
 	};
 
 	/**
@@ -142,6 +200,44 @@ namespace LeEK
 		void Close();
 	};
 
+	/**
+	A resource that's read straight from its archive a piece at a time,
+	instead of being loaded into the cache, for things like music that are
+	consumed in order and would only waste cache space.
+	Reads go through the archive stream's read-ahead, so they only wait on the disk
+	when the consumer outruns it. Size() returns the size of the raw resource.
+	*/
+	class StreamingResource : public ResourceBase
+	{
+	private:
+		ZipStream* stream;
+		//position in the raw resource.
+		FileSz streamPos;
+	public:
+		/**
+		Takes ownership of the stream.
+		*/
+		StreamingResource(	const ResGUID& guidParam, ZipStream* streamParam, FileSz sizeParam,
+							TypedHandle<ResourceManager> managerHnd, ExtraData* extraParam = NULL);
+		~StreamingResource(void);
+		/**
+		Copies the next bytes of the resource.
+		@return the number of bytes copied; less than numBytes only at the end of the resource.
+		*/
+		FileSz Read(char* dest, FileSz numBytes);
+		/**
+		Moves to the given position in the raw resource.
+		Compressed resources have to be decompressed up to the new position,
+		so seeking backwards starts over from the beginning.
+		*/
+		FileSz Seek(FileSz pos);
+		FileSz Tell() const { return streamPos; }
+		/**
+		Gets the number of times a read had to wait for the disk.
+		*/
+		U32 NumStalls() const;
+	};
+
 	inline bool operator== (const ResourceBase& lhs, const ResourceBase& rhs) { return lhs.GUID() == rhs.GUID(); }
 	inline bool operator!= (const ResourceBase& lhs, const ResourceBase& rhs) { return !(lhs == rhs); }
 }
\ No newline at end of file
@@ -1,9 +1,18 @@
 #include "ResourceArchive.h"
+#include "FileManagement/AsyncDataStream.h"
 
 using namespace LeEK;
 
 ZipResArchive::ZipResArchive(const Path& archivePath) : archPath(archivePath)
 {
+	asyncFile = NULL;
+	asyncOpened = false;
+}
+
+ZipResArchive::~ZipResArchive(void)
+{
+	//waits for any reads still in flight.
+	Filesystem::CloseFile(asyncFile);
 }
 
 bool ZipResArchive::Open()
@@ -15,6 +24,11 @@ bool ZipResArchive::Open()
 	return true;
 }
 
+ZipStream* ZipResArchive::OpenStream(const ResGUID& resource)
+{
+	return file.GetStream(file.Find(resource.ResName()));
+}
+
 FileSz ZipResArchive::GetRawSize(const ResGUID& resource) const
 {
 	return file.GetFileLen(file.Find(resource.ResName()));
@@ -42,4 +56,158 @@ const String ZipResArchive::GetResourceName(U32 resNum) const
 const String ZipResArchive::GetArchiveName() const
 {
 	return archPath.GetBaseName();
+}
+
+bool ZipResArchive::NeedsUnpack(const ResGUID& resource) const
+{
+	return file.GetCompression(file.Find(resource.ResName())) != COMP_NONE;
+}
+
+U32 ZipResArchive::GetPackedSize(const ResGUID& resource) const
+{
+	return file.GetCompressedLen(file.Find(resource.ResName()));
+}
+
+U32 ZipResArchive::GetPackedResource(const ResGUID& resource, char* buffer)
+{
+	I32 fileIndex = file.Find(resource.ResName());
+	if(file.ReadCompressedFile(fileIndex, buffer))
+	{
+		return file.GetCompressedLen(fileIndex);
+	}
+	return 0;
+}
+
+char* ZipResArchive::GetPackedView(const ResGUID& resource)
+{
+	return file.GetMappedFile(file.Find(resource.ResName()));
+}
+
+IAsyncDataStream* ZipResArchive::GetAsyncFile()
+{
+	if(!asyncOpened)
+	{
+		asyncFile = Filesystem::OpenFileAsyncReadOnly(archPath);
+		asyncOpened = true;
+	}
+	return asyncFile;
+}
+
+bool ZipResArchive::GetPackedOffset(const ResGUID& resource, FileSz& offset)
+{
+	return file.GetDataOffset(file.Find(resource.ResName()), offset);
+}
+
+bool ZipResArchive::UnpackResource(const ResGUID& resource, const char* packedBuf, U32 packedSize, char* buffer)
+{
+	I32 fileIndex = file.Find(resource.ResName());
+	switch(file.GetCompression(fileIndex))
+	{
+	case COMP_NONE:
+		memcpy(buffer, packedBuf, packedSize);
+		return true;
+	case COMP_DEFLATE:
+		return DecompDeflateBuf((char*)packedBuf, packedSize, buffer, file.GetFileLen(fileIndex));
+	default:
+		LogW(String("Unrecognized compression on ") + resource.Name + "!");
+		return false;
+	}
+}
+
+PackResArchive::PackResArchive(const Path& archivePath) : archPath(archivePath)
+{
+	asyncFile = NULL;
+	asyncOpened = false;
+}
+
+PackResArchive::~PackResArchive(void)
+{
+	//waits for any reads still in flight.
+	Filesystem::CloseFile(asyncFile);
+}
+
+bool PackResArchive::Open()
+{
+	return file.Init(archPath);
+}
+
+FileSz PackResArchive::GetRawSize(const ResGUID& resource) const
+{
+	return file.GetFileLen(file.Find(resource.ResName()));
+}
+
+U32 PackResArchive::GetRawResource(const ResGUID& resource, char* buffer)
+{
+	I32 fileIndex = file.Find(resource.ResName());
+	if(file.ReadFile(fileIndex, buffer))
+	{
+		return file.GetFileLen(fileIndex);
+	}
+	return 0;
+}
+
+U32 PackResArchive::GetNumResources() const
+{
+	return (U32)file.GetNumFiles();
+}
+
+const String PackResArchive::GetResourceName(U32 resNum) const
+{
+	return file.GetFilename(resNum);
+}
+
+const String PackResArchive::GetArchiveName() const
+{
+	return archPath.GetBaseName();
+}
+
+bool PackResArchive::NeedsUnpack(const ResGUID& resource) const
+{
+	return file.GetCompression(file.Find(resource.ResName())) != PACK_COMP_NONE;
+}
+
+U32 PackResArchive::GetPackedSize(const ResGUID& resource) const
+{
+	return file.GetPackedLen(file.Find(resource.ResName()));
+}
+
+U32 PackResArchive::GetPackedResource(const ResGUID& resource, char* buffer)
+{
+	I32 fileIndex = file.Find(resource.ResName());
+	if(file.ReadPackedFile(fileIndex, buffer))
+	{
+		return file.GetPackedLen(fileIndex);
+	}
+	return 0;
+}
+
+char* PackResArchive::GetPackedView(const ResGUID& resource)
+{
+	return file.GetMappedFile(file.Find(resource.ResName()));
+}
+
+IAsyncDataStream* PackResArchive::GetAsyncFile()
+{
+	if(!asyncOpened)
+	{
+		asyncFile = Filesystem::OpenFileAsyncReadOnly(archPath);
+		asyncOpened = true;
+	}
+	return asyncFile;
+}
+
+bool PackResArchive::GetPackedOffset(const ResGUID& resource, FileSz& offset)
+{
+	I32 fileIndex = file.Find(resource.ResName());
+	if(fileIndex < 0)
+	{
+		return false;
+	}
+	offset = file.GetDataOffset(fileIndex);
+	return true;
+}
+
+bool PackResArchive::UnpackResource(const ResGUID& resource, const char* packedBuf, U32 packedSize, char* buffer)
+{
+	return file.UnpackFile(file.Find(resource.ResName()), packedBuf, packedSize, buffer);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "IResourceArchive.h"
 #include "FileManagement/path.h"
 #include "FileManagement/ArchiveTypes.h"
+#include "FileManagement/PackFile.h"
 #include "Logging/Log.h"
 
 namespace LeEK
@@ -11,15 +12,52 @@ namespace LeEK
 	private:
 		Path archPath;
 		ZipFile file;
+		IAsyncDataStream* asyncFile;
+		bool asyncOpened;
 	public:
 		ZipResArchive(const Path& archivePath);
-		~ZipResArchive(void) {}
+		~ZipResArchive(void);
 		FileSz GetRawSize(const ResGUID& resource) const;
 		U32 GetRawResource(const ResGUID& resource, char* buffer);
 		U32 GetNumResources() const;
 		const String GetResourceName(U32 resNum) const;
 		const String GetArchiveName() const;
 		bool Open();
+		ZipStream* OpenStream(const ResGUID& resource);
+		bool NeedsUnpack(const ResGUID& resource) const;
+		U32 GetPackedSize(const ResGUID& resource) const;
+		U32 GetPackedResource(const ResGUID& resource, char* buffer);
+		char* GetPackedView(const ResGUID& resource);
+		IAsyncDataStream* GetAsyncFile();
+		bool GetPackedOffset(const ResGUID& resource, FileSz& offset);
+		bool UnpackResource(const ResGUID& resource, const char* packedBuf, U32 packedSize, char* buffer);
 	};
-}
 
+	/**
+	Reads resources from the engine's own pack format (.lpak).
+	*/
+	class PackResArchive : public IResourceArchive
+	{
+	private:
+		Path archPath;
+		PackFile file;
+		IAsyncDataStream* asyncFile;
+		bool asyncOpened;
+	public:
+		PackResArchive(const Path& archivePath);
+		~PackResArchive(void);
+		FileSz GetRawSize(const ResGUID& resource) const;
+		U32 GetRawResource(const ResGUID& resource, char* buffer);
+		U32 GetNumResources() const;
+		const String GetResourceName(U32 resNum) const;
+		const String GetArchiveName() const;
+		bool Open();
+		bool NeedsUnpack(const ResGUID& resource) const;
+		U32 GetPackedSize(const ResGUID& resource) const;
+		U32 GetPackedResource(const ResGUID& resource, char* buffer);
+		char* GetPackedView(const ResGUID& resource);
+		IAsyncDataStream* GetAsyncFile();
+		bool GetPackedOffset(const ResGUID& resource, FileSz& offset);
+		bool UnpackResource(const ResGUID& resource, const char* packedBuf, U32 packedSize, char* buffer);
+	};
+}
\ No newline at end of file
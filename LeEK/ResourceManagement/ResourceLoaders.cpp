@@ -1,10 +1,12 @@
 #include "ResourceLoaders.h"
-#include "DataStructures/STLStreams.h"
 #include "Rendering/Texture.h"
 #include "Logging/Log.h"
 #include "Rendering/Model.h"
 #include "FileManagement/ModelFile.h"
-#include <Libraries/PNG++/png.hpp>
+#include "FileManagement/TextureFile.h"
+#include "Rendering/PixelConversion.h"
+#include <Libraries/PNG++/png.h>
+#include <csetjmp>
 
 using namespace LeEK;
 
@@ -12,26 +14,329 @@ using namespace LeEK;
 //Also have resources autoload into rendering system as needed?
 //Would also need them to be able to unload automatically
 
+namespace
+{
+	//PNG files start with an 8 byte signature, followed by the IHDR chunk:
+	//its 4 byte length and "IHDR" tag, then the width and height as big endian U32s.
+	const U32 PNG_SIG_LEN = 8;
+	const U32 IHDR_DIMS_END = PNG_SIG_LEN + 16;
+
+	U32 readBigEndian32(const unsigned char* bytes)
+	{
+		return ((U32)bytes[0] << 24) | ((U32)bytes[1] << 16) | ((U32)bytes[2] << 8) | (U32)bytes[3];
+	}
+
+	//Gets an image's dimensions from its header, without decoding anything.
+	bool readPNGDims(const char* rawBuf, FileSz rawSize, U32& width, U32& height)
+	{
+		if(!rawBuf || rawSize < IHDR_DIMS_END)
+		{
+			return false;
+		}
+		const unsigned char* bytes = (const unsigned char*)rawBuf;
+		if(png_sig_cmp(bytes, 0, PNG_SIG_LEN) != 0 || memcmp(bytes + PNG_SIG_LEN + 4, "IHDR", 4) != 0)
+		{
+			return false;
+		}
+		width = readBigEndian32(bytes + PNG_SIG_LEN + 8);
+		height = readBigEndian32(bytes + PNG_SIG_LEN + 12);
+		return width && height;
+	}
+
+	struct PNGMemReader
+	{
+		const png_byte* Data;
+		png_size_t Size;
+		png_size_t Pos;
+	};
+
+	void readPNGMem(png_structp png, png_bytep out, png_size_t len)
+	{
+		PNGMemReader* reader = (PNGMemReader*)png_get_io_ptr(png);
+		if(len > reader->Size - reader->Pos)
+		{
+			png_error(png, "Unexpected end of PNG data");
+		}
+		memcpy(out, reader->Data + reader->Pos, len);
+		reader->Pos += len;
+	}
+
+	void onPNGError(png_structp png, png_const_charp msg)
+	{
+		LogE(String("Couldn't decode PNG: ") + msg);
+		png_longjmp(png, 1);
+	}
+
+	void onPNGWarning(png_structp png, png_const_charp msg)
+	{
+		LogW(String("PNG warning: ") + msg);
+	}
+
+	/**
+	Decodes a PNG straight into dest as RGBA8, with its rows in reverse order,
+	as OpenGL expects.
+	Nothing in here can need destructing, since errors longjmp out of it.
+	*/
+	bool decodePNG(const char* rawBuf, FileSz rawSize, U32 width, U32 height, char* dest)
+	{
+		png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, onPNGError, onPNGWarning);
+		if(!png)
+		{
+			return false;
+		}
+		png_infop info = png_create_info_struct(png);
+		if(!info)
+		{
+			png_destroy_read_struct(&png, NULL, NULL);
+			return false;
+		}
+		PNGMemReader reader = { (const png_byte*)rawBuf, (png_size_t)rawSize, 0 };
+		if(setjmp(png_jmpbuf(png)))
+		{
+			png_destroy_read_struct(&png, &info, NULL);
+			return false;
+		}
+		png_set_read_fn(png, &reader, readPNGMem);
+		png_read_info(png, info);
+		if(png_get_image_width(png, info) != width || png_get_image_height(png, info) != height)
+		{
+			png_error(png, "Image size doesn't match its header");
+		}
+
+		//have libpng convert everything to 8 bit RGBA as it decodes.
+		png_set_expand(png);
+		png_set_strip_16(png);
+		png_set_gray_to_rgb(png);
+		png_set_add_alpha(png, 0xFF, PNG_FILLER_AFTER);
+		int numPasses = png_set_interlace_handling(png);
+		png_read_update_info(png, info);
+		png_size_t stride = (png_size_t)width * 4;
+		if(png_get_rowbytes(png, info) != stride)
+		{
+			png_error(png, "Couldn't convert image to RGBA8");
+		}
+
+		//Each row's decoded right into its place in the buffer.
+		//Interlaced images fill in the same rows on each pass.
+		for(int pass = 0; pass < numPasses; ++pass)
+		{
+			for(U32 i = 0; i < height; ++i)
+			{
+				png_read_row(png, (png_bytep)dest + (height - i - 1) * stride, NULL);
+			}
+		}
+		png_destroy_read_struct(&png, &info, NULL);
+		return true;
+	}
+
+	//TGA headers are 18 bytes, little endian, followed by the image ID and color map.
+	const U32 TGA_HEADER_LEN = 18;
+	const U8 TGA_TRUECOLOR = 2;
+	const U8 TGA_GRAYSCALE = 3;
+	//Set in the image type for the RLE compressed versions.
+	const U8 TGA_RLE_FLAG = 8;
+	//Descriptor bits that move the origin from the bottom left to the top or the right.
+	const U8 TGA_TOP_ORIGIN = 0x20;
+	const U8 TGA_RIGHT_ORIGIN = 0x10;
+	//RLE packet headers: the high bit marks a run of one repeated pixel,
+	//and the rest is the number of pixels, less one.
+	const U8 TGA_RUN_FLAG = 0x80;
+	const U8 TGA_COUNT_MASK = 0x7F;
+
+	struct TGAInfo
+	{
+		U32 Width;
+		U32 Height;
+		U32 BytesPerPixel;
+		U32 DataStart;
+		bool Compressed;
+		bool TopOrigin;
+	};
+
+	U16 readLittleEndian16(const unsigned char* bytes)
+	{
+		return (U16)(bytes[0] | (bytes[1] << 8));
+	}
+
+	//Reads and checks a TGA's header, without decoding anything.
+	bool readTGAHeader(const char* rawBuf, FileSz rawSize, TGAInfo& info)
+	{
+		if(!rawBuf || rawSize < TGA_HEADER_LEN)
+		{
+			return false;
+		}
+		const unsigned char* bytes = (const unsigned char*)rawBuf;
+		const U8 idLen = bytes[0];
+		const U8 colorMapType = bytes[1];
+		const U8 imageType = bytes[2];
+		const U8 baseType = imageType & ~TGA_RLE_FLAG;
+		const U8 bitsPerPixel = bytes[16];
+		const U8 descriptor = bytes[17];
+		const bool supported =	(baseType == TGA_TRUECOLOR && (bitsPerPixel == 24 || bitsPerPixel == 32)) ||
+								(baseType == TGA_GRAYSCALE && bitsPerPixel == 8);
+		if(!supported || colorMapType > 1 || (descriptor & TGA_RIGHT_ORIGIN))
+		{
+			return false;
+		}
+		//truecolor images can still carry a color map; it's just skipped
+		U32 colorMapSize = 0;
+		if(colorMapType == 1)
+		{
+			colorMapSize = readLittleEndian16(bytes + 5) * ((bytes[7] + 7) / 8);
+		}
+		info.Width = readLittleEndian16(bytes + 12);
+		info.Height = readLittleEndian16(bytes + 14);
+		info.BytesPerPixel = bitsPerPixel / 8;
+		info.DataStart = TGA_HEADER_LEN + idLen + colorMapSize;
+		info.Compressed = (imageType & TGA_RLE_FLAG) != 0;
+		info.TopOrigin = (descriptor & TGA_TOP_ORIGIN) != 0;
+		return info.Width && info.Height && info.DataStart <= rawSize;
+	}
+
+	//Converts pixels as the file stores them to RGBA8.
+	void convertTGAPixels(const U8* src, U8* dest, U32 numPixels, U32 bytesPerPixel)
+	{
+		switch(bytesPerPixel)
+		{
+		case 4:
+			PixelConversion::BGRAToRGBA(src, dest, numPixels);
+			break;
+		case 3:
+			PixelConversion::BGRToRGBA(src, dest, numPixels);
+			break;
+		default:
+			PixelConversion::GrayToRGBA(src, dest, numPixels);
+			break;
+		}
+	}
+
+	//Where a row, counted in file order, goes in the decoded image.
+	U8* tgaDestRow(U8* dest, const TGAInfo& info, U32 row)
+	{
+		const U32 destRow = info.TopOrigin ? (info.Height - row - 1) : row;
+		return dest + ((size_t)destRow * info.Width * 4);
+	}
+
+	/**
+	Decodes a TGA straight into dest as RGBA8, last row first, as OpenGL expects.
+	That's the order TGAs are usually stored in, so most images convert in a single pass;
+	ones with their origin at the top have each row sent to the other end.
+	*/
+	bool decodeTGA(const char* rawBuf, FileSz rawSize, const TGAInfo& info, char* dest)
+	{
+		const U8* src = (const U8*)rawBuf + info.DataStart;
+		const U8* srcEnd = (const U8*)rawBuf + rawSize;
+		const U32 bpp = info.BytesPerPixel;
+		U8* const destStart = (U8*)dest;
+
+		if(!info.Compressed)
+		{
+			if((FileSz)(srcEnd - src) < (FileSz)info.Width * info.Height * bpp)
+			{
+				LogE("TGA is missing pixels!");
+				return false;
+			}
+			if(!info.TopOrigin)
+			{
+				convertTGAPixels(src, destStart, info.Width * info.Height, bpp);
+				return true;
+			}
+			for(U32 row = 0; row < info.Height; ++row)
+			{
+				convertTGAPixels(src + ((size_t)row * info.Width * bpp), tgaDestRow(destStart, info, row), info.Width, bpp);
+			}
+			return true;
+		}
+
+		//Packets can run over the end of a row, so keep track of where in the row we are.
+		U32 row = 0, col = 0;
+		U8* destRow = tgaDestRow(destStart, info, 0);
+		while(row < info.Height)
+		{
+			if(src >= srcEnd)
+			{
+				LogE("TGA is missing pixels!");
+				return false;
+			}
+			const U8 packet = *src++;
+			U32 count = (packet & TGA_COUNT_MASK) + 1;
+			const bool isRun = (packet & TGA_RUN_FLAG) != 0;
+			const U32 packetBytes = isRun ? bpp : count * bpp;
+			if((FileSz)(srcEnd - src) < packetBytes)
+			{
+				LogE("TGA is missing pixels!");
+				return false;
+			}
+			U8 runPixel[4];
+			if(isRun)
+			{
+				convertTGAPixels(src, runPixel, 1, bpp);
+			}
+			const U8* packetSrc = src;
+			src += packetBytes;
+			//pixels past the end of the image are dropped
+			while(count > 0 && row < info.Height)
+			{
+				const U32 numPixels = Math::Min(count, info.Width - col);
+				U8* out = destRow + (col * 4);
+				if(isRun)
+				{
+					for(U32 i = 0; i < numPixels; ++i)
+					{
+						memcpy(out + (i * 4), runPixel, 4);
+					}
+				}
+				else
+				{
+					convertTGAPixels(packetSrc, out, numPixels, bpp);
+					packetSrc += numPixels * bpp;
+				}
+				count -= numPixels;
+				col += numPixels;
+				if(col == info.Width)
+				{
+					col = 0;
+					++row;
+					if(row < info.Height)
+					{
+						destRow = tgaDestRow(destStart, info, row);
+					}
+				}
+			}
+		}
+		return true;
+	}
+}
+
+bool PNGLoader::ReadImageSize(const char* rawBuf, FileSz rawSize, U32& width, U32& height)
+{
+	return readPNGDims(rawBuf, rawSize, width, height);
+}
+
+bool PNGLoader::DecodeImage(const char* rawBuf, FileSz rawSize, U32 width, U32 height, char* dest)
+{
+	return decodePNG(rawBuf, rawSize, width, height, dest);
+}
+
 FileSz PNGLoader::GetLoadedResSize(char* rawBuf, FileSz rawSize)
 {
-	MemBuf wrappedBuf(rawBuf, rawSize);
-	std::istream bufStr (&wrappedBuf);
-	png::image<png::rgba_pixel> img(bufStr);
-	//include a Texture2D struct?
-	FileSz pixDataSize = img.get_height() * img.get_width() * 4;
-	if(pixDataSize == 0)
+	//only the header's needed for this.
+	U32 width, height;
+	if(!readPNGDims(rawBuf, rawSize, width, height))
 	{
 		return 0;
 	}
-	return sizeof(Texture2D) + pixDataSize;
+	return sizeof(Texture2D) + (FileSz)width * height * 4;
 }
 
-bool PNGLoader::LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resource> resource)
+bool PNGLoader::LoadResource(char* rawBuf, FileSz rawSize, Resource* resource)
 {
-	//wrap the raw data into a stream for PNG++ to use.
-	MemBuf wrappedBuf(rawBuf, rawSize);
-	std::istream bufStr (&wrappedBuf);
-	png::image<png::rgba_pixel> img(bufStr);
+	U32 width, height;
+	if(!readPNGDims(rawBuf, rawSize, width, height))
+	{
+		LogE("Couldn't read PNG header!");
+		return false;
+	}
 	//Also init the texture header in the resource buffer.
 	char* resBuf = resource->WriteableBuffer();
 	Texture2D* texHeader = (Texture2D*)(void*)resBuf;
@@ -44,56 +349,112 @@ bool PNGLoader::LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resou
 	texHeader->HasMipMap = false;
 	texHeader->PixType = Texture2D::RGBA8;
 	texHeader->CompType = Texture2D::NONE;
-	FileSz width = img.get_width();
-	FileSz height = img.get_height();
-	if(!width || !height)
-	{
-		return false;
-	}
 	texHeader->Width = width;
 	texHeader->Height = height;
 
-	//and copy the unpacked PNG data
-	for(FileSz i = 0; i < height; ++i)
+	//and unpack the PNG data right after it.
+	return decodePNG(rawBuf, rawSize, width, height, resBufData);
+}
+
+bool TGALoader::ReadImageSize(const char* rawBuf, FileSz rawSize, U32& width, U32& height)
+{
+	TGAInfo info;
+	if(!readTGAHeader(rawBuf, rawSize, info))
 	{
-		for(FileSz j = 0; j < width; ++j)
-		{
-			FileSz bytePos = (i*width*4) + (j * 4);
-			//PNG pixels aren't stored in the same order as OpenGL expects;
-			//you'll need to store rows in reverse order
-			png::rgba_pixel pix = img.get_pixel(j, (height - i - 1));
-			resBufData[bytePos] = pix.red;
-			resBufData[bytePos + 1] = pix.green;
-			resBufData[bytePos + 2] = pix.blue;
-			resBufData[bytePos + 3] = pix.alpha;
-		}
+		return false;
 	}
+	width = info.Width;
+	height = info.Height;
 	return true;
 }
 
+bool TGALoader::DecodeImage(const char* rawBuf, FileSz rawSize, U32 width, U32 height, char* dest)
+{
+	TGAInfo info;
+	if(!readTGAHeader(rawBuf, rawSize, info) || info.Width != width || info.Height != height)
+	{
+		LogE("Couldn't read TGA header, or image size doesn't match it!");
+		return false;
+	}
+	return decodeTGA(rawBuf, rawSize, info, dest);
+}
+
 FileSz TGALoader::GetLoadedResSize(char* rawBuf, FileSz rawSize)
 {
-	Log::W("Calling unimplemented function!");
-	return 0;
+	//only the header's needed for this.
+	TGAInfo info;
+	if(!readTGAHeader(rawBuf, rawSize, info))
+	{
+		return 0;
+	}
+	return sizeof(Texture2D) + (FileSz)info.Width * info.Height * 4;
 }
 
-bool TGALoader::LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resource> resource)
+bool TGALoader::LoadResource(char* rawBuf, FileSz rawSize, Resource* resource)
 {
-	Log::W("Calling unimplemented function!");
-	return false;
+	TGAInfo info;
+	if(!readTGAHeader(rawBuf, rawSize, info))
+	{
+		LogE("Couldn't read TGA header, or it's a kind of TGA that isn't supported!");
+		return false;
+	}
+	//Also init the texture header in the resource buffer.
+	char* resBuf = resource->WriteableBuffer();
+	Texture2D* texHeader = (Texture2D*)(void*)resBuf;
+	//clear out the texture header.
+	memset(texHeader, 0, sizeof(Texture2D));
+	//the start of the buffer is a texture header.
+	char* resBufData = resBuf + sizeof(Texture2D);
+	texHeader->BitDepth = 32;
+	texHeader->Data = resBufData;
+	texHeader->HasMipMap = false;
+	texHeader->PixType = Texture2D::RGBA8;
+	texHeader->CompType = Texture2D::NONE;
+	texHeader->Width = info.Width;
+	texHeader->Height = info.Height;
+
+	//and unpack the pixels right after it.
+	return decodeTGA(rawBuf, rawSize, info, resBufData);
+}
+
+FileSz TextureLoader::GetLoadedResSize(char* rawBuf, FileSz rawSize)
+{
+	if(!TextureMgr::IsTextureFile(rawBuf, rawSize))
+	{
+		return 0;
+	}
+	//the whole file goes after the texture, with room to align it.
+	return sizeof(Texture2D) + TEXTURE_DATA_ALIGN - 1 + rawSize;
+}
+
+const char* TextureLoader::GetTextureFile(const char* resBuf)
+{
+	const char* fileStart = resBuf + sizeof(Texture2D);
+	return (const char*)(((size_t)fileStart + TEXTURE_DATA_ALIGN - 1) & ~(size_t)(TEXTURE_DATA_ALIGN - 1));
+}
+
+bool TextureLoader::LoadResource(char* rawBuf, FileSz rawSize, Resource* resource)
+{
+	char* resBuf = resource->WriteableBuffer();
+	Texture2D* texHeader = new ((Texture2D*)resBuf) Texture2D();
+	//Start the file on an aligned address, so its level data is aligned too.
+	char* fileStart = (char*)GetTextureFile(resBuf);
+	memcpy(fileStart, rawBuf, rawSize);
+	return TextureMgr::ReadTextureInPlace(*texHeader, fileStart, rawSize);
 }
 
 FileSz ModelLoader::GetLoadedResSize(char* rawBuf, FileSz rawSize)
 {
 	//Model needs to store the raw geometry data and a model object so the data can be used by the engine.
-	if(!loadedSize)
+	if(ModelMgr::IsInPlaceModel(rawBuf, rawSize))
 	{
-		loadedSize = sizeof(Model) + ModelMgr::FindFileGeomSize(rawBuf);
+		//the whole file goes after the model, with room to align it.
+		return sizeof(Model) + MODEL_DATA_ALIGN - 1 + rawSize;
 	}
-	return loadedSize;
+	return sizeof(Model) + ModelMgr::FindFileGeomSize(rawBuf);
 }
 
-U16 getMeshCount(char* rawBuf)
+U16 getMeshCount(const char* rawBuf)
 {
 	if(!rawBuf)
 	{
@@ -112,12 +473,37 @@ U16 getMeshCount(char* rawBuf)
 	return mainHdr->NumUnits;
 }
 
-bool ModelLoader::LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resource> resource)
+bool ModelLoader::LoadResource(char* rawBuf, FileSz rawSize, Resource* resource)
 {
 	//need to do friggin' placement new?
 	Model* model = new ((Model*)resource->WriteableBuffer()) Model(getMeshCount(rawBuf));
 	char* geomStart = resource->WriteableBuffer() + sizeof(Model);
+	if(ModelMgr::IsInPlaceModel(rawBuf, rawSize))
+	{
+		//In-place files are copied in one go, and used right where they land.
+		//Start them on an aligned address, so their geometry blocks are aligned too.
+		char* fileStart = (char*)(((size_t)geomStart + MODEL_DATA_ALIGN - 1) & ~(size_t)(MODEL_DATA_ALIGN - 1));
+		memcpy(fileStart, rawBuf, rawSize);
+		return ModelMgr::ReadModelInPlace(*model, fileStart, rawSize);
+	}
 	size_t geomSize = GetLoadedResSize(rawBuf, rawSize) - sizeof(Model);
 	bool result = ModelMgr::ReadModelMemory(*model, rawBuf, rawSize, geomStart, geomSize);
 	return result;
-}
\ No newline at end of file
+}
+
+FileSz ModelLoader::GetMappedResSize(const char* view, FileSz size)
+{
+	//the geometry blocks are aligned relative to the file's start,
+	//so the file has to start on an aligned address to be used where it is.
+	if(!ModelMgr::IsInPlaceModel(view, size) || ((size_t)view & (MODEL_DATA_ALIGN - 1)) != 0)
+	{
+		return 0;
+	}
+	return sizeof(Model);
+}
+
+bool ModelLoader::LoadMappedResource(const char* view, FileSz size, Resource* resource)
+{
+	Model* model = new ((Model*)resource->WriteableBuffer()) Model(getMeshCount(view));
+	return ModelMgr::ReadModelInPlace(*model, view, size);
+}
@@ -13,7 +13,7 @@ namespace LeEK
 		virtual bool UseRawResource() { return true; }
 		virtual FileSz GetLoadedResSize(char* rawBuf, FileSz rawSize) { return rawSize; }
 		//does no processing
-		virtual bool LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resource> resource) { return true; }
+		virtual bool LoadResource(char* rawBuf, FileSz rawSize, Resource* resource) { return true; }
 		virtual FileSz StreamRead(DataStream* pData, char* dest, FileSz numBytes);
 		virtual FileSz StreamSeek(DataStream* pData, FileSz relOffset);
 		virtual FileSz StreamClose();
@@ -25,29 +25,69 @@ namespace LeEK
 	public:
 		virtual String GetPattern() { return "*.png"; }
 		virtual bool UseRawResource() { return false; }
+		virtual ResCategory GetCategory() { return TEXTURE_RES; }
 		virtual FileSz GetLoadedResSize(char* rawBuf, FileSz rawSize);
-		virtual bool LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resource> resource);
+		virtual bool LoadResource(char* rawBuf, FileSz rawSize, Resource* resource);
+		//only decodes into the resource buffer
+		virtual bool LoadsOnWorkerThread() { return true; }
+		//Reads an image's dimensions from its header, for tools that decode images themselves.
+		static bool ReadImageSize(const char* rawBuf, FileSz rawSize, U32& width, U32& height);
+		//Decodes an image into width * height RGBA8 pixels, last row first, as OpenGL expects.
+		static bool DecodeImage(const char* rawBuf, FileSz rawSize, U32 width, U32 height, char* dest);
 	};
 
+	/**
+	Loads truecolor (24 and 32 bit) and grayscale (8 bit) TGAs, raw or RLE compressed,
+	into RGBA8 textures. Color mapped images aren't supported.
+	*/
 	class TGALoader : public IResourceLoader
 	{
 	public:
 		virtual String GetPattern() { return "*.tga"; }
 		virtual bool UseRawResource() { return false; }
+		virtual ResCategory GetCategory() { return TEXTURE_RES; }
 		virtual FileSz GetLoadedResSize(char* rawBuf, FileSz rawSize);
-		virtual bool LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resource> resource);
+		virtual bool LoadResource(char* rawBuf, FileSz rawSize, Resource* resource);
+		//only decodes into the resource buffer
+		virtual bool LoadsOnWorkerThread() { return true; }
+		//Reads an image's dimensions from its header. Fails for images the loader can't decode.
+		static bool ReadImageSize(const char* rawBuf, FileSz rawSize, U32& width, U32& height);
+		//Decodes an image into width * height RGBA8 pixels, last row first, as OpenGL expects.
+		static bool DecodeImage(const char* rawBuf, FileSz rawSize, U32 width, U32 height, char* dest);
+	};
+
+	/**
+	Loads cooked textures (.ltex). They're copied in one go
+	and used right where they land, so loading doesn't decode anything.
+	*/
+	class TextureLoader : public IResourceLoader
+	{
+	public:
+		virtual String GetPattern() { return "*.ltex"; }
+		virtual bool UseRawResource() { return false; }
+		virtual ResCategory GetCategory() { return TEXTURE_RES; }
+		virtual FileSz GetLoadedResSize(char* rawBuf, FileSz rawSize);
+		virtual bool LoadResource(char* rawBuf, FileSz rawSize, Resource* resource);
+		//only copies into the resource buffer
+		virtual bool LoadsOnWorkerThread() { return true; }
+		/**
+		Finds the cooked file in a loaded resource's buffer,
+		for looking up atlas regions with TextureMgr.
+		*/
+		static const char* GetTextureFile(const char* resBuf);
 	};
 
 	//the front of the loaded resource can be read as a Model object.
 	class ModelLoader : public IResourceLoader
 	{
-	private:
-		size_t loadedSize;
 	public:
-		ModelLoader() : loadedSize(0) {}
 		virtual String GetPattern() { return "*.lmdl"; }
 		virtual bool UseRawResource() { return false; }
+		virtual ResCategory GetCategory() { return MODEL_RES; }
 		virtual FileSz GetLoadedResSize(char* rawBuf, FileSz rawSize);
-		virtual bool LoadResource(char* rawBuf, FileSz rawSize, std::shared_ptr<Resource> resource);
+		virtual bool LoadResource(char* rawBuf, FileSz rawSize, Resource* resource);
+		//in-place models in mapped archives only need room for the Model object.
+		virtual FileSz GetMappedResSize(const char* view, FileSz size);
+		virtual bool LoadMappedResource(const char* view, FileSz size, Resource* resource);
 	};
 }
\ No newline at end of file
@@ -6,47 +6,80 @@
 #include "Strings/StringUtils.h"
 #include "FileManagement/Filesystem.h"
 #include "ResourceManagement/ResourceArchive.h"
+#include "Hashing/Hash.h"
+#include "Stats/ResCacheStats.h"
+#include <chrono>
 
 using namespace LeEK;
 
 TypedHandle<ResourceManager> resMgrHnd = 0;
 
+namespace
+{
+	inline bool isArchiveNamed(const String& archName, const ResGUID& guid)
+	{
+		return	archName.length() == guid.ArchiveNameLen() &&
+				PathsEqualNoCase(archName.c_str(), guid.Name, guid.ArchiveNameLen());
+	}
+
+	typedef std::chrono::steady_clock DecodeClock;
+	inline F32 microsecondsSince(DecodeClock::time_point start)
+	{
+		return std::chrono::duration<F32, std::micro>(DecodeClock::now() - start).count();
+	}
+}
+
 ResourceManager::ResourceManager()
 {
 	cacheMax = 0;
 	cacheUsed = 0;
+	numDecodeThreads = 0;
+	preloadMaxInFlight = 32 * 1024 * 1024;
+	for(U32 i = 0; i < RESCAT_LEN; ++i)
+	{
+		categoryMax[i] = 0;
+		categoryUsed[i] = 0;
+	}
+	frameNum = 0;
 }
 
 ResourceManager::~ResourceManager(void)
 {
 }
 
-bool ResourceManager::makeRoom(FileSz size)
+bool ResourceManager::makeRoom(FileSz size, ResCategory category)
 {
 	//sanity check!
 	if(size > cacheMax)
 	{
 		return false;
 	}
+	//keep the category within its budget first.
+	//If everything in it's referenced, let it go over; only the total's a hard limit.
+	FileSz budget = categoryMax[category];
+	while(budget && categoryUsed[category] + size > budget)
+	{
+		if(!freeOneResource(category))
+		{
+			break;
+		}
+	}
 	//now try releasing resources
 	while((cacheMax - cacheUsed) < size)
 	{
-		//there's no more resources being tracked, but there's still not enough room.
-		//must be some shared_ptrs to those resources remaining elsewhere.
-		if(lruList.empty())
+		//everything left is in use, so there's no room to be had.
+		if(!freeOneResource(RESCAT_LEN))
 		{
 			return false;
 		}
-
-		freeOneResource();
 	}
 	return true;
 }
 
-char* ResourceManager::allocate(FileSz size)
+char* ResourceManager::allocate(FileSz size, ResCategory category)
 {
 	//ensure the buffer will fit in the cache
-	if(!makeRoom(size))
+	if(!makeRoom(size, category))
 	{
 		return NULL;
 	}
@@ -61,80 +94,183 @@ char* ResourceManager::allocate(FileSz size)
 	return res;
 }
 
-void ResourceManager::freeOneResource()
+bool ResourceManager::freeOneResource(ResCategory category)
 {
-	//pluck the resource at the END of the LRU.
-	ResList::iterator toRemove = lruList.end();
-	toRemove--;
-
-	//get the pointer, so we can also remove the reference in the map.
-	std::shared_ptr<Resource> resource = *toRemove;
+	//A category over its budget has to make room within itself,
+	//so only resources used this frame are safe from the other categories.
+	bool keepFrame = frameNum && category == RESCAT_LEN;
+	CacheEntry* victim = pickVictim(category, keepFrame);
+	//Keeping this frame's resources is only a preference;
+	//evicting one of them beats failing the load.
+	if(!victim && keepFrame)
+	{
+		victim = pickVictim(category, false);
+	}
+	if(!victim)
+	{
+		return false;
+	}
+	ResCacheStats::ReportEviction(victim->Category, victim->Size);
+	rememberEviction(victim->Res->GUID());
+	removeEntry(*victim);
+	return true;
+}
 
-	//and remove the respective pointers from the res collections
-	lruList.pop_back();
-	resMap.erase(resource->GUID().Name);
+ResourceManager::CacheEntry* ResourceManager::pickVictim(ResCategory category, bool keepFrame)
+{
+	//Weigh the resources at the END of the LRU against each other,
+	//and pick whichever costs least to reload for the space it frees.
+	//When the costs are the same, that's just the least recently used.
+	CacheEntry* victim = NULL;
+	F32 victimCost = 0;
+	U32 numCandidates = 0;
+	IntrusiveList::nodePtr node = lruList.Back();
+	U32 numEntries = resMap.size();
+	for(U32 i = 0; i < numEntries && node != lruList.Root() && numCandidates < EVICTION_WINDOW; ++i)
+	{
+		CacheEntry* entry = static_cast<CacheEntry*>(node);
+		node = node->Prev;
+		//everything in front of a resource used this frame was used this frame too.
+		if(keepFrame && entry->LastUsedFrame == frameNum)
+		{
+			break;
+		}
+		//Resources that are still referenced outside the cache are pinned;
+		//dropping them wouldn't free anything, and they'd just be loaded again.
+		//They're in use, so treat them as just used.
+		if(entry->Res.UseCount() > 1)
+		{
+			entry->LastUsedFrame = frameNum;
+			lruList.Remove(entry);
+			lruList.AddToFront(entry);
+			continue;
+		}
+		//mapped resources don't take up any room.
+		if(!entry->Size || (category != RESCAT_LEN && entry->Category != category))
+		{
+			continue;
+		}
+		F32 costPerByte = entry->ReloadCost / entry->Size;
+		if(!victim || costPerByte < victimCost)
+		{
+			victim = entry;
+			victimCost = costPerByte;
+		}
+		++numCandidates;
+	}
+	return victim;
 }
 
-void ResourceManager::ReportMemoryFreed(FileSz sizeFreed)
+void ResourceManager::rememberEviction(const ResGUID& resGUID)
 {
-	//notify the resource manager of the freed memory
-	L_ASSERT(sizeFreed <= cacheUsed && "Attempted to free more memory than used by resource cache!");
-	cacheUsed -= Math::Min(sizeFreed, cacheUsed);
+	if(evictedMap.find(ResKey(resGUID)) != evictedMap.end())
+	{
+		return;
+	}
+	evictedList.push_front(resGUID);
+	evictedMap[ResKey(evictedList.front())] = evictedList.begin();
+	if(evictedList.size() > MAX_EVICTED_GUIDS)
+	{
+		evictedMap.erase(ResKey(evictedList.back()));
+		evictedList.pop_back();
+	}
 }
 
-std::shared_ptr<Resource> ResourceManager::find(ResGUID* resGUID)
+bool ResourceManager::forgetEviction(const ResGUID& resGUID)
 {
-	ResMap::const_iterator resIt = resMap.find(resGUID->Name);
-	if(resIt != resMap.end())
+	EvictedMap::iterator evictedIt = evictedMap.find(ResKey(resGUID));
+	if(evictedIt == evictedMap.end())
 	{
-		return resIt->second;
+		return false;
 	}
-	return std::shared_ptr<Resource>();
+	EvictedList::iterator listIt = evictedIt->second;
+	evictedMap.erase(evictedIt);
+	evictedList.erase(listIt);
+	return true;
 }
 
-const void* ResourceManager::update(std::shared_ptr<Resource> res)
+void ResourceManager::removeEntry(CacheEntry& entry)
 {
-	//search the list for the resource.
-	ResList::iterator it = lruList.begin();
-	while(it != lruList.end())
+	categoryUsed[entry.Category] -= Math::Min(entry.Size, categoryUsed[entry.Category]);
+	ResCacheStats::ReportUsage(entry.Category, categoryUsed[entry.Category], categoryMax[entry.Category]);
+	lruList.Remove(&entry);
+	//hold onto the handle while the map entry goes,
+	//since the entry's key points into the resource.
+	ResPtr resource = entry.Res;
+	resMap.erase(ResKey(resource->GUID()));
+}
+
+void ResourceManager::clearCache()
+{
+	while(!lruList.Empty())
 	{
-		if((*it)->GUID() == res->GUID())
-		{
-			break;
-		}
-		++it;
+		removeEntry(*static_cast<CacheEntry*>(lruList.Back()));
 	}
-	//quit if it wasn't found.
-	if(it == lruList.end())
+}
+
+ResCategory ResourceManager::categoryOf(const ResGUID& resGUID)
+{
+	std::shared_ptr<IResourceLoader> loader = findLoader(resGUID);
+	return loader ? loader->GetCategory() : OTHER_RES;
+}
+
+F32 ResourceManager::reloadCost(const ResGUID& resGUID, FileSz rawSize, F32 decodeUs)
+{
+	//reading's assumed to cost the same per byte everywhere,
+	//so it's estimated from the bytes that'd have to be read again.
+	FileSz packedSize = rawSize;
+	ArchiveMap::iterator archIt = archiveMap.find(resGUID.ArchiveID());
+	if(resGUID.ArchiveNameLen() > 0 && archIt != archiveMap.end() && archIt->second.Archive->NeedsUnpack(resGUID))
 	{
-		return NULL;
+		packedSize = archIt->second.Archive->GetPackedSize(resGUID);
 	}
-	//otherwise, pop it and push it to the front.
-	else
+	return (F32)packedSize / READ_BYTES_PER_US + decodeUs;
+}
+
+void ResourceManager::SetCategoryBudget(ResCategory category, FileSz bytes)
+{
+	categoryMax[category] = bytes;
+	ResCacheStats::ReportUsage(category, categoryUsed[category], bytes);
+}
+
+void ResourceManager::ReportMemoryFreed(FileSz sizeFreed)
+{
+	//notify the resource manager of the freed memory
+	L_ASSERT(sizeFreed <= cacheUsed && "Attempted to free more memory than used by resource cache!");
+	cacheUsed -= Math::Min(sizeFreed, cacheUsed);
+}
+
+ResPtr ResourceManager::find(ResGUID* resGUID)
+{
+	ResMap::const_iterator resIt = resMap.find(ResKey(*resGUID));
+	if(resIt != resMap.end())
 	{
-		lruList.erase(it);
-		lruList.push_front(res);
-		return res.get();
+		return resIt->second.Res;
 	}
+	return ResPtr();
+}
+
+void ResourceManager::update(CacheEntry& entry)
+{
+	//pop it and push it to the front.
+	lruList.Remove(&entry);
+	lruList.AddToFront(&entry);
+	entry.LastUsedFrame = frameNum;
 }
 
 bool ResourceManager::openResource(const ResGUID& resGUID, char** outRawBuf, FileSz* outRawSize, bool useRawResource)
 {
-	String archName = ToLower(resGUID.ResArchiveName());
-	if(archiveMap.count(archName) < 1)
+	TypedHandle<IResourceArchive> archive = findArchive(resGUID);
+	if(!archive.GetHandle())
 	{
-		if(!OpenArchive(resGUID))
-		{
-			LogW(String("Couldn't load archive ") + archName + "!");
-			*outRawBuf = NULL;
-			*outRawSize = 0;
-			return false;
-		}
+		LogW(String("Couldn't load archive ") + resGUID.ResArchiveName() + "!");
+		*outRawBuf = NULL;
+		*outRawSize = 0;
+		return false;
 	}
 
 	//now try to allocate a raw data buffer
 	//it's temporary if the loader indicates to not use raw data
-	TypedHandle<IResourceArchive> archive = archiveMap[archName];
 	FileSz rawSize = archive->GetRawSize(resGUID);
 	*outRawSize = rawSize;
 	if(!rawSize)
@@ -143,41 +279,36 @@ bool ResourceManager::openResource(const ResGUID& resGUID, char** outRawBuf, Fil
 		return false;
 	}
 	*outRawBuf =	useRawResource ? 
-					allocate(rawSize) : 
+					allocate(rawSize, categoryOf(resGUID)) : 
 					CustomArrayNew<char>(rawSize, RESFILE_ALLOC, "TempBufAlloc");
+	if(!*outRawBuf)
+	{
+		LogW(String("Couldn't make room in the cache for ") + resGUID.ResName() + "!");
+		*outRawSize = 0;
+		return false;
+	}
+	//the I/O thread might be using the archive
+	Lock archiveLock(archiveMutex);
 	archive->GetRawResource(resGUID, *outRawBuf);
 	return true;
 }
 
-std::shared_ptr<Resource> ResourceManager::load(const ResGUID& resGUID)
+std::shared_ptr<IResourceLoader> ResourceManager::findLoader(const ResGUID& resGUID)
 {
-	std::shared_ptr<IResourceLoader> loader;
-	std::shared_ptr<Resource> resource;
-	//try to get a loader...
 	for(ResLoaderList::iterator it = loaderList.begin(); it != loaderList.end(); ++it)
 	{
 		std::shared_ptr<IResourceLoader> possLoader = *it;
 		if(StringUtils::WildcardMatch(resGUID.ResName(), possLoader->GetPattern().c_str()))
 		{
-			loader = possLoader;
-			break;
+			return possLoader;
 		}
 	}
-	//fail if there is no loader
-	if(!loader)
-	{
-		L_ASSERT(loader && "No default resource loader found!");
-		return resource;
-	}
-
-	//open the archive if necessary
-	char* rawBuf = NULL;
-	FileSz rawSize = 0;
-	if(!openResource(resGUID, &rawBuf, &rawSize, loader->UseRawResource()))
-	{
-		return resource;
-	}
+	return std::shared_ptr<IResourceLoader>();
+}
 
+ResPtr ResourceManager::buildResource(const ResGUID& resGUID, std::shared_ptr<IResourceLoader> loader, char* rawBuf, FileSz rawSize)
+{
+	ResPtr resource;
 	//the actual buffer
 	char* resBuf = NULL;
 	FileSz size = 0;
@@ -186,59 +317,123 @@ std::shared_ptr<Resource> ResourceManager::load(const ResGUID& resGUID)
 	if(loader->UseRawResource())
 	{
 		resBuf = rawBuf;
-		resource = GetSharedPtr(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc", 
+		resource = ResPtr(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc", 
 			resGUID, resBuf, rawSize, resMgrHnd));
 	}
 	else
 	{
 		size = loader->GetLoadedResSize(rawBuf, rawSize);
-		resBuf = allocate(size);
+		resBuf = allocate(size, loader->GetCategory());
 		if(!rawBuf || !resBuf)
 		{
 			//out of memory again!
-			return std::shared_ptr<Resource>();
+			CustomArrayDelete(rawBuf);
+			return ResPtr();
 		}
-		resource = GetSharedPtr(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc", 
+		resource = ResPtr(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc", 
 			resGUID, resBuf, size, resMgrHnd));
-		bool resLoaded = loader->LoadResource(rawBuf, rawSize, resource);
+		bool resLoaded = loader->LoadResource(rawBuf, rawSize, resource.get());
 		CustomArrayDelete(rawBuf);
 
 		if(!resLoaded)
 		{
 			//something went wrong with the load
-			return std::shared_ptr<Resource>();
+			return ResPtr();
 		}
 	}
+	return resource;
+}
 
-	//now insert the resource into the res collections
-	if(resource)
+ResPtr ResourceManager::mapResource(const ResGUID& resGUID, std::shared_ptr<IResourceLoader> loader)
+{
+	if(!loader || resGUID.ArchiveNameLen() == 0)
 	{
-		lruList.push_front(resource);
-		resMap[resGUID.Name] = resource;
+		return ResPtr();
+	}
+	TypedHandle<IResourceArchive> archive = findArchive(resGUID);
+	if(!archive.GetHandle())
+	{
+		return ResPtr();
+	}
+	if(archive->NeedsUnpack(resGUID))
+	{
+		return ResPtr();
+	}
+	char* view = archive->GetPackedView(resGUID);
+	FileSz size = archive->GetRawSize(resGUID);
+	if(!view || !size)
+	{
+		return ResPtr();
+	}
+	if(loader->UseRawResource())
+	{
+		//no allocation or copy; the view's never counted against the cache.
+		return ResPtr(CustomNew<MappedResource>(RESFILE_ALLOC, "ResAlloc", 
+			resGUID, view, size, resMgrHnd));
+	}
+	//only the loader's own data is allocated and counted; the view isn't copied.
+	FileSz resSize = loader->GetMappedResSize(view, size);
+	if(!resSize)
+	{
+		return ResPtr();
+	}
+	char* resBuf = allocate(resSize, loader->GetCategory());
+	if(!resBuf)
+	{
+		return ResPtr();
+	}
+	ResPtr resource(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc", 
+		resGUID, resBuf, resSize, resMgrHnd));
+	if(!loader->LoadMappedResource(view, size, resource.get()))
+	{
+		return ResPtr();
 	}
-
 	return resource;
 }
 
-std::shared_ptr<StreamingResource> ResourceManager::loadStream(const ResGUID& resGUID)
+void ResourceManager::cacheResource(const ResPtr& res, ResCategory category, F32 reloadCostUs)
 {
-	std::shared_ptr<IResourceLoader> loader = NULL;
-	std::shared_ptr<StreamingResource> stream = NULL;
-	//try to get a loader...
-	for(ResLoaderList::iterator it = loaderList.begin(); it != loaderList.end(); ++it)
+	//the key has to point at the cached resource's GUID,
+	//so replace any entry that's already there.
+	ResMap::iterator resIt = resMap.find(ResKey(res->GUID()));
+	if(resIt != resMap.end())
 	{
-		std::shared_ptr<IResourceLoader> possLoader = *it;
-		if(StringUtils::WildcardMatch(resGUID.ResName(), possLoader->GetPattern().c_str()))
-		{
-			loader = possLoader;
-			break;
-		}
+		removeEntry(resIt->second);
+	}
+	CacheEntry& entry = resMap[ResKey(res->GUID())];
+	entry.Res = res;
+	entry.Category = category;
+	entry.Size = res->IsMapped() ? 0 : res->Size();
+	entry.ReloadCost = reloadCostUs;
+	entry.LastUsedFrame = frameNum;
+	lruList.AddToFront(&entry);
+
+	categoryUsed[category] += entry.Size;
+	ResCacheStats::ReportUsage(category, categoryUsed[category], categoryMax[category]);
+	if(forgetEviction(res->GUID()))
+	{
+		ResCacheStats::ReportReload(category, entry.Size);
 	}
+}
+
+ResPtr ResourceManager::load(const ResGUID& resGUID)
+{
+	ResPtr resource;
+	//try to get a loader...
+	std::shared_ptr<IResourceLoader> loader = findLoader(resGUID);
 	//fail if there is no loader
 	if(!loader)
 	{
-		L_ASSERT(loader && "No default stream loader found!");
-		return stream;
+		L_ASSERT(loader && "No default resource loader found!");
+		return resource;
+	}
+
+	//stored resources in mapped archives can be used where they are.
+	resource = mapResource(resGUID, loader);
+	if(resource)
+	{
+		cacheResource(resource, loader->GetCategory());
+		return resource;
 	}
 
 	//open the archive if necessary
@@ -246,55 +441,167 @@ std::shared_ptr<StreamingResource> ResourceManager::loadStream(const ResGUID& re
 	FileSz rawSize = 0;
 	if(!openResource(resGUID, &rawBuf, &rawSize, loader->UseRawResource()))
 	{
-		return stream;
+		return resource;
 	}
 
-	//the actual buffer
-	char* resBuf = NULL;
-	FileSz size = 0;
+	DecodeClock::time_point decodeStart = DecodeClock::now();
+	resource = buildResource(resGUID, loader, rawBuf, rawSize);
+	F32 decodeUs = microsecondsSince(decodeStart);
 
-	//do the loader stuff
-	if(loader->UseRawResource())
+	//now insert the resource into the res collections
+	if(resource)
 	{
-		resBuf = rawBuf;
-		stream = GetSharedPtr(LNew(StreamingResource, RESFILE_ALLOC, "ResAlloc")( 
-			resGUID, rawSize, resMgrHnd));
+		cacheResource(resource, loader->GetCategory(), reloadCost(resGUID, rawSize, decodeUs));
 	}
-	else
+
+	return resource;
+}
+
+bool ResourceManager::prepareRequest(ResourceRequest& request)
+{
+	const ResGUID& resGUID = request.guid;
+	request.loader = findLoader(resGUID);
+	if(!request.loader)
 	{
-		size = loader->GetLoadedResSize(rawBuf, rawSize);
-		resBuf = allocate(size);
-		if(!rawBuf || !resBuf)
+		L_ASSERT(request.loader && "No default resource loader found!");
+		return false;
+	}
+
+	TypedHandle<IResourceArchive> archive = findArchive(resGUID);
+	if(!archive.GetHandle())
+	{
+		LogW(String("Couldn't load archive ") + resGUID.ResArchiveName() + "!");
+		return false;
+	}
+	//The archive's directory never changes once it's open,
+	//so these lookups are safe while the I/O thread's reading.
+	request.archive = archive.Ptr();
+	request.rawSize = request.archive->GetRawSize(resGUID);
+	if(!request.rawSize)
+	{
+		return false;
+	}
+	request.needsUnpack = request.archive->NeedsUnpack(resGUID);
+	if(request.needsUnpack)
+	{
+		request.packedSize = request.archive->GetPackedSize(resGUID);
+		//mapped archives can be unpacked from where they are.
+		request.packedView = request.archive->GetPackedView(resGUID);
+		if(!request.packedView)
 		{
-			//out of memory again!
-			return std::shared_ptr<StreamingResource>();
+			request.packedBuf = CustomArrayNew<char>(request.packedSize, RESFILE_ALLOC, "TempBufAlloc");
 		}
-		stream = GetSharedPtr(CustomNew<StreamingResource>(RESFILE_ALLOC, "ResAlloc", 
-			resGUID, resBuf, size, resMgrHnd));
-		bool resLoaded = loader->LoadStreamResource(rawBuf, rawSize, stream);
-		CustomArrayDelete(rawBuf);
+	}
+	//Like openResource(), the raw buffer's only part of the cache
+	//if the loader uses raw data.
+	request.rawBuf =	request.loader->UseRawResource() ?
+						allocate(request.rawSize, request.loader->GetCategory()) :
+						CustomArrayNew<char>(request.rawSize, RESFILE_ALLOC, "TempBufAlloc");
+	return request.rawBuf != NULL;
+}
 
-		if(!resLoaded)
+void ResourceManager::completeRequest(const ResRequestPtr& request)
+{
+	pendingRequests.erase(ResKey(request->guid));
+	ResPtr resource;
+	if(request->resource && request->uncounted)
+	{
+		//Loaded on a decode thread, so the cache doesn't know about it yet.
+		//Count it even if there's no room, since freeing it will uncount it.
+		FileSz size = request->resource->Size();
+		bool hasRoom = makeRoom(size, request->loader->GetCategory());
+		cacheUsed += size;
+		request->uncounted = false;
+		if(hasRoom && request->succeeded)
 		{
-			//something went wrong with the load
-			return std::shared_ptr<StreamingResource>();
+			resource = ResPtr(request->resource);
+		}
+	}
+	else if(request->succeeded && request->rawBuf)
+	{
+		//Loaders that need the main thread run here.
+		DecodeClock::time_point decodeStart = DecodeClock::now();
+		resource = buildResource(request->guid, request->loader, request->rawBuf, request->rawSize);
+		request->decodeUs += microsecondsSince(decodeStart);
+		request->rawBuf = NULL;
+	}
+	//If the raw buffer's still around, the load failed before using it.
+	if(request->rawBuf)
+	{
+		CustomArrayDelete(request->rawBuf);
+		request->rawBuf = NULL;
+		if(request->loader->UseRawResource())
+		{
+			ReportMemoryFreed(request->rawSize);
 		}
 	}
+	CustomArrayDelete(request->packedBuf);
+	request->packedBuf = NULL;
 
-	//now insert the stream into the res collections
-	if(stream)
+	if(resource)
+	{
+		//It might've been loaded synchronously while the request was in flight;
+		//keep the cached copy in that case.
+		ResMap::iterator resIt = resMap.find(ResKey(request->guid));
+		if(resIt != resMap.end())
+		{
+			resource = resIt->second.Res;
+			update(resIt->second);
+		}
+		else
+		{
+			cacheResource(	resource, request->loader->GetCategory(),
+							reloadCost(request->guid, request->rawSize, request->decodeUs));
+		}
+	}
+	request->resource = SharedResHandle(resource);
+	request->state = resource ? ResourceRequest::DONE : ResourceRequest::FAILED;
+	if(!resource)
+	{
+		LogW(String("Async load of ") + request->guid.Name + " failed!");
+	}
+
+	for(U32 i = 0; i < request->callbacks.size(); ++i)
+	{
+		request->callbacks[i].first(resource, request->callbacks[i].second);
+	}
+	request->callbacks.clear();
+}
+
+std::shared_ptr<StreamingResource> ResourceManager::loadStream(const ResGUID& resGUID)
+{
+	TypedHandle<IResourceArchive> archive = findArchive(resGUID);
+	if(!archive.GetHandle())
+	{
+		LogW(String("Couldn't load archive ") + resGUID.ResArchiveName() + "!");
+		return std::shared_ptr<StreamingResource>();
+	}
+	//Streams read the archive through their own mapping or file handle,
+	//so they don't need the archive lock.
+	ZipStream* zipStream = archive->OpenStream(resGUID);
+	if(!zipStream)
 	{
-		streamMap[resGUID.Name] = stream;
+		LogW(String("Couldn't stream ") + resGUID.Name + "!");
+		return std::shared_ptr<StreamingResource>();
 	}
+	//Streams don't go through a loader;
+	//whatever reads the stream decodes it as it goes.
+	std::shared_ptr<StreamingResource> stream = GetSharedPtr(CustomNew<StreamingResource>(RESFILE_ALLOC, "ResAlloc", 
+		resGUID, zipStream, archive->GetRawSize(resGUID), resMgrHnd));
 
+	//now insert the stream into the res collections
+	streamMap[resGUID.Name] = stream;
 	return stream;
 }
 
-void ResourceManager::release(std::shared_ptr<Resource> res)
+void ResourceManager::release(const ResPtr& res)
 {
 	//remove the resource from the LRU and the map.
-	lruList.remove(res);
-	resMap.erase(res->GUID().Name);
+	ResMap::iterator resIt = resMap.find(ResKey(res->GUID()));
+	if(resIt != resMap.end())
+	{
+		removeEntry(resIt->second);
+	}
 }
 
 bool ResourceManager::Init(FileSz cacheSizeMb)
@@ -305,6 +612,7 @@ bool ResourceManager::Init(FileSz cacheSizeMb)
 	//add default loaders to the manager.
 	loaderList.push_front(GetSharedPtr(CustomNew<DefaultResourceLoader>(RESLOADER_ALLOC, "ResLoaderAlloc")));
 	loaderList.push_front(GetSharedPtr(CustomNew<ModelLoader>(RESLOADER_ALLOC, "ResLoaderAlloc")));
+	loaderList.push_front(GetSharedPtr(CustomNew<TextureLoader>(RESLOADER_ALLOC, "ResLoaderAlloc")));
 
 	resMgrHnd = HandleMgr::RegisterPtr(this);
 	if(!resMgrHnd.GetHandle())
@@ -318,20 +626,25 @@ bool ResourceManager::Init(FileSz cacheSizeMb)
 
 void ResourceManager::Shutdown()
 {
-	//free all the resources
-	while(!lruList.empty())
-	{
-		freeOneResource();
-	}
+	//stop loading first; the loader threads use the archives.
+	asyncLoader.Stop();
+	UpdateAsyncLoads();
+	//free all the resources; any still referenced elsewhere
+	//are freed when their last handle goes.
+	clearCache();
+	evictedMap.clear();
+	evictedList.clear();
 	//unregister all loaders
 	while(!loaderList.empty())
 	{
 		loaderList.pop_front();
 	}
+	//streams can point into the archives' mappings.
+	streamMap.clear();
 	//close all our archives!
 	for(ArchiveMap::iterator it = archiveMap.begin(); it != archiveMap.end(); ++it)
 	{
-		HandleMgr::DeleteHandle(it->second);
+		HandleMgr::DeleteHandle(it->second.Archive);
 	}
 }
 
@@ -342,42 +655,156 @@ void ResourceManager::RegisterLoader(std::shared_ptr<IResourceLoader> loader)
 
 bool ResourceManager::OpenArchive(const ResGUID& guid)
 {
-	Path archPath = String(Filesystem::GetProgDir()) + guid.ResArchiveName();
+	String archName = guid.ResArchiveName();
 	//check the archive's not already loaded
-	String convertedName = ToLower(guid.ResArchiveName());
-	//try to open the arch,
-	//add it to the map if successful
-	if(archiveMap.count(convertedName) < 1)
+	ArchiveMap::iterator it = archiveMap.find(guid.ArchiveID());
+	if(it != archiveMap.end())
 	{
-		TypedHandle<IResourceArchive> resArch = HandleMgr::RegisterPtr(CustomNew<ZipResArchive>(RESFILE_ALLOC, "ResArchiveAlloc", archPath)).GetHandle();
-		if(!resArch->Open())
+		if(!isArchiveNamed(it->second.Name, guid))
 		{
+			LogE(String("Can't open ") + archName + "; its ID is already used by " + it->second.Name + "!");
 			return false;
 		}
-		archiveMap[convertedName] = resArch;
+		LogV(archName + " is already loaded!");
 		return true;
 	}
-	LogV(String(convertedName) + " is already loaded!");
+	//try to open the arch,
+	//add it to the map if successful
+	Path archPath = String(Filesystem::GetProgDir()) + archName;
+	//pick the backend by extension; anything that isn't a pack is assumed to be a ZIP.
+	IResourceArchive* newArch = NULL;
+	if(ToLower(archPath.GetExtension()) == PackFile::EXTENSION)
+	{
+		newArch = CustomNew<PackResArchive>(RESFILE_ALLOC, "ResArchiveAlloc", archPath);
+	}
+	else
+	{
+		newArch = CustomNew<ZipResArchive>(RESFILE_ALLOC, "ResArchiveAlloc", archPath);
+	}
+	TypedHandle<IResourceArchive> resArch = HandleMgr::RegisterPtr(newArch).GetHandle();
+	if(!resArch->Open())
+	{
+		return false;
+	}
+	ArchiveEntry& entry = archiveMap[guid.ArchiveID()];
+	entry.Name = archName;
+	entry.Archive = resArch;
 	return true;
 }
 
-std::shared_ptr<Resource> ResourceManager::GetResource(const ResGUID& guid)
+TypedHandle<IResourceArchive> ResourceManager::findArchive(const ResGUID& guid)
+{
+	ArchiveMap::iterator it = archiveMap.find(guid.ArchiveID());
+	if(it != archiveMap.end())
+	{
+		//an ID collision just fails here, rather than using the wrong archive.
+		return isArchiveNamed(it->second.Name, guid) ? it->second.Archive : TypedHandle<IResourceArchive>();
+	}
+	if(!OpenArchive(guid))
+	{
+		return TypedHandle<IResourceArchive>();
+	}
+	return archiveMap[guid.ArchiveID()].Archive;
+}
+
+ResPtr ResourceManager::GetResource(const ResGUID& guid)
 {
 	if(guid.Empty())
 	{
-		return NULL;
+		return ResPtr();
 	}
 	//get the resource if it's already loaded,
 	//otherwise load from disk
-	ResMap::iterator resIt = resMap.find(guid.Name);
+	ResMap::iterator resIt = resMap.find(ResKey(guid));
 	if(resIt != resMap.end())
 	{
+		ResCacheStats::ReportHit();
 		update(resIt->second);
-		return resIt->second;
+		return resIt->second.Res;
 	}
+	ResCacheStats::ReportMiss();
 	return load(guid);
 }
 
+ResRequestPtr ResourceManager::GetResourceAsync(const ResGUID& guid, I32 priority, ResLoadedCallback callback, void* userData)
+{
+	//join the existing request if there is one
+	RequestMap::iterator reqIt = pendingRequests.find(ResKey(guid));
+	if(reqIt != pendingRequests.end())
+	{
+		reqIt->second->AddCallback(callback, userData);
+		return reqIt->second;
+	}
+
+	ResRequestPtr request = GetSharedPtr(CustomNew<ResourceRequest>(RESFILE_ALLOC, "ResRequestAlloc", guid, priority));
+	request->AddCallback(callback, userData);
+	//Cache hits and resources outside of archives are loaded now;
+	//they still finish in UpdateAsyncLoads(), like everything else.
+	ResMap::iterator resIt = resMap.find(ResKey(guid));
+	if(guid.Empty() || resIt != resMap.end() || guid.ResArchiveName().empty())
+	{
+		request->resource = SharedResHandle(GetResource(guid));
+		request->succeeded = (bool)request->resource;
+		readyRequests.push_back(request);
+		return request;
+	}
+	//So are resources that can be used straight from a mapped archive.
+	ResCacheStats::ReportMiss();
+	std::shared_ptr<IResourceLoader> loader = findLoader(guid);
+	ResPtr mapped = mapResource(guid, loader);
+	if(mapped)
+	{
+		cacheResource(mapped, loader->GetCategory());
+		request->resource = SharedResHandle(mapped);
+		request->succeeded = true;
+		readyRequests.push_back(request);
+		return request;
+	}
+
+	if(!prepareRequest(*request))
+	{
+		request->succeeded = false;
+		readyRequests.push_back(request);
+		return request;
+	}
+	if(!asyncLoader.IsRunning())
+	{
+		asyncLoader.Start(resMgrHnd, &archiveMutex, numDecodeThreads);
+	}
+	//keyed by the request's copy of the GUID, which lives as long as the entry.
+	pendingRequests[ResKey(request->guid)] = request;
+	asyncLoader.Enqueue(request);
+	return request;
+}
+
+U32 ResourceManager::UpdateAsyncLoads(U32 maxRequests)
+{
+	U32 numFinished = 0;
+	//ready requests are cheap, so they don't count towards the limit.
+	while(!readyRequests.empty())
+	{
+		ResRequestPtr request = readyRequests.front();
+		readyRequests.pop_front();
+		ResPtr resource(request->resource);
+		request->state = resource ? ResourceRequest::DONE : ResourceRequest::FAILED;
+		for(U32 i = 0; i < request->callbacks.size(); ++i)
+		{
+			request->callbacks[i].first(resource, request->callbacks[i].second);
+		}
+		request->callbacks.clear();
+		++numFinished;
+	}
+
+	List<ResRequestPtr> finished;
+	asyncLoader.TakeFinished(finished, maxRequests);
+	for(List<ResRequestPtr>::iterator it = finished.begin(); it != finished.end(); ++it)
+	{
+		completeRequest(*it);
+		++numFinished;
+	}
+	return numFinished;
+}
+
 std::shared_ptr<StreamingResource> ResourceManager::GetStreamingResource(const ResGUID& guid)
 {
 	if(guid.Empty())
@@ -397,32 +824,102 @@ std::shared_ptr<StreamingResource> ResourceManager::GetStreamingResource(const R
 
 //GetStreamingResource?
 
-//Preload
-
-//Flush
-
-//EditorResManager
-TypedHandle<IResourceArchive> EditorResManager::findArchive(const ResGUID& archGUID)
+I32 ResourceManager::Preload(const String pattern, void(*progressCallback)(I32, bool&))
 {
-	//check the archive's not already loaded
-	String convertedName = ToLower(archGUID.ResArchiveName());
-	ArchiveMap::iterator it = archiveMap.find(convertedName);
-	TypedHandle<IResourceArchive> archHandle;
-	if(it == archiveMap.end())
+	ResGUID patternGUID(pattern.c_str());
+	String archName = patternGUID.ResArchiveName();
+	TypedHandle<IResourceArchive> archive;
+	if(archName.empty() || !(archive = findArchive(patternGUID)).GetHandle())
+	{
+		LogW(String("Couldn't open archive for preload pattern ") + pattern + "!");
+		return 0;
+	}
+
+	//Find all the matches first, so progress is a fraction of the whole preload.
+	//GUIDs lowercase resource names, so match against lowercase names.
+	String resPattern = ToLower(String(patternGUID.ResName()));
+	Vector<ResGUID> matches;
+	for(U32 i = 0; i < archive->GetNumResources(); ++i)
 	{
-		if(!OpenArchive(archGUID))
+		String resName = ToLower(archive->GetResourceName(i));
+		if(StringUtils::WildcardMatch(resName.c_str(), resPattern.c_str()))
 		{
-			return 0;
+			matches.push_back(ResGUID(archName, resName));
 		}
-		archHandle = archiveMap[convertedName];
 	}
-	else
+	if(matches.empty())
+	{
+		return 0;
+	}
+
+	//Requests go through the async loader, so the reads and decompression
+	//are spread across its threads, each inflating into its own destination buffer.
+	//Only so many bytes are allowed in flight, so a big preload can't flood memory with buffers.
+	typedef Pair<ResRequestPtr, FileSz> InFlightRequest;
+	List<InFlightRequest> inFlight;
+	FileSz bytesInFlight = 0;
+	U32 nextMatch = 0;
+	U32 numFinished = 0;
+	I32 numLoaded = 0;
+	I32 lastProgress = -1;
+	bool cancel = false;
+	while(nextMatch < matches.size() || !inFlight.empty())
 	{
-		archHandle = it->second;
+		while(!cancel && nextMatch < matches.size())
+		{
+			const ResGUID& guid = matches[nextMatch];
+			FileSz cost = archive->GetRawSize(guid);
+			if(archive->NeedsUnpack(guid))
+			{
+				cost += archive->GetPackedSize(guid);
+			}
+			if(!inFlight.empty() && bytesInFlight + cost > preloadMaxInFlight)
+			{
+				break;
+			}
+			inFlight.push_back(InFlightRequest(GetResourceAsync(guid), cost));
+			bytesInFlight += cost;
+			++nextMatch;
+		}
+		if(cancel && nextMatch < matches.size())
+		{
+			//never started, so they count as finished.
+			numFinished += matches.size() - nextMatch;
+			nextMatch = matches.size();
+		}
+
+		//Wait for something to finish, unless something already has.
+		if(UpdateAsyncLoads() == 0 && NumPendingLoads() > 0)
+		{
+			asyncLoader.WaitForFinished();
+			UpdateAsyncLoads();
+		}
+		for(List<InFlightRequest>::iterator it = inFlight.begin(); it != inFlight.end();)
+		{
+			if(!it->first->IsFinished())
+			{
+				++it;
+				continue;
+			}
+			numLoaded += it->first->Succeeded() ? 1 : 0;
+			bytesInFlight -= it->second;
+			++numFinished;
+			it = inFlight.erase(it);
+		}
+
+		I32 progress = (I32)((numFinished * 100) / matches.size());
+		if(progressCallback && progress != lastProgress)
+		{
+			progressCallback(progress, cancel);
+			lastProgress = progress;
+		}
 	}
-	return archHandle;
+	return numLoaded;
 }
 
+//Flush
+
+//EditorResManager
 U32 EditorResManager::GetNumResourcesInArchive(const ResGUID& archGUID)
 {
 	TypedHandle<IResourceArchive> archHandle = findArchive(archGUID);
@@ -454,16 +951,17 @@ ResPtr EditorResManager::GetResourceFromIndex(const ResGUID& archGUID, U32 resIn
 //DebugResManager
 bool DebugResManager::openResource(const ResGUID& resGUID, char** outRawBuf, FileSz* outRawSize, bool useRawResource)
 {
-	String archName = ToLower(resGUID.ResArchiveName());
 	//Check the resource name.
 	//If it indicates to use the filesystem, then use the filesystem!
-	bool useFS = archName.empty();
+	bool useFS = resGUID.ArchiveNameLen() == 0;
 	String filePath = Filesystem::GetProgDir() + String(resGUID.ResName());
-	if(!useFS && archiveMap.count(archName) < 1)
+	TypedHandle<IResourceArchive> archive;
+	if(!useFS)
 	{
-		if(!OpenArchive(resGUID))
+		archive = findArchive(resGUID);
+		if(!archive.GetHandle())
 		{
-			LogW(String("Couldn't load archive ") + archName + "!");
+			LogW(String("Couldn't load archive ") + resGUID.ResArchiveName() + "!");
 			*outRawBuf = NULL;
 			*outRawSize = 0;
 			return false;
@@ -472,7 +970,6 @@ bool DebugResManager::openResource(const ResGUID& resGUID, char** outRawBuf, Fil
 
 	//now try to allocate a raw data buffer
 	//it's temporary if the loader indicates to not use raw data
-	TypedHandle<IResourceArchive> archive = useFS ? 0 : archiveMap[archName];
 	U32 rawSize = useFS ? Filesystem::GetFileSize(filePath) : archive->GetRawSize(resGUID);
 	*outRawSize = rawSize;
 	if(!rawSize)
@@ -481,8 +978,14 @@ bool DebugResManager::openResource(const ResGUID& resGUID, char** outRawBuf, Fil
 		return false;
 	}
 	*outRawBuf =	useRawResource ? 
-					allocate(rawSize) : 
+					allocate(rawSize, categoryOf(resGUID)) : 
 					CustomArrayNew<char>(rawSize, RESFILE_ALLOC, "TempBufAlloc");
+	if(!*outRawBuf)
+	{
+		LogW(String("Couldn't make room in the cache for ") + resGUID.ResName() + "!");
+		*outRawSize = 0;
+		return false;
+	}
 	if(useFS)
 	{
 		auto file = Filesystem::OpenFileReadOnly(filePath);
@@ -493,12 +996,13 @@ bool DebugResManager::openResource(const ResGUID& resGUID, char** outRawBuf, Fil
 	}
 	else
 	{
+		Lock archiveLock(archiveMutex);
 		archive->GetRawResource(resGUID, *outRawBuf);
 	}
 	return true;
 }
 
-std::shared_ptr<Resource> DebugResManager::OpenResFromFile(const Path& path)
+ResPtr DebugResManager::OpenResFromFile(const Path& path)
 {
 	return GetResource(ResGUID("",path.ToString()));
 }
\ No newline at end of file
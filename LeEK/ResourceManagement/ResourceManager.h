@@ -1,54 +1,168 @@
 #pragma once
 #include "Resource.h"
+#include "ResHandle.h"
 #include "IResourceLoader.h"
 #include "IResourceArchive.h"
+#include "AsyncResourceLoader.h"
 #include "DataStructures/STLContainers.h"
+#include "DataStructures/IntrusiveList.h"
 #include "FileManagement/path.h"
 
 namespace LeEK
 {
-	typedef std::shared_ptr<Resource> ResPtr;
-
 	class ResourceManager
 	{
 	protected:
-		typedef List<std::shared_ptr<Resource>> ResList;
-		typedef Map<String, std::shared_ptr<Resource>> ResMap;
+		//Key for the resource maps. Points at a GUID owned by the map's value
+		//(the resource or request), so keys don't copy the name,
+		//and mismatches almost never get past the hash.
+		struct ResKey
+		{
+			U32 Hash;
+			const char* Name;
+
+			ResKey(const ResGUID& guid) : Hash(guid.HashValue()), Name(guid.Name) {}
+			bool operator==(const ResKey& other) const { return Hash == other.Hash && strcmp(Name, other.Name) == 0; }
+		};
+		struct ResKeyHasher
+		{
+			size_t operator()(const ResKey& key) const { return key.Hash; }
+		};
+		//The map's nodes never move, so each entry can link itself into the LRU list;
+		//touching or evicting a resource is then constant time.
+		struct CacheEntry : public IntrusiveListNode
+		{
+			ResPtr Res;
+			ResCategory Category;
+			//bytes counted against the cache; 0 for mapped resources.
+			FileSz Size;
+			//estimated microseconds to load the resource again.
+			F32 ReloadCost;
+			//the frame the resource was last used in.
+			U32 LastUsedFrame;
+		};
+		typedef UnorderedMap<ResKey, CacheEntry, ResKeyHasher> ResMap;
 		typedef Map<String, std::shared_ptr<StreamingResource>> StreamResMap;
-		typedef Map<String, TypedHandle<IResourceArchive>> ArchiveMap;
+		//Open archives are keyed by ResGUID::ArchiveID(),
+		//so finding a resource's archive doesn't build any strings.
+		//The name's kept to catch two archives with the same ID.
+		struct ArchiveEntry
+		{
+			String Name;
+			TypedHandle<IResourceArchive> Archive;
+		};
+		typedef UnorderedMap<U32, ArchiveEntry> ArchiveMap;
 		typedef List<std::shared_ptr<IResourceLoader>> ResLoaderList;
+		typedef UnorderedMap<ResKey, ResRequestPtr, ResKeyHasher> RequestMap;
+		//Recently evicted GUIDs, newest first; the map's keys point into the list's nodes.
+		typedef List<ResGUID> EvictedList;
+		typedef UnorderedMap<ResKey, EvictedList::iterator, ResKeyHasher> EvictedMap;
+
+		//How many of the least recently used resources are weighed against each other
+		//when picking one to evict.
+		static const U32 EVICTION_WINDOW = 8;
+		//Assumed read speed, for estimating reload costs. About 50 MB/s.
+		static const U32 READ_BYTES_PER_US = 50;
+		//How many evicted GUIDs are remembered to spot reloads;
+		//reloads of resources evicted longer ago aren't counted.
+		static const U32 MAX_EVICTED_GUIDS = 1024;
 
-		//Least Recently Used list.
+		//Least Recently Used list of the entries in resMap.
 		//Stuff in front's most used, stuff in back least.
-		ResList lruList;
+		IntrusiveList lruList;
 		ResMap resMap;
 		StreamResMap streamMap;
 		ArchiveMap archiveMap;
 		ResLoaderList loaderList;
 
+		//Async loading state.
+		AsyncResourceLoader asyncLoader;
+		//held while reading from any archive,
+		//since the I/O thread reads from them too.
+		Mutex archiveMutex;
+		//requests that are being loaded, by GUID.
+		RequestMap pendingRequests;
+		//requests that finished as soon as they were made (cache hits, failures);
+		//they're kept until UpdateAsyncLoads() so callbacks always run from there.
+		List<ResRequestPtr> readyRequests;
+		U32 numDecodeThreads;
+		//most bytes of packed and raw data Preload() keeps in flight at once.
+		FileSz preloadMaxInFlight;
+
 		//both measured in bytes
 		FileSz cacheMax;
 		FileSz cacheUsed;
+		//Per category limits and usage, in bytes. A limit of 0 means there's none.
+		//Usage only counts cached resources, not buffers that are still being loaded.
+		FileSz categoryMax[RESCAT_LEN];
+		FileSz categoryUsed[RESCAT_LEN];
+		//0 until BeginFrame() is first called, which turns on per frame pinning.
+		U32 frameNum;
+		//the most recently evicted resources, to spot reloads.
+		EvictedList evictedList;
+		EvictedMap evictedMap;
 
 		//Returns true if enough room has been freed, false otherwise
-		bool makeRoom(FileSz size);
+		bool makeRoom(FileSz size, ResCategory category);
 		//Attempts to create a buffer of the desired size for the cache.
-		char* allocate(FileSz size);
-		void freeOneResource();
+		char* allocate(FileSz size, ResCategory category = OTHER_RES);
+		//Evicts a resource of the given category, or of any category if it's RESCAT_LEN,
+		//that isn't referenced outside the cache. Resources used this frame are only evicted
+		//to keep their own category within its budget, or when nothing else can be.
+		//Returns false if nothing could be evicted.
+		bool freeOneResource(ResCategory category);
+		//Of the few least recently used resources that could be evicted,
+		//finds the one that's cheapest to reload per byte freed.
+		//If keepFrame's set, stops at the first resource used this frame.
+		//Returns NULL if there's no candidate.
+		CacheEntry* pickVictim(ResCategory category, bool keepFrame);
+		//Takes a resource out of the cache.
+		void removeEntry(CacheEntry& entry);
+		//Remembers that a resource was evicted, forgetting the oldest eviction if there's too many.
+		void rememberEviction(const ResGUID& resGUID);
+		//Returns true if the resource was recently evicted, and forgets the eviction.
+		bool forgetEviction(const ResGUID& resGUID);
+		//Drops everything from the cache, in use or not.
+		void clearCache();
+		//Gets the category of the loader that matches the GUID.
+		ResCategory categoryOf(const ResGUID& resGUID);
+		//Estimates how long it'd take to load a resource again,
+		//from its packed size and the time spent decoding it.
+		//Virtual so managers that don't read from archives can estimate it themselves.
+		virtual F32 reloadCost(const ResGUID& resGUID, FileSz rawSize, F32 decodeUs);
+
+		//Gets the GUID's archive, opening it if it's not open already.
+		//Returns a null handle if the archive couldn't be opened.
+		TypedHandle<IResourceArchive> findArchive(const ResGUID& guid);
 
 		//Resource managing methods:
 		//Gets the resource corresponding to the GUID, if possible.
-		std::shared_ptr<Resource> find(ResGUID* resGUID);
+		ResPtr find(ResGUID* resGUID);
 		//Notifies the manager that a resource has been used.
-		const void* update(std::shared_ptr<Resource> res);
+		void update(CacheEntry& entry);
 		//Actually loads resource data into memory.
 		//Returns true if succesful, false otherwise.
 		virtual bool openResource(const ResGUID& resGUID, char** outRawBuf, FileSz* outRawSize, bool useRawResource);
+		//Finds the loader matching the resource, if any.
+		std::shared_ptr<IResourceLoader> findLoader(const ResGUID& resGUID);
+		//Turns raw resource data into a resource, using the given loader.
+		//Takes ownership of rawBuf.
+		ResPtr buildResource(const ResGUID& resGUID, std::shared_ptr<IResourceLoader> loader, char* rawBuf, FileSz rawSize);
+		//If the resource is stored as-is in a mapped archive, makes a resource that uses the archive's copy directly:
+		//the copy itself for loaders that use raw data, or whatever the loader builds around it.
+		//Otherwise returns an empty pointer.
+		ResPtr mapResource(const ResGUID& resGUID, std::shared_ptr<IResourceLoader> loader);
+		//Adds a resource to the front of the LRU.
+		void cacheResource(const ResPtr& res, ResCategory category = OTHER_RES, F32 reloadCostUs = 0);
 		//Loads a resource into memory.
-		std::shared_ptr<Resource> load(const ResGUID& resGUID);
+		ResPtr load(const ResGUID& resGUID);
+		//Finds the request's archive and loader, and allocates its buffers.
+		bool prepareRequest(ResourceRequest& request);
+		//Finishes a request on the main thread, and runs its callbacks.
+		void completeRequest(const ResRequestPtr& request);
 		std::shared_ptr<StreamingResource> loadStream(const ResGUID& resGUID);
 		//Removes a resource from the manager.
-		void release(std::shared_ptr<Resource> res);
+		void release(const ResPtr& res);
 
 	public:
 		ResourceManager();
@@ -59,20 +173,87 @@ namespace LeEK
 		void Shutdown();
 		void RegisterLoader(std::shared_ptr<IResourceLoader> loader);
 
+		/**
+		Opens the GUID's archive, if it's not open already.
+		Archives ending in PackFile::EXTENSION are opened as packs, anything else as a ZIP.
+		*/
 		bool OpenArchive(const ResGUID& guid);
-		std::shared_ptr<Resource> GetResource(const ResGUID& guid);
+		ResPtr GetResource(const ResGUID& guid);
+		/**
+		Starts loading a resource in the background.
+		Reading happens on an I/O thread and decoding on a pool of worker threads;
+		the result's put in the cache, and callbacks are run, during UpdateAsyncLoads().
+		Resources that aren't in an archive are loaded immediately.
+		@param priority higher priorities are read and decoded first.
+		@param callback optional function to call when the load finishes.
+		@return a request that can be polled for the resource.
+		Requesting a resource that's already loading returns the existing request.
+		*/
+		ResRequestPtr GetResourceAsync(const ResGUID& guid, I32 priority = 0, ResLoadedCallback callback = NULL, void* userData = NULL);
+		/**
+		Finishes any asynchronous loads that are ready. Call once a frame on the main thread.
+		@param maxRequests the most requests to finish; 0 finishes all of them.
+		Limiting this spreads loads that must be finished on the main thread across frames.
+		@return the number of requests finished.
+		*/
+		U32 UpdateAsyncLoads(U32 maxRequests = 0);
+		/**
+		Gets the number of asynchronous loads that haven't finished.
+		*/
+		U32 NumPendingLoads() const { return pendingRequests.size(); }
+		/**
+		Sets the size of the decode thread pool.
+		Only takes effect if no asynchronous loads have been made yet.
+		0 uses all hardware threads except those taken by the main and I/O threads.
+		*/
+		void SetNumDecodeThreads(U32 val) { numDecodeThreads = val; }
+		/**
+		Opens a resource for reading a piece at a time, straight from its archive.
+		The archive's read ahead on a background thread as the stream's consumed.
+		Streams aren't counted against the cache, and don't go through a loader.
+		@return an empty pointer if the resource's archive can't stream it.
+		*/
 		std::shared_ptr<StreamingResource> GetStreamingResource(const ResGUID& guid);
 		void ReportMemoryFreed(FileSz sizeFreed);
-		//no support for streaming yet
+		/**
+		Loads every resource in an archive that matches the pattern into the cache,
+		reading and decoding them on the async loader's threads, and blocks until they're done.
+		No support for streaming yet.
+		@param pattern a GUID whose resource part may have wildcards,
+		like "Textures.zip:*.png". The archive's opened if it isn't already.
+		@param progressCallback optional; called with the percentage of matches finished.
+		Setting its bool to true cancels the preload, though loads already started still finish.
+		@return the number of resources loaded.
+		*/
 		I32 Preload(const String pattern, void(*progressCallback)(I32, bool&));
+		/**
+		Sets the most bytes Preload() may have read but not yet cached at once.
+		Counts both packed and raw data; a single resource larger than this is still loaded alone.
+		*/
+		void SetPreloadMaxInFlight(FileSz bytes) { preloadMaxInFlight = bytes; }
+		/**
+		Sets the most bytes resources of a category may take up in the cache.
+		0, the default, leaves the category limited only by the cache's total size.
+		Resources in the category are evicted first to stay under the budget,
+		even ones used this frame; if they're all referenced outside the cache,
+		the category's allowed over it.
+		*/
+		void SetCategoryBudget(ResCategory category, FileSz bytes);
+		FileSz CategoryBudget(ResCategory category) const { return categoryMax[category]; }
+		FileSz CategoryUsed(ResCategory category) const { return categoryUsed[category]; }
+		/**
+		Starts a new frame. Call once a frame on the main thread.
+		Resources used during a frame aren't evicted until the next one,
+		so the frame's working set can't push itself out of the cache.
+		Until this is first called, nothing's pinned by frame.
+		*/
+		void BeginFrame() { ++frameNum; }
 		//got no idea what this does!
 		void Flush(void);
 	};
 
 	class EditorResManager : public ResourceManager
 	{
-	protected:
-		TypedHandle<IResourceArchive> findArchive(const ResGUID& archGUID);
 	public:
 		U32 GetNumResourcesInArchive(const ResGUID& archGUID);
 		ResGUID GetResGUID(const ResGUID& archGUID, U32 resIndex);
@@ -84,6 +265,6 @@ namespace LeEK
 	protected:
 		bool openResource(const ResGUID& resGUID, char** outRawBuf, FileSz* outRawSize, bool useRawResource);
 	public:
-		std::shared_ptr<Resource> OpenResFromFile(const Path& path);
+		ResPtr OpenResFromFile(const Path& path);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "ResCacheStats.h"
+#include "DebugUtils/Assertions.h"
+#include "Logging/Log.h"
+#include "FileManagement/Filesystem.h"
+using namespace LeEK;
+
+namespace
+{
+	struct CategoryStats
+	{
+		U64 Evictions;
+		U64 BytesEvicted;
+		U64 Reloads;
+		U64 BytesReloaded;
+		FileSz Used;
+		FileSz Budget;
+	};
+
+	U64 numHits = 0;
+	U64 numMisses = 0;
+	CategoryStats catStats[RESCAT_LEN];
+
+	IStatDisplayer* resCacheDisp = NULL;
+
+	const U32 BUF_SIZE = 512;
+	char lineBuf[BUF_SIZE];
+
+	F64 toKB(U64 bytes) { return ((F64)bytes) / 1024; }
+}
+
+void ResCacheStats::ReportHit() { ++numHits; }
+void ResCacheStats::ReportMiss() { ++numMisses; }
+void ResCacheStats::ReportEviction(ResCategory category, FileSz size)
+{
+	catStats[category].Evictions++;
+	catStats[category].BytesEvicted += size;
+}
+void ResCacheStats::ReportReload(ResCategory category, FileSz size)
+{
+	catStats[category].Reloads++;
+	catStats[category].BytesReloaded += size;
+}
+void ResCacheStats::ReportUsage(ResCategory category, FileSz used, FileSz budget)
+{
+	catStats[category].Used = used;
+	catStats[category].Budget = budget;
+}
+void ResCacheStats::Reset()
+{
+	numHits = 0;
+	numMisses = 0;
+	for(U32 i = 0; i < RESCAT_LEN; ++i)
+	{
+		catStats[i].Evictions = 0;
+		catStats[i].BytesEvicted = 0;
+		catStats[i].Reloads = 0;
+		catStats[i].BytesReloaded = 0;
+	}
+}
+
+U64 ResCacheStats::NumHits() { return numHits; }
+U64 ResCacheStats::NumMisses() { return numMisses; }
+F64 ResCacheStats::HitRate()
+{
+	U64 lookups = numHits + numMisses;
+	return lookups ? ((F64)numHits) / lookups : 0;
+}
+U64 ResCacheStats::NumEvictions()
+{
+	U64 result = 0;
+	for(U32 i = 0; i < RESCAT_LEN; ++i)
+	{
+		result += catStats[i].Evictions;
+	}
+	return result;
+}
+U64 ResCacheStats::BytesReloaded()
+{
+	U64 result = 0;
+	for(U32 i = 0; i < RESCAT_LEN; ++i)
+	{
+		result += catStats[i].BytesReloaded;
+	}
+	return result;
+}
+
+//stat displaying funcs
+void ResCacheStats::SetStatDisplayer(IStatDisplayer* displayer)
+{
+	if(displayer)
+	{
+		resCacheDisp = displayer;
+	}
+}
+void ResCacheStats::WriteStats()
+{
+	L_ASSERT(resCacheDisp && "No output callback set");
+	sprintf_s(	lineBuf, BUF_SIZE, "Resource Cache: %.1f%% hits (%llu/%llu), %llu evicted, %.3f kB reloaded",
+				HitRate() * 100, (unsigned long long)numHits, (unsigned long long)(numHits + numMisses),
+				(unsigned long long)NumEvictions(), toKB(BytesReloaded()));
+	resCacheDisp->WriteStatLn(lineBuf);
+	resCacheDisp->WriteStatLn("Category\t| Used(kB)\t| Budget(kB)\t| Evicted(kB)\t| Reloaded(kB)");
+	for(U32 i = 0; i < RESCAT_LEN; ++i)
+	{
+		const CategoryStats& cat = catStats[i];
+		sprintf_s(	lineBuf, BUF_SIZE, "%s\t| %.3f\t| %.3f\t| %.3f\t| %.3f",
+					ResCategoryName((ResCategory)i), toKB(cat.Used), toKB(cat.Budget), toKB(cat.BytesEvicted), toKB(cat.BytesReloaded));
+		resCacheDisp->WriteStatLn(lineBuf);
+	}
+}
+void ResCacheStats::WriteCSV(DataStream* file)
+{
+	file->WriteLine("Cache Hits,Cache Misses,Hit Rate");
+	sprintf_s(	lineBuf, BUF_SIZE, "%llu,%llu,%.3f",
+				(unsigned long long)numHits, (unsigned long long)numMisses, HitRate());
+	file->WriteLine(lineBuf);
+	file->WriteLine("Category,Used(kB),Budget(kB),Evictions,Evicted(kB),Reloads,Reloaded(kB)");
+	for(U32 i = 0; i < RESCAT_LEN; ++i)
+	{
+		const CategoryStats& cat = catStats[i];
+		sprintf_s(	lineBuf, BUF_SIZE, "%s,%.3f,%.3f,%llu,%.3f,%llu,%.3f",
+					ResCategoryName((ResCategory)i), toKB(cat.Used), toKB(cat.Budget),
+					(unsigned long long)cat.Evictions, toKB(cat.BytesEvicted),
+					(unsigned long long)cat.Reloads, toKB(cat.BytesReloaded));
+		file->WriteLine(lineBuf);
+	}
+}
+void ResCacheStats::DumpCSV(const Path& path)
+{
+	LogD("Dumping resource cache stats...");
+	//open up a file, of course
+	DataStream* logFile = Filesystem::OpenFile(path);
+	if(!logFile)
+	{
+		LogW("Couldn't open stats log file!");
+		return;
+	}
+	//try to append to any existing log
+	logFile->SeekToEnd();
+	if(logFile->FileSize() > 0)
+	{
+		logFile->WriteLine();
+	}
+	WriteCSV(logFile);
+	//we're done, remember to close the file
+	logFile->Close();
+	LogD("Dump complete.");
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Datatypes.h"
+#include "FileManagement/DataStream.h"
+#include "FileManagement/path.h"
+#include "ResourceManagement/Resource.h"
+#include "Stats/IStatDisplayer.h"
+
+namespace LeEK
+{
+	//functions to monitor how well the resource cache is doing.
+	namespace ResCacheStats
+	{
+		//Report a lookup that found the resource already cached
+		void ReportHit();
+		//Report a lookup that had to load the resource
+		void ReportMiss();
+		//Report a resource dropped from the cache to make room
+		void ReportEviction(ResCategory category, FileSz size);
+		//Report a load of a resource that had been evicted before
+		void ReportReload(ResCategory category, FileSz size);
+		//Report a category's current usage and budget. A budget of 0 means there's none.
+		void ReportUsage(ResCategory category, FileSz used, FileSz budget);
+		//Clears everything but the usage figures
+		void Reset();
+
+		U64 NumHits();
+		U64 NumMisses();
+		//Gets the fraction of lookups that hit, or 0 if there haven't been any
+		F64 HitRate();
+		U64 NumEvictions();
+		U64 BytesReloaded();
+
+		//stat displaying funcs
+		void SetStatDisplayer(IStatDisplayer* displayer);
+		void WriteStats();
+		void WriteCSV(DataStream* file);
+		void DumpCSV(const Path& path);
+	}
+}
@@ -4,6 +4,7 @@
 #include "FileManagement/IStrStream.h"
 #include "Time/DateTime.h"
 #include "AllocStats.h"
+#include "ResCacheStats.h"
 using namespace LeEK;
 
 StatMonitor::StatMonitor(void)
@@ -34,6 +35,7 @@ void StatMonitor::Startup()
 	ProfileSample::SetStatDisplayer(this);
 	OverheadStats::SetStatDisplayer(this);
 	AllocStats::SetStatDisplayer(this);
+	ResCacheStats::SetStatDisplayer(this);
 }
 
 void StatMonitor::PrintStats()
@@ -45,6 +47,7 @@ void StatMonitor::PrintStats()
 	ProfileSample::WriteStats();
 	OverheadStats::WriteStats();
 	AllocStats::WriteStats();
+	ResCacheStats::WriteStats();
 }
 
 void StatMonitor::Update(const GameTime& time)
@@ -89,6 +92,8 @@ void StatMonitor::DumpStatsCSV(const Path& path)
 	logFile->WriteLine("Overhead and Misc");
 	OverheadStats::WriteCSV(logFile);
 	AllocStats::WriteCSV(logFile);
+	logFile->WriteLine("Resource Cache");
+	ResCacheStats::WriteCSV(logFile);
 	//we're done, remember to close the file
 	logFile->Close();
 	LogD("Debug stat dump complete.");
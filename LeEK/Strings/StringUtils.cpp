@@ -62,4 +62,65 @@ bool StringUtils::WildcardMatch(const char* str, const char* wildcard)
 	}
 	//otherwise, we're at the end of both; report a match
 	return true;
+}
+
+U32 StringUtils::DecodeUTF8(const char*& pos, const char* end)
+{
+	const U8 lead = (U8)*pos;
+	//ASCII is by far the most common case
+	if(lead < 0x80)
+	{
+		++pos;
+		return lead;
+	}
+	U32 numCont = 0;
+	U32 codepoint = 0;
+	U32 minCodepoint = 0;
+	if((lead & 0xE0) == 0xC0)
+	{
+		numCont = 1;
+		codepoint = lead & 0x1F;
+		minCodepoint = 0x80;
+	}
+	else if((lead & 0xF0) == 0xE0)
+	{
+		numCont = 2;
+		codepoint = lead & 0x0F;
+		minCodepoint = 0x800;
+	}
+	else if((lead & 0xF8) == 0xF0)
+	{
+		numCont = 3;
+		codepoint = lead & 0x07;
+		minCodepoint = 0x10000;
+	}
+	else
+	{
+		//a stray continuation byte, or a lead byte that can't start a sequence
+		++pos;
+		return REPLACEMENT_CHAR;
+	}
+	if((U32)(end - pos) <= numCont)
+	{
+		++pos;
+		return REPLACEMENT_CHAR;
+	}
+	for(U32 i = 1; i <= numCont; ++i)
+	{
+		const U8 cont = (U8)pos[i];
+		if((cont & 0xC0) != 0x80)
+		{
+			++pos;
+			return REPLACEMENT_CHAR;
+		}
+		codepoint = (codepoint << 6) | (cont & 0x3F);
+	}
+	//overlong forms, surrogates and anything past the last plane aren't valid
+	if(codepoint < minCodepoint || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+	{
+		++pos;
+		return REPLACEMENT_CHAR;
+	}
+	pos += numCont + 1;
+	return codepoint;
 }
\ No newline at end of file
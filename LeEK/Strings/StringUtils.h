@@ -12,5 +12,14 @@ namespace LeEK
 		*/
 		bool WildcardMatch(const char* str, const char* wildcard);
 		//bool WildcardMatch(String str, char* wildcard) { return WildcardMatch(str.c_str(), wildcard); }
+
+		//Substituted for any malformed UTF-8 sequence.
+		const U32 REPLACEMENT_CHAR = 0xFFFD;
+		/**
+		Decodes the UTF-8 sequence at pos into a codepoint, and moves pos past it.
+		Malformed, overlong or truncated sequences decode to REPLACEMENT_CHAR and skip a single byte,
+		so decoding always moves forward. pos must be before end.
+		*/
+		U32 DecodeUTF8(const char*& pos, const char* end);
 	}
 }
\ No newline at end of file
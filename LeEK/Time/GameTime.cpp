@@ -10,15 +10,13 @@ using namespace LeEK;
 U32 GameTime::MAX_FPS = 50;
 U32 GameTime::MAX_FRAME_SKIPS = 0;
 
-#ifdef WIN32
-LARGE_INTEGER liStore; // storage variable used in Win32 implementation
-#endif
-
 GameTime::GameTime(void) : prevTime(0), currTime(0), totalGameTime(0), sleepTime(0), framesSkipped(0)
 {
 #ifdef WIN32
 	//if we're under Win32, initialize the CPU frequency
 	//if this somehow doesn't work, freak out
+	//(liStore's local so timers on different threads don't share it)
+	LARGE_INTEGER liStore;
 	bool result = QueryPerformanceFrequency(&liStore);
 	L_ASSERT(result && "Couldn't get CPU frequency!");
 	cpuFreq = double(liStore.QuadPart) / 1000.0;
@@ -46,6 +44,7 @@ void GameTime::Tick()
 {
 	prevTime = currTime;
 #ifdef WIN32
+	LARGE_INTEGER liStore;
 	QueryPerformanceCounter(&liStore);
 	currTime = liStore.QuadPart;
 #else
@@ -15,9 +15,14 @@ uniform sampler2D diffTex;
 void main(void)
 {
 
-	//get the mapped texel
-	vec4 texColor = texture(diffTex, vec2(texCoord.x, 1.0f - texCoord.y));
+	//get the distance to the glyph's edge;
+	//the atlas is a distance field, 0.5 on the edge and rising inside the glyph
+	float dist = texture(diffTex, vec2(texCoord.x, 1.0f - texCoord.y)).r;
+
+	//antialias over about a pixel, whatever size the text's drawn at
+	float edgeWidth = 0.7f * fwidth(dist);
+	float alpha = smoothstep(0.5f - edgeWidth, 0.5f + edgeWidth, dist);
 
 	//just place the color on the screen
-	outputColor = vec4(1, 1, 1, texColor.r);
+	outputColor = vec4(1, 1, 1, alpha);
 }
\ No newline at end of file
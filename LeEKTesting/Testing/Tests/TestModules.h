@@ -14,25 +14,45 @@
 #include <Libraries/Assimp/postprocess.h>
 #include <ResourceManagement/ResourceManager.h>
 #include <ResourceManagement/ResourceLoaders.h>
+#include <DataStructures/STLStreams.h>
+#include <Libraries/PNG++/png.hpp>
+#include <Stats/ResCacheStats.h>
 #include <FileManagement/ArchiveTypes.h>
+#include <FileManagement/PackFile.h>
+#include <FileManagement/ReadAheadStream.h>
+#include <FileManagement/LinuxAsyncDataStream.h>
 #include <ResourceManagement/ResourceArchive.h>
 #include <Strings/StringUtils.h>
 #include <Rendering/Model.h>
+#include <Math/BatchMath.h>
 #include <FileManagement/ModelFile.h>
+#include <FileManagement/TextureFile.h>
+#include <FileManagement/FontFile.h>
+#include <Rendering/TextureCompression.h>
 #include <Rendering/Camera/Camera.h>
 #include <Rendering/Font.h>
 #include <Rendering/Text.h>
+#include <Rendering/TextBatch.h>
 #include <DataStructures/OcTree.h>
 #include <Rendering/Culling/OcTreeCuller.h>
 #include <Rendering/Culling/DummyCuller.h>
 #include <Rendering/Renderer.h>
 #include <Random/Random.h>
 #include <EngineLogic/SceneGraph/ModelNode.h>
+#include <EngineLogic/SceneGraph/TransformHierarchy.h>
 #include <Hashing/HashTable.h>
 #include <Scripting/ScriptIntegration.h>
 #include "../TestBase.h"
 #include "../TestObjects.h"
+#include "../../../ModelImporterLibrary/MeshOptimizer.h"
 #include <MultiThreading/StdThreading.h>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include <Audio/XAudio2Audio.h>
 #include <Audio/SoundLoaders.h>
 #include <Platforms/IPlatform.h>
@@ -1302,13 +1322,13 @@ namespace LeEK
 				//{
 					model.RecalcBounds();
 				//}
+				if(!gfx->InitModel(model))
+				{
+					Log::E("Couldn't load model into OpenGL!");
+					return false;
+				}
 				for(U32 i = 0; i < model.MeshCount(); ++i)
 				{
-					if(!gfx->InitGeometry(model.GetMesh(i)->GetGeometry()))
-					{
-						Log::E("Couldn't load model into OpenGL!");
-						return false;
-					}
 					//we can get rid of geometry data now
 					const Geometry& geom = model.GetMesh(i)->GetGeometry();
 					//HandleMgr::DeleteHandle(geom.VertexHandle());
@@ -2217,13 +2237,13 @@ namespace LeEK
 			bool initModelIntoRenderer(Model& model)
 			{
 				//Model& model = *(Model*)modelPtr->Buffer();
+				if(!gfx->InitModel(model))
+				{
+					Log::E("Couldn't load model into OpenGL!");
+					return false;
+				}
 				for(U32 i = 0; i < model.MeshCount(); ++i)
 				{
-					if(!gfx->InitGeometry(model.GetMesh(i)->GetGeometry()))
-					{
-						Log::E("Couldn't load model into OpenGL!");
-						return false;
-					}
 					ResPtr diffTex = resMgr.GetResource(model.GetMesh(i)->GetMaterial().DiffuseTexGUID);
 					if(!diffTex)
 					{
@@ -2604,12 +2624,12 @@ namespace LeEK
 
 				Log::D("Loading resource via resource manager...");
 				game->Time().Tick();
-				std::shared_ptr<Resource> resPtrCacheMiss = resMgr.GetResource(archGUID);
+				ResPtr resPtrCacheMiss = resMgr.GetResource(archGUID);
 				game->Time().Tick();
 				Log::D(String("Loaded resource in ") + game->Time().ElapsedGameTime().ToMilliseconds() + " ms");
 				Log::D("Loading resource again...");
 				game->Time().Tick();
-				std::shared_ptr<Resource> resPtrNoMiss = resMgr.GetResource(archGUID);
+				ResPtr resPtrNoMiss = resMgr.GetResource(archGUID);
 				game->Time().Tick();
 
 
@@ -2631,7 +2651,7 @@ namespace LeEK
 								"Textures/testImg1024.png");
 
 				game->Time().Tick();
-				std::shared_ptr<Resource> pngPtr = resMgr.GetResource(pngGUID);
+				ResPtr pngPtr = resMgr.GetResource(pngGUID);
 				game->Time().Tick();
 
 				if(!pngPtr)
@@ -3031,7 +3051,7 @@ namespace LeEK
 					return false;
 				}
 
-				result = font.GenerateFromResource(fontPtr, gfx, 32, 1024);
+				result = font.GenerateFromResource(fontPtr, gfx, 32, 1024, Path(String(Filesystem::GetProgDir()) + "/FontCache"));
 				if(!result)
 				{
 					Log::E("Couldn't build glyph atlas!");
@@ -3522,13 +3542,13 @@ namespace LeEK
 				//{
 					model.RecalcBounds();
 				//}
+				if(!gfx->InitModel(model))
+				{
+					Log::E("Couldn't load model into OpenGL!");
+					return false;
+				}
 				for(U32 i = 0; i < model.MeshCount(); ++i)
 				{
-					if(!gfx->InitGeometry(model.GetMesh(i)->GetGeometry()))
-					{
-						Log::E("Couldn't load model into OpenGL!");
-						return false;
-					}
 					//we can get rid of geometry data now
 					const Geometry& geom = model.GetMesh(i)->GetGeometry();
 					//HandleMgr::DeleteHandle(geom.VertexHandle());
@@ -3728,8 +3748,8 @@ namespace LeEK
 		public:
 			TransformTest(void)
 			{
-				defaultTexPtr = 0;
-				modelPtr = 0;
+				defaultTexPtr.reset();
+				modelPtr.reset();
 				camera = LookAtCamera();
 				initTransforms();
 			}
@@ -4040,23 +4060,27 @@ namespace LeEK
 				//{
 					//model.RecalcBounds();
 				//}
-				for(U32 i = 0; i < model.MeshCount(); ++i)
+				if(!gfx->InitModel(model))
+				{
+					Log::E("Couldn't load model into OpenGL!");
+					return false;
+				}
+				for(U32 lod = 0; lod < model.LODCount(); ++lod)
 				{
-					if(!gfx->InitGeometry(model.GetMesh(i)->GetGeometry()))
+					for(U32 i = 0; i < model.LODMeshCount(lod); ++i)
 					{
-						Log::E("Couldn't load model into OpenGL!");
-						return false;
+						Mesh* mesh = model.GetLODMesh(lod, i);
+						//we can get rid of geometry data now
+						const Geometry& geom = mesh->GetGeometry();
+						//HandleMgr::DeleteHandle(geom.VertexHandle());
+						//HandleMgr::DeleteHandle(geom.IndexHandle());
+
+						//the tool doesn't write GUIDs,
+						//so replace w/ default textures.
+						//Default's already initiaized - just set it.
+						Material& mat = mesh->GetMaterial();
+						mat.DiffuseTexGUID = defaultTexPtr->GUID();
 					}
-					//we can get rid of geometry data now
-					const Geometry& geom = model.GetMesh(i)->GetGeometry();
-					//HandleMgr::DeleteHandle(geom.VertexHandle());
-					//HandleMgr::DeleteHandle(geom.IndexHandle());
-
-					//the tool doesn't write GUIDs,
-					//so replace w/ default textures.
-					//Default's already initiaized - just set it.
-					Material& mat = model.GetMesh(i)->GetMaterial();
-					mat.DiffuseTexGUID = defaultTexPtr->GUID();
 				}
 				return true;
 			}
@@ -4911,13 +4935,13 @@ namespace LeEK
 				//{
 					model.RecalcBounds();
 				//}
+				if(!gfx->InitModel(model))
+				{
+					Log::E("Couldn't load model into OpenGL!");
+					return false;
+				}
 				for(U32 i = 0; i < model.MeshCount(); ++i)
 				{
-					if(!gfx->InitGeometry(model.GetMesh(i)->GetGeometry()))
-					{
-						Log::E("Couldn't load model into OpenGL!");
-						return false;
-					}
 					//we can get rid of geometry data now
 					const Geometry& geom = model.GetMesh(i)->GetGeometry();
 					//HandleMgr::DeleteHandle(geom.VertexHandle());
@@ -5355,12 +5379,12 @@ namespace LeEK
 
 				Log::D("Loading filesystem resource via resource manager...");
 				game->Time().Tick();
-				std::shared_ptr<Resource> resPtrCacheMiss = resMgr.OpenResFromFile(filePath);
+				ResPtr resPtrCacheMiss = resMgr.OpenResFromFile(filePath);
 				game->Time().Tick();
 				Log::D(String("Loaded resource in ") + game->Time().ElapsedGameTime().ToMilliseconds() + " ms");
 				Log::D("Loading resource again...");
 				game->Time().Tick();
-				std::shared_ptr<Resource> resPtrNoMiss = resMgr.OpenResFromFile(filePath);
+				ResPtr resPtrNoMiss = resMgr.OpenResFromFile(filePath);
 				game->Time().Tick();
 
 
@@ -5502,5 +5526,3868 @@ namespace LeEK
 			}
 			void Draw(Game* game, const GameTime& time) {}
 		};
+
+		//Largest difference between two matrices' elements,
+		//for checking a fast path's results against a reference.
+		inline F32 MaxMatrixDiff(const Matrix4x4& lhs, const Matrix4x4& rhs)
+		{
+			F32 maxDiff = 0;
+			for(U32 i = 0; i < 4; ++i)
+			{
+				for(U32 j = 0; j < 4; ++j)
+				{
+					maxDiff = Math::Max(maxDiff, Math::Abs(lhs(i, j) - rhs(i, j)));
+				}
+			}
+			return maxDiff;
+		}
+
+		/**
+		Measures the cost of a frame's world transform update
+		on a deep hierarchy, for a static scene,
+		a scene where a single leaf moves,
+		and a scene where the root moves.
+		*/
+		class TransformUpdateTest : public TestBase
+		{
+		private:
+			static const U32 NUM_CHAINS = 64;
+			static const U32 CHAIN_DEPTH = 64;
+			static const U32 NUM_FRAMES = 100;
+			Vector<SpatialNode*> allNodes;
+			GroupingNode* root;
+			TransformHierarchy hierarchy;
+
+			SpatialHnd hndFor(SpatialNode* node)
+			{
+				return SpatialHnd(HandleMgr::FindHandle(node));
+			}
+			//Walks the graph, comparing each node's cached world matrix
+			//against one built from the local transforms.
+			U32 countBadMatrices(SpatialNode* node, const Transform& parentWorld)
+			{
+				//Chains are 64 levels deep, so allow for some rounding.
+				const F32 tolerance = 0.001f;
+				Transform world = node->GetLocalTransform() * parentWorld;
+				U32 numBad = MaxMatrixDiff(node->GetWorldMatrix(), world.ToMatrix()) > tolerance ? 1 : 0;
+				if(node->GetContainMode() != SpatialNode::NODE_CONTAINER)
+				{
+					return numBad;
+				}
+				GroupingNode* group = (GroupingNode*)node;
+				for(U32 i = 0; i < group->GetNumChildren(); ++i)
+				{
+					numBad += countBadMatrices(group->GetChild(i).Ptr(), world);
+				}
+				return numBad;
+			}
+			bool checkUpdate(const char* caseName, U32 numUpdated, U32 expectedUpdated)
+			{
+				bool result = true;
+				if(numUpdated != expectedUpdated)
+				{
+					LogE(String(caseName) + ": updated " + numUpdated + " transforms, expected " + expectedUpdated);
+					result = false;
+				}
+				U32 numBad = countBadMatrices(root, Transform::Identity);
+				if(numBad > 0)
+				{
+					LogE(String(caseName) + ": " + numBad + " world matrices don't match their local transforms");
+					result = false;
+				}
+				return result;
+			}
+			void buildScene(Vector<ModelNode*>& deepestLeaves)
+			{
+				root = LNew(GroupingNode, TEST_ALLOC, "TestAlloc")();
+				allNodes.push_back(root);
+				for(U32 i = 0; i < NUM_CHAINS; ++i)
+				{
+					GroupingNode* parent = root;
+					ModelNode* leaf = NULL;
+					for(U32 j = 0; j < CHAIN_DEPTH; ++j)
+					{
+						//Each level has a leaf and the next level down.
+						GroupingNode* level = LNew(GroupingNode, TEST_ALLOC, "TestAlloc")(2);
+						level->LocalTransform().SetPosition(Vector3(1.0f, 0.0f, 0.0f));
+						level->LocalTransform().SetOrientation(Quaternion::BuildYRotation(0.01f));
+						parent->AttachChild(hndFor(level));
+						leaf = LNew(ModelNode, TEST_ALLOC, "TestAlloc")();
+						leaf->LocalTransform().SetPosition(Vector3(0.0f, 1.0f, 0.0f));
+						level->AttachChild(hndFor(leaf));
+						allNodes.push_back(level);
+						allNodes.push_back(leaf);
+						parent = level;
+					}
+					deepestLeaves.push_back(leaf);
+				}
+			}
+			F64 timeFrames(Game* game, SpatialNode* moved, U32* outNumUpdated)
+			{
+				F64 totalMs = 0;
+				for(U32 i = 0; i < NUM_FRAMES; ++i)
+				{
+					if(moved)
+					{
+						moved->LocalTransform().Translate(Vector3(0.0f, 0.001f, 0.0f));
+					}
+					game->Time().Tick();
+					*outNumUpdated = hierarchy.Update();
+					game->Time().Tick();
+					totalMs += game->Time().ElapsedGameTime().ToMilliseconds();
+				}
+				return totalMs / NUM_FRAMES;
+			}
+		public:
+			TransformUpdateTest()
+			{
+				root = NULL;
+			}
+			bool Startup(Game* game)
+			{
+				Vector<ModelNode*> deepestLeaves;
+				buildScene(deepestLeaves);
+
+				game->Time().Tick();
+				hierarchy.Rebuild(root);
+				game->Time().Tick();
+				LogD(	String("Flattened ") + hierarchy.GetNumNodes() + " nodes (depth " + CHAIN_DEPTH +
+						") in " + game->Time().ElapsedGameTime().ToMilliseconds() + " ms");
+				//First update has to calculate everything.
+				game->Time().Tick();
+				U32 numUpdated = hierarchy.Update();
+				game->Time().Tick();
+				LogD(	String("Initial update: ") + numUpdated + " transforms in " +
+						game->Time().ElapsedGameTime().ToMilliseconds() + " ms");
+				checkUpdate("Initial update", numUpdated, allNodes.size());
+
+				F64 staticMs = timeFrames(game, NULL, &numUpdated);
+				LogD(String("Static scene: ") + numUpdated + " transforms/frame, " + staticMs + " ms/frame");
+				checkUpdate("Static scene", numUpdated, 0);
+				F64 leafMs = timeFrames(game, deepestLeaves[0], &numUpdated);
+				LogD(String("One leaf moving: ") + numUpdated + " transforms/frame, " + leafMs + " ms/frame");
+				checkUpdate("One leaf moving", numUpdated, 1);
+				F64 chainMs = timeFrames(game, root->GetChild(0).Ptr(), &numUpdated);
+				LogD(String("One chain moving: ") + numUpdated + " transforms/frame, " + chainMs + " ms/frame");
+				//The chain's top level, everything below it and their leaves.
+				checkUpdate("One chain moving", numUpdated, 2 * CHAIN_DEPTH);
+				F64 rootMs = timeFrames(game, root, &numUpdated);
+				LogD(String("Root moving: ") + numUpdated + " transforms/frame, " + rootMs + " ms/frame");
+				checkUpdate("Root moving", numUpdated, allNodes.size());
+
+				//For comparison, what the renderer used to do every frame -
+				//convert every node's transform to a matrix.
+				F64 convertMs = 0;
+				Matrix4x4 sink = Matrix4x4::Identity;
+				for(U32 i = 0; i < NUM_FRAMES; ++i)
+				{
+					game->Time().Tick();
+					for(U32 j = 0; j < allNodes.size(); ++j)
+					{
+						sink = allNodes[j]->GetWorldTransform().ToMatrix();
+					}
+					game->Time().Tick();
+					convertMs += game->Time().ElapsedGameTime().ToMilliseconds();
+				}
+				LogD(	String("Per-frame matrix conversion of all nodes: ") +
+						(convertMs / NUM_FRAMES) + " ms/frame" + (sink(3,3) != 1.0f ? "!" : ""));
+				return false;
+			}
+			void Shutdown(Game* game)
+			{
+				for(U32 i = 0; i < allNodes.size(); ++i)
+				{
+					LDelete(allNodes[i]);
+				}
+				allNodes.clear();
+			}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Microbenchmark for the transform hierarchy's flat arrays
+		with about a million nodes, against walking the graph node by node.
+		*/
+		class TransformSweepTest : public TestBase
+		{
+		private:
+			static const U32 NUM_GROUPS = 1024;
+			static const U32 LEAVES_PER_GROUP = 1023;
+			static const U32 NUM_FRAMES = 10;
+			Vector<SpatialNode*> allNodes;
+			GroupingNode* root;
+			TransformHierarchy hierarchy;
+
+			SpatialHnd hndFor(SpatialNode* node)
+			{
+				return SpatialHnd(HandleMgr::FindHandle(node));
+			}
+			//What a recursive update costs - every child's resolved through the handle manager,
+			//and each node's transforms are wherever the node was allocated.
+			U32 walkGraph(SpatialNode* node, const Transform& parentWorld, Vector<Matrix4x4>& out)
+			{
+				Transform world = node->GetLocalTransform() * parentWorld;
+				out.push_back(world.ToMatrix());
+				U32 numVisited = 1;
+				if(node->GetContainMode() != SpatialNode::NODE_CONTAINER)
+				{
+					return numVisited;
+				}
+				GroupingNode* group = (GroupingNode*)node;
+				for(U32 i = 0; i < group->GetNumChildren(); ++i)
+				{
+					numVisited += walkGraph(group->GetChild(i).Ptr(), world, out);
+				}
+				return numVisited;
+			}
+			//Compares each node's cached world matrix against the one walkGraph() found,
+			//visiting nodes in the same order.
+			U32 countBadMatrices(SpatialNode* node, const Vector<Matrix4x4>& walked, U32& walkIdx)
+			{
+				const F32 tolerance = 0.001f;
+				U32 numBad = MaxMatrixDiff(node->GetWorldMatrix(), walked[walkIdx]) > tolerance ? 1 : 0;
+				++walkIdx;
+				if(node->GetContainMode() != SpatialNode::NODE_CONTAINER)
+				{
+					return numBad;
+				}
+				GroupingNode* group = (GroupingNode*)node;
+				for(U32 i = 0; i < group->GetNumChildren(); ++i)
+				{
+					numBad += countBadMatrices(group->GetChild(i).Ptr(), walked, walkIdx);
+				}
+				return numBad;
+			}
+			void checkNumUpdated(const char* caseName, U32 numUpdated, U32 expectedUpdated)
+			{
+				if(numUpdated != expectedUpdated)
+				{
+					LogE(String(caseName) + ": updated " + numUpdated + " transforms, expected " + expectedUpdated);
+				}
+			}
+			F64 timeFrames(Game* game, SpatialNode* moved, U32* outNumUpdated)
+			{
+				F64 totalMs = 0;
+				for(U32 i = 0; i < NUM_FRAMES; ++i)
+				{
+					if(moved)
+					{
+						moved->LocalTransform().Translate(Vector3(0.0f, 0.001f, 0.0f));
+					}
+					game->Time().Tick();
+					*outNumUpdated = hierarchy.Update();
+					game->Time().Tick();
+					totalMs += game->Time().ElapsedGameTime().ToMilliseconds();
+				}
+				return totalMs / NUM_FRAMES;
+			}
+		public:
+			TransformSweepTest()
+			{
+				root = NULL;
+			}
+			bool Startup(Game* game)
+			{
+				root = LNew(GroupingNode, TEST_ALLOC, "TestAlloc")(NUM_GROUPS);
+				allNodes.push_back(root);
+				for(U32 i = 0; i < NUM_GROUPS; ++i)
+				{
+					GroupingNode* group = LNew(GroupingNode, TEST_ALLOC, "TestAlloc")(LEAVES_PER_GROUP);
+					group->LocalTransform().SetPosition(Vector3((F32)i, 0.0f, 0.0f));
+					group->LocalTransform().SetOrientation(Quaternion::BuildYRotation(0.01f * i));
+					root->AttachChild(hndFor(group));
+					allNodes.push_back(group);
+					for(U32 j = 0; j < LEAVES_PER_GROUP; ++j)
+					{
+						ModelNode* leaf = LNew(ModelNode, TEST_ALLOC, "TestAlloc")();
+						leaf->LocalTransform().SetPosition(Vector3(0.0f, (F32)j, 0.0f));
+						group->AttachChild(hndFor(leaf));
+						allNodes.push_back(leaf);
+					}
+				}
+
+				game->Time().Tick();
+				hierarchy.Rebuild(root);
+				game->Time().Tick();
+				LogD(	String("Built arrays for ") + hierarchy.GetNumNodes() + " nodes in " +
+						game->Time().ElapsedGameTime().ToMilliseconds() + " ms");
+
+				U32 numUpdated = 0;
+				F64 rootMs = timeFrames(game, root, &numUpdated);
+				LogD(	String("Full sweep: ") + numUpdated + " transforms, " + rootMs + " ms/frame, " +
+						(rootMs * 1000000.0 / numUpdated) + " ns/node");
+				checkNumUpdated("Full sweep", numUpdated, allNodes.size());
+				F64 groupMs = timeFrames(game, root->GetChild(0).Ptr(), &numUpdated);
+				LogD(String("One group moving: ") + numUpdated + " transforms, " + groupMs + " ms/frame");
+				checkNumUpdated("One group moving", numUpdated, LEAVES_PER_GROUP + 1);
+				F64 staticMs = timeFrames(game, NULL, &numUpdated);
+				LogD(String("Static scene: ") + numUpdated + " transforms, " + staticMs + " ms/frame");
+				checkNumUpdated("Static scene", numUpdated, 0);
+
+				Vector<Matrix4x4> walked;
+				walked.reserve(allNodes.size());
+				F64 walkMs = 0;
+				U32 numWalked = 0;
+				for(U32 i = 0; i < NUM_FRAMES; ++i)
+				{
+					walked.clear();
+					game->Time().Tick();
+					numWalked = walkGraph(root, Transform::Identity, walked);
+					game->Time().Tick();
+					walkMs += game->Time().ElapsedGameTime().ToMilliseconds();
+				}
+				walkMs /= NUM_FRAMES;
+				LogD(	String("Recursive graph walk: ") + numWalked + " transforms, " + walkMs + " ms/frame, " +
+						(walkMs * 1000000.0 / numWalked) + " ns/node");
+
+				//Both paths should've come up with the same transforms.
+				if(numWalked != hierarchy.GetNumNodes())
+				{
+					LogE(String("Graph walk visited ") + numWalked + " nodes, but the arrays hold " + hierarchy.GetNumNodes());
+					return false;
+				}
+				U32 walkIdx = 0;
+				U32 numBad = countBadMatrices(root, walked, walkIdx);
+				if(numBad > 0)
+				{
+					LogE(String("Sweep: ") + numBad + " world matrices don't match the graph walk's");
+				}
+				return false;
+			}
+			void Shutdown(Game* game)
+			{
+				for(U32 i = 0; i < allNodes.size(); ++i)
+				{
+					LDelete(allNodes[i]);
+				}
+				allNodes.clear();
+			}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Benchmarks the SIMD matrix and quaternion kernels
+		against the scalar code they replaced.
+		*/
+		class MathKernelTest : public TestBase
+		{
+		private:
+			static const U32 NUM_OPS = 1000000;
+			static const U32 NUM_POINTS = 100000;
+
+			//The replaced implementations, kept here for comparison.
+			static Matrix4x4 oldMultiply(const Matrix4x4& lhs, const Matrix4x4& rhs)
+			{
+				Matrix4x4 result = Matrix4x4::Zero;
+				for(U32 i = 0; i < Matrix4x4::MATRIX_SIZE; i++)
+				{
+					for(U32 j = 0; j < Matrix4x4::MATRIX_SIZE; j++)
+					{
+						for(U32 k = 0; k < Matrix4x4::MATRIX_SIZE; k++)
+						{
+							result(i, j) += lhs(i, k) * rhs(k, j);
+						}
+					}
+				}
+				return result;
+			}
+			static Matrix4x4 oldFindInverse(const Matrix4x4& m)
+			{
+				F32 det = m.Determinant();
+				if(Math::ApproxEqual(det, 0.0f))
+				{
+					return Matrix4x4::Zero;
+				}
+				return m.Adjoint() / det;
+			}
+			static Matrix4x4 oldTransformInverse(const Matrix4x4& m)
+			{
+				Matrix3x3 rot = m.GetRotationSubmatrix();
+				rot.Transpose();
+				Vector3 trans = -rot.Multiply(m.GetTranslateComponent());
+				return Matrix4x4(	rot(0,0),	rot(0,1),	rot(0,2),	trans.X(),
+									rot(1,0),	rot(1,1),	rot(1,2),	trans.Y(),
+									rot(2,0),	rot(2,1),	rot(2,2),	trans.Z(),
+									0.0f,		0.0f,		0.0f,		1.0f);
+			}
+			static Quaternion oldQuatMultiply(Quaternion lhs, const Quaternion& rhs)
+			{
+				F32 x = lhs.X(), y = lhs.Y(), z = lhs.Z(), w = lhs.W();
+				w = w*rhs.W() - x*rhs.X() - y*rhs.Y() - z*rhs.Z();
+				x = w*rhs.X() + x*rhs.W() + y*rhs.Z() - z*rhs.Y();
+				y = w*rhs.Y() - x*rhs.Z() + y*rhs.W() + z*rhs.X();
+				z = w*rhs.Z() + x*rhs.Y() - y*rhs.X() + z*rhs.W();
+				lhs.SetX(x);
+				lhs.SetY(y);
+				lhs.SetZ(z);
+				lhs.SetW(w);
+				lhs.Normalize();
+				return lhs;
+			}
+			static Vector3 oldRotateVector(const Quaternion& q, const Vector3& v)
+			{
+				Vector3 quatVec = Vector3(q.X(), q.Y(), q.Z());
+				Vector3 t = 2.0f * Vector3::Cross(quatVec, v);
+				return v + (q.W() * t) + Vector3::Cross(quatVec, t);
+			}
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			void report(const char* name, F64 oldMs, F64 newMs)
+			{
+				LogD(String(name) + ": old " + oldMs + " ms, new " + newMs + " ms (" + (oldMs / newMs) + "x)");
+			}
+		public:
+			bool Startup(Game* game)
+			{
+#ifdef ENABLE_SSE
+				LogD("Math kernels: SSE");
+#else
+				LogD("Math kernels: scalar");
+#endif
+				Transform trans = Transform(Vector3(1.0f, -2.0f, 3.0f), Quaternion::FromEulerAngles(0.3f, 0.2f, 0.1f), 1.0f);
+				Matrix4x4 a = trans.ToMatrix();
+				Matrix4x4 b = Matrix4x4::BuildPerspectiveRH(1.5f, Math::PI_OVER_4, 0.1f, 100.0f);
+				F64 oldMs, newMs;
+
+				//Matrix multiply; feed the result back in so the work can't be skipped.
+				Matrix4x4 oldRes = a, newRes = a;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS; ++i)
+				{
+					oldRes = oldMultiply(oldRes, a);
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS; ++i)
+				{
+					newRes *= a;
+				}
+				newMs = stopTimer(game);
+				report("Matrix4x4 multiply", oldMs, newMs);
+
+				//General inverse.
+				Matrix4x4 m = a * b;
+				Matrix4x4 oldInv, newInv;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS / 10; ++i)
+				{
+					oldInv = oldFindInverse(m);
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS / 10; ++i)
+				{
+					newInv = m.FindInverse();
+				}
+				newMs = stopTimer(game);
+				report("FindInverse", oldMs, newMs);
+				LogD("M * FindInverse(M) = " + (m * newInv).ToString());
+
+				//Transform inverse.
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS; ++i)
+				{
+					oldInv = oldTransformInverse(a);
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS; ++i)
+				{
+					newInv = a.GetTransformInverse();
+				}
+				newMs = stopTimer(game);
+				report("GetTransformInverse", oldMs, newMs);
+				LogD("A * GetTransformInverse(A) = " + (a * newInv).ToString());
+
+				//Quaternion multiply.
+				Quaternion step = Quaternion::FromEulerAngles(0.01f, 0.02f, 0.03f);
+				Quaternion oldQ = Quaternion::Identity, newQ = Quaternion::Identity;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS; ++i)
+				{
+					oldQ = oldQuatMultiply(oldQ, step);
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_OPS; ++i)
+				{
+					newQ *= step;
+				}
+				newMs = stopTimer(game);
+				report("Quaternion multiply", oldMs, newMs);
+
+				//Point transformation and rotation, one at a time versus batched.
+				Vector<Vector3> points;
+				Vector<Vector3> results;
+				points.reserve(NUM_POINTS);
+				results.resize(NUM_POINTS);
+				for(U32 i = 0; i < NUM_POINTS; ++i)
+				{
+					points.push_back(Vector3((F32)i, (F32)(i % 7), -(F32)(i % 13)));
+				}
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_POINTS; ++i)
+				{
+					results[i] = a.MultiplyPoint(points[i]);
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				a.MultiplyPoints(&points[0], &results[0], NUM_POINTS);
+				newMs = stopTimer(game);
+				report("Point transform (per point vs. MultiplyPoints)", oldMs, newMs);
+
+				Quaternion rot = trans.Orientation();
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_POINTS; ++i)
+				{
+					results[i] = oldRotateVector(rot, points[i]);
+				}
+				oldMs = stopTimer(game);
+				Vector3 oldLast = results[NUM_POINTS - 1];
+				game->Time().Tick();
+				rot.RotateVectors(&points[0], &results[0], NUM_POINTS);
+				newMs = stopTimer(game);
+				report("Quaternion rotate (per point vs. RotateVectors)", oldMs, newMs);
+
+				LogD(	String("Sinks: ") + oldRes(0,0) + newRes(0,0) + oldQ.W() + newQ.W() +
+						oldInv(0,0) + ", rotate check " + oldLast.ToString() + " vs " + results[NUM_POINTS - 1].ToString());
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Benchmarks the batched vector math in BatchMath
+		against looping over the single-element operations,
+		on a vertex buffer sized like a large imported model.
+		*/
+		class BatchMathTest : public TestBase
+		{
+		private:
+			static const U32 NUM_VERTS = 1 << 20;
+			static const U32 NUM_QUATS = 1 << 16;
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			void report(const char* name, F64 oldMs, F64 newMs)
+			{
+				LogD(String(name) + ": per element " + oldMs + " ms, batched " + newMs + " ms (" + (oldMs / newMs) + "x)");
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Vector<Vertex> verts;
+				verts.resize(NUM_VERTS);
+				Vector<Vector3> positions;
+				positions.reserve(NUM_VERTS);
+				for(U32 i = 0; i < NUM_VERTS; ++i)
+				{
+					verts[i].Position = Random::InCube(-100.0f, 100.0f);
+					verts[i].Normal = verts[i].Position;
+					positions.push_back(verts[i].Position);
+				}
+				Vector<Vector3> results;
+				results.resize(NUM_VERTS);
+				F64 oldMs, newMs;
+
+				//AABB over vertex positions; this is what Model::RecalcBounds() used to do.
+				Vector3 oldMin = Vector3::Zero, oldMax = Vector3::Zero;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_VERTS; ++i)
+				{
+					const Vector3& vert = verts[i].Position;
+					oldMax.SetX(Math::Max(oldMax.X(), vert.X()));
+					oldMax.SetY(Math::Max(oldMax.Y(), vert.Y()));
+					oldMax.SetZ(Math::Max(oldMax.Z(), vert.Z()));
+					oldMin.SetX(Math::Min(oldMin.X(), vert.X()));
+					oldMin.SetY(Math::Min(oldMin.Y(), vert.Y()));
+					oldMin.SetZ(Math::Min(oldMin.Z(), vert.Z()));
+				}
+				oldMs = stopTimer(game);
+				Vector3 newMin = Vector3::Zero, newMax = Vector3::Zero;
+				game->Time().Tick();
+				BatchMath::ExpandAABB(&verts[0].Position, NUM_VERTS, newMin, newMax, sizeof(Vertex));
+				newMs = stopTimer(game);
+				report("Vertex AABB", oldMs, newMs);
+				LogD("AABB check: " + oldMin.ToString() + oldMax.ToString() + " vs " + newMin.ToString() + newMax.ToString());
+
+				//Import path; rotating positions and normals into engine space.
+				Matrix4x4 convertUpAxis = Matrix4x4::FromEulerAngles(-Math::PI_OVER_2, 0, Math::PI);
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_VERTS; ++i)
+				{
+					results[i] = convertUpAxis.MultiplyPoint(positions[i]);
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				BatchMath::TransformPoints(convertUpAxis, &positions[0], &results[0], NUM_VERTS);
+				newMs = stopTimer(game);
+				report("Point transform", oldMs, newMs);
+
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_VERTS; ++i)
+				{
+					results[i] = convertUpAxis.MultiplyVector(positions[i]);
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				BatchMath::TransformVectors(convertUpAxis, &positions[0], &results[0], NUM_VERTS);
+				newMs = stopTimer(game);
+				report("Vector transform", oldMs, newMs);
+
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_VERTS; ++i)
+				{
+					results[i] = positions[i].GetNormalized();
+				}
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				BatchMath::NormalizeVectors(&positions[0], &results[0], NUM_VERTS);
+				newMs = stopTimer(game);
+				report("Normalize", oldMs, newMs);
+
+				//SoA versions; no old equivalent, so time against the AoS versions.
+				Vector<F32> xs, ys, zs;
+				xs.resize(NUM_VERTS);
+				ys.resize(NUM_VERTS);
+				zs.resize(NUM_VERTS);
+				for(U32 i = 0; i < NUM_VERTS; ++i)
+				{
+					xs[i] = positions[i].X();
+					ys[i] = positions[i].Y();
+					zs[i] = positions[i].Z();
+				}
+				game->Time().Tick();
+				BatchMath::TransformPoints(convertUpAxis, &positions[0], &results[0], NUM_VERTS);
+				oldMs = stopTimer(game);
+				game->Time().Tick();
+				BatchMath::TransformPoints(convertUpAxis, &xs[0], &ys[0], &zs[0], &xs[0], &ys[0], &zs[0], NUM_VERTS);
+				newMs = stopTimer(game);
+				LogD(String("Point transform, AoS ") + oldMs + " ms vs. SoA " + newMs + " ms");
+
+				Vector3 center;
+				game->Time().Tick();
+				F32 radius = BatchMath::FindBoundingSphere(&positions[0], NUM_VERTS, center);
+				newMs = stopTimer(game);
+				LogD(String("Bounding sphere: ") + newMs + " ms, center " + center.ToString() + ", radius " + radius);
+
+				Vector<Quaternion> fromQuats, toQuats, slerped;
+				fromQuats.reserve(NUM_QUATS);
+				toQuats.reserve(NUM_QUATS);
+				slerped.resize(NUM_QUATS);
+				for(U32 i = 0; i < NUM_QUATS; ++i)
+				{
+					fromQuats.push_back(Random::InCubicEulerRange());
+					toQuats.push_back(Random::InCubicEulerRange());
+				}
+				game->Time().Tick();
+				BatchMath::SlerpQuaternions(&fromQuats[0], &toQuats[0], 0.5f, &slerped[0], NUM_QUATS);
+				newMs = stopTimer(game);
+				LogD(String("Slerp: ") + NUM_QUATS + " quaternions in " + newMs + " ms");
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Sweeps a model with three lower LODs out to where the coarsest one's enough, and back in.
+		The LOD has to get coarser going out and finer coming in, switching once per level each way.
+		*/
+		class LODSelectionTest : public TestBase
+		{
+		public:
+			bool Startup(Game* game)
+			{
+				//LOD selection only looks at the error values,
+				//so empty levels are fine here.
+				Model model;
+				model.AddLOD(0.05f);
+				model.AddLOD(0.1f);
+				model.AddLOD(0.2f);
+				//Sweep the model out and back in,
+				//logging every switch so popping's easy to spot.
+				const F32 pixelsPerUnitAtOne = 1000.0f;
+				const F32 maxPixelError = 1.0f;
+				const F32 hysteresis = 0.25f;
+				U32 lod = 0;
+				U32 numSwitches = 0;
+				U32 farthestLOD = 0;
+				bool monotonic = true;
+				for(I32 step = -400; step <= 400; ++step)
+				{
+					F32 dist = 400.0f - Math::Abs((F32)step) + 1.0f;
+					U32 newLOD = model.SelectLOD(pixelsPerUnitAtOne / dist, maxPixelError, lod, hysteresis);
+					if(newLOD != lod)
+					{
+						LogD(String("Distance ") + dist + ": LOD " + lod + " -> " + newLOD);
+						//moving out should only ever coarsen, and moving in only refine.
+						monotonic &= (step < 0) == (newLOD > lod);
+						lod = newLOD;
+						++numSwitches;
+					}
+					if(step == 0)
+					{
+						farthestLOD = lod;
+					}
+				}
+				LogD(String("LOD switches over sweep: ") + numSwitches);
+				U32 coarsest = model.LODCount() - 1;
+				if(!monotonic || farthestLOD != coarsest || lod != 0 || numSwitches != 2 * coarsest)
+				{
+					LogE(	String("LOD didn't follow distance! LOD ") + farthestLOD + "/" + coarsest + " when farthest, " +
+							lod + " when closest, " + numSwitches + " switches");
+				}
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Loads everything in the test archives synchronously, then asynchronously,
+		and compares the worst frame time of each.
+		A synchronous bulk load stalls one frame for the whole load.
+		*/
+		class AsyncLoadTest : public TestBase
+		{
+		private:
+			static const U32 NUM_ARCHIVES = 2;
+			static const U32 CACHE_SIZE_MB = 64;
+			ResourceManager resMgr;
+			Vector<ResGUID> guids;
+			Vector<ResRequestPtr> requests;
+			F64 syncTotalMs;
+			F64 worstFrameMs;
+			U32 numFrames;
+			U32 numLoaded;
+
+			static void onLoaded(const ResPtr& resource, void* userData)
+			{
+				if(resource)
+				{
+					++*(U32*)userData;
+				}
+			}
+		public:
+			AsyncLoadTest() : syncTotalMs(0), worstFrameMs(0), numFrames(0), numLoaded(0) {}
+			bool Startup(Game* game)
+			{
+				const char* archives[NUM_ARCHIVES] = {	"/TestContent/Archives/Test1.zip",
+														"/TestContent/Archives/Test2.zip" };
+				//Synchronous pass; also finds which resources are loadable.
+				{
+					EditorResManager syncMgr;
+					if(!syncMgr.Init(CACHE_SIZE_MB))
+					{
+						LogE("Couldn't init resource manager!");
+						return false;
+					}
+					syncMgr.RegisterLoader(GetSharedPtr(CustomNew<PNGLoader>(RESLOADER_ALLOC, "ResLoaderAlloc")));
+					for(U32 i = 0; i < NUM_ARCHIVES; ++i)
+					{
+						ResGUID archGUID(archives[i], "");
+						U32 numRes = syncMgr.GetNumResourcesInArchive(archGUID);
+						for(U32 j = 0; j < numRes; ++j)
+						{
+							ResGUID guid = syncMgr.GetResGUID(archGUID, j);
+							game->Time().Tick();
+							bool loaded = (bool)syncMgr.GetResource(guid);
+							game->Time().Tick();
+							if(loaded)
+							{
+								syncTotalMs += game->Time().ElapsedGameTime().ToMilliseconds();
+								guids.push_back(guid);
+							}
+						}
+					}
+					syncMgr.Shutdown();
+				}
+				LogD(String("Synchronous load of ") + guids.size() + " resources: " + syncTotalMs + " ms in one frame");
+
+				//Async pass; requests go out now, and finish over the next frames.
+				if(!resMgr.Init(CACHE_SIZE_MB))
+				{
+					LogE("Couldn't init resource manager!");
+					return false;
+				}
+				resMgr.RegisterLoader(GetSharedPtr(CustomNew<PNGLoader>(RESLOADER_ALLOC, "ResLoaderAlloc")));
+				game->Time().Tick();
+				for(U32 i = 0; i < guids.size(); ++i)
+				{
+					requests.push_back(resMgr.GetResourceAsync(guids[i], 0, onLoaded, &numLoaded));
+				}
+				game->Time().Tick();
+				LogD(String("Issued async requests in ") + game->Time().ElapsedGameTime().ToMilliseconds() + " ms");
+				return true;
+			}
+			void Shutdown(Game* game)
+			{
+				requests.clear();
+				resMgr.Shutdown();
+			}
+			void Update(Game* game, const GameTime& time)
+			{
+				//the first frame includes startup, so skip it.
+				if(numFrames > 0)
+				{
+					worstFrameMs = Math::Max(worstFrameMs, time.ElapsedGameTime().ToMilliseconds());
+				}
+				++numFrames;
+				resMgr.UpdateAsyncLoads();
+				if(resMgr.NumPendingLoads() == 0)
+				{
+					LogD(	String("Async load of ") + numLoaded + "/" + requests.size() + " resources took " +
+							numFrames + " frames; worst frame " + worstFrameMs + " ms vs. " + syncTotalMs + " ms synchronous");
+					game->Quit();
+				}
+			}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Resource manager for benchmarks that fill the cache themselves, without any archives.
+		Shuts down and drops its handle when it's destroyed, so it can live on a test's stack.
+		*/
+		class BenchResManager : public ResourceManager
+		{
+		private:
+			TypedHandle<ResourceManager> selfHnd;
+		public:
+			~BenchResManager()
+			{
+				//resources report back through the handle as they're freed,
+				//so empty the cache before dropping it.
+				Shutdown();
+				HandleMgr::RemovePtr(this);
+			}
+			bool Init(FileSz cacheSizeMb)
+			{
+				if(!ResourceManager::Init(cacheSizeMb))
+				{
+					return false;
+				}
+				selfHnd = HandleMgr::RegisterPtr(this).GetHandle();
+				return selfHnd.GetHandle() != 0;
+			}
+			TypedHandle<ResourceManager> Handle() const { return selfHnd; }
+			//Caches a resource of the given size. Returns false if there's no room for it.
+			bool AddDummyResource(const ResGUID& guid, FileSz size = 1, ResCategory category = OTHER_RES)
+			{
+				char* buf = allocate(size, category);
+				if(!buf)
+				{
+					return false;
+				}
+				cacheResource(ResPtr(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc", guid, buf, size, selfHnd)), category);
+				return true;
+			}
+			ResPtr Get(const ResGUID& guid) { return GetResource(guid); }
+			//Makes a texture resource with room in the cache, but doesn't cache it; a loader can then fill it.
+			ResPtr MakeTexture(const ResGUID& guid, FileSz size)
+			{
+				char* buf = allocate(size, TEXTURE_RES);
+				if(!buf)
+				{
+					return ResPtr();
+				}
+				return ResPtr(CustomNew<Resource>(RESFILE_ALLOC, "ResAlloc", guid, buf, size, selfHnd));
+			}
+		};
+
+		/**
+		Tiles a PNG out to size x size and encodes it again,
+		for benchmarks that need bigger images than the test archives have.
+		@return the tiled PNG, to be freed with CustomArrayDelete().
+		*/
+		inline char* TilePNG(char* png, FileSz pngSize, U32 size, FileSz& tiledSize)
+		{
+			MemBuf srcBuf(png, pngSize);
+			std::istream srcStr(&srcBuf);
+			png::image<png::rgba_pixel> src(srcStr);
+			U32 srcWidth = src.get_width();
+			U32 srcHeight = src.get_height();
+			png::image<png::rgba_pixel> img(size, size);
+			for(U32 y = 0; y < size; ++y)
+			{
+				for(U32 x = 0; x < size; ++x)
+				{
+					img.set_pixel(x, y, src.get_pixel(x % srcWidth, y % srcHeight));
+				}
+			}
+			std::ostringstream outStr;
+			img.write_stream(outStr);
+			std::string encoded = outStr.str();
+			tiledSize = encoded.size();
+			char* tiled = CustomArrayNew<char>(tiledSize, TEST_ALLOC, "TestTempBufAlloc");
+			memcpy(tiled, encoded.data(), tiledSize);
+			return tiled;
+		}
+
+		/**
+		Times cache hits with 50000 resources cached, using the access pattern
+		of a draw loop: each frame, every visible mesh fetches its diffuse and specular textures,
+		and the visible set slides a little each frame as the camera moves.
+		Compared against the old cache, a String keyed map plus an LRU list that's searched on every hit.
+		*/
+		class ResourceCacheTest : public TestBase
+		{
+		private:
+			static const U32 NUM_RESOURCES = 50000;
+			static const U32 NUM_VISIBLE = 2000;
+			static const U32 SCROLL_PER_FRAME = 50;
+			static const U32 NUM_FRAMES = 100;
+			//the old cache is far slower, so it only gets a few frames.
+			static const U32 NUM_OLD_FRAMES = 10;
+
+			//The cache as it was.
+			class OldResCache
+			{
+			private:
+				List<ResPtr> lruList;
+				Map<String, ResPtr> resMap;
+			public:
+				void Add(const ResPtr& res)
+				{
+					lruList.push_front(res);
+					resMap[res->GUID().Name] = res;
+				}
+				ResPtr Get(const ResGUID& guid)
+				{
+					Map<String, ResPtr>::iterator resIt = resMap.find(guid.Name);
+					if(resIt == resMap.end())
+					{
+						return ResPtr();
+					}
+					for(List<ResPtr>::iterator it = lruList.begin(); it != lruList.end(); ++it)
+					{
+						if((*it)->GUID() == resIt->second->GUID())
+						{
+							lruList.erase(it);
+							break;
+						}
+					}
+					lruList.push_front(resIt->second);
+					return resIt->second;
+				}
+				void Clear()
+				{
+					lruList.clear();
+					resMap.clear();
+				}
+			};
+
+			Vector<ResGUID> guids;
+
+			//Runs the draw loop's lookups for a frame;
+			//mesh i uses textures 2i and 2i+1.
+			template<typename cacheT>
+			U32 drawFrame(U32 frame, cacheT& cache)
+			{
+				U32 numHits = 0;
+				U32 numMeshes = NUM_RESOURCES / 2;
+				U32 firstVisible = (frame * SCROLL_PER_FRAME) % numMeshes;
+				for(U32 i = 0; i < NUM_VISIBLE; ++i)
+				{
+					U32 mesh = (firstVisible + i) % numMeshes;
+					numHits += cache.Get(guids[2*mesh]) ? 1 : 0;
+					numHits += cache.Get(guids[2*mesh + 1]) ? 1 : 0;
+				}
+				return numHits;
+			}
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				guids.reserve(NUM_RESOURCES);
+				for(U32 i = 0; i < NUM_RESOURCES; ++i)
+				{
+					guids.push_back(ResGUID("bench.zip", String("textures/level") + (i % 16) + "/tex" + i + ".png"));
+				}
+
+				BenchResManager resMgr;
+				if(!resMgr.Init(1))
+				{
+					LogE("Couldn't init resource manager!");
+					return false;
+				}
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_RESOURCES; ++i)
+				{
+					resMgr.AddDummyResource(guids[i]);
+				}
+				LogD(String("Cached ") + NUM_RESOURCES + " resources in " + stopTimer(game) + " ms");
+
+				U32 newHits = 0;
+				game->Time().Tick();
+				for(U32 frame = 0; frame < NUM_FRAMES; ++frame)
+				{
+					newHits += drawFrame(frame, resMgr);
+				}
+				F64 newMs = stopTimer(game) / NUM_FRAMES;
+
+				OldResCache oldCache;
+				for(U32 i = 0; i < NUM_RESOURCES; ++i)
+				{
+					oldCache.Add(resMgr.GetResource(guids[i]));
+				}
+				U32 oldHits = 0;
+				game->Time().Tick();
+				for(U32 frame = 0; frame < NUM_OLD_FRAMES; ++frame)
+				{
+					oldHits += drawFrame(frame, oldCache);
+				}
+				F64 oldMs = stopTimer(game) / NUM_OLD_FRAMES;
+				oldCache.Clear();
+
+				//everything's cached, so every lookup should hit.
+				U32 lookupsPerFrame = NUM_VISIBLE * 2;
+				LogD(String("Lookups per frame: ") + lookupsPerFrame + "; hits: old " + oldHits + ", new " + newHits);
+				if(newHits != lookupsPerFrame * NUM_FRAMES || oldHits != lookupsPerFrame * NUM_OLD_FRAMES)
+				{
+					LogE("Lookups missed resources that were cached!");
+				}
+				LogD(String("Per frame: old ") + oldMs + " ms, new " + newMs + " ms (" + (oldMs / newMs) + "x)");
+
+				//eviction's constant time too; time emptying the whole cache.
+				game->Time().Tick();
+				resMgr.Shutdown();
+				LogD(String("Evicted ") + NUM_RESOURCES + " resources in " + stopTimer(game) + " ms");
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Loads every file in the test archives many times over,
+		keeping everything loaded like a cache would, both through reads
+		and through the archive's memory mapping; stored files are used in place when mapped.
+		Every file's data is checksummed, so mapped files are actually read,
+		and both ways have to give the same data.
+		Reports the time taken and how much the process's resident memory grew.
+		*/
+		class ArchiveMappingTest : public TestBase
+		{
+		private:
+			static const U32 NUM_ARCHIVES = 2;
+			//repeats the archives to make up a larger data set.
+			static const U32 NUM_PASSES = 100;
+
+			//Gets a field from /proc/self/status in KB, or 0 if it's not available.
+			static U32 residentKB(const char* field)
+			{
+				U32 result = 0;
+#ifdef __linux__
+				FILE* status = fopen("/proc/self/status", "r");
+				if(!status)
+				{
+					return 0;
+				}
+				char line[256];
+				size_t fieldLen = strlen(field);
+				while(fgets(line, sizeof(line), status))
+				{
+					if(strncmp(line, field, fieldLen) == 0 && line[fieldLen] == ':')
+					{
+						result = (U32)atol(line + fieldLen + 1);
+						break;
+					}
+				}
+				fclose(status);
+#endif
+				return result;
+			}
+
+			//Gets the number of files loaded, and the checksum of all their data.
+			U32 loadAll(Game* game, bool useMapping, U32& checksum)
+			{
+				const char* archives[NUM_ARCHIVES] = {	"/TestContent/Archives/Test1.zip",
+														"/TestContent/Archives/Test2.zip" };
+				ZipFile files[NUM_ARCHIVES];
+				Vector<char*> buffers;
+				U32 numLoaded = 0;
+				checksum = crc32(0, NULL, 0);
+				U32 anonStart = residentKB("RssAnon");
+				U32 fileStart = residentKB("RssFile");
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_ARCHIVES; ++i)
+				{
+					if(!files[i].Init(Path(String(Filesystem::GetProgDir()) + archives[i]), useMapping))
+					{
+						LogE(String("Couldn't open ") + archives[i] + "!");
+						return 0;
+					}
+				}
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					for(U32 i = 0; i < NUM_ARCHIVES; ++i)
+					{
+						ZipFile& file = files[i];
+						for(I32 j = 0; j < file.GetNumFiles(); ++j)
+						{
+							FileSz size = file.GetFileLen(j);
+							if(size == 0)
+							{
+								continue;
+							}
+							const char* mapped = NULL;
+							if(file.IsMapped() && file.GetCompression(j) == COMP_NONE)
+							{
+								mapped = file.GetMappedFile(j);
+							}
+							if(mapped)
+							{
+								checksum = crc32(checksum, (const Bytef*)mapped, size);
+								++numLoaded;
+								continue;
+							}
+							char* buf = CustomArrayNew<char>(size, TEST_ALLOC, "TestTempBufAlloc");
+							if(file.ReadFile(j, buf))
+							{
+								checksum = crc32(checksum, (const Bytef*)buf, size);
+								++numLoaded;
+							}
+							buffers.push_back(buf);
+						}
+					}
+				}
+				game->Time().Tick();
+				F64 loadMs = game->Time().ElapsedGameTime().ToMilliseconds();
+				LogD(	String(useMapping ? "Mapped: " : "Read: ") + numLoaded + " files in " + loadMs +
+						" ms; anonymous RSS +" + (I32)(residentKB("RssAnon") - anonStart) +
+						" KB, file backed RSS +" + (I32)(residentKB("RssFile") - fileStart) + " KB");
+				for(U32 i = 0; i < buffers.size(); ++i)
+				{
+					CustomArrayDelete(buffers[i]);
+				}
+				return numLoaded;
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				U32 readChecksum, mappedChecksum;
+				U32 numRead = loadAll(game, false, readChecksum);
+				U32 numMapped = loadAll(game, true, mappedChecksum);
+				if(numRead == 0 || numRead != numMapped || readChecksum != mappedChecksum)
+				{
+					LogE(	String("Mapped files don't match read files! ") + numMapped + "/" + numRead + " files, checksum " +
+							mappedChecksum + " vs " + readChecksum);
+				}
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		//Little endian writers, for tests that build archives by hand.
+		inline void Put16(Vector<char>& out, U16 val)
+		{
+			out.push_back((char)(val & 0xFF));
+			out.push_back((char)(val >> 8));
+		}
+		inline void Put32(Vector<char>& out, U32 val)
+		{
+			Put16(out, (U16)(val & 0xFFFF));
+			Put16(out, (U16)(val >> 16));
+		}
+		inline void Put64(Vector<char>& out, U64 val)
+		{
+			Put32(out, (U32)(val & 0xFFFFFFFF));
+			Put32(out, (U32)(val >> 32));
+		}
+
+		/**
+		Preloads a large archive with different numbers of decode threads,
+		and reports the throughput of each.
+		The archive's built from many copies of a test archive's files.
+		*/
+		class PreloadTest : public TestBase
+		{
+		private:
+			static const U32 CACHE_SIZE_MB = 256;
+			static const U32 MAX_THREADS = 8;
+			//copies of the source archive's files in the preloaded archive.
+			static const U32 NUM_COPIES = 128;
+
+			static void onProgress(I32 progress, bool& cancel)
+			{
+				LogV(String("Preload ") + progress + "% done");
+			}
+
+			//Writes a ZIP holding NUM_COPIES copies of each of the source's files, compressed as they were.
+			//Gets the number of files written and their total uncompressed size.
+			static bool writeArchive(ZipFile& src, const Path& path, U32& numFiles, F64& totalBytes)
+			{
+				struct DirEntry
+				{
+					String Name;
+					U16 Compression;
+					U32 CRC;
+					U32 CompSize;
+					U32 Size;
+					U32 LocalOffset;
+				};
+				Vector<DirEntry> dir;
+				Vector<char> data;
+				for(I32 i = 0; i < src.GetNumFiles(); ++i)
+				{
+					DirEntry entry;
+					entry.Size = src.GetFileLen(i);
+					entry.CompSize = src.GetCompressedLen(i);
+					entry.Compression = src.GetCompression(i);
+					if(entry.Size == 0)
+					{
+						continue;
+					}
+					char* raw = CustomArrayNew<char>(entry.Size, TEST_ALLOC, "TestTempBufAlloc");
+					char* packed = CustomArrayNew<char>(entry.CompSize, TEST_ALLOC, "TestTempBufAlloc");
+					bool read = src.ReadFile(i, raw) && src.ReadCompressedFile(i, packed);
+					entry.CRC = crc32(0, (const Bytef*)raw, entry.Size);
+					for(U32 c = 0; read && c < NUM_COPIES; ++c)
+					{
+						entry.Name = String("Copy") + c + "/" + src.GetFilename(i);
+						entry.LocalOffset = data.size();
+						Put32(data, 0x04034b50);
+						//version, flags, compression, time, date.
+						Put16(data, 20); Put16(data, 0); Put16(data, entry.Compression); Put16(data, 0); Put16(data, 0);
+						Put32(data, entry.CRC); Put32(data, entry.CompSize); Put32(data, entry.Size);
+						Put16(data, (U16)entry.Name.length()); Put16(data, 0);
+						data.insert(data.end(), entry.Name.begin(), entry.Name.end());
+						data.insert(data.end(), packed, packed + entry.CompSize);
+						dir.push_back(entry);
+						totalBytes += entry.Size;
+					}
+					CustomArrayDelete(raw);
+					CustomArrayDelete(packed);
+					if(!read)
+					{
+						return false;
+					}
+				}
+				U32 dirOffset = data.size();
+				for(U32 i = 0; i < dir.size(); ++i)
+				{
+					const DirEntry& entry = dir[i];
+					Put32(data, 0x02014b50);
+					//version made, version needed, flags, compression, time, date.
+					Put16(data, 20); Put16(data, 20); Put16(data, 0); Put16(data, entry.Compression); Put16(data, 0); Put16(data, 0);
+					Put32(data, entry.CRC); Put32(data, entry.CompSize); Put32(data, entry.Size);
+					//name, extra and comment lengths, disk, attributes.
+					Put16(data, (U16)entry.Name.length()); Put16(data, 0); Put16(data, 0); Put16(data, 0); Put16(data, 0);
+					Put32(data, 0);
+					Put32(data, entry.LocalOffset);
+					data.insert(data.end(), entry.Name.begin(), entry.Name.end());
+				}
+				U32 dirSize = data.size() - dirOffset;
+				Put32(data, 0x06054b50);
+				Put16(data, 0); Put16(data, 0);
+				Put16(data, (U16)dir.size()); Put16(data, (U16)dir.size());
+				Put32(data, dirSize); Put32(data, dirOffset);
+				Put16(data, 0);
+				numFiles = dir.size();
+
+				return Filesystem::WriteFile(path, &data[0], data.size());
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				const char* srcArchive = "/TestContent/Archives/Test1.zip";
+				const char* archive = "/TestContent/Archives/PreloadTest.zip";
+				ZipFile src;
+				if(!src.Init(Path(String(Filesystem::GetProgDir()) + srcArchive)))
+				{
+					LogE(String("Couldn't open ") + srcArchive + "!");
+					return false;
+				}
+				U32 numFiles = 0;
+				F64 expectedBytes = 0;
+				if(!writeArchive(src, Path(String(Filesystem::GetProgDir()) + archive), numFiles, expectedBytes))
+				{
+					LogE(String("Couldn't build ") + archive + "!");
+					return false;
+				}
+				src.End();
+				LogD(String("Built ") + archive + ": " + numFiles + " files, " + expectedBytes / (1024.0 * 1024.0) + " MB");
+
+				for(U32 numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2)
+				{
+					EditorResManager resMgr;
+					resMgr.SetNumDecodeThreads(numThreads);
+					if(!resMgr.Init(CACHE_SIZE_MB))
+					{
+						LogE("Couldn't init resource manager!");
+						return false;
+					}
+					game->Time().Tick();
+					I32 numLoaded = resMgr.Preload(String(archive) + ":*", onProgress);
+					game->Time().Tick();
+					F64 preloadMs = game->Time().ElapsedGameTime().ToMilliseconds();
+
+					//everything's cached now, so this just adds up the sizes.
+					ResGUID archGUID(archive, "");
+					F64 totalBytes = 0;
+					U32 numRes = resMgr.GetNumResourcesInArchive(archGUID);
+					for(U32 i = 0; i < numRes; ++i)
+					{
+						ResPtr res = resMgr.GetResourceFromIndex(archGUID, i);
+						if(res)
+						{
+							totalBytes += res->Size();
+						}
+					}
+					F64 mbPerSec = (totalBytes / (1024.0 * 1024.0)) / (preloadMs / 1000.0);
+					LogD(	String("Preloaded ") + numLoaded + " resources with " + numThreads + " threads in " +
+							preloadMs + " ms (" + mbPerSec + " MB/s)");
+					if(numLoaded != (I32)numFiles || totalBytes != expectedBytes)
+					{
+						LogE(String("Preloaded ") + numLoaded + "/" + numFiles + " files, " + totalBytes + "/" + expectedBytes + " bytes!");
+					}
+					resMgr.Shutdown();
+				}
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Repacks a ZIP archive into a pack, then compares the two formats:
+		load throughput, decompression speed, reading a small range of a big file,
+		and preloading through the resource manager.
+		*/
+		class PackArchiveTest : public TestBase
+		{
+		private:
+			static const U32 NUM_PASSES = 20;
+			static const U32 NUM_RANGE_READS = 1000;
+			static const U32 RANGE_SIZE = 4096;
+			static const U32 CACHE_SIZE_MB = 256;
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			static F64 mbPerSec(F64 bytes, F64 ms)
+			{
+				return (bytes / (1024.0 * 1024.0)) / (ms / 1000.0);
+			}
+			static void onProgress(I32 progress, bool& cancel) {}
+
+			bool buildPack(ZipFile& zip, const Path& packPath)
+			{
+				PackWriter writer;
+				for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+				{
+					FileSz size = zip.GetFileLen(i);
+					if(size == 0)
+					{
+						continue;
+					}
+					char* buf = CustomArrayNew<char>(size, TEST_ALLOC, "TestTempBufAlloc");
+					bool added = zip.ReadFile(i, buf) && writer.AddFile(zip.GetFilename(i), buf, size);
+					CustomArrayDelete(buf);
+					if(!added)
+					{
+						return false;
+					}
+				}
+				return writer.Write(packPath);
+			}
+
+			void compareLoads(Game* game, ZipFile& zip, PackFile& pack, char* buf)
+			{
+				F64 totalBytes = 0;
+				game->Time().Tick();
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+					{
+						zip.ReadFile(i, buf);
+						totalBytes += zip.GetFileLen(i);
+					}
+				}
+				F64 zipMs = stopTimer(game);
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					for(I32 i = 0; i < pack.GetNumFiles(); ++i)
+					{
+						pack.ReadFile(i, buf);
+					}
+				}
+				F64 packMs = stopTimer(game);
+				LogD(	String("Load: ZIP ") + mbPerSec(totalBytes, zipMs) + " MB/s, pack " +
+						mbPerSec(totalBytes, packMs) + " MB/s");
+			}
+
+			//Times only the decompression, from data that's already in memory.
+			void compareDecompression(Game* game, ZipFile& zip, PackFile& pack, char* buf)
+			{
+				F64 zipBytes = 0, packBytes = 0;
+				F64 zipMs = 0, packMs = 0;
+				for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+				{
+					if(zip.GetCompression(i) != COMP_DEFLATE)
+					{
+						continue;
+					}
+					char* packed = CustomArrayNew<char>(zip.GetCompressedLen(i), TEST_ALLOC, "TestTempBufAlloc");
+					zip.ReadCompressedFile(i, packed);
+					game->Time().Tick();
+					for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+					{
+						DecompDeflateBuf(packed, zip.GetCompressedLen(i), buf, zip.GetFileLen(i));
+					}
+					zipMs += stopTimer(game);
+					zipBytes += (F64)zip.GetFileLen(i) * NUM_PASSES;
+					CustomArrayDelete(packed);
+				}
+				for(I32 i = 0; i < pack.GetNumFiles(); ++i)
+				{
+					if(pack.GetCompression(i) != PACK_COMP_LZ)
+					{
+						continue;
+					}
+					char* packed = CustomArrayNew<char>(pack.GetPackedLen(i), TEST_ALLOC, "TestTempBufAlloc");
+					pack.ReadPackedFile(i, packed);
+					game->Time().Tick();
+					for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+					{
+						pack.UnpackFile(i, packed, pack.GetPackedLen(i), buf);
+					}
+					packMs += stopTimer(game);
+					packBytes += (F64)pack.GetFileLen(i) * NUM_PASSES;
+					CustomArrayDelete(packed);
+				}
+				LogD(	String("Decompression: DEFLATE ") + mbPerSec(zipBytes, zipMs) + " MB/s, LZ " +
+						mbPerSec(packBytes, packMs) + " MB/s");
+			}
+
+			//ZIP has to inflate the whole file to get at any of it;
+			//the pack only decompresses the chunk the range is in.
+			void compareRangeReads(Game* game, ZipFile& zip, PackFile& pack, char* buf)
+			{
+				I32 largest = -1;
+				for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+				{
+					if(zip.GetCompression(i) == COMP_DEFLATE && (largest < 0 || zip.GetFileLen(i) > zip.GetFileLen(largest)))
+					{
+						largest = i;
+					}
+				}
+				if(largest < 0)
+				{
+					LogD("No compressed files to read ranges from");
+					return;
+				}
+				FileSz size = zip.GetFileLen(largest);
+				I32 packIdx = pack.Find(zip.GetFilename(largest));
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_RANGE_READS; ++i)
+				{
+					zip.ReadFile(largest, buf);
+				}
+				F64 zipMs = stopTimer(game);
+				for(U32 i = 0; i < NUM_RANGE_READS; ++i)
+				{
+					pack.ReadRange(packIdx, Random::InRange(0, (I32)size - 1), RANGE_SIZE, buf);
+				}
+				F64 packMs = stopTimer(game);
+				LogD(	String("Reading ") + (U32)RANGE_SIZE + " bytes from a " + size + " byte file: ZIP " +
+						(zipMs / NUM_RANGE_READS) + " ms, pack " + (packMs / NUM_RANGE_READS) + " ms");
+			}
+
+			void comparePreloads(Game* game, const char* zipArchive, const char* packArchive)
+			{
+				const char* archives[] = { zipArchive, packArchive };
+				for(U32 i = 0; i < 2; ++i)
+				{
+					EditorResManager resMgr;
+					if(!resMgr.Init(CACHE_SIZE_MB))
+					{
+						LogE("Couldn't init resource manager!");
+						return;
+					}
+					game->Time().Tick();
+					I32 numLoaded = resMgr.Preload(String(archives[i]) + ":*", onProgress);
+					F64 preloadMs = stopTimer(game);
+					LogD(String("Preloaded ") + numLoaded + " resources from " + archives[i] + " in " + preloadMs + " ms");
+					resMgr.Shutdown();
+				}
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				const char* zipArchive = "/TestContent/Archives/Test1.zip";
+				const char* packArchive = "/TestContent/Archives/Test1.lpak";
+				ZipFile zip;
+				PackFile pack;
+				if(!zip.Init(Path(String(Filesystem::GetProgDir()) + zipArchive)))
+				{
+					LogE(String("Couldn't open ") + zipArchive + "!");
+					return false;
+				}
+				Path packPath(String(Filesystem::GetProgDir()) + packArchive);
+				if(!buildPack(zip, packPath) || !pack.Init(packPath))
+				{
+					LogE(String("Couldn't build ") + packArchive + "!");
+					return false;
+				}
+				FileSz largest = 0;
+				for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+				{
+					largest = Math::Max(largest, zip.GetFileLen(i));
+				}
+				char* buf = CustomArrayNew<char>(Math::Max(largest, (FileSz)RANGE_SIZE), TEST_ALLOC, "TestTempBufAlloc");
+				compareLoads(game, zip, pack, buf);
+				compareDecompression(game, zip, pack, buf);
+				compareRangeReads(game, zip, pack, buf);
+				CustomArrayDelete(buf);
+				comparePreloads(game, zipArchive, packArchive);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+		class ZipIndexTest : public TestBase
+		{
+		private:
+			static const U32 NUM_FILES = 120000;
+			static const U32 NUM_DIRS = 500;
+			static const U32 NUM_INIT_PASSES = 10;
+			static const U32 NUM_MISSES = 100000;
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			static String fileName(U32 i)
+			{
+				char buf[64];
+				sprintf(buf, "Assets/Dir%03u/Mesh_%06u.lmdl", i % NUM_DIRS, i);
+				return String(buf);
+			}
+
+			//Writes a ZIP of empty, stored files.
+			//There's more than 65535 of them, so it needs the ZIP64 directory records.
+			bool writeArchive(const Path& path)
+			{
+				Vector<char> data;
+				Vector<U32> localOffsets;
+				for(U32 i = 0; i < NUM_FILES; ++i)
+				{
+					String name = fileName(i);
+					localOffsets.push_back(data.size());
+					Put32(data, 0x04034b50);
+					//version, flags, compression, time, date.
+					Put16(data, 10); Put16(data, 0); Put16(data, 0); Put16(data, 0); Put16(data, 0);
+					//CRC and sizes; all 0 for an empty file.
+					Put32(data, 0); Put32(data, 0); Put32(data, 0);
+					Put16(data, (U16)name.length()); Put16(data, 0);
+					data.insert(data.end(), name.begin(), name.end());
+				}
+				U32 dirOffset = data.size();
+				for(U32 i = 0; i < NUM_FILES; ++i)
+				{
+					String name = fileName(i);
+					Put32(data, 0x02014b50);
+					//version made, version needed, flags, compression, time, date.
+					Put16(data, 20); Put16(data, 10); Put16(data, 0); Put16(data, 0); Put16(data, 0); Put16(data, 0);
+					Put32(data, 0); Put32(data, 0); Put32(data, 0);
+					//name, extra and comment lengths, disk, attributes.
+					Put16(data, (U16)name.length()); Put16(data, 0); Put16(data, 0); Put16(data, 0); Put16(data, 0);
+					Put32(data, 0);
+					Put32(data, localOffsets[i]);
+					data.insert(data.end(), name.begin(), name.end());
+				}
+				U32 dirSize = data.size() - dirOffset;
+				U32 zip64Offset = data.size();
+				Put32(data, 0x06064b50);
+				Put64(data, 44);
+				Put16(data, 45); Put16(data, 45);
+				Put32(data, 0); Put32(data, 0);
+				Put64(data, NUM_FILES); Put64(data, NUM_FILES);
+				Put64(data, dirSize); Put64(data, dirOffset);
+				Put32(data, 0x07064b50);
+				Put32(data, 0);
+				Put64(data, zip64Offset);
+				Put32(data, 1);
+				Put32(data, 0x06054b50);
+				Put16(data, 0); Put16(data, 0);
+				//too many files for the old header; the ZIP64 header has the real count.
+				Put16(data, 0xFFFF); Put16(data, 0xFFFF);
+				Put32(data, dirSize); Put32(data, dirOffset);
+				Put16(data, 0);
+
+				return Filesystem::WriteFile(path, &data[0], data.size());
+			}
+
+			void timeInit(Game* game, const Path& path, bool allowMapping)
+			{
+				game->Time().Tick();
+				for(U32 pass = 0; pass < NUM_INIT_PASSES; ++pass)
+				{
+					ZipFile zip;
+					zip.Init(path, allowMapping);
+				}
+				F64 initMs = stopTimer(game) / NUM_INIT_PASSES;
+				LogD(String("Init (") + (allowMapping ? "mapped" : "unmapped") + "): " + initMs + " ms");
+			}
+
+			//Compares against the old index, a map of lowercased copies of each name.
+			void timeFind(Game* game, ZipFile& zip)
+			{
+				Vector<String> names;
+				Vector<I32> expected;
+				for(U32 i = 0; i < NUM_FILES; ++i)
+				{
+					names.push_back(fileName(i));
+					expected.push_back(i);
+				}
+				//shuffle, so the lookups don't walk the directory in order.
+				for(U32 i = NUM_FILES - 1; i > 0; --i)
+				{
+					U32 j = (U32)Random::InRange((I32)0, (I32)i);
+					std::swap(names[i], names[j]);
+					std::swap(expected[i], expected[j]);
+				}
+
+				game->Time().Tick();
+				Map<String, I32> oldIndex;
+				for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+				{
+					oldIndex[ToLower(zip.GetFilename(i))] = i;
+				}
+				F64 oldBuildMs = stopTimer(game);
+				U32 numBad = 0;
+				for(U32 i = 0; i < NUM_FILES; ++i)
+				{
+					if(oldIndex[ToLower(names[i])] != expected[i])
+					{
+						++numBad;
+					}
+				}
+				F64 oldFindMs = stopTimer(game);
+				for(U32 i = 0; i < NUM_FILES; ++i)
+				{
+					if(zip.Find(names[i].c_str()) != expected[i])
+					{
+						++numBad;
+					}
+				}
+				F64 findMs = stopTimer(game);
+				for(U32 i = 0; i < NUM_MISSES; ++i)
+				{
+					if(zip.Find("Assets/Missing/Mesh.lmdl") != -1)
+					{
+						++numBad;
+					}
+				}
+				F64 missMs = stopTimer(game);
+				LogD(String("Old index: ") + oldBuildMs + " ms to build, " + (oldFindMs * 1000000.0 / NUM_FILES) + " ns per lookup");
+				LogD(	String("Find: ") + (findMs * 1000000.0 / NUM_FILES) + " ns per hit, " +
+						(missMs * 1000000.0 / NUM_MISSES) + " ns per miss, " + numBad + " wrong results");
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Path path(String(Filesystem::GetProgDir()) + "/TestContent/Archives/ManyFiles.zip");
+				if(!writeArchive(path))
+				{
+					LogE("Couldn't write test archive!");
+					return false;
+				}
+				timeInit(game, path, true);
+				timeInit(game, path, false);
+				ZipFile zip;
+				if(!zip.Init(path) || zip.GetNumFiles() != (I32)NUM_FILES)
+				{
+					LogE("Test archive didn't open correctly!");
+					return false;
+				}
+				timeFind(game, zip);
+				zip.End();
+				Filesystem::RemoveFile(path);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+		class StreamingTest : public TestBase
+		{
+		private:
+			static const U32 CACHE_SIZE_MB = 16;
+			static const U32 NUM_PASSES = 8;
+			static const U32 PIECE_SIZE = 1024;
+			static const U32 CHUNK_SIZE = 16 * 1024;
+
+			//Wraps a stream, and makes each read take as long as it would on slow storage.
+			class SlowDataStream : public DataStream
+			{
+			private:
+				DataStream* file;
+				U32 latencyUs;
+				U32 bytesPerUs;
+			public:
+				SlowDataStream(DataStream* fileParam, U32 latencyUsParam, U32 mbPerSec) :
+					file(fileParam), latencyUs(latencyUsParam), bytesPerUs(Math::Max(mbPerSec, (U32)1)) {}
+				~SlowDataStream() { Filesystem::CloseFile(file); }
+				bool Open(const char* path, StreamFlag flags) { return false; }
+				bool DoAsync(AsyncRequest asyncType, char* buffer, FileSz bufSz, IAsyncCallback* asyncCallback) { return false; }
+				bool Close() { return true; }
+				FileSz FileSize() { return file->FileSize(); }
+				FileSz Write(const char* buffer, FileSz size) { return 0; }
+				FileSz Write(const char* buffer) { return 0; }
+				FileSz WriteLine(const char* line = "") { return 0; }
+				FileSz Read(char* buffer, FileSz size)
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(latencyUs + size / bytesPerUs));
+					return file->Read(buffer, size);
+				}
+				FileSz WritePos() { return 0; }
+				FileSz ReadPos() { return file->ReadPos(); }
+				char* ReadAll() { return NULL; }
+				FileSz Seek(FileSz position) { return file->Seek(position); }
+			};
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			//Stands in for decoding what was read.
+			static void work(U32 us)
+			{
+				std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now() + std::chrono::microseconds(us);
+				while(std::chrono::high_resolution_clock::now() < end)
+				{
+				}
+			}
+
+			bool checkZipStream(ZipFile& zip, I32 fileIndex, const char* expected, const char* label)
+			{
+				FileSz len = zip.GetFileLen(fileIndex);
+				char* buf = CustomArrayNew<char>(len + PIECE_SIZE, TEST_ALLOC, "TestTempBufAlloc");
+				ZipStream* stream = zip.GetStream(fileIndex, CHUNK_SIZE);
+				bool matched = stream != NULL;
+				//twice, to check restarting the stream.
+				for(U32 pass = 0; pass < 2 && matched; ++pass)
+				{
+					stream->Seek(0);
+					FileSz pos = 0, bytesRead = 0;
+					while((bytesRead = stream->Read((U8*)buf + pos, PIECE_SIZE)) > 0)
+					{
+						pos += bytesRead;
+					}
+					matched = pos == len && memcmp(buf, expected, len) == 0;
+				}
+				LogD(String(label) + " stream " + (matched ? "matches" : "DOESN'T match") + " the file" +
+					(stream ? String(", ") + stream->NumStalls() + " stalls" : String("")));
+				LDelete(stream);
+				CustomArrayDelete(buf);
+				return matched;
+			}
+
+			bool checkStreamingResource(const char* guid, const char* expected, FileSz len)
+			{
+				EditorResManager resMgr;
+				if(!resMgr.Init(CACHE_SIZE_MB))
+				{
+					LogE("Couldn't init resource manager!");
+					return false;
+				}
+				std::shared_ptr<StreamingResource> stream = resMgr.GetStreamingResource(ResGUID(guid));
+				bool matched = stream && stream->Size() == len;
+				if(matched)
+				{
+					char* buf = CustomArrayNew<char>(len, TEST_ALLOC, "TestTempBufAlloc");
+					FileSz pos = 0, bytesRead = 0;
+					while((bytesRead = stream->Read(buf + pos, PIECE_SIZE)) > 0)
+					{
+						pos += bytesRead;
+					}
+					matched = pos == len && memcmp(buf, expected, len) == 0;
+					//seek back into the middle and reread the rest.
+					FileSz mid = len / 2;
+					matched = matched && stream->Seek(mid) == mid && stream->Read(buf, len) == len - mid && memcmp(buf, expected + mid, len - mid) == 0;
+					CustomArrayDelete(buf);
+				}
+				LogD(String("Streaming resource ") + (matched ? "matches" : "DOESN'T match") + " the file");
+				stream.reset();
+				resMgr.Shutdown();
+				return matched;
+			}
+
+			//Reads a file PIECE_SIZE bytes at a time, doing workUs of work on each piece,
+			//first reading each chunk from slow storage only once it's needed, then reading ahead.
+			void benchmark(Game* game, const Path& path, U32 workUs)
+			{
+				const U32 LATENCY_US = 1000;
+				const U32 MB_PER_SEC = 40;
+				char piece[PIECE_SIZE];
+				char* chunk = CustomArrayNew<char>(CHUNK_SIZE, TEST_ALLOC, "TestTempBufAlloc");
+				SlowDataStream slowFile(Filesystem::OpenFileReadOnly(path), LATENCY_US, MB_PER_SEC);
+				FileSz fileSz = slowFile.FileSize();
+
+				U32 numReads = 0;
+				game->Time().Tick();
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					slowFile.Seek(0);
+					FileSz chunkLeft = 0, done = 0;
+					while(done < fileSz)
+					{
+						if(chunkLeft == 0)
+						{
+							chunkLeft = slowFile.Read(chunk, CHUNK_SIZE);
+						}
+						FileSz pieceSz = Math::Min(chunkLeft, (FileSz)PIECE_SIZE);
+						chunkLeft -= pieceSz;
+						done += pieceSz;
+						++numReads;
+						work(workUs);
+					}
+				}
+				F64 syncMs = stopTimer(game);
+
+				SlowDataStream* slowAhead = LNew(SlowDataStream, TEST_ALLOC, "TestAlloc")(Filesystem::OpenFileReadOnly(path), LATENCY_US, MB_PER_SEC);
+				ReadAheadStream* readAhead = LNew(ReadAheadStream, TEST_ALLOC, "TestAlloc")(slowAhead, 0, fileSz, false, CHUNK_SIZE);
+				game->Time().Tick();
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					readAhead->Seek(0);
+					while(readAhead->Read(piece, PIECE_SIZE) > 0)
+					{
+						work(workUs);
+					}
+				}
+				F64 aheadMs = stopTimer(game);
+				LogD(	String("With ") + workUs + " us of work per read: " +
+						(numReads * 1000.0 / syncMs) + " reads/sec without read-ahead, " +
+						(numReads * 1000.0 / aheadMs) + " with it (" + readAhead->NumStalls() + " stalls in " + numReads + " reads)");
+				LDelete(readAhead);
+				LDelete(slowAhead);
+				CustomArrayDelete(chunk);
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				const char* archive = "/TestContent/Sounds/Sounds.zip";
+				Path archPath(String(Filesystem::GetProgDir()) + archive);
+				for(U32 i = 0; i < 2; ++i)
+				{
+					bool mapped = i == 0;
+					ZipFile zip;
+					if(!zip.Init(archPath, mapped))
+					{
+						LogE(String("Couldn't open ") + archive + "!");
+						return false;
+					}
+					I32 fileIndex = zip.Find("hi.ogg");
+					FileSz len = zip.GetFileLen(fileIndex);
+					char* expected = CustomArrayNew<char>(len, TEST_ALLOC, "TestTempBufAlloc");
+					zip.ReadFile(fileIndex, expected);
+					checkZipStream(zip, fileIndex, expected, mapped ? "Mapped" : "Unmapped");
+					if(mapped)
+					{
+						checkStreamingResource((String(archive) + ":hi.ogg").c_str(), expected, len);
+					}
+					CustomArrayDelete(expected);
+				}
+				//the consumer outrunning the disk, then the disk outrunning the consumer.
+				benchmark(game, archPath, 100);
+				benchmark(game, archPath, 500);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+#ifdef __linux__
+		//Writes a file through LinuxAsyncDataStream, checks random reads of it with both backends,
+		//then measures how random read throughput scales with the number of reads in flight.
+		class AsyncIOTest : public TestBase
+		{
+		private:
+			static const U32 FILE_SIZE_MB = 64;
+			static const U32 READ_SIZE = 4096;
+			static const U32 NUM_READS = 4096;
+
+			//Collects finished reads for the thread that issued them.
+			struct Completions
+			{
+				Mutex Lock;
+				std::condition_variable Ready;
+				Vector<U32> Done;
+				U32 NumBad;
+			};
+			//One per read in flight. Each is reused for the next read once its last one's done.
+			class ReadSlot : public IAsyncCallback
+			{
+			public:
+				Completions* Owner;
+				U32 Index;
+				char* Buffer;
+				FileSz Offset;
+				FileSz BytesRead;
+				void OnStreamOpen() {}
+				void OnStreamClose() {}
+				void OnChunkRead(FileSz bytesRead) { BytesRead = bytesRead; }
+				void OnChunkWritten(FileSz bytesWritten) {}
+				void OnReadEnd()
+				{
+					//every word in the file holds its own offset.
+					bool matched = BytesRead == READ_SIZE && *(U32*)Buffer == Offset;
+					finish(matched);
+				}
+				void OnWriteEnd() {}
+				void OnError() { finish(false); }
+				void finish(bool matched)
+				{
+					{
+						std::lock_guard<std::mutex> lock(Owner->Lock.GetMutex());
+						Owner->NumBad += matched ? 0 : 1;
+						Owner->Done.push_back(Index);
+					}
+					Owner->Ready.notify_one();
+				}
+			};
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+
+			//Flushes the file and drops it from the page cache,
+			//so reads have to go to the disk.
+			static void dropCache(const Path& path)
+			{
+				int fd = open(path.ToString().c_str(), O_RDONLY);
+				if(fd >= 0)
+				{
+					fdatasync(fd);
+					posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+					close(fd);
+				}
+			}
+
+			bool writeFile(const Path& path)
+			{
+				const U32 BLOCK_SIZE = 1024 * 1024;
+				LinuxAsyncDataStream file;
+				if(!file.Open(path.ToString().c_str(), StreamFlags::ReadWrite))
+				{
+					LogE(String("Couldn't open ") + path.ToString() + "!");
+					return false;
+				}
+				U32* data = CustomArrayNew<U32>(FILE_SIZE_MB * BLOCK_SIZE / sizeof(U32), TEST_ALLOC, "TestTempBufAlloc");
+				for(U32 i = 0; i < FILE_SIZE_MB * BLOCK_SIZE / sizeof(U32); ++i)
+				{
+					data[i] = i * sizeof(U32);
+				}
+				for(U32 i = 0; i < FILE_SIZE_MB; ++i)
+				{
+					file.WriteAsync((const char*)data + i * BLOCK_SIZE, i * BLOCK_SIZE, BLOCK_SIZE, NULL);
+				}
+				file.WaitForAll();
+				bool written = file.FileSize() == FILE_SIZE_MB * BLOCK_SIZE;
+				file.Close();
+				CustomArrayDelete(data);
+				return written;
+			}
+
+			void issueRead(LinuxAsyncDataStream& file, ReadSlot& slot, Completions& completions, U32 index, char* buffers, U32 numBlocks)
+			{
+				slot.Owner = &completions;
+				slot.Index = index;
+				slot.Buffer = buffers + index * READ_SIZE;
+				slot.Offset = (FileSz)Random::InRange((I32)0, (I32)(numBlocks - 1)) * READ_SIZE;
+				slot.BytesRead = 0;
+				//a read that couldn't be submitted won't call back, so finish it here as a bad read.
+				if(!file.ReadAsync(slot.Buffer, slot.Offset, READ_SIZE, &slot))
+				{
+					slot.finish(false);
+				}
+			}
+
+			//Does NUM_READS random reads, keeping queueDepth of them in flight.
+			//@return reads per second, or 0 if any read came back wrong.
+			F64 randomReads(Game* game, const Path& path, bool useUring, U32 queueDepth)
+			{
+				dropCache(path);
+				LinuxAsyncDataStream file(queueDepth, useUring);
+				if(!file.Open(path.ToString().c_str(), StreamFlags::Read) || file.UsesUring() != useUring)
+				{
+					return 0;
+				}
+				U32 numBlocks = file.FileSize() / READ_SIZE;
+				Completions completions;
+				completions.NumBad = 0;
+				char* buffers = CustomArrayNew<char>(queueDepth * READ_SIZE, TEST_ALLOC, "TestTempBufAlloc");
+				Vector<ReadSlot> slots;
+				slots.resize(queueDepth);
+
+				game->Time().Tick();
+				U32 numIssued = 0, numFinished = 0;
+				for(U32 i = 0; i < queueDepth && numIssued < NUM_READS; ++i, ++numIssued)
+				{
+					issueRead(file, slots[i], completions, i, buffers, numBlocks);
+				}
+				while(numFinished < NUM_READS)
+				{
+					Vector<U32> done;
+					{
+						std::unique_lock<std::mutex> lock(completions.Lock.GetMutex());
+						while(completions.Done.empty())
+						{
+							completions.Ready.wait(lock);
+						}
+						done.swap(completions.Done);
+					}
+					numFinished += done.size();
+					//refill the slots that just finished.
+					for(U32 i = 0; i < done.size() && numIssued < NUM_READS; ++i, ++numIssued)
+					{
+						issueRead(file, slots[done[i]], completions, done[i], buffers, numBlocks);
+					}
+				}
+				F64 ms = stopTimer(game);
+				file.Close();
+				CustomArrayDelete(buffers);
+				return completions.NumBad == 0 ? NUM_READS * 1000.0 / ms : 0;
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Path path(String(Filesystem::GetProgDir()) + "/AsyncIOTest.bin");
+				if(!writeFile(path))
+				{
+					LogE("Couldn't write the test file!");
+					Filesystem::RemoveFile(path);
+					return false;
+				}
+				const U32 depths[] = { 1, 4, 16, 64 };
+				for(U32 backend = 0; backend < 2; ++backend)
+				{
+					bool useUring = backend == 0;
+					String results;
+					for(U32 i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i)
+					{
+						F64 readsPerSec = randomReads(game, path, useUring, depths[i]);
+						if(readsPerSec == 0)
+						{
+							LogW(String(useUring ? "io_uring" : "Thread pool") + " reads at depth " + depths[i] +
+								" failed or came back wrong!");
+						}
+						results += String(" ") + depths[i] + ": " + readsPerSec;
+					}
+					LogD(String(useUring ? "io_uring" : "Thread pool") + " random " + READ_SIZE + " byte reads/sec by queue depth -" + results);
+				}
+				Filesystem::RemoveFile(path);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+#endif //__linux__
+
+		/**
+		Times the draw loop's handle traffic with resource handles against the shared_ptrs they replaced:
+		each frame, every visible mesh copies the handles to its two textures and reads through them.
+		Also counts the allocations made creating the handles and running the loop,
+		and checks that eviction leaves resources that are still in use alone.
+		*/
+		class ResHandleTest : public TestBase
+		{
+		private:
+			static const U32 NUM_RESOURCES = 20000;
+			static const U32 NUM_VISIBLE = 2000;
+			static const U32 SCROLL_PER_FRAME = 50;
+			static const U32 NUM_FRAMES = 200;
+			//sizes for the eviction check; the cache's 1 MB.
+			static const U32 EVICT_RES_SIZE = 64 * 1024;
+			static const U32 NUM_EVICT_RESOURCES = 64;
+
+			//Mapped resources don't own their buffers, so every resource can share one.
+			char dummyBuf[16];
+
+			template<typename ptrT>
+			U32 drawFrame(U32 frame, const Vector<ptrT>& textures)
+			{
+				U32 sum = 0;
+				U32 numMeshes = NUM_RESOURCES / 2;
+				U32 firstVisible = (frame * SCROLL_PER_FRAME) % numMeshes;
+				for(U32 i = 0; i < NUM_VISIBLE; ++i)
+				{
+					U32 mesh = (firstVisible + i) % numMeshes;
+					ptrT diffuse = textures[2*mesh];
+					ptrT specular = textures[2*mesh + 1];
+					sum += diffuse->Buffer()[0] + specular->Buffer()[0] + (U32)diffuse->Size();
+				}
+				return sum;
+			}
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				BenchResManager resMgr;
+				if(!resMgr.Init(1))
+				{
+					LogE("Couldn't init resource manager!");
+					return false;
+				}
+				memset(dummyBuf, 0, sizeof(dummyBuf));
+				Vector<ResGUID> guids;
+				guids.reserve(NUM_RESOURCES);
+				for(U32 i = 0; i < NUM_RESOURCES; ++i)
+				{
+					guids.push_back(ResGUID("bench.zip", String("textures/tex") + i + ".png"));
+				}
+
+				//Before: shared_ptrs, with their control blocks going through the engine allocator so they're counted.
+				Vector<std::shared_ptr<Resource>> oldPtrs;
+				oldPtrs.reserve(NUM_RESOURCES);
+				U64 allocsBefore = Allocator::NumAllocations();
+				for(U32 i = 0; i < NUM_RESOURCES; ++i)
+				{
+					Resource* res = CustomNew<MappedResource>(RESFILE_ALLOC, "ResAlloc", guids[i], dummyBuf, (FileSz)1, resMgr.Handle());
+					oldPtrs.push_back(std::shared_ptr<Resource>(res, STLDeleter<Resource>(), STLAllocHook<Resource>()));
+				}
+				U64 oldCreateAllocs = Allocator::NumAllocations() - allocsBefore;
+				U32 oldSum = 0;
+				allocsBefore = Allocator::NumAllocations();
+				game->Time().Tick();
+				for(U32 frame = 0; frame < NUM_FRAMES; ++frame)
+				{
+					oldSum += drawFrame(frame, oldPtrs);
+				}
+				F64 oldMs = stopTimer(game) / NUM_FRAMES;
+				U64 oldLoopAllocs = Allocator::NumAllocations() - allocsBefore;
+				oldPtrs.clear();
+
+				//After: handles into the resource table.
+				Vector<ResPtr> newPtrs;
+				newPtrs.reserve(NUM_RESOURCES);
+				allocsBefore = Allocator::NumAllocations();
+				for(U32 i = 0; i < NUM_RESOURCES; ++i)
+				{
+					newPtrs.push_back(ResPtr(CustomNew<MappedResource>(RESFILE_ALLOC, "ResAlloc", guids[i], dummyBuf, (FileSz)1, resMgr.Handle())));
+				}
+				U64 newCreateAllocs = Allocator::NumAllocations() - allocsBefore;
+				U32 newSum = 0;
+				allocsBefore = Allocator::NumAllocations();
+				game->Time().Tick();
+				for(U32 frame = 0; frame < NUM_FRAMES; ++frame)
+				{
+					newSum += drawFrame(frame, newPtrs);
+				}
+				F64 newMs = stopTimer(game) / NUM_FRAMES;
+				U64 newLoopAllocs = Allocator::NumAllocations() - allocsBefore;
+				newPtrs.clear();
+
+				LogD(String("Handle copies per frame: ") + (NUM_VISIBLE * 2) + "; checksums: old " + oldSum + ", new " + newSum);
+				if(oldSum != newSum)
+				{
+					LogE("Handles read different data than shared_ptrs!");
+				}
+				LogD(String("Per frame: shared_ptr ") + oldMs + " ms, handle " + newMs + " ms (" + (oldMs / newMs) + "x)");
+				LogD(String("Allocations creating ") + NUM_RESOURCES + " handles: shared_ptr " + (U32)oldCreateAllocs + ", handle " + (U32)newCreateAllocs);
+				LogD(String("Allocations in the draw loop: shared_ptr ") + (U32)oldLoopAllocs + ", handle " + (U32)newLoopAllocs);
+				LogD(String("Resources left in the table: ") + ResTable::NumResources());
+
+				//Hold onto the first resource, then overfill the cache;
+				//it should still be cached afterwards, since evicting it frees nothing.
+				ResGUID pinnedGUID("bench.zip", "textures/pinned.png");
+				if(!resMgr.AddDummyResource(pinnedGUID, EVICT_RES_SIZE))
+				{
+					LogE("Couldn't add pinned resource!");
+					resMgr.Shutdown();
+					return false;
+				}
+				ResPtr pinned = resMgr.Get(pinnedGUID);
+				U32 numAdded = 0;
+				for(U32 i = 0; i < NUM_EVICT_RESOURCES; ++i)
+				{
+					numAdded += resMgr.AddDummyResource(ResGUID("bench.zip", String("textures/evict") + i + ".png"), EVICT_RES_SIZE) ? 1 : 0;
+				}
+				ResPtr stillCached = resMgr.Get(pinnedGUID);
+				bool stayedCached = stillCached && stillCached == pinned;
+				LogD(String("Added ") + numAdded + "/" + NUM_EVICT_RESOURCES + " resources to a full cache; pinned resource " +
+					(stayedCached ? "stayed cached" : "was evicted") + ", use count " + pinned.UseCount());
+				//everything but the pinned resource can be evicted, so there's always room.
+				if(!stayedCached)
+				{
+					LogE("Pinned resource was evicted!");
+				}
+				if(numAdded != NUM_EVICT_RESOURCES)
+				{
+					LogE("Eviction didn't make room for new resources!");
+				}
+				stillCached.reset();
+				pinned.reset();
+				resMgr.Shutdown();
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Runs a memory constrained cache through a frame loop that thrashes plain LRU:
+		every frame uses the same set of textures, interleaved with one-off resources
+		that are never used again, and the two together are more than the cache holds.
+		Compares plain LRU against cost-aware eviction, per frame pinning, and a budget for the one-offs,
+		reporting the stats the cache exports to StatMonitor.
+		*/
+		class ResCacheBudgetTest : public TestBase
+		{
+		private:
+			static const U32 CACHE_SIZE_MB = 4;
+			static const U32 RES_SIZE = 64 * 1024;
+			static const U32 NUM_TEXTURES = 40;
+			static const U32 NUM_ONE_OFFS = 32;
+			static const U32 NUM_FRAMES = 100;
+			//reload costs, in microseconds; textures have to be decoded, the one-offs are just read.
+			static const U32 TEXTURE_COST = 3000;
+			static const U32 ONE_OFF_COST = 1300;
+
+			enum Mode
+			{
+				PLAIN_LRU,
+				COST_AWARE,
+				PINNED,
+				BUDGETED,
+				MODE_LEN
+			};
+
+			//Stands in for a real loader; the resource's just its raw data.
+			class DummyLoader : public IResourceLoader
+			{
+			private:
+				String pattern;
+				ResCategory category;
+			public:
+				DummyLoader(const String& patternParam, ResCategory categoryParam) : pattern(patternParam), category(categoryParam) {}
+				String GetPattern() { return pattern; }
+				bool UseRawResource() { return false; }
+				FileSz GetLoadedResSize(char* rawBuf, FileSz rawSize) { return rawSize; }
+				bool LoadResource(char* rawBuf, FileSz rawSize, Resource* resource) { return true; }
+				ResCategory GetCategory() { return category; }
+			};
+
+			//Loads misses from a dummy buffer instead of an archive,
+			//and gives each category a fixed reload cost, so runs are repeatable.
+			class BudgetResManager : public BenchResManager
+			{
+			protected:
+				bool openResource(const ResGUID& resGUID, char** outRawBuf, FileSz* outRawSize, bool useRawResource)
+				{
+					++NumLoads;
+					*outRawSize = RES_SIZE;
+					*outRawBuf =	useRawResource ?
+									allocate(RES_SIZE, categoryOf(resGUID)) :
+									CustomArrayNew<char>(RES_SIZE, RESFILE_ALLOC, "TempBufAlloc");
+					return *outRawBuf != NULL;
+				}
+				F32 reloadCost(const ResGUID& resGUID, FileSz rawSize, F32 decodeUs)
+				{
+					return categoryOf(resGUID) == TEXTURE_RES ? TextureCost : OneOffCost;
+				}
+			public:
+				F32 TextureCost;
+				F32 OneOffCost;
+				U32 NumLoads;
+				BudgetResManager(F32 textureCost, F32 oneOffCost) : TextureCost(textureCost), OneOffCost(oneOffCost), NumLoads(0) {}
+			};
+
+			static const char* modeName(U32 mode)
+			{
+				switch(mode)
+				{
+				case PLAIN_LRU:
+					return "Plain LRU";
+				case COST_AWARE:
+					return "Cost-aware";
+				case PINNED:
+					return "Cost-aware + frame pinning";
+				default:
+					return "Pinning + one-off budget";
+				}
+			}
+
+			void runMode(U32 mode, Game* game)
+			{
+				//with every cost the same, eviction's plain LRU.
+				bool useCosts = mode != PLAIN_LRU;
+				BudgetResManager resMgr(useCosts ? (F32)TEXTURE_COST : 0, useCosts ? (F32)ONE_OFF_COST : 0);
+				if(!resMgr.Init(CACHE_SIZE_MB))
+				{
+					LogE("Couldn't init resource manager!");
+					return;
+				}
+				resMgr.RegisterLoader(GetSharedPtr(CustomNew<DummyLoader>(RESLOADER_ALLOC, "ResLoaderAlloc", "textures/*", TEXTURE_RES)));
+				resMgr.RegisterLoader(GetSharedPtr(CustomNew<DummyLoader>(RESLOADER_ALLOC, "ResLoaderAlloc", "oneoffs/*", OTHER_RES)));
+				if(mode == BUDGETED)
+				{
+					resMgr.SetCategoryBudget(OTHER_RES, CACHE_SIZE_MB * 1024 * 1024 - NUM_TEXTURES * RES_SIZE);
+				}
+				Vector<ResGUID> textures;
+				for(U32 i = 0; i < NUM_TEXTURES; ++i)
+				{
+					textures.push_back(ResGUID("bench.zip", String("textures/tex") + i + ".png"));
+				}
+
+				ResCacheStats::Reset();
+				U32 textureMisses = 0;
+				U32 failedLoads = 0;
+				U32 numOneOffs = 0;
+				U32 usesPerFrame = NUM_TEXTURES + NUM_ONE_OFFS;
+				game->Time().Tick();
+				for(U32 frame = 0; frame < NUM_FRAMES; ++frame)
+				{
+					if(mode == PINNED || mode == BUDGETED)
+					{
+						resMgr.BeginFrame();
+					}
+					U32 nextTexture = 0;
+					for(U32 i = 0; i < usesPerFrame; ++i)
+					{
+						U32 loadsBefore = resMgr.NumLoads;
+						bool loaded;
+						//5 textures to every 4 one-offs.
+						if(i % 9 < 5)
+						{
+							loaded = (bool)resMgr.GetResource(textures[nextTexture++]);
+							//the first frame has to load everything.
+							textureMisses += (resMgr.NumLoads != loadsBefore && frame > 0) ? 1 : 0;
+						}
+						else
+						{
+							ResGUID oneOff("bench.zip", String("oneoffs/res") + numOneOffs++ + ".dat");
+							loaded = (bool)resMgr.GetResource(oneOff);
+						}
+						failedLoads += loaded ? 0 : 1;
+					}
+				}
+				F64 frameMs = stopTimer(game) / NUM_FRAMES;
+
+				LogD(String(modeName(mode)) + ":");
+				LogD(String("\tHit rate: ") + (ResCacheStats::HitRate() * 100) + "%; texture misses after the first frame: " + textureMisses +
+					"/" + (NUM_TEXTURES * (NUM_FRAMES - 1)));
+				LogD(String("\tEvictions: ") + (U32)ResCacheStats::NumEvictions() + "; reloaded " + (F64)ResCacheStats::BytesReloaded() / (1024 * 1024) +
+					" MB; failed loads: " + failedLoads + "; " + frameMs + " ms per frame");
+				//Loads only fail when everything's pinned; the frame's working set is bigger than the cache,
+				//so that happens with pinning alone, but the one-offs' budget should always leave room.
+				if(failedLoads > 0 && mode != PINNED)
+				{
+					LogE(String(modeName(mode)) + ": resources failed to load!");
+				}
+				//the textures fit alongside the one-offs' budget, so they should never be evicted.
+				if(mode == BUDGETED && textureMisses > 0)
+				{
+					LogE("Budgeted textures were evicted!");
+				}
+			}
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				LogD(String("Cache: ") + CACHE_SIZE_MB + " MB; per frame: " + NUM_TEXTURES + " textures and " + NUM_ONE_OFFS +
+					" one-offs of " + (RES_SIZE / 1024) + " kB each");
+				for(U32 mode = 0; mode < MODE_LEN; ++mode)
+				{
+					runMode(mode, game);
+				}
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Times loading a batch of large PNGs, made by tiling the test archive's PNGs:
+		the old two-pass PNG++ path, then the PNG loader on one thread and on several.
+		*/
+		class PNGDecodeTest : public TestBase
+		{
+		private:
+			static const U32 CACHE_SIZE_MB = 512;
+			//the archive's PNGs are tiled out to this size, so there's enough to decode.
+			static const U32 TILED_SIZE = 2048;
+			//repeats the tiled PNGs to make up the batch.
+			static const U32 BATCH_SIZE = 16;
+			static const U32 MAX_THREADS = 8;
+
+			struct RawPNG
+			{
+				char* Data;
+				FileSz Size;
+			};
+
+			//Decodes every numThreads-th image of the batch, starting at first.
+			class DecodeClient : public IThreadClient
+			{
+			private:
+				PNGLoader* loader;
+				const Vector<RawPNG>* batch;
+				Vector<ResPtr>* results;
+				U32 first;
+				U32 numThreads;
+			public:
+				U32 NumFailed;
+				DecodeClient(PNGLoader* loaderParam, const Vector<RawPNG>* batchParam, Vector<ResPtr>* resultsParam,
+							U32 firstParam, U32 numThreadsParam) :
+					loader(loaderParam), batch(batchParam), results(resultsParam),
+					first(firstParam), numThreads(numThreadsParam), NumFailed(0) {}
+				void Run()
+				{
+					for(U32 i = first; i < batch->size(); i += numThreads)
+					{
+						if(!loader->LoadResource((*batch)[i].Data, (*batch)[i].Size, (*results)[i].get()))
+						{
+							++NumFailed;
+						}
+					}
+				}
+			};
+
+			//What PNGLoader used to do: decode once to size the resource, then again to fill it.
+			static void decodeOld(const RawPNG& png, Vector<char>& out)
+			{
+				MemBuf sizeBuf(png.Data, png.Size);
+				std::istream sizeStr(&sizeBuf);
+				png::image<png::rgba_pixel> sizeImg(sizeStr);
+				out.resize(sizeImg.get_width() * sizeImg.get_height() * 4);
+
+				MemBuf wrappedBuf(png.Data, png.Size);
+				std::istream bufStr(&wrappedBuf);
+				png::image<png::rgba_pixel> img(bufStr);
+				U32 width = img.get_width();
+				U32 height = img.get_height();
+				for(U32 i = 0; i < height; ++i)
+				{
+					for(U32 j = 0; j < width; ++j)
+					{
+						U32 bytePos = (i*width*4) + (j * 4);
+						png::rgba_pixel pix = img.get_pixel(j, (height - i - 1));
+						out[bytePos] = pix.red;
+						out[bytePos + 1] = pix.green;
+						out[bytePos + 2] = pix.blue;
+						out[bytePos + 3] = pix.alpha;
+					}
+				}
+			}
+
+			static void freePNGs(Vector<RawPNG>& pngs)
+			{
+				for(U32 i = 0; i < pngs.size(); ++i)
+				{
+					CustomArrayDelete(pngs[i].Data);
+				}
+				pngs.clear();
+			}
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Path archPath(String(Filesystem::GetProgDir()) + "/TestContent/Archives/Test1.zip");
+				IResourceArchive* resArch = CustomNew<ZipResArchive>(TEST_ALLOC, "ArchiveAlloc", archPath);
+				if(!resArch || !resArch->Open())
+				{
+					LogE("Failed to open archive!");
+					CustomDelete(resArch);
+					return false;
+				}
+				String archString = String("TestContent/Archives/") + resArch->GetArchiveName();
+				PNGLoader loader;
+				Vector<RawPNG> pngs;
+				Vector<ResGUID> guids;
+				for(U32 i = 0; i < resArch->GetNumResources(); ++i)
+				{
+					ResGUID guid(archString, resArch->GetResourceName(i));
+					if(!StringUtils::WildcardMatch(guid.ResName(), loader.GetPattern().c_str()))
+					{
+						continue;
+					}
+					RawPNG png;
+					png.Size = resArch->GetRawSize(guid);
+					png.Data = CustomArrayNew<char>(png.Size, TEST_ALLOC, "TestTempBufAlloc");
+					bool read = resArch->GetRawResource(guid, png.Data);
+					if(read)
+					{
+						RawPNG tiled;
+						tiled.Data = TilePNG(png.Data, png.Size, TILED_SIZE, tiled.Size);
+						pngs.push_back(tiled);
+						guids.push_back(guid);
+					}
+					CustomArrayDelete(png.Data);
+				}
+				CustomDelete(resArch);
+				if(pngs.empty())
+				{
+					LogE("No PNGs in archive!");
+					return false;
+				}
+				LogD(String("Tiled ") + (U32)pngs.size() + " PNGs out to " + TILED_SIZE + "x" + TILED_SIZE);
+				Vector<RawPNG> batch;
+				Vector<ResGUID> batchGUIDs;
+				for(U32 i = 0; i < BATCH_SIZE; ++i)
+				{
+					batch.push_back(pngs[i % pngs.size()]);
+					batchGUIDs.push_back(guids[i % guids.size()]);
+				}
+
+				BenchResManager resMgr;
+				if(!resMgr.Init(CACHE_SIZE_MB))
+				{
+					LogE("Couldn't init resource manager!");
+					freePNGs(pngs);
+					return false;
+				}
+
+				//The old path.
+				Vector<char> oldPixels;
+				game->Time().Tick();
+				for(U32 i = 0; i < BATCH_SIZE; ++i)
+				{
+					decodeOld(batch[i], oldPixels);
+				}
+				F64 oldMs = stopTimer(game) / BATCH_SIZE;
+				LogD(String("PNG++, decoding twice: ") + oldMs + " ms per image");
+
+				//Sizing only reads the header now.
+				FileSz totalSize = 0;
+				game->Time().Tick();
+				for(U32 i = 0; i < BATCH_SIZE; ++i)
+				{
+					totalSize += loader.GetLoadedResSize(batch[i].Data, batch[i].Size);
+				}
+				F64 probeMs = stopTimer(game) / BATCH_SIZE;
+				LogD(String("Header probe: ") + probeMs + " ms per image, " + (F64)totalSize / (1024 * 1024) + " MB decoded in all");
+
+				Vector<ResPtr> results;
+				for(U32 i = 0; i < BATCH_SIZE; ++i)
+				{
+					results.push_back(resMgr.MakeTexture(batchGUIDs[i], loader.GetLoadedResSize(batch[i].Data, batch[i].Size)));
+					if(!results[i])
+					{
+						LogE("Couldn't allocate texture!");
+						results.clear();
+						freePNGs(pngs);
+						return false;
+					}
+				}
+				for(U32 numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2)
+				{
+					Vector<DecodeClient*> clients;
+					Vector<Thread*> threads;
+					game->Time().Tick();
+					for(U32 i = 0; i < numThreads; ++i)
+					{
+						clients.push_back(LNew(DecodeClient, TEST_ALLOC, "TestAlloc")(&loader, &batch, &results, i, numThreads));
+						threads.push_back(LNew(Thread, TEST_ALLOC, "TestAlloc")(clients[i]));
+						threads[i]->Start();
+					}
+					U32 numFailed = 0;
+					for(U32 i = 0; i < numThreads; ++i)
+					{
+						threads[i]->Join();
+						numFailed += clients[i]->NumFailed;
+						LDelete(threads[i]);
+						LDelete(clients[i]);
+					}
+					F64 newMs = stopTimer(game) / BATCH_SIZE;
+					LogD(String("Single pass decode, ") + numThreads + " threads: " + newMs + " ms per image (" +
+						oldMs / newMs + "x faster); " + numFailed + " failed");
+					if(numFailed > 0)
+					{
+						LogE("PNGs failed to decode!");
+					}
+				}
+
+				//make sure both paths agree.
+				decodeOld(batch[BATCH_SIZE - 1], oldPixels);
+				const Texture2D* tex = (const Texture2D*)(const void*)results[BATCH_SIZE - 1]->Buffer();
+				bool matches = memcmp(tex->Data, &oldPixels[0], oldPixels.size()) == 0;
+				LogD(String("Decoded pixels ") + (matches ? "match" : "DON'T match") + " the old path");
+				if(!matches)
+				{
+					LogE("PNG loader's pixels don't match PNG++'s!");
+				}
+
+				results.clear();
+				freePNGs(pngs);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Writes the same model in the old copying format and the in-place format,
+		then compares how long each takes to load.
+		Also checks that the model loader uses in-place files where they are in a mapped archive.
+		*/
+		class ModelFormatTest : public TestBase
+		{
+		private:
+			static const U32 NUM_MESHES = 64;
+			static const U32 VERTS_PER_MESH = 4096;
+			static const U32 INDICES_PER_MESH = VERTS_PER_MESH * 3;
+			static const U32 NUM_LOADS = 200;
+
+			Vector<Vertex*> vertBufs;
+			Vector<U32*> indBufs;
+
+			//Half the meshes go in a second LOD; materials share a few textures.
+			void buildModel(Model& model)
+			{
+				for(U32 i = 0; i < NUM_MESHES; ++i)
+				{
+					Vertex* verts = CustomArrayNew<Vertex>(VERTS_PER_MESH, TEST_ALLOC, "TestAlloc");
+					U32* inds = CustomArrayNew<U32>(INDICES_PER_MESH, TEST_ALLOC, "TestAlloc");
+					for(U32 j = 0; j < VERTS_PER_MESH; ++j)
+					{
+						verts[j].Position = Random::InCube(10.0f);
+					}
+					for(U32 j = 0; j < INDICES_PER_MESH; ++j)
+					{
+						inds[j] = Random::InRange(0, (I32)VERTS_PER_MESH - 1);
+					}
+					vertBufs.push_back(verts);
+					indBufs.push_back(inds);
+					Geometry geom = Geometry();
+					geom.Initialize(HandleMgr::RegisterPtr(verts).GetHandle(), HandleMgr::RegisterPtr(inds).GetHandle(),
+									VERTS_PER_MESH, INDICES_PER_MESH, 1);
+					Material mat = Material();
+					mat.DiffuseTexGUID = ResGUID((String("textures.zip:diffuse") + (i % 4) + ".png").c_str());
+					if(i % 5 == 0)
+					{
+						mat.NormalMapGUID = ResGUID("textures.zip:normal.png");
+					}
+					if(i == NUM_MESHES / 2)
+					{
+						model.AddLOD(1.0f);
+					}
+					model.AddLODMesh(i < NUM_MESHES / 2 ? 0 : 1, Mesh(mat, geom));
+				}
+			}
+
+			bool meshesMatch(const Model& a, const Model& b)
+			{
+				if(a.LODCount() != b.LODCount())
+				{
+					return false;
+				}
+				for(U32 lod = 0; lod < a.LODCount(); ++lod)
+				{
+					if(a.LODMeshCount(lod) != b.LODMeshCount(lod))
+					{
+						return false;
+					}
+					for(U32 i = 0; i < a.LODMeshCount(lod); ++i)
+					{
+						const Mesh* meshA = a.GetLODMesh(lod, i);
+						const Mesh* meshB = b.GetLODMesh(lod, i);
+						const Geometry& geomA = meshA->GetGeometry();
+						const Geometry& geomB = meshB->GetGeometry();
+						if(	geomA.VertexCount() != geomB.VertexCount() || geomA.IndexCount() != geomB.IndexCount() ||
+							memcmp(geomA.Vertices(), geomB.Vertices(), geomA.VertexSizeAsBuffer()) != 0 ||
+							memcmp(geomA.Indices(), geomB.Indices(), geomA.IndexSizeAsBuffer()) != 0 ||
+							strcmp(meshA->GetMaterial().DiffuseTexGUID.Name, meshB->GetMaterial().DiffuseTexGUID.Name) != 0 ||
+							strcmp(meshA->GetMaterial().NormalMapGUID.Name, meshB->GetMaterial().NormalMapGUID.Name) != 0)
+						{
+							return false;
+						}
+					}
+				}
+				return true;
+			}
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+
+			//Loads the in-place file through the resource manager from a mapped pack.
+			void loadMapped(const char* file, size_t fileSize, const Model& expected)
+			{
+				const char* archive = "/TestContent/Archives/ModelFormatTest.lpak";
+				PackWriter writer;
+				if(	!writer.AddFile("model.lmdl", file, fileSize, false) ||
+					!writer.Write(Path(String(Filesystem::GetProgDir()) + archive)))
+				{
+					LogE(String("Couldn't write ") + archive + "!");
+					return;
+				}
+				BenchResManager resMgr;
+				if(!resMgr.Init(16))
+				{
+					LogE("Couldn't init resource manager!");
+					return;
+				}
+				ResPtr res = resMgr.Get(ResGUID((String(archive) + ":model.lmdl").c_str()));
+				if(!res || !meshesMatch(*(const Model*)res->Buffer(), expected))
+				{
+					LogE("Model loaded from a mapped pack doesn't match!");
+					return;
+				}
+				//only the Model object's allocated when the file's used where it's mapped.
+				LogD(String("Model in a mapped pack ") + (res->Size() == sizeof(Model) ? "used in place" : "copied") +
+						"; resource is " + (U32)res->Size() + " bytes");
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Model model;
+				buildModel(model);
+				size_t oldSize = ModelMgr::FindFileSize(model, LOD_MODEL_VER);
+				size_t newSize = ModelMgr::FindFileSize(model);
+				char* oldFile = CustomArrayNew<char>(oldSize, TEST_ALLOC, "TestAlloc");
+				//leave room to align the in-place file, like the model loader does.
+				char* newBuf = CustomArrayNew<char>(newSize + MODEL_DATA_ALIGN, TEST_ALLOC, "TestAlloc");
+				char* newFile = (char*)(((size_t)newBuf + MODEL_DATA_ALIGN - 1) & ~(size_t)(MODEL_DATA_ALIGN - 1));
+				if(	!ModelMgr::WriteModelMemory(model, oldFile, oldSize, LOD_MODEL_VER) ||
+					!ModelMgr::WriteModelMemory(model, newFile, newSize))
+				{
+					LogE("Couldn't write model!");
+					return false;
+				}
+				LogD(String("Version ") + LOD_MODEL_VER + " file: " + (U32)oldSize + " bytes; version " + CURR_MODEL_VER + " file: " + (U32)newSize + " bytes");
+
+				size_t geomSize = ModelMgr::FindFileGeomSize(oldFile);
+				char* geomBuf = CustomArrayNew<char>(geomSize, TEST_ALLOC, "TestAlloc");
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_LOADS; ++i)
+				{
+					Model loaded;
+					ModelMgr::ReadModelMemory(loaded, oldFile, oldSize, geomBuf, geomSize);
+				}
+				F64 oldMs = stopTimer(game) / NUM_LOADS;
+
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_LOADS; ++i)
+				{
+					ModelMgr::VerifyInPlaceModel(newFile, newSize);
+				}
+				F64 verifyMs = stopTimer(game) / NUM_LOADS;
+
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_LOADS; ++i)
+				{
+					Model loaded;
+					ModelMgr::ReadModelInPlace(loaded, newFile, newSize);
+				}
+				F64 newMs = stopTimer(game) / NUM_LOADS;
+				LogD(String("Copying load: ") + oldMs + " ms; in-place load: " + newMs + " ms (" + verifyMs + " ms of it verifying)");
+
+				Model oldModel;
+				Model newModel;
+				bool oldRead = ModelMgr::ReadModelMemory(oldModel, oldFile, oldSize, geomBuf, geomSize);
+				bool newRead = ModelMgr::ReadModelInPlace(newModel, newFile, newSize);
+				LogD(String("Models ") + (oldRead && newRead && meshesMatch(oldModel, newModel) ? "match" : "DON'T match"));
+				loadMapped(newFile, newSize, oldModel);
+				//a header pointing out of the file or at unaligned data should fail verification.
+				InPlaceMeshHeader* meshHdrs = (InPlaceMeshHeader*)(newFile + ((ModelHeader*)newFile)->MeshHdrStart);
+				meshHdrs[0].VertexDataStart += 4;
+				if(ModelMgr::VerifyInPlaceModel(newFile, newSize))
+				{
+					LogE("Model with unaligned geometry passed verification!");
+				}
+				meshHdrs[0].VertexDataStart -= 4;
+				meshHdrs[NUM_MESHES - 1].IndexDataStart = newSize - 4;
+				LogD(String("Corrupted model ") + (ModelMgr::VerifyInPlaceModel(newFile, newSize) ? "passed" : "failed") + " verification");
+
+				CustomArrayDelete(geomBuf);
+				CustomArrayDelete(newBuf);
+				CustomArrayDelete(oldFile);
+				for(U32 i = 0; i < vertBufs.size(); ++i)
+				{
+					CustomArrayDelete(vertBufs[i]);
+					CustomArrayDelete(indBufs[i]);
+				}
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Packs the same model into each compact vertex format,
+		then compares file sizes, load times and how much precision was lost.
+		*/
+		class VertexPackingTest : public TestBase
+		{
+		private:
+			static const U32 NUM_MESHES = 32;
+			static const U32 VERTS_PER_MESH = 8192;
+			static const U32 INDICES_PER_MESH = VERTS_PER_MESH * 3;
+			static const U32 NUM_LOADS = 100;
+
+			Vector<Vertex*> vertBufs;
+			Vector<U32*> indBufs;
+			Vector<Geometry> packedGeoms;
+
+			//Lumpy spheres in different places, so every mesh has its own bounds.
+			void buildModel(Model& model)
+			{
+				for(U32 i = 0; i < NUM_MESHES; ++i)
+				{
+					Vertex* verts = CustomArrayNew<Vertex>(VERTS_PER_MESH, TEST_ALLOC, "TestAlloc");
+					U32* inds = CustomArrayNew<U32>(INDICES_PER_MESH, TEST_ALLOC, "TestAlloc");
+					Vector3 center = Random::InCube(100.0f);
+					for(U32 j = 0; j < VERTS_PER_MESH; ++j)
+					{
+						Vector3 normal = Random::InCube(1.0f);
+						normal.Normalize();
+						verts[j].Position = center + normal * Random::InRange(4.0f, 5.0f);
+						verts[j].Normal = normal;
+						verts[j].Color = Vector3(Random::InRange(0.0f, 1.0f), Random::InRange(0.0f, 1.0f), Random::InRange(0.0f, 1.0f));
+						verts[j].UV = Vector3(Random::InRange(0.0f, 1.0f), Random::InRange(0.0f, 1.0f), 0);
+					}
+					for(U32 j = 0; j < INDICES_PER_MESH; ++j)
+					{
+						inds[j] = Random::InRange(0, (I32)VERTS_PER_MESH - 1);
+					}
+					vertBufs.push_back(verts);
+					indBufs.push_back(inds);
+					Geometry geom = Geometry();
+					geom.Initialize(HandleMgr::RegisterPtr(verts).GetHandle(), HandleMgr::RegisterPtr(inds).GetHandle(),
+									VERTS_PER_MESH, INDICES_PER_MESH, 1);
+					model.AddMesh(Mesh(Material(), geom));
+				}
+				model.RecalcBounds();
+			}
+
+			bool packModel(const Model& model, VertexFormat format, Model& packedModel)
+			{
+				for(U32 i = 0; i < model.MeshCount(); ++i)
+				{
+					const Mesh* mesh = model.GetMesh(i);
+					Geometry packed = Geometry();
+					if(!GeomHelpers::PackGeometry(mesh->GetGeometry(), format, packed))
+					{
+						return false;
+					}
+					packedGeoms.push_back(packed);
+					packedModel.AddMesh(Mesh(mesh->GetMaterial(), packed));
+				}
+				packedModel.RecalcBounds();
+				return true;
+			}
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+
+			//Writes the model out, then reads it back both ways.
+			//Returns the file, which is MODEL_DATA_ALIGN aligned inside fileBuf.
+			char* measureModel(Game* game, const Model& model, const String& name, char*& fileBuf, size_t& fileSize)
+			{
+				fileSize = ModelMgr::FindFileSize(model);
+				fileBuf = CustomArrayNew<char>(fileSize + MODEL_DATA_ALIGN, TEST_ALLOC, "TestAlloc");
+				char* file = (char*)(((size_t)fileBuf + MODEL_DATA_ALIGN - 1) & ~(size_t)(MODEL_DATA_ALIGN - 1));
+				if(!ModelMgr::WriteModelMemory(model, file, fileSize))
+				{
+					LogE(String("Couldn't write ") + name + " model!");
+					return NULL;
+				}
+				size_t geomSize = ModelMgr::FindFileGeomSize(file);
+				char* geomBuf = CustomArrayNew<char>(geomSize, TEST_ALLOC, "TestAlloc");
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_LOADS; ++i)
+				{
+					Model loaded;
+					ModelMgr::ReadModelMemory(loaded, file, fileSize, geomBuf, geomSize);
+				}
+				F64 copyMs = stopTimer(game) / NUM_LOADS;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_LOADS; ++i)
+				{
+					Model loaded;
+					ModelMgr::ReadModelInPlace(loaded, file, fileSize);
+				}
+				F64 inPlaceMs = stopTimer(game) / NUM_LOADS;
+				LogD(name + ": " + (U32)fileSize + " bytes (" + (U32)geomSize + " of geometry); copying load " + copyMs + " ms, in-place load " + inPlaceMs + " ms");
+				CustomArrayDelete(geomBuf);
+				return file;
+			}
+
+			//Compares a packed model read back from its file against the original.
+			void checkModel(const Model& model, const char* file, size_t fileSize, const String& name)
+			{
+				Model loaded;
+				if(!ModelMgr::ReadModelInPlace(loaded, file, fileSize))
+				{
+					LogE(String("Couldn't read ") + name + " model!");
+					return;
+				}
+				F32 maxPosErr = 0;
+				F32 maxNormErr = 0;
+				F32 maxUVErr = 0;
+				bool indicesMatch = true;
+				bool shortIndices = true;
+				for(U32 i = 0; i < model.MeshCount(); ++i)
+				{
+					const Geometry& src = model.GetMesh(i)->GetGeometry();
+					const Geometry& packed = loaded.GetMesh(i)->GetGeometry();
+					const PackedVertex* packedVerts = (const PackedVertex*)packed.VertexData();
+					for(U32 j = 0; j < src.VertexCount(); ++j)
+					{
+						Vertex unpacked = GeomHelpers::UnpackVertex(packed, packedVerts[j]);
+						const Vertex& orig = src.Vertices()[j];
+						maxPosErr = Math::Max(maxPosErr, (unpacked.Position - orig.Position).Length());
+						maxNormErr = Math::Max(maxNormErr, (unpacked.Normal - orig.Normal).Length());
+						maxUVErr = Math::Max(maxUVErr, (unpacked.UV - orig.UV).Length());
+					}
+					shortIndices &= packed.IndexSize() == sizeof(U16);
+					const U16* packedInds = (const U16*)packed.IndexData();
+					for(U32 j = 0; j < src.IndexCount() && shortIndices; ++j)
+					{
+						indicesMatch &= packedInds[j] == src.Indices()[j];
+					}
+				}
+				LogD(name + ": max position error " + maxPosErr + ", max normal error " + maxNormErr + ", max UV error " + maxUVErr);
+				LogD(name + ": indices " + (shortIndices && indicesMatch ? "packed to 16 bits and match" : "DON'T match"));
+				LogD(name + ": bounds " + (	(loaded.AABBBounds() - model.AABBBounds()).Length() < 0.001f ? "match" : "DON'T match"));
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Model model;
+				buildModel(model);
+				Model halfModel;
+				Model snormModel;
+				if(!packModel(model, HALF_POS_VERTEX, halfModel) || !packModel(model, SNORM_POS_VERTEX, snormModel))
+				{
+					LogE("Couldn't pack model!");
+					return false;
+				}
+				LogD(String("Vertex size: ") + (U32)sizeof(Vertex) + " bytes full, " + (U32)sizeof(PackedVertex) + " bytes packed");
+
+				char* fullBuf = NULL;
+				char* halfBuf = NULL;
+				char* snormBuf = NULL;
+				size_t fullSize, halfSize, snormSize;
+				char* fullFile = measureModel(game, model, "Full", fullBuf, fullSize);
+				char* halfFile = measureModel(game, halfModel, "Half-float positions", halfBuf, halfSize);
+				char* snormFile = measureModel(game, snormModel, "Snorm16 positions", snormBuf, snormSize);
+				if(fullFile && halfFile && snormFile)
+				{
+					LogD(String("Packed files are ") + (F32)halfSize / fullSize * 100.0f + "% of the full file");
+					checkModel(model, halfFile, halfSize, "Half-float positions");
+					checkModel(model, snormFile, snormSize, "Snorm16 positions");
+				}
+
+				CustomArrayDelete(snormBuf);
+				CustomArrayDelete(halfBuf);
+				CustomArrayDelete(fullBuf);
+				for(U32 i = 0; i < packedGeoms.size(); ++i)
+				{
+					CustomArrayDelete((void*)packedGeoms[i].VertexData());
+					CustomArrayDelete((void*)packedGeoms[i].IndexData());
+				}
+				for(U32 i = 0; i < vertBufs.size(); ++i)
+				{
+					CustomArrayDelete(vertBufs[i]);
+					CustomArrayDelete(indBufs[i]);
+				}
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Cooks a PNG from the test archive, tiled out to 2048x2048, into each block compressed format,
+		then compares loading the cooked textures with decoding the PNG,
+		in time and in texture memory.
+		*/
+		class TextureCookTest : public TestBase
+		{
+		private:
+			static const U32 CACHE_SIZE_MB = 256;
+			//the PNG's tiled out to this size, so cooking has a texture's worth of work.
+			static const U32 TILED_SIZE = 2048;
+			static const U32 NUM_LOADS = 16;
+			static const U32 MAX_THREADS = 8;
+
+			//Peak signal to noise ratio of the RGB channels, in dB; higher's better.
+			static F64 findPSNR(const U8* expected, const U8* actual, U32 numPixels)
+			{
+				F64 errSum = 0;
+				for(U32 i = 0; i < numPixels; ++i)
+				{
+					for(U32 c = 0; c < 3; ++c)
+					{
+						F64 diff = (F64)expected[i * 4 + c] - (F64)actual[i * 4 + c];
+						errSum += diff * diff;
+					}
+				}
+				if(errSum == 0)
+				{
+					return 99.0;
+				}
+				return 10.0 * log10(255.0 * 255.0 * numPixels * 3 / errSum);
+			}
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Path archPath(String(Filesystem::GetProgDir()) + "/TestContent/Archives/Test1.zip");
+				IResourceArchive* resArch = CustomNew<ZipResArchive>(TEST_ALLOC, "ArchiveAlloc", archPath);
+				if(!resArch || !resArch->Open())
+				{
+					LogE("Failed to open archive!");
+					CustomDelete(resArch);
+					return false;
+				}
+				String archString = String("TestContent/Archives/") + resArch->GetArchiveName();
+				PNGLoader pngLoader;
+				TextureLoader texLoader;
+				//the biggest PNG in the archive is the best test.
+				ResGUID pngGUID;
+				FileSz pngSize = 0;
+				for(U32 i = 0; i < resArch->GetNumResources(); ++i)
+				{
+					ResGUID guid(archString, resArch->GetResourceName(i));
+					if(	StringUtils::WildcardMatch(guid.ResName(), pngLoader.GetPattern().c_str()) &&
+						resArch->GetRawSize(guid) > pngSize)
+					{
+						pngGUID = guid;
+						pngSize = resArch->GetRawSize(guid);
+					}
+				}
+				if(pngSize == 0)
+				{
+					LogE("No PNGs in archive!");
+					CustomDelete(resArch);
+					return false;
+				}
+				char* archivePNG = CustomArrayNew<char>(pngSize, TEST_ALLOC, "TestTempBufAlloc");
+				bool read = resArch->GetRawResource(pngGUID, archivePNG);
+				CustomDelete(resArch);
+				if(!read)
+				{
+					LogE("Couldn't read PNG!");
+					CustomArrayDelete(archivePNG);
+					return false;
+				}
+				FileSz archivePNGSize = pngSize;
+				char* pngData = TilePNG(archivePNG, archivePNGSize, TILED_SIZE, pngSize);
+				CustomArrayDelete(archivePNG);
+
+				BenchResManager resMgr;
+				if(!resMgr.Init(CACHE_SIZE_MB))
+				{
+					LogE("Couldn't init resource manager!");
+					CustomArrayDelete(pngData);
+					return false;
+				}
+				ResPtr pngRes = resMgr.MakeTexture(pngGUID, pngLoader.GetLoadedResSize(pngData, pngSize));
+				if(!pngRes)
+				{
+					LogE("Couldn't allocate texture!");
+					CustomArrayDelete(pngData);
+					return false;
+				}
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_LOADS; ++i)
+				{
+					pngLoader.LoadResource(pngData, pngSize, pngRes.get());
+				}
+				F64 pngMs = stopTimer(game) / NUM_LOADS;
+				const Texture2D& source = *(const Texture2D*)(const void*)pngRes->Buffer();
+				const U8* sourcePixels = (const U8*)source.Data;
+				//the driver generates mips for PNGs when they're uploaded.
+				U32 rgbaKB = source.Width * source.Height * 4 / 1024;
+				LogD(String(pngGUID.ResName()) + ", tiled: " + source.Width + "x" + source.Height + ", " + (U32)(pngSize / 1024) + " KB as PNG; loads in " +
+					pngMs + " ms, to " + rgbaKB + " KB of RGBA8 (" + rgbaKB * 4 / 3 + " KB with mips)");
+
+				const Texture2D::CompressionType types[3] = { Texture2D::DXT1, Texture2D::DXT5, Texture2D::BC7 };
+				const char* typeNames[3] = { "BC1", "BC3", "BC7" };
+				Vector<U8> decoded;
+				decoded.resize(source.Width * source.Height * 4);
+				for(U32 t = 0; t < 3; ++t)
+				{
+					Texture2D cooked;
+					game->Time().Tick();
+					TextureCompression::CookTexture(sourcePixels, source.Width, source.Height, types[t], true, 1, cooked);
+					F64 oneThreadMs = stopTimer(game);
+					LArrayDelete(cooked.Data);
+					game->Time().Tick();
+					TextureCompression::CookTexture(sourcePixels, source.Width, source.Height, types[t], true, MAX_THREADS, cooked);
+					F64 cookMs = stopTimer(game);
+					TextureCompression::DecompressImage((const U8*)cooked.Data, source.Width, source.Height, types[t], &decoded[0]);
+					F64 psnr = findPSNR(sourcePixels, &decoded[0], source.Width * source.Height);
+
+					//name a couple of regions, so atlas lookups get tried too.
+					Vector<TextureRegion> regions;
+					TextureRegion region;
+					region.Name = "left";
+					region.X = 0;
+					region.Y = 0;
+					region.Width = source.Width / 2;
+					region.Height = source.Height;
+					regions.push_back(region);
+					region.Name = "right";
+					region.X = source.Width / 2;
+					regions.push_back(region);
+					size_t fileSize = TextureMgr::FindFileSize(cooked, regions);
+					char* file = CustomArrayNew<char>(fileSize, TEST_ALLOC, "TestTempBufAlloc");
+					TextureMgr::WriteTextureMemory(cooked, regions, file, fileSize);
+
+					ResPtr texRes = resMgr.MakeTexture(pngGUID, texLoader.GetLoadedResSize(file, fileSize));
+					if(!texRes)
+					{
+						LogE("Couldn't allocate texture!");
+						CustomArrayDelete(file);
+						LArrayDelete(cooked.Data);
+						break;
+					}
+					game->Time().Tick();
+					for(U32 i = 0; i < NUM_LOADS; ++i)
+					{
+						texLoader.LoadResource(file, fileSize, texRes.get());
+					}
+					F64 loadMs = stopTimer(game) / NUM_LOADS;
+					const Texture2D& loaded = *(const Texture2D*)(const void*)texRes->Buffer();
+					const char* loadedFile = TextureLoader::GetTextureFile(texRes->Buffer());
+					const AtlasRegion* right = TextureMgr::FindRegion(loadedFile, "right");
+					bool matches = loaded.CompType == types[t] && loaded.MipCount() == cooked.MipCount() &&
+									memcmp(loaded.Data, cooked.Data, cooked.DataSize()) == 0 &&
+									right && right->X == source.Width / 2 && !TextureMgr::FindRegion(loadedFile, "middle");
+					LogD(String(typeNames[t]) + ": cooked in " + cookMs + " ms on " + (U32)MAX_THREADS + " threads (" + oneThreadMs + " ms on 1), PSNR " + psnr +
+						" dB; loads in " + loadMs + " ms (" + pngMs / loadMs + "x faster), to " + cooked.DataSize() / 1024 + " KB with mips; loaded texture " +
+						(matches ? "matches" : "DOESN'T match"));
+					if(!matches)
+					{
+						LogE(String(typeNames[t]) + ": loaded texture doesn't match the cooked one!");
+					}
+					texRes.reset();
+					CustomArrayDelete(file);
+					LArrayDelete(cooked.Data);
+				}
+
+				pngRes.reset();
+				CustomArrayDelete(pngData);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Builds a distance field glyph atlas for a font from the test archive,
+		then compares building it with loading it from the atlas cache,
+		and its size with the atlases needed to keep a bitmap font at every size.
+		*/
+		class FontAtlasTest : public TestBase
+		{
+		private:
+			static const U32 BASE_SIZE = 32;
+			static const U32 MAX_TEX_SIZE = 2048;
+			static const U32 NUM_LOADS = 16;
+			static const U32 NUM_SIZES = 6;
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Path archPath(String(Filesystem::GetProgDir()) + "/TestContent/Archives/TestContent.zip");
+				IResourceArchive* resArch = CustomNew<ZipResArchive>(TEST_ALLOC, "ArchiveAlloc", archPath);
+				if(!resArch || !resArch->Open())
+				{
+					LogE("Failed to open archive!");
+					CustomDelete(resArch);
+					return false;
+				}
+				ResGUID fontGUID(String("TestContent/Archives/") + resArch->GetArchiveName(), "Fonts/ubuntu-r.ttf");
+				FileSz rawSize = resArch->GetRawSize(fontGUID);
+				if(rawSize == 0)
+				{
+					LogE("Font isn't in archive!");
+					CustomDelete(resArch);
+					return false;
+				}
+				//fonts are read with a terminator, which FreeType doesn't get to see.
+				U32 fontSize = (U32)rawSize + 1;
+				char* fontData = CustomArrayNew<char>(fontSize, TEST_ALLOC, "TestTempBufAlloc");
+				resArch->GetRawResource(fontGUID, fontData);
+				fontData[rawSize] = 0;
+				CustomDelete(resArch);
+
+				//a bitmap font needs an atlas for each size it's drawn at.
+				const U32 sizes[NUM_SIZES] = { 12, 16, 24, 32, 48, 64 };
+				U32 perSizeKB = 0;
+				F64 perSizeMs = 0;
+				for(U32 i = 0; i < NUM_SIZES; ++i)
+				{
+					FontAtlasData sized;
+					game->Time().Tick();
+					if(!Font::BuildAtlas(fontData, fontSize, sizes[i], MAX_TEX_SIZE, sized))
+					{
+						LogE(String("Couldn't build atlas at size ") + sizes[i] + "!");
+						CustomArrayDelete(fontData);
+						return false;
+					}
+					perSizeMs += stopTimer(game);
+					perSizeKB += sized.Atlas.DataSize() / 1024;
+					LArrayDelete(sized.Atlas.Data);
+				}
+
+				//a distance field atlas covers all of them.
+				FontAtlasData atlas;
+				game->Time().Tick();
+				if(!Font::BuildAtlas(fontData, fontSize, BASE_SIZE, MAX_TEX_SIZE, atlas))
+				{
+					LogE("Couldn't build atlas!");
+					CustomArrayDelete(fontData);
+					return false;
+				}
+				F64 buildMs = stopTimer(game);
+				U32 atlasKB = atlas.Atlas.DataSize() / 1024;
+				LogD(String("Distance field atlas at ") + (U32)BASE_SIZE + " px: " + atlas.Atlas.Width + "x" + atlas.Atlas.Height + ", " + atlasKB +
+					" KB, built in " + buildMs + " ms; an atlas for each of " + (U32)NUM_SIZES + " sizes from " + sizes[0] + " to " + sizes[NUM_SIZES - 1] +
+					" px takes " + perSizeKB + " KB and " + perSizeMs + " ms (" + (F32)perSizeKB / Math::Max(atlasKB, 1U) + "x the memory)");
+
+				size_t cacheSize = FontMgr::FindFileSize(atlas);
+				char* cache = CustomArrayNew<char>(cacheSize, TEST_ALLOC, "TestTempBufAlloc");
+				FontMgr::WriteFontMemory(atlas, cache, cacheSize);
+				FontAtlasData cached;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_LOADS; ++i)
+				{
+					FontMgr::ReadFontInPlace(cached, cache, cacheSize);
+				}
+				F64 loadMs = stopTimer(game) / NUM_LOADS;
+				bool matches = cached.Key == atlas.Key && cached.Glyphs.size() == atlas.Glyphs.size() &&
+								memcmp(&cached.Glyphs[0], &atlas.Glyphs[0], atlas.Glyphs.size() * sizeof(FontGlyph)) == 0 &&
+								memcmp(cached.Atlas.Data, atlas.Atlas.Data, atlas.Atlas.DataSize()) == 0;
+				LogD(String("Cached atlas is ") + (U32)(cacheSize / 1024) + " KB, reads in " + loadMs + " ms (" + buildMs / loadMs +
+					"x faster than building it); cached atlas " + (matches ? "matches" : "DOESN'T match"));
+				CustomArrayDelete(cache);
+				LArrayDelete(atlas.Atlas.Data);
+
+				//and the whole setup, upload included, with a cold and then a warm cache.
+				Path cacheDir(String(Filesystem::GetProgDir()) + "/FontCache");
+				U64 key = FontMgr::FindFontKey(fontData, fontSize, BASE_SIZE, Font::FindSpread(BASE_SIZE), MAX_TEX_SIZE);
+				Path cachePath(cacheDir.ToString() + "/" + FontMgr::FindCacheName(key));
+				if(Filesystem::Exists(cachePath))
+				{
+					Filesystem::RemoveFile(cachePath);
+				}
+				Font coldFont, warmFont;
+				game->Time().Tick();
+				bool coldResult = coldFont.GenerateFromMemory(fontData, gfx, fontSize, BASE_SIZE, MAX_TEX_SIZE, cacheDir);
+				F64 coldMs = stopTimer(game);
+				bool warmResult = warmFont.GenerateFromMemory(fontData, gfx, fontSize, BASE_SIZE, MAX_TEX_SIZE, cacheDir);
+				F64 warmMs = stopTimer(game);
+				if(coldResult && warmResult)
+				{
+					LogD(String("Font setup takes ") + coldMs + " ms with a cold cache, " + warmMs + " ms with a warm one");
+				}
+				else
+				{
+					LogE("Couldn't set up font!");
+				}
+
+				CustomArrayDelete(fontData);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Draws a thousand labels, first as separate Texts and then through a TextBatch,
+		counting draw calls and timing the CPU side of each.
+		Every tenth label changes every frame, like a stat overlay;
+		the rest are set to the same string every frame.
+		*/
+		class TextBatchTest : public TestBase
+		{
+		private:
+			static const U32 NUM_LABELS = 1000;
+			static const U32 NUM_FRAMES = 60;
+			static const U32 CHANGE_INTERVAL = 10;
+			static const U32 LABELS_PER_ROW = 25;
+
+			ResourceManager resMgr;
+			Font font;
+			Text labels[NUM_LABELS];
+			TextBatch batch;
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			void updateLabels(U32 frame)
+			{
+				for(U32 i = 0; i < NUM_LABELS; ++i)
+				{
+					if(i % CHANGE_INTERVAL == 0)
+					{
+						labels[i].SetString(String("Label ") + i + ", frame " + frame);
+					}
+					else
+					{
+						labels[i].SetString(String("Label ") + i);
+					}
+				}
+			}
+			Vector3 labelPos(U32 index)
+			{
+				return Vector3((index % LABELS_PER_ROW) * 0.04f, (index / LABELS_PER_ROW) * 0.025f, 0);
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				if(!resMgr.Init(128))
+				{
+					LogE("Couldn't init resource manager!");
+					return false;
+				}
+				ResPtr fontPtr = resMgr.GetResource(ResGUID("/TestContent/Archives/TestContent.zip", "Fonts/ubuntu-r.ttf"));
+				if(!fontPtr || !font.GenerateFromResource(fontPtr, gfx, 32, 1024, Path(String(Filesystem::GetProgDir()) + "/FontCache")))
+				{
+					LogE("Couldn't build font!");
+					resMgr.Shutdown();
+					return false;
+				}
+				fontPtr.reset();
+
+				Vector< ShaderFilePair > textShaders;
+				textShaders.push_back( ShaderFilePair(VERTEX, Path((String(Filesystem::GetProgDir()) + "./Shaders/Basic/Text.vp").c_str())) );
+				textShaders.push_back( ShaderFilePair(FRAGMENT, Path((String(Filesystem::GetProgDir()) + "./Shaders/Basic/Text.fp").c_str())) );
+				if(!gfx->MakeShader("Text", 2, textShaders) || !gfx->SetShader("Text"))
+				{
+					LogE("Failed to build shaders!");
+					resMgr.Shutdown();
+					return false;
+				}
+				gfx->SetIntUniform("diffTex", TextureMeta::DIFFUSE);
+				const Matrix4x4 projection = Matrix4x4::BuildOrthographicRH(1, 0, 0, 1, -1, 1);
+				for(U32 i = 0; i < NUM_LABELS; ++i)
+				{
+					labels[i].SetFont(font);
+					labels[i].SetSize(12);
+				}
+
+				//each Text on its own needs its own transform, texture bind and draw call.
+				game->Time().Tick();
+				for(U32 frame = 0; frame < NUM_FRAMES; ++frame)
+				{
+					updateLabels(frame);
+					gfx->SetTexture(font.GetTextureHandle(), TextureMeta::DIFFUSE);
+					for(U32 i = 0; i < NUM_LABELS; ++i)
+					{
+						gfx->SetWorldViewProjection(Matrix4x4::BuildTranslation(labelPos(i)), Matrix4x4::Identity, projection);
+						gfx->Draw(labels[i]);
+					}
+				}
+				F64 separateMs = stopTimer(game) / NUM_FRAMES;
+
+				//make the batch lay the labels out again, so neither run starts with a warm cache.
+				for(U32 i = 0; i < NUM_LABELS; ++i)
+				{
+					labels[i].SetString("");
+				}
+				font.ClearLayoutCache();
+				gfx->SetWorldViewProjection(Matrix4x4::Identity, Matrix4x4::Identity, projection);
+				game->Time().Tick();
+				for(U32 frame = 0; frame < NUM_FRAMES; ++frame)
+				{
+					updateLabels(frame);
+					batch.Clear();
+					for(U32 i = 0; i < NUM_LABELS; ++i)
+					{
+						batch.Add(labels[i], labelPos(i));
+					}
+					gfx->Draw(batch);
+				}
+				F64 batchMs = stopTimer(game) / NUM_FRAMES;
+				LogD(String("") + (U32)NUM_LABELS + " labels, " + batch.QuadCount() + " glyphs: separately, " + (U32)NUM_LABELS + " draw calls and " + separateMs +
+					" ms a frame; batched, " + batch.RunCount() + " draw call(s) and " + batchMs + " ms a frame (" + separateMs / batchMs + "x faster)");
+
+				for(U32 i = 0; i < NUM_LABELS; ++i)
+				{
+					gfx->ShutdownText(labels[i]);
+				}
+				resMgr.Shutdown();
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Times laying out UTF-8 labels: rendering glyphs into the dynamic pages the first time they're seen,
+		laying every label out from scratch, and getting them from the font's layout cache.
+		The labels repeat a few hundred strings mixing ASCII, accented Latin, Greek and Cyrillic,
+		like a UI's worth of localized labels.
+		*/
+		class TextLayoutTest : public TestBase
+		{
+		private:
+			static const U32 NUM_STRINGS = 256;
+			static const U32 NUM_LABELS = 5000;
+			static const U32 NUM_PASSES = 10;
+
+			ResourceManager resMgr;
+			Font font;
+			Vector<String> strings;
+			Text labels[NUM_LABELS];
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			void buildStrings()
+			{
+				//spelled out in UTF-8, so the source's encoding doesn't matter
+				const char* words[] = {	"Label",
+										"Gr\xC3\xB6\xC3\x9F" "e",						//German, "size"
+										"\xCE\xA3\xCE\xBA\xCE\xBF\xCF\x81",		//Greek, "score"
+										"\xD0\x9E\xD1\x87\xD0\xBA\xD0\xB8" };	//Russian, "points"
+				const U32 numWords = sizeof(words) / sizeof(words[0]);
+				strings.resize(NUM_STRINGS);
+				for(U32 i = 0; i < NUM_STRINGS; ++i)
+				{
+					strings[i] = String(words[i % numWords]) + ": " + i * 37;
+				}
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				if(!resMgr.Init(128))
+				{
+					LogE("Couldn't init resource manager!");
+					return false;
+				}
+				ResPtr fontPtr = resMgr.GetResource(ResGUID("/TestContent/Archives/TestContent.zip", "Fonts/ubuntu-r.ttf"));
+				if(!fontPtr || !font.GenerateFromResource(fontPtr, gfx, 32, 1024, Path(String(Filesystem::GetProgDir()) + "/FontCache")))
+				{
+					LogE("Couldn't build font!");
+					resMgr.Shutdown();
+					return false;
+				}
+				fontPtr.reset();
+				buildStrings();
+
+				//the first pass renders every glyph outside of ASCII.
+				TextLayout layout;
+				U32 numGlyphs = 0;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_STRINGS; ++i)
+				{
+					font.LayoutString(strings[i], layout);
+					numGlyphs += layout.QuadCount();
+				}
+				F64 coldMs = stopTimer(game);
+				LogD(String("Laid out ") + (U32)NUM_STRINGS + " strings with a cold glyph cache in " + coldMs + " ms, rendering " +
+					font.GetCachedGlyphCount() + " glyphs into " + (font.GetPageCount() - 1) + " dynamic page(s)");
+
+				//every glyph's cached now, so this is just decoding and placing quads.
+				numGlyphs = 0;
+				game->Time().Tick();
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					for(U32 i = 0; i < NUM_LABELS; ++i)
+					{
+						font.LayoutString(strings[i % NUM_STRINGS], layout);
+						numGlyphs += layout.QuadCount();
+					}
+				}
+				F64 uncachedMs = stopTimer(game) / NUM_PASSES;
+				U32 glyphsPerPass = numGlyphs / NUM_PASSES;
+
+				font.ClearLayoutCache();
+				game->Time().Tick();
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					for(U32 i = 0; i < NUM_LABELS; ++i)
+					{
+						font.GetLayout(strings[i % NUM_STRINGS]);
+					}
+				}
+				F64 cachedMs = stopTimer(game) / NUM_PASSES;
+				LogD(String("") + (U32)NUM_LABELS + " labels, " + glyphsPerPass + " glyphs: laid out every time, " + uncachedMs +
+					" ms (" + (glyphsPerPass / uncachedMs) * 1000 + " glyphs/s); from the layout cache, " + cachedMs + " ms (" +
+					uncachedMs / cachedMs + "x faster)");
+
+				//what a frame of changed labels costs, copying each one's layout into its geometry.
+				for(U32 i = 0; i < NUM_LABELS; ++i)
+				{
+					labels[i].SetFont(font);
+				}
+				game->Time().Tick();
+				for(U32 pass = 0; pass < NUM_PASSES; ++pass)
+				{
+					for(U32 i = 0; i < NUM_LABELS; ++i)
+					{
+						labels[i].SetString(strings[(i + pass) % NUM_STRINGS]);
+						labels[i].RebuildGeometry();
+					}
+				}
+				F64 rebuildMs = stopTimer(game) / NUM_PASSES;
+				LogD(String("Rebuilding ") + (U32)NUM_LABELS + " labels' geometry takes " + rebuildMs + " ms, " +
+					(NUM_LABELS / rebuildMs) + " labels/ms");
+
+				font.Shutdown();
+				resMgr.Shutdown();
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Times decoding TGAs the size of large textures, built by tiling testImg128.tga:
+		raw 32 and 24 bit images, and an RLE compressed 32 bit one.
+		The raw 32 bit decode's compared against swizzling a byte at a time,
+		and the RLE decode is checked against it.
+		*/
+		class TGADecodeTest : public TestBase
+		{
+		private:
+			static const U32 SRC_SIZE = 128;
+			static const U32 NUM_REPEATS = 5;
+			static const U32 TGA_HEADER_LEN = 18;
+
+			F64 stopTimer(Game* game)
+			{
+				game->Time().Tick();
+				return game->Time().ElapsedGameTime().ToMilliseconds();
+			}
+			//Packs a row into RLE packets: runs of a repeated pixel, and raw packets between them.
+			void appendRLE(const Vector<U8>& row, U32 bytesPerPixel, Vector<U8>& out)
+			{
+				const U32 MAX_PACKET = 128;
+				const U32 numPixels = row.size() / bytesPerPixel;
+				U32 i = 0;
+				while(i < numPixels)
+				{
+					U32 count = 1;
+					while(	i + count < numPixels && count < MAX_PACKET &&
+							memcmp(&row[i * bytesPerPixel], &row[(i + count) * bytesPerPixel], bytesPerPixel) == 0)
+					{
+						++count;
+					}
+					if(count > 1)
+					{
+						out.push_back((U8)(0x80 | (count - 1)));
+						out.insert(out.end(), row.begin() + (i * bytesPerPixel), row.begin() + ((i + 1) * bytesPerPixel));
+						i += count;
+						continue;
+					}
+					//a raw packet ends where a run starts
+					while(	i + count < numPixels && count < MAX_PACKET &&
+							(i + count + 1 == numPixels ||
+							memcmp(&row[(i + count) * bytesPerPixel], &row[(i + count + 1) * bytesPerPixel], bytesPerPixel) != 0))
+					{
+						++count;
+					}
+					out.push_back((U8)(count - 1));
+					out.insert(out.end(), row.begin() + (i * bytesPerPixel), row.begin() + ((i + count) * bytesPerPixel));
+					i += count;
+				}
+			}
+			//Tiles the source's BGRA pixels into a size x size TGA.
+			void buildImage(const U8* srcPixels, U32 size, U32 bitsPerPixel, bool compressed, Vector<U8>& out)
+			{
+				const U32 bytesPerPixel = bitsPerPixel / 8;
+				out.assign(TGA_HEADER_LEN, 0);
+				out[2] = compressed ? 10 : 2;
+				out[12] = (U8)(size & 0xFF);
+				out[13] = (U8)(size >> 8);
+				out[14] = (U8)(size & 0xFF);
+				out[15] = (U8)(size >> 8);
+				out[16] = (U8)bitsPerPixel;
+				out[17] = bitsPerPixel == 32 ? 8 : 0;
+				Vector<U8> row;
+				row.resize(size * bytesPerPixel);
+				for(U32 y = 0; y < size; ++y)
+				{
+					const U8* srcRow = srcPixels + ((y % SRC_SIZE) * SRC_SIZE * 4);
+					for(U32 x = 0; x < size; ++x)
+					{
+						memcpy(&row[x * bytesPerPixel], srcRow + ((x % SRC_SIZE) * 4), bytesPerPixel);
+					}
+					if(compressed)
+					{
+						appendRLE(row, bytesPerPixel, out);
+					}
+					else
+					{
+						out.insert(out.end(), row.begin(), row.end());
+					}
+				}
+			}
+			F64 timeDecode(Game* game, const Vector<U8>& image, U32 size, Vector<U8>& decoded)
+			{
+				bool decodedAll = true;
+				game->Time().Tick();
+				for(U32 i = 0; i < NUM_REPEATS; ++i)
+				{
+					decodedAll = TGALoader::DecodeImage((const char*)&image[0], image.size(), size, size, (char*)&decoded[0]) && decodedAll;
+				}
+				F64 ms = stopTimer(game) / NUM_REPEATS;
+				if(!decodedAll)
+				{
+					LogE("Couldn't decode TGA!");
+				}
+				return ms;
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				Path path(String(Filesystem::GetProgDir()) + "/TestContent/Archives/testImg128.tga");
+				DataStream* file = Filesystem::OpenFileReadOnly(path);
+				if(!file)
+				{
+					LogE("Couldn't open test image!");
+					return false;
+				}
+				FileSz fileSize = file->FileSize();
+				char* srcFile = file->ReadAll();
+				Filesystem::CloseFile(file);
+				U32 width = 0, height = 0;
+				if(	!TGALoader::ReadImageSize(srcFile, fileSize, width, height) ||
+					width != SRC_SIZE || height != SRC_SIZE || (U8)srcFile[16] != 32)
+				{
+					LogE("Test image isn't a 128x128, 32 bit TGA!");
+					CustomArrayDelete(srcFile);
+					return false;
+				}
+				const U8* srcPixels = (const U8*)srcFile + TGA_HEADER_LEN + (U8)srcFile[0];
+
+				const U32 sizes[] = { 512, 2048, 4096 };
+				Vector<U8> image, decoded, rawDecoded;
+				for(U32 s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+				{
+					const U32 size = sizes[s];
+					const U32 numPixels = size * size;
+					decoded.resize(numPixels * 4);
+					rawDecoded.resize(numPixels * 4);
+
+					buildImage(srcPixels, size, 32, false, image);
+					//what decoding cost with a plain loop.
+					const U8* pixels = &image[TGA_HEADER_LEN];
+					U8* dest = &rawDecoded[0];
+					game->Time().Tick();
+					for(U32 r = 0; r < NUM_REPEATS; ++r)
+					{
+						for(U32 i = 0; i < numPixels; ++i)
+						{
+							dest[(i * 4)] = pixels[(i * 4) + 2];
+							dest[(i * 4) + 1] = pixels[(i * 4) + 1];
+							dest[(i * 4) + 2] = pixels[(i * 4)];
+							dest[(i * 4) + 3] = pixels[(i * 4) + 3];
+						}
+					}
+					F64 scalarMs = stopTimer(game) / NUM_REPEATS;
+					F64 rawMs = timeDecode(game, image, size, rawDecoded);
+
+					buildImage(srcPixels, size, 24, false, image);
+					F64 rgbMs = timeDecode(game, image, size, decoded);
+
+					buildImage(srcPixels, size, 32, true, image);
+					F64 rleMs = timeDecode(game, image, size, decoded);
+					bool matches = memcmp(&decoded[0], &rawDecoded[0], numPixels * 4) == 0;
+
+					LogD(String("") + size + "x" + size + ": raw 32 bit in " + rawMs + " ms (" + numPixels / (rawMs * 1000) +
+						" Mpixels/s, " + scalarMs / rawMs + "x a plain loop), raw 24 bit in " + rgbMs + " ms, RLE in " + rleMs +
+						" ms from " + (U32)(image.size() / 1024) + "KB; RLE decode " + (matches ? "matches" : "DOESN'T match") + " raw");
+				}
+				CustomArrayDelete(srcFile);
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
+
+		/**
+		Runs the importer's mesh optimizer on a grid of triangles in shuffled order,
+		with every triangle using its own vertices, as importers often give them.
+		The optimized mesh has to have a better ACMR, be fully welded,
+		and have exactly the same triangles, wound the same way.
+		*/
+		class MeshOptimizerTest : public TestBase
+		{
+		private:
+			static const U32 GRID_SIZE = 64;
+			static const U32 NUM_TRIS = GRID_SIZE * GRID_SIZE * 2;
+
+			//Gets a triangle's positions, starting from the lowest so the winding's kept.
+			static String triangleKey(const Vertex* verts, const U32* tri)
+			{
+				F32 pos[3][3];
+				for(U32 i = 0; i < 3; ++i)
+				{
+					const Vector3& p = verts[tri[i]].Position;
+					pos[i][0] = p.X();
+					pos[i][1] = p.Y();
+					pos[i][2] = p.Z();
+				}
+				U32 first = 0;
+				for(U32 i = 1; i < 3; ++i)
+				{
+					if(memcmp(pos[i], pos[first], sizeof(pos[i])) < 0)
+					{
+						first = i;
+					}
+				}
+				String key;
+				for(U32 i = 0; i < 3; ++i)
+				{
+					key.append((const char*)pos[(first + i) % 3], sizeof(pos[0]));
+				}
+				return key;
+			}
+		public:
+			bool Startup(Game* game)
+			{
+				//two triangles per grid cell, in a shuffled order.
+				Vector<U32> triOrder;
+				for(U32 i = 0; i < NUM_TRIS; ++i)
+				{
+					triOrder.push_back(i);
+				}
+				U32 seed = 12345;
+				for(U32 i = NUM_TRIS - 1; i > 0; --i)
+				{
+					seed = seed * 1664525 + 1013904223;
+					std::swap(triOrder[i], triOrder[seed % (i + 1)]);
+				}
+				Vector<Vertex> verts;
+				Vector<U32> indices;
+				for(U32 i = 0; i < NUM_TRIS; ++i)
+				{
+					U32 cell = triOrder[i] / 2;
+					U32 x = cell % GRID_SIZE;
+					U32 y = cell / GRID_SIZE;
+					U32 corners[2][3][2] = {	{ { x, y }, { x + 1, y }, { x + 1, y + 1 } },
+												{ { x, y }, { x + 1, y + 1 }, { x, y + 1 } } };
+					for(U32 j = 0; j < 3; ++j)
+					{
+						const U32* corner = corners[triOrder[i] % 2][j];
+						Vertex vert;
+						vert.Position = Vector3((F32)corner[0], (F32)corner[1], 0.0f);
+						vert.Normal = Vector3(0.0f, 0.0f, 1.0f);
+						vert.UV = Vector3((F32)corner[0] / GRID_SIZE, (F32)corner[1] / GRID_SIZE, 0.0f);
+						indices.push_back(verts.size());
+						verts.push_back(vert);
+					}
+				}
+
+				Vector<Vertex> vertsOut;
+				Vector<U32> indicesOut;
+				game->Time().Tick();
+				MeshOptimizer::OptimizeStats stats = MeshOptimizer::OptimizeMesh(	&verts[0], verts.size(), &indices[0], indices.size(),
+																					vertsOut, indicesOut);
+				game->Time().Tick();
+				LogD(	String("Optimized ") + NUM_TRIS + " triangles in " + game->Time().ElapsedGameTime().ToMilliseconds() +
+						" ms: " + stats.VertsBefore + " -> " + stats.VertsAfter + " verts, ACMR " + stats.ACMRBefore + " -> " + stats.ACMRAfter);
+
+				F32 acmr = indicesOut.empty() ? 3.0f : MeshOptimizer::FindACMR(&indicesOut[0], indicesOut.size(), vertsOut.size());
+				if(acmr >= stats.ACMRBefore || acmr != stats.ACMRAfter)
+				{
+					LogE(String("Optimizing didn't improve the ACMR! ") + stats.ACMRBefore + " -> " + acmr);
+				}
+				if(vertsOut.size() != (GRID_SIZE + 1) * (GRID_SIZE + 1))
+				{
+					LogE(String("Optimized mesh has ") + (U32)vertsOut.size() + " verts; expected them all welded!");
+				}
+				//the same triangles should come out, just in another order.
+				Vector<String> trisIn, trisOut;
+				for(U32 i = 0; i < indices.size(); i += 3)
+				{
+					trisIn.push_back(triangleKey(&verts[0], &indices[i]));
+				}
+				for(U32 i = 0; i + 2 < indicesOut.size(); i += 3)
+				{
+					if(indicesOut[i] >= vertsOut.size() || indicesOut[i + 1] >= vertsOut.size() || indicesOut[i + 2] >= vertsOut.size())
+					{
+						LogE(String("Optimized triangle ") + i / 3 + " has an index out of range!");
+						return false;
+					}
+					trisOut.push_back(triangleKey(&vertsOut[0], &indicesOut[i]));
+				}
+				std::sort(trisIn.begin(), trisIn.end());
+				std::sort(trisOut.begin(), trisOut.end());
+				if(indicesOut.size() % 3 != 0 || trisIn != trisOut)
+				{
+					LogE(String("Optimized mesh has different triangles! ") + (U32)trisOut.size() + "/" + (U32)trisIn.size() + " triangles");
+				}
+				return false;
+			}
+			void Shutdown(Game* game) {}
+			void Update(Game* game, const GameTime& time) {}
+			void Draw(Game* game, const GameTime& time) {}
+		};
 	}
 }
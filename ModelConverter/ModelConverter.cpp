@@ -0,0 +1,515 @@
+//Converts a directory or ZIP archive of source models into LeEK models (.lmdl),
+//on as many threads as there are cores.
+//Sources that haven't changed since the last run are skipped.
+#include <Logging/Log.h>
+#include <Constants/AllocTypes.h>
+#include <Memory/Allocator.h>
+#include <Memory/Handle.h>
+#include <Math/MathFunctions.h>
+#include <Hashing/Hash.h>
+#include <Libraries/MurmurHash3/MurmurHash3.h>
+#include <FileManagement/Filesystem.h>
+#include <FileManagement/DataStream.h>
+#include <FileManagement/ArchiveTypes.h>
+#include <FileManagement/ModelFile.h>
+#include <MultiThreading/StdThreading.h>
+#include <DataStructures/STLContainers.h>
+#include <Rendering/Model.h>
+#include <Rendering/Geometry.h>
+#include <Time/GameTime.h>
+#include "../ModelImporterLibrary/ModelConversion.h"
+#include "../ModelImporterLibrary/ModelLog.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+using namespace LeEK;
+
+namespace
+{
+	//Bump this whenever a change to the conversion code changes its output,
+	//so models built by older converters are rebuilt.
+	const U32 CONVERTER_VERSION = 1;
+	//Lists the source hash of each model in the output directory.
+	const char* CACHE_FILENAME = ".lmdlcache";
+	//Characters in a hash, as written to the cache.
+	const U32 HASH_STR_LEN = 32;
+
+	enum JobResult
+	{
+		JOB_PENDING,
+		JOB_CONVERTED,
+		JOB_SKIPPED,
+		JOB_FAILED
+	};
+
+	struct ConvertJob
+	{
+		//relative to the input's root, with '/' separators.
+		String Name;
+		String OutName;
+		//set if the input's a directory.
+		String SourcePath;
+		//set if the input's a ZIP archive.
+		I32 ZipIndex;
+		FileSz Size;
+		String Hash;
+		JobResult Result;
+	};
+
+	//Biggest first, so the long conversions don't all land at the end.
+	bool largerJob(const ConvertJob& lhs, const ConvertJob& rhs)
+	{
+		return lhs.Size > rhs.Size;
+	}
+
+	typedef Map<String, String> HashCache;
+
+	void printUsage()
+	{
+		printf("Usage: ModelConverter <input directory or .zip> <output directory> [options]\n");
+		printf("Options:\n");
+		printf("\t-j <threads>\tnumber of models to convert at once (default: one per core)\n");
+		printf("\t-format <fmt>\tvertex format: full, half or snorm (default full)\n");
+		printf("\t-force\t\tconvert everything, even if it's unchanged\n");
+	}
+
+	String toOutputName(const String& name)
+	{
+		size_t slash = name.find_last_of('/');
+		size_t dot = name.find_last_of('.');
+		if(dot == String::npos || (slash != String::npos && dot < slash))
+		{
+			return name + ".lmdl";
+		}
+		return name.substr(0, dot) + ".lmdl";
+	}
+
+	bool isModelFile(Assimp::Importer& importer, const String& name)
+	{
+		size_t slash = name.find_last_of('/');
+		size_t dot = name.find_last_of('.');
+		if(dot == String::npos || (slash != String::npos && dot < slash))
+		{
+			return false;
+		}
+		return importer.IsExtensionSupported(name.substr(dot).c_str());
+	}
+
+	//Two sources with the same name and different extensions
+	//would write over each other, so only the first one's kept.
+	bool addJob(Vector<ConvertJob>& jobs, Map<String, String>& outNames, ConvertJob& job)
+	{
+		job.OutName = toOutputName(job.Name);
+		Map<String, String>::const_iterator it = outNames.find(job.OutName);
+		if(it != outNames.end())
+		{
+			printf("Skipping %s; %s already converts to %s\n", job.Name.c_str(), it->second.c_str(), job.OutName.c_str());
+			return false;
+		}
+		outNames[job.OutName] = job.Name;
+		job.Result = JOB_PENDING;
+		jobs.push_back(job);
+		return true;
+	}
+
+	void findZipJobs(ZipFile& zip, Vector<ConvertJob>& jobs)
+	{
+		Assimp::Importer importer;
+		Map<String, String> outNames;
+		for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+		{
+			ConvertJob job;
+			job.Name = zip.GetFilename(i);
+			if(!isModelFile(importer, job.Name))
+			{
+				continue;
+			}
+			job.ZipIndex = i;
+			job.Size = zip.GetFileLen(i);
+			addJob(jobs, outNames, job);
+		}
+	}
+
+	void findDirectoryJobs(const Path& dirPath, Vector<ConvertJob>& jobs)
+	{
+		namespace fs = boost::filesystem;
+		Assimp::Importer importer;
+		Map<String, String> outNames;
+		const fs::path& root = dirPath.PathImplementation();
+		for(fs::recursive_directory_iterator it(root), end; it != end; ++it)
+		{
+			if(!fs::is_regular_file(it->status()))
+			{
+				continue;
+			}
+			//names are relative to the input directory.
+			ConvertJob job;
+			job.SourcePath = it->path().generic_string().c_str();
+			job.Name = job.SourcePath.substr(root.generic_string().length());
+			while(!job.Name.empty() && job.Name[0] == '/')
+			{
+				job.Name = job.Name.substr(1);
+			}
+			if(!isModelFile(importer, job.Name))
+			{
+				continue;
+			}
+			job.ZipIndex = -1;
+			job.Size = (FileSz)fs::file_size(it->path());
+			addJob(jobs, outNames, job);
+		}
+	}
+
+	/**
+	Reads the cache as written by writeCache(): a line per model,
+	each its source's hash, a space, and then the source's name.
+	*/
+	void readCache(const Path& cachePath, HashCache& cache)
+	{
+		if(!Filesystem::Exists(cachePath))
+		{
+			return;
+		}
+		DataStream* file = Filesystem::OpenFileReadOnly(cachePath);
+		if(!file)
+		{
+			return;
+		}
+		FileSz size = file->FileSize();
+		char* buf = CustomArrayNew<char>(Math::Max(size, (FileSz)1), RESFILE_ALLOC, "TempBufAlloc");
+		file->Read(buf, size);
+		Filesystem::CloseFile(file);
+		String contents(buf, size);
+		CustomArrayDelete(buf);
+
+		size_t lineStart = 0;
+		while(lineStart < contents.length())
+		{
+			size_t lineEnd = contents.find('\n', lineStart);
+			if(lineEnd == String::npos)
+			{
+				lineEnd = contents.length();
+			}
+			if(lineEnd - lineStart > HASH_STR_LEN + 1)
+			{
+				String name = contents.substr(lineStart + HASH_STR_LEN + 1, lineEnd - lineStart - HASH_STR_LEN - 1);
+				cache[name] = contents.substr(lineStart, HASH_STR_LEN);
+			}
+			lineStart = lineEnd + 1;
+		}
+	}
+
+	//Only models that were converted or skipped go in the cache;
+	//failed ones, and ones that have left the input, are retried next time.
+	bool writeCache(const Path& cachePath, const Vector<ConvertJob>& jobs)
+	{
+		String contents;
+		for(U32 i = 0; i < jobs.size(); ++i)
+		{
+			const ConvertJob& job = jobs[i];
+			if(job.Result == JOB_CONVERTED || job.Result == JOB_SKIPPED)
+			{
+				contents += job.Hash + " " + job.Name + "\n";
+			}
+		}
+		return Filesystem::WriteFile(cachePath, contents.c_str(), contents.length());
+	}
+
+	/**
+	Packs every level of a converted model into the given vertex format.
+	*/
+	bool packModel(const Model& model, VertexFormat format, Model& packedModel)
+	{
+		for(U32 lod = 0; lod < model.LODCount(); ++lod)
+		{
+			U32 lodIdx = lod == 0 ? 0 : packedModel.AddLOD(model.LODError(lod));
+			for(U32 i = 0; i < model.LODMeshCount(lod); ++i)
+			{
+				const Mesh* mesh = model.GetLODMesh(lod, i);
+				Geometry packed = Geometry();
+				if(!GeomHelpers::PackGeometry(mesh->GetGeometry(), format, packed))
+				{
+					return false;
+				}
+				packedModel.AddLODMesh(lodIdx, Mesh(mesh->GetMaterial(), packed));
+			}
+		}
+		packedModel.RecalcBounds();
+		return true;
+	}
+
+	//Each mesh has the only copy of its buffers.
+	void releaseModel(Model& model)
+	{
+		for(U32 lod = 0; lod < model.LODCount(); ++lod)
+		{
+			for(U32 i = 0; i < model.LODMeshCount(lod); ++i)
+			{
+				GeomHelpers::DeleteGeometry(model.GetLODMesh(lod, i)->GetGeometry());
+			}
+		}
+		model.Clear();
+	}
+
+	/**
+	Hands jobs out to every converter thread.
+	*/
+	class ConvertClient : public IThreadClient
+	{
+	private:
+		Vector<ConvertJob>& jobs;
+		const HashCache& cache;
+		ZipFile* zip;
+		Path outDir;
+		VertexFormat format;
+		bool force;
+		//mixed into every hash, so changing the settings rebuilds everything.
+		U32 settingsSeed;
+		Mutex jobMutex;
+		U32 nextJob;
+		//guards the archive, creating directories and printing.
+		Mutex ioMutex;
+
+		bool readSource(const ConvertJob& job, char*& buf)
+		{
+			buf = CustomArrayNew<char>(Math::Max(job.Size, (FileSz)1), RESFILE_ALLOC, "TempBufAlloc");
+			if(zip)
+			{
+				Lock lock(ioMutex);
+				return zip->ReadFile(job.ZipIndex, buf);
+			}
+			DataStream* file = Filesystem::OpenFileReadOnly(Path(job.SourcePath));
+			if(!file)
+			{
+				return false;
+			}
+			bool read = file->Read(buf, job.Size) == job.Size;
+			Filesystem::CloseFile(file);
+			return read;
+		}
+
+		bool writeModel(const ConvertJob& job, const Model& model)
+		{
+			size_t fileSize = ModelMgr::FindFileSize(model);
+			char* fileBuf = CustomArrayNew<char>(fileSize, RESFILE_ALLOC, "TempBufAlloc");
+			bool written = ModelMgr::WriteModelMemory(model, fileBuf, fileSize);
+			if(written)
+			{
+				Path outPath(outDir.ToString() + "/" + job.OutName);
+				{
+					Lock lock(ioMutex);
+					boost::system::error_code err;
+					boost::filesystem::create_directories(outPath.PathImplementation().parent_path(), err);
+				}
+				written = Filesystem::WriteFile(outPath, fileBuf, fileSize);
+			}
+			CustomArrayDelete(fileBuf);
+			return written;
+		}
+
+		JobResult convert(ConvertJob& job)
+		{
+			GameTime timer;
+			char* buf = NULL;
+			if(!readSource(job, buf))
+			{
+				CustomArrayDelete(buf);
+				return JOB_FAILED;
+			}
+			//Only the source itself is hashed; that's all the output depends on.
+			//The importer only gets the source's bytes, not its path,
+			//so it can't find side files like .mtls next to the source,
+			//and textures are referenced by name rather than baked in.
+			//If the importer's ever given the path, hash the side files too.
+			U64 hash[2];
+			MurmurHash3_x64_128(buf, (int)job.Size, settingsSeed, hash);
+			char hashStr[HASH_STR_LEN + 1];
+			sprintf_s(hashStr, sizeof(hashStr), "%016llx%016llx", hash[0], hash[1]);
+			job.Hash = hashStr;
+
+			HashCache::const_iterator cached = cache.find(job.Name);
+			if(	!force && cached != cache.end() && cached->second == job.Hash &&
+				Filesystem::Exists(Path(outDir.ToString() + "/" + job.OutName)))
+			{
+				CustomArrayDelete(buf);
+				return JOB_SKIPPED;
+			}
+
+			Model model = Model();
+			bool imported = ModelConversion::ImportModel(buf, (int)job.Size, NULL, model);
+			CustomArrayDelete(buf);
+			if(!imported)
+			{
+				releaseModel(model);
+				return JOB_FAILED;
+			}
+			bool written;
+			if(format == FULL_VERTEX)
+			{
+				written = writeModel(job, model);
+			}
+			else
+			{
+				Model packedModel = Model();
+				written = packModel(model, format, packedModel) && writeModel(job, packedModel);
+				releaseModel(packedModel);
+			}
+			releaseModel(model);
+			timer.Tick();
+			if(written)
+			{
+				Lock lock(ioMutex);
+				printf("Converted %s (%.2fs)\n", job.Name.c_str(), timer.ElapsedGameTime().ToSeconds());
+			}
+			return written ? JOB_CONVERTED : JOB_FAILED;
+		}
+	public:
+		ConvertClient(Vector<ConvertJob>& jobsParam, const HashCache& cacheParam, ZipFile* zipParam,
+					const Path& outDirParam, VertexFormat formatParam, bool forceParam) :
+			jobs(jobsParam), cache(cacheParam), zip(zipParam), outDir(outDirParam),
+			format(formatParam), force(forceParam), nextJob(0)
+		{
+			U32 settings[3] = { CONVERTER_VERSION, CURR_MODEL_VER, (U32)format };
+			settingsSeed = getHash(settings, sizeof(settings));
+		}
+
+		void Run()
+		{
+			while(true)
+			{
+				U32 jobIdx;
+				{
+					Lock lock(jobMutex);
+					if(nextJob >= jobs.size())
+					{
+						return;
+					}
+					jobIdx = nextJob++;
+				}
+				ConvertJob& job = jobs[jobIdx];
+				job.Result = convert(job);
+				if(job.Result == JOB_FAILED)
+				{
+					Lock lock(ioMutex);
+					printf("Couldn't convert %s!\n", job.Name.c_str());
+				}
+			}
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	Log::SetVerbosity(Log::INFO);
+	Log::SetBufferEnabled(false);
+	//models are converted on several threads at once.
+	HandleMgr::SetThreadSafe(true);
+	//the model log's only read by the model tool.
+	ModelLog::SetBufferEnabled(false);
+	if(argc < 3)
+	{
+		printUsage();
+		return 1;
+	}
+	Path inPath(argv[1]);
+	Path outDir(argv[2]);
+	U32 numThreads = std::thread::hardware_concurrency();
+	VertexFormat format = FULL_VERTEX;
+	bool force = false;
+	for(I32 i = 3; i < argc; ++i)
+	{
+		String arg = argv[i];
+		if(arg == "-j" && i + 1 < argc)
+		{
+			numThreads = (U32)atol(argv[++i]);
+		}
+		else if(arg == "-format" && i + 1 < argc)
+		{
+			String fmt = argv[++i];
+			if(fmt == "full")
+			{
+				format = FULL_VERTEX;
+			}
+			else if(fmt == "half")
+			{
+				format = HALF_POS_VERTEX;
+			}
+			else if(fmt == "snorm")
+			{
+				format = SNORM_POS_VERTEX;
+			}
+			else
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if(arg == "-force")
+		{
+			force = true;
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+	numThreads = Math::Max(numThreads, 1U);
+
+	GameTime timer;
+	Vector<ConvertJob> jobs;
+	ZipFile zip;
+	bool fromZip = !boost::filesystem::is_directory(inPath.PathImplementation());
+	if(fromZip)
+	{
+		if(!zip.Init(inPath))
+		{
+			printf("Couldn't open %s!\n", inPath.ToString().c_str());
+			return 1;
+		}
+		findZipJobs(zip, jobs);
+	}
+	else
+	{
+		findDirectoryJobs(inPath, jobs);
+	}
+	std::sort(jobs.begin(), jobs.end(), largerJob);
+
+	boost::system::error_code err;
+	boost::filesystem::create_directories(outDir.PathImplementation(), err);
+	Path cachePath(outDir.ToString() + "/" + CACHE_FILENAME);
+	HashCache cache;
+	readCache(cachePath, cache);
+
+	ConvertClient client(jobs, cache, fromZip ? &zip : NULL, outDir, format, force);
+	numThreads = Math::Min(numThreads, Math::Max((U32)jobs.size(), 1U));
+	Vector<Thread*> threads;
+	for(U32 i = 0; i < numThreads; ++i)
+	{
+		Thread* thread = LNew(Thread, THREAD_ALLOC, "ThreadAlloc")(&client);
+		thread->Start();
+		threads.push_back(thread);
+	}
+	for(U32 i = 0; i < threads.size(); ++i)
+	{
+		threads[i]->Join();
+		LDelete(threads[i]);
+	}
+
+	U32 counts[JOB_FAILED + 1] = { 0 };
+	for(U32 i = 0; i < jobs.size(); ++i)
+	{
+		++counts[jobs[i].Result];
+	}
+	if(!writeCache(cachePath, jobs))
+	{
+		printf("Couldn't write %s!\n", cachePath.ToString().c_str());
+	}
+	timer.Tick();
+	printf("Converted %u models, skipped %u unchanged, %u failed, in %.2fs on %u threads\n",
+			counts[JOB_CONVERTED], counts[JOB_SKIPPED], counts[JOB_FAILED],
+			timer.ElapsedGameTime().ToSeconds(), numThreads);
+	return counts[JOB_FAILED] > 0 ? 1 : 0;
+}
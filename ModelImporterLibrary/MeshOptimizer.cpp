@@ -0,0 +1,404 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace LeEK;
+
+namespace
+{
+	const I32 NO_VERTEX = -1;
+
+	//Orders vertices by their bytes, so identical vertices end up next to each other.
+	struct VertexBytesLess
+	{
+		const Vertex* Verts;
+		VertexBytesLess(const Vertex* verts) : Verts(verts) {}
+		bool operator()(U32 lhs, U32 rhs) const
+		{
+			return memcmp(&Verts[lhs], &Verts[rhs], sizeof(Vertex)) < 0;
+		}
+	};
+
+	struct ClusterKey
+	{
+		F32 Facing;
+		U32 Start;
+		U32 End;
+	};
+
+	//Sorts clusters most outward-facing first.
+	bool operator<(const ClusterKey& lhs, const ClusterKey& rhs)
+	{
+		return lhs.Facing > rhs.Facing;
+	}
+
+	/**
+	Cache timestamps work like this: every miss bumps the time,
+	and a vertex is in the cache if it missed within the last cacheSize misses.
+	Times start past cacheSize so zeroed stamps count as not cached.
+	@return true if the vertex missed.
+	*/
+	inline bool touchVertex(U32 vert, Vector<U32>& cacheTime, U32& time, U32 cacheSize)
+	{
+		if(time - cacheTime[vert] > cacheSize)
+		{
+			cacheTime[vert] = time;
+			++time;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	Picks the next fanning vertex when none of the last fan's vertices have triangles left.
+	Tries recently used vertices first, then scans forward through the mesh.
+	*/
+	I32 skipDeadEnd(Vector<U32>& deadEnds, const Vector<U32>& liveTris, U32& cursor)
+	{
+		while(!deadEnds.empty())
+		{
+			U32 vert = deadEnds.back();
+			deadEnds.pop_back();
+			if(liveTris[vert] > 0)
+			{
+				return (I32)vert;
+			}
+		}
+		while(cursor < liveTris.size())
+		{
+			U32 vert = cursor++;
+			if(liveTris[vert] > 0)
+			{
+				return (I32)vert;
+			}
+		}
+		return NO_VERTEX;
+	}
+}
+
+F32 MeshOptimizer::FindACMR(const U32* indices, U32 numIndices, U32 numVerts, U32 cacheSize)
+{
+	if(!indices || numIndices < 3)
+	{
+		return 0.0f;
+	}
+	Vector<U32> cacheTime;
+	cacheTime.resize(numVerts, 0);
+	U32 time = cacheSize + 1;
+	U32 misses = 0;
+	for(U32 i = 0; i < numIndices; ++i)
+	{
+		if(touchVertex(indices[i], cacheTime, time, cacheSize))
+		{
+			++misses;
+		}
+	}
+	return (F32)misses / (F32)(numIndices / 3);
+}
+
+U32 MeshOptimizer::WeldVertices(const Vertex* verts, U32 numVerts, U32* indices, U32 numIndices, Vector<Vertex>& vertsOut)
+{
+	vertsOut.clear();
+	if(!verts || numVerts == 0)
+	{
+		return 0;
+	}
+	Vector<U32> order;
+	order.resize(numVerts);
+	for(U32 i = 0; i < numVerts; ++i)
+	{
+		order[i] = i;
+	}
+	//stable, so each run of identical vertices starts with its earliest vertex.
+	std::stable_sort(order.begin(), order.end(), VertexBytesLess(verts));
+
+	Vector<U32> remap;
+	remap.resize(numVerts);
+	U32 runStart = 0;
+	for(U32 i = 0; i < numVerts; ++i)
+	{
+		if(memcmp(&verts[order[i]], &verts[order[runStart]], sizeof(Vertex)) != 0)
+		{
+			runStart = i;
+		}
+		remap[order[i]] = order[runStart];
+	}
+	//Keep the survivors in their original order.
+	Vector<U32> newIndex;
+	newIndex.resize(numVerts);
+	for(U32 i = 0; i < numVerts; ++i)
+	{
+		if(remap[i] == i)
+		{
+			newIndex[i] = vertsOut.size();
+			vertsOut.push_back(verts[i]);
+		}
+	}
+	for(U32 i = 0; i < numIndices; ++i)
+	{
+		indices[i] = newIndex[remap[indices[i]]];
+	}
+	return vertsOut.size();
+}
+
+void MeshOptimizer::OptimizeVertexCache(const U32* indices, U32 numIndices, U32 numVerts, U32 cacheSize,
+										Vector<U32>& indicesOut, Vector<U32>& clustersOut)
+{
+	indicesOut.clear();
+	clustersOut.clear();
+	U32 numTris = numIndices / 3;
+	if(!indices || numTris == 0 || numVerts == 0)
+	{
+		return;
+	}
+	indicesOut.reserve(numTris * 3);
+
+	//Build the vertex -> triangle adjacency;
+	//liveTris counts each vertex's triangles that haven't been emitted yet.
+	Vector<U32> liveTris;
+	liveTris.resize(numVerts, 0);
+	for(U32 i = 0; i < numTris * 3; ++i)
+	{
+		++liveTris[indices[i]];
+	}
+	Vector<U32> adjStart;
+	adjStart.resize(numVerts + 1, 0);
+	for(U32 i = 0; i < numVerts; ++i)
+	{
+		adjStart[i + 1] = adjStart[i] + liveTris[i];
+	}
+	Vector<U32> adjFill;
+	adjFill.assign(adjStart.begin(), adjStart.end() - 1);
+	Vector<U32> adjacency;
+	adjacency.resize(numTris * 3);
+	for(U32 i = 0; i < numTris * 3; ++i)
+	{
+		adjacency[adjFill[indices[i]]++] = i / 3;
+	}
+
+	Vector<U32> cacheTime;
+	cacheTime.resize(numVerts, 0);
+	U32 time = cacheSize + 1;
+	Vector<bool> emitted;
+	emitted.resize(numTris, false);
+	Vector<U32> deadEnds;
+	Vector<U32> candidates;
+	U32 cursor = 1;
+
+	clustersOut.push_back(0);
+	I32 fanVert = 0;
+	while(fanVert != NO_VERTEX)
+	{
+		//Emit every remaining triangle around the fanning vertex.
+		candidates.clear();
+		for(U32 i = adjStart[fanVert]; i < adjStart[fanVert + 1]; ++i)
+		{
+			U32 tri = adjacency[i];
+			if(emitted[tri])
+			{
+				continue;
+			}
+			for(U32 j = 0; j < 3; ++j)
+			{
+				U32 vert = indices[tri*3 + j];
+				indicesOut.push_back(vert);
+				deadEnds.push_back(vert);
+				candidates.push_back(vert);
+				--liveTris[vert];
+				touchVertex(vert, cacheTime, time, cacheSize);
+			}
+			emitted[tri] = true;
+		}
+
+		//Next, fan around whichever of those vertices will still be in the cache
+		//after its own triangles are emitted, preferring the oldest.
+		//If there isn't one, take any of them that still has triangles.
+		I32 nextVert = NO_VERTEX;
+		I32 bestPriority = -1;
+		for(U32 i = 0; i < candidates.size(); ++i)
+		{
+			U32 vert = candidates[i];
+			if(liveTris[vert] == 0)
+			{
+				continue;
+			}
+			I32 priority = 0;
+			if(time - cacheTime[vert] + 2*liveTris[vert] <= cacheSize)
+			{
+				priority = (I32)(time - cacheTime[vert]);
+			}
+			if(priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVert = (I32)vert;
+			}
+		}
+		if(nextVert == NO_VERTEX)
+		{
+			nextVert = skipDeadEnd(deadEnds, liveTris, cursor);
+			//The mesh was left at a dead end, so a new cluster starts here.
+			U32 emittedTris = indicesOut.size() / 3;
+			if(nextVert != NO_VERTEX && clustersOut.back() != emittedTris)
+			{
+				clustersOut.push_back(emittedTris);
+			}
+		}
+		fanVert = nextVert;
+	}
+}
+
+void MeshOptimizer::OptimizeOverdraw(	const Vertex* verts, U32 numVerts, U32* indices, U32 numIndices,
+										const Vector<U32>& clusters, U32 cacheSize, F32 threshold)
+{
+	U32 numTris = numIndices / 3;
+	if(!verts || !indices || numTris == 0 || clusters.empty())
+	{
+		return;
+	}
+
+	//Split the clusters further wherever the piece so far
+	//has a good enough ACMR with a cold cache, since after sorting
+	//we can't count on the previous cluster's vertices being cached.
+	F32 targetACMR = FindACMR(indices, numIndices, numVerts, cacheSize) * threshold;
+	Vector<U32> cacheTime;
+	cacheTime.resize(numVerts, 0);
+	U32 time = cacheSize + 1;
+	Vector<U32> splitStarts;
+	for(U32 c = 0; c < clusters.size(); ++c)
+	{
+		U32 start = clusters[c];
+		U32 end = c + 1 < clusters.size() ? clusters[c + 1] : numTris;
+		//skipping ahead this far evicts everything.
+		time += cacheSize + 1;
+		splitStarts.push_back(start);
+		U32 pieceStart = start;
+		U32 misses = 0;
+		for(U32 tri = start; tri < end; ++tri)
+		{
+			for(U32 j = 0; j < 3; ++j)
+			{
+				if(touchVertex(indices[tri*3 + j], cacheTime, time, cacheSize))
+				{
+					++misses;
+				}
+			}
+			if(tri + 1 < end && (F32)misses <= targetACMR * (F32)(tri + 1 - pieceStart))
+			{
+				splitStarts.push_back(tri + 1);
+				pieceStart = tri + 1;
+				misses = 0;
+				time += cacheSize + 1;
+			}
+		}
+	}
+
+	//Clusters facing away from the mesh's center are probably on its outside,
+	//where they'll hide the clusters behind them; draw those first.
+	Vector3 meshCenter = Vector3::Zero;
+	for(U32 i = 0; i < numVerts; ++i)
+	{
+		meshCenter += verts[i].Position;
+	}
+	meshCenter = meshCenter / (F32)numVerts;
+
+	Vector<ClusterKey> keys;
+	keys.resize(splitStarts.size());
+	for(U32 c = 0; c < splitStarts.size(); ++c)
+	{
+		ClusterKey& key = keys[c];
+		key.Start = splitStarts[c];
+		key.End = c + 1 < splitStarts.size() ? splitStarts[c + 1] : numTris;
+		//Area weighted centroid and normal;
+		//the cross product's length is twice the triangle's area, so weighting's free.
+		Vector3 centroid = Vector3::Zero;
+		Vector3 normal = Vector3::Zero;
+		F32 totalArea = 0.0f;
+		for(U32 tri = key.Start; tri < key.End; ++tri)
+		{
+			const Vector3& p0 = verts[indices[tri*3]].Position;
+			const Vector3& p1 = verts[indices[tri*3 + 1]].Position;
+			const Vector3& p2 = verts[indices[tri*3 + 2]].Position;
+			Vector3 areaNormal = (p1 - p0).Cross(p2 - p0);
+			F32 area = areaNormal.Length();
+			centroid += (p0 + p1 + p2) * (area / 3.0f);
+			normal += areaNormal;
+			totalArea += area;
+		}
+		key.Facing = 0.0f;
+		if(totalArea > 0.0f && normal.LengthSquared() > 0.0f)
+		{
+			centroid = centroid / totalArea;
+			normal.Normalize();
+			key.Facing = (centroid - meshCenter).Dot(normal);
+		}
+	}
+	std::stable_sort(keys.begin(), keys.end());
+
+	Vector<U32> sorted;
+	sorted.reserve(numTris * 3);
+	for(U32 c = 0; c < keys.size(); ++c)
+	{
+		sorted.insert(sorted.end(), indices + keys[c].Start*3, indices + keys[c].End*3);
+	}
+	memcpy(indices, &sorted[0], sorted.size() * sizeof(U32));
+}
+
+void MeshOptimizer::OptimizeVertexFetch(Vector<Vertex>& verts, Vector<U32>& indices)
+{
+	const U32 UNUSED = 0xFFFFFFFF;
+	Vector<U32> newIndex;
+	newIndex.resize(verts.size(), UNUSED);
+	Vector<Vertex> reordered;
+	reordered.reserve(verts.size());
+	for(U32 i = 0; i < indices.size(); ++i)
+	{
+		U32& vert = indices[i];
+		if(newIndex[vert] == UNUSED)
+		{
+			newIndex[vert] = reordered.size();
+			reordered.push_back(verts[vert]);
+		}
+		vert = newIndex[vert];
+	}
+	verts.swap(reordered);
+}
+
+MeshOptimizer::OptimizeStats MeshOptimizer::OptimizeMesh(	const Vertex* verts, U32 numVerts,
+															const U32* indices, U32 numIndices,
+															Vector<Vertex>& vertsOut, Vector<U32>& indicesOut)
+{
+	OptimizeStats stats;
+	stats.VertsBefore = numVerts;
+
+	Vector<U32> weldedInds;
+	weldedInds.assign(indices, indices + numIndices);
+	U32 numWelded = WeldVertices(verts, numVerts, numIndices > 0 ? &weldedInds[0] : NULL, numIndices, vertsOut);
+	//Welding can collapse triangles to lines or points; those can go.
+	U32 numKept = 0;
+	for(U32 i = 0; i + 2 < numIndices; i += 3)
+	{
+		U32 a = weldedInds[i], b = weldedInds[i + 1], c = weldedInds[i + 2];
+		if(a != b && b != c && a != c)
+		{
+			weldedInds[numKept++] = a;
+			weldedInds[numKept++] = b;
+			weldedInds[numKept++] = c;
+		}
+	}
+	weldedInds.resize(numKept);
+	numIndices = numKept;
+	//Measured on the welded mesh in its source triangle order;
+	//unwelded, every vertex is a miss no matter the order.
+	stats.ACMRBefore = FindACMR(numIndices > 0 ? &weldedInds[0] : NULL, numIndices, numWelded);
+	Vector<U32> clusters;
+	OptimizeVertexCache(numIndices > 0 ? &weldedInds[0] : NULL, numIndices, numWelded, VERTEX_CACHE_SIZE, indicesOut, clusters);
+	if(!indicesOut.empty())
+	{
+		OptimizeOverdraw(&vertsOut[0], numWelded, &indicesOut[0], indicesOut.size(), clusters, VERTEX_CACHE_SIZE, OVERDRAW_ACMR_THRESHOLD);
+	}
+	OptimizeVertexFetch(vertsOut, indicesOut);
+
+	stats.VertsAfter = vertsOut.size();
+	stats.ACMRAfter = FindACMR(indicesOut.empty() ? NULL : &indicesOut[0], indicesOut.size(), vertsOut.size());
+	return stats;
+}
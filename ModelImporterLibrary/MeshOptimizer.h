@@ -0,0 +1,77 @@
+#pragma once
+#include "../LeEK/Datatypes.h"
+#include "../LeEK/DataStructures/STLContainers.h"
+#include "../LeEK/Rendering/Geometry.h"
+
+namespace LeEK
+{
+	/**
+	Offline mesh optimization, run on imported meshes before they're written out.
+	Everything here works on triangle lists.
+	*/
+	namespace MeshOptimizer
+	{
+		//Post-transform cache size the optimizer targets.
+		//Real caches vary, but orderings built for 16 entries do well on all of them.
+		const U32 VERTEX_CACHE_SIZE = 16;
+		//Clusters are split wherever that keeps their ACMR
+		//within this factor of the cache optimized mesh's.
+		const F32 OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+		struct OptimizeStats
+		{
+			U32 VertsBefore;
+			U32 VertsAfter;
+			F32 ACMRBefore;
+			F32 ACMRAfter;
+		};
+
+		/**
+		Finds the average cache miss ratio (misses per triangle)
+		of a triangle list run through a FIFO cache of the given size.
+		3 is the worst possible; about 0.5 is the best a large regular mesh can do.
+		*/
+		F32 FindACMR(const U32* indices, U32 numIndices, U32 numVerts, U32 cacheSize = VERTEX_CACHE_SIZE);
+
+		/**
+		Merges vertices that are exactly identical.
+		@param indices rewritten to index into vertsOut.
+		@return the number of unique vertices.
+		*/
+		U32 WeldVertices(const Vertex* verts, U32 numVerts, U32* indices, U32 numIndices, Vector<Vertex>& vertsOut);
+
+		/**
+		Reorders triangles for the post-transform vertex cache, using Tipsify
+		(Sander, Nehab & Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+		@param clustersOut receives the index of the first triangle of each cluster -
+		the runs Tipsify emitted without having to jump elsewhere in the mesh.
+		*/
+		void OptimizeVertexCache(	const U32* indices, U32 numIndices, U32 numVerts, U32 cacheSize,
+									Vector<U32>& indicesOut, Vector<U32>& clustersOut);
+
+		/**
+		Reorders the clusters of a cache optimized triangle list
+		so that clusters facing out from the mesh's center are drawn first,
+		and tend to occlude the rest. Clusters are split further first
+		while that costs less than threshold in ACMR.
+		@param indices the list from OptimizeVertexCache(); reordered in place.
+		*/
+		void OptimizeOverdraw(	const Vertex* verts, U32 numVerts, U32* indices, U32 numIndices,
+								const Vector<U32>& clusters, U32 cacheSize, F32 threshold);
+
+		/**
+		Reorders vertices into the order the triangle list first uses them,
+		so vertex fetches walk through memory. Unused vertices are dropped.
+		*/
+		void OptimizeVertexFetch(Vector<Vertex>& verts, Vector<U32>& indices);
+
+		/**
+		Runs all of the above, in order.
+		Triangles that weld down to a line or point are dropped,
+		so indicesOut may be shorter than the input.
+		*/
+		OptimizeStats OptimizeMesh(	const Vertex* verts, U32 numVerts,
+									const U32* indices, U32 numIndices,
+									Vector<Vertex>& vertsOut, Vector<U32>& indicesOut);
+	}
+}
@@ -0,0 +1,132 @@
+#include "../LeEK/Math/BatchMath.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+
+using namespace LeEK;
+
+namespace
+{
+	//Grid coordinates get 21 bits per axis, so a cell fits in a U64 key.
+	const U32 CELL_COORD_BITS = 21;
+	const U32 MAX_CELL_COORD = (1 << CELL_COORD_BITS) - 1;
+
+	struct ClusterEntry
+	{
+		U64 Cell;
+		U32 Vertex;
+	};
+
+	bool operator<(const ClusterEntry& lhs, const ClusterEntry& rhs)
+	{
+		return lhs.Cell < rhs.Cell;
+	}
+
+	U32 cellCoord(F32 pos, F32 min, F32 invCellSize)
+	{
+		U32 coord = (U32)((pos - min) * invCellSize);
+		return Math::Min(coord, MAX_CELL_COORD);
+	}
+}
+
+F32 MeshSimplifier::SimplifyByClustering(	const Vertex* verts, U32 numVerts,
+											const U32* indices, U32 numIndices,
+											F32 cellSize,
+											Vector<Vertex>& vertsOut, Vector<U32>& indicesOut)
+{
+	vertsOut.clear();
+	indicesOut.clear();
+	if(!verts || !indices || numVerts == 0 || cellSize <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	Vector3 min = verts[0].Position;
+	Vector3 max = verts[0].Position;
+	BatchMath::ExpandAABB(&verts[0].Position, numVerts, min, max, sizeof(Vertex));
+	F32 invCellSize = 1.0f / cellSize;
+
+	//Sort the vertices by cell, so each cluster's vertices are together.
+	Vector<ClusterEntry> entries;
+	entries.resize(numVerts);
+	for(U32 i = 0; i < numVerts; ++i)
+	{
+		const Vector3& pos = verts[i].Position;
+		U64 x = cellCoord(pos.X(), min.X(), invCellSize);
+		U64 y = cellCoord(pos.Y(), min.Y(), invCellSize);
+		U64 z = cellCoord(pos.Z(), min.Z(), invCellSize);
+		entries[i].Cell = x | (y << CELL_COORD_BITS) | (z << (2*CELL_COORD_BITS));
+		entries[i].Vertex = i;
+	}
+	std::sort(entries.begin(), entries.end());
+
+	//Now merge each cluster.
+	Vector<U32> remap;
+	remap.resize(numVerts);
+	F32 maxErrorSqr = 0.0f;
+	U32 clusterStart = 0;
+	while(clusterStart < numVerts)
+	{
+		U32 clusterEnd = clusterStart + 1;
+		while(clusterEnd < numVerts && entries[clusterEnd].Cell == entries[clusterStart].Cell)
+		{
+			++clusterEnd;
+		}
+		//The merged vertex sits at the cluster's average position, with its averaged normal.
+		Vector3 avgPos = Vector3::Zero;
+		Vector3 avgNorm = Vector3::Zero;
+		for(U32 i = clusterStart; i < clusterEnd; ++i)
+		{
+			const Vertex& vert = verts[entries[i].Vertex];
+			avgPos += vert.Position;
+			avgNorm += vert.Normal;
+		}
+		avgPos /= (F32)(clusterEnd - clusterStart);
+		//Averaging colors and UVs would smear them across texture seams,
+		//so those come from whichever vertex is closest to the merged one.
+		U32 closest = entries[clusterStart].Vertex;
+		F32 closestDistSqr = (verts[closest].Position - avgPos).LengthSquared();
+		U32 newIdx = vertsOut.size();
+		for(U32 i = clusterStart; i < clusterEnd; ++i)
+		{
+			U32 vertIdx = entries[i].Vertex;
+			F32 distSqr = (verts[vertIdx].Position - avgPos).LengthSquared();
+			if(distSqr < closestDistSqr)
+			{
+				closest = vertIdx;
+				closestDistSqr = distSqr;
+			}
+			maxErrorSqr = Math::Max(maxErrorSqr, distSqr);
+			remap[vertIdx] = newIdx;
+		}
+		Vertex merged = verts[closest];
+		merged.Position = avgPos;
+		merged.Normal = avgNorm.GetNormalized();
+		vertsOut.push_back(merged);
+
+		clusterStart = clusterEnd;
+	}
+
+	//Rebuild the triangles on the merged vertices.
+	indicesOut.reserve(numIndices);
+	for(U32 i = 0; i + 2 < numIndices; i += 3)
+	{
+		U32 a = remap[indices[i]];
+		U32 b = remap[indices[i + 1]];
+		U32 c = remap[indices[i + 2]];
+		if(a == b || b == c || a == c)
+		{
+			continue;
+		}
+		indicesOut.push_back(a);
+		indicesOut.push_back(b);
+		indicesOut.push_back(c);
+	}
+	//Every triangle might have collapsed;
+	//in that case there's nothing worth drawing.
+	if(indicesOut.empty())
+	{
+		vertsOut.clear();
+	}
+
+	return Math::Sqrt(maxErrorSqr);
+}
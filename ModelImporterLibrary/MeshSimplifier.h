@@ -0,0 +1,31 @@
+#pragma once
+#include "../LeEK/Datatypes.h"
+#include "../LeEK/DataStructures/STLContainers.h"
+#include "../LeEK/Rendering/Geometry.h"
+
+namespace LeEK
+{
+	/**
+	Offline mesh simplification, used to generate a model's lower LODs.
+	*/
+	namespace MeshSimplifier
+	{
+		/**
+		Simplifies a triangle list by vertex clustering:
+		space is divided into a grid of cubes, and all the vertices
+		in each cube are merged into one.
+		Triangles that collapse to a line or point are dropped.
+		This doesn't preserve topology, but it's fast and handles any input,
+		which is what we want for distant LODs.
+		@param cellSize the edge length of each grid cube.
+		Larger cells give simpler meshes.
+		@param vertsOut, indicesOut receive the simplified mesh.
+		@return the geometric error of the result -
+		the furthest any vertex was moved.
+		*/
+		F32 SimplifyByClustering(	const Vertex* verts, U32 numVerts,
+									const U32* indices, U32 numIndices,
+									F32 cellSize,
+									Vector<Vertex>& vertsOut, Vector<U32>& indicesOut);
+	}
+}
@@ -1,10 +1,11 @@
 #include "../LeEK/Datatypes.h"
-//#include "../LeEK/Constants/AllocTypes.h"
+#include "../LeEK/Constants/AllocTypes.h"
 //#include "../LeEK/Memory/Allocator.h"
 
 #include "../LeEK/Math/Vector3.h"
 #include "../LeEK/Math/Vector2.h"
 #include "../LeEK/Math/Matrix4x4.h"
+#include "../LeEK/Math/BatchMath.h"
 //#include "../LeEK/Logging/Log.h"
 
 #include "../LeEK/Rendering/Material.h"
@@ -19,14 +20,145 @@
 
 #include "ModelLog.h"
 #include "ModelConversion.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
 
 using namespace LeEK;
 using namespace ModelConversion;
 
-GameTime gameTime = GameTime();
+//LOD 1 is simplified on a grid this many cells across the model;
+//each level after that halves the resolution.
+const U32 FIRST_LOD_GRID_CELLS = 64;
+
+/**
+Finds the length of the diagonal of the scene's bounding box.
+Rotations don't change this, so it's fine to use the unconverted data.
+*/
+F32 findSceneSize(const aiScene* scene)
+{
+	aiVector3D min, max;
+	bool first = true;
+	for(U32 i = 0; i < scene->mNumMeshes; ++i)
+	{
+		aiMesh* mesh = scene->mMeshes[i];
+		for(U32 j = 0; j < mesh->mNumVertices; ++j)
+		{
+			const aiVector3D& pos = mesh->mVertices[j];
+			if(first)
+			{
+				min = max = pos;
+				first = false;
+				continue;
+			}
+			min.x = Math::Min(min.x, pos.x);
+			min.y = Math::Min(min.y, pos.y);
+			min.z = Math::Min(min.z, pos.z);
+			max.x = Math::Max(max.x, pos.x);
+			max.y = Math::Max(max.y, pos.y);
+			max.z = Math::Max(max.z, pos.z);
+		}
+	}
+	return first ? 0.0f : (max - min).Length();
+}
+
+/**
+Running totals for the optimization report.
+ACMRs are weighted by triangle count.
+*/
+struct OptimizeTotals
+{
+	U32 VertsBefore;
+	U32 VertsAfter;
+	F32 WeightedACMRBefore;
+	F32 WeightedACMRAfter;
+	U32 TrisBefore;
+	U32 TrisAfter;
+
+	OptimizeTotals() : VertsBefore(0), VertsAfter(0), WeightedACMRBefore(0), WeightedACMRAfter(0), TrisBefore(0), TrisAfter(0) {}
+	void Add(const MeshOptimizer::OptimizeStats& stats, U32 trisBefore, U32 trisAfter)
+	{
+		VertsBefore += stats.VertsBefore;
+		VertsAfter += stats.VertsAfter;
+		WeightedACMRBefore += stats.ACMRBefore * trisBefore;
+		WeightedACMRAfter += stats.ACMRAfter * trisAfter;
+		TrisBefore += trisBefore;
+		TrisAfter += trisAfter;
+	}
+};
+
+void logOptimizeStats(const string& prefix, U32 vertsBefore, U32 vertsAfter, F32 acmrBefore, F32 acmrAfter)
+{
+	ModelLog::D(prefix + "vertices " + vertsBefore + " -> " + vertsAfter + 
+				", ACMR " + acmrBefore + " -> " + acmrAfter);
+}
+
+/**
+Welds and reorders a mesh in place with MeshOptimizer.
+The mesh can only shrink, so the buffers don't need to be reallocated.
+*/
+void optimizeMesh(Vertex* verts, U32& numVerts, U32* indices, U32& numIndices, const string& logPrefix, OptimizeTotals& totals)
+{
+	Vector<Vertex> optVerts;
+	Vector<U32> optInds;
+	MeshOptimizer::OptimizeStats stats = MeshOptimizer::OptimizeMesh(verts, numVerts, indices, numIndices, optVerts, optInds);
+	if(!optVerts.empty())
+	{
+		memcpy(verts, &optVerts[0], optVerts.size() * sizeof(Vertex));
+	}
+	if(!optInds.empty())
+	{
+		memcpy(indices, &optInds[0], optInds.size() * sizeof(U32));
+	}
+	totals.Add(stats, numIndices / 3, optInds.size() / 3);
+	numVerts = optVerts.size();
+	numIndices = optInds.size();
+	logOptimizeStats(logPrefix, stats.VertsBefore, stats.VertsAfter, stats.ACMRBefore, stats.ACMRAfter);
+}
+
+/**
+Simplifies a converted mesh once for each generated LOD.
+*/
+void generateLODs(const Vertex* verts, U32 numVerts, const U32* indices, U32 numIndices,
+				  F32 sceneSize, U32 meshIdx, U32 numMeshes, Geometry* lodGeomList, F32* lodErrors, OptimizeTotals& totals)
+{
+	Vector<Vertex> lodVerts;
+	Vector<U32> lodInds;
+	for(U32 lod = 0; lod < NUM_GENERATED_LODS; ++lod)
+	{
+		F32 cellSize = sceneSize / (F32)(FIRST_LOD_GRID_CELLS >> lod);
+		F32 error = MeshSimplifier::SimplifyByClustering(verts, numVerts, indices, numIndices, cellSize, lodVerts, lodInds);
+		lodErrors[lod] = Math::Max(lodErrors[lod], error);
+		if(lodVerts.empty())
+		{
+			ModelLog::V(string("\tLOD ") + (lod + 1) + ": mesh simplified away");
+			continue;
+		}
+		Vertex* newVerts = CustomArrayNew<Vertex>(lodVerts.size(), 0, "DebugMeshInit");
+		U32* newInds = CustomArrayNew<U32>(lodInds.size(), MESH_ALLOC, "MeshIndexAlloc");
+		if(!newVerts || !newInds)
+		{
+			ModelLog::W(string("Out of memory building LOD ") + (lod + 1) + "!");
+			return;
+		}
+		memcpy(newVerts, &lodVerts[0], lodVerts.size() * sizeof(Vertex));
+		memcpy(newInds, &lodInds[0], lodInds.size() * sizeof(U32));
+		U32 numLODVerts = lodVerts.size();
+		U32 numLODInds = lodInds.size();
+		optimizeMesh(newVerts, numLODVerts, newInds, numLODInds, string("\tLOD ") + (lod + 1) + " optimized: ", totals);
+		lodGeomList[lod*numMeshes + meshIdx].Initialize(HandleMgr::RegisterPtr((void*)newVerts),
+														HandleMgr::RegisterPtr((void*)newInds),
+														numLODVerts,
+														numLODInds,
+														1);
+		ModelLog::V(string("\tLOD ") + (lod + 1) + ": " + (U32)lodVerts.size() + " vertices, " + 
+					(U32)(lodInds.size() / 3) + " triangles, error " + error);
+	}
+}
 
 void ModelConversion::listMeshDetails(const aiScene* scene)
 {
+	//timers are per call, so models can be converted on several threads.
+	GameTime gameTime;
 	ModelLog::D("Meshes:");
 	for(U32 i = 0; i < scene->mNumMeshes; ++i)
 	{
@@ -52,6 +184,7 @@ void ModelConversion::listMeshDetails(const aiScene* scene)
 }
 void ModelConversion::listMaterialDetails(const aiScene* scene)
 {
+	GameTime gameTime;
 	aiString name;
 	aiColor3D color(0,0,0);
 	U32 intVal = 0;
@@ -89,9 +222,21 @@ void ModelConversion::listMaterialDetails(const aiScene* scene)
 	}
 }
 
-void ModelConversion::convertMeshData(const aiScene* scene, Geometry* geomList)
+void ModelConversion::convertMeshData(const aiScene* scene, Geometry* geomList, Geometry* lodGeomList, F32* lodErrors)
 {
+	GameTime gameTime;
 	F32 totalLoadTimeSecs = 0;
+	//LODs are simplified on a grid sized to the whole scene,
+	//so each level has about the same error in every mesh.
+	F32 sceneSize = 0;
+	if(lodGeomList)
+	{
+		sceneSize = findSceneSize(scene);
+		for(U32 lod = 0; lod < NUM_GENERATED_LODS; ++lod)
+		{
+			lodErrors[lod] = 0;
+		}
+	}
 	//super fun - we need to convert the mesh's vector data to our vector version,
 	//then pass that converted data to the geometry.
 	//since we're here, might as well dynamically allocate the temporary buffers, too.
@@ -101,6 +246,8 @@ void ModelConversion::convertMeshData(const aiScene* scene, Geometry* geomList)
 	Vector3* convertedNorms = new Vector3[MAX_ELEMENTS];
 	Vector2* convertedUVs = new Vector2[MAX_ELEMENTS];
 	U32* indices = new U32[MAX_ELEMENTS];
+	OptimizeTotals totals;
+	OptimizeTotals lodTotals;
 	for(U32 i = 0; i < scene->mNumMeshes; ++i)
 	{
 		gameTime.Tick();
@@ -129,8 +276,7 @@ void ModelConversion::convertMeshData(const aiScene* scene, Geometry* geomList)
 		for(U32 j = 0; j < numVerts; ++j)
 		{
 			aiVector3D& pos = mesh->mVertices[j];
-			Vector3 newPos = Vector3(pos.x, pos.y, pos.z);
-			convertedPos[j] = convertUpAxis.MultiplyPoint(newPos);
+			convertedPos[j] = Vector3(pos.x, pos.y, pos.z);
 			if(hasColor)
 			{
 				aiColor4D& color = mesh->mColors[0][j];
@@ -143,7 +289,7 @@ void ModelConversion::convertMeshData(const aiScene* scene, Geometry* geomList)
 			if(hasNormals)
 			{
 				aiVector3D& norm = mesh->mNormals[j];
-				convertedNorms[j] = convertUpAxis.MultiplyVector(Vector3(norm.x, norm.y, norm.z));
+				convertedNorms[j] = Vector3(norm.x, norm.y, norm.z);
 			}
 			else
 			{
@@ -163,6 +309,12 @@ void ModelConversion::convertMeshData(const aiScene* scene, Geometry* geomList)
 				convertedUVs[j] = Vector2::Zero;
 			}
 		}
+		//rotate everything in one go, rather than a vertex at a time.
+		BatchMath::TransformPoints(convertUpAxis, convertedPos, convertedPos, numVerts);
+		if(hasNormals)
+		{
+			BatchMath::TransformVectors(convertUpAxis, convertedNorms, convertedNorms, numVerts);
+		}
 		//index is a little easier to iterate over.
 		for(U32 j = 0; j < numFaces; ++j)
 		{
@@ -187,29 +339,60 @@ void ModelConversion::convertMeshData(const aiScene* scene, Geometry* geomList)
 		{
 			ModelLog::W(string("Failed to load mesh ") + i + "!");
 		}
-		U32* inds = new U32[numIndices * 3];
+		else
+		{
+			//weld and reorder the mesh for the vertex cache before
+			//anything (including the LODs) is built from it.
+			optimizeMesh(vertHnd.Ptr(), numVerts, indices, numIndices, "\tOptimized: ", totals);
+		}
+		U32* inds = CustomArrayNew<U32>(numIndices, MESH_ALLOC, "MeshIndexAlloc");
 		memcpy(inds, indices, numIndices * sizeof(U32));
 		geomList[i].Initialize(vertHnd,
 							HandleMgr::RegisterPtr((void*)inds),
 							numVerts, 
 							numIndices, 
 							1);
+
+		if(lodGeomList && vertHnd.GetHandle())
+		{
+			generateLODs(vertHnd.Ptr(), numVerts, indices, numIndices, sceneSize, i, scene->mNumMeshes, lodGeomList, lodErrors, lodTotals);
+		}
 					
 		gameTime.Tick();
 		F32 loadTimeSecs = gameTime.ElapsedGameTime().ToSeconds();
 		ModelLog::D(string("Mesh loaded in ") + loadTimeSecs + "s");
 		totalLoadTimeSecs += loadTimeSecs;
 	}
+	//the selector expects each level to be coarser than the last.
+	if(lodGeomList)
+	{
+		for(U32 lod = 1; lod < NUM_GENERATED_LODS; ++lod)
+		{
+			lodErrors[lod] = Math::Max(lodErrors[lod], lodErrors[lod - 1]);
+		}
+	}
 	//now get rid of the buffers!
 	delete[] convertedColor;
 	delete[] convertedPos;
 	delete[] convertedNorms;
+	delete[] convertedUVs;
 	delete[] indices;
 	ModelLog::D(string("All meshes loaded in ") + totalLoadTimeSecs + "s");
+	if(totals.TrisBefore > 0 && totals.TrisAfter > 0)
+	{
+		logOptimizeStats("Optimized model: ", totals.VertsBefore, totals.VertsAfter,
+						totals.WeightedACMRBefore / totals.TrisBefore, totals.WeightedACMRAfter / totals.TrisAfter);
+	}
+	if(lodTotals.TrisBefore > 0 && lodTotals.TrisAfter > 0)
+	{
+		logOptimizeStats("Optimized LODs: ", lodTotals.VertsBefore, lodTotals.VertsAfter,
+						lodTotals.WeightedACMRBefore / lodTotals.TrisBefore, lodTotals.WeightedACMRAfter / lodTotals.TrisAfter);
+	}
 }
 
 bool ModelConversion::ImportModel(char* data, int dataSize, Geometry* geomList, Model& outputModel)
 {
+	GameTime gameTime;
 	Assimp::Importer importer;
 	importer.SetPropertyInteger(AI_CONFIG_PP_FD_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
 
@@ -258,11 +441,18 @@ bool ModelConversion::ImportModel(char* data, int dataSize, Geometry* geomList,
 	geomList = new Geometry[scene->mNumMeshes];
 	memset(geomList, 0, scene->mNumMeshes*sizeof(Geometry));
 
-	//convert the Assimp data into a mesh
-	convertMeshData(scene, geomList);
+	//convert the Assimp data into a mesh,
+	//and generate its lower LODs.
+	Geometry* lodGeomList = new Geometry[NUM_GENERATED_LODS * scene->mNumMeshes];
+	F32 lodErrors[NUM_GENERATED_LODS];
+	convertMeshData(scene, geomList, lodGeomList, lodErrors);
 
 	//now compile the model
-	if(!buildModel(outputModel, geomList, numMeshes))
+	bool built = buildModel(outputModel, geomList, numMeshes, lodGeomList, lodErrors);
+	//the meshes have copies of the geometry now
+	delete[] geomList;
+	delete[] lodGeomList;
+	if(!built)
 	{
 		ModelLog::E("Model compilation failed!");
 		return false;
@@ -271,7 +461,7 @@ bool ModelConversion::ImportModel(char* data, int dataSize, Geometry* geomList,
 	return true;
 }
 
-bool ModelConversion::buildModel(Model& model, Geometry* geomList, int numMeshes)
+bool ModelConversion::buildModel(Model& model, Geometry* geomList, int numMeshes, Geometry* lodGeomList, const F32* lodErrors)
 {
 	//there must be a geometry list, or this is pointless
 	if(geomList == NULL)
@@ -296,6 +486,24 @@ bool ModelConversion::buildModel(Model& model, Geometry* geomList, int numMeshes
 		//and insert the new mesh
 		model.AddMesh(mesh);
 	}
+	//then any lower LODs
+	if(lodGeomList && lodErrors)
+	{
+		for(U32 lod = 0; lod < NUM_GENERATED_LODS; ++lod)
+		{
+			U32 lodIdx = model.AddLOD(lodErrors[lod]);
+			for(U32 i = 0; i < numMeshes; ++i)
+			{
+				const Geometry& lodGeom = lodGeomList[lod*numMeshes + i];
+				//empty meshes simplified away entirely
+				if(lodGeom.VertexCount() == 0)
+				{
+					continue;
+				}
+				model.AddLODMesh(lodIdx, Mesh(defMat, lodGeom));
+			}
+		}
+	}
 	//bounds are definitely invalid, recalc
 	model.RecalcBounds();
 	ModelLog::D("Built model from imported data!");
@@ -20,17 +20,27 @@ namespace LeEK
 		void listMeshDetails(const aiScene* scene);
 		void listMaterialDetails(const aiScene* scene);
 
+		//Number of lower detail levels generated for imported models.
+		const U32 NUM_GENERATED_LODS = 3;
+
 		/**
 		Converts the imported data into a list of Geometry elements.
+		@param lodGeomList if not null, receives simplified versions of each mesh.
+		Must hold NUM_GENERATED_LODS * (number of meshes) elements;
+		LOD 1's meshes come first, then LOD 2's, and so on.
+		Meshes that simplify away to nothing are left empty.
+		@param lodErrors if lodGeomList isn't null, receives the geometric error
+		of each generated level. Must hold NUM_GENERATED_LODS elements.
 		*/
-		void convertMeshData(const aiScene* scene, Geometry* geomList);
+		void convertMeshData(const aiScene* scene, Geometry* geomList, Geometry* lodGeomList = NULL, F32* lodErrors = NULL);
 		/**
 		Compiles the given Geometry elements into a Model.
 		@param model the model to be generated.
 		@param geomList the input geometry.
 		@param numMeshes the number of meshes in the model.
+		@param lodGeomList, lodErrors the lower detail levels from convertMeshData(), if any.
 		*/
-		bool buildModel(Model& model, Geometry* geomList, int numMeshes);
+		bool buildModel(Model& model, Geometry* geomList, int numMeshes, Geometry* lodGeomList = NULL, const F32* lodErrors = NULL);
 		//bool exportModel(Model& model, string outPath);
 
 		/**
@@ -39,6 +49,7 @@ namespace LeEK
 		@param dataSize the size of the model file.
 		@param geomList a Geometry array to be constructed. If this is NOT null, it will be deleted!
 		@param outputModel the model to be generated.
+		Models can be imported on several threads at once.
 		*/
 		bool ImportModel(char* data, int dataSize, Geometry* geomList, Model& outputModel);
 	}
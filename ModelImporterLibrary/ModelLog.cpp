@@ -2,6 +2,7 @@
 #include "../LeEK/Time/DateTime.h"
 #include "../LeEK/Logging/Log.h"
 #include <vector>
+#include <mutex>
 
 using namespace LeEK;
 
@@ -30,8 +31,16 @@ typedef vector<LogElemPair> LogVec;
 
 LogVec buffer = LogVec();
 
+//conversions can run on several threads at once.
+std::mutex& bufferMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
 void ModelLog::bufferMessage(string message, ModelLog::Verbosity verb)
 {
+	std::lock_guard<std::mutex> lock(bufferMutex());
 	//now put message in buffer
 	buffer.push_back(LogElemPair(verb, message));
 }
@@ -47,11 +56,13 @@ ModelLog::~ModelLog(void)
 
 unsigned int ModelLog::BufferLength()
 {
+	std::lock_guard<std::mutex> lock(bufferMutex());
 	return buffer.size();
 }
 
 string ModelLog::GetMsg(unsigned int idx)
 {
+	std::lock_guard<std::mutex> lock(bufferMutex());
 	if(idx > buffer.size())
 	{
 		return "";
@@ -61,6 +72,7 @@ string ModelLog::GetMsg(unsigned int idx)
 
 ModelLog::Verbosity ModelLog::GetMsgVerbosity(unsigned int idx)
 {
+	std::lock_guard<std::mutex> lock(bufferMutex());
 	if(idx > buffer.size())
 	{
 		return ERR;
@@ -73,6 +85,7 @@ ModelLog::Verbosity ModelLog::GetMsgVerbosity(unsigned int idx)
 
 void ModelLog::ForceDumpBuffer()
 {
+	std::lock_guard<std::mutex> lock(bufferMutex());
 	buffer.clear();
 }
 
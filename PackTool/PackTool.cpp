@@ -0,0 +1,145 @@
+//Builds LeEK packs (.lpak) from a directory or a ZIP archive.
+#include <Logging/Log.h>
+#include <Constants/AllocTypes.h>
+#include <Memory/Allocator.h>
+#include <Math/MathFunctions.h>
+#include <FileManagement/Filesystem.h>
+#include <FileManagement/DataStream.h>
+#include <FileManagement/ArchiveTypes.h>
+#include <FileManagement/PackFile.h>
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstdlib>
+using namespace LeEK;
+
+namespace
+{
+	void printUsage()
+	{
+		printf("Usage: PackTool <input directory or .zip> <output.lpak> [options]\n");
+		printf("Options:\n");
+		printf("\t-store\t\tdon't compress anything\n");
+		printf("\t-align <bytes>\talignment of each file's data, a power of two (default %d)\n", PackWriter::DEFAULT_ALIGNMENT);
+		printf("\t-chunk <bytes>\tsize of each compressed chunk (default %d)\n", PackWriter::DEFAULT_CHUNK_SIZE);
+	}
+
+	bool addZip(PackWriter& writer, const Path& zipPath, bool compress)
+	{
+		ZipFile zip;
+		if(!zip.Init(zipPath))
+		{
+			return false;
+		}
+		for(I32 i = 0; i < zip.GetNumFiles(); ++i)
+		{
+			FileSz size = zip.GetFileLen(i);
+			String name = zip.GetFilename(i);
+			//skip folders.
+			if(size == 0 && !name.empty() && name[name.length() - 1] == '/')
+			{
+				continue;
+			}
+			char* buf = CustomArrayNew<char>(Math::Max(size, (FileSz)1), RESFILE_ALLOC, "TempBufAlloc");
+			bool added = zip.ReadFile(i, buf) && writer.AddFile(name, buf, size, compress);
+			CustomArrayDelete(buf);
+			if(!added)
+			{
+				LogE(String("Couldn't pack ") + name + "!");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool addDirectory(PackWriter& writer, const Path& dirPath, bool compress)
+	{
+		namespace fs = boost::filesystem;
+		const fs::path& root = dirPath.PathImplementation();
+		for(fs::recursive_directory_iterator it(root), end; it != end; ++it)
+		{
+			if(!fs::is_regular_file(it->status()))
+			{
+				continue;
+			}
+			//names in the pack are relative to the input directory.
+			String fullPath = it->path().generic_string().c_str();
+			String name = fullPath.substr(root.generic_string().length());
+			while(!name.empty() && name[0] == '/')
+			{
+				name = name.substr(1);
+			}
+			DataStream* file = Filesystem::OpenFileReadOnly(Path(fullPath));
+			if(!file)
+			{
+				LogE(String("Couldn't open ") + fullPath + "!");
+				return false;
+			}
+			FileSz size = file->FileSize();
+			char* buf = CustomArrayNew<char>(Math::Max(size, (FileSz)1), RESFILE_ALLOC, "TempBufAlloc");
+			file->Read(buf, size);
+			Filesystem::CloseFile(file);
+			bool added = writer.AddFile(name, buf, size, compress);
+			CustomArrayDelete(buf);
+			if(!added)
+			{
+				LogE(String("Couldn't pack ") + name + "!");
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::SetVerbosity(Log::INFO);
+	Log::SetBufferEnabled(false);
+	if(argc < 3)
+	{
+		printUsage();
+		return 1;
+	}
+	Path inPath(argv[1]);
+	Path outPath(argv[2]);
+	bool compress = true;
+	U32 alignment = PackWriter::DEFAULT_ALIGNMENT;
+	U32 chunkSize = PackWriter::DEFAULT_CHUNK_SIZE;
+	for(I32 i = 3; i < argc; ++i)
+	{
+		String arg = argv[i];
+		if(arg == "-store")
+		{
+			compress = false;
+		}
+		else if(arg == "-align" && i + 1 < argc)
+		{
+			alignment = (U32)atol(argv[++i]);
+		}
+		else if(arg == "-chunk" && i + 1 < argc)
+		{
+			chunkSize = (U32)atol(argv[++i]);
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+	if(alignment == 0 || (alignment & (alignment - 1)) != 0 || chunkSize == 0)
+	{
+		printUsage();
+		return 1;
+	}
+
+	PackWriter writer(alignment, chunkSize);
+	bool added = boost::filesystem::is_directory(inPath.PathImplementation()) ?
+					addDirectory(writer, inPath, compress) :
+					addZip(writer, inPath, compress);
+	if(!added || !writer.Write(outPath))
+	{
+		printf("Couldn't build %s!\n", outPath.ToString().c_str());
+		return 1;
+	}
+	printf("Packed %u files into %s\n", writer.GetNumFiles(), outPath.ToString().c_str());
+	return 0;
+}
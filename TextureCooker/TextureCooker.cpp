@@ -0,0 +1,458 @@
+//Cooks a directory of PNGs into LeEK textures (.ltex):
+//mip chains are built and block compressed ahead of time,
+//and small images can be packed into atlases.
+#include <Logging/Log.h>
+#include <Constants/AllocTypes.h>
+#include <Memory/Allocator.h>
+#include <Math/MathFunctions.h>
+#include <FileManagement/Filesystem.h>
+#include <FileManagement/DataStream.h>
+#include <FileManagement/TextureFile.h>
+#include <ResourceManagement/ResourceLoaders.h>
+#include <Rendering/Texture.h>
+#include <Rendering/TextureCompression.h>
+#include <DataStructures/STLContainers.h>
+#include <Time/GameTime.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+using namespace LeEK;
+
+namespace
+{
+	//Empty pixels around each atlas region, so filtering and
+	//the first few mip levels don't bleed neighboring regions in.
+	//They're filled with the region's edge pixels.
+	const U32 ATLAS_PADDING = 4;
+	const U32 DEFAULT_ATLAS_MAX_IMAGE = 128;
+	const U32 DEFAULT_ATLAS_MAX_SIZE = 4096;
+
+	enum CookFormat
+	{
+		//BC1 for opaque images, BC3 for ones with alpha.
+		FORMAT_AUTO,
+		FORMAT_BC1,
+		FORMAT_BC3,
+		FORMAT_BC7,
+		FORMAT_RGBA
+	};
+
+	const char* compTypeNames[Texture2D::COMPTYPE_LEN] = { "RGBA8", "BC1", "BC3", "BC7" };
+
+	struct SourceImage
+	{
+		//relative to the input's root, with '/' separators.
+		String Name;
+		String SourcePath;
+		FileSz FileSize;
+		U32 Width;
+		U32 Height;
+		//RGBA8, last row first.
+		Vector<U8> Pixels;
+		//Where the image went in the atlas, if it went in one.
+		U32 AtlasX;
+		U32 AtlasY;
+	};
+
+	//Tallest first, so each shelf's height is set by its first image.
+	bool tallerImage(const SourceImage* lhs, const SourceImage* rhs)
+	{
+		return lhs->Height > rhs->Height;
+	}
+
+	struct CookStats
+	{
+		U32 NumCooked;
+		U32 NumFailed;
+		U64 PNGBytes;
+		U64 RGBABytes;
+		U64 CookedBytes;
+	};
+
+	void printUsage()
+	{
+		printf("Usage: TextureCooker <input directory> <output directory> [options]\n");
+		printf("Options:\n");
+		printf("\t-format <fmt>\tauto, bc1, bc3, bc7 or rgba (default auto: bc1 if opaque, else bc3)\n");
+		printf("\t-nomips\t\tdon't build mip chains\n");
+		printf("\t-atlas <name>\tpack small images into <name>.ltex instead of cooking them separately\n");
+		printf("\t-atlasmax <px>\tlargest width or height an image can have to go in the atlas (default %u)\n", DEFAULT_ATLAS_MAX_IMAGE);
+		printf("\t-atlassize <px>\tlargest width or height the atlas can have (default %u)\n", DEFAULT_ATLAS_MAX_SIZE);
+		printf("\t-j <threads>\tnumber of threads compressing each texture (default: one per core)\n");
+	}
+
+	String toOutputName(const String& name)
+	{
+		size_t slash = name.find_last_of('/');
+		size_t dot = name.find_last_of('.');
+		if(dot == String::npos || (slash != String::npos && dot < slash))
+		{
+			return name + ".ltex";
+		}
+		return name.substr(0, dot) + ".ltex";
+	}
+
+	void findImages(const Path& dirPath, Vector<SourceImage>& images)
+	{
+		namespace fs = boost::filesystem;
+		const fs::path& root = dirPath.PathImplementation();
+		for(fs::recursive_directory_iterator it(root), end; it != end; ++it)
+		{
+			if(!fs::is_regular_file(it->status()))
+			{
+				continue;
+			}
+			SourceImage image;
+			image.SourcePath = it->path().generic_string().c_str();
+			image.Name = image.SourcePath.substr(root.generic_string().length());
+			while(!image.Name.empty() && image.Name[0] == '/')
+			{
+				image.Name = image.Name.substr(1);
+			}
+			std::string ext = it->path().extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+			if(ext != ".png")
+			{
+				continue;
+			}
+			image.FileSize = (FileSz)fs::file_size(it->path());
+			images.push_back(image);
+		}
+	}
+
+	bool decodeImage(SourceImage& image)
+	{
+		DataStream* file = Filesystem::OpenFileReadOnly(Path(image.SourcePath));
+		if(!file)
+		{
+			return false;
+		}
+		char* buf = CustomArrayNew<char>(Math::Max(image.FileSize, (FileSz)1), RESFILE_ALLOC, "TempBufAlloc");
+		bool decoded = file->Read(buf, image.FileSize) == image.FileSize &&
+						PNGLoader::ReadImageSize(buf, image.FileSize, image.Width, image.Height);
+		Filesystem::CloseFile(file);
+		if(decoded)
+		{
+			image.Pixels.resize(image.Width * image.Height * 4);
+			decoded = PNGLoader::DecodeImage(buf, image.FileSize, image.Width, image.Height, (char*)&image.Pixels[0]);
+		}
+		CustomArrayDelete(buf);
+		return decoded;
+	}
+
+	//Names can have directories in them, so make those first.
+	bool writeOutput(const Path& path, const char* data, FileSz size)
+	{
+		boost::system::error_code err;
+		boost::filesystem::create_directories(path.PathImplementation().parent_path(), err);
+		return Filesystem::WriteFile(path, data, size);
+	}
+
+	Texture2D::CompressionType pickCompression(CookFormat format, const U8* rgba, U32 width, U32 height)
+	{
+		switch(format)
+		{
+		case FORMAT_BC1:
+			return Texture2D::DXT1;
+		case FORMAT_BC3:
+			return Texture2D::DXT5;
+		case FORMAT_BC7:
+			return Texture2D::BC7;
+		case FORMAT_RGBA:
+			return Texture2D::NONE;
+		default:
+			return TextureCompression::HasAlpha(rgba, width, height) ? Texture2D::DXT5 : Texture2D::DXT1;
+		}
+	}
+
+	//Cooks an image and writes it out, adding it to the totals.
+	bool cookImage(	const String& name, const U8* rgba, U32 width, U32 height, FileSz pngBytes,
+					const Vector<TextureRegion>& regions, CookFormat format, bool buildMips, U32 numThreads,
+					const Path& outDir, CookStats& stats)
+	{
+		if(width > Texture2D::MAX_DIMENSION || height > Texture2D::MAX_DIMENSION)
+		{
+			printf("%s is %ux%u; textures can't be bigger than %ux%u!\n", name.c_str(), width, height,
+					Texture2D::MAX_DIMENSION, Texture2D::MAX_DIMENSION);
+			return false;
+		}
+		GameTime timer;
+		Texture2D tex;
+		Texture2D::CompressionType compType = pickCompression(format, rgba, width, height);
+		if(!TextureCompression::CookTexture(rgba, width, height, compType, buildMips, numThreads, tex))
+		{
+			return false;
+		}
+		size_t fileSize = TextureMgr::FindFileSize(tex, regions);
+		char* fileBuf = CustomArrayNew<char>(fileSize, RESFILE_ALLOC, "TempBufAlloc");
+		bool written = TextureMgr::WriteTextureMemory(tex, regions, fileBuf, fileSize) &&
+						writeOutput(Path(outDir.ToString() + "/" + toOutputName(name)), fileBuf, fileSize);
+		CustomArrayDelete(fileBuf);
+		//what the PNG loader would have kept, with the mips the driver would have generated.
+		U64 rgbaBytes = Texture2D::ImageSize(Texture2D::RGBA8, Texture2D::NONE, width, height);
+		if(buildMips)
+		{
+			rgbaBytes = rgbaBytes * 4 / 3;
+		}
+		U64 cookedBytes = tex.DataSize();
+		LArrayDelete(tex.Data);
+		if(!written)
+		{
+			return false;
+		}
+		timer.Tick();
+		printf("Cooked %s: %ux%u %s, %u mips, %.1fKB (PNG %.1fKB, RGBA8 %.1fKB) in %.2fs\n",
+				name.c_str(), width, height, compTypeNames[compType], tex.MipCount(),
+				cookedBytes / 1024.0, pngBytes / 1024.0, rgbaBytes / 1024.0, timer.ElapsedGameTime().ToSeconds());
+		++stats.NumCooked;
+		stats.PNGBytes += pngBytes;
+		stats.RGBABytes += rgbaBytes;
+		stats.CookedBytes += cookedBytes;
+		return true;
+	}
+
+	//Shelf packs the images into a width x height atlas, if they fit.
+	bool packShelves(Vector<SourceImage*>& images, U32 width, U32 height)
+	{
+		U32 x = 0, y = 0, shelfHeight = 0;
+		for(U32 i = 0; i < images.size(); ++i)
+		{
+			SourceImage* image = images[i];
+			//cells are kept on block boundaries, so no block holds two regions.
+			U32 cellWidth = (image->Width + ATLAS_PADDING * 2 + 3) & ~3U;
+			U32 cellHeight = (image->Height + ATLAS_PADDING * 2 + 3) & ~3U;
+			if(x + cellWidth > width)
+			{
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+			if(x + cellWidth > width || y + cellHeight > height)
+			{
+				return false;
+			}
+			image->AtlasX = x + ATLAS_PADDING;
+			image->AtlasY = y + ATLAS_PADDING;
+			x += cellWidth;
+			shelfHeight = Math::Max(shelfHeight, cellHeight);
+		}
+		return true;
+	}
+
+	//Copies an image into the atlas, repeating its edges out into the padding around it.
+	void blitPadded(const SourceImage& image, U8* atlas, U32 atlasWidth, U32 atlasHeight)
+	{
+		for(I32 y = -(I32)ATLAS_PADDING; y < (I32)(image.Height + ATLAS_PADDING); ++y)
+		{
+			I32 destY = (I32)image.AtlasY + y;
+			if(destY < 0 || destY >= (I32)atlasHeight)
+			{
+				continue;
+			}
+			U32 srcY = (U32)Math::Clamp(y, 0, (I32)image.Height - 1);
+			for(I32 x = -(I32)ATLAS_PADDING; x < (I32)(image.Width + ATLAS_PADDING); ++x)
+			{
+				I32 destX = (I32)image.AtlasX + x;
+				if(destX < 0 || destX >= (I32)atlasWidth)
+				{
+					continue;
+				}
+				U32 srcX = (U32)Math::Clamp(x, 0, (I32)image.Width - 1);
+				memcpy(atlas + (destY * atlasWidth + destX) * 4, &image.Pixels[(srcY * image.Width + srcX) * 4], 4);
+			}
+		}
+	}
+
+	bool cookAtlas(	const String& name, Vector<SourceImage*>& images, U32 maxSize, CookFormat format,
+					bool buildMips, U32 numThreads, const Path& outDir, CookStats& stats)
+	{
+		std::sort(images.begin(), images.end(), tallerImage);
+		//Start with the smallest square that could hold everything,
+		//then grow the atlas a side at a time until everything fits.
+		U64 area = 0;
+		FileSz pngBytes = 0;
+		for(U32 i = 0; i < images.size(); ++i)
+		{
+			area += (U64)(images[i]->Width + ATLAS_PADDING * 2) * (images[i]->Height + ATLAS_PADDING * 2);
+			pngBytes += images[i]->FileSize;
+		}
+		U32 width = 4, height = 4;
+		while((U64)width * height < area)
+		{
+			if(width > height)
+			{
+				height *= 2;
+			}
+			else
+			{
+				width *= 2;
+			}
+		}
+		while(!packShelves(images, width, height))
+		{
+			if(width > maxSize || height > maxSize)
+			{
+				break;
+			}
+			if(width > height)
+			{
+				height *= 2;
+			}
+			else
+			{
+				width *= 2;
+			}
+		}
+		if(width > maxSize || height > maxSize)
+		{
+			printf("Atlas %s needs to be bigger than %ux%u!\n", name.c_str(), maxSize, maxSize);
+			return false;
+		}
+
+		Vector<U8> atlas;
+		atlas.assign(width * height * 4, 0);
+		Vector<TextureRegion> regions;
+		for(U32 i = 0; i < images.size(); ++i)
+		{
+			const SourceImage& image = *images[i];
+			blitPadded(image, &atlas[0], width, height);
+			TextureRegion region;
+			region.Name = image.Name;
+			region.X = image.AtlasX;
+			region.Y = image.AtlasY;
+			region.Width = image.Width;
+			region.Height = image.Height;
+			regions.push_back(region);
+		}
+		printf("Packed %u images into %s (%ux%u)\n", (U32)images.size(), name.c_str(), width, height);
+		return cookImage(name, &atlas[0], width, height, pngBytes, regions, format, buildMips, numThreads, outDir, stats);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::SetVerbosity(Log::INFO);
+	Log::SetBufferEnabled(false);
+	if(argc < 3)
+	{
+		printUsage();
+		return 1;
+	}
+	Path inPath(argv[1]);
+	Path outDir(argv[2]);
+	U32 numThreads = std::thread::hardware_concurrency();
+	CookFormat format = FORMAT_AUTO;
+	bool buildMips = true;
+	String atlasName;
+	U32 atlasMaxImage = DEFAULT_ATLAS_MAX_IMAGE;
+	U32 atlasMaxSize = DEFAULT_ATLAS_MAX_SIZE;
+	for(I32 i = 3; i < argc; ++i)
+	{
+		String arg = argv[i];
+		if(arg == "-j" && i + 1 < argc)
+		{
+			numThreads = (U32)atol(argv[++i]);
+		}
+		else if(arg == "-format" && i + 1 < argc)
+		{
+			String fmt = argv[++i];
+			if(fmt == "auto")
+			{
+				format = FORMAT_AUTO;
+			}
+			else if(fmt == "bc1")
+			{
+				format = FORMAT_BC1;
+			}
+			else if(fmt == "bc3")
+			{
+				format = FORMAT_BC3;
+			}
+			else if(fmt == "bc7")
+			{
+				format = FORMAT_BC7;
+			}
+			else if(fmt == "rgba")
+			{
+				format = FORMAT_RGBA;
+			}
+			else
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if(arg == "-nomips")
+		{
+			buildMips = false;
+		}
+		else if(arg == "-atlas" && i + 1 < argc)
+		{
+			atlasName = argv[++i];
+		}
+		else if(arg == "-atlasmax" && i + 1 < argc)
+		{
+			atlasMaxImage = (U32)atol(argv[++i]);
+		}
+		else if(arg == "-atlassize" && i + 1 < argc)
+		{
+			atlasMaxSize = (U32)atol(argv[++i]);
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+	numThreads = Math::Max(numThreads, 1U);
+	if(!boost::filesystem::is_directory(inPath.PathImplementation()))
+	{
+		printf("%s isn't a directory!\n", inPath.ToString().c_str());
+		return 1;
+	}
+
+	GameTime timer;
+	Vector<SourceImage> images;
+	findImages(inPath, images);
+	CookStats stats;
+	memset(&stats, 0, sizeof(CookStats));
+	Vector<SourceImage*> atlasImages;
+	for(U32 i = 0; i < images.size(); ++i)
+	{
+		SourceImage& image = images[i];
+		if(!decodeImage(image))
+		{
+			printf("Couldn't decode %s!\n", image.Name.c_str());
+			++stats.NumFailed;
+			continue;
+		}
+		if(!atlasName.empty() && image.Width <= atlasMaxImage && image.Height <= atlasMaxImage)
+		{
+			atlasImages.push_back(&image);
+			continue;
+		}
+		if(!cookImage(	image.Name, &image.Pixels[0], image.Width, image.Height, image.FileSize, Vector<TextureRegion>(),
+						format, buildMips, numThreads, outDir, stats))
+		{
+			printf("Couldn't cook %s!\n", image.Name.c_str());
+			++stats.NumFailed;
+		}
+		//everything's cooked straight away except the atlas' images.
+		Vector<U8>().swap(image.Pixels);
+	}
+	if(!atlasImages.empty() && !cookAtlas(atlasName, atlasImages, atlasMaxSize, format, buildMips, numThreads, outDir, stats))
+	{
+		printf("Couldn't cook atlas %s!\n", atlasName.c_str());
+		++stats.NumFailed;
+	}
+
+	timer.Tick();
+	printf("Cooked %u textures, %u failed, in %.2fs on %u threads\n",
+			stats.NumCooked, stats.NumFailed, timer.ElapsedGameTime().ToSeconds(), numThreads);
+	printf("Texture memory: %.1fKB cooked, vs. %.1fKB as RGBA8 from %.1fKB of PNGs\n",
+			stats.CookedBytes / 1024.0, stats.RGBABytes / 1024.0, stats.PNGBytes / 1024.0);
+	return stats.NumFailed > 0 ? 1 : 0;
+}